@@ -517,8 +517,8 @@ retry:
 		mask = (1UL << shift) - 1;
 		page = pte_page(*ptep);
 		page += ((address & mask) >> PAGE_SHIFT);
-		if (flags & FOLL_GET)
-			get_page(page);
+		if (WARN_ON_ONCE(!try_grab_page(page, flags)))
+			page = NULL;
 	} else {
 		if (is_hugetlb_entry_migration(*ptep)) {
 			spin_unlock(ptl);
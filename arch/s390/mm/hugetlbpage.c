@@ -248,7 +248,7 @@ struct page *
 follow_huge_pud(struct mm_struct *mm, unsigned long address,
 		pud_t *pud, int flags)
 {
-	if (flags & FOLL_GET)
+	if (flags & (FOLL_GET | FOLL_PIN))
 		return NULL;
 
 	return pud_page(*pud) + ((address & ~PUD_MASK) >> PAGE_SHIFT);
@@ -132,7 +132,7 @@ static long syscall_trace_enter(struct pt_regs *regs)
 	(_TIF_SIGPENDING | _TIF_NOTIFY_RESUME | _TIF_UPROBE |	\
 	 _TIF_NEED_RESCHED | _TIF_USER_RETURN_NOTIFY | _TIF_PATCH_PENDING)
 
-static void exit_to_usermode_loop(struct pt_regs *regs, u32 cached_flags)
+static u32 exit_to_usermode_loop(struct pt_regs *regs, u32 cached_flags)
 {
 	/*
 	 * In order to return to user mode, we need to have IRQs off with
@@ -141,7 +141,7 @@ static void exit_to_usermode_loop(struct pt_regs *regs, u32 cached_flags)
 	 * so we need to loop.  Disabling preemption wouldn't help: doing the
 	 * work to clear some of the flags can sleep.
 	 */
-	while (true) {
+	do {
 		/* We have work to do. */
 		local_irq_enable();
 
@@ -171,10 +171,9 @@ static void exit_to_usermode_loop(struct pt_regs *regs, u32 cached_flags)
 		local_irq_disable();
 
 		cached_flags = READ_ONCE(current_thread_info()->flags);
+	} while (cached_flags & EXIT_TO_USERMODE_LOOP_FLAGS);
 
-		if (!(cached_flags & EXIT_TO_USERMODE_LOOP_FLAGS))
-			break;
-	}
+	return cached_flags;
 }
 
 /* Called with IRQs disabled. */
@@ -190,11 +189,14 @@ __visible inline void prepare_exit_to_usermode(struct pt_regs *regs)
 
 	cached_flags = READ_ONCE(ti->flags);
 
+	/*
+	 * The loop re-reads ti->flags with IRQs disabled after each pass
+	 * and hands back the final value, so no work is pending and no
+	 * reload is needed on return; the common no-work case is a single
+	 * flags read and one test-and-branch.
+	 */
 	if (unlikely(cached_flags & EXIT_TO_USERMODE_LOOP_FLAGS))
-		exit_to_usermode_loop(regs, cached_flags);
-
-	/* Reload ti->flags; we may have rescheduled above. */
-	cached_flags = READ_ONCE(ti->flags);
+		cached_flags = exit_to_usermode_loop(regs, cached_flags);
 
 	fpregs_assert_state_consistent();
 	if (unlikely(cached_flags & _TIF_NEED_FPU_LOAD))
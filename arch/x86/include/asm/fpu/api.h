@@ -15,12 +15,14 @@
 /*
  * Use kernel_fpu_begin/end() if you intend to use FPU in kernel context. It
  * disables preemption so be careful if you intend to use it for long periods
- * of time.
+ * of time; call kernel_fpu_resched() periodically from long sections so a
+ * due reschedule is not delayed for their whole length.
  * If you intend to use the FPU in softirq you need to check first with
  * irq_fpu_usable() if it is possible.
  */
 extern void kernel_fpu_begin(void);
 extern void kernel_fpu_end(void);
+extern void kernel_fpu_resched(void);
 extern bool irq_fpu_usable(void);
 extern void fpregs_mark_activate(void);
 
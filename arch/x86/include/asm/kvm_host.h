@@ -318,6 +318,7 @@ struct kvm_mmu_page {
 	u8 mmu_valid_gen;
 	bool mmio_cached;
 	bool lpage_disallowed; /* Can't be replaced by an equiv large page */
+	bool tdp_mmu_page;     /* Managed by the TDP MMU, has no rmaps */
 
 	/*
 	 * The following two entries are used to key the shadow page in the
@@ -864,6 +865,20 @@ struct kvm_arch {
 	struct list_head active_mmu_pages;
 	struct list_head zapped_obsolete_pages;
 	struct list_head lpage_disallowed_mmu_pages;
+
+	/*
+	 * Whether the TDP MMU is used for this VM.  Set at VM creation and
+	 * never changed afterwards, so it can be read without holding any
+	 * lock.
+	 */
+	bool tdp_mmu_enabled;
+
+	/*
+	 * List of struct kvm_mmu_page roots managed by the TDP MMU.  Pages
+	 * below the roots are not tracked on any list; they are reachable
+	 * only through their parent SPTEs.  Protected by mmu_lock.
+	 */
+	struct list_head tdp_mmu_roots;
 	struct kvm_page_track_notifier_node mmu_sp_tracker;
 	struct kvm_page_track_notifier_head track_notifier_head;
 
@@ -27,7 +27,7 @@ static inline void tlb_flush(struct mmu_gather *tlb)
 /*
  * While x86 architecture in general requires an IPI to perform TLB
  * shootdown, enablement code for several hypervisors overrides
- * .flush_tlb_others hook in pv_mmu_ops and implements it by issuing
+ * .flush_tlb_multi hook in pv_mmu_ops and implements it by issuing
  * a hypercall. To keep software pagetable walkers safe in this case we
  * switch to RCU based table free (HAVE_RCU_TABLE_FREE). See the comment
  * below 'ifdef CONFIG_HAVE_RCU_TABLE_FREE' in include/asm-generic/tlb.h
@@ -25,6 +25,7 @@
 #include <asm/tlbflush.h>
 #include <asm/io.h>
 #include <asm/fixmap.h>
+#include <asm/qspinlock.h>
 
 int __read_mostly alternatives_patched;
 
@@ -740,6 +741,15 @@ void __init alternative_instructions(void)
 
 	apply_paravirt(__parainstructions, __parainstructions_end);
 
+#if defined(CONFIG_NUMA_AWARE_SPINLOCKS)
+	/*
+	 * By this point, the NUMA topology is known and any paravirt lock
+	 * ops have been installed, but no spinlock has been contended yet,
+	 * so it is safe to redirect the spinlock slowpath.
+	 */
+	cna_configure_spin_lock_slowpath();
+#endif
+
 	restart_nmi();
 	alternatives_patched = 1;
 }
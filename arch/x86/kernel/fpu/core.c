@@ -119,6 +119,26 @@ void kernel_fpu_end(void)
 }
 EXPORT_SYMBOL_GPL(kernel_fpu_end);
 
+/*
+ * Offer a preemption point inside a long kernel-mode FPU section.  Bulk
+ * users (crypto) can keep a single begin/end pair around a whole burst
+ * and call this between blocks: the section is only torn down and
+ * re-entered when a reschedule is actually due, and the re-entry is
+ * cheap because TIF_NEED_FPU_LOAD stays set so the user state is not
+ * saved again.
+ */
+void kernel_fpu_resched(void)
+{
+	WARN_ON_FPU(!this_cpu_read(in_kernel_fpu));
+
+	if (should_resched(PREEMPT_OFFSET)) {
+		kernel_fpu_end();
+		cond_resched();
+		kernel_fpu_begin();
+	}
+}
+EXPORT_SYMBOL_GPL(kernel_fpu_resched);
+
 /*
  * Save the FPU state (mark it for reload if necessary):
  *
@@ -784,8 +784,69 @@ wakeup_secondary_cpu_via_nmi(int apicid, unsigned long start_eip)
 	return (send_status | accept_status);
 }
 
+/*
+ * CPUs whose INIT assert/deassert sequence was already performed by the
+ * boot-time broadcast in smp_broadcast_init_ipi(), so that
+ * wakeup_secondary_cpu_via_init() can go straight to the STARTUP IPIs.
+ */
+static struct cpumask init_broadcast_mask;
+
+/*
+ * Assert and deassert INIT on every present AP in one pass, so that the
+ * MP-spec 10ms assert->deassert delay on legacy platforms is paid once
+ * per boot instead of once per CPU in do_boot_cpu().  No AP executes a
+ * single instruction on INIT alone - it sits in wait-for-SIPI until its
+ * STARTUP IPI - so unlike the STARTUP phase, which funnels every AP
+ * through the shared real-mode trampoline stack and initial_stack /
+ * early_gdt_descr and therefore must stay serialized, this phase is
+ * safe to batch.
+ */
+static void __init smp_broadcast_init_ipi(void)
+{
+	int cpu, apicid;
+
+	/* Platform wakeup methods do their own sequencing */
+	if (apic->wakeup_secondary_cpu)
+		return;
+	if (!APIC_INTEGRATED(boot_cpu_apic_version))
+		return;
+	/* The warm reset path reprograms the reset vector per CPU */
+	if (x86_platform.legacy.warm_reset)
+		return;
+
+	if (lapic_get_maxlvt() > 3)	/* Due to the Pentium erratum 3AP.  */
+		apic_write(APIC_ESR, 0);
+	apic_read(APIC_ESR);
+
+	for_each_present_cpu(cpu) {
+		if (cpu == 0)
+			continue;
+		apicid = apic->cpu_present_to_apicid(cpu);
+		if (apicid == BAD_APICID || !apic->apic_id_valid(apicid))
+			continue;
+		apic_icr_write(APIC_INT_LEVELTRIG | APIC_INT_ASSERT |
+			       APIC_DM_INIT, apicid);
+		if (safe_apic_wait_icr_idle())
+			continue;
+		cpumask_set_cpu(cpu, &init_broadcast_mask);
+	}
+
+	if (cpumask_empty(&init_broadcast_mask))
+		return;
+
+	udelay(init_udelay);
+
+	for_each_cpu(cpu, &init_broadcast_mask) {
+		apicid = apic->cpu_present_to_apicid(cpu);
+		apic_icr_write(APIC_INT_LEVELTRIG | APIC_DM_INIT, apicid);
+		safe_apic_wait_icr_idle();
+	}
+	mb();
+}
+
 static int
-wakeup_secondary_cpu_via_init(int phys_apicid, unsigned long start_eip)
+wakeup_secondary_cpu_via_init(int phys_apicid, unsigned long start_eip,
+			      int cpu)
 {
 	unsigned long send_status = 0, accept_status = 0;
 	int maxlvt, num_starts, j;
@@ -801,32 +862,39 @@ wakeup_secondary_cpu_via_init(int phys_apicid, unsigned long start_eip)
 		apic_read(APIC_ESR);
 	}
 
-	pr_debug("Asserting INIT\n");
-
 	/*
-	 * Turn INIT on target chip
+	 * Skip the INIT sequence if the boot-time broadcast already
+	 * performed it for this CPU.  The bit is consumed so that any
+	 * retry or later soft hotplug runs the full sequence again.
 	 */
-	/*
-	 * Send IPI
-	 */
-	apic_icr_write(APIC_INT_LEVELTRIG | APIC_INT_ASSERT | APIC_DM_INIT,
-		       phys_apicid);
+	if (!cpumask_test_and_clear_cpu(cpu, &init_broadcast_mask)) {
+		pr_debug("Asserting INIT\n");
 
-	pr_debug("Waiting for send to finish...\n");
-	send_status = safe_apic_wait_icr_idle();
+		/*
+		 * Turn INIT on target chip
+		 */
+		/*
+		 * Send IPI
+		 */
+		apic_icr_write(APIC_INT_LEVELTRIG | APIC_INT_ASSERT |
+			       APIC_DM_INIT, phys_apicid);
 
-	udelay(init_udelay);
+		pr_debug("Waiting for send to finish...\n");
+		send_status = safe_apic_wait_icr_idle();
 
-	pr_debug("Deasserting INIT\n");
+		udelay(init_udelay);
 
-	/* Target chip */
-	/* Send IPI */
-	apic_icr_write(APIC_INT_LEVELTRIG | APIC_DM_INIT, phys_apicid);
+		pr_debug("Deasserting INIT\n");
 
-	pr_debug("Waiting for send to finish...\n");
-	send_status = safe_apic_wait_icr_idle();
+		/* Target chip */
+		/* Send IPI */
+		apic_icr_write(APIC_INT_LEVELTRIG | APIC_DM_INIT, phys_apicid);
 
-	mb();
+		pr_debug("Waiting for send to finish...\n");
+		send_status = safe_apic_wait_icr_idle();
+
+		mb();
+	}
 
 	/*
 	 * Should we send STARTUP IPIs ?
@@ -971,7 +1039,8 @@ wakeup_cpu_via_init_nmi(int cpu, unsigned long start_ip, int apicid,
 	 * Wake up AP by INIT, INIT, STARTUP sequence.
 	 */
 	if (cpu) {
-		boot_error = wakeup_secondary_cpu_via_init(apicid, start_ip);
+		boot_error = wakeup_secondary_cpu_via_init(apicid, start_ip,
+							   cpu);
 		goto out;
 	}
 
@@ -1377,6 +1446,8 @@ void __init native_smp_prepare_cpus(unsigned int max_cpus)
 
 	smp_quirk_init_udelay();
 
+	smp_broadcast_init_ipi();
+
 	speculative_store_bypass_ht_init();
 }
 
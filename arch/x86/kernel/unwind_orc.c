@@ -1,6 +1,8 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include <linux/module.h>
 #include <linux/sort.h>
+#include <linux/hash.h>
+#include <linux/percpu.h>
 #include <asm/ptrace.h>
 #include <asm/stacktrace.h>
 #include <asm/unwind.h>
@@ -184,6 +186,82 @@ static struct orc_entry *orc_find(unsigned long ip)
 	return orc_ftrace_find(ip);
 }
 
+/*
+ * A small per-CPU cache in front of orc_find().  Profilers unwinding at a
+ * high sampling rate keep resolving the same small set of text addresses,
+ * so remembering recent (ip, orc entry) pairs avoids redoing the binary
+ * search for them on every sample.
+ *
+ * The cache is only accessed with preemption disabled (see
+ * unwind_next_frame()), which also keeps module ORC tables from going away
+ * under a cached pointer that is about to be used.  The only concurrency
+ * to worry about is a same-CPU NMI unwinding in the middle of an
+ * interrupted unwind; entries are invalidated before and revalidated after
+ * an update so a half-written entry is never used, and compiler barriers
+ * are sufficient to order same-CPU accesses.
+ */
+#define ORC_CACHE_BITS	6
+#define ORC_CACHE_SIZE	(1 << ORC_CACHE_BITS)
+
+struct orc_cache_entry {
+	unsigned long		ip;
+	struct orc_entry	*orc;
+};
+
+struct orc_cache {
+	unsigned long		gen;
+	struct orc_cache_entry	entries[ORC_CACHE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct orc_cache, orc_cache);
+static atomic_long_t orc_cache_gen = ATOMIC_LONG_INIT(1);
+
+static struct orc_entry *orc_find_cached(unsigned long ip)
+{
+	struct orc_cache *cache = this_cpu_ptr(&orc_cache);
+	struct orc_cache_entry *ent;
+	struct orc_entry *orc;
+	unsigned long gen;
+
+	/* Zero doubles as the empty entry marker; orc_find() handles it. */
+	if (unlikely(!ip))
+		return orc_find(ip);
+
+	gen = atomic_long_read(&orc_cache_gen);
+	if (unlikely(cache->gen != gen)) {
+		/*
+		 * The module ORC tables changed; cached entries may point
+		 * into freed memory.  Start over.
+		 */
+		memset(cache->entries, 0, sizeof(cache->entries));
+		cache->gen = gen;
+	}
+
+	ent = &cache->entries[hash_long(ip, ORC_CACHE_BITS)];
+	if (READ_ONCE(ent->ip) == ip) {
+		orc = READ_ONCE(ent->orc);
+		barrier();
+		if (READ_ONCE(ent->ip) == ip)
+			return orc;
+	}
+
+	orc = orc_find(ip);
+	if (orc) {
+		WRITE_ONCE(ent->ip, 0);
+		barrier();
+		WRITE_ONCE(ent->orc, orc);
+		barrier();
+		WRITE_ONCE(ent->ip, ip);
+	}
+
+	return orc;
+}
+
+static void orc_cache_invalidate(void)
+{
+	atomic_long_inc(&orc_cache_gen);
+}
+
 static void orc_sort_swap(void *_a, void *_b, int size)
 {
 	struct orc_entry *orc_a, *orc_b;
@@ -253,6 +331,29 @@ void unwind_module_init(struct module *mod, void *_orc_ip, size_t orc_ip_size,
 	mod->arch.orc_unwind = orc;
 	mod->arch.num_orcs = num_entries;
 }
+
+static int orc_module_notify(struct notifier_block *nb, unsigned long state,
+			     void *mod)
+{
+	/*
+	 * Cached entries can point into the module's ORC tables; drop them
+	 * before the module goes away.
+	 */
+	if (state == MODULE_STATE_GOING)
+		orc_cache_invalidate();
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block orc_module_nb = {
+	.notifier_call = orc_module_notify,
+};
+
+static int __init orc_module_notifier_init(void)
+{
+	return register_module_notifier(&orc_module_nb);
+}
+core_initcall(orc_module_notifier_init);
 #endif
 
 void __init unwind_init(void)
@@ -437,7 +538,7 @@ bool unwind_next_frame(struct unwind_state *state)
 	 * if the call was to a noreturn function.  So get the ORC data for the
 	 * call instruction itself.
 	 */
-	orc = orc_find(state->signal ? state->ip : state->ip - 1);
+	orc = orc_find_cached(state->signal ? state->ip : state->ip - 1);
 	if (!orc) {
 		/*
 		 * As a fallback, try to assume this code uses a frame pointer.
@@ -77,6 +77,14 @@ module_param_cb(nx_huge_pages_recovery_ratio, &nx_huge_pages_recovery_ratio_ops,
 		&nx_huge_pages_recovery_ratio, 0644);
 __MODULE_PARM_TYPE(nx_huge_pages_recovery_ratio, "uint");
 
+/*
+ * If set, VMs with TDP (EPT/NPT) use the rmap-less TDP MMU for their direct
+ * roots.  The value is snapshotted per-VM at creation, so flipping it only
+ * affects VMs created afterwards.
+ */
+static bool __read_mostly tdp_mmu_allowed;
+module_param_named(tdp_mmu, tdp_mmu_allowed, bool, 0444);
+
 /*
  * When setting this variable to true it enables Two-Dimensional-Paging
  * where the hardware walks 2 page tables:
@@ -307,6 +315,21 @@ static bool is_executable_pte(u64 spte);
 static union kvm_mmu_page_role
 kvm_mmu_calc_root_page_role(struct kvm_vcpu *vcpu);
 
+/* TDP MMU entry points used before their definitions, see below. */
+static int kvm_tdp_mmu_zap_hva_range(struct kvm *kvm, unsigned long start,
+				     unsigned long end);
+static int kvm_tdp_mmu_set_spte_hva(struct kvm *kvm, unsigned long hva);
+static int kvm_tdp_mmu_age_hva_range(struct kvm *kvm, unsigned long start,
+				     unsigned long end);
+static int kvm_tdp_mmu_test_age_hva(struct kvm *kvm, unsigned long hva);
+static void kvm_tdp_mmu_clear_dirty_pt_masked(struct kvm *kvm,
+					      struct kvm_memory_slot *slot,
+					      gfn_t gfn_offset,
+					      unsigned long mask, bool wrprot);
+static bool kvm_tdp_mmu_write_protect_gfn(struct kvm *kvm,
+					  struct kvm_memory_slot *slot,
+					  gfn_t gfn);
+
 #define CREATE_TRACE_POINTS
 #include "mmutrace.h"
 
@@ -1754,6 +1777,10 @@ static void kvm_mmu_write_protect_pt_masked(struct kvm *kvm,
 {
 	struct kvm_rmap_head *rmap_head;
 
+	if (kvm->arch.tdp_mmu_enabled)
+		kvm_tdp_mmu_clear_dirty_pt_masked(kvm, slot, gfn_offset,
+						  mask, true);
+
 	while (mask) {
 		rmap_head = __gfn_to_rmap(slot->base_gfn + gfn_offset + __ffs(mask),
 					  PT_PAGE_TABLE_LEVEL, slot);
@@ -1780,6 +1807,10 @@ void kvm_mmu_clear_dirty_pt_masked(struct kvm *kvm,
 {
 	struct kvm_rmap_head *rmap_head;
 
+	if (kvm->arch.tdp_mmu_enabled)
+		kvm_tdp_mmu_clear_dirty_pt_masked(kvm, slot, gfn_offset,
+						  mask, false);
+
 	while (mask) {
 		rmap_head = __gfn_to_rmap(slot->base_gfn + gfn_offset + __ffs(mask),
 					  PT_PAGE_TABLE_LEVEL, slot);
@@ -1839,6 +1870,9 @@ bool kvm_mmu_slot_gfn_write_protect(struct kvm *kvm,
 		write_protected |= __rmap_write_protect(kvm, rmap_head, true);
 	}
 
+	if (kvm->arch.tdp_mmu_enabled)
+		write_protected |= kvm_tdp_mmu_write_protect_gfn(kvm, slot, gfn);
+
 	return write_protected;
 }
 
@@ -2047,12 +2081,26 @@ static int kvm_handle_hva(struct kvm *kvm, unsigned long hva,
 
 int kvm_unmap_hva_range(struct kvm *kvm, unsigned long start, unsigned long end)
 {
-	return kvm_handle_hva_range(kvm, start, end, 0, kvm_unmap_rmapp);
+	int flush;
+
+	flush = kvm_handle_hva_range(kvm, start, end, 0, kvm_unmap_rmapp);
+
+	if (kvm->arch.tdp_mmu_enabled)
+		flush |= kvm_tdp_mmu_zap_hva_range(kvm, start, end);
+
+	return flush;
 }
 
 int kvm_set_spte_hva(struct kvm *kvm, unsigned long hva, pte_t pte)
 {
-	return kvm_handle_hva(kvm, hva, (unsigned long)&pte, kvm_set_pte_rmapp);
+	int flush;
+
+	flush = kvm_handle_hva(kvm, hva, (unsigned long)&pte, kvm_set_pte_rmapp);
+
+	if (kvm->arch.tdp_mmu_enabled)
+		flush |= kvm_tdp_mmu_set_spte_hva(kvm, hva);
+
+	return flush;
 }
 
 static int kvm_age_rmapp(struct kvm *kvm, struct kvm_rmap_head *rmap_head,
@@ -2101,12 +2149,26 @@ static void rmap_recycle(struct kvm_vcpu *vcpu, u64 *spte, gfn_t gfn)
 
 int kvm_age_hva(struct kvm *kvm, unsigned long start, unsigned long end)
 {
-	return kvm_handle_hva_range(kvm, start, end, 0, kvm_age_rmapp);
+	int young;
+
+	young = kvm_handle_hva_range(kvm, start, end, 0, kvm_age_rmapp);
+
+	if (kvm->arch.tdp_mmu_enabled)
+		young |= kvm_tdp_mmu_age_hva_range(kvm, start, end);
+
+	return young;
 }
 
 int kvm_test_age_hva(struct kvm *kvm, unsigned long hva)
 {
-	return kvm_handle_hva(kvm, hva, 0, kvm_test_age_rmapp);
+	int young;
+
+	young = kvm_handle_hva(kvm, hva, 0, kvm_test_age_rmapp);
+
+	if (kvm->arch.tdp_mmu_enabled)
+		young |= kvm_tdp_mmu_test_age_hva(kvm, hva);
+
+	return young;
 }
 
 #ifdef MMU_DEBUG
@@ -3366,246 +3428,1232 @@ static int __direct_map(struct kvm_vcpu *vcpu, gpa_t gpa, int write,
 	return ret;
 }
 
-static void kvm_send_hwpoison_signal(unsigned long address, struct task_struct *tsk)
-{
-	send_sig_mceerr(BUS_MCEERR_AR, (void __user *)address, PAGE_SHIFT, tsk);
-}
+/*
+ * The TDP MMU.
+ *
+ * An alternative page table manager for VMs using TDP (EPT/NPT), opt-in via
+ * the tdp_mmu module parameter.  The shadow MMU keys every shadow page in a
+ * hash table and threads every SPTE onto per-gfn rmap chains so that guest
+ * page table emulation can find them; none of that is needed when the
+ * hardware walks the guest page tables and KVM only maps guest-physical to
+ * host-physical.  The TDP MMU therefore builds plain direct page tables,
+ * reachable only through their parent SPTEs, and walks them by gfn with a
+ * dedicated iterator.  That removes the rmap memory overhead and the rmap
+ * update cost from the fault path, which is what limits huge guests during
+ * dirty logging and migration.
+ *
+ * All operations here still run under mmu_lock, like the shadow MMU.  The
+ * gfn-based iterator and the strict parent-before-child teardown (with a
+ * remote TLB flush before any table page is freed, which is also what keeps
+ * the lockless walkers in fast_page_fault() and get_mmio_spte() safe, cf.
+ * kvm_mmu_commit_zap_page()) are structured so that the walks could later be
+ * done under a read-mostly lock, but that conversion is not part of this
+ * code.
+ *
+ * TDP MMU pages are not accounted in n_used_mmu_pages and are invisible to
+ * the mmu_shrinker; their size is bounded by the direct mapping of the
+ * guest address space.
+ */
 
-static int kvm_handle_bad_page(struct kvm_vcpu *vcpu, gfn_t gfn, kvm_pfn_t pfn)
-{
+struct tdp_iter {
 	/*
-	 * Do not cache the mmio info caused by writing the readonly gfn
-	 * into the spte otherwise read access on readonly gfn also can
-	 * caused mmio page fault and treat it as mmio access.
+	 * The iterator will traverse the paging structure towards the mapping
+	 * for this GFN.
 	 */
-	if (pfn == KVM_PFN_ERR_RO_FAULT)
-		return RET_PF_EMULATE;
-
-	if (pfn == KVM_PFN_ERR_HWPOISON) {
-		kvm_send_hwpoison_signal(kvm_vcpu_gfn_to_hva(vcpu, gfn), current);
-		return RET_PF_RETRY;
-	}
+	gfn_t next_last_level_gfn;
+	/* Pointers to the page tables traversed to reach the current SPTE */
+	u64 *pt_path[PT64_ROOT_MAX_LEVEL];
+	/* A pointer to the current SPTE */
+	u64 *sptep;
+	/* The lowest GFN mapped by the current SPTE */
+	gfn_t gfn;
+	/* The level of the root page given to the iterator */
+	int root_level;
+	/* The lowest level the iterator should traverse to */
+	int min_level;
+	/* The iterator's current level within the paging structure */
+	int level;
+	/* A snapshot of the value at sptep */
+	u64 old_spte;
+	/*
+	 * Whether the iterator has a valid state. This will be false if the
+	 * iterator walks off the end of the paging structure.
+	 */
+	bool valid;
+};
 
-	return -EFAULT;
+static gfn_t round_gfn_for_level(gfn_t gfn, int level)
+{
+	return gfn & -KVM_PAGES_PER_HPAGE(level);
 }
 
-static void transparent_hugepage_adjust(struct kvm_vcpu *vcpu,
-					gfn_t gfn, kvm_pfn_t *pfnp,
-					int *levelp)
+static void tdp_iter_refresh_sptep(struct tdp_iter *iter)
 {
-	kvm_pfn_t pfn = *pfnp;
-	int level = *levelp;
-
-	/*
-	 * Check if it's a transparent hugepage. If this would be an
-	 * hugetlbfs page, level wouldn't be set to
-	 * PT_PAGE_TABLE_LEVEL and there would be no adjustment done
-	 * here.
-	 */
-	if (!is_error_noslot_pfn(pfn) && !kvm_is_reserved_pfn(pfn) &&
-	    !kvm_is_zone_device_pfn(pfn) && level == PT_PAGE_TABLE_LEVEL &&
-	    PageTransCompoundMap(pfn_to_page(pfn)) &&
-	    !mmu_gfn_lpage_is_disallowed(vcpu, gfn, PT_DIRECTORY_LEVEL)) {
-		unsigned long mask;
-		/*
-		 * mmu_notifier_retry was successful and we hold the
-		 * mmu_lock here, so the pmd can't become splitting
-		 * from under us, and in turn
-		 * __split_huge_page_refcount() can't run from under
-		 * us and we can safely transfer the refcount from
-		 * PG_tail to PG_head as we switch the pfn to tail to
-		 * head.
-		 */
-		*levelp = level = PT_DIRECTORY_LEVEL;
-		mask = KVM_PAGES_PER_HPAGE(level) - 1;
-		VM_BUG_ON((gfn & mask) != (pfn & mask));
-		if (pfn & mask) {
-			kvm_release_pfn_clean(pfn);
-			pfn &= ~mask;
-			kvm_get_pfn(pfn);
-			*pfnp = pfn;
-		}
-	}
+	iter->sptep = iter->pt_path[iter->level - 1] +
+		SHADOW_PT_INDEX(iter->gfn << PAGE_SHIFT, iter->level);
+	iter->old_spte = READ_ONCE(*iter->sptep);
 }
 
-static bool handle_abnormal_pfn(struct kvm_vcpu *vcpu, gva_t gva, gfn_t gfn,
-				kvm_pfn_t pfn, unsigned access, int *ret_val)
+/*
+ * Set up a TDP iterator to walk a direct paging structure rooted at @root_pt,
+ * in order to visit the SPTE mapping @next_last_level_gfn and then all
+ * following SPTEs in gfn order.
+ */
+static void tdp_iter_start(struct tdp_iter *iter, u64 *root_pt, int root_level,
+			   int min_level, gfn_t next_last_level_gfn)
 {
-	/* The pfn is invalid, report the error! */
-	if (unlikely(is_error_pfn(pfn))) {
-		*ret_val = kvm_handle_bad_page(vcpu, gfn, pfn);
-		return true;
-	}
+	WARN_ON(root_level < 1);
+	WARN_ON(root_level > PT64_ROOT_MAX_LEVEL);
 
-	if (unlikely(is_noslot_pfn(pfn)))
-		vcpu_cache_mmio_info(vcpu, gva, gfn,
-				     access & shadow_mmio_access_mask);
+	iter->next_last_level_gfn = next_last_level_gfn;
+	iter->root_level = root_level;
+	iter->min_level = min_level;
+	iter->level = root_level;
+	iter->pt_path[iter->level - 1] = root_pt;
 
-	return false;
+	iter->gfn = round_gfn_for_level(iter->next_last_level_gfn, iter->level);
+	tdp_iter_refresh_sptep(iter);
+
+	iter->valid = true;
 }
 
-static bool page_fault_can_be_fast(u32 error_code)
+/*
+ * Steps down one level in the paging structure towards the goal GFN. Returns
+ * true if the iterator was able to step down a level, false otherwise.
+ */
+static bool try_step_down(struct tdp_iter *iter)
 {
-	/*
-	 * Do not fix the mmio spte with invalid generation number which
-	 * need to be updated by slow page fault path.
-	 */
-	if (unlikely(error_code & PFERR_RSVD_MASK))
-		return false;
+	u64 *child_pt;
 
-	/* See if the page fault is due to an NX violation */
-	if (unlikely(((error_code & (PFERR_FETCH_MASK | PFERR_PRESENT_MASK))
-		      == (PFERR_FETCH_MASK | PFERR_PRESENT_MASK))))
+	if (iter->level == iter->min_level)
 		return false;
 
 	/*
-	 * #PF can be fast if:
-	 * 1. The shadow page table entry is not present, which could mean that
-	 *    the fault is potentially caused by access tracking (if enabled).
-	 * 2. The shadow page table entry is present and the fault
-	 *    is caused by write-protect, that means we just need change the W
-	 *    bit of the spte which can be done out of mmu-lock.
-	 *
-	 * However, if access tracking is disabled we know that a non-present
-	 * page must be a genuine page fault where we have to create a new SPTE.
-	 * So, if access tracking is disabled, we return true only for write
-	 * accesses to a present page.
+	 * Reread the SPTE before stepping down to avoid traversing into page
+	 * tables that are no longer linked from this entry.
 	 */
+	iter->old_spte = READ_ONCE(*iter->sptep);
 
-	return shadow_acc_track_mask != 0 ||
-	       ((error_code & (PFERR_WRITE_MASK | PFERR_PRESENT_MASK))
-		== (PFERR_WRITE_MASK | PFERR_PRESENT_MASK));
+	if (!is_shadow_present_pte(iter->old_spte) ||
+	    is_last_spte(iter->old_spte, iter->level))
+		return false;
+
+	child_pt = __va(iter->old_spte & PT64_BASE_ADDR_MASK);
+
+	iter->level--;
+	iter->pt_path[iter->level - 1] = child_pt;
+	iter->gfn = round_gfn_for_level(iter->next_last_level_gfn, iter->level);
+	tdp_iter_refresh_sptep(iter);
+
+	return true;
 }
 
 /*
- * Returns true if the SPTE was fixed successfully. Otherwise,
- * someone else modified the SPTE from its original value.
+ * Steps to the next entry in the current page table, at the current page
+ * table level. The next entry could point to a page backing guest memory or
+ * another page table, or be non-present. Returns true if the iterator was
+ * able to step to the next entry in the page table, false if the iterator
+ * was already at the end of the current page table.
  */
-static bool
-fast_pf_fix_direct_spte(struct kvm_vcpu *vcpu, struct kvm_mmu_page *sp,
-			u64 *sptep, u64 old_spte, u64 new_spte)
+static bool try_step_side(struct tdp_iter *iter)
 {
-	gfn_t gfn;
-
-	WARN_ON(!sp->role.direct);
-
 	/*
-	 * Theoretically we could also set dirty bit (and flush TLB) here in
-	 * order to eliminate unnecessary PML logging. See comments in
-	 * set_spte. But fast_page_fault is very unlikely to happen with PML
-	 * enabled, so we do not do this. This might result in the same GPA
-	 * to be logged in PML buffer again when the write really happens, and
-	 * eventually to be called by mark_page_dirty twice. But it's also no
-	 * harm. This also avoids the TLB flush needed after setting dirty bit
-	 * so non-PML cases won't be impacted.
-	 *
-	 * Compare with set_spte where instead shadow_dirty_mask is set.
+	 * Check if the iterator is already at the end of the current page
+	 * table.
 	 */
-	if (cmpxchg64(sptep, old_spte, new_spte) != old_spte)
+	if (SHADOW_PT_INDEX(iter->gfn << PAGE_SHIFT, iter->level) ==
+	    (PT64_ENT_PER_PAGE - 1))
 		return false;
 
-	if (is_writable_pte(new_spte) && !is_writable_pte(old_spte)) {
-		/*
-		 * The gfn of direct spte is stable since it is
-		 * calculated by sp->gfn.
-		 */
-		gfn = kvm_mmu_page_get_gfn(sp, sptep - sp->spt);
-		kvm_vcpu_mark_page_dirty(vcpu, gfn);
-	}
+	iter->gfn += KVM_PAGES_PER_HPAGE(iter->level);
+	iter->next_last_level_gfn = iter->gfn;
+	iter->sptep++;
+	iter->old_spte = READ_ONCE(*iter->sptep);
 
 	return true;
 }
 
-static bool is_access_allowed(u32 fault_err_code, u64 spte)
+/*
+ * Tries to traverse back up a level in the paging structure so that the walk
+ * can continue from the next entry in the parent page table. Returns true on
+ * a successful step up, false if already in the root page.
+ */
+static bool try_step_up(struct tdp_iter *iter)
 {
-	if (fault_err_code & PFERR_FETCH_MASK)
-		return is_executable_pte(spte);
+	if (iter->level == iter->root_level)
+		return false;
 
-	if (fault_err_code & PFERR_WRITE_MASK)
-		return is_writable_pte(spte);
+	iter->level++;
+	iter->gfn = round_gfn_for_level(iter->gfn, iter->level);
+	tdp_iter_refresh_sptep(iter);
 
-	/* Fault was on Read access */
-	return spte & PT_PRESENT_MASK;
+	return true;
 }
 
 /*
- * Return value:
- * - true: let the vcpu to access on the same address again.
- * - false: let the real page fault path to fix it.
+ * Step to the next SPTE in a pre-order traversal of the paging structure.
+ * To get to the next SPTE, the iterator either steps down towards the goal
+ * GFN, if at a present, non-last-level SPTE, or over to a SPTE mapping a
+ * highter GFN.
  */
-static bool fast_page_fault(struct kvm_vcpu *vcpu, gpa_t cr2_or_gpa, int level,
-			    u32 error_code)
+static void tdp_iter_next(struct tdp_iter *iter)
 {
-	struct kvm_shadow_walk_iterator iterator;
-	struct kvm_mmu_page *sp;
-	bool fault_handled = false;
-	u64 spte = 0ull;
-	uint retry_count = 0;
+	if (try_step_down(iter))
+		return;
 
-	if (!VALID_PAGE(vcpu->arch.mmu->root_hpa))
-		return false;
+	do {
+		if (try_step_side(iter))
+			return;
+	} while (try_step_up(iter));
+	iter->valid = false;
+}
 
-	if (!page_fault_can_be_fast(error_code))
-		return false;
+#define for_each_tdp_pte_min_level(_iter, _root, _min_level, _start, _end)  \
+	for (tdp_iter_start(&_iter, _root->spt, _root->role.level,	    \
+			    _min_level, _start);			    \
+	     _iter.valid && _iter.gfn < _end;				    \
+	     tdp_iter_next(&_iter))
 
-	walk_shadow_page_lockless_begin(vcpu);
+#define tdp_root_for_each_pte(_iter, _root, _start, _end)		    \
+	for_each_tdp_pte_min_level(_iter, _root, PT_PAGE_TABLE_LEVEL,	    \
+				   _start, _end)
 
-	do {
-		u64 new_spte;
+static gfn_t tdp_mmu_max_gfn(void)
+{
+	return 1ULL << (shadow_phys_bits - PAGE_SHIFT);
+}
 
-		for_each_shadow_entry_lockless(vcpu, cr2_or_gpa, iterator, spte)
-			if (!is_shadow_present_pte(spte) ||
-			    iterator.level < level)
-				break;
+static union kvm_mmu_page_role tdp_mmu_page_role(struct kvm_vcpu *vcpu,
+						 int level)
+{
+	union kvm_mmu_page_role role;
 
-		sp = page_header(__pa(iterator.sptep));
-		if (!is_last_spte(spte, sp->role.level))
-			break;
+	role = vcpu->arch.mmu->mmu_role.base;
+	role.level = level;
+	role.direct = true;
+	role.gpte_is_8_bytes = true;
+	role.access = ACC_ALL;
 
-		/*
-		 * Check whether the memory access that caused the fault would
-		 * still cause it if it were to be performed right now. If not,
-		 * then this is a spurious fault caused by TLB lazily flushed,
-		 * or some other CPU has already fixed the PTE after the
-		 * current CPU took the fault.
-		 *
-		 * Need not check the access of upper level table entries since
-		 * they are always ACC_ALL.
-		 */
-		if (is_access_allowed(error_code, spte)) {
-			fault_handled = true;
-			break;
-		}
+	return role;
+}
 
-		new_spte = spte;
+static struct kvm_mmu_page *alloc_tdp_mmu_page(struct kvm_vcpu *vcpu, gfn_t gfn,
+					       int level)
+{
+	struct kvm_mmu_page *sp;
 
-		if (is_access_track_spte(spte))
-			new_spte = restore_acc_track_spte(new_spte);
+	sp = mmu_memory_cache_alloc(&vcpu->arch.mmu_page_header_cache);
+	sp->spt = mmu_memory_cache_alloc(&vcpu->arch.mmu_page_cache);
+	set_page_private(virt_to_page(sp->spt), (unsigned long)sp);
 
-		/*
-		 * Currently, to simplify the code, write-protection can
-		 * be removed in the fast path only if the SPTE was
-		 * write-protected for dirty-logging or access tracking.
-		 */
-		if ((error_code & PFERR_WRITE_MASK) &&
-		    spte_can_locklessly_be_made_writable(spte))
-		{
-			new_spte |= PT_WRITABLE_MASK;
+	sp->role = tdp_mmu_page_role(vcpu, level);
+	sp->gfn = gfn;
+	sp->tdp_mmu_page = true;
 
-			/*
-			 * Do not fix write-permission on the large spte.  Since
-			 * we only dirty the first page into the dirty-bitmap in
-			 * fast_pf_fix_direct_spte(), other pages are missed
-			 * if its slot has dirty logging enabled.
-			 *
-			 * Instead, we let the slow page fault path create a
-			 * normal spte to fix the access.
-			 *
-			 * See the comments in kvm_arch_commit_memory_region().
-			 */
-			if (sp->role.level > PT_PAGE_TABLE_LEVEL)
-				break;
-		}
+	clear_page(sp->spt);
+
+	return sp;
+}
+
+static void handle_removed_pt(struct kvm *kvm, u64 old_spte);
+
+/*
+ * Zap the SPTE at the iterator's position, dropping the page table page it
+ * points to if it is a non-last-level SPTE.  The caller is responsible for
+ * flushing remote TLBs for the zapped range; disconnected page table pages
+ * themselves are flushed and freed by handle_removed_pt().
+ */
+static void tdp_mmu_zap_spte(struct kvm *kvm, struct tdp_iter *iter)
+{
+	if (is_last_spte(iter->old_spte, iter->level)) {
+		if (mmu_spte_clear_track_bits(iter->sptep) &&
+		    is_large_pte(iter->old_spte))
+			--kvm->stat.lpages;
+	} else {
+		mmu_spte_clear_no_track(iter->sptep);
+		handle_removed_pt(kvm, iter->old_spte);
+	}
+	iter->old_spte = 0ull;
+}
+
+/*
+ * Disconnect and free the page table page referenced by @old_spte, zapping
+ * all the mappings below it.  The caller must already have cleared the
+ * parent SPTE.
+ *
+ * The remote TLB flush before the page is freed forces vCPUs doing lockless
+ * walks (fast_page_fault(), get_mmio_spte()) out of the paging structure
+ * first, exactly as kvm_mmu_commit_zap_page() does for the shadow MMU.
+ */
+static void handle_removed_pt(struct kvm *kvm, u64 old_spte)
+{
+	struct kvm_mmu_page *sp = page_header(old_spte & PT64_BASE_ADDR_MASK);
+	int level = sp->role.level;
+	int i;
+
+	for (i = 0; i < PT64_ENT_PER_PAGE; i++) {
+		u64 *sptep = sp->spt + i;
+		u64 spte = *sptep;
+
+		if (!is_shadow_present_pte(spte)) {
+			/* Clear any MMIO SPTEs along with the page table. */
+			if (spte)
+				mmu_spte_clear_no_track(sptep);
+		} else if (is_last_spte(spte, level)) {
+			if (mmu_spte_clear_track_bits(sptep) &&
+			    is_large_pte(spte))
+				--kvm->stat.lpages;
+		} else {
+			mmu_spte_clear_no_track(sptep);
+			handle_removed_pt(kvm, spte);
+		}
+	}
+
+	kvm_flush_remote_tlbs_with_address(kvm, sp->gfn,
+					   KVM_PAGES_PER_HPAGE(level + 1));
+
+	if (sp->lpage_disallowed)
+		unaccount_huge_nx_page(kvm, sp);
+
+	free_page((unsigned long)sp->spt);
+	kmem_cache_free(mmu_page_header_cache, sp);
+}
+
+/*
+ * Flush pending TLB invalidations and yield mmu_lock if contended.  Returns
+ * true if the walk was interrupted, in which case the iterator has been
+ * reset to continue from the next unvisited last-level gfn and the caller
+ * should skip to the next iteration.
+ */
+static bool tdp_mmu_iter_cond_resched(struct kvm *kvm, struct tdp_iter *iter,
+				      bool flush)
+{
+	if (!need_resched() && !spin_needbreak(&kvm->mmu_lock))
+		return false;
+
+	if (flush)
+		kvm_flush_remote_tlbs(kvm);
+
+	cond_resched_lock(&kvm->mmu_lock);
+	tdp_iter_start(iter, iter->pt_path[iter->root_level - 1],
+		       iter->root_level, iter->min_level,
+		       iter->next_last_level_gfn);
+
+	return true;
+}
+
+/*
+ * Remove all mappings in [start, end) below @root.  If @can_yield is true,
+ * mmu_lock may be released and reacquired during the walk.  Returns true if
+ * the caller needs to flush remote TLBs.
+ */
+static bool zap_gfn_range(struct kvm *kvm, struct kvm_mmu_page *root,
+			  gfn_t start, gfn_t end, bool can_yield)
+{
+	struct tdp_iter iter;
+	bool flush_needed = false;
+
+	tdp_root_for_each_pte(iter, root, start, end) {
+		if (can_yield &&
+		    tdp_mmu_iter_cond_resched(kvm, &iter, flush_needed)) {
+			flush_needed = false;
+			continue;
+		}
+
+		if (!is_shadow_present_pte(iter.old_spte))
+			continue;
+
+		/*
+		 * If this is a non-last-level SPTE that covers a larger range
+		 * than should be zapped, continue, and zap the mappings at a
+		 * lower level.
+		 */
+		if ((iter.gfn < start ||
+		     iter.gfn + KVM_PAGES_PER_HPAGE(iter.level) > end) &&
+		    !is_last_spte(iter.old_spte, iter.level))
+			continue;
+
+		tdp_mmu_zap_spte(kvm, &iter);
+		flush_needed = true;
+	}
+
+	return flush_needed;
+}
+
+static void kvm_tdp_mmu_free_root(struct kvm *kvm, struct kvm_mmu_page *root)
+{
+	lockdep_assert_held(&kvm->mmu_lock);
+	WARN_ON(root->root_count);
+
+	list_del(&root->link);
+
+	if (zap_gfn_range(kvm, root, 0, tdp_mmu_max_gfn(), true))
+		kvm_flush_remote_tlbs(kvm);
+
+	free_page((unsigned long)root->spt);
+	kmem_cache_free(mmu_page_header_cache, root);
+}
+
+static void get_tdp_mmu_root(struct kvm *kvm, struct kvm_mmu_page *root)
+{
+	lockdep_assert_held(&kvm->mmu_lock);
+	WARN_ON(!root->root_count);
+
+	++root->root_count;
+}
+
+/*
+ * Drop a root reference, freeing the root if it was the last one.  Returns
+ * true if the root was freed, in which case a caller iterating
+ * tdp_mmu_roots must restart its walk.
+ */
+static bool put_tdp_mmu_root(struct kvm *kvm, struct kvm_mmu_page *root)
+{
+	lockdep_assert_held(&kvm->mmu_lock);
+
+	if (--root->root_count)
+		return false;
+
+	kvm_tdp_mmu_free_root(kvm, root);
+	return true;
+}
+
+static bool is_tdp_mmu_root(struct kvm *kvm, hpa_t hpa)
+{
+	struct kvm_mmu_page *sp;
+
+	if (!kvm->arch.tdp_mmu_enabled)
+		return false;
+	if (WARN_ON(!VALID_PAGE(hpa)))
+		return false;
+
+	sp = page_header(hpa);
+
+	return sp->tdp_mmu_page && sp->root_count;
+}
+
+static struct kvm_mmu_page *kvm_tdp_mmu_get_vcpu_root(struct kvm_vcpu *vcpu)
+{
+	union kvm_mmu_page_role role;
+	struct kvm *kvm = vcpu->kvm;
+	struct kvm_mmu_page *root;
+
+	role = tdp_mmu_page_role(vcpu, vcpu->arch.mmu->shadow_root_level);
+
+	spin_lock(&kvm->mmu_lock);
+
+	/* Check for an existing root before allocating a new one. */
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		if (root->role.word == role.word) {
+			get_tdp_mmu_root(kvm, root);
+			spin_unlock(&kvm->mmu_lock);
+			return root;
+		}
+	}
+
+	root = alloc_tdp_mmu_page(vcpu, 0, vcpu->arch.mmu->shadow_root_level);
+	root->root_count = 1;
+
+	list_add(&root->link, &kvm->arch.tdp_mmu_roots);
+
+	spin_unlock(&kvm->mmu_lock);
+
+	return root;
+}
+
+/*
+ * Handle a TDP page fault (NPT/EPT violation/misconfiguration), the TDP MMU
+ * counterpart of __direct_map(): installs any missing intermediate page
+ * tables and the final SPTE for the faulting access.
+ */
+static int kvm_tdp_mmu_map(struct kvm_vcpu *vcpu, gpa_t gpa, int write,
+			   int map_writable, int level, kvm_pfn_t pfn,
+			   bool prefault, bool lpage_disallowed)
+{
+	struct kvm_mmu *mmu = vcpu->arch.mmu;
+	struct kvm_mmu_page *root;
+	struct kvm_mmu_page *sp;
+	struct tdp_iter iter;
+	u64 new_spte;
+	int set_spte_ret;
+	int ret = RET_PF_RETRY;
+	gfn_t gfn = gpa >> PAGE_SHIFT;
+	gfn_t base_gfn = gfn;
+	bool was_present;
+
+	if (!VALID_PAGE(mmu->root_hpa))
+		return RET_PF_RETRY;
+
+	trace_kvm_mmu_spte_requested(gpa, level, pfn);
+
+	root = page_header(mmu->root_hpa);
+
+	tdp_root_for_each_pte(iter, root, gfn, gfn + 1) {
+		/*
+		 * As in __direct_map(), do not overwrite an existing small
+		 * page table with an NX huge page: go down a level instead.
+		 */
+		if (iter.level == level && level > PT_PAGE_TABLE_LEVEL &&
+		    is_nx_huge_page_enabled() &&
+		    is_shadow_present_pte(iter.old_spte) &&
+		    !is_large_pte(iter.old_spte)) {
+			u64 page_mask = KVM_PAGES_PER_HPAGE(level) -
+					KVM_PAGES_PER_HPAGE(level - 1);
+
+			pfn |= gfn & page_mask;
+			level--;
+		}
+
+		base_gfn = gfn & ~(KVM_PAGES_PER_HPAGE(iter.level) - 1);
+		if (iter.level == level)
+			break;
+
+		/*
+		 * If there is a huge page mapped at a higher level than the
+		 * target, it must be split: zap it and install a page table
+		 * in its place.
+		 */
+		if (is_shadow_present_pte(iter.old_spte) &&
+		    is_large_pte(iter.old_spte)) {
+			tdp_mmu_zap_spte(vcpu->kvm, &iter);
+			kvm_flush_remote_tlbs_with_address(vcpu->kvm, iter.gfn,
+					KVM_PAGES_PER_HPAGE(iter.level));
+		}
+
+		if (!is_shadow_present_pte(iter.old_spte)) {
+			sp = alloc_tdp_mmu_page(vcpu, base_gfn,
+						iter.level - 1);
+
+			/* Same non-leaf SPTE bits as link_shadow_page(). */
+			new_spte = __pa(sp->spt) | shadow_present_mask |
+				   PT_WRITABLE_MASK | shadow_user_mask |
+				   shadow_x_mask | shadow_me_mask;
+
+			if (sp_ad_disabled(sp))
+				new_spte |= SPTE_AD_DISABLED_MASK;
+			else
+				new_spte |= shadow_accessed_mask;
+
+			mmu_spte_set(iter.sptep, new_spte);
+			iter.old_spte = new_spte;
+
+			if (lpage_disallowed)
+				account_huge_nx_page(vcpu->kvm, sp);
+		}
+	}
+
+	if (WARN_ON(iter.level != level))
+		return RET_PF_RETRY;
+
+	/*
+	 * If the pfn changed (e.g. because the backing page was migrated and
+	 * the stale mapping not yet zapped by the mmu_notifier), drop the old
+	 * SPTE so that set_spte() starts from a non-present one.
+	 */
+	if (is_shadow_present_pte(iter.old_spte) &&
+	    spte_to_pfn(iter.old_spte) != pfn) {
+		tdp_mmu_zap_spte(vcpu->kvm, &iter);
+		kvm_flush_remote_tlbs_with_address(vcpu->kvm, iter.gfn,
+				KVM_PAGES_PER_HPAGE(iter.level));
+	}
+
+	was_present = is_shadow_present_pte(iter.old_spte);
+
+	set_spte_ret = set_spte(vcpu, iter.sptep, ACC_ALL, iter.level,
+				base_gfn, pfn, prefault, true, map_writable);
+	if (set_spte_ret & SET_SPTE_WRITE_PROTECTED_PT) {
+		if (write)
+			ret = RET_PF_EMULATE;
+		kvm_make_request(KVM_REQ_TLB_FLUSH, vcpu);
+	}
+
+	if (set_spte_ret & SET_SPTE_NEED_REMOTE_TLB_FLUSH)
+		kvm_flush_remote_tlbs_with_address(vcpu->kvm, base_gfn,
+				KVM_PAGES_PER_HPAGE(iter.level));
+
+	if (unlikely(is_mmio_spte(*iter.sptep)))
+		ret = RET_PF_EMULATE;
+
+	trace_kvm_mmu_set_spte(iter.level, base_gfn, iter.sptep);
+	if (!was_present && is_large_pte(*iter.sptep))
+		++vcpu->kvm->stat.lpages;
+
+	++vcpu->stat.pf_fixed;
+	return ret;
+}
+
+/*
+ * Iterate over the TDP MMU roots, applying @handler to the gfn ranges of
+ * every memslot intersecting [start, end).  The handlers must not release
+ * mmu_lock, so no root references are needed; see the slot-wide operations
+ * below for the yielding variant.
+ */
+static int kvm_tdp_mmu_handle_hva_range(struct kvm *kvm, unsigned long start,
+		unsigned long end, unsigned long data,
+		int (*handler)(struct kvm *kvm, struct kvm_memory_slot *slot,
+			       struct kvm_mmu_page *root, gfn_t start,
+			       gfn_t end, unsigned long data))
+{
+	struct kvm_memslots *slots;
+	struct kvm_memory_slot *memslot;
+	struct kvm_mmu_page *root;
+	int ret = 0;
+
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		slots = kvm_memslots_for_spte_role(kvm, root->role);
+		kvm_for_each_memslot(memslot, slots) {
+			unsigned long hva_start, hva_end;
+			gfn_t gfn_start, gfn_end;
+
+			hva_start = max(start, memslot->userspace_addr);
+			hva_end = min(end, memslot->userspace_addr +
+				      (memslot->npages << PAGE_SHIFT));
+			if (hva_start >= hva_end)
+				continue;
+			/*
+			 * {gfn(page) | page intersects with [hva_start, hva_end)} =
+			 * {gfn_start, gfn_start+1, ..., gfn_end-1}.
+			 */
+			gfn_start = hva_to_gfn_memslot(hva_start, memslot);
+			gfn_end = hva_to_gfn_memslot(hva_end + PAGE_SIZE - 1,
+						     memslot);
+
+			ret |= handler(kvm, memslot, root, gfn_start, gfn_end,
+				       data);
+		}
+	}
+
+	return ret;
+}
+
+static int zap_gfn_range_hva_handler(struct kvm *kvm,
+				     struct kvm_memory_slot *slot,
+				     struct kvm_mmu_page *root, gfn_t start,
+				     gfn_t end, unsigned long data)
+{
+	return zap_gfn_range(kvm, root, start, end, false);
+}
+
+static int kvm_tdp_mmu_zap_hva_range(struct kvm *kvm, unsigned long start,
+				     unsigned long end)
+{
+	return kvm_tdp_mmu_handle_hva_range(kvm, start, end, 0,
+					    zap_gfn_range_hva_handler);
+}
+
+/*
+ * The pfn backing the gfn changed (mmu_notifier change_pte): zap the old
+ * mapping and let the next access fault in the new pfn.
+ */
+static int kvm_tdp_mmu_set_spte_hva(struct kvm *kvm, unsigned long hva)
+{
+	return kvm_tdp_mmu_handle_hva_range(kvm, hva, hva + 1, 0,
+					    zap_gfn_range_hva_handler);
+}
+
+static int age_gfn_range(struct kvm *kvm, struct kvm_memory_slot *slot,
+			 struct kvm_mmu_page *root, gfn_t start, gfn_t end,
+			 unsigned long data)
+{
+	struct tdp_iter iter;
+	int young = 0;
+
+	tdp_root_for_each_pte(iter, root, start, end) {
+		if (!is_shadow_present_pte(iter.old_spte) ||
+		    !is_last_spte(iter.old_spte, iter.level))
+			continue;
+
+		young |= mmu_spte_age(iter.sptep);
+	}
+
+	return young;
+}
+
+static int kvm_tdp_mmu_age_hva_range(struct kvm *kvm, unsigned long start,
+				     unsigned long end)
+{
+	return kvm_tdp_mmu_handle_hva_range(kvm, start, end, 0, age_gfn_range);
+}
+
+static int test_age_gfn_range(struct kvm *kvm, struct kvm_memory_slot *slot,
+			      struct kvm_mmu_page *root, gfn_t start,
+			      gfn_t end, unsigned long data)
+{
+	struct tdp_iter iter;
+	int young = 0;
+
+	tdp_root_for_each_pte(iter, root, start, end) {
+		if (!is_shadow_present_pte(iter.old_spte) ||
+		    !is_last_spte(iter.old_spte, iter.level))
+			continue;
+
+		young |= is_accessed_spte(iter.old_spte);
+	}
+
+	return young;
+}
+
+static int kvm_tdp_mmu_test_age_hva(struct kvm *kvm, unsigned long hva)
+{
+	return kvm_tdp_mmu_handle_hva_range(kvm, hva, hva + 1, 0,
+					    test_age_gfn_range);
+}
+
+/*
+ * Remove write access from all last-level SPTEs at or above @min_level that
+ * map gfns in the memslot, for dirty logging.  Returns true if a TLB flush
+ * is needed.
+ */
+static bool kvm_tdp_mmu_wrprot_slot(struct kvm *kvm,
+				    struct kvm_memory_slot *slot,
+				    int min_level)
+{
+	struct kvm_mmu_page *root;
+	struct tdp_iter iter;
+	bool spte_set = false;
+
+restart:
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		if (root->role.smm != slot->as_id)
+			continue;
+
+		/* Hold a reference in case the walk yields mmu_lock. */
+		get_tdp_mmu_root(kvm, root);
+
+		for_each_tdp_pte_min_level(iter, root, min_level,
+				slot->base_gfn,
+				slot->base_gfn + slot->npages) {
+			if (tdp_mmu_iter_cond_resched(kvm, &iter, false))
+				continue;
+
+			if (!is_shadow_present_pte(iter.old_spte) ||
+			    !is_last_spte(iter.old_spte, iter.level))
+				continue;
+
+			spte_set |= spte_write_protect(iter.sptep, false);
+		}
+
+		if (put_tdp_mmu_root(kvm, root))
+			goto restart;
+	}
+
+	return spte_set;
+}
+
+/*
+ * Clear the dirty status of all the last-level SPTEs mapping the memslot:
+ * the D bit on A/D-enabled SPTEs, the W bit otherwise.  Returns true if a
+ * TLB flush is needed.
+ */
+static bool kvm_tdp_mmu_clear_dirty_slot(struct kvm *kvm,
+					 struct kvm_memory_slot *slot)
+{
+	struct kvm_mmu_page *root;
+	struct tdp_iter iter;
+	bool spte_set = false;
+
+restart:
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		if (root->role.smm != slot->as_id)
+			continue;
+
+		get_tdp_mmu_root(kvm, root);
+
+		tdp_root_for_each_pte(iter, root, slot->base_gfn,
+				slot->base_gfn + slot->npages) {
+			if (tdp_mmu_iter_cond_resched(kvm, &iter, false))
+				continue;
+
+			if (!is_shadow_present_pte(iter.old_spte) ||
+			    !is_last_spte(iter.old_spte, iter.level))
+				continue;
+
+			if (spte_ad_need_write_protect(iter.old_spte))
+				spte_set |=
+					spte_wrprot_for_clear_dirty(iter.sptep);
+			else
+				spte_set |= spte_clear_dirty(iter.sptep);
+		}
+
+		if (put_tdp_mmu_root(kvm, root))
+			goto restart;
+	}
+
+	return spte_set;
+}
+
+/*
+ * Set the dirty status (the D bit) of all the A/D-enabled last-level SPTEs
+ * mapping the memslot, when dirty logging is disabled.  Returns true if a
+ * TLB flush is needed.
+ */
+static bool kvm_tdp_mmu_slot_set_dirty(struct kvm *kvm,
+				       struct kvm_memory_slot *slot)
+{
+	struct kvm_mmu_page *root;
+	struct tdp_iter iter;
+	bool spte_set = false;
+
+restart:
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		if (root->role.smm != slot->as_id)
+			continue;
+
+		get_tdp_mmu_root(kvm, root);
+
+		tdp_root_for_each_pte(iter, root, slot->base_gfn,
+				slot->base_gfn + slot->npages) {
+			if (tdp_mmu_iter_cond_resched(kvm, &iter, false))
+				continue;
+
+			if (!is_shadow_present_pte(iter.old_spte) ||
+			    !is_last_spte(iter.old_spte, iter.level))
+				continue;
+
+			if (spte_ad_enabled(iter.old_spte))
+				spte_set |= spte_set_dirty(iter.sptep);
+		}
+
+		if (put_tdp_mmu_root(kvm, root))
+			goto restart;
+	}
+
+	return spte_set;
+}
+
+/*
+ * Clear the dirty status of the 4K SPTEs selected by @mask starting at
+ * @gfn_offset within the memslot, or write protect them if @wrprot is set
+ * (or A/D bits cannot be relied on).  Called for dirty log clearing with a
+ * small, bounded mask, so the walk does not yield.
+ */
+static void kvm_tdp_mmu_clear_dirty_pt_masked(struct kvm *kvm,
+					      struct kvm_memory_slot *slot,
+					      gfn_t gfn_offset,
+					      unsigned long mask, bool wrprot)
+{
+	gfn_t gfn = slot->base_gfn + gfn_offset;
+	struct kvm_mmu_page *root;
+	struct tdp_iter iter;
+
+	if (!mask)
+		return;
+
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		unsigned long slot_mask = mask;
+
+		if (root->role.smm != slot->as_id)
+			continue;
+
+		tdp_root_for_each_pte(iter, root, gfn + __ffs(slot_mask),
+				gfn + BITS_PER_LONG) {
+			if (!slot_mask)
+				break;
+
+			if (iter.level > PT_PAGE_TABLE_LEVEL ||
+			    !(slot_mask & (1UL << (iter.gfn - gfn))))
+				continue;
+
+			slot_mask &= ~(1UL << (iter.gfn - gfn));
+
+			if (!is_shadow_present_pte(iter.old_spte))
+				continue;
+
+			if (wrprot ||
+			    spte_ad_need_write_protect(iter.old_spte))
+				spte_wrprot_for_clear_dirty(iter.sptep);
+			else
+				spte_clear_dirty(iter.sptep);
+		}
+	}
+}
+
+/*
+ * Zap 4K SPTEs whose backing pages have been collapsed into transparent
+ * huge pages, so that the next fault can map them hugely again after dirty
+ * logging is disabled.
+ */
+static void kvm_tdp_mmu_zap_collapsible_sptes(struct kvm *kvm,
+					      struct kvm_memory_slot *slot)
+{
+	struct kvm_mmu_page *root;
+	struct tdp_iter iter;
+	kvm_pfn_t pfn;
+	bool spte_set = false;
+
+restart:
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		if (root->role.smm != slot->as_id)
+			continue;
+
+		get_tdp_mmu_root(kvm, root);
+
+		tdp_root_for_each_pte(iter, root, slot->base_gfn,
+				slot->base_gfn + slot->npages) {
+			if (tdp_mmu_iter_cond_resched(kvm, &iter, spte_set)) {
+				spte_set = false;
+				continue;
+			}
+
+			if (!is_shadow_present_pte(iter.old_spte) ||
+			    iter.level > PT_PAGE_TABLE_LEVEL)
+				continue;
+
+			pfn = spte_to_pfn(iter.old_spte);
+			if (kvm_is_reserved_pfn(pfn) ||
+			    kvm_is_zone_device_pfn(pfn) ||
+			    !PageTransCompoundMap(pfn_to_page(pfn)))
+				continue;
+
+			tdp_mmu_zap_spte(kvm, &iter);
+			spte_set = true;
+		}
+
+		if (put_tdp_mmu_root(kvm, root))
+			goto restart;
+	}
+
+	if (spte_set)
+		kvm_flush_remote_tlbs_with_address(kvm, slot->base_gfn,
+						   slot->npages);
+}
+
+/*
+ * Write protect the gfn at all levels, e.g. for guest page table pages
+ * tracked by the page-track machinery.  Returns true if an SPTE was
+ * changed and a TLB flush is needed.
+ */
+static bool kvm_tdp_mmu_write_protect_gfn(struct kvm *kvm,
+					  struct kvm_memory_slot *slot,
+					  gfn_t gfn)
+{
+	struct kvm_mmu_page *root;
+	struct tdp_iter iter;
+	bool spte_set = false;
+
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		if (root->role.smm != slot->as_id)
+			continue;
+
+		tdp_root_for_each_pte(iter, root, gfn, gfn + 1) {
+			if (!is_shadow_present_pte(iter.old_spte) ||
+			    !is_last_spte(iter.old_spte, iter.level))
+				continue;
+
+			spte_set |= spte_write_protect(iter.sptep, true);
+		}
+	}
+
+	return spte_set;
+}
+
+/*
+ * Zap all mappings in [start, end) in every TDP MMU root.  Returns true if
+ * the caller needs to flush remote TLBs.
+ */
+static bool kvm_tdp_mmu_zap_gfn_range(struct kvm *kvm, gfn_t start, gfn_t end)
+{
+	struct kvm_mmu_page *root;
+	bool flush = false;
+
+restart:
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		get_tdp_mmu_root(kvm, root);
+
+		flush |= zap_gfn_range(kvm, root, start, end, true);
+
+		if (put_tdp_mmu_root(kvm, root))
+			goto restart;
+	}
+
+	return flush;
+}
+
+static void kvm_tdp_mmu_zap_all(struct kvm *kvm)
+{
+	if (kvm_tdp_mmu_zap_gfn_range(kvm, 0, tdp_mmu_max_gfn()))
+		kvm_flush_remote_tlbs(kvm);
+}
+
+/*
+ * Zap the subtree rooted at the NX-huge-page-disallowed page table page by
+ * zapping the parent SPTE that points to it, so that the range can be
+ * mapped with a huge page again.  Used by the NX recovery worker.
+ */
+static void kvm_tdp_mmu_zap_sp(struct kvm *kvm, struct kvm_mmu_page *sp)
+{
+	gfn_t end = sp->gfn + KVM_PAGES_PER_HPAGE(sp->role.level + 1);
+	struct kvm_mmu_page *root;
+	bool flush = false;
+
+	list_for_each_entry(root, &kvm->arch.tdp_mmu_roots, link) {
+		if (root->role.smm != sp->role.smm)
+			continue;
+
+		flush |= zap_gfn_range(kvm, root, sp->gfn, end, false);
+	}
+
+	if (flush)
+		kvm_flush_remote_tlbs_with_address(kvm, sp->gfn,
+						   end - sp->gfn);
+}
+
+static void kvm_mmu_init_tdp_mmu(struct kvm *kvm)
+{
+	/*
+	 * 64-bit only: 32-bit hosts route the root through pae_root, which
+	 * the TDP MMU does not implement.
+	 */
+	kvm->arch.tdp_mmu_enabled = IS_ENABLED(CONFIG_X86_64) && tdp_enabled &&
+				    READ_ONCE(tdp_mmu_allowed);
+	INIT_LIST_HEAD(&kvm->arch.tdp_mmu_roots);
+}
+
+static void kvm_mmu_uninit_tdp_mmu(struct kvm *kvm)
+{
+	WARN_ON(!list_empty(&kvm->arch.tdp_mmu_roots));
+}
+
+static void kvm_send_hwpoison_signal(unsigned long address, struct task_struct *tsk)
+{
+	send_sig_mceerr(BUS_MCEERR_AR, (void __user *)address, PAGE_SHIFT, tsk);
+}
+
+static int kvm_handle_bad_page(struct kvm_vcpu *vcpu, gfn_t gfn, kvm_pfn_t pfn)
+{
+	/*
+	 * Do not cache the mmio info caused by writing the readonly gfn
+	 * into the spte otherwise read access on readonly gfn also can
+	 * caused mmio page fault and treat it as mmio access.
+	 */
+	if (pfn == KVM_PFN_ERR_RO_FAULT)
+		return RET_PF_EMULATE;
+
+	if (pfn == KVM_PFN_ERR_HWPOISON) {
+		kvm_send_hwpoison_signal(kvm_vcpu_gfn_to_hva(vcpu, gfn), current);
+		return RET_PF_RETRY;
+	}
+
+	return -EFAULT;
+}
+
+static void transparent_hugepage_adjust(struct kvm_vcpu *vcpu,
+					gfn_t gfn, kvm_pfn_t *pfnp,
+					int *levelp)
+{
+	kvm_pfn_t pfn = *pfnp;
+	int level = *levelp;
+
+	/*
+	 * Check if it's a transparent hugepage. If this would be an
+	 * hugetlbfs page, level wouldn't be set to
+	 * PT_PAGE_TABLE_LEVEL and there would be no adjustment done
+	 * here.
+	 */
+	if (!is_error_noslot_pfn(pfn) && !kvm_is_reserved_pfn(pfn) &&
+	    !kvm_is_zone_device_pfn(pfn) && level == PT_PAGE_TABLE_LEVEL &&
+	    PageTransCompoundMap(pfn_to_page(pfn)) &&
+	    !mmu_gfn_lpage_is_disallowed(vcpu, gfn, PT_DIRECTORY_LEVEL)) {
+		unsigned long mask;
+		/*
+		 * mmu_notifier_retry was successful and we hold the
+		 * mmu_lock here, so the pmd can't become splitting
+		 * from under us, and in turn
+		 * __split_huge_page_refcount() can't run from under
+		 * us and we can safely transfer the refcount from
+		 * PG_tail to PG_head as we switch the pfn to tail to
+		 * head.
+		 */
+		*levelp = level = PT_DIRECTORY_LEVEL;
+		mask = KVM_PAGES_PER_HPAGE(level) - 1;
+		VM_BUG_ON((gfn & mask) != (pfn & mask));
+		if (pfn & mask) {
+			kvm_release_pfn_clean(pfn);
+			pfn &= ~mask;
+			kvm_get_pfn(pfn);
+			*pfnp = pfn;
+		}
+	}
+}
+
+static bool handle_abnormal_pfn(struct kvm_vcpu *vcpu, gva_t gva, gfn_t gfn,
+				kvm_pfn_t pfn, unsigned access, int *ret_val)
+{
+	/* The pfn is invalid, report the error! */
+	if (unlikely(is_error_pfn(pfn))) {
+		*ret_val = kvm_handle_bad_page(vcpu, gfn, pfn);
+		return true;
+	}
+
+	if (unlikely(is_noslot_pfn(pfn)))
+		vcpu_cache_mmio_info(vcpu, gva, gfn,
+				     access & shadow_mmio_access_mask);
+
+	return false;
+}
+
+static bool page_fault_can_be_fast(u32 error_code)
+{
+	/*
+	 * Do not fix the mmio spte with invalid generation number which
+	 * need to be updated by slow page fault path.
+	 */
+	if (unlikely(error_code & PFERR_RSVD_MASK))
+		return false;
+
+	/* See if the page fault is due to an NX violation */
+	if (unlikely(((error_code & (PFERR_FETCH_MASK | PFERR_PRESENT_MASK))
+		      == (PFERR_FETCH_MASK | PFERR_PRESENT_MASK))))
+		return false;
+
+	/*
+	 * #PF can be fast if:
+	 * 1. The shadow page table entry is not present, which could mean that
+	 *    the fault is potentially caused by access tracking (if enabled).
+	 * 2. The shadow page table entry is present and the fault
+	 *    is caused by write-protect, that means we just need change the W
+	 *    bit of the spte which can be done out of mmu-lock.
+	 *
+	 * However, if access tracking is disabled we know that a non-present
+	 * page must be a genuine page fault where we have to create a new SPTE.
+	 * So, if access tracking is disabled, we return true only for write
+	 * accesses to a present page.
+	 */
+
+	return shadow_acc_track_mask != 0 ||
+	       ((error_code & (PFERR_WRITE_MASK | PFERR_PRESENT_MASK))
+		== (PFERR_WRITE_MASK | PFERR_PRESENT_MASK));
+}
+
+/*
+ * Returns true if the SPTE was fixed successfully. Otherwise,
+ * someone else modified the SPTE from its original value.
+ */
+static bool
+fast_pf_fix_direct_spte(struct kvm_vcpu *vcpu, struct kvm_mmu_page *sp,
+			u64 *sptep, u64 old_spte, u64 new_spte)
+{
+	gfn_t gfn;
+
+	WARN_ON(!sp->role.direct);
+
+	/*
+	 * Theoretically we could also set dirty bit (and flush TLB) here in
+	 * order to eliminate unnecessary PML logging. See comments in
+	 * set_spte. But fast_page_fault is very unlikely to happen with PML
+	 * enabled, so we do not do this. This might result in the same GPA
+	 * to be logged in PML buffer again when the write really happens, and
+	 * eventually to be called by mark_page_dirty twice. But it's also no
+	 * harm. This also avoids the TLB flush needed after setting dirty bit
+	 * so non-PML cases won't be impacted.
+	 *
+	 * Compare with set_spte where instead shadow_dirty_mask is set.
+	 */
+	if (cmpxchg64(sptep, old_spte, new_spte) != old_spte)
+		return false;
+
+	if (is_writable_pte(new_spte) && !is_writable_pte(old_spte)) {
+		/*
+		 * The gfn of direct spte is stable since it is
+		 * calculated by sp->gfn.
+		 */
+		gfn = kvm_mmu_page_get_gfn(sp, sptep - sp->spt);
+		kvm_vcpu_mark_page_dirty(vcpu, gfn);
+	}
+
+	return true;
+}
+
+static bool is_access_allowed(u32 fault_err_code, u64 spte)
+{
+	if (fault_err_code & PFERR_FETCH_MASK)
+		return is_executable_pte(spte);
+
+	if (fault_err_code & PFERR_WRITE_MASK)
+		return is_writable_pte(spte);
+
+	/* Fault was on Read access */
+	return spte & PT_PRESENT_MASK;
+}
+
+/*
+ * Return value:
+ * - true: let the vcpu to access on the same address again.
+ * - false: let the real page fault path to fix it.
+ */
+static bool fast_page_fault(struct kvm_vcpu *vcpu, gpa_t cr2_or_gpa, int level,
+			    u32 error_code)
+{
+	struct kvm_shadow_walk_iterator iterator;
+	struct kvm_mmu_page *sp;
+	bool fault_handled = false;
+	u64 spte = 0ull;
+	uint retry_count = 0;
+
+	if (!VALID_PAGE(vcpu->arch.mmu->root_hpa))
+		return false;
+
+	if (!page_fault_can_be_fast(error_code))
+		return false;
+
+	walk_shadow_page_lockless_begin(vcpu);
+
+	do {
+		u64 new_spte;
+
+		for_each_shadow_entry_lockless(vcpu, cr2_or_gpa, iterator, spte)
+			if (!is_shadow_present_pte(spte) ||
+			    iterator.level < level)
+				break;
+
+		sp = page_header(__pa(iterator.sptep));
+		if (!is_last_spte(spte, sp->role.level))
+			break;
+
+		/*
+		 * Check whether the memory access that caused the fault would
+		 * still cause it if it were to be performed right now. If not,
+		 * then this is a spurious fault caused by TLB lazily flushed,
+		 * or some other CPU has already fixed the PTE after the
+		 * current CPU took the fault.
+		 *
+		 * Need not check the access of upper level table entries since
+		 * they are always ACC_ALL.
+		 */
+		if (is_access_allowed(error_code, spte)) {
+			fault_handled = true;
+			break;
+		}
+
+		new_spte = spte;
+
+		if (is_access_track_spte(spte))
+			new_spte = restore_acc_track_spte(new_spte);
+
+		/*
+		 * Currently, to simplify the code, write-protection can
+		 * be removed in the fast path only if the SPTE was
+		 * write-protected for dirty-logging or access tracking.
+		 */
+		if ((error_code & PFERR_WRITE_MASK) &&
+		    spte_can_locklessly_be_made_writable(spte))
+		{
+			new_spte |= PT_WRITABLE_MASK;
+
+			/*
+			 * Do not fix write-permission on the large spte.  Since
+			 * we only dirty the first page into the dirty-bitmap in
+			 * fast_pf_fix_direct_spte(), other pages are missed
+			 * if its slot has dirty logging enabled.
+			 *
+			 * Instead, we let the slow page fault path create a
+			 * normal spte to fix the access.
+			 *
+			 * See the comments in kvm_arch_commit_memory_region().
+			 */
+			if (sp->role.level > PT_PAGE_TABLE_LEVEL)
+				break;
+		}
 
 		/* Verify that the fault can be handled in the fast path */
 		if (new_spte == spte ||
@@ -3706,6 +4754,13 @@ static void mmu_free_root_page(struct kvm *kvm, hpa_t *root_hpa,
 		return;
 
 	sp = page_header(*root_hpa & PT64_BASE_ADDR_MASK);
+
+	if (sp->tdp_mmu_page) {
+		put_tdp_mmu_root(kvm, sp);
+		*root_hpa = INVALID_PAGE;
+		return;
+	}
+
 	--sp->root_count;
 	if (!sp->root_count && sp->role.invalid)
 		kvm_mmu_prepare_zap_page(kvm, sp, invalid_list);
@@ -3779,7 +4834,10 @@ static int mmu_alloc_direct_roots(struct kvm_vcpu *vcpu)
 	struct kvm_mmu_page *sp;
 	unsigned i;
 
-	if (vcpu->arch.mmu->shadow_root_level >= PT64_ROOT_4LEVEL) {
+	if (vcpu->kvm->arch.tdp_mmu_enabled) {
+		sp = kvm_tdp_mmu_get_vcpu_root(vcpu);
+		vcpu->arch.mmu->root_hpa = __pa(sp->spt);
+	} else if (vcpu->arch.mmu->shadow_root_level >= PT64_ROOT_4LEVEL) {
 		spin_lock(&vcpu->kvm->mmu_lock);
 		if(make_mmu_pages_available(vcpu) < 0) {
 			spin_unlock(&vcpu->kvm->mmu_lock);
@@ -4329,8 +5387,12 @@ static int tdp_page_fault(struct kvm_vcpu *vcpu, gpa_t gpa, u32 error_code,
 		goto out_unlock;
 	if (likely(!force_pt_level))
 		transparent_hugepage_adjust(vcpu, gfn, &pfn, &level);
-	r = __direct_map(vcpu, gpa, write, map_writable, level, pfn,
-			 prefault, lpage_disallowed);
+	if (is_tdp_mmu_root(vcpu->kvm, vcpu->arch.mmu->root_hpa))
+		r = kvm_tdp_mmu_map(vcpu, gpa, write, map_writable, level,
+				    pfn, prefault, lpage_disallowed);
+	else
+		r = __direct_map(vcpu, gpa, write, map_writable, level, pfn,
+				 prefault, lpage_disallowed);
 out_unlock:
 	spin_unlock(&vcpu->kvm->mmu_lock);
 	kvm_release_pfn_clean(pfn);
@@ -5913,6 +6975,14 @@ static void kvm_mmu_zap_all_fast(struct kvm *kvm)
 	kvm_reload_remote_mmus(kvm);
 
 	kvm_zap_obsolete_pages(kvm);
+
+	/*
+	 * TDP MMU pages have no generation; zap them explicitly so that no
+	 * mapping into the invalidated slots survives this function.
+	 */
+	if (kvm->arch.tdp_mmu_enabled)
+		kvm_tdp_mmu_zap_all(kvm);
+
 	spin_unlock(&kvm->mmu_lock);
 }
 
@@ -5932,6 +7002,8 @@ void kvm_mmu_init_vm(struct kvm *kvm)
 {
 	struct kvm_page_track_notifier_node *node = &kvm->arch.mmu_sp_tracker;
 
+	kvm_mmu_init_tdp_mmu(kvm);
+
 	node->track_write = kvm_mmu_pte_write;
 	node->track_flush_slot = kvm_mmu_invalidate_zap_pages_in_memslot;
 	kvm_page_track_register_notifier(kvm, node);
@@ -5942,6 +7014,8 @@ void kvm_mmu_uninit_vm(struct kvm *kvm)
 	struct kvm_page_track_notifier_node *node = &kvm->arch.mmu_sp_tracker;
 
 	kvm_page_track_unregister_notifier(kvm, node);
+
+	kvm_mmu_uninit_tdp_mmu(kvm);
 }
 
 void kvm_zap_gfn_range(struct kvm *kvm, gfn_t gfn_start, gfn_t gfn_end)
@@ -5967,6 +7041,10 @@ void kvm_zap_gfn_range(struct kvm *kvm, gfn_t gfn_start, gfn_t gfn_end)
 		}
 	}
 
+	if (kvm->arch.tdp_mmu_enabled &&
+	    kvm_tdp_mmu_zap_gfn_range(kvm, gfn_start, gfn_end))
+		kvm_flush_remote_tlbs(kvm);
+
 	spin_unlock(&kvm->mmu_lock);
 }
 
@@ -5984,6 +7062,9 @@ void kvm_mmu_slot_remove_write_access(struct kvm *kvm,
 	spin_lock(&kvm->mmu_lock);
 	flush = slot_handle_all_level(kvm, memslot, slot_rmap_write_protect,
 				      false);
+	if (kvm->arch.tdp_mmu_enabled)
+		flush |= kvm_tdp_mmu_wrprot_slot(kvm, memslot,
+						 PT_PAGE_TABLE_LEVEL);
 	spin_unlock(&kvm->mmu_lock);
 
 	/*
@@ -6055,6 +7136,9 @@ void kvm_mmu_zap_collapsible_sptes(struct kvm *kvm,
 	spin_lock(&kvm->mmu_lock);
 	slot_handle_leaf(kvm, (struct kvm_memory_slot *)memslot,
 			 kvm_mmu_zap_collapsible_spte, true);
+	if (kvm->arch.tdp_mmu_enabled)
+		kvm_tdp_mmu_zap_collapsible_sptes(kvm,
+				(struct kvm_memory_slot *)memslot);
 	spin_unlock(&kvm->mmu_lock);
 }
 
@@ -6065,6 +7149,8 @@ void kvm_mmu_slot_leaf_clear_dirty(struct kvm *kvm,
 
 	spin_lock(&kvm->mmu_lock);
 	flush = slot_handle_leaf(kvm, memslot, __rmap_clear_dirty, false);
+	if (kvm->arch.tdp_mmu_enabled)
+		flush |= kvm_tdp_mmu_clear_dirty_slot(kvm, memslot);
 	spin_unlock(&kvm->mmu_lock);
 
 	lockdep_assert_held(&kvm->slots_lock);
@@ -6089,6 +7175,9 @@ void kvm_mmu_slot_largepage_remove_write_access(struct kvm *kvm,
 	spin_lock(&kvm->mmu_lock);
 	flush = slot_handle_large_level(kvm, memslot, slot_rmap_write_protect,
 					false);
+	if (kvm->arch.tdp_mmu_enabled)
+		flush |= kvm_tdp_mmu_wrprot_slot(kvm, memslot,
+						 PT_DIRECTORY_LEVEL);
 	spin_unlock(&kvm->mmu_lock);
 
 	/* see kvm_mmu_slot_remove_write_access */
@@ -6107,6 +7196,8 @@ void kvm_mmu_slot_set_dirty(struct kvm *kvm,
 
 	spin_lock(&kvm->mmu_lock);
 	flush = slot_handle_all_level(kvm, memslot, __rmap_set_dirty, false);
+	if (kvm->arch.tdp_mmu_enabled)
+		flush |= kvm_tdp_mmu_slot_set_dirty(kvm, memslot);
 	spin_unlock(&kvm->mmu_lock);
 
 	lockdep_assert_held(&kvm->slots_lock);
@@ -6136,6 +7227,10 @@ restart:
 	}
 
 	kvm_mmu_commit_zap_page(kvm, &invalid_list);
+
+	if (kvm->arch.tdp_mmu_enabled)
+		kvm_tdp_mmu_zap_all(kvm);
+
 	spin_unlock(&kvm->mmu_lock);
 }
 
@@ -6443,8 +7538,13 @@ static void kvm_recover_nx_lpages(struct kvm *kvm)
 				      struct kvm_mmu_page,
 				      lpage_disallowed_link);
 		WARN_ON_ONCE(!sp->lpage_disallowed);
-		kvm_mmu_prepare_zap_page(kvm, sp, &invalid_list);
-		WARN_ON_ONCE(sp->lpage_disallowed);
+		if (sp->tdp_mmu_page) {
+			/* Zapping the subtree frees sp, don't touch it. */
+			kvm_tdp_mmu_zap_sp(kvm, sp);
+		} else {
+			kvm_mmu_prepare_zap_page(kvm, sp, &invalid_list);
+			WARN_ON_ONCE(sp->lpage_disallowed);
+		}
 
 		if (!--to_zap || need_resched() || spin_needbreak(&kvm->mmu_lock)) {
 			kvm_mmu_commit_zap_page(kvm, &invalid_list);
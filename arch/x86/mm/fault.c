@@ -1401,6 +1401,17 @@ void do_user_addr_fault(struct pt_regs *regs,
 	 * 1. Failed to acquire mmap_sem, and
 	 * 2. The access did not originate in userspace.
 	 */
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	/*
+	 * Try to service the fault without taking the mmap_sem at all;
+	 * VM_FAULT_RETRY means the speculative path gave up and we must
+	 * fall through to the classic, mmap_sem protected, path.
+	 */
+	fault = handle_speculative_fault(mm, address, flags);
+	if (fault != VM_FAULT_RETRY)
+		goto done;
+#endif
+
 	if (unlikely(!down_read_trylock(&mm->mmap_sem))) {
 		if (!user_mode(regs) && !search_exception_tables(regs->ip)) {
 			/*
@@ -1487,6 +1498,9 @@ good_area:
 	}
 
 	up_read(&mm->mmap_sem);
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+done:
+#endif
 	if (unlikely(fault & VM_FAULT_ERROR)) {
 		mm_fault_error(regs, hw_error_code, address, fault);
 		return;
@@ -237,6 +237,15 @@ static void req_bio_endio(struct request *rq, struct bio *bio,
 
 	bio_advance(bio, nbytes);
 
+	/*
+	 * An emulated zone append reports the sector the data landed at
+	 * through bi_sector.  Partial completions cannot be supported as
+	 * the submitter has no way to retry the remainder at the right
+	 * position, so the request start sector is the append location.
+	 */
+	if (bio_flagged(bio, BIO_ZONE_APPEND) && !error)
+		bio->bi_iter.bi_sector = blk_rq_pos(rq);
+
 	/* don't actually finish bio if it's part of flush sequence */
 	if (bio->bi_iter.bi_size == 0 && !(rq->rq_flags & RQF_FLUSH_SEQ))
 		bio_endio(bio);
@@ -523,6 +532,9 @@ struct request_queue *blk_alloc_queue_node(gfp_t gfp_mask, int node_id)
 	mutex_init(&q->sysfs_lock);
 	mutex_init(&q->sysfs_dir_lock);
 	spin_lock_init(&q->queue_lock);
+#ifdef CONFIG_BLK_DEV_ZONED
+	spin_lock_init(&q->zone_wp_lock);
+#endif
 
 	init_waitqueue_head(&q->mq_freeze_wq);
 	mutex_init(&q->mq_freeze_lock);
@@ -943,6 +955,13 @@ generic_make_request_checks(struct bio *bio)
 		if (!blk_queue_is_zoned(q) || !blk_queue_zone_resetall(q))
 			goto not_supported;
 		break;
+	case REQ_OP_ZONE_APPEND:
+		if (!blk_queue_is_zoned(q))
+			goto not_supported;
+		status = blk_zone_append_bio(q, bio);
+		if (status != BLK_STS_OK)
+			goto end_io;
+		break;
 	case REQ_OP_WRITE_ZEROES:
 		if (!q->limits.max_write_zeroes_sectors)
 			goto not_supported;
@@ -951,6 +970,10 @@ generic_make_request_checks(struct bio *bio)
 		break;
 	}
 
+	/* Keep the write pointer cache for zone append emulation current */
+	if (blk_queue_is_zoned(q))
+		blk_zone_track_write(q, bio);
+
 	/*
 	 * Various block parts want %current->io_context and lazy ioc
 	 * allocation ends up trading a lot of pain for a small amount of
@@ -52,10 +52,14 @@ static int __blk_rq_unmap_user(struct bio *bio)
 	int ret = 0;
 
 	if (bio) {
-		if (bio_flagged(bio, BIO_USER_MAPPED))
-			bio_unmap_user(bio);
-		else
+		/*
+		 * Copied bios carry their bio_map_data in ->bi_private,
+		 * directly mapped ones do not.
+		 */
+		if (bio->bi_private)
 			ret = bio_uncopy_user(bio);
+		else
+			bio_unmap_user(bio);
 	}
 
 	return ret;
@@ -146,7 +150,7 @@ int blk_rq_map_user_iov(struct request_queue *q, struct request *rq,
 			bio = rq->bio;
 	} while (iov_iter_count(&i));
 
-	if (!bio_flagged(bio, BIO_USER_MAPPED))
+	if (copy)
 		rq->rq_flags |= RQF_COPY_USER;
 	return 0;
 
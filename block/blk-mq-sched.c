@@ -167,6 +167,29 @@ static void blk_mq_do_dispatch_ctx(struct blk_mq_hw_ctx *hctx)
 	WRITE_ONCE(hctx->dispatch_from, ctx);
 }
 
+/*
+ * Reorder a dispatch list so that higher dispatch classes go to the driver
+ * first. The sort is stable: order within a class is preserved.
+ */
+static void blk_mq_sched_sort_dispatch(struct list_head *rq_list)
+{
+	struct list_head cls[BLK_MQ_NR_DISPATCH_CLASSES];
+	struct request *rq, *next;
+	int i;
+
+	if (list_empty(rq_list) || list_is_singular(rq_list))
+		return;
+
+	for (i = 0; i < BLK_MQ_NR_DISPATCH_CLASSES; i++)
+		INIT_LIST_HEAD(&cls[i]);
+
+	list_for_each_entry_safe(rq, next, rq_list, queuelist)
+		list_move_tail(&rq->queuelist, &cls[blk_mq_rq_dispatch_class(rq)]);
+
+	for (i = 0; i < BLK_MQ_NR_DISPATCH_CLASSES; i++)
+		list_splice_tail(&cls[i], rq_list);
+}
+
 void blk_mq_sched_dispatch_requests(struct blk_mq_hw_ctx *hctx)
 {
 	struct request_queue *q = hctx->queue;
@@ -206,6 +229,7 @@ void blk_mq_sched_dispatch_requests(struct blk_mq_hw_ctx *hctx)
 	 */
 	if (!list_empty(&rq_list)) {
 		blk_mq_sched_mark_restart_hctx(hctx);
+		blk_mq_sched_sort_dispatch(&rq_list);
 		if (blk_mq_dispatch_rq_list(q, &rq_list, false)) {
 			if (has_sched_dispatch)
 				blk_mq_do_dispatch_sched(hctx);
@@ -219,6 +243,7 @@ void blk_mq_sched_dispatch_requests(struct blk_mq_hw_ctx *hctx)
 		blk_mq_do_dispatch_ctx(hctx);
 	} else {
 		blk_mq_flush_busy_ctxs(hctx, &rq_list);
+		blk_mq_sched_sort_dispatch(&rq_list);
 		blk_mq_dispatch_rq_list(q, &rq_list, false);
 	}
 }
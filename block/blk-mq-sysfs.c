@@ -187,6 +187,32 @@ static ssize_t blk_mq_hw_sysfs_cpus_show(struct blk_mq_hw_ctx *hctx, char *page)
 	return pos + ret;
 }
 
+/*
+ * Issue-to-completion latency per dispatch class. One line per class:
+ * name, sample count, average and worst latency in nanoseconds. Only
+ * collected while queue stats (QUEUE_FLAG_STATS) are enabled.
+ */
+static ssize_t blk_mq_hw_sysfs_class_lat_show(struct blk_mq_hw_ctx *hctx,
+					      char *page)
+{
+	static const char * const names[BLK_MQ_NR_DISPATCH_CLASSES] = {
+		"rt", "be", "idle"
+	};
+	ssize_t pos = 0;
+	int i;
+
+	for (i = 0; i < BLK_MQ_NR_DISPATCH_CLASSES; i++) {
+		struct blk_mq_class_stat *stat = &hctx->class_lat[i];
+		unsigned long nr = stat->nr_samples;
+
+		pos += sprintf(page + pos, "%s %lu %llu %llu\n", names[i], nr,
+			       nr ? div_u64(stat->total_ns, nr) : 0,
+			       stat->max_ns);
+	}
+
+	return pos;
+}
+
 static struct blk_mq_hw_ctx_sysfs_entry blk_mq_hw_sysfs_nr_tags = {
 	.attr = {.name = "nr_tags", .mode = 0444 },
 	.show = blk_mq_hw_sysfs_nr_tags_show,
@@ -199,11 +225,16 @@ static struct blk_mq_hw_ctx_sysfs_entry blk_mq_hw_sysfs_cpus = {
 	.attr = {.name = "cpu_list", .mode = 0444 },
 	.show = blk_mq_hw_sysfs_cpus_show,
 };
+static struct blk_mq_hw_ctx_sysfs_entry blk_mq_hw_sysfs_class_lat = {
+	.attr = {.name = "class_lat_ns", .mode = 0444 },
+	.show = blk_mq_hw_sysfs_class_lat_show,
+};
 
 static struct attribute *default_hw_ctx_attrs[] = {
 	&blk_mq_hw_sysfs_nr_tags.attr,
 	&blk_mq_hw_sysfs_nr_reserved_tags.attr,
 	&blk_mq_hw_sysfs_cpus.attr,
+	&blk_mq_hw_sysfs_class_lat.attr,
 	NULL,
 };
 ATTRIBUTE_GROUPS(default_hw_ctx);
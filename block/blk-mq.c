@@ -370,6 +370,7 @@ static struct request *blk_mq_get_request(struct request_queue *q,
 		alloc_time_ns = ktime_get_ns();
 
 	data->q = q;
+retry:
 	if (likely(!data->ctx)) {
 		data->ctx = blk_mq_get_ctx(q);
 		clear_ctx_on_error = true;
@@ -397,6 +398,29 @@ static struct request *blk_mq_get_request(struct request_queue *q,
 	}
 
 	tag = blk_mq_get_tag(data);
+	if (tag != BLK_MQ_TAG_FAIL &&
+	    unlikely(test_bit(BLK_MQ_S_INACTIVE, &data->hctx->state))) {
+		/*
+		 * The hctx is going inactive because all its CPUs are being
+		 * offlined.  Give the tag back; new requests must not be
+		 * allocated on it while the drain is in progress.
+		 */
+		blk_mq_put_tag(data->hctx, blk_mq_tags_from_data(data),
+			       data->ctx, tag);
+		if (clear_ctx_on_error && !(data->flags & BLK_MQ_REQ_NOWAIT)) {
+			/*
+			 * Give up the CPU and sleep for a random short time to
+			 * ensure that thread using a realtime scheduling class
+			 * are migrated off the CPU, and thus off the hctx that
+			 * is going away.
+			 */
+			data->ctx = NULL;
+			data->hctx = NULL;
+			msleep(3);
+			goto retry;
+		}
+		tag = BLK_MQ_TAG_FAIL;
+	}
 	if (tag == BLK_MQ_TAG_FAIL) {
 		if (clear_ctx_on_error)
 			data->ctx = NULL;
@@ -549,6 +573,22 @@ inline void __blk_mq_end_request(struct request *rq, blk_status_t error)
 		blk_stat_add(rq, now);
 	}
 
+	/*
+	 * Per dispatch class issue-to-complete latency. Like the other hctx
+	 * counters this is updated without locking, so it is approximate
+	 * under concurrent completions.
+	 */
+	if (rq->io_start_time_ns && now > rq->io_start_time_ns) {
+		struct blk_mq_class_stat *stat;
+		u64 lat = now - rq->io_start_time_ns;
+
+		stat = &rq->mq_hctx->class_lat[blk_mq_rq_dispatch_class(rq)];
+		stat->nr_samples++;
+		stat->total_ns += lat;
+		if (lat > stat->max_ns)
+			stat->max_ns = lat;
+	}
+
 	if (rq->internal_tag != -1)
 		blk_mq_sched_completed_request(rq, now);
 
@@ -1725,6 +1765,26 @@ static int plug_rq_cmp(void *priv, struct list_head *a, struct list_head *b)
 	return blk_rq_pos(rqa) > blk_rq_pos(rqb);
 }
 
+static void blk_mq_plug_issue_rqs(struct blk_mq_hw_ctx *hctx,
+				  struct blk_mq_ctx *ctx,
+				  struct list_head *list, bool from_schedule)
+{
+	struct request_queue *q = hctx->queue;
+
+	/*
+	 * Hand the whole batch to the driver when it can take a list, so
+	 * it only rings the doorbell once. Skip the fast path when an
+	 * elevator needs to see the requests or the queue is not ready;
+	 * anything the driver leaves behind goes the normal insert route.
+	 */
+	if (q->mq_ops->queue_rqs && !q->elevator && !from_schedule &&
+	    !blk_mq_hctx_stopped(hctx) && !blk_queue_quiesced(q))
+		q->mq_ops->queue_rqs(list);
+
+	if (!list_empty(list))
+		blk_mq_sched_insert_requests(hctx, ctx, list, from_schedule);
+}
+
 void blk_mq_flush_plug_list(struct blk_plug *plug, bool from_schedule)
 {
 	struct blk_mq_hw_ctx *this_hctx;
@@ -1754,9 +1814,9 @@ void blk_mq_flush_plug_list(struct blk_plug *plug, bool from_schedule)
 		if (rq->mq_hctx != this_hctx || rq->mq_ctx != this_ctx) {
 			if (this_hctx) {
 				trace_block_unplug(this_q, depth, !from_schedule);
-				blk_mq_sched_insert_requests(this_hctx, this_ctx,
-								&rq_list,
-								from_schedule);
+				blk_mq_plug_issue_rqs(this_hctx, this_ctx,
+							&rq_list,
+							from_schedule);
 			}
 
 			this_q = rq->q;
@@ -1775,8 +1835,8 @@ void blk_mq_flush_plug_list(struct blk_plug *plug, bool from_schedule)
 	 */
 	if (this_hctx) {
 		trace_block_unplug(this_q, depth, !from_schedule);
-		blk_mq_sched_insert_requests(this_hctx, this_ctx, &rq_list,
-						from_schedule);
+		blk_mq_plug_issue_rqs(this_hctx, this_ctx, &rq_list,
+					from_schedule);
 	}
 }
 
@@ -2231,6 +2291,86 @@ fail:
 	return -ENOMEM;
 }
 
+struct rq_iter_data {
+	struct blk_mq_hw_ctx *hctx;
+	bool has_rq;
+};
+
+static bool blk_mq_has_request(struct request *rq, void *data, bool reserved)
+{
+	struct rq_iter_data *iter_data = data;
+
+	if (rq->mq_hctx != iter_data->hctx)
+		return true;
+	iter_data->has_rq = true;
+	return false;
+}
+
+static bool blk_mq_hctx_has_requests(struct blk_mq_hw_ctx *hctx)
+{
+	struct blk_mq_tags *tags = hctx->sched_tags ?
+			hctx->sched_tags : hctx->tags;
+	struct rq_iter_data data = {
+		.hctx	= hctx,
+	};
+
+	blk_mq_all_tag_iter(tags, blk_mq_has_request, &data);
+	return data.has_rq;
+}
+
+static inline bool blk_mq_last_cpu_in_hctx(unsigned int cpu,
+		struct blk_mq_hw_ctx *hctx)
+{
+	if (cpumask_next_and(-1, hctx->cpumask, cpu_online_mask) != cpu)
+		return false;
+	if (cpumask_next_and(cpu, hctx->cpumask, cpu_online_mask) < nr_cpu_ids)
+		return false;
+	return true;
+}
+
+static int blk_mq_hctx_notify_offline(unsigned int cpu, struct hlist_node *node)
+{
+	struct blk_mq_hw_ctx *hctx = hlist_entry_safe(node,
+			struct blk_mq_hw_ctx, cpuhp_online);
+
+	if (!cpumask_test_cpu(cpu, hctx->cpumask) ||
+	    !blk_mq_last_cpu_in_hctx(cpu, hctx))
+		return 0;
+
+	/*
+	 * Prevent new request from being allocated on the current hctx.
+	 *
+	 * The smp_mb__after_atomic() Pairs with the implied barrier in
+	 * test_and_set_bit_lock in sbitmap_get().  Ensures the inactive flag is
+	 * seen in blk_mq_get_tag() before we deal with existing requests.
+	 */
+	set_bit(BLK_MQ_S_INACTIVE, &hctx->state);
+	smp_mb__after_atomic();
+
+	/*
+	 * Try to grab a reference to the queue and wait for any outstanding
+	 * requests.  If we could not grab a reference the queue has been
+	 * frozen and there are no requests.
+	 */
+	if (percpu_ref_tryget(&hctx->queue->q_usage_counter)) {
+		while (blk_mq_hctx_has_requests(hctx))
+			msleep(5);
+		percpu_ref_put(&hctx->queue->q_usage_counter);
+	}
+
+	return 0;
+}
+
+static int blk_mq_hctx_notify_online(unsigned int cpu, struct hlist_node *node)
+{
+	struct blk_mq_hw_ctx *hctx = hlist_entry_safe(node,
+			struct blk_mq_hw_ctx, cpuhp_online);
+
+	if (cpumask_test_cpu(cpu, hctx->cpumask))
+		clear_bit(BLK_MQ_S_INACTIVE, &hctx->state);
+	return 0;
+}
+
 /*
  * 'cpu' is going away. splice any existing rq_list entries from this
  * software queue to the hw queue dispatch list, and ensure that it
@@ -2267,6 +2407,9 @@ static int blk_mq_hctx_notify_dead(unsigned int cpu, struct hlist_node *node)
 
 static void blk_mq_remove_cpuhp(struct blk_mq_hw_ctx *hctx)
 {
+	if (!(hctx->flags & BLK_MQ_F_STACKING))
+		cpuhp_state_remove_instance_nocalls(CPUHP_AP_BLK_MQ_ONLINE,
+						    &hctx->cpuhp_online);
 	cpuhp_state_remove_instance_nocalls(CPUHP_BLK_MQ_DEAD,
 					    &hctx->cpuhp_dead);
 }
@@ -2326,6 +2469,9 @@ static int blk_mq_init_hctx(struct request_queue *q,
 {
 	hctx->queue_num = hctx_idx;
 
+	if (!(hctx->flags & BLK_MQ_F_STACKING))
+		cpuhp_state_add_instance_nocalls(CPUHP_AP_BLK_MQ_ONLINE,
+				&hctx->cpuhp_online);
 	cpuhp_state_add_instance_nocalls(CPUHP_BLK_MQ_DEAD, &hctx->cpuhp_dead);
 
 	hctx->tags = set->tags[hctx_idx];
@@ -3379,6 +3525,7 @@ static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
 				       struct blk_mq_hw_ctx *hctx,
 				       struct request *rq)
 {
+	const struct blk_rq_stat *stat;
 	unsigned long ret = 0;
 	int bucket;
 
@@ -3391,9 +3538,7 @@ static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
 
 	/*
 	 * As an optimistic guess, use half of the mean service time
-	 * for this type of request. We can (and should) make this smarter.
-	 * For instance, if the completion latencies are tight, we can
-	 * get closer than just half the mean. This is especially
+	 * for this type of request as the baseline. This is especially
 	 * important on devices where the completion latencies are longer
 	 * than ~10 usec. We do use the stats for the relevant IO size
 	 * if available which does lead to better estimates.
@@ -3402,8 +3547,22 @@ static unsigned long blk_mq_poll_nsecs(struct request_queue *q,
 	if (bucket < 0)
 		return ret;
 
-	if (q->poll_stat[bucket].nr_samples)
-		ret = (q->poll_stat[bucket].mean + 1) / 2;
+	stat = &q->poll_stat[bucket];
+	if (stat->nr_samples) {
+		ret = (stat->mean + 1) / 2;
+
+		/*
+		 * If the completion latencies in the last window were tight,
+		 * we can get closer than just half the mean: sleep up to
+		 * three quarters of the fastest completion seen for this
+		 * size. Nothing in the window completed faster than min, so
+		 * we still expect to wake up with time left to poll, while
+		 * on devices with stable latencies this roughly halves the
+		 * cycles burned spinning.
+		 */
+		if (stat->min - (stat->min >> 2) > ret)
+			ret = stat->min - (stat->min >> 2);
+	}
 
 	return ret;
 }
@@ -3563,6 +3722,9 @@ static int __init blk_mq_init(void)
 {
 	cpuhp_setup_state_multi(CPUHP_BLK_MQ_DEAD, "block/mq:dead", NULL,
 				blk_mq_hctx_notify_dead);
+	cpuhp_setup_state_multi(CPUHP_AP_BLK_MQ_ONLINE, "block/mq:online",
+				blk_mq_hctx_notify_online,
+				blk_mq_hctx_notify_offline);
 	return 0;
 }
 subsys_initcall(blk_mq_init);
@@ -2,6 +2,8 @@
 #ifndef INT_BLK_MQ_H
 #define INT_BLK_MQ_H
 
+#include <linux/ioprio.h>
+
 #include "blk-stat.h"
 #include "blk-mq-tag.h"
 
@@ -180,6 +182,19 @@ static inline bool blk_mq_hctx_stopped(struct blk_mq_hw_ctx *hctx)
 	return test_bit(BLK_MQ_S_STOPPED, &hctx->state);
 }
 
+/* Map a request's I/O priority class to its dispatch class */
+static inline unsigned int blk_mq_rq_dispatch_class(struct request *rq)
+{
+	switch (IOPRIO_PRIO_CLASS(req_get_ioprio(rq))) {
+	case IOPRIO_CLASS_RT:
+		return BLK_MQ_DISPATCH_RT;
+	case IOPRIO_CLASS_IDLE:
+		return BLK_MQ_DISPATCH_IDLE;
+	default:
+		return BLK_MQ_DISPATCH_BE;
+	}
+}
+
 static inline bool blk_mq_hw_queue_mapped(struct blk_mq_hw_ctx *hctx)
 {
 	return hctx->nr_ctx && hctx->tags;
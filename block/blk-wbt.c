@@ -21,6 +21,7 @@
  */
 #include <linux/kernel.h>
 #include <linux/blk_types.h>
+#include <linux/blk-cgroup.h>
 #include <linux/slab.h>
 #include <linux/backing-dev.h>
 #include <linux/swap.h>
@@ -108,6 +109,8 @@ static inline struct rq_wait *get_rq_wait(struct rq_wb *rwb,
 		return &rwb->rq_wait[WBT_RWQ_KSWAPD];
 	else if (wb_acct & WBT_DISCARD)
 		return &rwb->rq_wait[WBT_RWQ_DISCARD];
+	else if (wb_acct & WBT_CGROUP)
+		return &rwb->rq_wait[WBT_RWQ_CGROUP];
 
 	return &rwb->rq_wait[WBT_RWQ_BG];
 }
@@ -141,11 +144,11 @@ static void wbt_rqw_done(struct rq_wb *rwb, struct rq_wait *rqw,
 	}
 
 	/*
-	 * For discards, our limit is always the background. For writes, if
-	 * the device does write back caching, drop further down before we
-	 * wake people up.
+	 * For discards and cgroup limited writes, our limit is always the
+	 * background. For writes, if the device does write back caching,
+	 * drop further down before we wake people up.
 	 */
-	if (wb_acct & WBT_DISCARD)
+	if (wb_acct & (WBT_DISCARD | WBT_CGROUP))
 		limit = rwb->wb_background;
 	else if (rwb->wc && !wb_recent_wait(rwb))
 		limit = 0;
@@ -491,16 +494,53 @@ static inline unsigned int get_limit(struct rq_wb *rwb, unsigned long rw)
 	return limit;
 }
 
+/*
+ * Writeback throttling latency target of the cgroup the bio is charged
+ * to, in nsecs.  0 means the cgroup uses the per-device default.
+ */
+static u64 wbt_bio_cgroup_lat(struct bio *bio)
+{
+#ifdef CONFIG_BLK_CGROUP
+	if (bio->bi_blkg)
+		return (u64)READ_ONCE(bio->bi_blkg->blkcg->wbt_lat_usec) *
+			NSEC_PER_USEC;
+#endif
+	return 0;
+}
+
+/*
+ * Scale the queue depth available to a latency limited cgroup by the
+ * ratio of the device target to the cgroup target: cgroups that declared
+ * they tolerate more latency get proportionally fewer slots, so they are
+ * squeezed before I/O with the device target notices anything.
+ */
+static unsigned int wbt_cgroup_depth(struct rq_wb *rwb, unsigned int limit,
+				     u64 cg_lat_nsec)
+{
+	u64 depth;
+
+	if (!cg_lat_nsec || !rwb->min_lat_nsec)
+		return limit;
+
+	depth = div64_u64((u64)limit * rwb->min_lat_nsec, cg_lat_nsec);
+	return clamp_t(u64, depth, 1, limit);
+}
+
 struct wbt_wait_data {
 	struct rq_wb *rwb;
 	enum wbt_flags wb_acct;
 	unsigned long rw;
+	u64 cg_lat_nsec;
 };
 
 static bool wbt_inflight_cb(struct rq_wait *rqw, void *private_data)
 {
 	struct wbt_wait_data *data = private_data;
-	return rq_wait_inc_below(rqw, get_limit(data->rwb, data->rw));
+	unsigned int limit = get_limit(data->rwb, data->rw);
+
+	if (data->wb_acct & WBT_CGROUP)
+		limit = wbt_cgroup_depth(data->rwb, limit, data->cg_lat_nsec);
+	return rq_wait_inc_below(rqw, limit);
 }
 
 static void wbt_cleanup_cb(struct rq_wait *rqw, void *private_data)
@@ -514,13 +554,14 @@ static void wbt_cleanup_cb(struct rq_wait *rqw, void *private_data)
  * the timer to kick off queuing again.
  */
 static void __wbt_wait(struct rq_wb *rwb, enum wbt_flags wb_acct,
-		       unsigned long rw)
+		       struct bio *bio)
 {
 	struct rq_wait *rqw = get_rq_wait(rwb, wb_acct);
 	struct wbt_wait_data data = {
 		.rwb = rwb,
 		.wb_acct = wb_acct,
-		.rw = rw,
+		.rw = bio->bi_opf,
+		.cg_lat_nsec = wbt_bio_cgroup_lat(bio),
 	};
 
 	rq_qos_wait(rqw, &data, wbt_inflight_cb, wbt_cleanup_cb);
@@ -558,6 +599,8 @@ static enum wbt_flags bio_to_wbt_flags(struct rq_wb *rwb, struct bio *bio)
 			flags |= WBT_KSWAPD;
 		if (bio_op(bio) == REQ_OP_DISCARD)
 			flags |= WBT_DISCARD;
+		else if (wbt_bio_cgroup_lat(bio) > rwb->min_lat_nsec)
+			flags |= WBT_CGROUP;
 		flags |= WBT_TRACKED;
 	}
 	return flags;
@@ -588,7 +631,7 @@ static void wbt_wait(struct rq_qos *rqos, struct bio *bio)
 		return;
 	}
 
-	__wbt_wait(rwb, flags, bio->bi_opf);
+	__wbt_wait(rwb, flags, bio);
 
 	if (!blk_stat_is_active(rwb->cb))
 		rwb_arm_timer(rwb);
@@ -16,14 +16,16 @@ enum wbt_flags {
 	WBT_READ		= 2,	/* read */
 	WBT_KSWAPD		= 4,	/* write, from kswapd */
 	WBT_DISCARD		= 8,	/* discard */
+	WBT_CGROUP		= 16,	/* write, cgroup latency limited */
 
-	WBT_NR_BITS		= 4,	/* number of bits */
+	WBT_NR_BITS		= 5,	/* number of bits */
 };
 
 enum {
 	WBT_RWQ_BG		= 0,
 	WBT_RWQ_KSWAPD,
 	WBT_RWQ_DISCARD,
+	WBT_RWQ_CGROUP,
 	WBT_NUM_RWQ,
 };
 
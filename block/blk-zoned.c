@@ -439,6 +439,102 @@ void blk_queue_free_zone_bitmaps(struct request_queue *q)
 	q->seq_zones_bitmap = NULL;
 	kfree(q->seq_zones_wlock);
 	q->seq_zones_wlock = NULL;
+	kvfree(q->seq_zones_wp);
+	q->seq_zones_wp = NULL;
+}
+
+/**
+ * blk_zone_append_bio - emulate a zone append operation
+ * @q:		Target request queue
+ * @bio:	REQ_OP_ZONE_APPEND bio, positioned at the start of a zone
+ *
+ * Assign the bio the sector of the cached write pointer of its target zone,
+ * advance the cache, and turn the bio into a regular non-mergeable write.
+ * The assigned sector is reported back through bio->bi_iter.bi_sector when
+ * the bio completes (see req_bio_endio()).  Writes within a zone are kept
+ * ordered by the zone write lock, as for any other zoned write.
+ */
+blk_status_t blk_zone_append_bio(struct request_queue *q, struct bio *bio)
+{
+	sector_t sector = bio->bi_iter.bi_sector;
+	unsigned int zno = blk_queue_zone_no(q, sector);
+	sector_t zone_end = ((sector_t)zno + 1) * blk_queue_zone_sectors(q);
+	unsigned long flags;
+	sector_t wp;
+
+	if (!q->seq_zones_wp || !blk_queue_zone_is_seq(q, sector) ||
+	    sector != blk_zone_start(q, sector) || !bio_sectors(bio))
+		return BLK_STS_IOERR;
+
+	spin_lock_irqsave(&q->zone_wp_lock, flags);
+	wp = q->seq_zones_wp[zno];
+	if (wp == BLK_ZONE_WP_INVAL || wp + bio_sectors(bio) > zone_end) {
+		spin_unlock_irqrestore(&q->zone_wp_lock, flags);
+		return BLK_STS_IOERR;
+	}
+	q->seq_zones_wp[zno] = wp + bio_sectors(bio);
+	spin_unlock_irqrestore(&q->zone_wp_lock, flags);
+
+	bio->bi_iter.bi_sector = wp;
+	bio->bi_opf &= ~REQ_OP_MASK;
+	bio->bi_opf |= REQ_OP_WRITE | REQ_NOMERGE;
+	bio_set_flag(bio, BIO_ZONE_APPEND);
+
+	return BLK_STS_OK;
+}
+
+/**
+ * blk_zone_track_write - maintain the zone write pointer cache
+ * @q:		Target request queue
+ * @bio:	Submitted bio
+ *
+ * Called for every bio submitted to a zoned queue so that the write pointer
+ * cache used by zone append emulation follows the regular write stream and
+ * zone resets.  Failed writes leave the cache ahead of the device write
+ * pointer; the next zone revalidation resynchronizes it.
+ */
+void blk_zone_track_write(struct request_queue *q, struct bio *bio)
+{
+	sector_t sector = bio->bi_iter.bi_sector;
+	unsigned long flags;
+	unsigned int zno;
+	sector_t end;
+
+	if (!q->seq_zones_wp)
+		return;
+
+	switch (bio_op(bio)) {
+	case REQ_OP_WRITE:
+	case REQ_OP_WRITE_SAME:
+	case REQ_OP_WRITE_ZEROES:
+		if (!bio_sectors(bio) || !blk_queue_zone_is_seq(q, sector))
+			return;
+		zno = blk_queue_zone_no(q, sector);
+		end = sector + bio_sectors(bio);
+		spin_lock_irqsave(&q->zone_wp_lock, flags);
+		if (q->seq_zones_wp[zno] != BLK_ZONE_WP_INVAL &&
+		    end > q->seq_zones_wp[zno])
+			q->seq_zones_wp[zno] = end;
+		spin_unlock_irqrestore(&q->zone_wp_lock, flags);
+		break;
+	case REQ_OP_ZONE_RESET:
+		zno = blk_queue_zone_no(q, sector);
+		spin_lock_irqsave(&q->zone_wp_lock, flags);
+		q->seq_zones_wp[zno] = blk_zone_start(q, sector);
+		spin_unlock_irqrestore(&q->zone_wp_lock, flags);
+		break;
+	case REQ_OP_ZONE_RESET_ALL:
+		spin_lock_irqsave(&q->zone_wp_lock, flags);
+		for (zno = 0; zno < q->nr_zones; zno++) {
+			if (q->seq_zones_wp[zno] != BLK_ZONE_WP_INVAL)
+				q->seq_zones_wp[zno] =
+					(sector_t)zno * blk_queue_zone_sectors(q);
+		}
+		spin_unlock_irqrestore(&q->zone_wp_lock, flags);
+		break;
+	default:
+		break;
+	}
 }
 
 /**
@@ -456,6 +552,7 @@ int blk_revalidate_disk_zones(struct gendisk *disk)
 	unsigned int nr_zones = __blkdev_nr_zones(q, get_capacity(disk));
 	unsigned long *seq_zones_wlock = NULL, *seq_zones_bitmap = NULL;
 	unsigned int i, rep_nr_zones = 0, z = 0, nrz;
+	sector_t *seq_zones_wp = NULL;
 	struct blk_zone *zones = NULL;
 	unsigned int noio_flag;
 	sector_t sector = 0;
@@ -489,6 +586,9 @@ int blk_revalidate_disk_zones(struct gendisk *disk)
 	seq_zones_bitmap = blk_alloc_zone_bitmap(q->node, nr_zones);
 	if (!seq_zones_bitmap)
 		goto out;
+	seq_zones_wp = kvcalloc(nr_zones, sizeof(sector_t), GFP_KERNEL);
+	if (!seq_zones_wp)
+		goto out;
 
 	/* Get zone information and initialize seq_zones_bitmap */
 	rep_nr_zones = nr_zones;
@@ -506,6 +606,30 @@ int blk_revalidate_disk_zones(struct gendisk *disk)
 		for (i = 0; i < nrz; i++) {
 			if (zones[i].type != BLK_ZONE_TYPE_CONVENTIONAL)
 				set_bit(z, seq_zones_bitmap);
+
+			/*
+			 * Seed the write pointer cache used for zone append
+			 * emulation.  Zones we cannot write to get an
+			 * invalid write pointer.
+			 */
+			switch (zones[i].cond) {
+			case BLK_ZONE_COND_EMPTY:
+				seq_zones_wp[z] = zones[i].start;
+				break;
+			case BLK_ZONE_COND_FULL:
+				seq_zones_wp[z] = zones[i].start + zones[i].len;
+				break;
+			case BLK_ZONE_COND_READONLY:
+			case BLK_ZONE_COND_OFFLINE:
+				seq_zones_wp[z] = BLK_ZONE_WP_INVAL;
+				break;
+			default:
+				if (zones[i].type == BLK_ZONE_TYPE_CONVENTIONAL)
+					seq_zones_wp[z] = BLK_ZONE_WP_INVAL;
+				else
+					seq_zones_wp[z] = zones[i].wp;
+				break;
+			}
 			z++;
 		}
 		sector += nrz * blk_queue_zone_sectors(q);
@@ -526,6 +650,7 @@ update:
 	q->nr_zones = nr_zones;
 	swap(q->seq_zones_wlock, seq_zones_wlock);
 	swap(q->seq_zones_bitmap, seq_zones_bitmap);
+	swap(q->seq_zones_wp, seq_zones_wp);
 	blk_mq_unfreeze_queue(q);
 
 out:
@@ -534,6 +659,7 @@ out:
 	kvfree(zones);
 	kfree(seq_zones_wlock);
 	kfree(seq_zones_bitmap);
+	kvfree(seq_zones_wp);
 
 	if (ret) {
 		pr_warn("%s: failed to revalidate zones\n", disk->disk_name);
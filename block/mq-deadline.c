@@ -15,6 +15,7 @@
 #include <linux/slab.h>
 #include <linux/init.h>
 #include <linux/compiler.h>
+#include <linux/ioprio.h>
 #include <linux/rbtree.h>
 #include <linux/sbitmap.h>
 
@@ -32,12 +33,40 @@ static const int write_expire = 5 * HZ; /* ditto for writes, these limits are SO
 static const int writes_starved = 2;    /* max times reads can starve a write */
 static const int fifo_batch = 16;       /* # of sequential requests treated as one
 				     by the above parameters. For throughput. */
+static const int aging_expire = 10 * HZ; /* max extra time a lower priority class
+				     waits behind higher classes once its own
+				     deadline has passed. */
 
-struct deadline_data {
-	/*
-	 * run time data
-	 */
+/*
+ * Writes targeting a zoned device are kept on per-zone FIFO buckets instead
+ * of fifo_list[WRITE] so that dispatch does not have to scan past writes
+ * queued for zones that are write locked. Zones hash onto the buckets by
+ * zone number, so each bucket stays FIFO ordered per zone.
+ */
+#define DD_ZONE_FIFO_BUCKETS	64
+
+/*
+ * I/O is dispatched in priority class order: RT first, then BE (which also
+ * serves IOPRIO_CLASS_NONE), IDLE only when the other classes are empty.
+ * The aging_expire escape hatch keeps the lower classes from starving.
+ */
+enum dd_prio {
+	DD_RT_PRIO	= 0,
+	DD_BE_PRIO	= 1,
+	DD_IDLE_PRIO	= 2,
+	DD_PRIO_MAX	= 2,
+};
+
+#define DD_PRIO_COUNT	3
 
+static const enum dd_prio ioprio_class_to_prio[] = {
+	[IOPRIO_CLASS_NONE]	= DD_BE_PRIO,
+	[IOPRIO_CLASS_RT]	= DD_RT_PRIO,
+	[IOPRIO_CLASS_BE]	= DD_BE_PRIO,
+	[IOPRIO_CLASS_IDLE]	= DD_IDLE_PRIO,
+};
+
+struct dd_per_prio {
 	/*
 	 * requests (deadline_rq s) are present on both sort_list and fifo_list
 	 */
@@ -48,6 +77,25 @@ struct deadline_data {
 	 * next in sort order. read, write or both are NULL
 	 */
 	struct request *next_rq[2];
+
+	/* statistics, exported read-only through sysfs */
+	unsigned int starved;	/* times only the aging escape made progress */
+	unsigned int lat_ms;	/* EWMA of time from insert to dispatch */
+};
+
+struct deadline_data {
+	/*
+	 * run time data
+	 */
+	struct dd_per_prio per_prio[DD_PRIO_COUNT];
+
+	/*
+	 * writes to a zoned device, hashed by target zone. Such requests are
+	 * on sort_list and a zone bucket, but never on a fifo_list[WRITE].
+	 */
+	struct list_head zone_fifo[DD_ZONE_FIFO_BUCKETS];
+	unsigned int nr_zone_writes;
+
 	unsigned int batching;		/* number of sequential requests made */
 	unsigned int starved;		/* times reads have starved writes */
 
@@ -58,16 +106,43 @@ struct deadline_data {
 	int fifo_batch;
 	int writes_starved;
 	int front_merges;
+	int aging_expire;
 
 	spinlock_t lock;
 	spinlock_t zone_lock;
 	struct list_head dispatch;
 };
 
+static inline bool dd_rq_is_zoned_write(struct request *rq)
+{
+	return rq_data_dir(rq) == WRITE && blk_queue_is_zoned(rq->q);
+}
+
+/*
+ * Zoned writes are kept in a single pool (the BE class) whatever their io
+ * priority says, so that the per-zone dispatch order is never violated.
+ */
+static enum dd_prio dd_rq_prio(struct request *rq)
+{
+	const unsigned int class = IOPRIO_PRIO_CLASS(req_get_ioprio(rq));
+
+	if (dd_rq_is_zoned_write(rq))
+		return DD_BE_PRIO;
+	if (class >= ARRAY_SIZE(ioprio_class_to_prio))
+		return DD_BE_PRIO;
+	return ioprio_class_to_prio[class];
+}
+
+static inline struct dd_per_prio *dd_rq_per_prio(struct deadline_data *dd,
+						 struct request *rq)
+{
+	return &dd->per_prio[dd_rq_prio(rq)];
+}
+
 static inline struct rb_root *
 deadline_rb_root(struct deadline_data *dd, struct request *rq)
 {
-	return &dd->sort_list[rq_data_dir(rq)];
+	return &dd_rq_per_prio(dd, rq)->sort_list[rq_data_dir(rq)];
 }
 
 /*
@@ -84,6 +159,16 @@ deadline_latter_request(struct request *rq)
 	return NULL;
 }
 
+static inline struct list_head *dd_zone_fifo(struct deadline_data *dd,
+					     struct request *rq)
+{
+#ifdef CONFIG_BLK_DEV_ZONED
+	return &dd->zone_fifo[blk_rq_zone_no(rq) % DD_ZONE_FIFO_BUCKETS];
+#else
+	return &dd->per_prio[DD_BE_PRIO].fifo_list[WRITE];
+#endif
+}
+
 static void
 deadline_add_rq_rb(struct deadline_data *dd, struct request *rq)
 {
@@ -95,10 +180,11 @@ deadline_add_rq_rb(struct deadline_data *dd, struct request *rq)
 static inline void
 deadline_del_rq_rb(struct deadline_data *dd, struct request *rq)
 {
+	struct dd_per_prio *per_prio = dd_rq_per_prio(dd, rq);
 	const int data_dir = rq_data_dir(rq);
 
-	if (dd->next_rq[data_dir] == rq)
-		dd->next_rq[data_dir] = deadline_latter_request(rq);
+	if (per_prio->next_rq[data_dir] == rq)
+		per_prio->next_rq[data_dir] = deadline_latter_request(rq);
 
 	elv_rb_del(deadline_rb_root(dd, rq), rq);
 }
@@ -110,6 +196,9 @@ static void deadline_remove_request(struct request_queue *q, struct request *rq)
 {
 	struct deadline_data *dd = q->elevator->elevator_data;
 
+	if (dd_rq_is_zoned_write(rq) && !list_empty(&rq->queuelist))
+		dd->nr_zone_writes--;
+
 	list_del_init(&rq->queuelist);
 
 	/*
@@ -142,9 +231,12 @@ static void dd_merged_requests(struct request_queue *q, struct request *req,
 {
 	/*
 	 * if next expires before rq, assign its expire time to rq
-	 * and move into next position (next will be deleted) in fifo
+	 * and move into next position (next will be deleted) in fifo.
+	 * Only do this for requests of the same priority class; moving a
+	 * request onto another class's fifo would corrupt both lists.
 	 */
-	if (!list_empty(&req->queuelist) && !list_empty(&next->queuelist)) {
+	if (!list_empty(&req->queuelist) && !list_empty(&next->queuelist) &&
+	    dd_rq_prio(req) == dd_rq_prio(next)) {
 		if (time_before((unsigned long)next->fifo_time,
 				(unsigned long)req->fifo_time)) {
 			list_move(&req->queuelist, &next->queuelist);
@@ -162,13 +254,14 @@ static void dd_merged_requests(struct request_queue *q, struct request *req,
  * move an entry to dispatch queue
  */
 static void
-deadline_move_request(struct deadline_data *dd, struct request *rq)
+deadline_move_request(struct deadline_data *dd, struct dd_per_prio *per_prio,
+		      struct request *rq)
 {
 	const int data_dir = rq_data_dir(rq);
 
-	dd->next_rq[READ] = NULL;
-	dd->next_rq[WRITE] = NULL;
-	dd->next_rq[data_dir] = deadline_latter_request(rq);
+	per_prio->next_rq[READ] = NULL;
+	per_prio->next_rq[WRITE] = NULL;
+	per_prio->next_rq[data_dir] = deadline_latter_request(rq);
 
 	/*
 	 * take it off the sort and fifo list
@@ -178,17 +271,39 @@ deadline_move_request(struct deadline_data *dd, struct request *rq)
 
 /*
  * deadline_check_fifo returns 0 if there are no expired requests on the fifo,
- * 1 otherwise. Requires !list_empty(&dd->fifo_list[data_dir])
+ * 1 otherwise. Requires the dd->lock
  */
-static inline int deadline_check_fifo(struct deadline_data *dd, int ddir)
+static inline int deadline_check_fifo(struct deadline_data *dd,
+				      struct dd_per_prio *per_prio, int ddir)
 {
-	struct request *rq = rq_entry_fifo(dd->fifo_list[ddir].next);
+	struct request *rq;
+	unsigned int i;
+
+	if (!list_empty(&per_prio->fifo_list[ddir])) {
+		rq = rq_entry_fifo(per_prio->fifo_list[ddir].next);
+
+		/*
+		 * rq is expired!
+		 */
+		if (time_after_eq(jiffies, (unsigned long)rq->fifo_time))
+			return 1;
+	}
+
+	if (ddir != WRITE || per_prio != &dd->per_prio[DD_BE_PRIO] ||
+	    !dd->nr_zone_writes)
+		return 0;
 
 	/*
-	 * rq is expired!
+	 * Each zone bucket is FIFO ordered, so checking the head of every
+	 * non-empty bucket is enough to detect an expired zoned write.
 	 */
-	if (time_after_eq(jiffies, (unsigned long)rq->fifo_time))
-		return 1;
+	for (i = 0; i < DD_ZONE_FIFO_BUCKETS; i++) {
+		if (list_empty(&dd->zone_fifo[i]))
+			continue;
+		rq = rq_entry_fifo(dd->zone_fifo[i].next);
+		if (time_after_eq(jiffies, (unsigned long)rq->fifo_time))
+			return 1;
+	}
 
 	return 0;
 }
@@ -198,30 +313,53 @@ static inline int deadline_check_fifo(struct deadline_data *dd, int ddir)
  * dispatch using arrival ordered lists.
  */
 static struct request *
-deadline_fifo_request(struct deadline_data *dd, int data_dir)
+deadline_fifo_request(struct deadline_data *dd, struct dd_per_prio *per_prio,
+		      int data_dir)
 {
 	struct request *rq;
 	unsigned long flags;
+	unsigned int i;
 
 	if (WARN_ON_ONCE(data_dir != READ && data_dir != WRITE))
 		return NULL;
 
-	if (list_empty(&dd->fifo_list[data_dir]))
-		return NULL;
+	/*
+	 * Zoned writes never sit on a fifo_list[WRITE], so a non-empty fifo
+	 * head is always dispatchable.
+	 */
+	if (!list_empty(&per_prio->fifo_list[data_dir]))
+		return rq_entry_fifo(per_prio->fifo_list[data_dir].next);
 
-	rq = rq_entry_fifo(dd->fifo_list[data_dir].next);
-	if (data_dir == READ || !blk_queue_is_zoned(rq->q))
-		return rq;
+	if (data_dir == READ || per_prio != &dd->per_prio[DD_BE_PRIO] ||
+	    !dd->nr_zone_writes)
+		return NULL;
 
 	/*
-	 * Look for a write request that can be dispatched, that is one with
-	 * an unlocked target zone.
+	 * Look for a zoned write that can be dispatched, that is one with an
+	 * unlocked target zone. Checking only the head of each bucket covers
+	 * the common case of one write stream per zone: if a bucket head is
+	 * write locked, the later writes of that zone cannot dispatch either.
 	 */
 	spin_lock_irqsave(&dd->zone_lock, flags);
-	list_for_each_entry(rq, &dd->fifo_list[WRITE], queuelist) {
+	for (i = 0; i < DD_ZONE_FIFO_BUCKETS; i++) {
+		if (list_empty(&dd->zone_fifo[i]))
+			continue;
+		rq = rq_entry_fifo(dd->zone_fifo[i].next);
 		if (blk_req_can_dispatch_to_zone(rq))
 			goto out;
 	}
+
+	/*
+	 * Zones hashing to the same bucket can hide an unlocked zone behind
+	 * a locked bucket head. Fall back to a full scan, matching the old
+	 * behavior of walking every queued write.
+	 */
+	for (i = 0; i < DD_ZONE_FIFO_BUCKETS; i++) {
+		list_for_each_entry(rq, &dd->zone_fifo[i], queuelist) {
+			if (blk_req_can_dispatch_to_zone(rq))
+				goto out;
+		}
+	}
 	rq = NULL;
 out:
 	spin_unlock_irqrestore(&dd->zone_lock, flags);
@@ -234,7 +372,8 @@ out:
  * dispatch using sector position sorted lists.
  */
 static struct request *
-deadline_next_request(struct deadline_data *dd, int data_dir)
+deadline_next_request(struct deadline_data *dd, struct dd_per_prio *per_prio,
+		      int data_dir)
 {
 	struct request *rq;
 	unsigned long flags;
@@ -242,7 +381,7 @@ deadline_next_request(struct deadline_data *dd, int data_dir)
 	if (WARN_ON_ONCE(data_dir != READ && data_dir != WRITE))
 		return NULL;
 
-	rq = dd->next_rq[data_dir];
+	rq = per_prio->next_rq[data_dir];
 	if (!rq)
 		return NULL;
 
@@ -264,31 +403,41 @@ deadline_next_request(struct deadline_data *dd, int data_dir)
 	return rq;
 }
 
+/*
+ * Fold the insert-to-dispatch wait of @rq into the per-class latency EWMA.
+ */
+static void dd_update_lat(struct deadline_data *dd, struct dd_per_prio *per_prio,
+			  struct request *rq)
+{
+	unsigned int wait_ms = jiffies_to_msecs(jiffies -
+		((unsigned long)rq->fifo_time -
+		 dd->fifo_expire[rq_data_dir(rq)]));
+
+	per_prio->lat_ms = per_prio->lat_ms - (per_prio->lat_ms >> 3) +
+		(wait_ms >> 3);
+}
+
 /*
  * deadline_dispatch_requests selects the best request according to
  * read/write expire, fifo_batch, etc
  */
-static struct request *__dd_dispatch_request(struct deadline_data *dd)
+static struct request *__dd_dispatch_request(struct deadline_data *dd,
+					     struct dd_per_prio *per_prio)
 {
 	struct request *rq, *next_rq;
 	bool reads, writes;
 	int data_dir;
 
-	if (!list_empty(&dd->dispatch)) {
-		rq = list_first_entry(&dd->dispatch, struct request, queuelist);
-		list_del_init(&rq->queuelist);
-		goto done;
-	}
-
-	reads = !list_empty(&dd->fifo_list[READ]);
-	writes = !list_empty(&dd->fifo_list[WRITE]);
+	reads = !list_empty(&per_prio->fifo_list[READ]);
+	writes = !list_empty(&per_prio->fifo_list[WRITE]) ||
+		(per_prio == &dd->per_prio[DD_BE_PRIO] && dd->nr_zone_writes);
 
 	/*
 	 * batches are currently reads XOR writes
 	 */
-	rq = deadline_next_request(dd, WRITE);
+	rq = deadline_next_request(dd, per_prio, WRITE);
 	if (!rq)
-		rq = deadline_next_request(dd, READ);
+		rq = deadline_next_request(dd, per_prio, READ);
 
 	if (rq && dd->batching < dd->fifo_batch)
 		/* we have a next request are still entitled to batch */
@@ -300,9 +449,9 @@ static struct request *__dd_dispatch_request(struct deadline_data *dd)
 	 */
 
 	if (reads) {
-		BUG_ON(RB_EMPTY_ROOT(&dd->sort_list[READ]));
+		BUG_ON(RB_EMPTY_ROOT(&per_prio->sort_list[READ]));
 
-		if (deadline_fifo_request(dd, WRITE) &&
+		if (deadline_fifo_request(dd, per_prio, WRITE) &&
 		    (dd->starved++ >= dd->writes_starved))
 			goto dispatch_writes;
 
@@ -317,7 +466,7 @@ static struct request *__dd_dispatch_request(struct deadline_data *dd)
 
 	if (writes) {
 dispatch_writes:
-		BUG_ON(RB_EMPTY_ROOT(&dd->sort_list[WRITE]));
+		BUG_ON(RB_EMPTY_ROOT(&per_prio->sort_list[WRITE]));
 
 		dd->starved = 0;
 
@@ -332,14 +481,14 @@ dispatch_find_request:
 	/*
 	 * we are not running a batch, find best request for selected data_dir
 	 */
-	next_rq = deadline_next_request(dd, data_dir);
-	if (deadline_check_fifo(dd, data_dir) || !next_rq) {
+	next_rq = deadline_next_request(dd, per_prio, data_dir);
+	if (deadline_check_fifo(dd, per_prio, data_dir) || !next_rq) {
 		/*
 		 * A deadline has expired, the last request was in the other
 		 * direction, or we have run out of higher-sectored requests.
 		 * Start again from the request with the earliest expiry time.
 		 */
-		rq = deadline_fifo_request(dd, data_dir);
+		rq = deadline_fifo_request(dd, per_prio, data_dir);
 	} else {
 		/*
 		 * The last req was the same dir and we have a next request in
@@ -362,16 +511,44 @@ dispatch_request:
 	 * rq is the selected appropriate request.
 	 */
 	dd->batching++;
-	deadline_move_request(dd, rq);
-done:
-	/*
-	 * If the request needs its target zone locked, do it.
-	 */
-	blk_req_zone_write_lock(rq);
-	rq->rq_flags |= RQF_STARTED;
+	dd_update_lat(dd, per_prio, rq);
+	deadline_move_request(dd, per_prio, rq);
 	return rq;
 }
 
+/*
+ * If a request of a lower priority class has been waiting for longer than
+ * aging_expire past its own deadline, dispatch it ahead of the higher
+ * classes so that RT traffic cannot starve BE and IDLE indefinitely.
+ */
+static struct request *dd_dispatch_aged_request(struct deadline_data *dd)
+{
+	enum dd_prio prio;
+	int ddir;
+
+	for (prio = DD_BE_PRIO; prio <= DD_PRIO_MAX; prio++) {
+		struct dd_per_prio *per_prio = &dd->per_prio[prio];
+
+		for (ddir = READ; ddir <= WRITE; ddir++) {
+			struct request *rq;
+
+			if (list_empty(&per_prio->fifo_list[ddir]))
+				continue;
+			rq = rq_entry_fifo(per_prio->fifo_list[ddir].next);
+			if (!time_after_eq(jiffies, (unsigned long)rq->fifo_time +
+					   dd->aging_expire))
+				continue;
+			per_prio->starved++;
+			dd->batching = 0;
+			dd_update_lat(dd, per_prio, rq);
+			deadline_move_request(dd, per_prio, rq);
+			return rq;
+		}
+	}
+
+	return NULL;
+}
+
 /*
  * One confusing aspect here is that we get called for a specific
  * hardware queue, but we may return a request that is for a
@@ -382,9 +559,33 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 {
 	struct deadline_data *dd = hctx->queue->elevator->elevator_data;
 	struct request *rq;
+	enum dd_prio prio;
 
 	spin_lock(&dd->lock);
-	rq = __dd_dispatch_request(dd);
+
+	if (!list_empty(&dd->dispatch)) {
+		rq = list_first_entry(&dd->dispatch, struct request, queuelist);
+		list_del_init(&rq->queuelist);
+		goto done;
+	}
+
+	rq = dd_dispatch_aged_request(dd);
+	if (rq)
+		goto done;
+
+	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
+		rq = __dd_dispatch_request(dd, &dd->per_prio[prio]);
+		if (rq)
+			break;
+	}
+done:
+	if (rq) {
+		/*
+		 * If the request needs its target zone locked, do it.
+		 */
+		blk_req_zone_write_lock(rq);
+		rq->rq_flags |= RQF_STARTED;
+	}
 	spin_unlock(&dd->lock);
 
 	return rq;
@@ -393,9 +594,15 @@ static struct request *dd_dispatch_request(struct blk_mq_hw_ctx *hctx)
 static void dd_exit_queue(struct elevator_queue *e)
 {
 	struct deadline_data *dd = e->elevator_data;
+	enum dd_prio prio;
+	unsigned int i;
 
-	BUG_ON(!list_empty(&dd->fifo_list[READ]));
-	BUG_ON(!list_empty(&dd->fifo_list[WRITE]));
+	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
+		BUG_ON(!list_empty(&dd->per_prio[prio].fifo_list[READ]));
+		BUG_ON(!list_empty(&dd->per_prio[prio].fifo_list[WRITE]));
+	}
+	for (i = 0; i < DD_ZONE_FIFO_BUCKETS; i++)
+		BUG_ON(!list_empty(&dd->zone_fifo[i]));
 
 	kfree(dd);
 }
@@ -407,6 +614,8 @@ static int dd_init_queue(struct request_queue *q, struct elevator_type *e)
 {
 	struct deadline_data *dd;
 	struct elevator_queue *eq;
+	enum dd_prio prio;
+	unsigned int i;
 
 	eq = elevator_alloc(q, e);
 	if (!eq)
@@ -419,15 +628,22 @@ static int dd_init_queue(struct request_queue *q, struct elevator_type *e)
 	}
 	eq->elevator_data = dd;
 
-	INIT_LIST_HEAD(&dd->fifo_list[READ]);
-	INIT_LIST_HEAD(&dd->fifo_list[WRITE]);
-	dd->sort_list[READ] = RB_ROOT;
-	dd->sort_list[WRITE] = RB_ROOT;
+	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
+		struct dd_per_prio *per_prio = &dd->per_prio[prio];
+
+		INIT_LIST_HEAD(&per_prio->fifo_list[READ]);
+		INIT_LIST_HEAD(&per_prio->fifo_list[WRITE]);
+		per_prio->sort_list[READ] = RB_ROOT;
+		per_prio->sort_list[WRITE] = RB_ROOT;
+	}
+	for (i = 0; i < DD_ZONE_FIFO_BUCKETS; i++)
+		INIT_LIST_HEAD(&dd->zone_fifo[i]);
 	dd->fifo_expire[READ] = read_expire;
 	dd->fifo_expire[WRITE] = write_expire;
 	dd->writes_starved = writes_starved;
 	dd->front_merges = 1;
 	dd->fifo_batch = fifo_batch;
+	dd->aging_expire = aging_expire;
 	spin_lock_init(&dd->lock);
 	spin_lock_init(&dd->zone_lock);
 	INIT_LIST_HEAD(&dd->dispatch);
@@ -440,13 +656,18 @@ static int dd_request_merge(struct request_queue *q, struct request **rq,
 			    struct bio *bio)
 {
 	struct deadline_data *dd = q->elevator->elevator_data;
+	const unsigned int class = IOPRIO_PRIO_CLASS(bio_prio(bio));
 	sector_t sector = bio_end_sector(bio);
+	enum dd_prio prio = DD_BE_PRIO;
 	struct request *__rq;
 
 	if (!dd->front_merges)
 		return ELEVATOR_NO_MERGE;
 
-	__rq = elv_rb_find(&dd->sort_list[bio_data_dir(bio)], sector);
+	if (class < ARRAY_SIZE(ioprio_class_to_prio))
+		prio = ioprio_class_to_prio[class];
+	__rq = elv_rb_find(&dd->per_prio[prio].sort_list[bio_data_dir(bio)],
+			   sector);
 	if (__rq) {
 		BUG_ON(sector != blk_rq_pos(__rq));
 
@@ -516,7 +737,13 @@ static void dd_insert_request(struct blk_mq_hw_ctx *hctx, struct request *rq,
 		 * set expire time and add to fifo list
 		 */
 		rq->fifo_time = jiffies + dd->fifo_expire[data_dir];
-		list_add_tail(&rq->queuelist, &dd->fifo_list[data_dir]);
+		if (dd_rq_is_zoned_write(rq)) {
+			list_add_tail(&rq->queuelist, dd_zone_fifo(dd, rq));
+			dd->nr_zone_writes++;
+		} else {
+			list_add_tail(&rq->queuelist,
+				      &dd_rq_per_prio(dd, rq)->fifo_list[data_dir]);
+		}
 	}
 }
 
@@ -567,9 +794,14 @@ static void dd_finish_request(struct request *rq)
 		struct deadline_data *dd = q->elevator->elevator_data;
 		unsigned long flags;
 
+		enum dd_prio prio;
+		bool writes = dd->nr_zone_writes;
+
 		spin_lock_irqsave(&dd->zone_lock, flags);
 		blk_req_zone_write_unlock(rq);
-		if (!list_empty(&dd->fifo_list[WRITE]))
+		for (prio = 0; prio <= DD_PRIO_MAX; prio++)
+			writes |= !list_empty(&dd->per_prio[prio].fifo_list[WRITE]);
+		if (writes)
 			blk_mq_sched_mark_restart_hctx(rq->mq_hctx);
 		spin_unlock_irqrestore(&dd->zone_lock, flags);
 	}
@@ -578,10 +810,18 @@ static void dd_finish_request(struct request *rq)
 static bool dd_has_work(struct blk_mq_hw_ctx *hctx)
 {
 	struct deadline_data *dd = hctx->queue->elevator->elevator_data;
+	enum dd_prio prio;
+
+	if (!list_empty_careful(&dd->dispatch) || READ_ONCE(dd->nr_zone_writes))
+		return true;
+
+	for (prio = 0; prio <= DD_PRIO_MAX; prio++) {
+		if (!list_empty_careful(&dd->per_prio[prio].fifo_list[0]) ||
+		    !list_empty_careful(&dd->per_prio[prio].fifo_list[1]))
+			return true;
+	}
 
-	return !list_empty_careful(&dd->dispatch) ||
-		!list_empty_careful(&dd->fifo_list[0]) ||
-		!list_empty_careful(&dd->fifo_list[1]);
+	return false;
 }
 
 /*
@@ -615,6 +855,13 @@ SHOW_FUNCTION(deadline_write_expire_show, dd->fifo_expire[WRITE], 1);
 SHOW_FUNCTION(deadline_writes_starved_show, dd->writes_starved, 0);
 SHOW_FUNCTION(deadline_front_merges_show, dd->front_merges, 0);
 SHOW_FUNCTION(deadline_fifo_batch_show, dd->fifo_batch, 0);
+SHOW_FUNCTION(deadline_aging_expire_show, dd->aging_expire, 1);
+SHOW_FUNCTION(deadline_rt_starved_show, dd->per_prio[DD_RT_PRIO].starved, 0);
+SHOW_FUNCTION(deadline_be_starved_show, dd->per_prio[DD_BE_PRIO].starved, 0);
+SHOW_FUNCTION(deadline_idle_starved_show, dd->per_prio[DD_IDLE_PRIO].starved, 0);
+SHOW_FUNCTION(deadline_rt_latency_ms_show, dd->per_prio[DD_RT_PRIO].lat_ms, 0);
+SHOW_FUNCTION(deadline_be_latency_ms_show, dd->per_prio[DD_BE_PRIO].lat_ms, 0);
+SHOW_FUNCTION(deadline_idle_latency_ms_show, dd->per_prio[DD_IDLE_PRIO].lat_ms, 0);
 #undef SHOW_FUNCTION
 
 #define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
@@ -638,10 +885,13 @@ STORE_FUNCTION(deadline_write_expire_store, &dd->fifo_expire[WRITE], 0, INT_MAX,
 STORE_FUNCTION(deadline_writes_starved_store, &dd->writes_starved, INT_MIN, INT_MAX, 0);
 STORE_FUNCTION(deadline_front_merges_store, &dd->front_merges, 0, 1, 0);
 STORE_FUNCTION(deadline_fifo_batch_store, &dd->fifo_batch, 0, INT_MAX, 0);
+STORE_FUNCTION(deadline_aging_expire_store, &dd->aging_expire, 0, INT_MAX, 1);
 #undef STORE_FUNCTION
 
 #define DD_ATTR(name) \
 	__ATTR(name, 0644, deadline_##name##_show, deadline_##name##_store)
+#define DD_ATTR_RO(name) \
+	__ATTR(name, 0444, deadline_##name##_show, NULL)
 
 static struct elv_fs_entry deadline_attrs[] = {
 	DD_ATTR(read_expire),
@@ -649,20 +899,28 @@ static struct elv_fs_entry deadline_attrs[] = {
 	DD_ATTR(writes_starved),
 	DD_ATTR(front_merges),
 	DD_ATTR(fifo_batch),
+	DD_ATTR(aging_expire),
+	DD_ATTR_RO(rt_starved),
+	DD_ATTR_RO(be_starved),
+	DD_ATTR_RO(idle_starved),
+	DD_ATTR_RO(rt_latency_ms),
+	DD_ATTR_RO(be_latency_ms),
+	DD_ATTR_RO(idle_latency_ms),
 	__ATTR_NULL
 };
 
 #ifdef CONFIG_BLK_DEBUG_FS
-#define DEADLINE_DEBUGFS_DDIR_ATTRS(ddir, name)				\
+#define DEADLINE_DEBUGFS_DDIR_ATTRS(prio, ddir, name)			\
 static void *deadline_##name##_fifo_start(struct seq_file *m,		\
 					  loff_t *pos)			\
 	__acquires(&dd->lock)						\
 {									\
 	struct request_queue *q = m->private;				\
 	struct deadline_data *dd = q->elevator->elevator_data;		\
+	struct dd_per_prio *per_prio = &dd->per_prio[prio];		\
 									\
 	spin_lock(&dd->lock);						\
-	return seq_list_start(&dd->fifo_list[ddir], *pos);		\
+	return seq_list_start(&per_prio->fifo_list[ddir], *pos);	\
 }									\
 									\
 static void *deadline_##name##_fifo_next(struct seq_file *m, void *v,	\
@@ -670,8 +928,9 @@ static void *deadline_##name##_fifo_next(struct seq_file *m, void *v,	\
 {									\
 	struct request_queue *q = m->private;				\
 	struct deadline_data *dd = q->elevator->elevator_data;		\
+	struct dd_per_prio *per_prio = &dd->per_prio[prio];		\
 									\
-	return seq_list_next(v, &dd->fifo_list[ddir], pos);		\
+	return seq_list_next(v, &per_prio->fifo_list[ddir], pos);	\
 }									\
 									\
 static void deadline_##name##_fifo_stop(struct seq_file *m, void *v)	\
@@ -695,14 +954,18 @@ static int deadline_##name##_next_rq_show(void *data,			\
 {									\
 	struct request_queue *q = data;					\
 	struct deadline_data *dd = q->elevator->elevator_data;		\
-	struct request *rq = dd->next_rq[ddir];				\
+	struct request *rq = dd->per_prio[prio].next_rq[ddir];		\
 									\
 	if (rq)								\
 		__blk_mq_debugfs_rq_show(m, rq);			\
 	return 0;							\
 }
-DEADLINE_DEBUGFS_DDIR_ATTRS(READ, read)
-DEADLINE_DEBUGFS_DDIR_ATTRS(WRITE, write)
+DEADLINE_DEBUGFS_DDIR_ATTRS(DD_RT_PRIO, READ, read0)
+DEADLINE_DEBUGFS_DDIR_ATTRS(DD_RT_PRIO, WRITE, write0)
+DEADLINE_DEBUGFS_DDIR_ATTRS(DD_BE_PRIO, READ, read1)
+DEADLINE_DEBUGFS_DDIR_ATTRS(DD_BE_PRIO, WRITE, write1)
+DEADLINE_DEBUGFS_DDIR_ATTRS(DD_IDLE_PRIO, READ, read2)
+DEADLINE_DEBUGFS_DDIR_ATTRS(DD_IDLE_PRIO, WRITE, write2)
 #undef DEADLINE_DEBUGFS_DDIR_ATTRS
 
 static int deadline_batching_show(void *data, struct seq_file *m)
@@ -761,8 +1024,12 @@ static const struct seq_operations deadline_dispatch_seq_ops = {
 	{#name "_fifo_list", 0400, .seq_ops = &deadline_##name##_fifo_seq_ops},	\
 	{#name "_next_rq", 0400, deadline_##name##_next_rq_show}
 static const struct blk_mq_debugfs_attr deadline_queue_debugfs_attrs[] = {
-	DEADLINE_QUEUE_DDIR_ATTRS(read),
-	DEADLINE_QUEUE_DDIR_ATTRS(write),
+	DEADLINE_QUEUE_DDIR_ATTRS(read0),
+	DEADLINE_QUEUE_DDIR_ATTRS(write0),
+	DEADLINE_QUEUE_DDIR_ATTRS(read1),
+	DEADLINE_QUEUE_DDIR_ATTRS(write1),
+	DEADLINE_QUEUE_DDIR_ATTRS(read2),
+	DEADLINE_QUEUE_DDIR_ATTRS(write2),
 	{"batching", 0400, deadline_batching_show},
 	{"starved", 0400, deadline_starved_show},
 	{"dispatch", 0400, .seq_ops = &deadline_dispatch_seq_ops},
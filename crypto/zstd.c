@@ -22,18 +22,23 @@ struct zstd_ctx {
 	ZSTD_DCtx *dctx;
 	void *cwksp;
 	void *dwksp;
+	ZSTD_parameters params;
 };
 
-static ZSTD_parameters zstd_params(void)
+static ZSTD_parameters zstd_params(int level, unsigned int window_log)
 {
-	return ZSTD_getParams(ZSTD_DEF_LEVEL, 0, 0);
+	ZSTD_parameters params = ZSTD_getParams(level, 0, 0);
+
+	if (window_log)
+		params.cParams.windowLog = window_log;
+
+	return params;
 }
 
 static int zstd_comp_init(struct zstd_ctx *ctx)
 {
 	int ret = 0;
-	const ZSTD_parameters params = zstd_params();
-	const size_t wksp_size = ZSTD_CCtxWorkspaceBound(params.cParams);
+	const size_t wksp_size = ZSTD_CCtxWorkspaceBound(ctx->params.cParams);
 
 	ctx->cwksp = vzalloc(wksp_size);
 	if (!ctx->cwksp) {
@@ -92,8 +97,10 @@ static void zstd_decomp_exit(struct zstd_ctx *ctx)
 
 static int __zstd_init(void *ctx)
 {
+	struct zstd_ctx *zctx = ctx;
 	int ret;
 
+	zctx->params = zstd_params(ZSTD_DEF_LEVEL, 0);
 	ret = zstd_comp_init(ctx);
 	if (ret)
 		return ret;
@@ -152,9 +159,9 @@ static int __zstd_compress(const u8 *src, unsigned int slen,
 {
 	size_t out_len;
 	struct zstd_ctx *zctx = ctx;
-	const ZSTD_parameters params = zstd_params();
 
-	out_len = ZSTD_compressCCtx(zctx->cctx, dst, *dlen, src, slen, params);
+	out_len = ZSTD_compressCCtx(zctx->cctx, dst, *dlen, src, slen,
+				    zctx->params);
 	if (ZSTD_isError(out_len))
 		return -EINVAL;
 	*dlen = out_len;
@@ -169,6 +176,53 @@ static int zstd_compress(struct crypto_tfm *tfm, const u8 *src,
 	return __zstd_compress(src, slen, dst, dlen, ctx);
 }
 
+static int __zstd_set_params(struct zstd_ctx *ctx, int level,
+			     unsigned int window_log)
+{
+	ZSTD_parameters params;
+	size_t wksp_size;
+	void *cwksp;
+	ZSTD_CCtx *cctx;
+
+	if (level < 1 || level > ZSTD_maxCLevel())
+		return -EINVAL;
+	if (window_log &&
+	    (window_log < ZSTD_WINDOWLOG_MIN ||
+	     window_log > ZSTD_WINDOWLOG_MAX))
+		return -EINVAL;
+
+	params = zstd_params(level, window_log);
+	if (ZSTD_isError(ZSTD_checkCParams(params.cParams)))
+		return -EINVAL;
+
+	/*
+	 * The compression workspace is sized for the window, so set up a new
+	 * one before tearing down the old one in case the allocation fails.
+	 */
+	wksp_size = ZSTD_CCtxWorkspaceBound(params.cParams);
+	cwksp = vzalloc(wksp_size);
+	if (!cwksp)
+		return -ENOMEM;
+
+	cctx = ZSTD_initCCtx(cwksp, wksp_size);
+	if (!cctx) {
+		vfree(cwksp);
+		return -EINVAL;
+	}
+
+	zstd_comp_exit(ctx);
+	ctx->params = params;
+	ctx->cwksp = cwksp;
+	ctx->cctx = cctx;
+	return 0;
+}
+
+static int zstd_set_params(struct crypto_scomp *tfm, int level,
+			   unsigned int window_log, void *ctx)
+{
+	return __zstd_set_params(ctx, level, window_log);
+}
+
 static int zstd_scompress(struct crypto_scomp *tfm, const u8 *src,
 			  unsigned int slen, u8 *dst, unsigned int *dlen,
 			  void *ctx)
@@ -222,6 +276,7 @@ static struct scomp_alg scomp = {
 	.free_ctx		= zstd_free_ctx,
 	.compress		= zstd_scompress,
 	.decompress		= zstd_sdecompress,
+	.set_params		= zstd_set_params,
 	.base			= {
 		.cra_name	= "zstd",
 		.cra_driver_name = "zstd-scomp",
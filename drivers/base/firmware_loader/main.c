@@ -27,6 +27,7 @@
 #include <linux/file.h>
 #include <linux/list.h>
 #include <linux/fs.h>
+#include <linux/initrd.h>
 #include <linux/async.h>
 #include <linux/pm.h>
 #include <linux/suspend.h>
@@ -469,6 +470,9 @@ fw_get_filesystem_firmware(struct device *device, struct fw_priv *fw_priv,
 	size_t msize = INT_MAX;
 	void *buffer = NULL;
 
+	/* The firmware may be in the initramfs, which may still be unpacking. */
+	wait_for_initramfs();
+
 	/* Already populated data member means we're loading into a buffer */
 	if (!decompress && fw_priv->data) {
 		buffer = fw_priv->data;
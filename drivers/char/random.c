@@ -840,18 +840,20 @@ static int credit_entropy_bits_safe(struct entropy_store *r, int nbits)
 
 static DECLARE_WAIT_QUEUE_HEAD(crng_init_wait);
 
-#ifdef CONFIG_NUMA
+#ifdef CONFIG_SMP
 /*
  * Hack to deal with crazy userspace progams when they are all trying
- * to access /dev/urandom in parallel.  The programs are almost
- * certainly doing something terribly wrong, but we'll work around
- * their brain damage.
+ * to access /dev/urandom or getrandom(2) in parallel.  Give every CPU
+ * its own CRNG instance, seeded from the primary crng: the per-cpu
+ * lock is then only ever taken by its owning CPU (modulo a rare
+ * preemption race, which is harmless) so generation never contends or
+ * bounces the state cacheline between packages.
  */
-static struct crng_state **crng_node_pool __read_mostly;
+static struct crng_state **crng_cpu_pool __read_mostly;
 #endif
 
 static void invalidate_batched_entropy(void);
-static void numa_crng_init(void);
+static void percpu_crng_init(void);
 
 static bool trust_cpu __ro_after_init = IS_ENABLED(CONFIG_RANDOM_TRUST_CPU);
 static int __init parse_trust_cpu(char *arg)
@@ -882,44 +884,45 @@ static void crng_initialize(struct crng_state *crng)
 	}
 	if (trust_cpu && arch_init && crng == &primary_crng) {
 		invalidate_batched_entropy();
-		numa_crng_init();
+		percpu_crng_init();
 		crng_init = 2;
 		pr_notice("random: crng done (trusting CPU's manufacturer)\n");
 	}
 	crng->init_time = jiffies - CRNG_RESEED_INTERVAL - 1;
 }
 
-#ifdef CONFIG_NUMA
-static void do_numa_crng_init(struct work_struct *work)
+#ifdef CONFIG_SMP
+static void do_percpu_crng_init(struct work_struct *work)
 {
-	int i;
+	int cpu;
 	struct crng_state *crng;
 	struct crng_state **pool;
 
-	pool = kcalloc(nr_node_ids, sizeof(*pool), GFP_KERNEL|__GFP_NOFAIL);
-	for_each_online_node(i) {
+	pool = kcalloc(nr_cpu_ids, sizeof(*pool), GFP_KERNEL|__GFP_NOFAIL);
+	for_each_possible_cpu(cpu) {
 		crng = kmalloc_node(sizeof(struct crng_state),
-				    GFP_KERNEL | __GFP_NOFAIL, i);
+				    GFP_KERNEL | __GFP_NOFAIL,
+				    cpu_to_node(cpu));
 		spin_lock_init(&crng->lock);
 		crng_initialize(crng);
-		pool[i] = crng;
+		pool[cpu] = crng;
 	}
 	mb();
-	if (cmpxchg(&crng_node_pool, NULL, pool)) {
-		for_each_node(i)
-			kfree(pool[i]);
+	if (cmpxchg(&crng_cpu_pool, NULL, pool)) {
+		for_each_possible_cpu(cpu)
+			kfree(pool[cpu]);
 		kfree(pool);
 	}
 }
 
-static DECLARE_WORK(numa_crng_init_work, do_numa_crng_init);
+static DECLARE_WORK(percpu_crng_init_work, do_percpu_crng_init);
 
-static void numa_crng_init(void)
+static void percpu_crng_init(void)
 {
-	schedule_work(&numa_crng_init_work);
+	schedule_work(&percpu_crng_init_work);
 }
 #else
-static void numa_crng_init(void) {}
+static void percpu_crng_init(void) {}
 #endif
 
 /*
@@ -1028,7 +1031,7 @@ static void crng_reseed(struct crng_state *crng, struct entropy_store *r)
 	spin_unlock_irqrestore(&crng->lock, flags);
 	if (crng == &primary_crng && crng_init < 2) {
 		invalidate_batched_entropy();
-		numa_crng_init();
+		percpu_crng_init();
 		crng_init = 2;
 		process_random_ready_list();
 		wake_up_interruptible(&crng_init_wait);
@@ -1070,9 +1073,9 @@ static void extract_crng(__u8 out[CHACHA_BLOCK_SIZE])
 {
 	struct crng_state *crng = NULL;
 
-#ifdef CONFIG_NUMA
-	if (crng_node_pool)
-		crng = crng_node_pool[numa_node_id()];
+#ifdef CONFIG_SMP
+	if (crng_cpu_pool)
+		crng = crng_cpu_pool[raw_smp_processor_id()];
 	if (crng == NULL)
 #endif
 		crng = &primary_crng;
@@ -1107,9 +1110,9 @@ static void crng_backtrack_protect(__u8 tmp[CHACHA_BLOCK_SIZE], int used)
 {
 	struct crng_state *crng = NULL;
 
-#ifdef CONFIG_NUMA
-	if (crng_node_pool)
-		crng = crng_node_pool[numa_node_id()];
+#ifdef CONFIG_SMP
+	if (crng_cpu_pool)
+		crng = crng_cpu_pool[raw_smp_processor_id()];
 	if (crng == NULL)
 #endif
 		crng = &primary_crng;
@@ -386,6 +386,14 @@ struct cached_dev {
 	unsigned int		writeback_rate_p_term_inverse;
 	unsigned int		writeback_rate_minimum;
 
+	/*
+	 * Moving average of backing device writeback write latency, and the
+	 * latency target beyond which the rate controller backs off. A
+	 * target of 0 disables latency based throttling.
+	 */
+	uint64_t		writeback_lat_ns;
+	unsigned int		writeback_lat_target_us;
+
 	enum stop_on_failure	stop_when_cache_set_failed;
 #define DEFAULT_CACHED_DEV_ERROR_LIMIT	64
 	atomic_t		io_errors;
@@ -569,11 +577,20 @@ struct cache_set {
 	 * high order page allocations can be rather expensive, and it's quite
 	 * common to delete and allocate btree nodes in quick succession. It
 	 * should never grow past ~2-3 nodes in practice.
+	 *
+	 * The lru is sharded by the NUMA node a btree node was allocated on,
+	 * so the shrinker and cannibalize can prefer nodes in bulk without
+	 * walking one long list, and node memory stays local to the CPUs
+	 * that faulted it in.
 	 */
-	struct list_head	btree_cache;
+#define BTREE_CACHE_SHARDS	4
+	struct list_head	btree_cache[BTREE_CACHE_SHARDS];
 	struct list_head	btree_cache_freeable;
 	struct list_head	btree_cache_freed;
 
+	/* Round robin position for the shrinker, per shard fairness */
+	unsigned int		btree_cache_scan_shard;
+
 	/* Number of elements in btree_cache + btree_cache_freeable lists */
 	unsigned int		btree_cache_used;
 
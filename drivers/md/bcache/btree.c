@@ -604,7 +604,7 @@ static void mca_data_alloc(struct btree *b, struct bkey *k, gfp_t gfp)
 					btree_order(k)),
 				  gfp)) {
 		b->c->btree_cache_used++;
-		list_move(&b->list, &b->c->btree_cache);
+		list_move(&b->list, &b->c->btree_cache[b->shard]);
 	} else {
 		list_move(&b->list, &b->c->btree_cache_freed);
 	}
@@ -617,11 +617,13 @@ static struct btree *mca_bucket_alloc(struct cache_set *c,
 	 * kzalloc() is necessary here for initialization,
 	 * see code comments in bch_btree_keys_init().
 	 */
-	struct btree *b = kzalloc(sizeof(struct btree), gfp);
+	struct btree *b = kzalloc_node(sizeof(struct btree), gfp,
+				       numa_node_id());
 
 	if (!b)
 		return NULL;
 
+	b->shard = numa_node_id() % BTREE_CACHE_SHARDS;
 	init_rwsem(&b->lock);
 	lockdep_set_novalidate_class(&b->lock);
 	mutex_init(&b->write_lock);
@@ -743,11 +745,24 @@ static unsigned long bch_mca_scan(struct shrinker *shrink,
 	}
 
 	for (;  (nr--) && i < btree_cache_used; i++) {
-		if (list_empty(&c->btree_cache))
+		struct list_head *lru = NULL;
+		unsigned int j;
+
+		/*
+		 * Pick the next non-empty shard lru round robin, so no shard
+		 * is scanned disproportionately often.
+		 */
+		for (j = 0; j < BTREE_CACHE_SHARDS; j++) {
+			lru = &c->btree_cache[c->btree_cache_scan_shard++ %
+					      BTREE_CACHE_SHARDS];
+			if (!list_empty(lru))
+				break;
+		}
+		if (j == BTREE_CACHE_SHARDS)
 			goto out;
 
-		b = list_first_entry(&c->btree_cache, struct btree, list);
-		list_rotate_left(&c->btree_cache);
+		b = list_first_entry(lru, struct btree, list);
+		list_rotate_left(lru);
 
 		if (!b->accessed &&
 		    !mca_reap(b, 0, false)) {
@@ -781,6 +796,7 @@ void bch_btree_cache_free(struct cache_set *c)
 {
 	struct btree *b;
 	struct closure cl;
+	unsigned int i;
 
 	closure_init_stack(&cl);
 
@@ -791,27 +807,32 @@ void bch_btree_cache_free(struct cache_set *c)
 
 #ifdef CONFIG_BCACHE_DEBUG
 	if (c->verify_data)
-		list_move(&c->verify_data->list, &c->btree_cache);
+		list_move(&c->verify_data->list,
+			  &c->btree_cache[c->verify_data->shard]);
 
 	free_pages((unsigned long) c->verify_ondisk, ilog2(bucket_pages(c)));
 #endif
 
 	list_splice(&c->btree_cache_freeable,
-		    &c->btree_cache);
+		    &c->btree_cache[0]);
 
-	while (!list_empty(&c->btree_cache)) {
-		b = list_first_entry(&c->btree_cache, struct btree, list);
+	for (i = 0; i < BTREE_CACHE_SHARDS; i++) {
+		while (!list_empty(&c->btree_cache[i])) {
+			b = list_first_entry(&c->btree_cache[i],
+					     struct btree, list);
 
-		/*
-		 * This function is called by cache_set_free(), no I/O
-		 * request on cache now, it is unnecessary to acquire
-		 * b->write_lock before clearing BTREE_NODE_dirty anymore.
-		 */
-		if (btree_node_dirty(b)) {
-			btree_complete_write(b, btree_current_write(b));
-			clear_bit(BTREE_NODE_dirty, &b->flags);
+			/*
+			 * This function is called by cache_set_free(), no I/O
+			 * request on cache now, it is unnecessary to acquire
+			 * b->write_lock before clearing BTREE_NODE_dirty
+			 * anymore.
+			 */
+			if (btree_node_dirty(b)) {
+				btree_complete_write(b, btree_current_write(b));
+				clear_bit(BTREE_NODE_dirty, &b->flags);
+			}
+			mca_data_free(b);
 		}
-		mca_data_free(b);
 	}
 
 	while (!list_empty(&c->btree_cache_freed)) {
@@ -833,8 +854,9 @@ int bch_btree_cache_alloc(struct cache_set *c)
 		if (!mca_bucket_alloc(c, &ZERO_KEY, GFP_KERNEL))
 			return -ENOMEM;
 
-	list_splice_init(&c->btree_cache,
-			 &c->btree_cache_freeable);
+	for (i = 0; i < BTREE_CACHE_SHARDS; i++)
+		list_splice_init(&c->btree_cache[i],
+				 &c->btree_cache_freeable);
 
 #ifdef CONFIG_BCACHE_DEBUG
 	mutex_init(&c->verify_lock);
@@ -903,19 +925,22 @@ static struct btree *mca_cannibalize(struct cache_set *c, struct btree_op *op,
 				     struct bkey *k)
 {
 	struct btree *b;
+	unsigned int i;
 
 	trace_bcache_btree_cache_cannibalize(c);
 
 	if (mca_cannibalize_lock(c, op))
 		return ERR_PTR(-EINTR);
 
-	list_for_each_entry_reverse(b, &c->btree_cache, list)
-		if (!mca_reap(b, btree_order(k), false))
-			return b;
+	for (i = 0; i < BTREE_CACHE_SHARDS; i++)
+		list_for_each_entry_reverse(b, &c->btree_cache[i], list)
+			if (!mca_reap(b, btree_order(k), false))
+				return b;
 
-	list_for_each_entry_reverse(b, &c->btree_cache, list)
-		if (!mca_reap(b, btree_order(k), true))
-			return b;
+	for (i = 0; i < BTREE_CACHE_SHARDS; i++)
+		list_for_each_entry_reverse(b, &c->btree_cache[i], list)
+			if (!mca_reap(b, btree_order(k), true))
+				return b;
 
 	WARN(1, "btree cache cannibalize failed\n");
 	return ERR_PTR(-ENOMEM);
@@ -977,7 +1002,7 @@ out:
 	BUG_ON(b->io_mutex.count != 1);
 
 	bkey_copy(&b->key, k);
-	list_move(&b->list, &c->btree_cache);
+	list_move(&b->list, &c->btree_cache[b->shard]);
 	hlist_del_init_rcu(&b->hash);
 	hlist_add_head_rcu(&b->hash, mca_hash(c, k));
 
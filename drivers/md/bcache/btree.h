@@ -133,6 +133,8 @@ struct btree {
 	unsigned long		flags;
 	uint16_t		written;	/* would be nice to kill */
 	uint8_t			level;
+	/* Which c->btree_cache[] lru this node lives on */
+	uint8_t			shard;
 
 	struct btree_keys	keys;
 
@@ -770,6 +770,14 @@ static void journal_write_unlocked(struct closure *cl)
 	if (!w->need_write) {
 		closure_return_with_destructor(cl, journal_write_unlock);
 		return;
+	} else if (w->pending) {
+		/*
+		 * Submitters are still copying keys into this entry; the
+		 * last one to finish will re-kick the write from
+		 * bch_journal().
+		 */
+		closure_return_with_destructor(cl, journal_write_unlock);
+		return;
 	} else if (journal_full(&c->journal)) {
 		journal_reclaim(c);
 		spin_unlock(&c->journal.lock);
@@ -936,6 +944,7 @@ atomic_t *bch_journal(struct cache_set *c,
 		      struct closure *parent)
 {
 	struct journal_write *w;
+	struct bkey *dst;
 	atomic_t *ret;
 
 	/* No journaling if CACHE_SET_IO_DISABLE set already */
@@ -947,14 +956,33 @@ atomic_t *bch_journal(struct cache_set *c,
 
 	w = journal_wait_for_write(c, bch_keylist_nkeys(keys));
 
-	memcpy(bset_bkey_last(w->data), keys->keys, bch_keylist_bytes(keys));
+	/*
+	 * Reserve space in the entry under the lock, but do the actual copy
+	 * outside it: concurrent submitters copy into disjoint reservations
+	 * and the next flush picks up all of them at once.
+	 */
+	dst = bset_bkey_last(w->data);
 	w->data->keys += bch_keylist_nkeys(keys);
+	w->pending++;
 
 	ret = &fifo_back(&c->journal.pin);
 	atomic_inc(ret);
 
-	if (parent) {
+	spin_unlock(&c->journal.lock);
+
+	memcpy(dst, keys->keys, bch_keylist_bytes(keys));
+
+	spin_lock(&c->journal.lock);
+	/* The entry cannot be written out while our copy was in flight */
+	BUG_ON(w != c->journal.cur);
+	w->pending--;
+
+	if (parent)
 		closure_wait(&w->wait, parent);
+
+	if (parent ||
+	    (!w->pending && w->need_write && !c->journal.io_in_flight)) {
+		/* Kick a write, or re-kick one deferred while we copied */
 		journal_try_write(c);
 	} else if (!w->dirty) {
 		w->dirty = true;
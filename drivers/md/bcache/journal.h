@@ -98,6 +98,13 @@ struct journal_write {
 	struct closure_waitlist	wait;
 	bool			dirty;
 	bool			need_write;
+
+	/*
+	 * Number of submitters that have reserved space in data and are
+	 * still copying their keys in, outside the journal lock. The entry
+	 * cannot be written while this is nonzero.
+	 */
+	unsigned int		pending;
 };
 
 /* Embedded in struct cache_set */
@@ -1627,19 +1627,20 @@ static void cache_set_flush(struct closure *cl)
 		kthread_stop(c->gc_thread);
 
 	if (!IS_ERR_OR_NULL(c->root))
-		list_add(&c->root->list, &c->btree_cache);
+		list_add(&c->root->list, &c->btree_cache[c->root->shard]);
 
 	/*
 	 * Avoid flushing cached nodes if cache set is retiring
 	 * due to too many I/O errors detected.
 	 */
 	if (!test_bit(CACHE_SET_IO_DISABLE, &c->flags))
-		list_for_each_entry(b, &c->btree_cache, list) {
-			mutex_lock(&b->write_lock);
-			if (btree_node_dirty(b))
-				__bch_btree_node_write(b, NULL);
-			mutex_unlock(&b->write_lock);
-		}
+		for (i = 0; i < BTREE_CACHE_SHARDS; i++)
+			list_for_each_entry(b, &c->btree_cache[i], list) {
+				mutex_lock(&b->write_lock);
+				if (btree_node_dirty(b))
+					__bch_btree_node_write(b, NULL);
+				mutex_unlock(&b->write_lock);
+			}
 
 	for_each_cache(ca, c, i)
 		if (ca->alloc_thread)
@@ -1759,6 +1760,7 @@ void bch_cache_set_unregister(struct cache_set *c)
 struct cache_set *bch_cache_set_alloc(struct cache_sb *sb)
 {
 	int iter_size;
+	unsigned int i;
 	struct cache_set *c = kzalloc(sizeof(struct cache_set), GFP_KERNEL);
 
 	if (!c)
@@ -1810,7 +1812,8 @@ struct cache_set *bch_cache_set_alloc(struct cache_sb *sb)
 
 	INIT_LIST_HEAD(&c->list);
 	INIT_LIST_HEAD(&c->cached_devs);
-	INIT_LIST_HEAD(&c->btree_cache);
+	for (i = 0; i < BTREE_CACHE_SHARDS; i++)
+		INIT_LIST_HEAD(&c->btree_cache[i]);
 	INIT_LIST_HEAD(&c->btree_cache_freeable);
 	INIT_LIST_HEAD(&c->btree_cache_freed);
 	INIT_LIST_HEAD(&c->data_buckets);
@@ -118,6 +118,8 @@ rw_attribute(writeback_rate_update_seconds);
 rw_attribute(writeback_rate_i_term_inverse);
 rw_attribute(writeback_rate_p_term_inverse);
 rw_attribute(writeback_rate_minimum);
+rw_attribute(writeback_lat_target_us);
+read_attribute(writeback_lat_us);
 read_attribute(writeback_rate_debug);
 
 read_attribute(stripe_size);
@@ -201,6 +203,9 @@ SHOW(__bch_cached_dev)
 	var_print(writeback_rate_i_term_inverse);
 	var_print(writeback_rate_p_term_inverse);
 	var_print(writeback_rate_minimum);
+	var_print(writeback_lat_target_us);
+	sysfs_print(writeback_lat_us,
+		    div_u64(dc->writeback_lat_ns, NSEC_PER_USEC));
 
 	if (attr == &sysfs_writeback_rate_debug) {
 		char rate[20];
@@ -329,6 +334,9 @@ STORE(__cached_dev)
 	sysfs_strtoul_clamp(writeback_rate_minimum,
 			    dc->writeback_rate_minimum,
 			    1, UINT_MAX);
+	sysfs_strtoul_clamp(writeback_lat_target_us,
+			    dc->writeback_lat_target_us,
+			    0, UINT_MAX);
 
 	sysfs_strtoul_clamp(io_error_limit, dc->error_limit, 0, INT_MAX);
 
@@ -498,6 +506,8 @@ static struct attribute *bch_cached_dev_files[] = {
 	&sysfs_writeback_rate_i_term_inverse,
 	&sysfs_writeback_rate_p_term_inverse,
 	&sysfs_writeback_rate_minimum,
+	&sysfs_writeback_lat_target_us,
+	&sysfs_writeback_lat_us,
 	&sysfs_writeback_rate_debug,
 	&sysfs_io_errors,
 	&sysfs_io_error_limit,
@@ -111,6 +111,23 @@ static void __update_writeback_rate(struct cached_dev *dc)
 	new_rate = clamp_t(int32_t, (proportional_scaled + integral_scaled),
 			dc->writeback_rate_minimum, NSEC_PER_SEC);
 
+	/*
+	 * If writeback writes are completing slower than the configured
+	 * latency target, the backing device is congested by foreground
+	 * I/O; back the rate off proportionally, no matter how far dirty
+	 * data is above target.
+	 */
+	if (dc->writeback_lat_target_us) {
+		uint64_t lat = dc->writeback_lat_ns;
+		uint64_t target_ns = (uint64_t) dc->writeback_lat_target_us *
+			NSEC_PER_USEC;
+
+		if (lat > target_ns)
+			new_rate = max_t(uint64_t,
+					 div64_u64(new_rate * target_ns, lat),
+					 dc->writeback_rate_minimum);
+	}
+
 	dc->writeback_rate_proportional = proportional_scaled;
 	dc->writeback_rate_integral_scaled = integral_scaled;
 	dc->writeback_rate_change = new_rate -
@@ -242,6 +259,7 @@ struct dirty_io {
 	struct closure		cl;
 	struct cached_dev	*dc;
 	uint16_t		sequence;
+	uint64_t		start_time;
 	struct bio		bio;
 };
 
@@ -273,6 +291,21 @@ static void write_dirty_finish(struct closure *cl)
 	struct keybuf_key *w = io->bio.bi_private;
 	struct cached_dev *dc = io->dc;
 
+	if (io->start_time) {
+		uint64_t lat = local_clock() - io->start_time;
+
+		/*
+		 * Unlocked moving average: racing completions can lose an
+		 * update, which is fine for a control loop input.
+		 */
+		if (!dc->writeback_lat_ns)
+			dc->writeback_lat_ns = lat;
+		else
+			dc->writeback_lat_ns +=
+				(lat >> WRITEBACK_LAT_EWMA_SHIFT) -
+				(dc->writeback_lat_ns >> WRITEBACK_LAT_EWMA_SHIFT);
+	}
+
 	bio_free_pages(&io->bio);
 
 	/* This is kind of a dumb way of signalling errors. */
@@ -359,6 +392,7 @@ static void write_dirty(struct closure *cl)
 		io->bio.bi_end_io	= dirty_endio;
 
 		/* I/O request sent to backing device */
+		io->start_time = local_clock();
 		closure_bio_submit(io->dc->disk.c, &io->bio, cl);
 	}
 
@@ -14,6 +14,9 @@
 #define WRITEBACK_RATE_UPDATE_SECS_MAX		60
 #define WRITEBACK_RATE_UPDATE_SECS_DEFAULT	5
 
+/* Weight of a new sample in the backing device latency moving average */
+#define WRITEBACK_LAT_EWMA_SHIFT	3
+
 #define BCH_AUTO_GC_DIRTY_THRESHOLD	50
 
 /*
@@ -17,16 +17,33 @@
 
 #define MIN_CELLS 1024
 
-struct dm_bio_prison {
+#define NR_LOCKS 64
+
+struct prison_region {
 	spinlock_t lock;
 	struct rb_root cells;
+} ____cacheline_aligned_in_smp;
+
+struct dm_bio_prison {
 	mempool_t cell_pool;
+	struct prison_region regions[NR_LOCKS];
 };
 
 static struct kmem_cache *_cell_cache;
 
 /*----------------------------------------------------------------*/
 
+/*
+ * Keys are hashed to a lock region by the BIO_PRISON_MAX_RANGE aligned
+ * region they fall in; dm_cell_key_has_valid_range() guarantees a key
+ * never straddles two regions.
+ */
+static unsigned lock_nr(struct dm_cell_key *key)
+{
+	return (key->block_begin >> BIO_PRISON_MAX_RANGE_SHIFT) &
+		(NR_LOCKS - 1);
+}
+
 /*
  * @nr_cells should be the number of cells you want in use _concurrently_.
  * Don't confuse it with the number of distinct keys.
@@ -34,20 +51,22 @@ static struct kmem_cache *_cell_cache;
 struct dm_bio_prison *dm_bio_prison_create(void)
 {
 	struct dm_bio_prison *prison = kzalloc(sizeof(*prison), GFP_KERNEL);
+	unsigned i;
 	int ret;
 
 	if (!prison)
 		return NULL;
 
-	spin_lock_init(&prison->lock);
-
 	ret = mempool_init_slab_pool(&prison->cell_pool, MIN_CELLS, _cell_cache);
 	if (ret) {
 		kfree(prison);
 		return NULL;
 	}
 
-	prison->cells = RB_ROOT;
+	for (i = 0; i < NR_LOCKS; i++) {
+		spin_lock_init(&prison->regions[i].lock);
+		prison->regions[i].cells = RB_ROOT;
+	}
 
 	return prison;
 }
@@ -106,14 +125,14 @@ static int cmp_keys(struct dm_cell_key *lhs,
 	return 0;
 }
 
-static int __bio_detain(struct dm_bio_prison *prison,
+static int __bio_detain(struct prison_region *region,
 			struct dm_cell_key *key,
 			struct bio *inmate,
 			struct dm_bio_prison_cell *cell_prealloc,
 			struct dm_bio_prison_cell **cell_result)
 {
 	int r;
-	struct rb_node **new = &prison->cells.rb_node, *parent = NULL;
+	struct rb_node **new = &region->cells.rb_node, *parent = NULL;
 
 	while (*new) {
 		struct dm_bio_prison_cell *cell =
@@ -138,7 +157,7 @@ static int __bio_detain(struct dm_bio_prison *prison,
 	*cell_result = cell_prealloc;
 
 	rb_link_node(&cell_prealloc->node, parent, new);
-	rb_insert_color(&cell_prealloc->node, &prison->cells);
+	rb_insert_color(&cell_prealloc->node, &region->cells);
 
 	return 0;
 }
@@ -151,10 +170,14 @@ static int bio_detain(struct dm_bio_prison *prison,
 {
 	int r;
 	unsigned long flags;
+	struct prison_region *region = prison->regions + lock_nr(key);
+
+	if (WARN_ON_ONCE(!dm_cell_key_has_valid_range(key)))
+		return -EINVAL;
 
-	spin_lock_irqsave(&prison->lock, flags);
-	r = __bio_detain(prison, key, inmate, cell_prealloc, cell_result);
-	spin_unlock_irqrestore(&prison->lock, flags);
+	spin_lock_irqsave(&region->lock, flags);
+	r = __bio_detain(region, key, inmate, cell_prealloc, cell_result);
+	spin_unlock_irqrestore(&region->lock, flags);
 
 	return r;
 }
@@ -181,11 +204,11 @@ EXPORT_SYMBOL_GPL(dm_get_cell);
 /*
  * @inmates must have been initialised prior to this call
  */
-static void __cell_release(struct dm_bio_prison *prison,
+static void __cell_release(struct prison_region *region,
 			   struct dm_bio_prison_cell *cell,
 			   struct bio_list *inmates)
 {
-	rb_erase(&cell->node, &prison->cells);
+	rb_erase(&cell->node, &region->cells);
 
 	if (inmates) {
 		if (cell->holder)
@@ -199,21 +222,22 @@ void dm_cell_release(struct dm_bio_prison *prison,
 		     struct bio_list *bios)
 {
 	unsigned long flags;
+	struct prison_region *region = prison->regions + lock_nr(&cell->key);
 
-	spin_lock_irqsave(&prison->lock, flags);
-	__cell_release(prison, cell, bios);
-	spin_unlock_irqrestore(&prison->lock, flags);
+	spin_lock_irqsave(&region->lock, flags);
+	__cell_release(region, cell, bios);
+	spin_unlock_irqrestore(&region->lock, flags);
 }
 EXPORT_SYMBOL_GPL(dm_cell_release);
 
 /*
  * Sometimes we don't want the holder, just the additional bios.
  */
-static void __cell_release_no_holder(struct dm_bio_prison *prison,
+static void __cell_release_no_holder(struct prison_region *region,
 				     struct dm_bio_prison_cell *cell,
 				     struct bio_list *inmates)
 {
-	rb_erase(&cell->node, &prison->cells);
+	rb_erase(&cell->node, &region->cells);
 	bio_list_merge(inmates, &cell->bios);
 }
 
@@ -222,10 +246,11 @@ void dm_cell_release_no_holder(struct dm_bio_prison *prison,
 			       struct bio_list *inmates)
 {
 	unsigned long flags;
+	struct prison_region *region = prison->regions + lock_nr(&cell->key);
 
-	spin_lock_irqsave(&prison->lock, flags);
-	__cell_release_no_holder(prison, cell, inmates);
-	spin_unlock_irqrestore(&prison->lock, flags);
+	spin_lock_irqsave(&region->lock, flags);
+	__cell_release_no_holder(region, cell, inmates);
+	spin_unlock_irqrestore(&region->lock, flags);
 }
 EXPORT_SYMBOL_GPL(dm_cell_release_no_holder);
 
@@ -251,19 +276,20 @@ void dm_cell_visit_release(struct dm_bio_prison *prison,
 			   struct dm_bio_prison_cell *cell)
 {
 	unsigned long flags;
+	struct prison_region *region = prison->regions + lock_nr(&cell->key);
 
-	spin_lock_irqsave(&prison->lock, flags);
+	spin_lock_irqsave(&region->lock, flags);
 	visit_fn(context, cell);
-	rb_erase(&cell->node, &prison->cells);
-	spin_unlock_irqrestore(&prison->lock, flags);
+	rb_erase(&cell->node, &region->cells);
+	spin_unlock_irqrestore(&region->lock, flags);
 }
 EXPORT_SYMBOL_GPL(dm_cell_visit_release);
 
-static int __promote_or_release(struct dm_bio_prison *prison,
+static int __promote_or_release(struct prison_region *region,
 				struct dm_bio_prison_cell *cell)
 {
 	if (bio_list_empty(&cell->bios)) {
-		rb_erase(&cell->node, &prison->cells);
+		rb_erase(&cell->node, &region->cells);
 		return 1;
 	}
 
@@ -276,10 +302,11 @@ int dm_cell_promote_or_release(struct dm_bio_prison *prison,
 {
 	int r;
 	unsigned long flags;
+	struct prison_region *region = prison->regions + lock_nr(&cell->key);
 
-	spin_lock_irqsave(&prison->lock, flags);
-	r = __promote_or_release(prison, cell);
-	spin_unlock_irqrestore(&prison->lock, flags);
+	spin_lock_irqsave(&region->lock, flags);
+	r = __promote_or_release(region, cell);
+	spin_unlock_irqrestore(&region->lock, flags);
 
 	return r;
 }
@@ -33,6 +33,27 @@ struct dm_cell_key {
 	dm_block_t block_begin, block_end;
 };
 
+/*
+ * The prison shards its lock by BIO_PRISON_MAX_RANGE aligned, BIO_PRISON_
+ * MAX_RANGE sized regions of the key space, so concurrent operations on
+ * different regions do not contend.  For this to work a key must never
+ * span such a region boundary; clients must split their ranges
+ * accordingly (see dm_cell_key_has_valid_range() below).
+ */
+#define BIO_PRISON_MAX_RANGE_SHIFT	10
+#define BIO_PRISON_MAX_RANGE		(1 << BIO_PRISON_MAX_RANGE_SHIFT)
+
+static inline bool dm_cell_key_has_valid_range(struct dm_cell_key *key)
+{
+	if (key->block_end - key->block_begin > BIO_PRISON_MAX_RANGE)
+		return false;
+	if ((key->block_begin >> BIO_PRISON_MAX_RANGE_SHIFT) !=
+	    ((key->block_end - 1) >> BIO_PRISON_MAX_RANGE_SHIFT))
+		return false;
+
+	return true;
+}
+
 /*
  * Treat this as opaque, only in header so callers can manage allocation
  * themselves.
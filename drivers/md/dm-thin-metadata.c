@@ -1640,6 +1640,50 @@ int dm_thin_insert_block(struct dm_thin_device *td, dm_block_t block,
 	return r;
 }
 
+/*
+ * Allocates and maps data blocks for every unmapped block in [begin, end)
+ * while holding the root lock once, so provisioning a whole volume is a
+ * single metadata transaction rather than one fault per block.  Stops at
+ * the first error, leaving any mappings already made in place.
+ */
+int dm_thin_provision_range(struct dm_thin_device *td,
+			    dm_block_t begin, dm_block_t end)
+{
+	int r = -EINVAL;
+	struct dm_pool_metadata *pmd = td->pmd;
+	dm_block_t b;
+
+	pmd_write_lock(pmd);
+	if (pmd->fail_io)
+		goto out;
+
+	for (b = begin; b < end; b++) {
+		__le64 value;
+		dm_block_t keys[2] = { td->id, b };
+		dm_block_t data_block;
+
+		/* Skip blocks that are already mapped */
+		r = dm_btree_lookup(&pmd->info, pmd->root, keys, &value);
+		if (!r)
+			continue;
+		if (r != -ENODATA)
+			goto out;
+
+		r = dm_sm_new_block(pmd->data_sm, &data_block);
+		if (r)
+			goto out;
+
+		r = __insert(td, b, data_block);
+		if (r)
+			goto out;
+	}
+	r = 0;
+out:
+	pmd_write_unlock(pmd);
+
+	return r;
+}
+
 static int __remove(struct dm_thin_device *td, dm_block_t block)
 {
 	int r;
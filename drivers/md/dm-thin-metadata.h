@@ -170,6 +170,12 @@ int dm_thin_remove_block(struct dm_thin_device *td, dm_block_t block);
 int dm_thin_remove_range(struct dm_thin_device *td,
 			 dm_block_t begin, dm_block_t end);
 
+/*
+ * Bulk provision every unmapped block in [begin, end) in one transaction.
+ */
+int dm_thin_provision_range(struct dm_thin_device *td,
+			    dm_block_t begin, dm_block_t end);
+
 /*
  * Queries.
  */
@@ -1686,7 +1686,7 @@ static void break_up_discard_bio(struct thin_c *tc, dm_block_t begin, dm_block_t
 	struct dm_cell_key data_key;
 	struct dm_bio_prison_cell *data_cell;
 	struct dm_thin_new_mapping *m;
-	dm_block_t virt_begin, virt_end, data_begin;
+	dm_block_t virt_begin, virt_end, data_begin, data_boundary;
 
 	while (begin != end) {
 		r = ensure_next_mapping(pool);
@@ -1703,6 +1703,17 @@ static void break_up_discard_bio(struct thin_c *tc, dm_block_t begin, dm_block_t
 			 */
 			break;
 
+		/*
+		 * The physical key must not straddle a prison region
+		 * boundary either; trim the range and let the next
+		 * iteration pick up the rest.
+		 */
+		data_boundary = (data_begin &
+				 ~(dm_block_t)(BIO_PRISON_MAX_RANGE - 1)) +
+			BIO_PRISON_MAX_RANGE;
+		if (data_begin + (virt_end - virt_begin) > data_boundary)
+			virt_end = virt_begin + (data_boundary - data_begin);
+
 		build_key(tc->td, PHYSICAL, data_begin, data_begin + (virt_end - virt_begin), &data_key);
 		if (bio_detain(tc->pool, &data_key, NULL, &data_cell)) {
 			/* contention, we'll give up with this range */
@@ -2738,6 +2749,21 @@ static int thin_bio_map(struct dm_target *ti, struct bio *bio)
 	}
 
 	if (op_is_flush(bio->bi_opf) || bio_op(bio) == REQ_OP_DISCARD) {
+		if (bio_op(bio) == REQ_OP_DISCARD && bio_sectors(bio)) {
+			/*
+			 * The bio prison shards its lock by BIO_PRISON_MAX_RANGE
+			 * aligned regions and a cell must not span a region
+			 * boundary.  Clamp the discard here; dm core resubmits
+			 * the remainder as a fresh bio.
+			 */
+			sector_t boundary =
+				((block & ~(dm_block_t)(BIO_PRISON_MAX_RANGE - 1)) +
+				 BIO_PRISON_MAX_RANGE) * tc->pool->sectors_per_block;
+
+			if (bio_end_sector(bio) > boundary)
+				dm_accept_partial_bio(bio,
+					boundary - bio->bi_iter.bi_sector);
+		}
 		thin_defer_bio_with_throttle(tc, bio);
 		return DM_MAPIO_SUBMITTED;
 	}
@@ -3845,11 +3871,63 @@ static int process_release_metadata_snap_mesg(unsigned argc, char **argv, struct
 	return r;
 }
 
+static int process_provision_mesg(unsigned argc, char **argv, struct pool *pool)
+{
+	int r;
+	dm_thin_id dev_id;
+	dm_block_t begin, end;
+	struct dm_thin_device *td;
+
+	r = check_arg_count(argc, 4);
+	if (r)
+		return r;
+
+	r = read_dev_id(argv[1], &dev_id, 1);
+	if (r)
+		return r;
+
+	if (kstrtoull(argv[2], 10, (unsigned long long *)&begin) ||
+	    kstrtoull(argv[3], 10, (unsigned long long *)&end) ||
+	    end <= begin) {
+		DMWARN("Message received with invalid block range: %s %s",
+		       argv[2], argv[3]);
+		return -EINVAL;
+	}
+
+	/*
+	 * Freshly allocated blocks are handed to the device unzeroed, so
+	 * bulk provisioning is only safe when the pool already skips block
+	 * zeroing (the provisioning flow is expected to write the whole
+	 * volume anyway).
+	 */
+	if (pool->pf.zero_new_blocks) {
+		DMWARN("provision message requires the skip_block_zeroing feature.");
+		return -EOPNOTSUPP;
+	}
+
+	r = dm_pool_open_thin_device(pool->pmd, dev_id, &td);
+	if (r) {
+		DMWARN("Provisioning of device with id %s failed.", argv[1]);
+		return r;
+	}
+
+	r = dm_thin_provision_range(td, begin, end);
+	if (r)
+		DMWARN("Provisioning blocks %llu-%llu of device with id %s failed.",
+		       (unsigned long long) begin, (unsigned long long) end,
+		       argv[1]);
+
+	(void) dm_pool_close_thin_device(td);
+
+	return r;
+}
+
 /*
  * Messages supported:
  *   create_thin	<dev_id>
  *   create_snap	<dev_id> <origin_id>
  *   delete		<dev_id>
+ *   provision		<dev_id> <begin_block> <end_block>
  *   set_transaction_id <current_trans_id> <new_trans_id>
  *   reserve_metadata_snap
  *   release_metadata_snap
@@ -3885,6 +3963,9 @@ static int pool_message(struct dm_target *ti, unsigned argc, char **argv,
 	else if (!strcasecmp(argv[0], "release_metadata_snap"))
 		r = process_release_metadata_snap_mesg(argc, argv, pool);
 
+	else if (!strcasecmp(argv[0], "provision"))
+		r = process_provision_mesg(argc, argv, pool);
+
 	else
 		DMWARN("Unrecognised thin pool target message received: %s", argv[0]);
 
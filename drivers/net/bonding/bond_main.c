@@ -3299,7 +3299,8 @@ u32 bond_xmit_hash(struct bonding *bond, struct sk_buff *skb)
 	struct flow_keys flow;
 	u32 hash;
 
-	if (bond->params.xmit_policy == BOND_XMIT_POLICY_ENCAP34 &&
+	if ((bond->params.xmit_policy == BOND_XMIT_POLICY_ENCAP34 ||
+	     bond->params.xmit_policy == BOND_XMIT_POLICY_LAYER34) &&
 	    skb->l4_hash)
 		return skb->hash;
 
@@ -3320,6 +3321,53 @@ u32 bond_xmit_hash(struct bonding *bond, struct sk_buff *skb)
 	return hash >> 1;
 }
 
+/* Periodically compare per-slave tx byte counts in XOR/802.3ad modes.  A
+ * handful of elephant flows hashing onto the same port can pin one link at
+ * line rate while the others idle; when one usable slave has carried more
+ * than twice its fair share over the last interval, reseed the salt that
+ * bond_3ad_xor_xmit() folds into the selection hash so flows are remapped.
+ * The remap reorders in-flight packets once, like a slave add/remove does.
+ */
+static void bond_rebalance_monitor(struct work_struct *work)
+{
+	struct bonding *bond = container_of(work, struct bonding,
+					    rebalance_work.work);
+	u64 max_delta = 0, total_delta = 0;
+	struct list_head *iter;
+	struct slave *slave;
+	int count = 0;
+
+	if (!bond->params.xmit_rebalance)
+		return;
+
+	rcu_read_lock();
+	bond_for_each_slave_rcu(bond, slave, iter) {
+		struct rtnl_link_stats64 stats;
+		u64 delta;
+
+		dev_get_stats(slave->dev, &stats);
+		delta = stats.tx_bytes - slave->rebalance_tx_bytes;
+		slave->rebalance_tx_bytes = stats.tx_bytes;
+
+		if (!bond_slave_can_tx(slave))
+			continue;
+		total_delta += delta;
+		max_delta = max(max_delta, delta);
+		count++;
+	}
+	rcu_read_unlock();
+
+	if (count > 1 && total_delta &&
+	    max_delta * count > 2 * total_delta) {
+		WRITE_ONCE(bond->xmit_salt, prandom_u32());
+		netdev_dbg(bond->dev, "rebalancing: busiest slave carried %llu of %llu bytes across %d slaves\n",
+			   max_delta, total_delta, count);
+	}
+
+	queue_delayed_work(bond->wq, &bond->rebalance_work,
+			   bond->params.xmit_rebalance * HZ);
+}
+
 /*-------------------------- Device entry points ----------------------------*/
 
 void bond_work_init_all(struct bonding *bond)
@@ -3331,6 +3379,7 @@ void bond_work_init_all(struct bonding *bond)
 	INIT_DELAYED_WORK(&bond->arp_work, bond_arp_monitor);
 	INIT_DELAYED_WORK(&bond->ad_work, bond_3ad_state_machine_handler);
 	INIT_DELAYED_WORK(&bond->slave_arr_work, bond_slave_arr_handler);
+	INIT_DELAYED_WORK(&bond->rebalance_work, bond_rebalance_monitor);
 }
 
 static void bond_work_cancel_all(struct bonding *bond)
@@ -3341,6 +3390,7 @@ static void bond_work_cancel_all(struct bonding *bond)
 	cancel_delayed_work_sync(&bond->ad_work);
 	cancel_delayed_work_sync(&bond->mcast_work);
 	cancel_delayed_work_sync(&bond->slave_arr_work);
+	cancel_delayed_work_sync(&bond->rebalance_work);
 }
 
 static int bond_open(struct net_device *bond_dev)
@@ -3391,6 +3441,10 @@ static int bond_open(struct net_device *bond_dev)
 	if (bond_mode_can_use_xmit_hash(bond))
 		bond_update_slave_arr(bond, NULL);
 
+	if (bond->params.xmit_rebalance)  /* rebalance interval, in seconds. */
+		queue_delayed_work(bond->wq, &bond->rebalance_work,
+				   bond->params.xmit_rebalance * HZ);
+
 	return 0;
 }
 
@@ -4105,7 +4159,10 @@ static netdev_tx_t bond_3ad_xor_xmit(struct sk_buff *skb,
 	slaves = rcu_dereference(bond->slave_arr);
 	count = slaves ? READ_ONCE(slaves->count) : 0;
 	if (likely(count)) {
-		slave = slaves->arr[bond_xmit_hash(bond, skb) % count];
+		u32 hash = bond_xmit_hash(bond, skb) ^
+			   READ_ONCE(bond->xmit_salt);
+
+		slave = slaves->arr[hash % count];
 		bond_dev_queue_xmit(bond, skb, slave->dev);
 	} else {
 		bond_tx_drop(dev, skb);
@@ -4770,6 +4827,7 @@ static int bond_check_params(struct bond_params *params)
 	params->lp_interval = lp_interval;
 	params->packets_per_slave = packets_per_slave;
 	params->tlb_dynamic_lb = tlb_dynamic_lb;
+	params->xmit_rebalance = 0;
 	params->ad_actor_sys_prio = ad_actor_sys_prio;
 	eth_zero_addr(params->ad_actor_system);
 	params->ad_user_port_key = ad_user_port_key;
@@ -76,6 +76,8 @@ static int bond_option_ad_actor_system_set(struct bonding *bond,
 					   const struct bond_opt_value *newval);
 static int bond_option_ad_user_port_key_set(struct bonding *bond,
 					    const struct bond_opt_value *newval);
+static int bond_option_xmit_rebalance_set(struct bonding *bond,
+					  const struct bond_opt_value *newval);
 
 
 static const struct bond_opt_value bond_mode_tbl[] = {
@@ -192,6 +194,12 @@ static const struct bond_opt_value bond_tlb_dynamic_lb_tbl[] = {
 	{ NULL,  -1, 0}
 };
 
+static const struct bond_opt_value bond_xmit_rebalance_tbl[] = {
+	{ "off",     0,       BOND_VALFLAG_DEFAULT},
+	{ "maxval",  INT_MAX, BOND_VALFLAG_MAX},
+	{ NULL,      -1,      0},
+};
+
 static const struct bond_opt_value bond_ad_actor_sys_prio_tbl[] = {
 	{ "minval",  1,     BOND_VALFLAG_MIN},
 	{ "maxval",  65535, BOND_VALFLAG_MAX | BOND_VALFLAG_DEFAULT},
@@ -433,6 +441,15 @@ static const struct bond_option bond_opts[BOND_OPT_LAST] = {
 		.desc = "Delay between each peer notification on failover event, in milliseconds",
 		.values = bond_intmax_tbl,
 		.set = bond_option_peer_notif_delay_set
+	},
+	[BOND_OPT_XMIT_REBALANCE] = {
+		.id = BOND_OPT_XMIT_REBALANCE,
+		.name = "xmit_rebalance",
+		.desc = "Interval between slave utilization rebalance checks, in seconds; 0 disables",
+		.unsuppmodes = BOND_MODE_ALL_EX(BIT(BOND_MODE_XOR) |
+						BIT(BOND_MODE_8023AD)),
+		.values = bond_xmit_rebalance_tbl,
+		.set = bond_option_xmit_rebalance_set
 	}
 };
 
@@ -1264,6 +1281,25 @@ static int bond_option_lp_interval_set(struct bonding *bond,
 	return 0;
 }
 
+static int bond_option_xmit_rebalance_set(struct bonding *bond,
+					  const struct bond_opt_value *newval)
+{
+	netdev_dbg(bond->dev, "Setting xmit_rebalance to %llu\n",
+		   newval->value);
+	bond->params.xmit_rebalance = newval->value;
+	if (bond->dev->flags & IFF_UP) {
+		/* If the interface is up, (re)arm the rebalance monitor with
+		 * the new interval; otherwise bond_open() will start it.
+		 */
+		cancel_delayed_work_sync(&bond->rebalance_work);
+		if (newval->value)
+			queue_delayed_work(bond->wq, &bond->rebalance_work,
+					   newval->value * HZ);
+	}
+
+	return 0;
+}
+
 static int bond_option_pps_set(struct bonding *bond,
 			       const struct bond_opt_value *newval)
 {
@@ -243,6 +243,8 @@
 			       NET_IP_ALIGN)
 #define NETSEC_RX_BUF_NON_DATA (NETSEC_RXBUF_HEADROOM + \
 				SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
+/* Headers copied to the skb linear area when header split is enabled */
+#define NETSEC_RX_SPLIT_HLEN	256
 
 #define DESC_SZ	sizeof(struct netsec_de)
 
@@ -284,6 +286,8 @@ struct netsec_desc_ring {
 	u16 xdp_xmit; /* netsec_xdp_xmit packets */
 	struct page_pool *page_pool;
 	struct xdp_rxq_info xdp_rxq;
+	unsigned int pool_order;
+	bool header_split;
 	spinlock_t lock; /* XDP tx queue locking */
 };
 
@@ -731,10 +735,11 @@ static void *netsec_alloc_rx_data(struct netsec_priv *priv,
 	 * network payloads and/or XDP
 	 */
 	*dma_handle = page_pool_get_dma_addr(page) + NETSEC_RXBUF_HEADROOM;
-	/* Make sure the incoming payload fits in the page for XDP and non-XDP
-	 * cases and reserve enough space for headroom + skb_shared_info
+	/* Make sure the incoming payload fits in the buffer for XDP and
+	 * non-XDP cases and reserve enough space for headroom +
+	 * skb_shared_info
 	 */
-	*desc_len = PAGE_SIZE - NETSEC_RX_BUF_NON_DATA;
+	*desc_len = (PAGE_SIZE << dring->pool_order) - NETSEC_RX_BUF_NON_DATA;
 	dma_dir = page_pool_get_dma_dir(dring->page_pool);
 	dma_sync_single_for_device(priv->dev, *dma_handle, *desc_len, dma_dir);
 
@@ -1005,7 +1010,15 @@ static int netsec_process_rx(struct netsec_priv *priv, int budget)
 				goto next;
 			}
 		}
-		skb = build_skb(desc->addr, desc->len + NETSEC_RX_BUF_NON_DATA);
+		if (dring->header_split)
+			skb = napi_skb_header_split(&priv->napi, page,
+						    xdp.data - xdp.data_hard_start,
+						    xdp.data_end - xdp.data,
+						    NETSEC_RX_SPLIT_HLEN,
+						    PAGE_SIZE << dring->pool_order);
+		else
+			skb = build_skb(desc->addr,
+					desc->len + NETSEC_RX_BUF_NON_DATA);
 
 		if (unlikely(!skb)) {
 			/* If skb fails recycle_direct will either unmap and
@@ -1018,10 +1031,17 @@ static int netsec_process_rx(struct netsec_priv *priv, int budget)
 				  "rx failed to build skb\n");
 			break;
 		}
-		page_pool_release_page(dring->page_pool, page);
 
-		skb_reserve(skb, xdp.data - xdp.data_hard_start);
-		skb_put(skb, xdp.data_end - xdp.data);
+		if (!dring->header_split) {
+			page_pool_release_page(dring->page_pool, page);
+			skb_reserve(skb, xdp.data - xdp.data_hard_start);
+			skb_put(skb, xdp.data_end - xdp.data);
+		} else if (skb_shinfo(skb)->nr_frags) {
+			page_pool_release_page(dring->page_pool, page);
+		} else {
+			/* Whole packet copied, keep the payload page pooled */
+			page_pool_recycle_direct(dring->page_pool, page);
+		}
 		skb->protocol = eth_type_trans(skb, priv->ndev);
 
 		if (priv->rx_cksum_offload_flag &&
@@ -1274,7 +1294,14 @@ static int netsec_setup_rx_dring(struct netsec_priv *priv)
 	struct page_pool_params pp_params = { 0 };
 	int i, err;
 
-	pp_params.order = 0;
+	dring->pool_order = netdev_rx_queue_pool_order(priv->ndev, 0);
+	/* desc->len and the hardware buffer length field are 16 bit wide */
+	while (dring->pool_order &&
+	       (PAGE_SIZE << dring->pool_order) > U16_MAX)
+		dring->pool_order--;
+	dring->header_split = netdev_rx_queue_header_split(priv->ndev, 0);
+
+	pp_params.order = dring->pool_order;
 	/* internal DMA mapping in page_pool */
 	pp_params.flags = PP_FLAG_DMA_MAP;
 	pp_params.pool_size = DESC_NUM;
@@ -34,6 +34,14 @@
 #define VETH_RING_SIZE		256
 #define VETH_XDP_HEADROOM	(XDP_PACKET_HEADROOM + NET_IP_ALIGN)
 
+/*
+ * Largest contiguous buffer we reallocate an skb into before running the XDP
+ * program on it.  This is what limits the MTU in XDP mode; allowing a few
+ * pages keeps jumbo frames (9000 byte MTU) working while still bounding the
+ * allocation to an order the page allocator serves cheaply under load.
+ */
+#define VETH_XDP_MAX_BUF	(PAGE_SIZE << PAGE_ALLOC_COSTLY_ORDER)
+
 /* Separating two types of XDP xmit */
 #define VETH_XDP_TX		BIT(0)
 #define VETH_XDP_REDIR		BIT(1)
@@ -49,6 +57,10 @@ struct veth_rq_stats {
 
 struct veth_rq {
 	struct napi_struct	xdp_napi;
+	struct napi_struct __rcu *napi; /* points to xdp_napi when the rx
+					 * path is active, whether for XDP
+					 * or for plain NAPI+GRO receive
+					 */
 	struct net_device	*dev;
 	struct bpf_prog __rcu	*xdp_prog;
 	struct xdp_mem_info	xdp_mem;
@@ -64,6 +76,9 @@ struct veth_priv {
 	struct bpf_prog		*_xdp_prog;
 	struct veth_rq		*rq;
 	unsigned int		requested_headroom;
+	bool			gro_napi; /* NAPI rx path requested via the
+					   * "napi" private flag
+					   */
 };
 
 struct veth_xdp_tx_bq {
@@ -96,6 +111,18 @@ static struct {
 	{ "peer_ifindex" },
 };
 
+/* Route packets through the peer's NAPI instance with GRO even without an
+ * XDP program, instead of per-packet netif_rx() into the backlog.
+ */
+#define VETH_PRIV_FLAG_NAPI	BIT(0)
+
+static const char veth_priv_flags_strings[][ETH_GSTRING_LEN] = {
+	"napi",
+};
+
+static int veth_napi_add(struct net_device *dev);
+static void veth_napi_del(struct net_device *dev);
+
 static int veth_get_link_ksettings(struct net_device *dev,
 				   struct ethtool_link_ksettings *cmd)
 {
@@ -130,6 +157,10 @@ static void veth_get_strings(struct net_device *dev, u32 stringset, u8 *buf)
 			}
 		}
 		break;
+	case ETH_SS_PRIV_FLAGS:
+		memcpy(p, veth_priv_flags_strings,
+		       sizeof(veth_priv_flags_strings));
+		break;
 	}
 }
 
@@ -139,6 +170,8 @@ static int veth_get_sset_count(struct net_device *dev, int sset)
 	case ETH_SS_STATS:
 		return ARRAY_SIZE(ethtool_stats_keys) +
 		       VETH_RQ_STATS_LEN * dev->real_num_rx_queues;
+	case ETH_SS_PRIV_FLAGS:
+		return ARRAY_SIZE(veth_priv_flags_strings);
 	default:
 		return -EOPNOTSUPP;
 	}
@@ -170,6 +203,42 @@ static void veth_get_ethtool_stats(struct net_device *dev,
 	}
 }
 
+static u32 veth_get_priv_flags(struct net_device *dev)
+{
+	struct veth_priv *priv = netdev_priv(dev);
+
+	return priv->gro_napi ? VETH_PRIV_FLAG_NAPI : 0;
+}
+
+static int veth_set_priv_flags(struct net_device *dev, u32 flags)
+{
+	struct veth_priv *priv = netdev_priv(dev);
+	bool enable = !!(flags & VETH_PRIV_FLAG_NAPI);
+	int err;
+
+	if (flags & ~VETH_PRIV_FLAG_NAPI)
+		return -EOPNOTSUPP;
+
+	if (enable == priv->gro_napi)
+		return 0;
+
+	/* The XDP setup owns the NAPI instance while a program is attached;
+	 * just record the flag for when the program goes away.
+	 */
+	if ((dev->flags & IFF_UP) && !priv->_xdp_prog) {
+		if (enable) {
+			err = veth_napi_add(dev);
+			if (err)
+				return err;
+		} else {
+			veth_napi_del(dev);
+		}
+	}
+	priv->gro_napi = enable;
+
+	return 0;
+}
+
 static const struct ethtool_ops veth_ethtool_ops = {
 	.get_drvinfo		= veth_get_drvinfo,
 	.get_link		= ethtool_op_get_link,
@@ -178,6 +247,8 @@ static const struct ethtool_ops veth_ethtool_ops = {
 	.get_ethtool_stats	= veth_get_ethtool_stats,
 	.get_link_ksettings	= veth_get_link_ksettings,
 	.get_ts_info		= ethtool_op_get_ts_info,
+	.get_priv_flags		= veth_get_priv_flags,
+	.set_priv_flags		= veth_set_priv_flags,
 };
 
 /* general routines */
@@ -239,7 +310,7 @@ static netdev_tx_t veth_xmit(struct sk_buff *skb, struct net_device *dev)
 	struct veth_rq *rq = NULL;
 	struct net_device *rcv;
 	int length = skb->len;
-	bool rcv_xdp = false;
+	bool use_napi = false;
 	int rxq;
 
 	rcu_read_lock();
@@ -253,14 +324,17 @@ static netdev_tx_t veth_xmit(struct sk_buff *skb, struct net_device *dev)
 	rxq = skb_get_queue_mapping(skb);
 	if (rxq < rcv->real_num_rx_queues) {
 		rq = &rcv_priv->rq[rxq];
-		rcv_xdp = rcu_access_pointer(rq->xdp_prog);
-		if (rcv_xdp)
+		/* The napi pointer is set when the rx path runs in NAPI
+		 * mode, for an attached XDP program or for GRO receive.
+		 */
+		use_napi = rcu_access_pointer(rq->napi);
+		if (use_napi)
 			skb_record_rx_queue(skb, rxq);
 	}
 
 	skb_tx_timestamp(skb);
-	if (likely(veth_forward_skb(rcv, skb, rq, rcv_xdp) == NET_RX_SUCCESS)) {
-		if (!rcv_xdp) {
+	if (likely(veth_forward_skb(rcv, skb, rq, use_napi) == NET_RX_SUCCESS)) {
+		if (!use_napi) {
 			struct pcpu_lstats *stats = this_cpu_ptr(dev->lstats);
 
 			u64_stats_update_begin(&stats->syncp);
@@ -273,7 +347,7 @@ drop:
 		atomic64_inc(&priv->dropped);
 	}
 
-	if (rcv_xdp)
+	if (use_napi)
 		__veth_xdp_flush(rq);
 
 	rcu_read_unlock();
@@ -622,10 +696,11 @@ static struct sk_buff *veth_xdp_rcv_skb(struct veth_rq *rq, struct sk_buff *skb,
 
 		size = SKB_DATA_ALIGN(VETH_XDP_HEADROOM + pktlen) +
 		       SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
-		if (size > PAGE_SIZE)
+		if (size > VETH_XDP_MAX_BUF)
 			goto drop;
 
-		page = alloc_page(GFP_ATOMIC | __GFP_NOWARN);
+		page = alloc_pages(GFP_ATOMIC | __GFP_NOWARN | __GFP_COMP,
+				   get_order(size));
 		if (!page)
 			goto drop;
 
@@ -638,7 +713,7 @@ static struct sk_buff *veth_xdp_rcv_skb(struct veth_rq *rq, struct sk_buff *skb,
 
 		nskb = veth_build_skb(head,
 				      VETH_XDP_HEADROOM + mac_len, skb->len,
-				      PAGE_SIZE);
+				      PAGE_SIZE << get_order(size));
 		if (!nskb) {
 			page_frag_free(head);
 			goto drop;
@@ -814,6 +889,7 @@ static int veth_napi_add(struct net_device *dev)
 
 		netif_napi_add(dev, &rq->xdp_napi, veth_poll, NAPI_POLL_WEIGHT);
 		napi_enable(&rq->xdp_napi);
+		rcu_assign_pointer(rq->napi, &rq->xdp_napi);
 	}
 
 	return 0;
@@ -832,6 +908,7 @@ static void veth_napi_del(struct net_device *dev)
 	for (i = 0; i < dev->real_num_rx_queues; i++) {
 		struct veth_rq *rq = &priv->rq[i];
 
+		rcu_assign_pointer(rq->napi, NULL);
 		napi_disable(&rq->xdp_napi);
 		napi_hash_del(&rq->xdp_napi);
 	}
@@ -849,6 +926,7 @@ static void veth_napi_del(struct net_device *dev)
 static int veth_enable_xdp(struct net_device *dev)
 {
 	struct veth_priv *priv = netdev_priv(dev);
+	bool napi_already_on = rtnl_dereference(priv->rq[0].napi);
 	int err, i;
 
 	if (!xdp_rxq_info_is_reg(&priv->rq[0].xdp_rxq)) {
@@ -869,9 +947,11 @@ static int veth_enable_xdp(struct net_device *dev)
 			rq->xdp_mem = rq->xdp_rxq.mem;
 		}
 
-		err = veth_napi_add(dev);
-		if (err)
-			goto err_rxq_reg;
+		if (!napi_already_on) {
+			err = veth_napi_add(dev);
+			if (err)
+				goto err_rxq_reg;
+		}
 	}
 
 	for (i = 0; i < dev->real_num_rx_queues; i++)
@@ -894,7 +974,8 @@ static void veth_disable_xdp(struct net_device *dev)
 
 	for (i = 0; i < dev->real_num_rx_queues; i++)
 		rcu_assign_pointer(priv->rq[i].xdp_prog, NULL);
-	veth_napi_del(dev);
+	if (!netif_running(dev) || !priv->gro_napi)
+		veth_napi_del(dev);
 	for (i = 0; i < dev->real_num_rx_queues; i++) {
 		struct veth_rq *rq = &priv->rq[i];
 
@@ -916,6 +997,10 @@ static int veth_open(struct net_device *dev)
 		err = veth_enable_xdp(dev);
 		if (err)
 			return err;
+	} else if (priv->gro_napi) {
+		err = veth_napi_add(dev);
+		if (err)
+			return err;
 	}
 
 	if (peer->flags & IFF_UP) {
@@ -937,6 +1022,8 @@ static int veth_close(struct net_device *dev)
 
 	if (priv->_xdp_prog)
 		veth_disable_xdp(dev);
+	else if (priv->gro_napi)
+		veth_napi_del(dev);
 
 	return 0;
 }
@@ -1082,7 +1169,7 @@ static int veth_xdp_set(struct net_device *dev, struct bpf_prog *prog,
 			goto err;
 		}
 
-		max_mtu = PAGE_SIZE - VETH_XDP_HEADROOM -
+		max_mtu = VETH_XDP_MAX_BUF - VETH_XDP_HEADROOM -
 			  peer->hard_header_len -
 			  SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
 		if (peer->mtu > max_mtu) {
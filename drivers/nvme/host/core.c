@@ -283,6 +283,7 @@ void nvme_complete_rq(struct request *req)
 	blk_status_t status = nvme_error_status(nvme_req(req)->status);
 
 	trace_nvme_complete_rq(req);
+	nvme_mpath_io_end(req);
 
 	if (nvme_req(req)->ctrl->kas)
 		nvme_req(req)->ctrl->comp_seen = true;
@@ -782,6 +783,8 @@ blk_status_t nvme_setup_cmd(struct nvme_ns *ns, struct request *req,
 
 	cmd->common.command_id = req->tag;
 	trace_nvme_setup_cmd(req, cmd);
+	if (ns && ret == BLK_STS_OK)
+		nvme_mpath_io_start(req);
 	return ret;
 }
 EXPORT_SYMBOL_GPL(nvme_setup_cmd);
@@ -2507,6 +2510,7 @@ static void nvme_release_subsystem(struct device *dev)
 	struct nvme_subsystem *subsys =
 		container_of(dev, struct nvme_subsystem, dev);
 
+	nvme_mpath_put_iopolicy(subsys);
 	if (subsys->instance >= 0)
 		ida_simple_remove(&nvme_instance_ida, subsys->instance);
 	kfree(subsys);
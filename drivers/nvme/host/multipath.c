@@ -4,6 +4,7 @@
  */
 
 #include <linux/backing-dev.h>
+#include <linux/module.h>
 #include <linux/moduleparam.h>
 #include <trace/events/block.h>
 #include "nvme.h"
@@ -13,6 +14,94 @@ module_param(multipath, bool, 0444);
 MODULE_PARM_DESC(multipath,
 	"turn on native support for multiple controllers per subsystem");
 
+/* Weight of a new sample in the per-path completion latency EWMA */
+#define NVME_PATH_LAT_EWMA_SHIFT	3
+
+static LIST_HEAD(nvme_mpath_policies);
+static DEFINE_MUTEX(nvme_mpath_policies_lock);
+
+int nvme_mpath_register_policy(struct nvme_mpath_policy *policy)
+{
+	struct nvme_mpath_policy *p;
+	int ret = 0;
+
+	mutex_lock(&nvme_mpath_policies_lock);
+	list_for_each_entry(p, &nvme_mpath_policies, entry) {
+		if (!strcmp(p->name, policy->name)) {
+			ret = -EEXIST;
+			goto out_unlock;
+		}
+	}
+	list_add_tail_rcu(&policy->entry, &nvme_mpath_policies);
+out_unlock:
+	mutex_unlock(&nvme_mpath_policies_lock);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(nvme_mpath_register_policy);
+
+/*
+ * The caller must ensure no subsystem still uses the policy, which is
+ * normally guaranteed by the module reference held for each selection.
+ */
+void nvme_mpath_unregister_policy(struct nvme_mpath_policy *policy)
+{
+	mutex_lock(&nvme_mpath_policies_lock);
+	list_del_rcu(&policy->entry);
+	mutex_unlock(&nvme_mpath_policies_lock);
+	synchronize_rcu();
+}
+EXPORT_SYMBOL_GPL(nvme_mpath_unregister_policy);
+
+static void nvme_subsys_clear_iopolicy_plugin(struct nvme_subsystem *subsys)
+{
+	struct nvme_mpath_policy *old;
+
+	old = rcu_dereference_protected(subsys->iopolicy_plugin,
+				lockdep_is_held(&nvme_mpath_policies_lock));
+	if (old) {
+		RCU_INIT_POINTER(subsys->iopolicy_plugin, NULL);
+		module_put(old->owner);
+	}
+}
+
+void nvme_mpath_put_iopolicy(struct nvme_subsystem *subsys)
+{
+	mutex_lock(&nvme_mpath_policies_lock);
+	nvme_subsys_clear_iopolicy_plugin(subsys);
+	mutex_unlock(&nvme_mpath_policies_lock);
+}
+
+void nvme_mpath_io_start(struct request *rq)
+{
+	struct nvme_ns *ns = rq->q->queuedata;
+
+	if (!ns->head->disk ||
+	    (nvme_req(rq)->flags & NVME_REQ_PATH_ACCOUNTED))
+		return;
+	nvme_req(rq)->flags |= NVME_REQ_PATH_ACCOUNTED;
+	atomic_inc(&ns->path_inflight);
+}
+
+void nvme_mpath_io_end(struct request *rq)
+{
+	struct nvme_ns *ns = rq->q->queuedata;
+	u64 lat, ewma;
+
+	if (!ns || !(nvme_req(rq)->flags & NVME_REQ_PATH_ACCOUNTED))
+		return;
+	nvme_req(rq)->flags &= ~NVME_REQ_PATH_ACCOUNTED;
+	atomic_dec(&ns->path_inflight);
+
+	lat = ktime_get_ns() - rq->start_time_ns;
+	ewma = READ_ONCE(ns->path_lat_ewma);
+	if (ewma)
+		ewma += (lat >> NVME_PATH_LAT_EWMA_SHIFT) -
+			(ewma >> NVME_PATH_LAT_EWMA_SHIFT);
+	else
+		ewma = lat;
+	WRITE_ONCE(ns->path_lat_ewma, ewma);
+}
+
 void nvme_mpath_unfreeze(struct nvme_subsystem *subsys)
 {
 	struct nvme_ns_head *h;
@@ -257,6 +346,50 @@ out:
 	return found;
 }
 
+static struct nvme_ns *nvme_service_time_path(struct nvme_ns_head *head,
+		int node)
+{
+	u64 found_cost = U64_MAX, fallback_cost = U64_MAX, cost;
+	struct nvme_ns *found = NULL, *fallback = NULL, *ns;
+
+	list_for_each_entry_rcu(ns, &head->list, siblings) {
+		if (nvme_path_is_disabled(ns))
+			continue;
+
+		/*
+		 * Estimated time to drain this path: the commands already in
+		 * flight plus the one about to be queued, times the smoothed
+		 * completion latency.  A path without latency samples yet
+		 * costs nothing, so fresh paths are probed quickly.
+		 */
+		cost = (u64)(atomic_read(&ns->path_inflight) + 1) *
+			READ_ONCE(ns->path_lat_ewma);
+
+		switch (ns->ana_state) {
+		case NVME_ANA_OPTIMIZED:
+			if (cost < found_cost) {
+				found_cost = cost;
+				found = ns;
+			}
+			break;
+		case NVME_ANA_NONOPTIMIZED:
+			if (cost < fallback_cost) {
+				fallback_cost = cost;
+				fallback = ns;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (!found)
+		found = fallback;
+	if (found)
+		rcu_assign_pointer(head->current_path[node], found);
+	return found;
+}
+
 static inline bool nvme_path_is_optimized(struct nvme_ns *ns)
 {
 	return ns->ctrl->state == NVME_CTRL_LIVE &&
@@ -265,12 +398,30 @@ static inline bool nvme_path_is_optimized(struct nvme_ns *ns)
 
 inline struct nvme_ns *nvme_find_path(struct nvme_ns_head *head)
 {
+	int iopolicy = READ_ONCE(head->subsys->iopolicy);
 	int node = numa_node_id();
 	struct nvme_ns *ns;
 
+	if (iopolicy == NVME_IOPOLICY_PLUGIN) {
+		struct nvme_mpath_policy *policy;
+
+		ns = NULL;
+		rcu_read_lock();
+		policy = rcu_dereference(head->subsys->iopolicy_plugin);
+		if (policy)
+			ns = policy->select(head);
+		rcu_read_unlock();
+		if (ns)
+			return ns;
+		/* no policy or no answer: fall back to default selection */
+		return __nvme_find_path(head, node);
+	}
+
 	ns = srcu_dereference(head->current_path[node], &head->srcu);
-	if (READ_ONCE(head->subsys->iopolicy) == NVME_IOPOLICY_RR && ns)
+	if (iopolicy == NVME_IOPOLICY_RR && ns)
 		ns = nvme_round_robin_path(head, node, ns);
+	else if (iopolicy == NVME_IOPOLICY_ST)
+		ns = nvme_service_time_path(head, node);
 	if (unlikely(!ns || !nvme_path_is_optimized(ns)))
 		ns = __nvme_find_path(head, node);
 	return ns;
@@ -592,6 +743,7 @@ void nvme_mpath_stop(struct nvme_ctrl *ctrl)
 static const char *nvme_iopolicy_names[] = {
 	[NVME_IOPOLICY_NUMA]	= "numa",
 	[NVME_IOPOLICY_RR]	= "round-robin",
+	[NVME_IOPOLICY_ST]	= "service-time",
 };
 
 static ssize_t nvme_subsys_iopolicy_show(struct device *dev,
@@ -599,9 +751,20 @@ static ssize_t nvme_subsys_iopolicy_show(struct device *dev,
 {
 	struct nvme_subsystem *subsys =
 		container_of(dev, struct nvme_subsystem, dev);
+	int iopolicy = READ_ONCE(subsys->iopolicy);
+
+	if (iopolicy == NVME_IOPOLICY_PLUGIN) {
+		struct nvme_mpath_policy *policy;
+		ssize_t ret;
+
+		rcu_read_lock();
+		policy = rcu_dereference(subsys->iopolicy_plugin);
+		ret = sprintf(buf, "%s\n", policy ? policy->name : "none");
+		rcu_read_unlock();
+		return ret;
+	}
 
-	return sprintf(buf, "%s\n",
-			nvme_iopolicy_names[READ_ONCE(subsys->iopolicy)]);
+	return sprintf(buf, "%s\n", nvme_iopolicy_names[iopolicy]);
 }
 
 static ssize_t nvme_subsys_iopolicy_store(struct device *dev,
@@ -609,15 +772,33 @@ static ssize_t nvme_subsys_iopolicy_store(struct device *dev,
 {
 	struct nvme_subsystem *subsys =
 		container_of(dev, struct nvme_subsystem, dev);
+	struct nvme_mpath_policy *policy;
 	int i;
 
 	for (i = 0; i < ARRAY_SIZE(nvme_iopolicy_names); i++) {
 		if (sysfs_streq(buf, nvme_iopolicy_names[i])) {
+			mutex_lock(&nvme_mpath_policies_lock);
+			nvme_subsys_clear_iopolicy_plugin(subsys);
 			WRITE_ONCE(subsys->iopolicy, i);
+			mutex_unlock(&nvme_mpath_policies_lock);
 			return count;
 		}
 	}
 
+	mutex_lock(&nvme_mpath_policies_lock);
+	list_for_each_entry(policy, &nvme_mpath_policies, entry) {
+		if (!sysfs_streq(buf, policy->name))
+			continue;
+		if (!try_module_get(policy->owner))
+			break;
+		nvme_subsys_clear_iopolicy_plugin(subsys);
+		rcu_assign_pointer(subsys->iopolicy_plugin, policy);
+		WRITE_ONCE(subsys->iopolicy, NVME_IOPOLICY_PLUGIN);
+		mutex_unlock(&nvme_mpath_policies_lock);
+		return count;
+	}
+	mutex_unlock(&nvme_mpath_policies_lock);
+
 	return -EINVAL;
 }
 SUBSYS_ATTR_RW(iopolicy, S_IRUGO | S_IWUSR,
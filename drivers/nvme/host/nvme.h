@@ -138,6 +138,7 @@ struct nvme_request {
 enum {
 	NVME_REQ_CANCELLED		= (1 << 0),
 	NVME_REQ_USERCMD		= (1 << 1),
+	NVME_REQ_PATH_ACCOUNTED		= (1 << 2),
 };
 
 static inline struct nvme_request *nvme_req(struct request *req)
@@ -284,9 +285,13 @@ struct nvme_ctrl {
 	struct nvme_fault_inject fault_inject;
 };
 
+struct nvme_mpath_policy;
+
 enum nvme_iopolicy {
 	NVME_IOPOLICY_NUMA,
 	NVME_IOPOLICY_RR,
+	NVME_IOPOLICY_ST,
+	NVME_IOPOLICY_PLUGIN,
 };
 
 struct nvme_subsystem {
@@ -311,6 +316,7 @@ struct nvme_subsystem {
 	struct ida		ns_ida;
 #ifdef CONFIG_NVME_MULTIPATH
 	enum nvme_iopolicy	iopolicy;
+	struct nvme_mpath_policy __rcu *iopolicy_plugin;
 #endif
 };
 
@@ -360,6 +366,8 @@ struct nvme_ns {
 #ifdef CONFIG_NVME_MULTIPATH
 	enum nvme_ana_state ana_state;
 	u32 ana_grpid;
+	atomic_t path_inflight;
+	u64 path_lat_ewma;
 #endif
 	struct list_head siblings;
 	struct nvm_dev *ndev;
@@ -534,6 +542,26 @@ void nvme_mpath_stop(struct nvme_ctrl *ctrl);
 bool nvme_mpath_clear_current_path(struct nvme_ns *ns);
 void nvme_mpath_clear_ctrl_paths(struct nvme_ctrl *ctrl);
 struct nvme_ns *nvme_find_path(struct nvme_ns_head *head);
+void nvme_mpath_io_start(struct request *rq);
+void nvme_mpath_io_end(struct request *rq);
+void nvme_mpath_put_iopolicy(struct nvme_subsystem *subsys);
+
+/*
+ * Pluggable I/O path selector.  Modules register a policy and it is selected
+ * per subsystem by writing its name to the iopolicy sysfs attribute.  The
+ * select callback runs under head->srcu and RCU and must not sleep; it may
+ * return NULL to fall back to the default path selection.  A subsystem that
+ * selected the policy holds a reference on @owner, so the owning module
+ * cannot be unloaded while the policy is in use.
+ */
+struct nvme_mpath_policy {
+	struct list_head	entry;
+	const char		*name;
+	struct module		*owner;
+	struct nvme_ns		*(*select)(struct nvme_ns_head *head);
+};
+int nvme_mpath_register_policy(struct nvme_mpath_policy *policy);
+void nvme_mpath_unregister_policy(struct nvme_mpath_policy *policy);
 
 static inline void nvme_mpath_check_last_path(struct nvme_ns *ns)
 {
@@ -604,6 +632,15 @@ static inline void nvme_trace_bio_complete(struct request *req,
         blk_status_t status)
 {
 }
+static inline void nvme_mpath_io_start(struct request *rq)
+{
+}
+static inline void nvme_mpath_io_end(struct request *rq)
+{
+}
+static inline void nvme_mpath_put_iopolicy(struct nvme_subsystem *subsys)
+{
+}
 static inline int nvme_mpath_init(struct nvme_ctrl *ctrl,
 		struct nvme_id_ctrl *id)
 {
@@ -344,6 +344,18 @@ static void scsi_dec_host_busy(struct Scsi_Host *shost)
 	rcu_read_unlock();
 }
 
+/*
+ * SSDs gain nothing from per-LUN queue depth throttling - the host tag
+ * space already bounds the number of outstanding commands - so skip the
+ * device_busy accounting for non-rotational devices unless the LLD wants
+ * accurate counts for tracking queue full conditions.
+ */
+static inline bool scsi_device_busy_elided(struct scsi_device *sdev)
+{
+	return blk_queue_nonrot(sdev->request_queue) &&
+		!sdev->host->hostt->track_queue_depth;
+}
+
 void scsi_device_unbusy(struct scsi_device *sdev)
 {
 	struct Scsi_Host *shost = sdev->host;
@@ -354,7 +366,12 @@ void scsi_device_unbusy(struct scsi_device *sdev)
 	if (starget->can_queue > 0)
 		atomic_dec(&starget->target_busy);
 
-	atomic_dec(&sdev->device_busy);
+	/*
+	 * When accounting is elided device_busy stays at zero.  Decrement
+	 * with a floor of zero so that flipping the rotational flag while
+	 * commands are in flight cannot drive the counter negative.
+	 */
+	atomic_add_unless(&sdev->device_busy, -1, 0);
 }
 
 static void scsi_kick_queue(struct request_queue *q)
@@ -571,10 +588,22 @@ static void scsi_mq_uninit_cmd(struct scsi_cmnd *cmd)
 static void scsi_run_queue_async(struct scsi_device *sdev)
 {
 	if (scsi_target(sdev)->single_lun ||
-	    !list_empty(&sdev->host->starved_list))
+	    !list_empty(&sdev->host->starved_list)) {
 		kblockd_schedule_work(&sdev->requeue_work);
-	else
-		blk_mq_run_hw_queues(sdev->request_queue, true);
+		return;
+	}
+
+	/*
+	 * When device_busy accounting is elided the budget is always
+	 * granted, so dispatch can only stall further down where blk-mq's
+	 * own SCHED_RESTART handling and the delayed runs armed on
+	 * BLK_STS_RESOURCE already guarantee forward progress.  Skip the
+	 * hw queue run that would otherwise be taken on every completion.
+	 */
+	if (scsi_device_busy_elided(sdev) && !scsi_device_blocked(sdev))
+		return;
+
+	blk_mq_run_hw_queues(sdev->request_queue, true);
 }
 
 /* Returns false when no more bytes to process, true if there are more */
@@ -1294,6 +1323,21 @@ static inline int scsi_dev_queue_ready(struct request_queue *q,
 {
 	unsigned int busy;
 
+	if (scsi_device_busy_elided(sdev)) {
+		if (atomic_read(&sdev->device_blocked)) {
+			/*
+			 * Without accounting we can't wait for the device
+			 * to drain, so iterate device_blocked down once
+			 * per dispatch attempt instead.
+			 */
+			if (atomic_dec_return(&sdev->device_blocked) > 0)
+				return 0;
+			SCSI_LOG_MLQUEUE(3, sdev_printk(KERN_INFO, sdev,
+					   "unblocking device at zero depth\n"));
+		}
+		return 1;
+	}
+
 	busy = atomic_inc_return(&sdev->device_busy) - 1;
 	if (atomic_read(&sdev->device_blocked)) {
 		if (busy)
@@ -1636,7 +1680,7 @@ static void scsi_mq_put_budget(struct blk_mq_hw_ctx *hctx)
 	struct request_queue *q = hctx->queue;
 	struct scsi_device *sdev = q->queuedata;
 
-	atomic_dec(&sdev->device_busy);
+	atomic_add_unless(&sdev->device_busy, -1, 0);
 }
 
 static bool scsi_mq_get_budget(struct blk_mq_hw_ctx *hctx)
@@ -1647,7 +1691,13 @@ static bool scsi_mq_get_budget(struct blk_mq_hw_ctx *hctx)
 	if (scsi_dev_queue_ready(q, sdev))
 		return true;
 
-	if (atomic_read(&sdev->device_busy) == 0 && !scsi_device_blocked(sdev))
+	/*
+	 * With elided accounting we only get here while device_blocked
+	 * iterates down, and completions no longer kick the queue, so
+	 * poll until the device unblocks.
+	 */
+	if (scsi_device_busy_elided(sdev) ||
+	    (atomic_read(&sdev->device_busy) == 0 && !scsi_device_blocked(sdev)))
 		blk_mq_delay_run_hw_queue(hctx, SCSI_QUEUE_DELAY);
 	return false;
 }
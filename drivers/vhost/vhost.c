@@ -186,12 +186,12 @@ EXPORT_SYMBOL_GPL(vhost_work_init);
 
 /* Init poll structure */
 void vhost_poll_init(struct vhost_poll *poll, vhost_work_fn_t fn,
-		     __poll_t mask, struct vhost_dev *dev)
+		     __poll_t mask, struct vhost_virtqueue *vq)
 {
 	init_waitqueue_func_entry(&poll->wait, vhost_poll_wakeup);
 	init_poll_funcptr(&poll->table, vhost_poll_func);
 	poll->mask = mask;
-	poll->dev = dev;
+	poll->vq = vq;
 	poll->wqh = NULL;
 
 	vhost_work_init(&poll->work, fn);
@@ -230,17 +230,37 @@ void vhost_poll_stop(struct vhost_poll *poll)
 }
 EXPORT_SYMBOL_GPL(vhost_poll_stop);
 
-void vhost_work_flush(struct vhost_dev *dev, struct vhost_work *work)
+static void vhost_work_queue_on(struct vhost_worker *worker,
+				struct vhost_work *work)
+{
+	if (!worker)
+		return;
+
+	if (!test_and_set_bit(VHOST_WORK_QUEUED, &work->flags)) {
+		/* We can only add the work to the list after we're
+		 * sure it was not in the list.
+		 * test_and_set_bit() implies a memory barrier.
+		 */
+		llist_add(&work->node, &worker->work_list);
+		wake_up_process(worker->task);
+	}
+}
+
+static void vhost_worker_flush(struct vhost_worker *worker)
 {
 	struct vhost_flush_struct flush;
 
-	if (dev->worker) {
-		init_completion(&flush.wait_event);
-		vhost_work_init(&flush.work, vhost_flush_work);
+	init_completion(&flush.wait_event);
+	vhost_work_init(&flush.work, vhost_flush_work);
 
-		vhost_work_queue(dev, &flush.work);
-		wait_for_completion(&flush.wait_event);
-	}
+	vhost_work_queue_on(worker, &flush.work);
+	wait_for_completion(&flush.wait_event);
+}
+
+void vhost_work_flush(struct vhost_dev *dev, struct vhost_work *work)
+{
+	if (dev->worker)
+		vhost_worker_flush(dev->worker);
 }
 EXPORT_SYMBOL_GPL(vhost_work_flush);
 
@@ -248,36 +268,31 @@ EXPORT_SYMBOL_GPL(vhost_work_flush);
  * locks that are also used by the callback. */
 void vhost_poll_flush(struct vhost_poll *poll)
 {
-	vhost_work_flush(poll->dev, &poll->work);
+	struct vhost_worker *worker = READ_ONCE(poll->vq->worker);
+
+	if (worker)
+		vhost_worker_flush(worker);
 }
 EXPORT_SYMBOL_GPL(vhost_poll_flush);
 
 void vhost_work_queue(struct vhost_dev *dev, struct vhost_work *work)
 {
-	if (!dev->worker)
-		return;
-
-	if (!test_and_set_bit(VHOST_WORK_QUEUED, &work->flags)) {
-		/* We can only add the work to the list after we're
-		 * sure it was not in the list.
-		 * test_and_set_bit() implies a memory barrier.
-		 */
-		llist_add(&work->node, &dev->work_list);
-		wake_up_process(dev->worker);
-	}
+	vhost_work_queue_on(dev->worker, work);
 }
 EXPORT_SYMBOL_GPL(vhost_work_queue);
 
 /* A lockless hint for busy polling code to exit the loop */
-bool vhost_has_work(struct vhost_dev *dev)
+bool vhost_vq_has_work(struct vhost_virtqueue *vq)
 {
-	return !llist_empty(&dev->work_list);
+	struct vhost_worker *worker = READ_ONCE(vq->worker);
+
+	return worker && !llist_empty(&worker->work_list);
 }
-EXPORT_SYMBOL_GPL(vhost_has_work);
+EXPORT_SYMBOL_GPL(vhost_vq_has_work);
 
 void vhost_poll_queue(struct vhost_poll *poll)
 {
-	vhost_work_queue(poll->dev, &poll->work);
+	vhost_work_queue_on(READ_ONCE(poll->vq->worker), &poll->work);
 }
 EXPORT_SYMBOL_GPL(vhost_poll_queue);
 
@@ -325,12 +340,14 @@ static void vhost_vq_reset(struct vhost_dev *dev,
 	vq->busyloop_timeout = 0;
 	vq->umem = NULL;
 	vq->iotlb = NULL;
+	vq->worker = NULL;
 	__vhost_vq_meta_reset(vq);
 }
 
 static int vhost_worker(void *data)
 {
-	struct vhost_dev *dev = data;
+	struct vhost_worker *worker = data;
+	struct vhost_dev *dev = worker->dev;
 	struct vhost_work *work, *work_next;
 	struct llist_node *node;
 	mm_segment_t oldfs = get_fs();
@@ -347,7 +364,7 @@ static int vhost_worker(void *data)
 			break;
 		}
 
-		node = llist_del_all(&dev->work_list);
+		node = llist_del_all(&worker->work_list);
 		if (!node)
 			schedule();
 
@@ -470,7 +487,7 @@ void vhost_dev_init(struct vhost_dev *dev,
 	dev->iov_limit = iov_limit;
 	dev->weight = weight;
 	dev->byte_weight = byte_weight;
-	init_llist_head(&dev->work_list);
+	xa_init_flags(&dev->worker_xa, XA_FLAGS_ALLOC);
 	init_waitqueue_head(&dev->wait);
 	INIT_LIST_HEAD(&dev->read_list);
 	INIT_LIST_HEAD(&dev->pending_list);
@@ -487,7 +504,7 @@ void vhost_dev_init(struct vhost_dev *dev,
 		vhost_vq_reset(dev, vq);
 		if (vq->handle_kick)
 			vhost_poll_init(&vq->poll, vq->handle_kick,
-					EPOLLIN, dev);
+					EPOLLIN, vq);
 	}
 }
 EXPORT_SYMBOL_GPL(vhost_dev_init);
@@ -514,17 +531,68 @@ static void vhost_attach_cgroups_work(struct vhost_work *work)
 	s->ret = cgroup_attach_task_all(s->owner, current);
 }
 
-static int vhost_attach_cgroups(struct vhost_dev *dev)
+static int vhost_attach_cgroups(struct vhost_worker *worker)
 {
 	struct vhost_attach_cgroups_struct attach;
 
 	attach.owner = current;
 	vhost_work_init(&attach.work, vhost_attach_cgroups_work);
-	vhost_work_queue(dev, &attach.work);
-	vhost_work_flush(dev, &attach.work);
+	vhost_work_queue_on(worker, &attach.work);
+	vhost_worker_flush(worker);
 	return attach.ret;
 }
 
+static void vhost_worker_destroy(struct vhost_dev *dev,
+				 struct vhost_worker *worker)
+{
+	WARN_ON(!llist_empty(&worker->work_list));
+	xa_erase(&dev->worker_xa, worker->id);
+	kthread_stop(worker->task);
+	kfree(worker);
+}
+
+static struct vhost_worker *vhost_worker_create(struct vhost_dev *dev)
+{
+	struct vhost_worker *worker;
+	struct task_struct *task;
+	u32 id;
+	int err;
+
+	worker = kzalloc(sizeof(*worker), GFP_KERNEL);
+	if (!worker)
+		return NULL;
+
+	worker->dev = dev;
+	init_llist_head(&worker->work_list);
+
+	task = kthread_create(vhost_worker, worker, "vhost-%d", current->pid);
+	if (IS_ERR(task))
+		goto free_worker;
+
+	worker->task = task;
+	wake_up_process(task);	/* avoid contributing to loadavg */
+
+	/* Put the new thread into the same cgroups as the owner so that
+	 * its CPU time is charged to and limited by the VM's cgroup. */
+	err = vhost_attach_cgroups(worker);
+	if (err)
+		goto stop_worker;
+
+	err = xa_alloc(&dev->worker_xa, &id, worker, xa_limit_31b,
+		       GFP_KERNEL);
+	if (err)
+		goto stop_worker;
+	worker->id = id;
+
+	return worker;
+
+stop_worker:
+	kthread_stop(task);
+free_worker:
+	kfree(worker);
+	return NULL;
+}
+
 /* Caller should have device mutex */
 bool vhost_dev_has_owner(struct vhost_dev *dev)
 {
@@ -535,8 +603,8 @@ EXPORT_SYMBOL_GPL(vhost_dev_has_owner);
 /* Caller should have device mutex */
 long vhost_dev_set_owner(struct vhost_dev *dev)
 {
-	struct task_struct *worker;
-	int err;
+	struct vhost_worker *worker;
+	int err, i;
 
 	/* Is there an owner already? */
 	if (vhost_dev_has_owner(dev)) {
@@ -546,26 +614,27 @@ long vhost_dev_set_owner(struct vhost_dev *dev)
 
 	/* No owner, become one */
 	dev->mm = get_task_mm(current);
-	worker = kthread_create(vhost_worker, dev, "vhost-%d", current->pid);
-	if (IS_ERR(worker)) {
-		err = PTR_ERR(worker);
+	worker = vhost_worker_create(dev);
+	if (!worker) {
+		err = -ENOMEM;
 		goto err_worker;
 	}
 
+	/* All virtqueues start out on the default worker. */
 	dev->worker = worker;
-	wake_up_process(worker);	/* avoid contributing to loadavg */
-
-	err = vhost_attach_cgroups(dev);
-	if (err)
-		goto err_cgroup;
+	worker->attachment_cnt = dev->nvqs;
+	for (i = 0; i < dev->nvqs; ++i)
+		dev->vqs[i]->worker = worker;
 
 	err = vhost_dev_alloc_iovecs(dev);
 	if (err)
-		goto err_cgroup;
+		goto err_iovecs;
 
 	return 0;
-err_cgroup:
-	kthread_stop(worker);
+err_iovecs:
+	for (i = 0; i < dev->nvqs; ++i)
+		dev->vqs[i]->worker = NULL;
+	vhost_worker_destroy(dev, worker);
 	dev->worker = NULL;
 err_worker:
 	if (dev->mm)
@@ -678,11 +747,15 @@ void vhost_dev_cleanup(struct vhost_dev *dev)
 	dev->iotlb = NULL;
 	vhost_clear_msg(dev);
 	wake_up_interruptible_poll(&dev->wait, EPOLLIN | EPOLLRDNORM);
-	WARN_ON(!llist_empty(&dev->work_list));
 	if (dev->worker) {
-		kthread_stop(dev->worker);
+		struct vhost_worker *worker;
+		unsigned long i;
+
+		xa_for_each(&dev->worker_xa, i, worker)
+			vhost_worker_destroy(dev, worker);
 		dev->worker = NULL;
 	}
+	xa_destroy(&dev->worker_xa);
 	if (dev->mm)
 		mmput(dev->mm);
 	dev->mm = NULL;
@@ -1582,6 +1655,67 @@ static long vhost_vring_set_num_addr(struct vhost_dev *d,
 
 	return r;
 }
+
+static long vhost_vring_worker_ioctl(struct vhost_dev *d,
+				     struct vhost_virtqueue *vq, u32 idx,
+				     unsigned int ioctl, void __user *argp)
+{
+	struct vhost_vring_worker w;
+	struct vhost_worker *worker, *old;
+	long r = 0;
+
+	switch (ioctl) {
+	case VHOST_ATTACH_VRING_WORKER:
+		if (copy_from_user(&w, argp, sizeof(w)))
+			return -EFAULT;
+		worker = xa_load(&d->worker_xa, w.worker_id);
+		if (!worker)
+			return -ENODEV;
+
+		mutex_lock(&vq->mutex);
+		/* The ring must be stopped so that no work is queued to the
+		 * old worker once it has been flushed below. */
+		if (vq->private_data) {
+			mutex_unlock(&vq->mutex);
+			return -EBUSY;
+		}
+		old = vq->worker;
+		if (old == worker) {
+			mutex_unlock(&vq->mutex);
+			return 0;
+		}
+		/* Stop the kick poller so the guest can't queue work to the
+		 * old worker behind our back while we swap. */
+		if (vq->kick && vq->handle_kick)
+			vhost_poll_stop(&vq->poll);
+		WRITE_ONCE(vq->worker, worker);
+		worker->attachment_cnt++;
+		if (old)
+			old->attachment_cnt--;
+		if (vq->kick && vq->handle_kick)
+			r = vhost_poll_start(&vq->poll, vq->kick);
+		mutex_unlock(&vq->mutex);
+
+		/* Don't hold the ring mutex here: the handlers take it. */
+		if (old)
+			vhost_worker_flush(old);
+		break;
+	case VHOST_GET_VRING_WORKER:
+		worker = READ_ONCE(vq->worker);
+		if (!worker)
+			return -EINVAL;
+		w.index = idx;
+		w.worker_id = worker->id;
+		if (copy_to_user(argp, &w, sizeof(w)))
+			return -EFAULT;
+		break;
+	default:
+		r = -ENOIOCTLCMD;
+	}
+
+	return r;
+}
+
 long vhost_vring_ioctl(struct vhost_dev *d, unsigned int ioctl, void __user *argp)
 {
 	struct file *eventfp, *filep = NULL;
@@ -1608,6 +1742,11 @@ long vhost_vring_ioctl(struct vhost_dev *d, unsigned int ioctl, void __user *arg
 		return vhost_vring_set_num_addr(d, vq, ioctl, argp);
 	}
 
+	if (ioctl == VHOST_ATTACH_VRING_WORKER ||
+	    ioctl == VHOST_GET_VRING_WORKER) {
+		return vhost_vring_worker_ioctl(d, vq, idx, ioctl, argp);
+	}
+
 	mutex_lock(&vq->mutex);
 
 	switch (ioctl) {
@@ -1808,6 +1947,44 @@ long vhost_dev_ioctl(struct vhost_dev *d, unsigned int ioctl, void __user *argp)
 		if (ctx)
 			eventfd_ctx_put(ctx);
 		break;
+	case VHOST_NEW_WORKER: {
+		struct vhost_worker_state w;
+		struct vhost_worker *worker;
+
+		worker = vhost_worker_create(d);
+		if (!worker) {
+			r = -ENOMEM;
+			break;
+		}
+		w.worker_id = worker->id;
+		if (copy_to_user(argp, &w, sizeof(w))) {
+			vhost_worker_destroy(d, worker);
+			r = -EFAULT;
+		}
+		break;
+	}
+	case VHOST_FREE_WORKER: {
+		struct vhost_worker_state w;
+		struct vhost_worker *worker;
+
+		if (copy_from_user(&w, argp, sizeof(w))) {
+			r = -EFAULT;
+			break;
+		}
+		worker = xa_load(&d->worker_xa, w.worker_id);
+		if (!worker) {
+			r = -ENODEV;
+			break;
+		}
+		/* The default worker always services device-level work, and
+		 * a worker with rings attached may have work in flight. */
+		if (worker == d->worker || worker->attachment_cnt) {
+			r = -EBUSY;
+			break;
+		}
+		vhost_worker_destroy(d, worker);
+		break;
+	}
 	default:
 		r = -ENOIOCTLCMD;
 		break;
@@ -12,6 +12,7 @@
 #include <linux/virtio_config.h>
 #include <linux/virtio_ring.h>
 #include <linux/atomic.h>
+#include <linux/xarray.h>
 
 struct vhost_work;
 typedef void (*vhost_work_fn_t)(struct vhost_work *work);
@@ -23,6 +24,20 @@ struct vhost_work {
 	unsigned long		  flags;
 };
 
+/* A worker thread servicing one or more virtqueues.  The worker created at
+ * VHOST_SET_OWNER time has id 0 and services every virtqueue until userspace
+ * creates more workers and rebinds virtqueues with
+ * VHOST_ATTACH_VRING_WORKER. */
+struct vhost_worker {
+	struct task_struct	 *task;
+	struct llist_head	  work_list;
+	struct vhost_dev	 *dev;
+	/* Number of virtqueues bound to this worker.  Protected by the
+	 * device mutex. */
+	int			  attachment_cnt;
+	u32			  id;
+};
+
 /* Poll a file (eventfd or socket) */
 /* Note: there's nothing vhost specific about this structure. */
 struct vhost_poll {
@@ -31,15 +46,15 @@ struct vhost_poll {
 	wait_queue_entry_t              wait;
 	struct vhost_work	  work;
 	__poll_t		  mask;
-	struct vhost_dev	 *dev;
+	struct vhost_virtqueue	 *vq;
 };
 
 void vhost_work_init(struct vhost_work *work, vhost_work_fn_t fn);
 void vhost_work_queue(struct vhost_dev *dev, struct vhost_work *work);
-bool vhost_has_work(struct vhost_dev *dev);
+bool vhost_vq_has_work(struct vhost_virtqueue *vq);
 
 void vhost_poll_init(struct vhost_poll *poll, vhost_work_fn_t fn,
-		     __poll_t mask, struct vhost_dev *dev);
+		     __poll_t mask, struct vhost_virtqueue *vq);
 int vhost_poll_start(struct vhost_poll *poll, struct file *file);
 void vhost_poll_stop(struct vhost_poll *poll);
 void vhost_poll_flush(struct vhost_poll *poll);
@@ -98,6 +113,10 @@ struct vhost_virtqueue {
 
 	struct vhost_poll poll;
 
+	/* The worker servicing this virtqueue.  Protected by the device
+	 * mutex; readers on the queueing path use READ_ONCE. */
+	struct vhost_worker *worker;
+
 	/* The routine to call when the Guest pings us, or timeout. */
 	vhost_work_fn_t handle_kick;
 
@@ -162,8 +181,10 @@ struct vhost_dev {
 	struct vhost_virtqueue **vqs;
 	int nvqs;
 	struct eventfd_ctx *log_ctx;
-	struct llist_head work_list;
-	struct task_struct *worker;
+	/* The default worker, created at VHOST_SET_OWNER time. */
+	struct vhost_worker *worker;
+	/* All workers of this device, indexed by worker id. */
+	struct xarray worker_xa;
 	struct vhost_umem *umem;
 	struct vhost_umem *iotlb;
 	spinlock_t iotlb_lock;
@@ -41,6 +41,7 @@
 #include <linux/sched/cputime.h>
 #include <linux/cred.h>
 #include <linux/dax.h>
+#include <linux/fadvise.h>
 #include <linux/uaccess.h>
 #include <asm/param.h>
 #include <asm/page.h>
@@ -543,6 +544,29 @@ static inline int make_prot(u32 p_flags)
    is only provided so that we can read a.out libraries that have
    an ELF header */
 
+/*
+ * Kick off asynchronous readahead of all PT_LOAD file ranges before the
+ * segments are mapped, so that by the time control transfers to the new
+ * image most major faults hit pages whose I/O is already in flight (or
+ * completed) instead of paying a synchronous read per fault cluster.
+ *
+ * This is best effort: on failure the segments are simply demand paged
+ * as before, so errors are ignored.
+ */
+static void elf_readahead_segments(struct file *file,
+				   struct elf_phdr *phdata, int nr)
+{
+	struct elf_phdr *eppnt = phdata;
+	int i;
+
+	for (i = 0; i < nr; i++, eppnt++) {
+		if (eppnt->p_type != PT_LOAD || !eppnt->p_filesz)
+			continue;
+		vfs_fadvise(file, eppnt->p_offset, eppnt->p_filesz,
+			    POSIX_FADV_WILLNEED);
+	}
+}
+
 static unsigned long load_elf_interp(struct elfhdr *interp_elf_ex,
 		struct file *interpreter, unsigned long *interp_map_addr,
 		unsigned long no_base, struct elf_phdr *interp_elf_phdata)
@@ -573,6 +597,9 @@ static unsigned long load_elf_interp(struct elfhdr *interp_elf_ex,
 		goto out;
 	}
 
+	elf_readahead_segments(interpreter, interp_elf_phdata,
+			       interp_elf_ex->e_phnum);
+
 	eppnt = interp_elf_phdata;
 	for (i = 0; i < interp_elf_ex->e_phnum; i++, eppnt++) {
 		if (eppnt->p_type == PT_LOAD) {
@@ -875,6 +902,8 @@ out_free_interp:
 	start_data = 0;
 	end_data = 0;
 
+	elf_readahead_segments(bprm->file, elf_phdata, loc->elf_ex.e_phnum);
+
 	/* Now we do a little grungy work by mmapping the ELF image into
 	   the correct location in memory. */
 	for(i = 0, elf_ppnt = elf_phdata;
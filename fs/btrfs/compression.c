@@ -297,6 +297,13 @@ out:
 	bio_put(bio);
 }
 
+static blk_status_t btrfs_submit_compressed_bio_start(void *private_data,
+						      struct bio *bio,
+						      u64 bio_offset)
+{
+	return btrfs_csum_one_bio(private_data, bio, bio_offset, 1);
+}
+
 /*
  * worker function to build and submit bios for previously compressed pages.
  * The corresponding pages in the inode should be marked for writeback
@@ -304,7 +311,10 @@ out:
  * when the IO is complete.
  *
  * This also checksums the file bytes and gets things ready for
- * the end io hooks.
+ * the end io hooks.  The checksumming itself is offloaded through
+ * btrfs_wq_submit_bio() so that crc of the compressed data is sharded
+ * across CPUs instead of running serialized in the single ordered
+ * async_cow submit stage that calls us.
  */
 blk_status_t btrfs_submit_compressed_write(struct inode *inode, u64 start,
 				 unsigned long len, u64 disk_start,
@@ -373,12 +383,12 @@ blk_status_t btrfs_submit_compressed_write(struct inode *inode, u64 start,
 						  BTRFS_WQ_ENDIO_DATA);
 			BUG_ON(ret); /* -ENOMEM */
 
-			if (!skip_sum) {
-				ret = btrfs_csum_one_bio(inode, bio, start, 1);
-				BUG_ON(ret); /* -ENOMEM */
-			}
-
-			ret = btrfs_map_bio(fs_info, bio, 0, 1);
+			if (!skip_sum)
+				ret = btrfs_wq_submit_bio(fs_info, bio, 0, 0,
+						start, inode,
+						btrfs_submit_compressed_bio_start);
+			else
+				ret = btrfs_map_bio(fs_info, bio, 0, 1);
 			if (ret) {
 				bio->bi_status = ret;
 				bio_endio(bio);
@@ -404,12 +414,11 @@ blk_status_t btrfs_submit_compressed_write(struct inode *inode, u64 start,
 	ret = btrfs_bio_wq_end_io(fs_info, bio, BTRFS_WQ_ENDIO_DATA);
 	BUG_ON(ret); /* -ENOMEM */
 
-	if (!skip_sum) {
-		ret = btrfs_csum_one_bio(inode, bio, start, 1);
-		BUG_ON(ret); /* -ENOMEM */
-	}
-
-	ret = btrfs_map_bio(fs_info, bio, 0, 1);
+	if (!skip_sum)
+		ret = btrfs_wq_submit_bio(fs_info, bio, 0, 0, start, inode,
+					  btrfs_submit_compressed_bio_start);
+	else
+		ret = btrfs_map_bio(fs_info, bio, 0, 1);
 	if (ret) {
 		bio->bi_status = ret;
 		bio_endio(bio);
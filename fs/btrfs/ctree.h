@@ -680,6 +680,12 @@ struct btrfs_fs_info {
 
 	atomic_t async_delalloc_pages;
 
+	/*
+	 * Number of bios queued for async checksumming but not yet mapped to
+	 * the devices, bounded in btrfs_wq_submit_bio().
+	 */
+	atomic_t nr_async_submits;
+
 	/*
 	 * this is used to protect the following list -- ordered_roots.
 	 */
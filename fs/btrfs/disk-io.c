@@ -755,6 +755,18 @@ blk_status_t btrfs_bio_wq_end_io(struct btrfs_fs_info *info, struct bio *bio,
 	return 0;
 }
 
+/*
+ * Maximum number of bios queued for async checksumming at any one time,
+ * scaled with the thread pool size so a larger pool also gets a deeper
+ * pipeline.  Beyond this the submitters are made to wait so that a flood of
+ * writeback bios cannot build an unbounded backlog of checksum work in front
+ * of everybody else.
+ */
+static unsigned int btrfs_async_submit_limit(struct btrfs_fs_info *fs_info)
+{
+	return 256 * fs_info->thread_pool_size;
+}
+
 static void run_one_async_start(struct btrfs_work *work)
 {
 	struct async_submit_bio *async;
@@ -778,11 +790,18 @@ static void run_one_async_start(struct btrfs_work *work)
 static void run_one_async_done(struct btrfs_work *work)
 {
 	struct async_submit_bio *async;
+	struct btrfs_fs_info *fs_info;
 	struct inode *inode;
 	blk_status_t ret;
 
 	async = container_of(work, struct  async_submit_bio, work);
 	inode = async->private_data;
+	fs_info = btrfs_sb(inode->i_sb);
+
+	/* One bio less in the pipeline, unthrottle waiting submitters */
+	if (atomic_dec_return(&fs_info->nr_async_submits) <
+	    btrfs_async_submit_limit(fs_info) * 2 / 3)
+		cond_wake_up_nomb(&fs_info->async_submit_wait);
 
 	/* If an error occurred we just want to clean up the bio and move on */
 	if (async->status) {
@@ -791,8 +810,7 @@ static void run_one_async_done(struct btrfs_work *work)
 		return;
 	}
 
-	ret = btrfs_map_bio(btrfs_sb(inode->i_sb), async->bio,
-			async->mirror_num, 1);
+	ret = btrfs_map_bio(fs_info, async->bio, async->mirror_num, 1);
 	if (ret) {
 		async->bio->bi_status = ret;
 		bio_endio(async->bio);
@@ -814,6 +832,16 @@ blk_status_t btrfs_wq_submit_bio(struct btrfs_fs_info *fs_info, struct bio *bio,
 {
 	struct async_submit_bio *async;
 
+	/*
+	 * Sync bios skip the throttle, they are queued at high priority below
+	 * and making a commit or fsync wait behind async writeback would
+	 * defeat that.
+	 */
+	if (!op_is_sync(bio->bi_opf))
+		wait_event(fs_info->async_submit_wait,
+			   atomic_read(&fs_info->nr_async_submits) <
+			   btrfs_async_submit_limit(fs_info));
+
 	async = kmalloc(sizeof(*async), GFP_NOFS);
 	if (!async)
 		return BLK_STS_RESOURCE;
@@ -833,6 +861,7 @@ blk_status_t btrfs_wq_submit_bio(struct btrfs_fs_info *fs_info, struct bio *bio,
 	if (op_is_sync(bio->bi_opf))
 		btrfs_set_work_high_priority(&async->work);
 
+	atomic_inc(&fs_info->nr_async_submits);
 	btrfs_queue_work(fs_info->workers, &async->work);
 	return 0;
 }
@@ -2678,6 +2707,7 @@ int open_ctree(struct super_block *sb,
 			     BTRFS_BLOCK_RSV_DELREFS);
 
 	atomic_set(&fs_info->async_delalloc_pages, 0);
+	atomic_set(&fs_info->nr_async_submits, 0);
 	atomic_set(&fs_info->defrag_running, 0);
 	atomic_set(&fs_info->reada_works_cnt, 0);
 	atomic_set(&fs_info->nr_delayed_iputs, 0);
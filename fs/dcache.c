@@ -165,6 +165,41 @@ static long get_nr_dentry_negative(void)
 	return sum < 0 ? 0 : sum;
 }
 
+/*
+ * Cap on the number of unused negative dentries. When the cache grows
+ * past it, the surplus is pruned in batches from a workqueue so lookup
+ * paths never pay for the reclaim. Zero (the default) disables the cap.
+ */
+unsigned long sysctl_negative_dentry_limit;
+
+/* Insertions between two checks of the limit on each CPU */
+#define NEG_DENTRY_BATCH	(1 << 6)
+
+static DEFINE_PER_CPU(long, nr_dentry_negative_batch);
+
+static void prune_negative_dentries(struct work_struct *work);
+static DECLARE_WORK(negative_prune_work, prune_negative_dentries);
+
+/*
+ * Called when a negative dentry is added to the LRU. Summing the
+ * per-cpu counters is not free, so only look at the total once per
+ * NEG_DENTRY_BATCH insertions on this CPU.
+ */
+static void negative_dentry_limit_check(void)
+{
+	unsigned long limit = READ_ONCE(sysctl_negative_dentry_limit);
+
+	if (likely(!limit))
+		return;
+
+	if (this_cpu_inc_return(nr_dentry_negative_batch) < NEG_DENTRY_BATCH)
+		return;
+	this_cpu_write(nr_dentry_negative_batch, 0);
+
+	if (get_nr_dentry_negative() > limit)
+		schedule_work(&negative_prune_work);
+}
+
 int proc_nr_dentry(struct ctl_table *table, int write, void __user *buffer,
 		   size_t *lenp, loff_t *ppos)
 {
@@ -399,8 +434,10 @@ static void d_lru_add(struct dentry *dentry)
 	D_FLAG_VERIFY(dentry, 0);
 	dentry->d_flags |= DCACHE_LRU_LIST;
 	this_cpu_inc(nr_dentry_unused);
-	if (d_is_negative(dentry))
+	if (d_is_negative(dentry)) {
 		this_cpu_inc(nr_dentry_negative);
+		negative_dentry_limit_check();
+	}
 	WARN_ON_ONCE(!list_lru_add(&dentry->d_sb->s_dentry_lru, &dentry->d_lru));
 }
 
@@ -1179,6 +1216,74 @@ static enum lru_status dentry_lru_isolate(struct list_head *item,
 	return LRU_REMOVED;
 }
 
+/*
+ * Like dentry_lru_isolate(), but only takes negative dentries. Positive
+ * entries are skipped in place so their LRU order is left to normal
+ * memory-pressure aging.
+ */
+static enum lru_status dentry_lru_isolate_negative(struct list_head *item,
+		struct list_lru_one *lru, spinlock_t *lru_lock, void *arg)
+{
+	struct list_head *freeable = arg;
+	struct dentry	*dentry = container_of(item, struct dentry, d_lru);
+
+	if (!spin_trylock(&dentry->d_lock))
+		return LRU_SKIP;
+
+	if (!d_is_negative(dentry)) {
+		spin_unlock(&dentry->d_lock);
+		return LRU_SKIP;
+	}
+
+	if (dentry->d_lockref.count) {
+		d_lru_isolate(lru, dentry);
+		spin_unlock(&dentry->d_lock);
+		return LRU_REMOVED;
+	}
+
+	if (dentry->d_flags & DCACHE_REFERENCED) {
+		dentry->d_flags &= ~DCACHE_REFERENCED;
+		spin_unlock(&dentry->d_lock);
+		return LRU_ROTATE;
+	}
+
+	d_lru_shrink_move(lru, dentry, freeable);
+	spin_unlock(&dentry->d_lock);
+
+	return LRU_REMOVED;
+}
+
+static void prune_negative_one_sb(struct super_block *sb, void *arg)
+{
+	unsigned long *pruned = arg;
+	LIST_HEAD(dispose);
+
+	*pruned += list_lru_walk(&sb->s_dentry_lru,
+				 dentry_lru_isolate_negative, &dispose,
+				 NEG_DENTRY_BATCH);
+	shrink_dentry_list(&dispose);
+}
+
+static void prune_negative_dentries(struct work_struct *work)
+{
+	unsigned long limit = READ_ONCE(sysctl_negative_dentry_limit);
+	unsigned long pruned = 0;
+
+	if (!limit || get_nr_dentry_negative() <= limit)
+		return;
+
+	iterate_supers(prune_negative_one_sb, &pruned);
+
+	/*
+	 * Requeue ourselves while still over the limit, but only if this
+	 * pass freed something, so a limit that cannot be met (e.g. all
+	 * remaining negative dentries are in use) does not spin.
+	 */
+	if (pruned &&
+	    get_nr_dentry_negative() > READ_ONCE(sysctl_negative_dentry_limit))
+		schedule_work(&negative_prune_work);
+}
+
 /**
  * prune_dcache_sb - shrink the dcache
  * @sb: superblock
@@ -181,9 +181,9 @@ static __poll_t eventfd_poll(struct file *file, poll_table *wait)
 	return events;
 }
 
-static void eventfd_ctx_do_read(struct eventfd_ctx *ctx, __u64 *cnt)
+static void eventfd_ctx_do_read(struct eventfd_ctx *ctx, __u64 *cnt, __u64 max)
 {
-	*cnt = (ctx->flags & EFD_SEMAPHORE) ? 1 : ctx->count;
+	*cnt = (ctx->flags & EFD_SEMAPHORE) ? min(max, ctx->count) : ctx->count;
 	ctx->count -= *cnt;
 }
 
@@ -206,7 +206,7 @@ int eventfd_ctx_remove_wait_queue(struct eventfd_ctx *ctx, wait_queue_entry_t *w
 	unsigned long flags;
 
 	spin_lock_irqsave(&ctx->wqh.lock, flags);
-	eventfd_ctx_do_read(ctx, cnt);
+	eventfd_ctx_do_read(ctx, cnt, 1);
 	__remove_wait_queue(&ctx->wqh, wait);
 	if (*cnt != 0 && waitqueue_active(&ctx->wqh))
 		wake_up_locked_poll(&ctx->wqh, EPOLLOUT);
@@ -222,11 +222,22 @@ static ssize_t eventfd_read(struct file *file, char __user *buf, size_t count,
 	struct eventfd_ctx *ctx = file->private_data;
 	ssize_t res;
 	__u64 ucnt = 0;
+	__u64 max = 1;
 	DECLARE_WAITQUEUE(wait, current);
 
 	if (count < sizeof(ucnt))
 		return -EINVAL;
 
+	/*
+	 * In batch mode the read(2) buffer size tells us how many counts
+	 * the caller is prepared to consume in one go: a buffer of
+	 * N * sizeof(__u64) dequeues up to N counts, and the number
+	 * actually dequeued is returned as the __u64 value.  Callers
+	 * passing the classic 8 byte buffer get the old semantics.
+	 */
+	if (ctx->flags & EFD_BATCH)
+		max = count / sizeof(ucnt);
+
 	spin_lock_irq(&ctx->wqh.lock);
 	res = -EAGAIN;
 	if (ctx->count > 0)
@@ -251,7 +262,7 @@ static ssize_t eventfd_read(struct file *file, char __user *buf, size_t count,
 		__set_current_state(TASK_RUNNING);
 	}
 	if (likely(res > 0)) {
-		eventfd_ctx_do_read(ctx, &ucnt);
+		eventfd_ctx_do_read(ctx, &ucnt, max);
 		if (waitqueue_active(&ctx->wqh))
 			wake_up_locked_poll(&ctx->wqh, EPOLLOUT);
 	}
@@ -414,6 +425,9 @@ static int do_eventfd(unsigned int count, int flags)
 
 	if (flags & ~EFD_FLAGS_SET)
 		return -EINVAL;
+	/* Batching the counter only makes sense in semaphore mode. */
+	if ((flags & EFD_BATCH) && !(flags & EFD_SEMAPHORE))
+		return -EINVAL;
 
 	ctx = kmalloc(sizeof(*ctx), GFP_KERNEL);
 	if (!ctx)
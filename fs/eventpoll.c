@@ -36,6 +36,7 @@
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 #include <linux/compat.h>
+#include <linux/vmalloc.h>
 #include <linux/rculist.h>
 #include <net/busy_poll.h>
 
@@ -224,7 +225,20 @@ struct eventpoll {
 #ifdef CONFIG_NET_RX_BUSY_POLL
 	/* used to track busy poll napi_id */
 	unsigned int napi_id;
+	/* busy poll timeout in usecs, 0 means use the global sysctl */
+	u32 busy_poll_usecs;
+	/* busy poll packet budget, 0 means use the default */
+	u16 busy_poll_budget;
 #endif
+
+	/*
+	 * mmap'd ready-event ring (EPOLL_RING mode), NULL otherwise.
+	 * The producer index is mirrored in ring_tail so a misbehaving
+	 * consumer scribbling on the mapping cannot confuse the kernel.
+	 */
+	struct epoll_ring_header *ring;
+	unsigned int ring_entries;
+	u32 ring_tail;
 };
 
 /* Wait structure used by the poll hooks */
@@ -382,9 +396,25 @@ static inline int ep_events_available(struct eventpoll *ep)
 }
 
 #ifdef CONFIG_NET_RX_BUSY_POLL
+/* Busy polling is on for this instance either when it has its own
+ * timeout set through EPIOCSPARAMS, or when the global sysctl is set.
+ */
+static bool ep_busy_loop_on(struct eventpoll *ep)
+{
+	return !!READ_ONCE(ep->busy_poll_usecs) || net_busy_loop_on();
+}
+
 static bool ep_busy_loop_end(void *p, unsigned long start_time)
 {
 	struct eventpoll *ep = p;
+	unsigned long bp_usec = READ_ONCE(ep->busy_poll_usecs);
+
+	if (bp_usec) {
+		unsigned long end_time = start_time + bp_usec;
+		unsigned long now = busy_loop_current_time();
+
+		return ep_events_available(ep) || time_after(now, end_time);
+	}
 
 	return ep_events_available(ep) || busy_loop_timeout(start_time);
 }
@@ -398,9 +428,14 @@ static bool ep_busy_loop_end(void *p, unsigned long start_time)
 static void ep_busy_loop(struct eventpoll *ep, int nonblock)
 {
 	unsigned int napi_id = READ_ONCE(ep->napi_id);
+	u16 budget = READ_ONCE(ep->busy_poll_budget);
 
-	if ((napi_id >= MIN_NAPI_ID) && net_busy_loop_on())
-		napi_busy_loop(napi_id, nonblock ? NULL : ep_busy_loop_end, ep);
+	if (!budget)
+		budget = BUSY_POLL_BUDGET;
+
+	if ((napi_id >= MIN_NAPI_ID) && ep_busy_loop_on(ep))
+		napi_busy_loop(napi_id, nonblock ? NULL : ep_busy_loop_end, ep,
+			       budget);
 }
 
 static inline void ep_reset_busy_poll_napi_id(struct eventpoll *ep)
@@ -420,7 +455,7 @@ static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 	struct sock *sk;
 	int err;
 
-	if (!net_busy_loop_on())
+	if (!ep_busy_loop_on(epi->ep))
 		return;
 
 	sock = sock_from_file(epi->ffd.file, &err);
@@ -445,6 +480,50 @@ static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 	ep->napi_id = napi_id;
 }
 
+static long ep_eventpoll_bp_ioctl(struct file *file, unsigned int cmd,
+				  unsigned long arg)
+{
+	struct eventpoll *ep = file->private_data;
+	void __user *uarg = (void __user *)arg;
+	struct epoll_params epoll_params;
+
+	switch (cmd) {
+	case EPIOCSPARAMS:
+		if (copy_from_user(&epoll_params, uarg, sizeof(epoll_params)))
+			return -EFAULT;
+
+		/* pad byte must be zero */
+		if (epoll_params.__pad)
+			return -EINVAL;
+
+		if (epoll_params.busy_poll_usecs > S32_MAX)
+			return -EINVAL;
+
+		/* No irq deferral here, so a preference for busy polling
+		 * over interrupts cannot be honoured.
+		 */
+		if (epoll_params.prefer_busy_poll)
+			return -EINVAL;
+
+		if (epoll_params.busy_poll_budget > NAPI_POLL_WEIGHT &&
+		    !capable(CAP_NET_ADMIN))
+			return -EPERM;
+
+		WRITE_ONCE(ep->busy_poll_usecs, epoll_params.busy_poll_usecs);
+		WRITE_ONCE(ep->busy_poll_budget, epoll_params.busy_poll_budget);
+		return 0;
+	case EPIOCGPARAMS:
+		memset(&epoll_params, 0, sizeof(epoll_params));
+		epoll_params.busy_poll_usecs = READ_ONCE(ep->busy_poll_usecs);
+		epoll_params.busy_poll_budget = READ_ONCE(ep->busy_poll_budget);
+		if (copy_to_user(uarg, &epoll_params, sizeof(epoll_params)))
+			return -EFAULT;
+		return 0;
+	default:
+		return -ENOIOCTLCMD;
+	}
+}
+
 #else
 
 static inline void ep_busy_loop(struct eventpoll *ep, int nonblock)
@@ -459,6 +538,12 @@ static inline void ep_set_busy_poll_napi_id(struct epitem *epi)
 {
 }
 
+static long ep_eventpoll_bp_ioctl(struct file *file, unsigned int cmd,
+				  unsigned long arg)
+{
+	return -EOPNOTSUPP;
+}
+
 #endif /* CONFIG_NET_RX_BUSY_POLL */
 
 /**
@@ -809,6 +894,54 @@ static int ep_remove(struct eventpoll *ep, struct epitem *epi)
 	return 0;
 }
 
+/* Number of event slots in an EPOLL_RING mapping */
+#define EP_RING_ENTRIES 1024
+
+static size_t ep_ring_size(struct eventpoll *ep)
+{
+	return sizeof(*ep->ring) +
+		(size_t)ep->ring_entries * sizeof(struct epoll_event);
+}
+
+static int ep_ring_alloc(struct eventpoll *ep)
+{
+	struct epoll_ring_header *ring;
+
+	ep->ring_entries = EP_RING_ENTRIES;
+	ring = vmalloc_user(ep_ring_size(ep));
+	if (!ring)
+		return -ENOMEM;
+
+	ring->mask = ep->ring_entries - 1;
+	ep->ring = ring;
+
+	return 0;
+}
+
+/*
+ * Publish one event into the ring. Called under ep->mtx from
+ * ep_send_events_proc(), so there is a single producer. Only the
+ * consumer index is read from the shared page; everything else the
+ * kernel relies on lives in the eventpoll structure.
+ */
+static bool ep_ring_publish(struct eventpoll *ep, __poll_t revents, __u64 data)
+{
+	struct epoll_ring_header *ring = ep->ring;
+	u32 tail = ep->ring_tail;
+	u32 idx = tail & (ep->ring_entries - 1);
+
+	if (tail - READ_ONCE(ring->head) >= ep->ring_entries)
+		return false;
+
+	ring->events[idx].events = revents;
+	ring->events[idx].data = data;
+	ep->ring_tail = tail + 1;
+	/* order the entry store before the index update */
+	smp_store_release(&ring->tail, tail + 1);
+
+	return true;
+}
+
 static void ep_free(struct eventpoll *ep)
 {
 	struct rb_node *rbp;
@@ -858,6 +991,7 @@ static void ep_free(struct eventpoll *ep)
 	mutex_destroy(&ep->mtx);
 	free_uid(ep->user);
 	wakeup_source_unregister(ep->ws);
+	vfree(ep->ring);
 	kfree(ep);
 }
 
@@ -967,6 +1101,40 @@ static void ep_show_fdinfo(struct seq_file *m, struct file *f)
 }
 #endif
 
+static int ep_eventpoll_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct eventpoll *ep = file->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+
+	if (!ep->ring)
+		return -EINVAL;
+	if (vma->vm_pgoff || size > PAGE_ALIGN(ep_ring_size(ep)))
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, ep->ring, 0);
+}
+
+static long ep_eventpoll_ioctl(struct file *file, unsigned int cmd,
+			       unsigned long arg)
+{
+	int ret;
+
+	if (!is_file_epoll(file))
+		return -EINVAL;
+
+	switch (cmd) {
+	case EPIOCSPARAMS:
+	case EPIOCGPARAMS:
+		ret = ep_eventpoll_bp_ioctl(file, cmd, arg);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	return ret;
+}
+
 /* File callbacks that implement the eventpoll file behaviour */
 static const struct file_operations eventpoll_fops = {
 #ifdef CONFIG_PROC_FS
@@ -974,6 +1142,9 @@ static const struct file_operations eventpoll_fops = {
 #endif
 	.release	= ep_eventpoll_release,
 	.poll		= ep_eventpoll_poll,
+	.mmap		= ep_eventpoll_mmap,
+	.unlocked_ioctl	= ep_eventpoll_ioctl,
+	.compat_ioctl	= compat_ptr_ioctl,
 	.llseek		= noop_llseek,
 };
 
@@ -1750,16 +1921,28 @@ static __poll_t ep_send_events_proc(struct eventpoll *ep, struct list_head *head
 		if (!revents)
 			continue;
 
-		if (__put_user(revents, &uevent->events) ||
-		    __put_user(epi->event.data, &uevent->data)) {
+		if (ep->ring) {
+			if (!ep_ring_publish(ep, revents, epi->event.data)) {
+				/*
+				 * Ring full: keep the item ready and stop.
+				 * The consumer picks it up on the next
+				 * epoll_wait() after making room.
+				 */
+				list_add(&epi->rdllink, head);
+				ep_pm_stay_awake(epi);
+				return 0;
+			}
+		} else if (__put_user(revents, &uevent->events) ||
+			   __put_user(epi->event.data, &uevent->data)) {
 			list_add(&epi->rdllink, head);
 			ep_pm_stay_awake(epi);
 			if (!esed->res)
 				esed->res = -EFAULT;
 			return 0;
+		} else {
+			uevent++;
 		}
 		esed->res++;
-		uevent++;
 		if (epi->event.events & EPOLLONESHOT)
 			epi->event.events &= EP_PRIVATE_BITS;
 		else if (!(epi->event.events & EPOLLET)) {
@@ -2053,7 +2236,7 @@ static int do_epoll_create(int flags)
 	/* Check the EPOLL_* constant for consistency.  */
 	BUILD_BUG_ON(EPOLL_CLOEXEC != O_CLOEXEC);
 
-	if (flags & ~EPOLL_CLOEXEC)
+	if (flags & ~(EPOLL_CLOEXEC | EPOLL_RING))
 		return -EINVAL;
 	/*
 	 * Create the internal data structure ("struct eventpoll").
@@ -2061,6 +2244,11 @@ static int do_epoll_create(int flags)
 	error = ep_alloc(&ep);
 	if (error < 0)
 		return error;
+	if (flags & EPOLL_RING) {
+		error = ep_ring_alloc(ep);
+		if (error < 0)
+			goto out_free_ep;
+	}
 	/*
 	 * Creates all the items needed to setup an eventpoll file. That is,
 	 * a file structure and a free file descriptor.
@@ -2272,10 +2460,6 @@ static int do_epoll_wait(int epfd, struct epoll_event __user *events,
 	if (maxevents <= 0 || maxevents > EP_MAX_EVENTS)
 		return -EINVAL;
 
-	/* Verify that the area passed by the user is writeable */
-	if (!access_ok(events, maxevents * sizeof(struct epoll_event)))
-		return -EFAULT;
-
 	/* Get the "struct file *" for the eventpoll file */
 	f = fdget(epfd);
 	if (!f.file)
@@ -2295,6 +2479,15 @@ static int do_epoll_wait(int epfd, struct epoll_event __user *events,
 	 */
 	ep = f.file->private_data;
 
+	/*
+	 * Verify that the area passed by the user is writeable. Ring mode
+	 * instances deliver through the mapping and ignore the buffer.
+	 */
+	error = -EFAULT;
+	if (!ep->ring &&
+	    !access_ok(events, maxevents * sizeof(struct epoll_event)))
+		goto error_fput;
+
 	/* Time to fish for events ... */
 	error = ep_poll(ep, events, maxevents, timeout);
 
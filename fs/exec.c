@@ -1017,6 +1017,9 @@ static int exec_mmap(struct mm_struct *mm)
 	old_mm = current->mm;
 	exec_mm_release(tsk, old_mm);
 
+	/* Drop the concurrency id held in the old mm. */
+	sched_mm_cid_exit(tsk);
+
 	if (old_mm) {
 		sync_mm_rss(old_mm);
 		/*
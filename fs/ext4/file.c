@@ -233,6 +233,51 @@ ext4_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 		return ext4_dax_write_iter(iocb, from);
 #endif
 
+	/*
+	 * An aligned overwrite of allocated, written blocks neither changes
+	 * the block mapping nor moves i_size, so it needs i_rwsem only to
+	 * keep truncate and friends away.  Take the lock shared in that case
+	 * so that overwrite DIO against the same file can be submitted in
+	 * parallel; everything that modifies the mapping (truncate,
+	 * fallocate, allocating writes) takes the lock exclusive and thus
+	 * still waits for us.
+	 */
+	if (o_direct && ext4_should_dioread_nolock(inode)) {
+		if (!inode_trylock_shared(inode)) {
+			if (iocb->ki_flags & IOCB_NOWAIT)
+				return -EAGAIN;
+			inode_lock_shared(inode);
+		}
+		ret = ext4_write_checks(iocb, from);
+		if (ret <= 0) {
+			inode_unlock_shared(inode);
+			return ret;
+		}
+		/*
+		 * Unaligned AIO needs the exclusive lock as zeroing of
+		 * partial blocks of two competing unaligned AIOs can result
+		 * in data corruption.
+		 */
+		if ((is_sync_kiocb(iocb) ||
+		     !ext4_unaligned_aio(inode, from, iocb->ki_pos)) &&
+		    ext4_overwrite_io(inode, iocb->ki_pos,
+				      iov_iter_count(from))) {
+			overwrite = 1;
+			iocb->private = &overwrite;
+			ret = __generic_file_write_iter(iocb, from);
+			inode_unlock_shared(inode);
+			if (ret > 0)
+				ret = generic_write_sync(iocb, ret);
+			return ret;
+		}
+		/*
+		 * Not a pure overwrite; restart with the exclusive lock and
+		 * redo the checks as the mapping may change once the shared
+		 * lock is dropped.
+		 */
+		inode_unlock_shared(inode);
+	}
+
 	if (!inode_trylock(inode)) {
 		if (iocb->ki_flags & IOCB_NOWAIT)
 			return -EAGAIN;
@@ -256,15 +301,10 @@ ext4_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 	}
 
 	iocb->private = &overwrite;
-	/* Check whether we do a DIO overwrite or not */
-	if (o_direct && !unaligned_aio) {
-		if (ext4_overwrite_io(inode, iocb->ki_pos, iov_iter_count(from))) {
-			if (ext4_should_dioread_nolock(inode))
-				overwrite = 1;
-		} else if (iocb->ki_flags & IOCB_NOWAIT) {
-			ret = -EAGAIN;
-			goto out;
-		}
+	if (o_direct && !unaligned_aio && (iocb->ki_flags & IOCB_NOWAIT) &&
+	    !ext4_overwrite_io(inode, iocb->ki_pos, iov_iter_count(from))) {
+		ret = -EAGAIN;
+		goto out;
 	}
 
 	ret = __generic_file_write_iter(iocb, from);
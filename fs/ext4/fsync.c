@@ -149,7 +149,16 @@ int ext4_sync_file(struct file *file, loff_t start, loff_t end, int datasync)
 	if (journal->j_flags & JBD2_BARRIER &&
 	    !jbd2_trans_will_send_data_barrier(journal, commit_tid))
 		needs_barrier = true;
-	ret = jbd2_complete_transaction(journal, commit_tid);
+	/*
+	 * In fsync-heavy steady state the transaction that last touched this
+	 * inode has usually committed already, and going through
+	 * jbd2_complete_transaction() just to find that out makes every
+	 * fsync bounce the j_state_lock cacheline.  An unlocked peek at the
+	 * commit sequence is safe: tid_geq() copes with wrap, and racing
+	 * with an in-flight commit only means taking the locked path.
+	 */
+	if (!tid_geq(READ_ONCE(journal->j_commit_sequence), commit_tid))
+		ret = jbd2_complete_transaction(journal, commit_tid);
 	if (needs_barrier) {
 	issue_flush:
 		err = blkdev_issue_flush(inode->i_sb->s_bdev, GFP_KERNEL, NULL);
@@ -3956,6 +3956,9 @@ static int ext4_fill_super(struct super_block *sb, void *data, int silent)
 		sb->s_iflags |= SB_I_CGROUPWB;
 	}
 
+	/* all xattr updates go through the VFS, so values may be cached */
+	sb->s_iflags |= SB_I_XATTR_CACHE;
+
 	sb->s_flags = (sb->s_flags & ~SB_POSIXACL) |
 		(test_opt(sb, POSIX_ACL) ? SB_POSIXACL : 0);
 
@@ -2056,6 +2056,15 @@ static long wb_do_writeback(struct bdi_writeback *wb)
 /*
  * Handle writeback of dirty data for the device backed by this bdi. Also
  * reschedules periodically and does kupdated style flushing.
+ *
+ * Exactly one instance runs per bdi_writeback: the b_io/b_more_io list
+ * splicing in queue_io(), the cursor semantics of writeback_sb_inodes()
+ * and the ->dwork state machine all assume a single writer under
+ * wb->list_lock.  Writeback concurrency therefore comes from having
+ * many bdi_writeback structs, not from threading this function: every
+ * device contributes its own bdi, and with cgroup writeback each memcg
+ * gets its own wb (and worker) per bdi, with work fanned out to them in
+ * proportion to their bandwidth share by bdi_split_work_to_wbs().
  */
 void wb_workfn(struct work_struct *work)
 {
@@ -202,13 +202,18 @@ static unsigned int fuse_req_hash(u64 unique)
 
 /**
  * A new request is available, wake fiq->waitq
+ *
+ * Drop fiq->lock before waking: the queue update is already visible by
+ * the time the reader can observe the wakeup, and this way a reader
+ * woken from fuse_dev_do_read() does not immediately pile up on a lock
+ * the waker still holds.
  */
 static void fuse_dev_wake_and_unlock(struct fuse_iqueue *fiq)
 __releases(fiq->lock)
 {
+	spin_unlock(&fiq->lock);
 	wake_up(&fiq->waitq);
 	kill_fasync(&fiq->fasync, SIGIO, POLL_IN);
-	spin_unlock(&fiq->lock);
 }
 
 const struct fuse_iqueue_ops fuse_dev_fiq_ops = {
@@ -165,6 +165,11 @@ extern void shrink_dentry_list(struct list_head *);
  */
 extern int rw_verify_area(int, struct file *, const loff_t *, size_t);
 
+/*
+ * stat.c
+ */
+extern int cp_statx(const struct kstat *stat, struct statx __user *buffer);
+
 /*
  * pipe.c
  */
@@ -72,6 +72,7 @@
 #include <linux/hugetlb.h>
 #include <linux/highmem.h>
 #include <linux/fs_struct.h>
+#include <linux/splice.h>
 
 #include <uapi/linux/io_uring.h>
 
@@ -173,6 +174,25 @@ struct async_list {
 	size_t			io_len;
 };
 
+struct io_sq_data {
+	refcount_t		refs;
+	struct mutex		lock;
+
+	/*
+	 * Rings serviced by this thread. Only modified with the thread
+	 * parked and ->ctx_lock held; the thread itself walks the list
+	 * without locking.
+	 */
+	struct mutex		ctx_lock;
+	struct list_head	ctx_list;
+
+	struct task_struct	*thread;
+	struct wait_queue_head	wait;
+	struct completion	startup;
+
+	unsigned		sq_thread_idle;
+};
+
 struct io_ring_ctx {
 	struct {
 		struct percpu_ref	refs;
@@ -208,10 +228,11 @@ struct io_ring_ctx {
 
 	/* IO offload */
 	struct workqueue_struct	*sqo_wq[2];
-	struct task_struct	*sqo_thread;	/* if using sq thread polling */
 	struct mm_struct	*sqo_mm;
-	wait_queue_head_t	sqo_wait;
-	struct completion	sqo_thread_started;
+
+	/* if using sq thread polling */
+	struct io_sq_data	*sq_data;
+	struct list_head	sqd_list;
 
 	struct {
 		unsigned		cached_cq_tail;
@@ -222,16 +243,22 @@ struct io_ring_ctx {
 		struct fasync_struct	*cq_fasync;
 		struct eventfd_ctx	*cq_ev_fd;
 		atomic_t		cq_timeouts;
+		unsigned		cq_ev_batch;
+		ktime_t			cq_ev_timeout;
+		atomic_t		cq_ev_pending;
+		struct hrtimer		cq_ev_timer;
 	} ____cacheline_aligned_in_smp;
 
 	struct io_rings	*rings;
 
 	/*
-	 * If used, fixed file set. Writers must ensure that ->refs is dead,
-	 * readers must ensure that ->refs is alive as long as the file* is
-	 * used. Only updated through io_uring_register(2).
+	 * If used, fixed file set. The table itself is only resized or torn
+	 * down with ->refs dead, but individual slots are swapped under RCU
+	 * by IORING_REGISTER_FILES_UPDATE without quiescing the ring. The
+	 * submission side must dereference slots inside an RCU read section
+	 * and grab its own reference to the file.
 	 */
-	struct file		**user_files;
+	struct file __rcu	**user_files;
 	unsigned		nr_user_files;
 
 	/* if used, fixed mapped user buffers */
@@ -344,6 +371,9 @@ struct io_kiocb {
 
 	struct fs_struct	*fs;
 
+	/* input file for IORING_OP_SPLICE, resolved at submission time */
+	struct file		*splice_file_in;
+
 	struct work_struct	work;
 	struct task_struct	*work_task;
 	struct list_head	task_list;
@@ -375,6 +405,7 @@ struct io_submit_state {
 static void io_sq_wq_submit_work(struct work_struct *work);
 static void io_cqring_fill_event(struct io_ring_ctx *ctx, u64 ki_user_data,
 				 long res);
+static enum hrtimer_restart io_cq_ev_timer_fn(struct hrtimer *timer);
 static void __io_free_req(struct io_kiocb *req);
 
 static struct kmem_cache *req_cachep;
@@ -417,10 +448,9 @@ static struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 	}
 
 	ctx->flags = p->flags;
-	init_waitqueue_head(&ctx->sqo_wait);
+	INIT_LIST_HEAD(&ctx->sqd_list);
 	init_waitqueue_head(&ctx->cq_wait);
 	init_completion(&ctx->ctx_done);
-	init_completion(&ctx->sqo_thread_started);
 	mutex_init(&ctx->uring_lock);
 	init_waitqueue_head(&ctx->wait);
 	for (i = 0; i < ARRAY_SIZE(ctx->pending_async); i++) {
@@ -435,6 +465,8 @@ static struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 	INIT_LIST_HEAD(&ctx->timeout_list);
 	INIT_LIST_HEAD(&ctx->task_list);
 	spin_lock_init(&ctx->task_lock);
+	hrtimer_init(&ctx->cq_ev_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	ctx->cq_ev_timer.function = io_cq_ev_timer_fn;
 	return ctx;
 }
 
@@ -585,8 +617,8 @@ static struct io_uring_cqe *io_get_cqring(struct io_ring_ctx *ctx)
 	return &rings->cqes[tail & ctx->cq_mask];
 }
 
-static void io_cqring_fill_event(struct io_ring_ctx *ctx, u64 ki_user_data,
-				 long res)
+static void __io_cqring_fill_event(struct io_ring_ctx *ctx, u64 ki_user_data,
+				   long res, unsigned cflags)
 {
 	struct io_uring_cqe *cqe;
 
@@ -599,36 +631,79 @@ static void io_cqring_fill_event(struct io_ring_ctx *ctx, u64 ki_user_data,
 	if (cqe) {
 		WRITE_ONCE(cqe->user_data, ki_user_data);
 		WRITE_ONCE(cqe->res, res);
-		WRITE_ONCE(cqe->flags, 0);
+		WRITE_ONCE(cqe->flags, cflags);
 	} else {
 		WRITE_ONCE(ctx->rings->cq_overflow,
 				atomic_inc_return(&ctx->cached_cq_overflow));
 	}
 }
 
-static void io_cqring_ev_posted(struct io_ring_ctx *ctx)
+static void io_cqring_fill_event(struct io_ring_ctx *ctx, u64 ki_user_data,
+				 long res)
+{
+	__io_cqring_fill_event(ctx, ki_user_data, res, 0);
+}
+
+static void io_cqring_ev_flush(struct io_ring_ctx *ctx)
 {
 	if (waitqueue_active(&ctx->wait))
 		wake_up(&ctx->wait);
-	if (waitqueue_active(&ctx->sqo_wait))
-		wake_up(&ctx->sqo_wait);
 	if (ctx->cq_ev_fd)
 		eventfd_signal(ctx->cq_ev_fd, 1);
 }
 
-static void io_cqring_add_event(struct io_ring_ctx *ctx, u64 user_data,
-				long res)
+static enum hrtimer_restart io_cq_ev_timer_fn(struct hrtimer *timer)
+{
+	struct io_ring_ctx *ctx = container_of(timer, struct io_ring_ctx,
+					       cq_ev_timer);
+
+	atomic_set(&ctx->cq_ev_pending, 0);
+	io_cqring_ev_flush(ctx);
+	return HRTIMER_NORESTART;
+}
+
+static void io_cqring_ev_posted(struct io_ring_ctx *ctx)
+{
+	/* the sqpoll thread never wants delayed notification */
+	if (ctx->sq_data && waitqueue_active(&ctx->sq_data->wait))
+		wake_up(&ctx->sq_data->wait);
+	if (ctx->cq_ev_batch) {
+		/*
+		 * Coalesce notifications until the registered batch size has
+		 * accumulated, with the timer bounding the added latency for
+		 * a partial batch.
+		 */
+		if (atomic_inc_return(&ctx->cq_ev_pending) < ctx->cq_ev_batch) {
+			if (!hrtimer_active(&ctx->cq_ev_timer))
+				hrtimer_start(&ctx->cq_ev_timer,
+					      ctx->cq_ev_timeout,
+					      HRTIMER_MODE_REL);
+			return;
+		}
+		atomic_set(&ctx->cq_ev_pending, 0);
+	}
+	io_cqring_ev_flush(ctx);
+}
+
+static void __io_cqring_add_event(struct io_ring_ctx *ctx, u64 user_data,
+				  long res, unsigned cflags)
 {
 	unsigned long flags;
 
 	spin_lock_irqsave(&ctx->completion_lock, flags);
-	io_cqring_fill_event(ctx, user_data, res);
+	__io_cqring_fill_event(ctx, user_data, res, cflags);
 	io_commit_cqring(ctx);
 	spin_unlock_irqrestore(&ctx->completion_lock, flags);
 
 	io_cqring_ev_posted(ctx);
 }
 
+static void io_cqring_add_event(struct io_ring_ctx *ctx, u64 user_data,
+				long res)
+{
+	__io_cqring_add_event(ctx, user_data, res, 0);
+}
+
 static struct io_kiocb *io_get_req(struct io_ring_ctx *ctx,
 				   struct io_submit_state *state)
 {
@@ -675,6 +750,7 @@ static struct io_kiocb *io_get_req(struct io_ring_ctx *ctx,
 	refcount_set(&req->refs, 2);
 	req->result = 0;
 	req->fs = NULL;
+	req->splice_file_in = NULL;
 	return req;
 out:
 	percpu_ref_put(&ctx->refs);
@@ -692,8 +768,10 @@ static void io_free_req_many(struct io_ring_ctx *ctx, void **reqs, int *nr)
 
 static void __io_free_req(struct io_kiocb *req)
 {
-	if (req->file && !(req->flags & REQ_F_FIXED_FILE))
+	if (req->file)
 		fput(req->file);
+	if (req->splice_file_in)
+		fput(req->splice_file_in);
 	percpu_ref_put(&req->ctx->refs);
 	kmem_cache_free(req_cachep, req);
 }
@@ -796,13 +874,14 @@ static void io_iopoll_complete(struct io_ring_ctx *ctx, unsigned int *nr_events,
 		(*nr_events)++;
 
 		if (refcount_dec_and_test(&req->refs)) {
-			/* If we're not using fixed files, we have to pair the
-			 * completion part with the file put. Use regular
-			 * completions for those, only batch free for fixed
-			 * file and non-linked commands.
+			/*
+			 * Only batch free for fixed file and non-linked
+			 * commands, everything else goes through the full
+			 * (and more expensive) io_free_req().
 			 */
 			if ((req->flags & (REQ_F_FIXED_FILE|REQ_F_LINK)) ==
 			    REQ_F_FIXED_FILE) {
+				fput(req->file);
 				reqs[to_free++] = req;
 				if (to_free == ARRAY_SIZE(reqs))
 					io_free_req_many(ctx, reqs, &to_free);
@@ -1730,6 +1809,111 @@ static int io_recvmsg(struct io_kiocb *req, const struct io_uring_sqe *sqe,
 #endif
 }
 
+static int io_accept(struct io_kiocb *req, const struct io_uring_sqe *sqe,
+		     bool force_nonblock)
+{
+#if defined(CONFIG_NET)
+	struct sockaddr __user *addr;
+	int __user *addr_len;
+	unsigned file_flags;
+	int flags, ret;
+	bool multishot;
+
+	if (unlikely(req->ctx->flags & IORING_SETUP_IOPOLL))
+		return -EINVAL;
+	if (unlikely(sqe->len || sqe->buf_index))
+		return -EINVAL;
+
+	addr = (struct sockaddr __user *) (unsigned long) READ_ONCE(sqe->addr);
+	addr_len = (int __user *) (unsigned long) READ_ONCE(sqe->off);
+	flags = READ_ONCE(sqe->accept_flags);
+	multishot = READ_ONCE(sqe->ioprio) & IORING_ACCEPT_MULTISHOT;
+	file_flags = force_nonblock ? O_NONBLOCK : 0;
+
+	do {
+		ret = __sys_accept4_file(req->file, file_flags, addr,
+					 addr_len, flags);
+		if (ret == -EAGAIN && force_nonblock)
+			return -EAGAIN;
+		if (ret == -ERESTARTSYS)
+			ret = -EINTR;
+		if (ret < 0)
+			break;
+		if (!multishot)
+			break;
+		/*
+		 * In multishot mode, keep the request alive and post one
+		 * CQE per accepted connection, tagged with IORING_CQE_F_MORE
+		 * so the application knows more completions will follow. The
+		 * final CQE (posted below on error or ring teardown) has the
+		 * flag cleared.
+		 */
+		__io_cqring_add_event(req->ctx, req->user_data, ret,
+				      IORING_CQE_F_MORE);
+	} while (!percpu_ref_is_dying(&req->ctx->refs));
+
+	/* the last accepted connection was already reported above */
+	if (multishot && ret >= 0)
+		ret = -ECANCELED;
+
+	if (ret < 0 && (req->flags & REQ_F_LINK))
+		req->flags |= REQ_F_FAIL_LINK;
+	io_cqring_add_event(req->ctx, req->user_data, ret);
+	io_put_req(req);
+	return 0;
+#else
+	return -EOPNOTSUPP;
+#endif
+}
+
+static int io_splice(struct io_kiocb *req, const struct io_uring_sqe *sqe,
+		     bool force_nonblock)
+{
+	struct file *in = req->splice_file_in;
+	struct file *out = req->file;
+	loff_t off_in, off_out;
+	loff_t *poff_in, *poff_out;
+	unsigned int flags;
+	size_t len;
+	long ret;
+
+	if (unlikely(req->ctx->flags & IORING_SETUP_IOPOLL))
+		return -EINVAL;
+	if (unlikely(sqe->ioprio))
+		return -EINVAL;
+
+	flags = READ_ONCE(sqe->splice_flags);
+	if (flags & ~SPLICE_F_ALL)
+		return -EINVAL;
+
+	/*
+	 * Splicing may block on either end no matter how the files were
+	 * opened, so always do the actual transfer from the async context.
+	 * The submitter can keep several of these in flight to pipeline
+	 * file reads with socket sends.
+	 */
+	if (force_nonblock)
+		return -EAGAIN;
+
+	len = READ_ONCE(sqe->len);
+	off_in = READ_ONCE(sqe->addr);
+	off_out = READ_ONCE(sqe->off);
+	poff_in = (off_in == -1) ? NULL : &off_in;
+	poff_out = (off_out == -1) ? NULL : &off_out;
+
+	ret = 0;
+	if (len)
+		ret = do_splice(in, poff_in, out, poff_out, len, flags);
+	if (ret == -ERESTARTSYS)
+		ret = -EINTR;
+
+	if (ret < 0 && (req->flags & REQ_F_LINK))
+		req->flags |= REQ_F_FAIL_LINK;
+	io_cqring_add_event(req->ctx, req->user_data, ret);
+	io_put_req(req);
+	return 0;
+}
+
 static void io_poll_remove_one(struct io_kiocb *req)
 {
 	struct io_poll_iocb *poll = &req->poll;
@@ -2147,6 +2331,12 @@ static int __io_submit_sqe(struct io_ring_ctx *ctx, struct io_kiocb *req,
 	case IORING_OP_RECVMSG:
 		ret = io_recvmsg(req, s->sqe, force_nonblock);
 		break;
+	case IORING_OP_ACCEPT:
+		ret = io_accept(req, s->sqe, force_nonblock);
+		break;
+	case IORING_OP_SPLICE:
+		ret = io_splice(req, s->sqe, force_nonblock);
+		break;
 	case IORING_OP_TIMEOUT:
 		ret = io_timeout(req, s->sqe);
 		break;
@@ -2412,10 +2602,24 @@ static int io_req_set_file(struct io_ring_ctx *ctx, const struct sqe_submit *s,
 		return 0;
 
 	if (flags & IOSQE_FIXED_FILE) {
+		struct file *file;
+
 		if (unlikely(!ctx->user_files ||
 		    (unsigned) fd >= ctx->nr_user_files))
 			return -EBADF;
-		req->file = ctx->user_files[fd];
+		/*
+		 * The slot may be swapped from under us by a files update,
+		 * so pin the file inside the RCU section. The updater only
+		 * drops the table reference after a grace period.
+		 */
+		rcu_read_lock();
+		file = rcu_dereference(ctx->user_files[fd]);
+		if (file)
+			get_file(file);
+		rcu_read_unlock();
+		if (unlikely(!file))
+			return -EBADF;
+		req->file = file;
 		req->flags |= REQ_F_FIXED_FILE;
 	} else {
 		if (s->needs_fixed_file)
@@ -2425,6 +2629,21 @@ static int io_req_set_file(struct io_ring_ctx *ctx, const struct sqe_submit *s,
 			return -EBADF;
 	}
 
+	/*
+	 * Splice needs its input file resolved now as well: by the time the
+	 * request runs from the async context the submitter's file table is
+	 * no longer reachable.
+	 */
+	if (s->opcode == IORING_OP_SPLICE) {
+		int fd_in = READ_ONCE(s->sqe->splice_fd_in);
+
+		if (s->needs_fixed_file)
+			return -EBADF;
+		req->splice_file_in = fget(fd_in);
+		if (unlikely(!req->splice_file_in))
+			return -EBADF;
+	}
+
 	return 0;
 }
 
@@ -2762,124 +2981,156 @@ out:
 	return submitted;
 }
 
+static int __io_sq_thread(struct io_ring_ctx *ctx, struct mm_struct **cur_mm,
+			  bool cap_entries)
+{
+	unsigned int to_submit;
+	int ret = 0;
+
+	if ((ctx->flags & IORING_SETUP_IOPOLL) && !list_empty(&ctx->poll_list)) {
+		unsigned nr_events = 0;
+
+		mutex_lock(&ctx->uring_lock);
+		if (!list_empty(&ctx->poll_list))
+			io_iopoll_getevents(ctx, &nr_events, 0);
+		mutex_unlock(&ctx->uring_lock);
+	}
+
+	to_submit = io_sqring_entries(ctx);
+	/* if we're handling multiple rings, cap submit size for fairness */
+	if (cap_entries && to_submit > 8)
+		to_submit = 8;
+
+	if (to_submit) {
+		/* Unless all new commands are FIXED regions, grab mm */
+		if (*cur_mm != ctx->sqo_mm) {
+			if (*cur_mm) {
+				unuse_mm(*cur_mm);
+				mmput(*cur_mm);
+				*cur_mm = NULL;
+			}
+			if (mmget_not_zero(ctx->sqo_mm)) {
+				use_mm(ctx->sqo_mm);
+				*cur_mm = ctx->sqo_mm;
+			}
+		}
+
+		to_submit = min(to_submit, ctx->sq_entries);
+		ret = io_submit_sqes(ctx, to_submit, *cur_mm != NULL,
+				     *cur_mm == NULL);
+
+		/* Commit SQ ring head once we've consumed all SQEs */
+		io_commit_sqring(ctx);
+	}
+
+	return ret;
+}
+
 static int io_sq_thread(void *data)
 {
-	struct io_ring_ctx *ctx = data;
+	struct io_sq_data *sqd = data;
 	struct mm_struct *cur_mm = NULL;
-	const struct cred *old_cred;
+	const struct cred *old_cred = NULL;
+	struct io_ring_ctx *ctx;
 	mm_segment_t old_fs;
-	DEFINE_WAIT(wait);
-	unsigned inflight;
 	unsigned long timeout;
+	DEFINE_WAIT(wait);
 
-	complete(&ctx->sqo_thread_started);
+	complete(&sqd->startup);
 
 	old_fs = get_fs();
 	set_fs(USER_DS);
-	old_cred = override_creds(ctx->creds);
-
-	timeout = inflight = 0;
-	while (!kthread_should_park()) {
-		bool mm_fault = false;
-		unsigned int to_submit;
-
-		if (inflight) {
-			unsigned nr_events = 0;
-
-			if (ctx->flags & IORING_SETUP_IOPOLL) {
-				/*
-				 * inflight is the count of the maximum possible
-				 * entries we submitted, but it can be smaller
-				 * if we dropped some of them. If we don't have
-				 * poll entries available, then we know that we
-				 * have nothing left to poll for. Reset the
-				 * inflight count to zero in that case.
-				 */
-				mutex_lock(&ctx->uring_lock);
-				if (!list_empty(&ctx->poll_list))
-					io_iopoll_getevents(ctx, &nr_events, 0);
-				else
-					inflight = 0;
-				mutex_unlock(&ctx->uring_lock);
-			} else {
-				/*
-				 * Normal IO, just pretend everything completed.
-				 * We don't have to poll completions for that.
-				 */
-				nr_events = inflight;
-			}
 
-			inflight -= nr_events;
-			if (!inflight)
-				timeout = jiffies + ctx->sq_thread_idle;
-		}
+	timeout = jiffies + sqd->sq_thread_idle;
+	while (!kthread_should_stop()) {
+		bool cap_entries, sqt_spin, needs_sched;
+		int ret;
 
-		to_submit = io_sqring_entries(ctx);
-		if (!to_submit) {
-			/*
-			 * Drop cur_mm before scheduling, we can't hold it for
-			 * long periods (or over schedule()). Do this before
-			 * adding ourselves to the waitqueue, as the unuse/drop
-			 * may sleep.
-			 */
+		/*
+		 * Attaching and detaching rings is serialized against us
+		 * by parking the thread, so the unlocked list walks below
+		 * are safe.
+		 */
+		if (kthread_should_park()) {
 			if (cur_mm) {
 				unuse_mm(cur_mm);
 				mmput(cur_mm);
 				cur_mm = NULL;
 			}
+			kthread_parkme();
+			if (kthread_should_stop())
+				break;
+			timeout = jiffies + sqd->sq_thread_idle;
+			continue;
+		}
 
-			/*
-			 * We're polling. If we're within the defined idle
-			 * period, then let us spin without work before going
-			 * to sleep.
-			 */
-			if (inflight || !time_after(jiffies, timeout)) {
-				cond_resched();
-				continue;
+		sqt_spin = false;
+		cap_entries = !list_is_singular(&sqd->ctx_list);
+		list_for_each_entry(ctx, &sqd->ctx_list, sqd_list) {
+			if (current_cred() != ctx->creds) {
+				if (old_cred)
+					revert_creds(old_cred);
+				old_cred = override_creds(ctx->creds);
 			}
+			ret = __io_sq_thread(ctx, &cur_mm, cap_entries);
+			if (ret > 0 || !list_empty(&ctx->poll_list))
+				sqt_spin = true;
+		}
 
-			prepare_to_wait(&ctx->sqo_wait, &wait,
-						TASK_INTERRUPTIBLE);
+		/*
+		 * Any of the rings keeping us busy extends the idle spin
+		 * period for all of them.
+		 */
+		if (sqt_spin || !time_after(jiffies, timeout)) {
+			cond_resched();
+			if (sqt_spin)
+				timeout = jiffies + sqd->sq_thread_idle;
+			continue;
+		}
 
-			/* Tell userspace we may need a wakeup call */
-			ctx->rings->sq_flags |= IORING_SQ_NEED_WAKEUP;
-			/* make sure to read SQ tail after writing flags */
-			smp_mb();
+		/*
+		 * Drop cur_mm before scheduling, we can't hold it for
+		 * long periods (or over schedule()). Do this before
+		 * adding ourselves to the waitqueue, as the unuse/drop
+		 * may sleep.
+		 */
+		if (cur_mm) {
+			unuse_mm(cur_mm);
+			mmput(cur_mm);
+			cur_mm = NULL;
+		}
 
-			to_submit = io_sqring_entries(ctx);
-			if (!to_submit) {
-				if (kthread_should_park()) {
-					finish_wait(&ctx->sqo_wait, &wait);
-					break;
-				}
-				if (signal_pending(current))
-					flush_signals(current);
-				schedule();
-				finish_wait(&ctx->sqo_wait, &wait);
+		prepare_to_wait(&sqd->wait, &wait, TASK_INTERRUPTIBLE);
 
-				ctx->rings->sq_flags &= ~IORING_SQ_NEED_WAKEUP;
-				continue;
+		/* Tell userspace we may need a wakeup call */
+		list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
+			ctx->rings->sq_flags |= IORING_SQ_NEED_WAKEUP;
+		/* make sure to read SQ tail after writing flags */
+		smp_mb();
+
+		needs_sched = !kthread_should_park();
+		list_for_each_entry(ctx, &sqd->ctx_list, sqd_list) {
+			if ((ctx->flags & IORING_SETUP_IOPOLL) &&
+			    !list_empty_careful(&ctx->poll_list)) {
+				needs_sched = false;
+				break;
 			}
-			finish_wait(&ctx->sqo_wait, &wait);
-
-			ctx->rings->sq_flags &= ~IORING_SQ_NEED_WAKEUP;
-		}
-
-		/* Unless all new commands are FIXED regions, grab mm */
-		if (!cur_mm) {
-			mm_fault = !mmget_not_zero(ctx->sqo_mm);
-			if (!mm_fault) {
-				use_mm(ctx->sqo_mm);
-				cur_mm = ctx->sqo_mm;
+			if (io_sqring_entries(ctx)) {
+				needs_sched = false;
+				break;
 			}
 		}
 
-		to_submit = min(to_submit, ctx->sq_entries);
-		inflight += io_submit_sqes(ctx, to_submit, cur_mm != NULL,
-					   mm_fault);
+		if (needs_sched) {
+			if (signal_pending(current))
+				flush_signals(current);
+			schedule();
+		}
 
-		/* Commit SQ ring head once we've consumed all SQEs */
-		io_commit_sqring(ctx);
+		finish_wait(&sqd->wait, &wait);
+		list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
+			ctx->rings->sq_flags &= ~IORING_SQ_NEED_WAKEUP;
+		timeout = jiffies + sqd->sq_thread_idle;
 	}
 
 	set_fs(old_fs);
@@ -2887,7 +3138,8 @@ static int io_sq_thread(void *data)
 		unuse_mm(cur_mm);
 		mmput(cur_mm);
 	}
-	revert_creds(old_cred);
+	if (old_cred)
+		revert_creds(old_cred);
 
 	kthread_parkme();
 
@@ -3042,6 +3294,15 @@ static int io_cqring_wait(struct io_ring_ctx *ctx, int min_events,
 	return READ_ONCE(rings->cq.head) == READ_ONCE(rings->cq.tail) ? ret : 0;
 }
 
+/*
+ * Slot accessor for paths that exclude concurrent table updates, either by
+ * holding ->uring_lock or by having quiesced the ring.
+ */
+static struct file *io_file_from_index(struct io_ring_ctx *ctx, int index)
+{
+	return rcu_dereference_protected(ctx->user_files[index], 1);
+}
+
 static void __io_sqe_files_unregister(struct io_ring_ctx *ctx)
 {
 #if defined(CONFIG_UNIX)
@@ -3055,8 +3316,12 @@ static void __io_sqe_files_unregister(struct io_ring_ctx *ctx)
 #else
 	int i;
 
-	for (i = 0; i < ctx->nr_user_files; i++)
-		fput(ctx->user_files[i]);
+	for (i = 0; i < ctx->nr_user_files; i++) {
+		struct file *file = io_file_from_index(ctx, i);
+
+		if (file)
+			fput(file);
+	}
 #endif
 }
 
@@ -3072,18 +3337,65 @@ static int io_sqe_files_unregister(struct io_ring_ctx *ctx)
 	return 0;
 }
 
+static void io_sq_thread_park(struct io_sq_data *sqd)
+	__acquires(&sqd->lock)
+{
+	mutex_lock(&sqd->lock);
+	if (sqd->thread) {
+		wait_for_completion(&sqd->startup);
+		kthread_park(sqd->thread);
+	}
+}
+
+static void io_sq_thread_unpark(struct io_sq_data *sqd)
+	__releases(&sqd->lock)
+{
+	if (sqd->thread)
+		kthread_unpark(sqd->thread);
+	mutex_unlock(&sqd->lock);
+}
+
+static void io_put_sq_data(struct io_sq_data *sqd)
+{
+	if (refcount_dec_and_test(&sqd->refs)) {
+		if (sqd->thread) {
+			wait_for_completion(&sqd->startup);
+			/*
+			 * The park is a bit of a work-around, without it we
+			 * get warning spews on shutdown with SQPOLL set and
+			 * affinity set to a single CPU.
+			 */
+			kthread_park(sqd->thread);
+			kthread_stop(sqd->thread);
+		}
+		kfree(sqd);
+	}
+}
+
+static void io_sqd_update_thread_idle(struct io_sq_data *sqd)
+{
+	struct io_ring_ctx *ctx;
+	unsigned sq_thread_idle = 0;
+
+	list_for_each_entry(ctx, &sqd->ctx_list, sqd_list)
+		sq_thread_idle = max(sq_thread_idle, ctx->sq_thread_idle);
+	sqd->sq_thread_idle = sq_thread_idle;
+}
+
 static void io_sq_thread_stop(struct io_ring_ctx *ctx)
 {
-	if (ctx->sqo_thread) {
-		wait_for_completion(&ctx->sqo_thread_started);
-		/*
-		 * The park is a bit of a work-around, without it we get
-		 * warning spews on shutdown with SQPOLL set and affinity
-		 * set to a single CPU.
-		 */
-		kthread_park(ctx->sqo_thread);
-		kthread_stop(ctx->sqo_thread);
-		ctx->sqo_thread = NULL;
+	struct io_sq_data *sqd = ctx->sq_data;
+
+	if (sqd) {
+		io_sq_thread_park(sqd);
+		mutex_lock(&sqd->ctx_lock);
+		list_del_init(&ctx->sqd_list);
+		io_sqd_update_thread_idle(sqd);
+		mutex_unlock(&sqd->ctx_lock);
+		io_sq_thread_unpark(sqd);
+
+		io_put_sq_data(sqd);
+		ctx->sq_data = NULL;
 	}
 }
 
@@ -3141,7 +3453,7 @@ static int __io_sqe_files_scm(struct io_ring_ctx *ctx, int nr, int offset)
 
 	fpl->user = get_uid(ctx->user);
 	for (i = 0; i < nr; i++) {
-		fpl->fp[i] = get_file(ctx->user_files[i + offset]);
+		fpl->fp[i] = get_file(io_file_from_index(ctx, i + offset));
 		unix_inflight(fpl->user, fpl->fp[i]);
 	}
 
@@ -3182,7 +3494,7 @@ static int io_sqe_files_scm(struct io_ring_ctx *ctx)
 		return 0;
 
 	while (total < ctx->nr_user_files) {
-		fput(ctx->user_files[total]);
+		fput(io_file_from_index(ctx, total));
 		total++;
 	}
 
@@ -3214,14 +3526,16 @@ static int io_sqe_files_register(struct io_ring_ctx *ctx, void __user *arg,
 		return -ENOMEM;
 
 	for (i = 0; i < nr_args; i++) {
+		struct file *file;
+
 		ret = -EFAULT;
 		if (copy_from_user(&fd, &fds[i], sizeof(fd)))
 			break;
 
-		ctx->user_files[i] = fget(fd);
+		file = fget(fd);
 
 		ret = -EBADF;
-		if (!ctx->user_files[i])
+		if (!file)
 			break;
 		/*
 		 * Don't allow io_uring instances to be registered. If UNIX
@@ -3230,17 +3544,18 @@ static int io_sqe_files_register(struct io_ring_ctx *ctx, void __user *arg,
 		 * handle it just fine, but there's still no point in allowing
 		 * a ring fd as it doesn't support regular read/write anyway.
 		 */
-		if (ctx->user_files[i]->f_op == &io_uring_fops) {
-			fput(ctx->user_files[i]);
+		if (file->f_op == &io_uring_fops) {
+			fput(file);
 			break;
 		}
+		rcu_assign_pointer(ctx->user_files[i], file);
 		ctx->nr_user_files++;
 		ret = 0;
 	}
 
 	if (ret) {
 		for (i = 0; i < ctx->nr_user_files; i++)
-			fput(ctx->user_files[i]);
+			fput(io_file_from_index(ctx, i));
 
 		kfree(ctx->user_files);
 		ctx->user_files = NULL;
@@ -3255,6 +3570,234 @@ static int io_sqe_files_register(struct io_ring_ctx *ctx, void __user *arg,
 	return ret;
 }
 
+/*
+ * Make the UNIX gc aware of a single file added by a files update. Try to
+ * merge the file into an existing SCM_RIGHTS skb, and fall back to a new
+ * skb if there's no room left. In both cases the skb ends up owning the
+ * table reference that the caller acquired with fget().
+ */
+static int io_sqe_file_register(struct io_ring_ctx *ctx, struct file *file,
+				int index)
+{
+#if defined(CONFIG_UNIX)
+	struct sock *sock = ctx->ring_sock->sk;
+	struct sk_buff_head *head = &sock->sk_receive_queue;
+	struct sk_buff *skb;
+
+	spin_lock_irq(&head->lock);
+	skb = skb_peek(head);
+	if (skb) {
+		struct scm_fp_list *fpl = UNIXCB(skb).fp;
+
+		if (fpl->count < SCM_MAX_FD) {
+			__skb_unlink(skb, head);
+			spin_unlock_irq(&head->lock);
+			fpl->fp[fpl->count] = file;
+			unix_inflight(fpl->user, file);
+			fpl->count++;
+			spin_lock_irq(&head->lock);
+			__skb_queue_head(head, skb);
+		} else {
+			skb = NULL;
+		}
+	}
+	spin_unlock_irq(&head->lock);
+
+	if (skb)
+		return 0;
+
+	return __io_sqe_files_scm(ctx, 1, index);
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Drop the table reference of a file removed by a files update. With UNIX
+ * sockets enabled that reference lives in an SCM_RIGHTS skb, so find the
+ * fragment, take it out of flight and put it.
+ */
+static void io_ring_file_put(struct io_ring_ctx *ctx, struct file *file)
+{
+#if defined(CONFIG_UNIX)
+	struct sock *sock = ctx->ring_sock->sk;
+	struct sk_buff_head list, *head = &sock->sk_receive_queue;
+	struct sk_buff *skb;
+	int i;
+
+	__skb_queue_head_init(&list);
+
+	skb = skb_dequeue(head);
+	while (skb) {
+		struct scm_fp_list *fp = UNIXCB(skb).fp;
+
+		for (i = 0; i < fp->count; i++) {
+			int left;
+
+			if (fp->fp[i] != file)
+				continue;
+
+			unix_notinflight(fp->user, fp->fp[i]);
+			left = fp->count - 1 - i;
+			if (left)
+				memmove(&fp->fp[i], &fp->fp[i + 1],
+					left * sizeof(struct file *));
+			fp->count--;
+			if (!fp->count) {
+				kfree_skb(skb);
+				skb = NULL;
+			} else {
+				__skb_queue_tail(&list, skb);
+			}
+			fput(file);
+			file = NULL;
+			break;
+		}
+
+		if (!file)
+			break;
+
+		__skb_queue_tail(&list, skb);
+
+		skb = skb_dequeue(head);
+	}
+
+	if (skb_peek(&list)) {
+		spin_lock_irq(&head->lock);
+		while ((skb = __skb_dequeue(&list)) != NULL)
+			__skb_queue_tail(head, skb);
+		spin_unlock_irq(&head->lock);
+	}
+#else
+	fput(file);
+#endif
+}
+
+/*
+ * Swap individual slots of the registered file table without quiescing the
+ * ring. The submission side only looks at slots under rcu_read_lock() and
+ * pins the file before use, so a single grace period after the swaps is
+ * enough before the old table references can be dropped.
+ */
+static int io_sqe_files_update(struct io_ring_ctx *ctx, void __user *arg,
+			       unsigned nr_args)
+{
+	struct io_uring_files_update up;
+	struct file **old_files;
+	__s32 __user *fds;
+	int fd, err = 0;
+	__u32 done, i;
+
+	if (!ctx->user_files)
+		return -ENXIO;
+	if (!nr_args)
+		return -EINVAL;
+	if (copy_from_user(&up, arg, sizeof(up)))
+		return -EFAULT;
+	if (up.resv)
+		return -EINVAL;
+	if (check_add_overflow(up.offset, nr_args, &done))
+		return -EOVERFLOW;
+	if (done > ctx->nr_user_files)
+		return -EINVAL;
+
+	old_files = kcalloc(nr_args, sizeof(struct file *), GFP_KERNEL);
+	if (!old_files)
+		return -ENOMEM;
+
+	fds = u64_to_user_ptr(up.fds);
+	for (done = 0; done < nr_args; done++) {
+		unsigned index = up.offset + done;
+		struct file *file;
+
+		if (copy_from_user(&fd, &fds[done], sizeof(fd))) {
+			err = -EFAULT;
+			break;
+		}
+		old_files[done] = io_file_from_index(ctx, index);
+		if (fd == -1) {
+			rcu_assign_pointer(ctx->user_files[index], NULL);
+			continue;
+		}
+		file = fget(fd);
+		if (!file) {
+			err = -EBADF;
+			break;
+		}
+		/* same reference cycle concern as io_sqe_files_register() */
+		if (file->f_op == &io_uring_fops) {
+			fput(file);
+			err = -EBADF;
+			break;
+		}
+		rcu_assign_pointer(ctx->user_files[index], file);
+		err = io_sqe_file_register(ctx, file, index);
+		if (err) {
+			rcu_assign_pointer(ctx->user_files[index],
+					   old_files[done]);
+			old_files[done] = NULL;
+			fput(file);
+			break;
+		}
+	}
+
+	if (done) {
+		synchronize_rcu();
+		for (i = 0; i < done; i++) {
+			if (old_files[i])
+				io_ring_file_put(ctx, old_files[i]);
+		}
+	}
+	kfree(old_files);
+	return done ? done : err;
+}
+
+static struct io_sq_data *io_attach_sq_data(struct io_uring_params *p)
+{
+	struct io_ring_ctx *ctx_attach;
+	struct io_sq_data *sqd;
+	struct fd f;
+
+	f = fdget(p->wq_fd);
+	if (!f.file)
+		return ERR_PTR(-ENXIO);
+	if (f.file->f_op != &io_uring_fops) {
+		fdput(f);
+		return ERR_PTR(-EINVAL);
+	}
+
+	ctx_attach = f.file->private_data;
+	sqd = ctx_attach->sq_data;
+	if (!sqd) {
+		fdput(f);
+		return ERR_PTR(-EINVAL);
+	}
+
+	refcount_inc(&sqd->refs);
+	fdput(f);
+	return sqd;
+}
+
+static struct io_sq_data *io_get_sq_data(struct io_uring_params *p)
+{
+	struct io_sq_data *sqd;
+
+	if (p->flags & IORING_SETUP_ATTACH_WQ)
+		return io_attach_sq_data(p);
+
+	sqd = kzalloc(sizeof(*sqd), GFP_KERNEL);
+	if (!sqd)
+		return ERR_PTR(-ENOMEM);
+
+	refcount_set(&sqd->refs, 1);
+	INIT_LIST_HEAD(&sqd->ctx_list);
+	mutex_init(&sqd->ctx_lock);
+	mutex_init(&sqd->lock);
+	init_waitqueue_head(&sqd->wait);
+	init_completion(&sqd->startup);
+	return sqd;
+}
+
 static int io_sq_offload_start(struct io_ring_ctx *ctx,
 			       struct io_uring_params *p)
 {
@@ -3264,14 +3807,34 @@ static int io_sq_offload_start(struct io_ring_ctx *ctx,
 	ctx->sqo_mm = current->mm;
 
 	if (ctx->flags & IORING_SETUP_SQPOLL) {
+		struct io_sq_data *sqd;
+
 		ret = -EPERM;
 		if (!capable(CAP_SYS_ADMIN))
 			goto err;
 
+		sqd = io_get_sq_data(p);
+		if (IS_ERR(sqd)) {
+			ret = PTR_ERR(sqd);
+			goto err;
+		}
+		ctx->sq_data = sqd;
+
 		ctx->sq_thread_idle = msecs_to_jiffies(p->sq_thread_idle);
 		if (!ctx->sq_thread_idle)
 			ctx->sq_thread_idle = HZ;
 
+		io_sq_thread_park(sqd);
+		mutex_lock(&sqd->ctx_lock);
+		list_add_tail(&ctx->sqd_list, &sqd->ctx_list);
+		io_sqd_update_thread_idle(sqd);
+		mutex_unlock(&sqd->ctx_lock);
+		io_sq_thread_unpark(sqd);
+
+		/* attached to an already running thread, nothing to start */
+		if (sqd->thread)
+			goto done;
+
 		if (p->flags & IORING_SETUP_SQ_AFF) {
 			int cpu = p->sq_thread_cpu;
 
@@ -3281,25 +3844,26 @@ static int io_sq_offload_start(struct io_ring_ctx *ctx,
 			if (!cpu_online(cpu))
 				goto err;
 
-			ctx->sqo_thread = kthread_create_on_cpu(io_sq_thread,
-							ctx, cpu,
+			sqd->thread = kthread_create_on_cpu(io_sq_thread,
+							sqd, cpu,
 							"io_uring-sq");
 		} else {
-			ctx->sqo_thread = kthread_create(io_sq_thread, ctx,
+			sqd->thread = kthread_create(io_sq_thread, sqd,
 							"io_uring-sq");
 		}
-		if (IS_ERR(ctx->sqo_thread)) {
-			ret = PTR_ERR(ctx->sqo_thread);
-			ctx->sqo_thread = NULL;
+		if (IS_ERR(sqd->thread)) {
+			ret = PTR_ERR(sqd->thread);
+			sqd->thread = NULL;
 			goto err;
 		}
-		wake_up_process(ctx->sqo_thread);
+		wake_up_process(sqd->thread);
 	} else if (p->flags & IORING_SETUP_SQ_AFF) {
 		/* Can't have SQ_AFF without SQPOLL */
 		ret = -EINVAL;
 		goto err;
 	}
 
+done:
 	/* Do QD, or 2 * CPUS, whatever is smallest */
 	ctx->sqo_wq[0] = alloc_workqueue("io_ring-wq",
 			WQ_UNBOUND | WQ_FREEZABLE,
@@ -3628,6 +4192,27 @@ static int io_eventfd_register(struct io_ring_ctx *ctx, void __user *arg)
 	return 0;
 }
 
+static int io_cq_ev_batch_register(struct io_ring_ctx *ctx, void __user *arg)
+{
+	struct io_uring_cq_ev_batch batch;
+
+	if (copy_from_user(&batch, arg, sizeof(batch)))
+		return -EFAULT;
+	if (batch.resv)
+		return -EINVAL;
+	if (batch.batch > ctx->cq_entries)
+		return -EINVAL;
+	/* a partial batch must always be flushed in bounded time */
+	if (batch.batch > 1 && !batch.timeout_us)
+		return -EINVAL;
+
+	hrtimer_cancel(&ctx->cq_ev_timer);
+	ctx->cq_ev_batch = batch.batch > 1 ? batch.batch : 0;
+	ctx->cq_ev_timeout = (u64)batch.timeout_us * NSEC_PER_USEC;
+	atomic_set(&ctx->cq_ev_pending, 0);
+	return 0;
+}
+
 static int io_eventfd_unregister(struct io_ring_ctx *ctx)
 {
 	if (ctx->cq_ev_fd) {
@@ -3642,6 +4227,7 @@ static int io_eventfd_unregister(struct io_ring_ctx *ctx)
 static void io_ring_ctx_free(struct io_ring_ctx *ctx)
 {
 	io_finish_async(ctx);
+	hrtimer_cancel(&ctx->cq_ev_timer);
 	if (ctx->sqo_mm)
 		mmdrop(ctx->sqo_mm);
 
@@ -3811,7 +4397,7 @@ SYSCALL_DEFINE6(io_uring_enter, unsigned int, fd, u32, to_submit,
 	ret = 0;
 	if (ctx->flags & IORING_SETUP_SQPOLL) {
 		if (flags & IORING_ENTER_SQ_WAKEUP)
-			wake_up(&ctx->sqo_wait);
+			wake_up(&ctx->sq_data->wait);
 		submitted = to_submit;
 	} else if (to_submit) {
 		to_submit = min(to_submit, ctx->sq_entries);
@@ -4044,7 +4630,7 @@ static long io_uring_setup(u32 entries, struct io_uring_params __user *params)
 	}
 
 	if (p.flags & ~(IORING_SETUP_IOPOLL | IORING_SETUP_SQPOLL |
-			IORING_SETUP_SQ_AFF))
+			IORING_SETUP_SQ_AFF | IORING_SETUP_ATTACH_WQ))
 		return -EINVAL;
 
 	ret = io_uring_create(entries, &p);
@@ -4063,6 +4649,16 @@ SYSCALL_DEFINE2(io_uring_setup, u32, entries,
 	return io_uring_setup(entries, params);
 }
 
+static bool io_register_op_must_quiesce(unsigned opcode)
+{
+	switch (opcode) {
+	case IORING_REGISTER_FILES_UPDATE:
+		return false;
+	default:
+		return true;
+	}
+}
+
 static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			       void __user *arg, unsigned nr_args)
 	__releases(ctx->uring_lock)
@@ -4078,18 +4674,21 @@ static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 	if (percpu_ref_is_dying(&ctx->refs))
 		return -ENXIO;
 
-	percpu_ref_kill(&ctx->refs);
+	if (io_register_op_must_quiesce(opcode)) {
+		percpu_ref_kill(&ctx->refs);
 
-	/*
-	 * Drop uring mutex before waiting for references to exit. If another
-	 * thread is currently inside io_uring_enter() it might need to grab
-	 * the uring_lock to make progress. If we hold it here across the drain
-	 * wait, then we can deadlock. It's safe to drop the mutex here, since
-	 * no new references will come in after we've killed the percpu ref.
-	 */
-	mutex_unlock(&ctx->uring_lock);
-	wait_for_completion(&ctx->ctx_done);
-	mutex_lock(&ctx->uring_lock);
+		/*
+		 * Drop uring mutex before waiting for references to exit. If
+		 * another thread is currently inside io_uring_enter() it might
+		 * need to grab the uring_lock to make progress. If we hold it
+		 * here across the drain wait, then we can deadlock. It's safe
+		 * to drop the mutex here, since no new references will come in
+		 * after we've killed the percpu ref.
+		 */
+		mutex_unlock(&ctx->uring_lock);
+		wait_for_completion(&ctx->ctx_done);
+		mutex_lock(&ctx->uring_lock);
+	}
 
 	switch (opcode) {
 	case IORING_REGISTER_BUFFERS:
@@ -4110,6 +4709,9 @@ static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			break;
 		ret = io_sqe_files_unregister(ctx);
 		break;
+	case IORING_REGISTER_FILES_UPDATE:
+		ret = io_sqe_files_update(ctx, arg, nr_args);
+		break;
 	case IORING_REGISTER_EVENTFD:
 		ret = -EINVAL;
 		if (nr_args != 1)
@@ -4122,14 +4724,22 @@ static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			break;
 		ret = io_eventfd_unregister(ctx);
 		break;
+	case IORING_REGISTER_CQ_EV_BATCH:
+		ret = -EINVAL;
+		if (nr_args != 1)
+			break;
+		ret = io_cq_ev_batch_register(ctx, arg);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
 	}
 
-	/* bring the ctx back to life */
-	reinit_completion(&ctx->ctx_done);
-	percpu_ref_reinit(&ctx->refs);
+	if (io_register_op_must_quiesce(opcode)) {
+		/* bring the ctx back to life */
+		reinit_completion(&ctx->ctx_done);
+		percpu_ref_reinit(&ctx->refs);
+	}
 	return ret;
 }
 
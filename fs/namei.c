@@ -1544,6 +1544,91 @@ static struct dentry *__lookup_hash(const struct qstr *name,
 	return dentry;
 }
 
+/*
+ * Parallel dirops: filesystems that set FS_ALLOW_PAR_DIROPS take care of
+ * the internal consistency of concurrent updates themselves, so the VFS
+ * only holds the directory lock shared for create and unlink and instead
+ * serializes updates of one particular name with a per-dentry bit lock.
+ */
+static inline bool dir_allows_par_dirops(const struct inode *dir)
+{
+	return dir->i_sb->s_type->fs_flags & FS_ALLOW_PAR_DIROPS;
+}
+
+static void lock_dentry_update(struct dentry *dentry)
+{
+	spin_lock(&dentry->d_lock);
+	while (dentry->d_flags & DCACHE_PAR_UPDATE) {
+		spin_unlock(&dentry->d_lock);
+		wait_var_event(&dentry->d_flags,
+			       !(READ_ONCE(dentry->d_flags) &
+				 DCACHE_PAR_UPDATE));
+		spin_lock(&dentry->d_lock);
+	}
+	dentry->d_flags |= DCACHE_PAR_UPDATE;
+	spin_unlock(&dentry->d_lock);
+}
+
+static void unlock_dentry_update(struct dentry *dentry)
+{
+	spin_lock(&dentry->d_lock);
+	WARN_ON_ONCE(!(dentry->d_flags & DCACHE_PAR_UPDATE));
+	dentry->d_flags &= ~DCACHE_PAR_UPDATE;
+	spin_unlock(&dentry->d_lock);
+	wake_up_var(&dentry->d_flags);
+}
+
+/*
+ * Like __lookup_hash(), but usable with the directory lock only held
+ * shared: allocation of a new dentry goes through d_alloc_parallel() so
+ * concurrent lookups of the same name cannot install a second copy, and
+ * the returned dentry has DCACHE_PAR_UPDATE set. The caller must drop it
+ * with unlock_dentry_update() after the update (or its failure).
+ */
+static struct dentry *lookup_hash_update(const struct qstr *name,
+					 struct dentry *base,
+					 unsigned int flags)
+{
+	struct inode *dir = base->d_inode;
+	struct dentry *dentry;
+	DECLARE_WAIT_QUEUE_HEAD_ONSTACK(wq);
+
+	dentry = d_lookup(base, name);
+	for (;;) {
+		if (!dentry) {
+			/* Don't create child dentry for a dead directory. */
+			if (unlikely(IS_DEADDIR(dir)))
+				return ERR_PTR(-ENOENT);
+
+			dentry = d_alloc_parallel(base, name, &wq);
+			if (IS_ERR(dentry))
+				return dentry;
+		}
+		if (d_in_lookup(dentry)) {
+			struct dentry *old;
+
+			old = dir->i_op->lookup(dir, dentry, flags);
+			d_lookup_done(dentry);
+			if (unlikely(old)) {
+				dput(dentry);
+				if (IS_ERR(old))
+					return old;
+				dentry = old;
+			}
+			break;
+		}
+
+		if (likely(d_revalidate(dentry, flags) > 0))
+			break;
+		d_invalidate(dentry);
+		dput(dentry);
+		dentry = NULL;
+	}
+
+	lock_dentry_update(dentry);
+	return dentry;
+}
+
 static int lookup_fast(struct nameidata *nd,
 		       struct path *path, struct inode **inode,
 		       unsigned *seqp)
@@ -3216,17 +3301,35 @@ no_open:
 
 	/* Negative dentry, just create the file */
 	if (!dentry->d_inode && (open_flag & O_CREAT)) {
-		file->f_mode |= FMODE_CREATED;
-		audit_inode_child(dir_inode, dentry, AUDIT_TYPE_CHILD_CREATE);
-		if (!dir_inode->i_op->create) {
-			error = -EACCES;
-			goto out_dput;
-		}
-		error = dir_inode->i_op->create(dir_inode, dentry, mode,
+		bool par_update = dir_allows_par_dirops(dir_inode);
+
+		/*
+		 * The directory may only be held shared; serialize against
+		 * another create or unlink of this name and repeat the
+		 * existence check, as we may have slept.
+		 */
+		if (par_update)
+			lock_dentry_update(dentry);
+		error = 0;
+		if (!dentry->d_inode) {
+			file->f_mode |= FMODE_CREATED;
+			audit_inode_child(dir_inode, dentry,
+					  AUDIT_TYPE_CHILD_CREATE);
+			if (!dir_inode->i_op->create)
+				error = -EACCES;
+			else
+				error = dir_inode->i_op->create(dir_inode,
+						dentry, mode,
 						open_flag & O_EXCL);
+			if (!error)
+				fsnotify_create(dir_inode, dentry);
+			else
+				file->f_mode &= ~FMODE_CREATED;
+		}
+		if (par_update)
+			unlock_dentry_update(dentry);
 		if (error)
 			goto out_dput;
-		fsnotify_create(dir_inode, dentry);
 	}
 	if (unlikely(create_error) && !dentry->d_inode) {
 		error = create_error;
@@ -3310,12 +3413,12 @@ static int do_last(struct nameidata *nd,
 		 * dropping this one anyway.
 		 */
 	}
-	if (open_flag & O_CREAT)
+	if ((open_flag & O_CREAT) && !dir_allows_par_dirops(dir->d_inode))
 		inode_lock(dir->d_inode);
 	else
 		inode_lock_shared(dir->d_inode);
 	error = lookup_open(nd, &path, file, op, got_write);
-	if (open_flag & O_CREAT)
+	if ((open_flag & O_CREAT) && !dir_allows_par_dirops(dir->d_inode))
 		inode_unlock(dir->d_inode);
 	else
 		inode_unlock_shared(dir->d_inode);
@@ -4028,6 +4131,7 @@ long do_unlinkat(int dfd, struct filename *name)
 	struct inode *inode = NULL;
 	struct inode *delegated_inode = NULL;
 	unsigned int lookup_flags = 0;
+	bool shared;
 retry:
 	name = filename_parentat(dfd, name, lookup_flags, &path, &last, &type);
 	if (IS_ERR(name))
@@ -4041,8 +4145,14 @@ retry:
 	if (error)
 		goto exit1;
 retry_deleg:
-	inode_lock_nested(path.dentry->d_inode, I_MUTEX_PARENT);
-	dentry = __lookup_hash(&last, path.dentry, lookup_flags);
+	shared = dir_allows_par_dirops(path.dentry->d_inode);
+	if (shared) {
+		inode_lock_shared_nested(path.dentry->d_inode, I_MUTEX_PARENT);
+		dentry = lookup_hash_update(&last, path.dentry, lookup_flags);
+	} else {
+		inode_lock_nested(path.dentry->d_inode, I_MUTEX_PARENT);
+		dentry = __lookup_hash(&last, path.dentry, lookup_flags);
+	}
 	error = PTR_ERR(dentry);
 	if (!IS_ERR(dentry)) {
 		/* Why not before? Because we want correct error value */
@@ -4057,9 +4167,14 @@ retry_deleg:
 			goto exit2;
 		error = vfs_unlink(path.dentry->d_inode, dentry, &delegated_inode);
 exit2:
+		if (shared)
+			unlock_dentry_update(dentry);
 		dput(dentry);
 	}
-	inode_unlock(path.dentry->d_inode);
+	if (shared)
+		inode_unlock_shared(path.dentry->d_inode);
+	else
+		inode_unlock(path.dentry->d_inode);
 	if (inode)
 		iput(inode);	/* truncate the inode here */
 	inode = NULL;
@@ -30,6 +30,7 @@
 #include <uapi/linux/mount.h>
 #include <linux/fs_context.h>
 #include <linux/shmem_fs.h>
+#include <linux/watch_queue.h>
 
 #include "pnode.h"
 #include "internal.h"
@@ -87,6 +88,21 @@ EXPORT_SYMBOL_GPL(fs_kobj);
  */
 __cacheline_aligned_in_smp DEFINE_SEQLOCK(mount_lock);
 
+static inline void lock_ns_list(struct mnt_namespace *ns)
+{
+	spin_lock(&ns->ns_lock);
+}
+
+static inline void unlock_ns_list(struct mnt_namespace *ns)
+{
+	spin_unlock(&ns->ns_lock);
+}
+
+static inline bool mnt_is_cursor(struct mount *mnt)
+{
+	return mnt->mnt.mnt_flags & MNT_CURSOR;
+}
+
 static inline struct hlist_head *m_hash(struct vfsmount *mnt, struct dentry *dentry)
 {
 	unsigned long tmp = ((unsigned long)mnt / L1_CACHE_BYTES);
@@ -673,11 +689,15 @@ bool __is_local_mountpoint(struct dentry *dentry)
 		goto out;
 
 	down_read(&namespace_sem);
+	lock_ns_list(ns);
 	list_for_each_entry(mnt, &ns->list, mnt_list) {
+		if (mnt_is_cursor(mnt))
+			continue;
 		is_covered = (mnt->mnt_mountpoint == dentry);
 		if (is_covered)
 			break;
 	}
+	unlock_ns_list(ns);
 	up_read(&namespace_sem);
 out:
 	return is_covered;
@@ -798,6 +818,89 @@ static void __touch_mnt_namespace(struct mnt_namespace *ns)
 	}
 }
 
+#ifdef CONFIG_WATCH_QUEUE
+/*
+ * Post a mount topology change notification to the watchers of a mount
+ * namespace.  Callers run in process context with the namespace pinned
+ * (it is always the caller's own namespace) and pass mount IDs rather
+ * than mounts so that no mount need stay pinned for the notification.
+ */
+static void notify_mount(struct mnt_namespace *ns, int triggered_on,
+			 int changed_mount, u32 subtype)
+{
+	struct watch_list *wlist = READ_ONCE(ns->mnt_watchers);
+	struct mount_notification n;
+
+	if (likely(!wlist))
+		return;
+
+	memset(&n, 0, sizeof(n));
+	n.watch.type = WATCH_TYPE_MOUNT_NOTIFY;
+	n.watch.subtype = subtype;
+	n.watch.info = watch_sizeof(n);
+	n.triggered_on = triggered_on;
+	n.changed_mount = changed_mount;
+
+	post_watch_notification(wlist, &n.watch);
+}
+
+/*
+ * Attach a watch on the mount topology of a namespace to the notification
+ * pipe given by @fd (IOC_WATCH_MOUNTS on a /proc/<pid>/mounts file).
+ */
+int mnt_ns_watch_mounts(struct mnt_namespace *ns, int fd)
+{
+	struct watch_queue *wqueue;
+	struct watch_list *wlist;
+	struct watch *watch;
+	int ret;
+
+	if (!ns_capable(ns->user_ns, CAP_SYS_ADMIN))
+		return -EPERM;
+
+	wqueue = get_watch_queue(fd);
+	if (IS_ERR(wqueue))
+		return PTR_ERR(wqueue);
+
+	wlist = READ_ONCE(ns->mnt_watchers);
+	if (!wlist) {
+		wlist = kzalloc(sizeof(*wlist), GFP_KERNEL);
+		if (!wlist) {
+			ret = -ENOMEM;
+			goto err_wqueue;
+		}
+		init_watch_list(wlist, NULL);
+		if (cmpxchg(&ns->mnt_watchers, NULL, wlist) != NULL) {
+			/* Lost the race - use the winner's list */
+			kfree(wlist);
+			wlist = ns->mnt_watchers;
+		}
+	}
+
+	ret = -ENOMEM;
+	watch = kzalloc(sizeof(*watch), GFP_KERNEL);
+	if (!watch)
+		goto err_wqueue;
+
+	init_watch(watch, wqueue);
+
+	spin_lock(&wlist->lock);
+	ret = add_watch_to_object(watch, wlist);
+	spin_unlock(&wlist->lock);
+	if (ret < 0)
+		kfree(watch);
+
+err_wqueue:
+	put_watch_queue(wqueue);
+	return ret;
+}
+#else
+static inline void notify_mount(struct mnt_namespace *ns, int triggered_on,
+				int changed_mount, u32 subtype)
+{
+}
+#endif
+
 /*
  * vfsmount lock must be held for write
  */
@@ -1245,46 +1348,71 @@ struct vfsmount *mnt_clone_internal(const struct path *path)
 }
 
 #ifdef CONFIG_PROC_FS
+static struct mount *mnt_list_next(struct mnt_namespace *ns,
+				   struct list_head *p)
+{
+	struct mount *mnt, *ret = NULL;
+
+	lock_ns_list(ns);
+	list_for_each_continue(p, &ns->list) {
+		mnt = list_entry(p, typeof(*mnt), mnt_list);
+		if (!mnt_is_cursor(mnt)) {
+			ret = mnt;
+			break;
+		}
+	}
+	unlock_ns_list(ns);
+
+	return ret;
+}
+
 /* iterator; we want it to have access to namespace_sem, thus here... */
 static void *m_start(struct seq_file *m, loff_t *pos)
 {
 	struct proc_mounts *p = m->private;
+	struct list_head *prev;
 
 	down_read(&namespace_sem);
-	if (p->cached_event == p->ns->event) {
-		void *v = p->cached_mount;
-		if (*pos == p->cached_index)
-			return v;
-		if (*pos == p->cached_index + 1) {
-			v = seq_list_next(v, &p->ns->list, &p->cached_index);
-			return p->cached_mount = v;
-		}
+	if (!*pos) {
+		prev = &p->ns->list;
+	} else {
+		prev = &p->cursor.mnt_list;
+
+		/* Read after we'd reached the end? */
+		if (list_empty(prev))
+			return NULL;
 	}
 
-	p->cached_event = p->ns->event;
-	p->cached_mount = seq_list_start(&p->ns->list, *pos);
-	p->cached_index = *pos;
-	return p->cached_mount;
+	return mnt_list_next(p->ns, prev);
 }
 
 static void *m_next(struct seq_file *m, void *v, loff_t *pos)
 {
 	struct proc_mounts *p = m->private;
+	struct mount *mnt = v;
 
-	p->cached_mount = seq_list_next(v, &p->ns->list, pos);
-	p->cached_index = *pos;
-	return p->cached_mount;
+	++*pos;
+	return mnt_list_next(p->ns, &mnt->mnt_list);
 }
 
 static void m_stop(struct seq_file *m, void *v)
 {
+	struct proc_mounts *p = m->private;
+	struct mount *mnt = v;
+
+	lock_ns_list(p->ns);
+	if (mnt)
+		list_move_tail(&p->cursor.mnt_list, &mnt->mnt_list);
+	else
+		list_del_init(&p->cursor.mnt_list);
+	unlock_ns_list(p->ns);
 	up_read(&namespace_sem);
 }
 
 static int m_show(struct seq_file *m, void *v)
 {
 	struct proc_mounts *p = m->private;
-	struct mount *r = list_entry(v, struct mount, mnt_list);
+	struct mount *r = v;
 	return p->show(m, &r->mnt);
 }
 
@@ -1294,6 +1422,15 @@ const struct seq_operations mounts_op = {
 	.stop	= m_stop,
 	.show	= m_show,
 };
+
+void mnt_cursor_del(struct mnt_namespace *ns, struct mount *cursor)
+{
+	down_read(&namespace_sem);
+	lock_ns_list(ns);
+	list_del(&cursor->mnt_list);
+	unlock_ns_list(ns);
+	up_read(&namespace_sem);
+}
 #endif  /* CONFIG_PROC_FS */
 
 /**
@@ -1696,6 +1833,9 @@ int ksys_umount(char __user *name, int flags)
 		goto dput_and_out;
 
 	retval = do_umount(mnt, flags);
+	if (!retval)
+		notify_mount(current->nsproxy->mnt_ns, mnt->mnt_id,
+			     mnt->mnt_id, NOTIFY_MOUNT_UNMOUNT);
 dput_and_out:
 	/* we mustn't call path_put() as that would clear mnt_expiry_mark */
 	dput(path.dentry);
@@ -2309,6 +2449,9 @@ static int do_loopback(struct path *path, const char *old_name,
 		lock_mount_hash();
 		umount_tree(mnt, UMOUNT_SYNC);
 		unlock_mount_hash();
+	} else {
+		notify_mount(current->nsproxy->mnt_ns, parent->mnt_id,
+			     mnt->mnt_id, NOTIFY_MOUNT_NEW_MOUNT);
 	}
 out2:
 	unlock_mount(mp);
@@ -2530,6 +2673,7 @@ static int do_remount(struct path *path, int ms_flags, int sb_flags,
 	int err;
 	struct super_block *sb = path->mnt->mnt_sb;
 	struct mount *mnt = real_mount(path->mnt);
+	bool was_ro = __mnt_is_readonly(path->mnt);
 	struct fs_context *fc;
 
 	if (!check_mnt(mnt))
@@ -2557,6 +2701,12 @@ static int do_remount(struct path *path, int ms_flags, int sb_flags,
 		up_write(&sb->s_umount);
 	}
 
+	if (!err)
+		notify_mount(current->nsproxy->mnt_ns, mnt->mnt_id,
+			     mnt->mnt_id,
+			     was_ro != __mnt_is_readonly(path->mnt) ?
+			     NOTIFY_MOUNT_READONLY : NOTIFY_MOUNT_SETATTR);
+
 	mnt_warn_timestamp_expiry(path, &mnt->mnt);
 
 	put_fs_context(fc);
@@ -2666,6 +2816,10 @@ static int do_move_mount(struct path *old_path, struct path *new_path)
 	list_del_init(&old->mnt_expire);
 	if (attached)
 		put_mountpoint(old_mp);
+
+	notify_mount(current->nsproxy->mnt_ns,
+		     real_mount(new_path->mnt)->mnt_id, old->mnt_id,
+		     NOTIFY_MOUNT_MOVE_TO);
 out:
 	unlock_mount(mp);
 	if (!err) {
@@ -2749,7 +2903,7 @@ static int do_new_mount_fc(struct fs_context *fc, struct path *mountpoint,
 {
 	struct vfsmount *mnt;
 	struct super_block *sb = fc->root->d_sb;
-	int error;
+	int error, mnt_id;
 
 	error = security_sb_kern_mount(sb);
 	if (!error && mount_too_revealing(sb, &mnt_flags))
@@ -2768,9 +2922,14 @@ static int do_new_mount_fc(struct fs_context *fc, struct path *mountpoint,
 
 	mnt_warn_timestamp_expiry(mountpoint, mnt);
 
+	mnt_id = real_mount(mnt)->mnt_id;
 	error = do_add_mount(real_mount(mnt), mountpoint, mnt_flags);
 	if (error < 0)
 		mntput(mnt);
+	else
+		notify_mount(current->nsproxy->mnt_ns,
+			     real_mount(mountpoint->mnt)->mnt_id, mnt_id,
+			     NOTIFY_MOUNT_NEW_MOUNT);
 	return error;
 }
 
@@ -3158,6 +3317,9 @@ static void dec_mnt_namespaces(struct ucounts *ucounts)
 
 static void free_mnt_ns(struct mnt_namespace *ns)
 {
+#ifdef CONFIG_WATCH_QUEUE
+	remove_watch_list(ns->mnt_watchers, 0);
+#endif
 	if (!is_anon_ns(ns))
 		ns_free_inum(&ns->ns);
 	dec_mnt_namespaces(ns->ucounts);
@@ -3203,6 +3365,7 @@ static struct mnt_namespace *alloc_mnt_ns(struct user_namespace *user_ns, bool a
 	atomic_set(&new_ns->count, 1);
 	INIT_LIST_HEAD(&new_ns->list);
 	init_waitqueue_head(&new_ns->poll);
+	spin_lock_init(&new_ns->ns_lock);
 	new_ns->user_ns = get_user_ns(user_ns);
 	new_ns->ucounts = ucounts;
 	return new_ns;
@@ -3849,10 +4012,14 @@ static bool mnt_already_visible(struct mnt_namespace *ns,
 	bool visible = false;
 
 	down_read(&namespace_sem);
+	lock_ns_list(ns);
 	list_for_each_entry(mnt, &ns->list, mnt_list) {
 		struct mount *child;
 		int mnt_flags;
 
+		if (mnt_is_cursor(mnt))
+			continue;
+
 		if (mnt->mnt.mnt_sb->s_type != sb->s_type)
 			continue;
 
@@ -3900,6 +4067,7 @@ static bool mnt_already_visible(struct mnt_namespace *ns,
 	next:	;
 	}
 found:
+	unlock_ns_list(ns);
 	up_read(&namespace_sem);
 	return visible;
 }
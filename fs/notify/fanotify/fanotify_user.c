@@ -62,38 +62,69 @@ static int fanotify_event_info_len(struct fanotify_event *event)
 }
 
 /*
- * Get an fsnotify notification event if one exists and is small
- * enough to fit in "count". Return an error pointer if the count
- * is not large enough. When permission event is dequeued, its state is
- * updated accordingly.
+ * Dequeue as many events as fit in "count" in a single pass under
+ * notification_lock, so that draining a busy queue does not take the
+ * lock once per event.  Dequeued events are put on "events" in queue
+ * order and dequeued permission events have their state updated
+ * accordingly.  Returns the number of events dequeued, 0 if the queue
+ * is empty, or -EINVAL if the first event does not fit in "count".
  */
-static struct fsnotify_event *get_one_event(struct fsnotify_group *group,
-					    size_t count)
+static int get_more_events(struct fsnotify_group *group, size_t count,
+			   struct list_head *events)
 {
-	size_t event_size = FAN_EVENT_METADATA_LEN;
-	struct fsnotify_event *fsn_event = NULL;
+	struct fsnotify_event *fsn_event;
+	size_t event_size;
+	int nr = 0;
 
 	pr_debug("%s: group=%p count=%zd\n", __func__, group, count);
 
 	spin_lock(&group->notification_lock);
-	if (fsnotify_notify_queue_is_empty(group))
-		goto out;
+	while (!fsnotify_notify_queue_is_empty(group)) {
+		event_size = FAN_EVENT_METADATA_LEN;
+		if (FAN_GROUP_FLAG(group, FAN_REPORT_FID)) {
+			event_size += fanotify_event_info_len(
+				FANOTIFY_E(fsnotify_peek_first_event(group)));
+		}
 
-	if (FAN_GROUP_FLAG(group, FAN_REPORT_FID)) {
-		event_size += fanotify_event_info_len(
-			FANOTIFY_E(fsnotify_peek_first_event(group)));
+		if (event_size > count) {
+			if (!nr)
+				nr = -EINVAL;
+			break;
+		}
+		fsn_event = fsnotify_remove_first_event(group);
+		if (fanotify_is_perm_event(FANOTIFY_E(fsn_event)->mask))
+			FANOTIFY_PE(fsn_event)->state = FAN_EVENT_REPORTED;
+		list_add_tail(&fsn_event->list, events);
+		nr++;
+		count -= event_size;
 	}
+	spin_unlock(&group->notification_lock);
+	return nr;
+}
 
-	if (event_size > count) {
-		fsn_event = ERR_PTR(-EINVAL);
-		goto out;
+/*
+ * Put dequeued but unconsumed events back at the head of the
+ * notification queue, so that a failed copy does not lose the events
+ * behind it in the batch.
+ */
+static void requeue_events(struct fsnotify_group *group,
+			   struct list_head *events)
+{
+	struct fsnotify_event *fsn_event;
+	unsigned int nr = 0;
+
+	if (list_empty(events))
+		return;
+
+	spin_lock(&group->notification_lock);
+	list_for_each_entry(fsn_event, events, list) {
+		if (fanotify_is_perm_event(FANOTIFY_E(fsn_event)->mask))
+			FANOTIFY_PE(fsn_event)->state = FAN_EVENT_INIT;
+		nr++;
 	}
-	fsn_event = fsnotify_remove_first_event(group);
-	if (fanotify_is_perm_event(FANOTIFY_E(fsn_event)->mask))
-		FANOTIFY_PE(fsn_event)->state = FAN_EVENT_REPORTED;
-out:
+	list_splice_init(events, &group->notification_list);
+	group->q_len += nr;
 	spin_unlock(&group->notification_lock);
-	return fsn_event;
 }
 
 static int create_fd(struct fsnotify_group *group,
@@ -337,7 +368,8 @@ static ssize_t fanotify_read(struct file *file, char __user *buf,
 	struct fsnotify_group *group;
 	struct fsnotify_event *kevent;
 	char __user *start;
-	int ret;
+	int ret, nr;
+	LIST_HEAD(events);
 	DEFINE_WAIT_FUNC(wait, woken_wake_function);
 
 	start = buf;
@@ -347,13 +379,13 @@ static ssize_t fanotify_read(struct file *file, char __user *buf,
 
 	add_wait_queue(&group->notification_waitq, &wait);
 	while (1) {
-		kevent = get_one_event(group, count);
-		if (IS_ERR(kevent)) {
-			ret = PTR_ERR(kevent);
+		nr = get_more_events(group, count, &events);
+		if (nr < 0) {
+			ret = nr;
 			break;
 		}
 
-		if (!kevent) {
+		if (!nr) {
 			ret = -EAGAIN;
 			if (file->f_flags & O_NONBLOCK)
 				break;
@@ -369,42 +401,52 @@ static ssize_t fanotify_read(struct file *file, char __user *buf,
 			continue;
 		}
 
-		ret = copy_event_to_user(group, kevent, buf, count);
-		if (unlikely(ret == -EOPENSTALE)) {
+		while (nr--) {
+			kevent = list_first_entry(&events,
+						  struct fsnotify_event, list);
+			list_del_init(&kevent->list);
+
+			ret = copy_event_to_user(group, kevent, buf, count);
+			if (unlikely(ret == -EOPENSTALE)) {
+				/*
+				 * We cannot report events with stale fd so
+				 * drop it.  Setting ret to 0 will continue
+				 * the event loop and do the right thing if
+				 * there are no more events to read (i.e.
+				 * return bytes read, -EAGAIN or wait).
+				 */
+				ret = 0;
+			}
+
 			/*
-			 * We cannot report events with stale fd so drop it.
-			 * Setting ret to 0 will continue the event loop and
-			 * do the right thing if there are no more events to
-			 * read (i.e. return bytes read, -EAGAIN or wait).
+			 * Permission events get queued to wait for response.
+			 * Other events can be destroyed now.
 			 */
-			ret = 0;
-		}
-
-		/*
-		 * Permission events get queued to wait for response.  Other
-		 * events can be destroyed now.
-		 */
-		if (!fanotify_is_perm_event(FANOTIFY_E(kevent)->mask)) {
-			fsnotify_destroy_event(group, kevent);
-		} else {
-			if (ret <= 0) {
-				spin_lock(&group->notification_lock);
-				finish_permission_event(group,
-					FANOTIFY_PE(kevent), FAN_DENY);
-				wake_up(&group->fanotify_data.access_waitq);
+			if (!fanotify_is_perm_event(FANOTIFY_E(kevent)->mask)) {
+				fsnotify_destroy_event(group, kevent);
 			} else {
-				spin_lock(&group->notification_lock);
-				list_add_tail(&kevent->list,
-					&group->fanotify_data.access_list);
-				spin_unlock(&group->notification_lock);
+				if (ret <= 0) {
+					spin_lock(&group->notification_lock);
+					finish_permission_event(group,
+						FANOTIFY_PE(kevent), FAN_DENY);
+					wake_up(&group->fanotify_data.access_waitq);
+				} else {
+					spin_lock(&group->notification_lock);
+					list_add_tail(&kevent->list,
+						&group->fanotify_data.access_list);
+					spin_unlock(&group->notification_lock);
+				}
 			}
+			if (ret < 0)
+				break;
+			buf += ret;
+			count -= ret;
 		}
 		if (ret < 0)
 			break;
-		buf += ret;
-		count -= ret;
 	}
 	remove_wait_queue(&group->notification_waitq, &wait);
+	requeue_events(group, &events);
 
 	if (start != buf && ret != -EFAULT)
 		ret = buf - start;
@@ -826,6 +826,7 @@ static int show_smap(struct seq_file *m, void *v)
 {
 	struct vm_area_struct *vma = v;
 	struct mem_size_stats mss;
+	unsigned int swap_ra_win, swap_ra_hits;
 
 	memset(&mss, 0, sizeof(mss));
 
@@ -843,6 +844,10 @@ static int show_smap(struct seq_file *m, void *v)
 	seq_printf(m, "THPeligible:		%d\n",
 		   transparent_hugepage_enabled(vma));
 
+	swap_vma_ra_info(vma, &swap_ra_win, &swap_ra_hits);
+	seq_printf(m, "SwapRaWin:      %8u\nSwapRaHits:     %8u\n",
+		   swap_ra_win, swap_ra_hits);
+
 	if (arch_pkeys_enabled())
 		seq_printf(m, "ProtectionKey:  %8u\n", vma_pkey(vma));
 	show_smap_vma_flags(m, vma);
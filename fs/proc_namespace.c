@@ -12,6 +12,7 @@
 #include <linux/security.h>
 #include <linux/fs_struct.h>
 #include <linux/sched/task.h>
+#include <linux/watch_queue.h>
 
 #include "proc/internal.h" /* only for get_proc_task() in ->open() */
 
@@ -279,7 +280,8 @@ static int mounts_open_common(struct inode *inode, struct file *file,
 	p->ns = ns;
 	p->root = root;
 	p->show = show;
-	p->cached_event = ~0ULL;
+	INIT_LIST_HEAD(&p->cursor.mnt_list);
+	p->cursor.mnt.mnt_flags = MNT_CURSOR;
 
 	return 0;
 
@@ -296,10 +298,27 @@ static int mounts_release(struct inode *inode, struct file *file)
 	struct seq_file *m = file->private_data;
 	struct proc_mounts *p = m->private;
 	path_put(&p->root);
+	mnt_cursor_del(p->ns, &p->cursor);
 	put_mnt_ns(p->ns);
 	return seq_release_private(inode, file);
 }
 
+#ifdef CONFIG_WATCH_QUEUE
+static long mounts_ioctl(struct file *file, unsigned int cmd,
+			 unsigned long arg)
+{
+	struct seq_file *m = file->private_data;
+	struct proc_mounts *p = m->private;
+
+	switch (cmd) {
+	case IOC_WATCH_MOUNTS:
+		return mnt_ns_watch_mounts(p->ns, arg);
+	default:
+		return -ENOIOCTLCMD;
+	}
+}
+#endif
+
 static int mounts_open(struct inode *inode, struct file *file)
 {
 	return mounts_open_common(inode, file, show_vfsmnt);
@@ -321,6 +340,9 @@ const struct file_operations proc_mounts_operations = {
 	.llseek		= seq_lseek,
 	.release	= mounts_release,
 	.poll		= mounts_poll,
+#ifdef CONFIG_WATCH_QUEUE
+	.unlocked_ioctl	= mounts_ioctl,
+#endif
 };
 
 const struct file_operations proc_mountinfo_operations = {
@@ -329,6 +351,9 @@ const struct file_operations proc_mountinfo_operations = {
 	.llseek		= seq_lseek,
 	.release	= mounts_release,
 	.poll		= mounts_poll,
+#ifdef CONFIG_WATCH_QUEUE
+	.unlocked_ioctl	= mounts_ioctl,
+#endif
 };
 
 const struct file_operations proc_mountstats_operations = {
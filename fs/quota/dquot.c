@@ -766,6 +766,21 @@ void dqput(struct dquot *dquot)
 	}
 #endif
 	dqstats_inc(DQST_DROPS);
+
+	/*
+	 * Fast path: if we are not dropping the last reference, there is
+	 * no release work to do and we can avoid dq_list_lock entirely.
+	 * invalidate_dquots() may be sleeping in dquot_ref_wq until the
+	 * count falls to one (its own reference); the RMW below is the
+	 * full barrier that pairs with prepare_to_wait() there and makes
+	 * the waitqueue_active() check safe.
+	 */
+	if (atomic_add_unless(&dquot->dq_count, -1, 1)) {
+		if (unlikely(waitqueue_active(&dquot_ref_wq) &&
+			     atomic_read(&dquot->dq_count) == 1))
+			wake_up(&dquot_ref_wq);
+		return;
+	}
 we_slept:
 	spin_lock(&dq_list_lock);
 	if (atomic_read(&dquot->dq_count) > 1) {
@@ -1608,10 +1608,22 @@ static ssize_t do_copy_file_range(struct file *file_in, loff_t pos_in,
 	 * using the same ->copy_file_range() function pointer.
 	 */
 	if (file_out->f_op->copy_file_range &&
-	    file_out->f_op->copy_file_range == file_in->f_op->copy_file_range)
-		return file_out->f_op->copy_file_range(file_in, pos_in,
-						       file_out, pos_out,
-						       len, flags);
+	    file_out->f_op->copy_file_range == file_in->f_op->copy_file_range) {
+		ssize_t ret;
+
+		ret = file_out->f_op->copy_file_range(file_in, pos_in,
+						      file_out, pos_out,
+						      len, flags);
+		/*
+		 * A filesystem that cannot offload this particular copy
+		 * (e.g. an NFS server without server-side copy support,
+		 * or a copy between servers) says so with -EOPNOTSUPP or
+		 * -EXDEV; fall back to the in-kernel splice copy rather
+		 * than making userspace bounce the data itself.
+		 */
+		if (ret != -EOPNOTSUPP && ret != -EXDEV)
+			return ret;
+	}
 
 	return generic_copy_file_range(file_in, pos_in, file_out, pos_out, len,
 				       flags);
@@ -16,6 +16,7 @@
 #include <linux/fs.h>
 #include <linux/fsnotify.h>
 #include <linux/dirent.h>
+#include <linux/namei.h>
 #include <linux/security.h>
 #include <linux/syscalls.h>
 #include <linux/unistd.h>
@@ -24,6 +25,8 @@
 
 #include <asm/unaligned.h>
 
+#include "internal.h"
+
 /*
  * Note the "unsafe_put_user() semantics: we goto a
  * label for errors.
@@ -392,6 +395,189 @@ SYSCALL_DEFINE3(getdents64, unsigned int, fd,
 	return ksys_getdents64(fd, dirent, count);
 }
 
+/*
+ * getdents_statx() - getdents64 with the statx data for each entry.
+ *
+ * The directory is walked once into a kernel staging buffer, then each
+ * captured name is looked up relative to the directory (a single dcache
+ * hit for entries the walk just touched) and its attributes are fetched
+ * without another full path resolution.  Entries whose attributes
+ * cannot be fetched - typically because they were unlinked in between -
+ * are still returned, with d_stx.stx_mask cleared.
+ */
+
+/* Staged form of one directory entry between the walk and the copy out */
+struct getdents_statx_ent {
+	u64		ino;
+	s64		off;	/* offset of the next entry */
+	u16		reclen;	/* user-visible record length */
+	u16		namlen;
+	u8		type;
+	char		name[];	/* null-terminated */
+};
+
+#define GETDENTS_STATX_STAGING	(1 << 16)
+
+struct getdents_statx_callback {
+	struct dir_context ctx;
+	void *staging;
+	unsigned int used;	/* bytes of staging consumed */
+	unsigned int size;	/* bytes of staging available */
+	unsigned int budget;	/* bytes left in the user buffer */
+	struct getdents_statx_ent *prev;
+	int error;
+};
+
+static int filldir_statx(struct dir_context *ctx, const char *name,
+			 int namlen, loff_t offset, u64 ino,
+			 unsigned int d_type)
+{
+	struct getdents_statx_callback *buf =
+		container_of(ctx, struct getdents_statx_callback, ctx);
+	struct getdents_statx_ent *ent;
+	int reclen = ALIGN(offsetof(struct statx_dirent, d_name) + namlen + 1,
+			   sizeof(u64));
+	int entlen = ALIGN(sizeof(*ent) + namlen + 1, sizeof(u64));
+
+	buf->error = verify_dirent_name(name, namlen);
+	if (unlikely(buf->error))
+		return buf->error;
+	buf->error = -EINVAL;	/* only used if we fail.. */
+	if (reclen > buf->budget || entlen > buf->size - buf->used)
+		return -EINVAL;
+	if (buf->prev && signal_pending(current))
+		return -EINTR;
+
+	ent = buf->staging + buf->used;
+	ent->ino = ino;
+	ent->off = 0;
+	ent->reclen = reclen;
+	ent->namlen = namlen;
+	ent->type = d_type;
+	memcpy(ent->name, name, namlen);
+	ent->name[namlen] = '\0';
+
+	/* Like filldir64(): this entry's offset completes the previous one */
+	if (buf->prev)
+		buf->prev->off = offset;
+	buf->prev = ent;
+	buf->used += entlen;
+	buf->budget -= reclen;
+	buf->error = 0;
+	return 0;
+}
+
+static void getdents_statx_fetch(struct file *file,
+				 struct getdents_statx_ent *ent,
+				 unsigned int mask, struct kstat *stat)
+{
+	struct dentry *child;
+
+	memset(stat, 0, sizeof(*stat));
+
+	if (ent->name[0] == '.' &&
+	    (ent->namlen == 1 ||
+	     (ent->namlen == 2 && ent->name[1] == '.'))) {
+		/* "." is the directory itself; ".." is left unfetched */
+		if (ent->namlen == 1)
+			vfs_getattr(&file->f_path, stat, mask, 0);
+		return;
+	}
+
+	child = lookup_one_len_unlocked(ent->name, file->f_path.dentry,
+					ent->namlen);
+	if (IS_ERR(child))
+		return;
+	if (d_really_is_positive(child)) {
+		struct path path = {
+			.mnt	= file->f_path.mnt,
+			.dentry	= child,
+		};
+
+		if (vfs_getattr(&path, stat, mask, 0))
+			memset(stat, 0, sizeof(*stat));
+	}
+	dput(child);
+}
+
+SYSCALL_DEFINE4(getdents_statx, unsigned int, fd,
+		struct statx_dirent __user *, dirent,
+		unsigned int, count, unsigned int, mask)
+{
+	struct getdents_statx_callback buf = {
+		.ctx.actor = filldir_statx,
+		.budget = count,
+	};
+	void __user *ucur = dirent;
+	loff_t entry_pos;
+	unsigned int pos;
+	struct fd f;
+	int error;
+
+	if (mask & STATX__RESERVED)
+		return -EINVAL;
+	if (!access_ok(dirent, count))
+		return -EFAULT;
+
+	f = fdget_pos(fd);
+	if (!f.file)
+		return -EBADF;
+
+	buf.size = min_t(unsigned int, count, GETDENTS_STATX_STAGING);
+	buf.staging = kvmalloc(buf.size, GFP_KERNEL);
+	if (!buf.staging) {
+		fdput_pos(f);
+		return -ENOMEM;
+	}
+
+	entry_pos = f.file->f_pos;
+	error = iterate_dir(f.file, &buf.ctx);
+	if (error >= 0)
+		error = buf.error;
+	if (buf.prev)
+		buf.prev->off = buf.ctx.pos;
+
+	for (pos = 0; pos < buf.used; ) {
+		struct getdents_statx_ent *ent = buf.staging + pos;
+		struct statx_dirent __user *udir = ucur;
+		static const u8 spare[5];
+		struct kstat stat;
+
+		getdents_statx_fetch(f.file, ent, mask, &stat);
+
+		if (put_user(ent->ino, &udir->d_ino) ||
+		    put_user(ent->off, &udir->d_off) ||
+		    put_user(ent->reclen, &udir->d_reclen) ||
+		    put_user(ent->type, &udir->d_type) ||
+		    copy_to_user(udir->__spare, spare, sizeof(spare)) ||
+		    cp_statx(&stat, &udir->d_stx) ||
+		    copy_to_user(udir->d_name, ent->name, ent->namlen + 1)) {
+			/*
+			 * Rewind to this entry so that it and everything
+			 * staged behind it is seen by the next call.
+			 */
+			vfs_llseek(f.file, entry_pos, SEEK_SET);
+			error = -EFAULT;
+			break;
+		}
+
+		entry_pos = ent->off;
+		ucur += ent->reclen;
+		pos += ALIGN(sizeof(*ent) + ent->namlen + 1, sizeof(u64));
+	}
+
+	/*
+	 * If anything was emitted, report it: the file position always
+	 * matches what the caller has consumed, even after a fault.
+	 */
+	if (ucur != (void __user *)dirent)
+		error = ucur - (void __user *)dirent;
+
+	kvfree(buf.staging);
+	fdput_pos(f);
+	return error;
+}
+
 #ifdef CONFIG_COMPAT
 struct compat_old_linux_dirent {
 	compat_ulong_t	d_ino;
@@ -22,6 +22,7 @@
 #include <linux/audit.h>
 #include <linux/vmalloc.h>
 #include <linux/posix_acl_xattr.h>
+#include <linux/rculist.h>
 
 #include <linux/uaccess.h>
 
@@ -35,6 +36,175 @@ strcmp_prefix(const char *a, const char *a_prefix)
 	return *a_prefix ? NULL : a;
 }
 
+/*
+ * Per-inode cache of small, hot xattr values.
+ *
+ * Security xattrs are re-read through the filesystem's xattr handlers on
+ * every open (capability checks, LSM label reads), which on ext4 and
+ * friends means re-walking the on-disk xattr block even though the
+ * answer rarely changes. Filesystems that opt in with SB_I_XATTR_CACHE
+ * get the last few values - including negative "no such attribute"
+ * answers, which are the common case - kept on the inode, with RCU on
+ * the lookup side like the posix acl cache.
+ */
+#define XATTR_CACHE_MAX_VALUE	256
+#define XATTR_CACHE_MAX_ENTRIES	8
+
+struct xattr_cache_entry {
+	struct hlist_node	list;
+	struct rcu_head		rcu;
+	ssize_t			value_len;	/* value size, or -ENODATA */
+	unsigned short		name_len;
+	char			data[];		/* name '\0' value */
+};
+
+struct xattr_cache {
+	spinlock_t		lock;
+	unsigned int		nr_entries;
+	struct hlist_head	entries;
+};
+
+/*
+ * Only cache names whose every update funnels through __vfs_setxattr()
+ * or __vfs_removexattr(), so that invalidation there keeps us coherent.
+ * That holds for security.* (including security.capability, which
+ * killpriv removes via __vfs_removexattr()), but not for the posix acl
+ * names: the filesystem rewrites those behind our back on chmod. The
+ * parsed acls are already cached in inode->i_acl anyway, so permission
+ * checks stay out of fs-specific code either way.
+ */
+static bool xattr_cacheable_name(const char *name)
+{
+	return !strncmp(name, XATTR_SECURITY_PREFIX,
+			XATTR_SECURITY_PREFIX_LEN);
+}
+
+/*
+ * Returns the value length (copying the value if @size is non-zero), a
+ * cached -ENODATA, or -EAGAIN on a cache miss.
+ */
+static ssize_t xattr_cache_get(struct inode *inode, const char *name,
+			       void *value, size_t size)
+{
+	struct xattr_cache_entry *entry;
+	struct xattr_cache *cache;
+	ssize_t ret = -EAGAIN;
+
+	rcu_read_lock();
+	cache = rcu_dereference(inode->i_xattr_cache);
+	if (cache) {
+		hlist_for_each_entry_rcu(entry, &cache->entries, list) {
+			if (strcmp(entry->data, name))
+				continue;
+			ret = entry->value_len;
+			if (ret > 0 && size) {
+				if ((size_t)ret > size)
+					ret = -ERANGE;
+				else
+					memcpy(value, entry->data +
+					       entry->name_len + 1, ret);
+			}
+			break;
+		}
+	}
+	rcu_read_unlock();
+	return ret;
+}
+
+static void xattr_cache_add(struct inode *inode, const char *name,
+			    const void *value, ssize_t value_len)
+{
+	struct xattr_cache_entry *entry, *old;
+	struct xattr_cache *cache;
+	size_t name_len = strlen(name);
+
+	cache = READ_ONCE(inode->i_xattr_cache);
+	if (!cache) {
+		struct xattr_cache *new;
+
+		new = kmalloc(sizeof(*new), GFP_NOFS);
+		if (!new)
+			return;
+		spin_lock_init(&new->lock);
+		new->nr_entries = 0;
+		INIT_HLIST_HEAD(&new->entries);
+		cache = cmpxchg(&inode->i_xattr_cache, NULL, new);
+		if (!cache)
+			cache = new;
+		else
+			kfree(new);
+	}
+
+	entry = kmalloc(sizeof(*entry) + name_len + 1 +
+			(value_len > 0 ? value_len : 0), GFP_NOFS);
+	if (!entry)
+		return;
+	entry->value_len = value_len;
+	entry->name_len = name_len;
+	memcpy(entry->data, name, name_len + 1);
+	if (value_len > 0)
+		memcpy(entry->data + name_len + 1, value, value_len);
+
+	spin_lock(&cache->lock);
+	if (cache->nr_entries >= XATTR_CACHE_MAX_ENTRIES)
+		goto out_drop;
+	hlist_for_each_entry(old, &cache->entries, list) {
+		if (!strcmp(old->data, name))
+			goto out_drop;
+	}
+	hlist_add_head_rcu(&entry->list, &cache->entries);
+	cache->nr_entries++;
+	spin_unlock(&cache->lock);
+	return;
+
+out_drop:
+	spin_unlock(&cache->lock);
+	kfree(entry);
+}
+
+/*
+ * Throw away all cached values. Called whenever a cacheable name is
+ * (re)written or removed; attribute updates are rare enough that finer
+ * grained invalidation isn't worth it.
+ */
+static void xattr_cache_invalidate(struct inode *inode)
+{
+	struct xattr_cache_entry *entry;
+	struct xattr_cache *cache;
+	struct hlist_node *tmp;
+
+	cache = READ_ONCE(inode->i_xattr_cache);
+	if (!cache)
+		return;
+
+	spin_lock(&cache->lock);
+	hlist_for_each_entry_safe(entry, tmp, &cache->entries, list) {
+		hlist_del_rcu(&entry->list);
+		kfree_rcu(entry, rcu);
+	}
+	cache->nr_entries = 0;
+	spin_unlock(&cache->lock);
+}
+
+/*
+ * Free the cache on inode eviction. No locking needed, there are no
+ * users left at this point.
+ */
+void xattr_cache_free(struct inode *inode)
+{
+	struct xattr_cache *cache = inode->i_xattr_cache;
+	struct xattr_cache_entry *entry;
+	struct hlist_node *tmp;
+
+	if (!cache)
+		return;
+
+	hlist_for_each_entry_safe(entry, tmp, &cache->entries, list)
+		kfree(entry);
+	kfree(cache);
+	inode->i_xattr_cache = NULL;
+}
+
 /*
  * In order to implement different sets of xattr operations for each xattr
  * prefix, a filesystem should create a null-terminated array of struct
@@ -140,6 +310,9 @@ __vfs_setxattr(struct dentry *dentry, struct inode *inode, const char *name,
 {
 	const struct xattr_handler *handler;
 
+	if (xattr_cacheable_name(name))
+		xattr_cache_invalidate(inode);
+
 	handler = xattr_resolve_name(inode, &name);
 	if (IS_ERR(handler))
 		return PTR_ERR(handler);
@@ -339,13 +512,35 @@ __vfs_getxattr(struct dentry *dentry, struct inode *inode, const char *name,
 	       void *value, size_t size)
 {
 	const struct xattr_handler *handler;
+	const char *full_name = name;
+	bool cacheable;
+	ssize_t ret;
+
+	cacheable = (inode->i_sb->s_iflags & SB_I_XATTR_CACHE) &&
+		    xattr_cacheable_name(name);
+	if (cacheable) {
+		ret = xattr_cache_get(inode, name, value, size);
+		if (ret != -EAGAIN)
+			return ret;
+	}
 
 	handler = xattr_resolve_name(inode, &name);
 	if (IS_ERR(handler))
 		return PTR_ERR(handler);
 	if (!handler->get)
 		return -EOPNOTSUPP;
-	return handler->get(handler, dentry, inode, name, value, size);
+	ret = handler->get(handler, dentry, inode, name, value, size);
+
+	/*
+	 * Cache the full value (only available when the caller wasn't just
+	 * probing for the size) or the absence of the attribute.
+	 */
+	if (cacheable &&
+	    ((value && size && ret >= 0 && ret <= XATTR_CACHE_MAX_VALUE) ||
+	     ret == -ENODATA))
+		xattr_cache_add(inode, full_name, value, ret);
+
+	return ret;
 }
 EXPORT_SYMBOL(__vfs_getxattr);
 
@@ -406,6 +601,9 @@ __vfs_removexattr(struct dentry *dentry, const char *name)
 	struct inode *inode = d_inode(dentry);
 	const struct xattr_handler *handler;
 
+	if (xattr_cacheable_name(name))
+		xattr_cache_invalidate(inode);
+
 	handler = xattr_resolve_name(inode, &name);
 	if (IS_ERR(handler))
 		return PTR_ERR(handler);
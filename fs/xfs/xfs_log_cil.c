@@ -390,6 +390,7 @@ xlog_cil_insert_items(
 {
 	struct xfs_cil		*cil = log->l_cilp;
 	struct xfs_cil_ctx	*ctx = cil->xc_ctx;
+	struct xfs_cil_pcp	*cilpcp;
 	struct xfs_log_item	*lip;
 	int			len = 0;
 	int			diff_iovecs = 0;
@@ -458,27 +459,32 @@ xlog_cil_insert_items(
 		xlog_print_trans(tp);
 	}
 
+	spin_unlock(&cil->xc_cil_lock);
+
 	/*
-	 * Now (re-)position everything modified at the tail of the CIL.
-	 * We do this here so we only need to take the CIL lock once during
-	 * the transaction commit.
+	 * Now attach everything modified to this CPU's CIL list.  Items that
+	 * are being relogged are already on a per-cpu list (or on xc_cil if
+	 * a push is aggregating them right now) and just had their log
+	 * vectors updated in place, so they can be left where they are -
+	 * checkpoints are atomic, so item ordering within the CIL doesn't
+	 * matter.  The per-cpu lists are only drained while we're locked out
+	 * by the exclusive xc_ctx_lock at push time, so preemption protection
+	 * is all that's needed here.
 	 */
+	if (test_bit(XLOG_CIL_EMPTY, &cil->xc_flags))
+		clear_bit(XLOG_CIL_EMPTY, &cil->xc_flags);
+
+	cilpcp = get_cpu_ptr(cil->xc_pcp);
 	list_for_each_entry(lip, &tp->t_items, li_trans) {
 
 		/* Skip items which aren't dirty in this transaction. */
 		if (!test_bit(XFS_LI_DIRTY, &lip->li_flags))
 			continue;
 
-		/*
-		 * Only move the item if it isn't already at the tail. This is
-		 * to prevent a transient list_empty() state when reinserting
-		 * an item that is already the only item in the CIL.
-		 */
-		if (!list_is_last(&lip->li_cil, &cil->xc_cil))
-			list_move_tail(&lip->li_cil, &cil->xc_cil);
+		if (list_empty(&lip->li_cil))
+			list_add_tail(&lip->li_cil, &cilpcp->log_items);
 	}
-
-	spin_unlock(&cil->xc_cil_lock);
+	put_cpu_ptr(cil->xc_pcp);
 
 	if (tp->t_ticket->t_curr_res < 0)
 		xfs_force_shutdown(log->l_mp, SHUTDOWN_LOG_IO_ERROR);
@@ -625,6 +631,25 @@ xlog_cil_process_committed(
 	}
 }
 
+/*
+ * Fold the per-cpu CIL item lists into the main CIL list.  Must be called
+ * with the context lock held exclusively so that transaction commits are
+ * locked out while the lists are being spliced.
+ */
+static void
+xlog_cil_pcp_aggregate(
+	struct xfs_cil		*cil)
+{
+	struct xfs_cil_pcp	*cilpcp;
+	int			cpu;
+
+	for_each_possible_cpu(cpu) {
+		cilpcp = per_cpu_ptr(cil->xc_pcp, cpu);
+		if (!list_empty(&cilpcp->log_items))
+			list_splice_init(&cilpcp->log_items, &cil->xc_cil);
+	}
+}
+
 /*
  * Push the Committed Item List to the log. If @push_seq flag is zero, then it
  * is a background flush and so we can chose to ignore it. Otherwise, if the
@@ -666,6 +691,12 @@ xlog_cil_push(
 	down_write(&cil->xc_ctx_lock);
 	ctx = cil->xc_ctx;
 
+	/*
+	 * Transaction commits are locked out now, so fold the per-cpu CIL
+	 * lists into the single list we pull the checkpoint from.
+	 */
+	xlog_cil_pcp_aggregate(cil);
+
 	spin_lock(&cil->xc_push_lock);
 	push_seq = cil->xc_push_seq;
 	ASSERT(push_seq <= ctx->sequence);
@@ -737,6 +768,7 @@ xlog_cil_push(
 		item->li_lv = NULL;
 		num_iovecs += lv->lv_niovecs;
 	}
+	set_bit(XLOG_CIL_EMPTY, &cil->xc_flags);
 
 	/*
 	 * initialise the new context and attach it to the CIL. Then attach
@@ -908,7 +940,7 @@ xlog_cil_push_background(
 	 * The cil won't be empty because we are called while holding the
 	 * context lock so whatever we added to the CIL will still be there
 	 */
-	ASSERT(!list_empty(&cil->xc_cil));
+	ASSERT(!test_bit(XLOG_CIL_EMPTY, &cil->xc_flags));
 
 	/*
 	 * don't do a background push if we haven't used up all the
@@ -952,7 +984,8 @@ xlog_cil_push_now(
 	 * there's no work we need to do.
 	 */
 	spin_lock(&cil->xc_push_lock);
-	if (list_empty(&cil->xc_cil) || push_seq <= cil->xc_push_seq) {
+	if (test_bit(XLOG_CIL_EMPTY, &cil->xc_flags) ||
+	    push_seq <= cil->xc_push_seq) {
 		spin_unlock(&cil->xc_push_lock);
 		return;
 	}
@@ -970,7 +1003,7 @@ xlog_cil_empty(
 	bool		empty = false;
 
 	spin_lock(&cil->xc_push_lock);
-	if (list_empty(&cil->xc_cil))
+	if (test_bit(XLOG_CIL_EMPTY, &cil->xc_flags))
 		empty = true;
 	spin_unlock(&cil->xc_push_lock);
 	return empty;
@@ -1119,7 +1152,7 @@ restart:
 	 * we would have found the context on the committing list.
 	 */
 	if (sequence == cil->xc_current_sequence &&
-	    !list_empty(&cil->xc_cil)) {
+	    !test_bit(XLOG_CIL_EMPTY, &cil->xc_flags)) {
 		spin_unlock(&cil->xc_push_lock);
 		goto restart;
 	}
@@ -1178,17 +1211,28 @@ xlog_cil_init(
 {
 	struct xfs_cil	*cil;
 	struct xfs_cil_ctx *ctx;
+	int		cpu;
 
 	cil = kmem_zalloc(sizeof(*cil), KM_MAYFAIL);
 	if (!cil)
 		return -ENOMEM;
 
+	cil->xc_pcp = alloc_percpu(struct xfs_cil_pcp);
+	if (!cil->xc_pcp) {
+		kmem_free(cil);
+		return -ENOMEM;
+	}
+	for_each_possible_cpu(cpu)
+		INIT_LIST_HEAD(&per_cpu_ptr(cil->xc_pcp, cpu)->log_items);
+
 	ctx = kmem_zalloc(sizeof(*ctx), KM_MAYFAIL);
 	if (!ctx) {
+		free_percpu(cil->xc_pcp);
 		kmem_free(cil);
 		return -ENOMEM;
 	}
 
+	set_bit(XLOG_CIL_EMPTY, &cil->xc_flags);
 	INIT_WORK(&cil->xc_push_work, xlog_cil_push_work);
 	INIT_LIST_HEAD(&cil->xc_cil);
 	INIT_LIST_HEAD(&cil->xc_committing);
@@ -1219,7 +1263,9 @@ xlog_cil_destroy(
 		kmem_free(log->l_cilp->xc_ctx);
 	}
 
+	ASSERT(test_bit(XLOG_CIL_EMPTY, &log->l_cilp->xc_flags));
 	ASSERT(list_empty(&log->l_cilp->xc_cil));
+	free_percpu(log->l_cilp->xc_pcp);
 	kmem_free(log->l_cilp);
 }
 
@@ -266,10 +266,21 @@ struct xfs_cil_ctx {
  * the commit LSN to be determined as well. This should make synchronous
  * operations almost as efficient as the old logging methods.
  */
+/*
+ * Per-cpu CIL tracking items.  Committing transactions attach their log items
+ * here without taking the shared xc_cil_lock; the lists are aggregated onto
+ * xc_cil when the CIL is pushed, under the exclusive xc_ctx_lock.
+ */
+struct xfs_cil_pcp {
+	struct list_head	log_items;
+};
+
 struct xfs_cil {
 	struct xlog		*xc_log;
+	unsigned long		xc_flags;
 	struct list_head	xc_cil;
 	spinlock_t		xc_cil_lock;
+	struct xfs_cil_pcp __percpu *xc_pcp;
 
 	struct rw_semaphore	xc_ctx_lock ____cacheline_aligned_in_smp;
 	struct xfs_cil_ctx	*xc_ctx;
@@ -282,6 +293,9 @@ struct xfs_cil {
 	struct work_struct	xc_push_work;
 } ____cacheline_aligned_in_smp;
 
+/* xc_flags bits */
+#define	XLOG_CIL_EMPTY		0	/* no items anywhere in the CIL */
+
 /*
  * The amount of log space we allow the CIL to aggregate is difficult to size.
  * Whatever we choose, we have to make sure we can get a reservation for the
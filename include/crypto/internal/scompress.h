@@ -23,6 +23,9 @@ struct crypto_scomp {
  * @free_ctx:	Function frees context allocated with alloc_ctx
  * @compress:	Function performs a compress operation
  * @decompress:	Function performs a de-compress operation
+ * @set_params:	Function sets the compression level and window size for
+ *		contexts allocated with alloc_ctx.  Optional; algorithms
+ *		with fixed parameters leave it NULL
  * @base:	Common crypto API algorithm data structure
  */
 struct scomp_alg {
@@ -34,6 +37,8 @@ struct scomp_alg {
 	int (*decompress)(struct crypto_scomp *tfm, const u8 *src,
 			  unsigned int slen, u8 *dst, unsigned int *dlen,
 			  void *ctx);
+	int (*set_params)(struct crypto_scomp *tfm, int level,
+			  unsigned int window_log, void *ctx);
 	struct crypto_alg base;
 };
 
@@ -80,6 +85,18 @@ static inline int crypto_scomp_compress(struct crypto_scomp *tfm,
 	return crypto_scomp_alg(tfm)->compress(tfm, src, slen, dst, dlen, ctx);
 }
 
+static inline int crypto_scomp_set_params(struct crypto_scomp *tfm,
+					  int level, unsigned int window_log,
+					  void *ctx)
+{
+	struct scomp_alg *alg = crypto_scomp_alg(tfm);
+
+	if (!alg->set_params)
+		return -ENOSYS;
+
+	return alg->set_params(tfm, level, window_log, ctx);
+}
+
 static inline int crypto_scomp_decompress(struct crypto_scomp *tfm,
 					  const u8 *src, unsigned int slen,
 					  u8 *dst, unsigned int *dlen,
@@ -12,6 +12,26 @@ struct blk_flush_queue;
 /**
  * struct blk_mq_hw_ctx - State for a hardware queue facing the hardware block device
  */
+/*
+ * Dispatch classes, derived from the request's I/O priority class. The
+ * dispatch path drains higher classes first and latency is accounted per
+ * class so that latency-sensitive I/O can be told apart from bulk I/O on
+ * a shared hardware queue.
+ */
+enum {
+	BLK_MQ_DISPATCH_RT,
+	BLK_MQ_DISPATCH_BE,
+	BLK_MQ_DISPATCH_IDLE,
+
+	BLK_MQ_NR_DISPATCH_CLASSES,
+};
+
+struct blk_mq_class_stat {
+	unsigned long	nr_samples;
+	u64		total_ns;
+	u64		max_ns;
+};
+
 struct blk_mq_hw_ctx {
 	struct {
 		spinlock_t		lock;
@@ -58,6 +78,7 @@ struct blk_mq_hw_ctx {
 
 	atomic_t		nr_active;
 
+	struct hlist_node	cpuhp_online;
 	struct hlist_node	cpuhp_dead;
 	struct kobject		kobj;
 
@@ -65,6 +86,9 @@ struct blk_mq_hw_ctx {
 	unsigned long		poll_invoked;
 	unsigned long		poll_success;
 
+	/* issue-to-completion latency per dispatch class, approximate */
+	struct blk_mq_class_stat class_lat[BLK_MQ_NR_DISPATCH_CLASSES];
+
 #ifdef CONFIG_BLK_DEBUG_FS
 	struct dentry		*debugfs_dir;
 	struct dentry		*sched_debugfs_dir;
@@ -123,6 +147,7 @@ struct blk_mq_queue_data {
 typedef blk_status_t (queue_rq_fn)(struct blk_mq_hw_ctx *,
 		const struct blk_mq_queue_data *);
 typedef void (commit_rqs_fn)(struct blk_mq_hw_ctx *);
+typedef void (queue_rqs_fn)(struct list_head *list);
 typedef bool (get_budget_fn)(struct blk_mq_hw_ctx *);
 typedef void (put_budget_fn)(struct blk_mq_hw_ctx *);
 typedef enum blk_eh_timer_return (timeout_fn)(struct request *, bool);
@@ -149,6 +174,15 @@ struct blk_mq_ops {
 	 */
 	queue_rq_fn		*queue_rq;
 
+	/*
+	 * Queue a list of new requests. All requests belong to the same
+	 * hardware queue and no I/O scheduler is attached. The driver
+	 * issues what it can, ringing the doorbell once for the whole
+	 * batch, and leaves anything it could not issue on the list for
+	 * the caller to dispatch through ->queue_rq instead.
+	 */
+	queue_rqs_fn		*queue_rqs;
+
 	/*
 	 * If a driver uses bd->last to judge when to submit requests to
 	 * hardware, it must define this function. In case of errors that
@@ -226,6 +260,11 @@ struct blk_mq_ops {
 enum {
 	BLK_MQ_F_SHOULD_MERGE	= 1 << 0,
 	BLK_MQ_F_TAG_SHARED	= 1 << 1,
+	/*
+	 * Set when this device requires underlying blk-mq device for
+	 * completing IO:
+	 */
+	BLK_MQ_F_STACKING	= 1 << 2,
 	BLK_MQ_F_BLOCKING	= 1 << 5,
 	BLK_MQ_F_NO_SCHED	= 1 << 6,
 	BLK_MQ_F_ALLOC_POLICY_START_BIT = 8,
@@ -234,6 +273,8 @@ enum {
 	BLK_MQ_S_STOPPED	= 0,
 	BLK_MQ_S_TAG_ACTIVE	= 1,
 	BLK_MQ_S_SCHED_RESTART	= 2,
+	/* hw queue is inactive after all its CPUs become offline */
+	BLK_MQ_S_INACTIVE	= 3,
 
 	BLK_MQ_MAX_DEPTH	= 10240,
 
@@ -369,6 +369,14 @@ extern int blkdev_report_zones_ioctl(struct block_device *bdev, fmode_t mode,
 extern int blkdev_reset_zones_ioctl(struct block_device *bdev, fmode_t mode,
 				    unsigned int cmd, unsigned long arg);
 
+/* Cached zone write pointer value for an unusable (offline/unknown) zone */
+#define BLK_ZONE_WP_INVAL	((sector_t)-1)
+
+struct request_queue;
+extern blk_status_t blk_zone_append_bio(struct request_queue *q,
+					struct bio *bio);
+extern void blk_zone_track_write(struct request_queue *q, struct bio *bio);
+
 #else /* CONFIG_BLK_DEV_ZONED */
 
 static inline unsigned int blkdev_nr_zones(struct block_device *bdev)
@@ -395,6 +403,18 @@ static inline int blkdev_reset_zones_ioctl(struct block_device *bdev,
 	return -ENOTTY;
 }
 
+struct request_queue;
+static inline blk_status_t blk_zone_append_bio(struct request_queue *q,
+					       struct bio *bio)
+{
+	return BLK_STS_NOTSUPP;
+}
+
+static inline void blk_zone_track_write(struct request_queue *q,
+					struct bio *bio)
+{
+}
+
 #endif /* CONFIG_BLK_DEV_ZONED */
 
 struct request_queue {
@@ -522,6 +542,13 @@ struct request_queue {
 	unsigned int		nr_zones;
 	unsigned long		*seq_zones_bitmap;
 	unsigned long		*seq_zones_wlock;
+	/*
+	 * Cached write pointer of each zone, in sectors, used to emulate
+	 * REQ_OP_ZONE_APPEND.  Maintained from the submitted write stream
+	 * under zone_wp_lock and refreshed on zone revalidation.
+	 */
+	sector_t		*seq_zones_wp;
+	spinlock_t		zone_wp_lock;
 #endif /* CONFIG_BLK_DEV_ZONED */
 
 	/*
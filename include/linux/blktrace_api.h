@@ -12,11 +12,15 @@
 
 #include <linux/sysfs.h>
 
+struct blk_trace_agg;
+
 struct blk_trace {
 	int trace_state;
 	struct rchan *rchan;
 	unsigned long __percpu *sequence;
 	unsigned char __percpu *msg_data;
+	struct blk_trace_agg __percpu *agg;
+	unsigned int sample_rate;
 	u16 act_mask;
 	u64 start_lba;
 	u64 end_lba;
@@ -25,6 +29,8 @@ struct blk_trace {
 	struct dentry *dir;
 	struct dentry *dropped_file;
 	struct dentry *msg_file;
+	struct dentry *hist_file;
+	struct dentry *sample_file;
 	struct list_head running_list;
 	atomic_t dropped;
 };
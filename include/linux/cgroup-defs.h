@@ -22,6 +22,18 @@
 #include <linux/bpf-cgroup.h>
 #include <linux/psi_types.h>
 
+/*
+ * Task delay accounting (delayacct) categories rolled up per cgroup and
+ * reported in cpu.stat.
+ */
+enum cgroup_delay_type {
+	CGROUP_DELAY_BLKIO,
+	CGROUP_DELAY_SWAPIN,
+	CGROUP_DELAY_FREEPAGES,
+	CGROUP_DELAY_THRASHING,
+	CGROUP_NR_DELAYS,
+};
+
 #ifdef CONFIG_CGROUPS
 
 struct cgroup;
@@ -278,6 +290,11 @@ struct css_set {
 
 struct cgroup_base_stat {
 	struct task_cputime cputime;
+
+#ifdef CONFIG_TASK_DELAY_ACCT
+	/* aggregated task delay accounting totals, in nanoseconds */
+	u64 delay[CGROUP_NR_DELAYS];
+#endif
 };
 
 /*
@@ -800,6 +800,27 @@ static inline void cgroup_account_cputime_field(struct task_struct *task,
 	rcu_read_unlock();
 }
 
+#ifdef CONFIG_TASK_DELAY_ACCT
+void __cgroup_account_delay(struct cgroup *cgrp, enum cgroup_delay_type idx,
+			    u64 delta);
+
+static inline void cgroup_account_delay(struct task_struct *task,
+					enum cgroup_delay_type idx, u64 delta)
+{
+	struct cgroup *cgrp;
+
+	rcu_read_lock();
+	cgrp = task_dfl_cgroup(task);
+	if (cgroup_parent(cgrp))
+		__cgroup_account_delay(cgrp, idx, delta);
+	rcu_read_unlock();
+}
+#else
+static inline void cgroup_account_delay(struct task_struct *task,
+					enum cgroup_delay_type idx,
+					u64 delta) {}
+#endif	/* CONFIG_TASK_DELAY_ACCT */
+
 #else	/* CONFIG_CGROUPS */
 
 static inline void cgroup_account_cputime(struct task_struct *task,
@@ -807,6 +828,9 @@ static inline void cgroup_account_cputime(struct task_struct *task,
 static inline void cgroup_account_cputime_field(struct task_struct *task,
 						enum cpu_usage_stat index,
 						u64 delta_exec) {}
+static inline void cgroup_account_delay(struct task_struct *task,
+					enum cgroup_delay_type idx,
+					u64 delta) {}
 
 #endif	/* CONFIG_CGROUPS */
 
@@ -584,6 +584,10 @@ asmlinkage ssize_t compat_sys_readv(compat_ulong_t fd,
 asmlinkage ssize_t compat_sys_writev(compat_ulong_t fd,
 		const struct compat_iovec __user *vec, compat_ulong_t vlen);
 /* No generic prototype for pread64 and pwrite64 */
+asmlinkage long compat_sys_process_madvise(compat_int_t pidfd,
+		const struct compat_iovec __user *vec,
+		compat_size_t vlen, compat_int_t behavior,
+		compat_uint_t flags);
 asmlinkage ssize_t compat_sys_preadv(compat_ulong_t fd,
 		const struct compat_iovec __user *vec,
 		compat_ulong_t vlen, u32 pos_low, u32 pos_high);
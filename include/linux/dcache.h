@@ -68,6 +68,7 @@ struct dentry_stat_t {
 	long dummy;		/* Reserved for future use */
 };
 extern struct dentry_stat_t dentry_stat;
+extern unsigned long sysctl_negative_dentry_limit;
 
 /*
  * Try to keep struct dentry aligned on 64 byte cachelines (this will
@@ -214,6 +215,7 @@ struct dentry_operations {
 #define DCACHE_ENCRYPTED_NAME		0x02000000 /* Encrypted name (dir key was unavailable) */
 #define DCACHE_OP_REAL			0x04000000
 
+#define DCACHE_PAR_UPDATE		0x08000000 /* being created or unlinked with parent locked shared */
 #define DCACHE_PAR_LOOKUP		0x10000000 /* being looked up (with parent locked shared) */
 #define DCACHE_DENTRY_CURSOR		0x20000000
 #define DCACHE_NORCU			0x40000000 /* No RCU delay for freeing */
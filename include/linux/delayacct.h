@@ -8,6 +8,7 @@
 #define _LINUX_DELAYACCT_H
 
 #include <uapi/linux/taskstats.h>
+#include <linux/u64_stats_sync.h>
 
 /*
  * Per-task flags relevant to delay accounting
@@ -19,7 +20,7 @@
 
 #ifdef CONFIG_TASK_DELAY_ACCT
 struct task_delay_info {
-	raw_spinlock_t	lock;
+	struct u64_stats_sync sync;
 	unsigned int	flags;	/* Private per-task flags */
 
 	/* For each stat XXX, add following, aligned appropriately
@@ -28,8 +29,10 @@ struct task_delay_info {
 	 * u64 XXX_delay;
 	 * u32 XXX_count;
 	 *
-	 * Atomicity of updates to XXX_delay, XXX_count protected by
-	 * single lock above (split into XXX_lock if contention is an issue).
+	 * Updates to XXX_delay and XXX_count are made by a single writer
+	 * at a time (the task itself, or in the blkio case whoever wakes
+	 * it), so the u64_stats seqcount is all that readers need and the
+	 * update side is lock-free on 64-bit.
 	 */
 
 	/*
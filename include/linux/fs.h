@@ -597,6 +597,7 @@ static inline void mapping_allow_writable(struct address_space *mapping)
 #endif
 
 struct posix_acl;
+struct xattr_cache;
 #define ACL_NOT_CACHED ((void *)(-1))
 #define ACL_DONT_CACHE ((void *)(-3))
 
@@ -636,6 +637,7 @@ struct inode {
 	struct posix_acl	*i_acl;
 	struct posix_acl	*i_default_acl;
 #endif
+	struct xattr_cache	*i_xattr_cache;
 
 	const struct inode_operations	*i_op;
 	struct super_block	*i_sb;
@@ -1403,6 +1405,7 @@ extern int send_sigurg(struct fown_struct *fown);
 #define SB_I_USERNS_VISIBLE		0x00000010 /* fstype already mounted */
 #define SB_I_IMA_UNVERIFIABLE_SIGNATURE	0x00000020
 #define SB_I_UNTRUSTED_MOUNTER		0x00000040
+#define SB_I_XATTR_CACHE	0x00000080	/* cache xattr values on inodes */
 
 /* Possible states of 'frozen' field */
 enum {
@@ -2223,6 +2226,9 @@ struct file_system_type {
 #define FS_HAS_SUBTYPE		4
 #define FS_USERNS_MOUNT		8	/* Can be mounted by userns root */
 #define FS_DISALLOW_NOTIFY_PERM	16	/* Disable fanotify permission events */
+#define FS_ALLOW_PAR_DIROPS	32	/* FS serializes same-name dir updates itself,
+					 * create/unlink may run with the directory
+					 * lock held shared. */
 #define FS_RENAME_DOES_D_MOVE	32768	/* FS will handle d_move() during rename() internally. */
 	int (*init_fs_context)(struct fs_context *);
 	const struct fs_parameter_description *parameters;
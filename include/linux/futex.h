@@ -28,6 +28,8 @@ struct task_struct;
 
 #define FUT_OFF_INODE    1 /* We set bit 0 if key has a reference on inode */
 #define FUT_OFF_MMSHARED 2 /* We set bit 1 if key has a reference on mm */
+#define FUT_OFF_NUMA	 0x80000000 /* NUMA-sharded hashing; offsets stay
+				     * below PAGE_SIZE so bit 31 is free */
 
 union futex_key {
 	struct {
@@ -496,6 +496,18 @@ __alloc_pages(gfp_t gfp_mask, unsigned int order, int preferred_nid)
 	return __alloc_pages_nodemask(gfp_mask, order, preferred_nid, NULL);
 }
 
+unsigned long __alloc_pages_bulk(gfp_t gfp, int preferred_nid,
+				 nodemask_t *nodemask, int nr_pages,
+				 struct list_head *page_list);
+
+/* Bulk allocate order-0 pages */
+static inline unsigned long
+alloc_pages_bulk(gfp_t gfp, int nr_pages, struct list_head *page_list)
+{
+	return __alloc_pages_bulk(gfp, numa_mem_id(), NULL, nr_pages,
+				  page_list);
+}
+
 /*
  * Allocate pages, preferring the node given as nid. The node must be valid and
  * online. For more general interface, see alloc_pages_node().
@@ -421,6 +421,35 @@ static inline void hrtimer_start(struct hrtimer *timer, ktime_t tim,
 	hrtimer_start_range_ns(timer, tim, 0, mode);
 }
 
+/*
+ * Coalescing classes: symbolic slack amounts for callers which can
+ * tolerate their timer expiring somewhat late.  Timers whose
+ * [softexpires, expires] ranges overlap are expired in a single
+ * interrupt, so the looser the class, the fewer interrupts a flock of
+ * similar timers on the same CPU generates.
+ */
+enum hrtimer_class {
+	HRTIMER_CLASS_TIGHT,	/* precise, no slack at all */
+	HRTIMER_CLASS_NORMAL,	/* may expire up to 100us late */
+	HRTIMER_CLASS_LOOSE,	/* may expire up to 1.25ms late */
+};
+
+extern u64 hrtimer_class_slack(enum hrtimer_class class);
+
+/**
+ * hrtimer_start_class - (re)start an hrtimer with coalescing class slack
+ * @timer:	the timer to be added
+ * @tim:	expiry time
+ * @class:	coalescing class selecting the tolerated expiry slack
+ * @mode:	timer mode, see hrtimer_start()
+ */
+static inline void hrtimer_start_class(struct hrtimer *timer, ktime_t tim,
+				       enum hrtimer_class class,
+				       const enum hrtimer_mode mode)
+{
+	hrtimer_start_range_ns(timer, tim, hrtimer_class_slack(class), mode);
+}
+
 extern int hrtimer_cancel(struct hrtimer *timer);
 extern int hrtimer_try_to_cancel(struct hrtimer *timer);
 
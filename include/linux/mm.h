@@ -534,6 +534,30 @@ static inline void vma_init(struct vm_area_struct *vma, struct mm_struct *mm)
 	vma->vm_mm = mm;
 	vma->vm_ops = &dummy_vm_ops;
 	INIT_LIST_HEAD(&vma->anon_vma_chain);
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	seqcount_init(&vma->vm_sequence);
+	atomic_set(&vma->vm_ref_count, 1);
+#endif
+}
+
+/*
+ * Mark the vma as being modified for the benefit of speculative page fault
+ * handlers. Must be used around every update of vm_start, vm_end, vm_flags,
+ * vm_page_prot or the vma's position in the mm, with the mmap_sem held for
+ * writing.
+ */
+static inline void vm_write_begin(struct vm_area_struct *vma)
+{
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	raw_write_seqcount_begin(&vma->vm_sequence);
+#endif
+}
+
+static inline void vm_write_end(struct vm_area_struct *vma)
+{
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	raw_write_seqcount_end(&vma->vm_sequence);
+#endif
 }
 
 static inline void vma_set_anonymous(struct vm_area_struct *vma)
@@ -1045,6 +1069,8 @@ static inline __must_check bool try_get_page(struct page *page)
 	return true;
 }
 
+bool __must_check try_grab_page(struct page *page, unsigned int flags);
+
 static inline void put_page(struct page *page)
 {
 	page = compound_head(page);
@@ -1087,6 +1113,55 @@ void put_user_pages_dirty_lock(struct page **pages, unsigned long npages,
 
 void put_user_pages(struct page **pages, unsigned long npages);
 
+void unpin_user_page(struct page *page);
+void unpin_user_pages_dirty_lock(struct page **pages, unsigned long npages,
+				 bool make_dirty);
+void unpin_user_pages(struct page **pages, unsigned long npages);
+
+/*
+ * GUP_PIN_COUNTING_BIAS, and the associated functions that use it, overload
+ * the page's refcount so that two separate items are tracked: the original page
+ * reference count, and also a new count of how many pin_user_pages() calls were
+ * made against the page. ("gup-pinned" is another term for the latter).
+ *
+ * With this scheme, pin_user_pages() becomes special: such pages are marked as
+ * distinct from normal pages. As such, the unpin_user_page() call (and its
+ * variants) must be used in order to release gup-pinned pages.
+ *
+ * Choosing a power of two for the bias keeps the arithmetic cheap, and
+ * leaves plenty of room before the 32-bit refcount could overflow: even a
+ * fully pin_user_pages()'d 1GB gigantic page only reaches 2^28.
+ */
+#define GUP_PIN_COUNTING_BIAS (1U << 10)
+
+/**
+ * page_maybe_dma_pinned() - report if a page is pinned for DMA.
+ * @page:	pointer to page to be queried.
+ *
+ * This returns true if the page was pinned via pin_user_pages() (as opposed
+ * to get_user_pages()).
+ *
+ * False positives are possible: a page that has been referenced
+ * GUP_PIN_COUNTING_BIAS or more times by "normal" get_page()/get_user_pages()
+ * users also reports as pinned. Callers must therefore treat the result as a
+ * strong hint, not a guarantee, and must not rely on it for correctness.
+ *
+ * Return: True, if it is likely that the page has been "dma-pinned".
+ *         False, if the page is definitely not dma-pinned.
+ */
+static inline bool page_maybe_dma_pinned(struct page *page)
+{
+	/*
+	 * page_ref_count() is signed. If that refcount overflows, then
+	 * page_ref_count() returns a negative value, and callers will avoid
+	 * further incrementing the refcount. Here, the unsigned comparison
+	 * also treats such (poisoned) values as pinned, which is the safe
+	 * answer for the callers above.
+	 */
+	return ((unsigned int)page_ref_count(compound_head(page))) >=
+		GUP_PIN_COUNTING_BIAS;
+}
+
 #if defined(CONFIG_SPARSEMEM) && !defined(CONFIG_SPARSEMEM_VMEMMAP)
 #define SECTION_IN_PAGE_FLAGS
 #endif
@@ -1487,6 +1562,24 @@ int invalidate_inode_page(struct page *page);
 #ifdef CONFIG_MMU
 extern vm_fault_t handle_mm_fault(struct vm_area_struct *vma,
 			unsigned long address, unsigned int flags);
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+extern struct vm_area_struct *get_vma(struct mm_struct *mm,
+				      unsigned long addr);
+extern void put_vma(struct vm_area_struct *vma);
+extern vm_fault_t __handle_speculative_fault(struct mm_struct *mm,
+			unsigned long address, unsigned int flags);
+static inline vm_fault_t handle_speculative_fault(struct mm_struct *mm,
+			unsigned long address, unsigned int flags)
+{
+	/*
+	 * Single threaded tasks cannot race with themselves on the
+	 * mmap_sem; the classic path is just as fast for them.
+	 */
+	if (!(flags & FAULT_FLAG_USER) || atomic_read(&mm->mm_users) == 1)
+		return VM_FAULT_RETRY;
+	return __handle_speculative_fault(mm, address, flags);
+}
+#endif
 extern int fixup_user_fault(struct task_struct *tsk, struct mm_struct *mm,
 			    unsigned long address, unsigned int fault_flags,
 			    bool *unlocked);
@@ -1544,6 +1637,12 @@ long get_user_pages_unlocked(unsigned long start, unsigned long nr_pages,
 int get_user_pages_fast(unsigned long start, int nr_pages,
 			unsigned int gup_flags, struct page **pages);
 
+long pin_user_pages(unsigned long start, unsigned long nr_pages,
+		    unsigned int gup_flags, struct page **pages,
+		    struct vm_area_struct **vmas);
+int pin_user_pages_fast(unsigned long start, int nr_pages,
+			unsigned int gup_flags, struct page **pages);
+
 int account_locked_vm(struct mm_struct *mm, unsigned long pages, bool inc);
 int __account_locked_vm(struct mm_struct *mm, unsigned long pages, bool inc,
 			struct task_struct *task, bool bypass_rlim);
@@ -1621,13 +1720,33 @@ int clear_page_dirty_for_io(struct page *page);
 
 int get_cmdline(struct task_struct *task, char *buffer, int buflen);
 
+int reserve_mem_find_by_name(const char *name, phys_addr_t *start,
+			     phys_addr_t *size);
+
 extern unsigned long move_page_tables(struct vm_area_struct *vma,
 		unsigned long old_addr, struct vm_area_struct *new_vma,
 		unsigned long new_addr, unsigned long len,
 		bool need_rmap_locks);
+
+/*
+ * Flags used by change_protection().  For now we make it a bitmap so
+ * that we can pass in multiple flags just like parameters.  However
+ * for now all the callers are only use one of the flags at the same
+ * time.
+ */
+/* Whether we should allow dirty bit accounting */
+#define  MM_CP_DIRTY_ACCT                  (1UL << 0)
+/* Whether this protection change is for NUMA hints */
+#define  MM_CP_PROT_NUMA                   (1UL << 1)
+/* Whether this change is for write protecting */
+#define  MM_CP_UFFD_WP                     (1UL << 2) /* do wp */
+#define  MM_CP_UFFD_WP_RESOLVE             (1UL << 3) /* Resolve wp */
+#define  MM_CP_UFFD_WP_ALL                 (MM_CP_UFFD_WP | \
+					    MM_CP_UFFD_WP_RESOLVE)
+
 extern unsigned long change_protection(struct vm_area_struct *vma, unsigned long start,
 			      unsigned long end, pgprot_t newprot,
-			      int dirty_accountable, int prot_numa);
+			      unsigned long cp_flags);
 extern int mprotect_fixup(struct vm_area_struct *vma,
 			  struct vm_area_struct **pprev, unsigned long start,
 			  unsigned long end, unsigned long newflags);
@@ -2350,6 +2469,8 @@ extern int __do_munmap(struct mm_struct *, unsigned long, size_t,
 		       struct list_head *uf, bool downgrade);
 extern int do_munmap(struct mm_struct *, unsigned long, size_t,
 		     struct list_head *uf);
+extern int do_madvise(struct mm_struct *mm, unsigned long start, size_t len_in,
+		      int behavior);
 
 static inline unsigned long
 do_mmap_pgoff(struct file *file, unsigned long addr,
@@ -2601,8 +2722,30 @@ struct page *follow_page(struct vm_area_struct *vma, unsigned long address,
 #define FOLL_ANON	0x8000	/* don't do file mappings */
 #define FOLL_LONGTERM	0x10000	/* mapping lifetime is indefinite: see below */
 #define FOLL_SPLIT_PMD	0x20000	/* split huge pmd before returning */
+#define FOLL_PIN	0x40000	/* pages must be released via unpin_user_page */
 
 /*
+ * NOTE on FOLL_PIN:
+ *
+ * FOLL_PIN and FOLL_GET are mutually exclusive for a given function call.
+ * FOLL_PIN is an internal flag: callers must use the pin_user_pages*() APIs
+ * instead of setting it directly.
+ *
+ * FOLL_PIN is similar to FOLL_GET: both of these pin pages. They use different
+ * and separate refcounting mechanisms, however, and that means that each has
+ * its own acquire and release mechanisms:
+ *
+ *     FOLL_GET: get_user_pages*() to acquire, and put_page()/put_user_page*()
+ *     to release.
+ *
+ *     FOLL_PIN: pin_user_pages*() to acquire, and unpin_user_page*() to
+ *     release.
+ *
+ * FOLL_PIN pins are tracked in the page refcount via GUP_PIN_COUNTING_BIAS,
+ * which lets page_maybe_dma_pinned() report the pinned state so that reclaim,
+ * compaction and other page migrators can avoid wasting work on pages that
+ * cannot move while the pin is held.
+ *
  * NOTE on FOLL_LONGTERM:
  *
  * FOLL_LONGTERM indicates that the page will be held for an indefinite time
@@ -2629,6 +2772,17 @@ struct page *follow_page(struct vm_area_struct *vma, unsigned long address,
  * FOLL_LONGTERM is specified.
  */
 
+/*
+ * Pages allocated from CMA pageblocks or ZONE_MOVABLE must remain migratable,
+ * so they are not acceptable targets for a long-term pin: such pages are
+ * migrated out before the pin is taken.
+ */
+static inline bool is_pinnable_page(struct page *page)
+{
+	return !(zone_idx(page_zone(page)) == ZONE_MOVABLE ||
+		 is_migrate_cma_page(page));
+}
+
 static inline int vm_fault_to_errno(vm_fault_t vm_fault, int foll_flags)
 {
 	if (vm_fault & VM_FAULT_OOM)
@@ -9,6 +9,7 @@
 #include <linux/spinlock.h>
 #include <linux/rbtree.h>
 #include <linux/rwsem.h>
+#include <linux/seqlock.h>
 #include <linux/completion.h>
 #include <linux/cpumask.h>
 #include <linux/uprobes.h>
@@ -351,6 +352,16 @@ struct vm_area_struct {
 #endif
 #ifdef CONFIG_NUMA
 	struct mempolicy *vm_policy;	/* NUMA policy for the VMA */
+#endif
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	/*
+	 * Odd, or changed between two reads: the vma is (or was) being
+	 * modified and speculative page fault handlers must bail out.
+	 * Written under mmap_sem held for writing.
+	 */
+	seqcount_t vm_sequence;
+	/* Allows the vma to outlive its unlink from the mm (see put_vma()) */
+	atomic_t vm_ref_count;
 #endif
 	struct vm_userfaultfd_ctx vm_userfaultfd_ctx;
 } __randomize_layout;
@@ -371,6 +382,13 @@ struct mm_struct {
 	struct {
 		struct vm_area_struct *mmap;		/* list of VMAs */
 		struct rb_root mm_rb;
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+		/*
+		 * Allows speculative page fault handlers to walk mm_rb
+		 * without the mmap_sem. Nests inside the mmap_sem.
+		 */
+		rwlock_t mm_rb_lock;
+#endif
 		u64 vmacache_seqnum;                   /* per-thread vmacache */
 #ifdef CONFIG_MMU
 		unsigned long (*get_unmapped_area) (struct file *filp,
@@ -524,6 +542,13 @@ struct mm_struct {
 		atomic_long_t hugetlb_usage;
 #endif
 		struct work_struct async_put_work;
+
+#ifdef CONFIG_RSEQ
+		/*
+		 * Protects the concurrency id bitmap at mm_cidmask().
+		 */
+		raw_spinlock_t cid_lock;
+#endif
 	} __randomize_layout;
 
 	/*
@@ -550,6 +575,40 @@ static inline cpumask_t *mm_cpumask(struct mm_struct *mm)
 	return (struct cpumask *)&mm->cpu_bitmap;
 }
 
+#ifdef CONFIG_RSEQ
+/*
+ * The concurrency id bitmap is dynamically sized like mm_cpumask() and
+ * stored right after it at the end of mm_struct.
+ */
+static inline struct cpumask *mm_cidmask(struct mm_struct *mm)
+{
+	unsigned long cid_bitmap = (unsigned long)mm;
+
+	cid_bitmap += offsetof(struct mm_struct, cpu_bitmap);
+	cid_bitmap += cpumask_size();
+	return (struct cpumask *)cid_bitmap;
+}
+
+static inline void mm_init_cid(struct mm_struct *mm)
+{
+	raw_spin_lock_init(&mm->cid_lock);
+	cpumask_clear(mm_cidmask(mm));
+}
+
+static inline unsigned int mm_cid_size(void)
+{
+	return cpumask_size();
+}
+#else /* CONFIG_RSEQ */
+static inline void mm_init_cid(struct mm_struct *mm)
+{
+}
+static inline unsigned int mm_cid_size(void)
+{
+	return 0;
+}
+#endif /* CONFIG_RSEQ */
+
 struct mmu_gather;
 extern void tlb_gather_mmu(struct mmu_gather *tlb, struct mm_struct *mm,
 				unsigned long start, unsigned long end);
@@ -336,10 +336,14 @@ struct napi_struct {
 	struct sk_buff		*skb;
 	struct list_head	rx_list; /* Pending GRO_NORMAL skbs */
 	int			rx_count; /* length of rx_list */
+	int			defer_hard_irqs_count;
+	u64			gro_ns_per_pkt; /* EWMA, for adaptive flush */
+	u64			gro_last_done;
 	struct hrtimer		timer;
 	struct list_head	dev_list;
 	struct hlist_node	napi_hash_node;
 	unsigned int		napi_id;
+	struct task_struct	*thread;
 };
 
 enum {
@@ -350,6 +354,7 @@ enum {
 	NAPI_STATE_HASHED,	/* In NAPI hash (busy polling possible) */
 	NAPI_STATE_NO_BUSY_POLL,/* Do not add in napi_hash, no busy polling */
 	NAPI_STATE_IN_BUSY_POLL,/* sk_busy_loop() owns this NAPI */
+	NAPI_STATE_THREADED,	/* The poll is performed inside its own thread*/
 };
 
 enum {
@@ -360,6 +365,7 @@ enum {
 	NAPIF_STATE_HASHED	 = BIT(NAPI_STATE_HASHED),
 	NAPIF_STATE_NO_BUSY_POLL = BIT(NAPI_STATE_NO_BUSY_POLL),
 	NAPIF_STATE_IN_BUSY_POLL = BIT(NAPI_STATE_IN_BUSY_POLL),
+	NAPIF_STATE_THREADED	 = BIT(NAPI_STATE_THREADED),
 };
 
 enum gro_result {
@@ -504,6 +510,17 @@ bool napi_hash_del(struct napi_struct *napi);
  */
 void napi_disable(struct napi_struct *n);
 
+/**
+ *	dev_set_threaded - set or clear threaded mode for a device's NAPIs
+ *	@dev: network device
+ *	@threaded: whether each NAPI should be polled from a kthread
+ *
+ * In threaded mode every NAPI instance of the device is serviced by its
+ * own kthread instead of from softirq context, so the scheduler can
+ * spread receive processing across CPUs. Caller must hold RTNL.
+ */
+int dev_set_threaded(struct net_device *dev, bool threaded);
+
 /**
  *	napi_enable - enable NAPI scheduling
  *	@n: NAPI context
@@ -712,6 +729,11 @@ struct rps_sock_flow_table {
 
 extern u32 rps_cpu_mask;
 extern struct rps_sock_flow_table __rcu *rps_sock_flow_table;
+extern int rps_sock_flow_autosize;
+extern atomic_long_t rps_sock_flow_collisions;
+
+int rps_sock_flow_table_set(unsigned int size);
+void rps_sock_flow_collision(const struct rps_sock_flow_table *table);
 
 static inline void rps_record_sock_flow(struct rps_sock_flow_table *table,
 					u32 hash)
@@ -723,8 +745,17 @@ static inline void rps_record_sock_flow(struct rps_sock_flow_table *table,
 		/* We only give a hint, preemption can change CPU under us */
 		val |= raw_smp_processor_id();
 
-		if (table->ents[index] != val)
+		if (table->ents[index] != val) {
+			/* Overwriting a live entry recorded for a different
+			 * hash means the table is too small for the socket
+			 * population: account it, and grow the table if
+			 * autosizing is enabled.
+			 */
+			if (table->ents[index] != RPS_NO_CPU &&
+			    ((table->ents[index] ^ val) & ~rps_cpu_mask))
+				rps_sock_flow_collision(table);
 			table->ents[index] = val;
+		}
 	}
 }
 
@@ -739,6 +770,8 @@ struct netdev_rx_queue {
 #ifdef CONFIG_RPS
 	struct rps_map __rcu		*rps_map;
 	struct rps_dev_flow_table __rcu	*rps_flow_table;
+	atomic_long_t			rps_flow_hits;
+	atomic_long_t			rps_flow_misses;
 #endif
 	struct kobject			kobj;
 	struct net_device		*dev;
@@ -746,6 +779,11 @@ struct netdev_rx_queue {
 #ifdef CONFIG_XDP_SOCKETS
 	struct xdp_umem                 *umem;
 #endif
+	/* Receive buffer layout hints, set via sysfs and consumed by the
+	 * driver the next time it (re)builds this queue's buffer pool.
+	 */
+	unsigned int			payload_pool_order;
+	bool				header_split;
 } ____cacheline_aligned_in_smp;
 
 /*
@@ -850,6 +888,7 @@ enum tc_setup_type {
 	TC_SETUP_ROOT_QDISC,
 	TC_SETUP_QDISC_GRED,
 	TC_SETUP_QDISC_TAPRIO,
+	TC_SETUP_FT,
 };
 
 /* These structures hold the attributes of bpf state that are being passed
@@ -1947,6 +1986,8 @@ struct net_device {
 
 	struct bpf_prog __rcu	*xdp_prog;
 	unsigned long		gro_flush_timeout;
+	unsigned int		napi_defer_hard_irqs;
+	unsigned int		gro_adaptive_flush;
 	rx_handler_func_t __rcu	*rx_handler;
 	void __rcu		*rx_handler_data;
 
@@ -2066,6 +2107,7 @@ struct net_device {
 	struct lock_class_key	addr_list_lock_key;
 	bool			proto_down;
 	unsigned		wol_enabled:1;
+	unsigned		threaded:1;
 };
 #define to_net_dev(d) container_of(d, struct net_device, dev)
 
@@ -3563,6 +3605,26 @@ __netif_get_rx_queue(struct net_device *dev, unsigned int rxq)
 	return dev->_rx + rxq;
 }
 
+/* Page order a driver should use for this queue's payload buffer pool.
+ * Larger orders let pools sit on huge-page backed memory, which keeps
+ * payload pages out of the slab and cheap to map for zerocopy receive.
+ */
+static inline unsigned int
+netdev_rx_queue_pool_order(const struct net_device *dev, unsigned int rxq)
+{
+	return dev->_rx[rxq].payload_pool_order;
+}
+
+/* True when the driver should copy packet headers into the skb linear
+ * area and attach the payload as a page fragment, so that headers stay
+ * in slab while payload pages remain cheap to map or flip.
+ */
+static inline bool
+netdev_rx_queue_header_split(const struct net_device *dev, unsigned int rxq)
+{
+	return dev->_rx[rxq].header_split;
+}
+
 #ifdef CONFIG_SYSFS
 static inline unsigned int get_netdev_rx_queue_index(
 		struct netdev_rx_queue *queue)
@@ -12,6 +12,7 @@
 #include <linux/atomic.h>
 #include <linux/compiler.h>
 #include <linux/mutex.h>
+#include <linux/percpu_counter.h>
 #include <linux/workqueue.h>
 
 struct rhash_head {
@@ -76,7 +77,8 @@ struct rhashtable_params {
  * @run_work: Deferred worker to expand/shrink asynchronously
  * @mutex: Mutex to protect current/future table swapping
  * @lock: Spin lock to protect walker list
- * @nelems: Number of elements in table
+ * @nelems: Number of elements in table, kept per-CPU so that insertions
+ *	    and removals do not bounce a shared counter between CPUs
  */
 struct rhashtable {
 	struct bucket_table __rcu	*tbl;
@@ -87,7 +89,7 @@ struct rhashtable {
 	struct work_struct		run_work;
 	struct mutex                    mutex;
 	spinlock_t			lock;
-	atomic_t			nelems;
+	struct percpu_counter		nelems;
 };
 
 /**
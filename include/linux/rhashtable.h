@@ -179,11 +179,11 @@ static inline unsigned int rht_head_hashfn(
  * @ht:		hash table
  * @tbl:	current table
  */
-static inline bool rht_grow_above_75(const struct rhashtable *ht,
+static inline bool rht_grow_above_75(struct rhashtable *ht,
 				     const struct bucket_table *tbl)
 {
 	/* Expand table when exceeding 75% load */
-	return atomic_read(&ht->nelems) > (tbl->size / 4 * 3) &&
+	return percpu_counter_read_positive(&ht->nelems) > (tbl->size / 4 * 3) &&
 	       (!ht->p.max_size || tbl->size < ht->p.max_size);
 }
 
@@ -192,11 +192,11 @@ static inline bool rht_grow_above_75(const struct rhashtable *ht,
  * @ht:		hash table
  * @tbl:	current table
  */
-static inline bool rht_shrink_below_30(const struct rhashtable *ht,
+static inline bool rht_shrink_below_30(struct rhashtable *ht,
 				       const struct bucket_table *tbl)
 {
 	/* Shrink table beneath 30% load */
-	return atomic_read(&ht->nelems) < (tbl->size * 3 / 10) &&
+	return percpu_counter_read_positive(&ht->nelems) < (tbl->size * 3 / 10) &&
 	       tbl->size > ht->p.min_size;
 }
 
@@ -205,10 +205,10 @@ static inline bool rht_shrink_below_30(const struct rhashtable *ht,
  * @ht:		hash table
  * @tbl:	current table
  */
-static inline bool rht_grow_above_100(const struct rhashtable *ht,
+static inline bool rht_grow_above_100(struct rhashtable *ht,
 				      const struct bucket_table *tbl)
 {
-	return atomic_read(&ht->nelems) > tbl->size &&
+	return percpu_counter_read_positive(&ht->nelems) > tbl->size &&
 		(!ht->p.max_size || tbl->size < ht->p.max_size);
 }
 
@@ -217,10 +217,14 @@ static inline bool rht_grow_above_100(const struct rhashtable *ht,
  * @ht:		hash table
  * @tbl:	current table
  */
-static inline bool rht_grow_above_max(const struct rhashtable *ht,
+static inline bool rht_grow_above_max(struct rhashtable *ht,
 				      const struct bucket_table *tbl)
 {
-	return atomic_read(&ht->nelems) >= ht->max_elems;
+	/*
+	 * This is a hard limit, so fold the per-CPU deltas once the
+	 * cheap read gets anywhere near it.
+	 */
+	return percpu_counter_compare(&ht->nelems, ht->max_elems) >= 0;
 }
 
 #ifdef CONFIG_PROVE_LOCKING
@@ -792,7 +796,7 @@ slow_path:
 		RCU_INIT_POINTER(list->next, NULL);
 	}
 
-	atomic_inc(&ht->nelems);
+	percpu_counter_inc(&ht->nelems);
 	rht_assign_unlock(tbl, bkt, obj);
 
 	if (rht_grow_above_75(ht, tbl))
@@ -1061,7 +1065,7 @@ static inline int __rhashtable_remove_fast_one(
 	rht_unlock(tbl, bkt);
 unlocked:
 	if (err > 0) {
-		atomic_dec(&ht->nelems);
+		percpu_counter_dec(&ht->nelems);
 		if (unlikely(ht->p.automatic_shrinking &&
 			     rht_shrink_below_30(ht, tbl)))
 			schedule_work(&ht->run_work);
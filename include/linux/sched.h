@@ -542,12 +542,21 @@ struct sched_dl_entity {
 	 *
 	 * @dl_overrun tells if the task asked to be informed about runtime
 	 * overruns.
+	 *
+	 * @dl_server tells if this is a server entity: it is not attached
+	 * to a task but to a runqueue, and its budget backs the execution
+	 * of entities of a lower scheduling class picked via @server_pick.
+	 *
+	 * @dl_server_active tells if the server has been started and has
+	 * not been stopped yet (it may be throttled in between).
 	 */
 	unsigned int			dl_throttled      : 1;
 	unsigned int			dl_boosted        : 1;
 	unsigned int			dl_yielded        : 1;
 	unsigned int			dl_non_contending : 1;
 	unsigned int			dl_overrun	  : 1;
+	unsigned int			dl_server         : 1;
+	unsigned int			dl_server_active  : 1;
 
 	/*
 	 * Bandwidth enforcement timer. Each -deadline task has its
@@ -563,6 +572,14 @@ struct sched_dl_entity {
 	 * time.
 	 */
 	struct hrtimer inactive_timer;
+
+	/*
+	 * Server entities are not bound to a task; they run on behalf of
+	 * the runqueue they belong to and pick what to run through the
+	 * @server_pick callback of the class they serve.
+	 */
+	struct rq			*rq;
+	struct task_struct *(*server_pick)(struct sched_dl_entity *dl_se);
 };
 
 #ifdef CONFIG_UCLAMP_TASK
@@ -671,6 +688,7 @@ struct task_struct {
 	int				static_prio;
 	int				normal_prio;
 	unsigned int			rt_priority;
+	int				latency_nice;
 
 	const struct sched_class	*sched_class;
 	struct sched_entity		se;
@@ -680,6 +698,15 @@ struct task_struct {
 #endif
 	struct sched_dl_entity		dl;
 
+#ifdef CONFIG_SCHED_SMT
+	/*
+	 * Core scheduling cookie, managed through prctl(PR_SCHED_CORE).
+	 * The wakeup path keeps tasks with different cookies off the same
+	 * SMT core. Inherited over fork.
+	 */
+	unsigned long			core_cookie;
+#endif
+
 #ifdef CONFIG_UCLAMP_TASK
 	/* Clamp values requested for a scheduling entity */
 	struct uclamp_se		uclamp_req[UCLAMP_CNT];
@@ -1129,6 +1156,13 @@ struct task_struct {
 	 * with respect to preemption.
 	 */
 	unsigned long rseq_event_mask;
+	/*
+	 * Concurrency id held in the mm's cid bitmap while the task is
+	 * running, -1 otherwise.  Only maintained (mm_cid_active) while
+	 * an rseq area is registered.
+	 */
+	int				mm_cid;
+	int				mm_cid_active;
 #endif
 
 	struct tlbflush_unmap_batch	tlb_ubc;
@@ -1519,6 +1553,7 @@ static inline bool is_percpu_thread(void)
 #define PFA_SPEC_IB_DISABLE		5	/* Indirect branch speculation restricted */
 #define PFA_SPEC_IB_FORCE_DISABLE	6	/* Indirect branch speculation permanently restricted */
 #define PFA_SPEC_SSB_NOEXEC		7	/* Speculative Store Bypass clear on execve() */
+#define PFA_TIMER_HOUSEKEEP		8	/* Expire timer wheel timers on housekeeping CPUs */
 
 #define TASK_PFA_TEST(name, func)					\
 	static inline bool task_##func(struct task_struct *p)		\
@@ -1561,6 +1596,10 @@ TASK_PFA_CLEAR(SPEC_IB_DISABLE, spec_ib_disable)
 TASK_PFA_TEST(SPEC_IB_FORCE_DISABLE, spec_ib_force_disable)
 TASK_PFA_SET(SPEC_IB_FORCE_DISABLE, spec_ib_force_disable)
 
+TASK_PFA_TEST(TIMER_HOUSEKEEP, timer_housekeep)
+TASK_PFA_SET(TIMER_HOUSEKEEP, timer_housekeep)
+TASK_PFA_CLEAR(TIMER_HOUSEKEEP, timer_housekeep)
+
 static inline void
 current_restore_flags(unsigned long orig_flags, unsigned long flags)
 {
@@ -1851,6 +1890,16 @@ static inline bool vcpu_is_preempted(int cpu)
 #endif
 
 extern long sched_setaffinity(pid_t pid, const struct cpumask *new_mask);
+
+#ifdef CONFIG_SCHED_SMT
+extern int sched_core_prctl(int op, pid_t pid, unsigned long __user *uaddr);
+#else
+static inline int sched_core_prctl(int op, pid_t pid,
+				   unsigned long __user *uaddr)
+{
+	return -EINVAL;
+}
+#endif
 extern long sched_getaffinity(pid_t pid, struct cpumask *mask);
 
 #ifndef TASK_SIZE_OF
@@ -1928,6 +1977,8 @@ static inline void rseq_fork(struct task_struct *t, unsigned long clone_flags)
 		t->rseq_sig = current->rseq_sig;
 		t->rseq_event_mask = current->rseq_event_mask;
 	}
+	t->mm_cid = -1;
+	t->mm_cid_active = !!t->rseq;
 }
 
 static inline void rseq_execve(struct task_struct *t)
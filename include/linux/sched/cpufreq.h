@@ -10,6 +10,7 @@
 
 #define SCHED_CPUFREQ_IOWAIT	(1U << 0)
 #define SCHED_CPUFREQ_MIGRATION	(1U << 1)
+#define SCHED_CPUFREQ_RAMP_BOOST	(1U << 2)
 
 #ifdef CONFIG_CPU_FREQ
 struct cpufreq_policy;
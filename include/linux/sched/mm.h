@@ -392,4 +392,16 @@ static inline void membarrier_mm_sync_core_before_usermode(struct mm_struct *mm)
 }
 #endif
 
+#ifdef CONFIG_RSEQ
+extern void sched_mm_cid_activate(struct task_struct *t);
+extern void sched_mm_cid_exit(struct task_struct *t);
+#else
+static inline void sched_mm_cid_activate(struct task_struct *t)
+{
+}
+static inline void sched_mm_cid_exit(struct task_struct *t)
+{
+}
+#endif
+
 #endif /* _LINUX_SCHED_MM_H */
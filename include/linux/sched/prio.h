@@ -6,6 +6,18 @@
 #define MIN_NICE	-20
 #define NICE_WIDTH	(MAX_NICE - MIN_NICE + 1)
 
+/*
+ * latency_nice tells the scheduler how much latency a task is willing to
+ * trade for throughput.  It follows the nice convention: higher values mean
+ * the task tolerates more scheduling latency, lower values mean it wants the
+ * CPU as soon as it wakes.  It only affects scheduling heuristics (wakeup
+ * preemption, idle CPU search), never the task's share of CPU time.
+ */
+#define MAX_LATENCY_NICE	19
+#define MIN_LATENCY_NICE	-20
+#define LATENCY_NICE_WIDTH	(MAX_LATENCY_NICE - MIN_LATENCY_NICE + 1)
+#define DEFAULT_LATENCY_NICE	0
+
 /*
  * Priority of a process goes from 0..MAX_PRIO-1, valid RT
  * priority is 0..MAX_RT_PRIO-1, and SCHED_NORMAL/SCHED_BATCH
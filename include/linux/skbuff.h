@@ -2826,6 +2826,10 @@ static inline struct sk_buff *napi_alloc_skb(struct napi_struct *napi,
 {
 	return __napi_alloc_skb(napi, length, GFP_ATOMIC);
 }
+struct sk_buff *napi_skb_header_split(struct napi_struct *napi,
+				      struct page *page, unsigned int offset,
+				      unsigned int len, unsigned int hlen,
+				      unsigned int truesize);
 void napi_consume_skb(struct sk_buff *skb, int budget);
 
 void __kfree_skb_flush(void);
@@ -81,6 +81,18 @@ struct sk_psock_work_state {
 	u32				off;
 };
 
+/* Cached skb verdict for an established flow, refreshed whenever the
+ * verdict program runs.  Only touched from the strparser callbacks,
+ * which are serialized per socket, until psock teardown.
+ */
+struct sk_psock_verdict_cache {
+	struct sock			*sk_redir;
+	int				verdict;
+	u32				flags;
+	u32				bytes_left;
+	unsigned long			expires;
+};
+
 struct sk_psock {
 	struct sock			*sk;
 	struct sock			*sk_redir;
@@ -90,6 +102,7 @@ struct sk_psock {
 	struct sk_msg			*cork;
 	struct sk_psock_progs		progs;
 	struct sk_psock_parser		parser;
+	struct sk_psock_verdict_cache	verdict_cache;
 	struct sk_buff_head		ingress_skb;
 	struct list_head		ingress_msg;
 	unsigned long			state;
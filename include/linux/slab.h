@@ -404,6 +404,28 @@ void kmem_cache_free(struct kmem_cache *, void *);
 void kmem_cache_free_bulk(struct kmem_cache *, size_t, void **);
 int kmem_cache_alloc_bulk(struct kmem_cache *, gfp_t, size_t, void **);
 
+/*
+ * Layer a percpu object array ("sheaf") above the cache's cpu freelists.
+ * Sheaves absorb frees locally and can be prefilled so that a burst of
+ * up to @count allocations is served without touching slab locks.
+ */
+#ifdef CONFIG_SLUB
+int kmem_cache_setup_sheaves(struct kmem_cache *s, unsigned int capacity);
+int kmem_cache_prefill_sheaf(struct kmem_cache *s, gfp_t gfp,
+			     unsigned int count);
+#else
+static inline int kmem_cache_setup_sheaves(struct kmem_cache *s,
+					   unsigned int capacity)
+{
+	return -EOPNOTSUPP;
+}
+static inline int kmem_cache_prefill_sheaf(struct kmem_cache *s, gfp_t gfp,
+					   unsigned int count)
+{
+	return -EOPNOTSUPP;
+}
+#endif
+
 /*
  * Caller must not use kfree_bulk() on memory not originally allocated
  * by kmalloc(), because the SLOB allocator cannot handle this.
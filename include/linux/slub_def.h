@@ -79,8 +79,21 @@ struct kmem_cache_order_objects {
 /*
  * Slab cache management.
  */
+/*
+ * Optional percpu array ("sheaf") layered above the regular cpu slab
+ * freelists. It batch-absorbs frees and can be prefilled so that bursty
+ * consumers are guaranteed a run of lockless allocations.
+ */
+struct kmem_cache_sheaf {
+	unsigned int count;
+	void *objects[];
+};
+
 struct kmem_cache {
 	struct kmem_cache_cpu __percpu *cpu_slab;
+	/* Optional percpu object array, see kmem_cache_setup_sheaves() */
+	struct kmem_cache_sheaf __percpu *cpu_sheaf;
+	unsigned int sheaf_capacity;
 	/* Used for retrieving partial slabs, etc. */
 	slab_flags_t flags;
 	unsigned long min_partial;
@@ -18,6 +18,10 @@ unsigned int stack_trace_save(unsigned long *store, unsigned int size,
 unsigned int stack_trace_save_tsk(struct task_struct *task,
 				  unsigned long *store, unsigned int size,
 				  unsigned int skipnr);
+unsigned int stack_trace_save_tsk_bulk(struct task_struct **tasks,
+				       unsigned int nr_tasks,
+				       unsigned long *store, unsigned int size,
+				       unsigned int *lens, unsigned int skipnr);
 unsigned int stack_trace_save_regs(struct pt_regs *regs, unsigned long *store,
 				   unsigned int size, unsigned int skipnr);
 unsigned int stack_trace_save_user(unsigned long *store, unsigned int size);
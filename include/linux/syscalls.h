@@ -48,6 +48,7 @@ struct stat64;
 struct statfs;
 struct statfs64;
 struct statx;
+struct statx_dirent;
 struct __sysctl_args;
 struct sysinfo;
 struct timespec;
@@ -68,6 +69,7 @@ struct sigaltstack;
 struct rseq;
 union bpf_attr;
 struct io_uring_params;
+struct futex_waitv;
 struct clone_args;
 
 #include <linux/types.h>
@@ -453,6 +455,9 @@ asmlinkage long sys_quotactl(unsigned int cmd, const char __user *special,
 asmlinkage long sys_getdents64(unsigned int fd,
 				struct linux_dirent64 __user *dirent,
 				unsigned int count);
+asmlinkage long sys_getdents_statx(unsigned int fd,
+				struct statx_dirent __user *dirent,
+				unsigned int count, unsigned int mask);
 
 /* fs/read_write.c */
 asmlinkage long sys_llseek(unsigned int fd, unsigned long offset_high,
@@ -575,6 +580,10 @@ asmlinkage long sys_unshare(unsigned long unshare_flags);
 asmlinkage long sys_futex(u32 __user *uaddr, int op, u32 val,
 			struct __kernel_timespec __user *utime, u32 __user *uaddr2,
 			u32 val3);
+asmlinkage long sys_futex_waitv(struct futex_waitv __user *waiters,
+				unsigned int nr_futexes, unsigned int flags,
+				struct __kernel_timespec __user *timeout,
+				clockid_t clockid);
 asmlinkage long sys_futex_time32(u32 __user *uaddr, int op, u32 val,
 			struct old_timespec32 __user *utime, u32 __user *uaddr2,
 			u32 val3);
@@ -874,6 +883,8 @@ asmlinkage long sys_munlockall(void);
 asmlinkage long sys_mincore(unsigned long start, size_t len,
 				unsigned char __user * vec);
 asmlinkage long sys_madvise(unsigned long start, size_t len, int behavior);
+asmlinkage long sys_process_madvise(int pidfd, const struct iovec __user *vec,
+			size_t vlen, int behavior, unsigned int flags);
 asmlinkage long sys_remap_file_pages(unsigned long start, unsigned long size,
 			unsigned long prot, unsigned long pgoff,
 			unsigned long flags);
@@ -358,6 +358,9 @@ struct tcp_sock {
 
 	u32 rcv_ooopack; /* Received out-of-order packets, for tcpinfo */
 
+	u64 rcv_zc_bytes;  /* Bytes mapped by zerocopy receive, for tcpinfo */
+	u64 rcv_zc_copied; /* Zerocopy receive fallback copies, for tcpinfo */
+
 /* Receiver side RTT estimation */
 	u32 rcv_rtt_last_tsecr;
 	struct {
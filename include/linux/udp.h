@@ -89,6 +89,23 @@ struct udp_sock {
 
 	/* This field is dirtied by udp_recvmsg() */
 	int		forward_deficit;
+
+	/* Route cached from the last send of an unconnected socket, so
+	 * that repeated sends to the same destination skip the fib
+	 * lookup.  Keyed on the output flow and revalidated through
+	 * dst->ops->check(), which fails once the route genid moves on;
+	 * see udp_rtcache_get().
+	 */
+	seqlock_t	 rtcache_lock;
+	struct dst_entry *rtcache_dst;
+	__be32		 rtcache_daddr;
+	__be32		 rtcache_saddr;
+	__be32		 rtcache_prefsrc;
+	__be16		 rtcache_dport;
+	int		 rtcache_oif;
+	__u32		 rtcache_mark;
+	__u8		 rtcache_tos;
+	__u8		 rtcache_flow_flags;
 };
 
 #define UDP_MAX_SEGMENTS	(1 << 6UL)
@@ -134,6 +134,26 @@ struct rcu_work {
  *
  * This can be used to change attributes of an unbound workqueue.
  */
+/**
+ * enum wq_affn_scope - affinity scope for unbound work item placement
+ * @WQ_AFFN_NUMA: place work on the NUMA node pool of the queueing CPU
+ * @WQ_AFFN_CACHE: prefer the queueing CPU's cache domain
+ * @WQ_AFFN_SMT: prefer the queueing CPU's SMT siblings
+ * @WQ_AFFN_CPU: prefer the queueing CPU itself
+ *
+ * Scopes narrower than %WQ_AFFN_NUMA keep a work item inside the given
+ * topology domain by running it on a per-cpu pool, spilling back to the
+ * NUMA node pool when the whole domain is busy.
+ */
+enum wq_affn_scope {
+	WQ_AFFN_NUMA,
+	WQ_AFFN_CACHE,
+	WQ_AFFN_SMT,
+	WQ_AFFN_CPU,
+
+	WQ_AFFN_NR_TYPES,
+};
+
 struct workqueue_attrs {
 	/**
 	 * @nice: nice level
@@ -153,6 +173,15 @@ struct workqueue_attrs {
 	 * doesn't participate in pool hash calculations or equality comparisons.
 	 */
 	bool no_numa;
+
+	/**
+	 * @affn_scope: affinity scope for unbound work item placement
+	 *
+	 * Like ``no_numa``, this only affects where work items are queued and
+	 * isn't a property of a worker_pool; it doesn't participate in pool
+	 * hash calculations or equality comparisons.
+	 */
+	int affn_scope;
 };
 
 static inline struct delayed_work *to_delayed_work(struct work_struct *work)
@@ -60,6 +60,11 @@ struct unix_sock {
 	struct list_head	link;
 	atomic_long_t		inflight;
 	spinlock_t		lock;
+	/* datagram reader-private queue, refilled in batches from
+	 * sk_receive_queue so that senders and the reader do not
+	 * serialize on the same lock; see unix_dgram_recv_skb().
+	 */
+	struct sk_buff_head	reader_queue;
 	unsigned long		gc_flags;
 #define UNIX_GC_CANDIDATE	0
 #define UNIX_GC_MAYBE_CYCLE	1
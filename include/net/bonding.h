@@ -136,6 +136,7 @@ struct bond_params {
 	int lp_interval;
 	int packets_per_slave;
 	int tlb_dynamic_lb;
+	int xmit_rebalance;
 	struct reciprocal_value reciprocal_packets_per_slave;
 	u16 ad_actor_sys_prio;
 	u16 ad_user_port_key;
@@ -178,6 +179,7 @@ struct slave {
 	struct delayed_work notify_work;
 	struct kobject kobj;
 	struct rtnl_link_stats64 slave_stats;
+	u64 rebalance_tx_bytes; /* tx_bytes at the last rebalance check */
 };
 
 struct bond_up_slave {
@@ -222,6 +224,10 @@ struct bonding {
 #endif /* CONFIG_PROC_FS */
 	struct   list_head bond_list;
 	u32      rr_tx_counter;
+	u32      xmit_salt; /* folded into the slave selection hash, reseeded
+			     * by the rebalance monitor to break up link
+			     * hot-spots in XOR/802.3ad modes
+			     */
 	struct   ad_bond_info ad_info;
 	struct   alb_bond_info alb_info;
 	struct   bond_params params;
@@ -232,6 +238,7 @@ struct bonding {
 	struct   delayed_work ad_work;
 	struct   delayed_work mcast_work;
 	struct   delayed_work slave_arr_work;
+	struct   delayed_work rebalance_work;
 #ifdef CONFIG_DEBUG_FS
 	/* debugging support via debugfs */
 	struct	 dentry *debug_dir;
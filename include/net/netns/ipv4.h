@@ -169,6 +169,7 @@ struct netns_ipv4 {
 	int sysctl_tcp_rmem[3];
 	int sysctl_tcp_comp_sack_nr;
 	unsigned long sysctl_tcp_comp_sack_delay_ns;
+	unsigned long sysctl_tcp_comp_sack_slack_ns;
 	struct inet_timewait_death_row tcp_death_row;
 	int sysctl_max_syn_backlog;
 	int sysctl_tcp_fastopen;
@@ -212,6 +213,8 @@ struct netns_ipv4 {
 	int sysctl_fib_multipath_use_neigh;
 	int sysctl_fib_multipath_hash_policy;
 #endif
+	int sysctl_fnhe_reclaim_depth;
+	int sysctl_fnhe_stale_timeout;
 
 	struct fib_notifier_ops	*notifier_ops;
 	unsigned int	fib_seq;	/* protected by rtnl_mutex */
@@ -2559,6 +2559,9 @@ extern __u32 sysctl_rmem_max;
 extern int sysctl_tstamp_allow_data;
 extern int sysctl_optmem_max;
 
+extern int sysctl_sockmap_verdict_cache_bytes;
+extern int sysctl_sockmap_verdict_cache_ms;
+
 extern __u32 sysctl_wmem_default;
 extern __u32 sysctl_rmem_default;
 
@@ -1910,6 +1910,8 @@ struct tcp_seq_afinfo {
 
 struct tcp_iter_state {
 	struct seq_net_private	p;
+	/* Set instead of the procfs entry's data for BPF iterators */
+	struct tcp_seq_afinfo	*bpf_seq_afinfo;
 	enum tcp_seq_states	state;
 	struct sock		*syn_wait_sk;
 	int			bucket, offset, sbucket, num;
@@ -176,6 +176,11 @@ struct tls_sw_context_rx {
 
 	struct sk_buff *recv_pkt;
 	u8 control;
+	/* Inner content type of a TLS 1.3 record decrypted directly into
+	 * the user's pages; only valid right after a zero-copy decryption
+	 * (TLS 1.3 rx is always synchronous).
+	 */
+	u8 rx_tail;
 	int async_capable;
 	bool decrypted;
 	atomic_t decrypt_pending;
@@ -439,6 +439,8 @@ struct udp_seq_afinfo {
 
 struct udp_iter_state {
 	struct seq_net_private  p;
+	/* Set instead of the procfs entry's data for BPF iterators */
+	struct udp_seq_afinfo	*bpf_seq_afinfo;
 	int			bucket;
 };
 
@@ -849,10 +849,20 @@ __SYSCALL(__NR_pidfd_open, sys_pidfd_open)
 #ifdef __ARCH_WANT_SYS_CLONE3
 #define __NR_clone3 435
 __SYSCALL(__NR_clone3, sys_clone3)
+
+#define __NR_futex_waitv 436
+__SYSCALL(__NR_futex_waitv, sys_futex_waitv)
+
+#define __NR_process_madvise 437
+__SC_COMP(__NR_process_madvise, sys_process_madvise, \
+	  compat_sys_process_madvise)
 #endif
 
+#define __NR_getdents_statx 438
+__SYSCALL(__NR_getdents_statx, sys_getdents_statx)
+
 #undef __NR_syscalls
-#define __NR_syscalls 436
+#define __NR_syscalls 439
 
 /*
  * 32 bit systems traditionally used different
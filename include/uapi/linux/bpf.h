@@ -107,6 +107,10 @@ enum bpf_cmd {
 	BPF_MAP_LOOKUP_AND_DELETE_ELEM,
 	BPF_MAP_FREEZE,
 	BPF_BTF_GET_NEXT_ID,
+	BPF_MAP_LOOKUP_BATCH,
+	BPF_MAP_UPDATE_BATCH,
+	BPF_MAP_DELETE_BATCH,
+	BPF_ITER_CREATE,
 };
 
 enum bpf_map_type {
@@ -173,6 +177,7 @@ enum bpf_prog_type {
 	BPF_PROG_TYPE_CGROUP_SYSCTL,
 	BPF_PROG_TYPE_RAW_TRACEPOINT_WRITABLE,
 	BPF_PROG_TYPE_CGROUP_SOCKOPT,
+	BPF_PROG_TYPE_ITER,
 };
 
 enum bpf_attach_type {
@@ -396,6 +401,23 @@ union bpf_attr {
 		__u64		flags;
 	};
 
+	struct { /* struct used by BPF_MAP_*_BATCH commands */
+		__aligned_u64	in_batch;	/* start batch,
+						 * NULL to start from beginning
+						 */
+		__aligned_u64	out_batch;	/* output: next start batch */
+		__aligned_u64	keys;
+		__aligned_u64	values;
+		__u32		count;		/* input/output:
+						 * input: # of key/value
+						 * elements
+						 * output: # of filled elements
+						 */
+		__u32		map_fd;
+		__u64		elem_flags;
+		__u64		flags;
+	} batch;
+
 	struct { /* anonymous struct used by BPF_PROG_LOAD command */
 		__u32		prog_type;	/* one of enum bpf_prog_type */
 		__u32		insn_cnt;
@@ -487,6 +509,12 @@ union bpf_attr {
 		__u32 prog_fd;
 	} raw_tracepoint;
 
+	struct { /* struct used by BPF_ITER_CREATE command */
+		__aligned_u64	target;		/* target name string */
+		__u32		prog_fd;
+		__u32		flags;
+	} iter_create;
+
 	struct { /* anonymous struct for BPF_BTF_LOAD */
 		__aligned_u64	btf;
 		__aligned_u64	btf_log_buf;
@@ -2750,6 +2778,17 @@ union bpf_attr {
  *		**-EOPNOTSUPP** kernel configuration does not enable SYN cookies
  *
  *		**-EPROTONOSUPPORT** IP packet version is not 4 or 6
+ *
+ * int bpf_seq_write(struct bpf_iter_ctx *ctx, const void *data, u32 len)
+ *	Description
+ *		Append *len* bytes from *data* to the output of the iterator
+ *		given by *ctx*.  Only usable by programs of type
+ *		**BPF_PROG_TYPE_ITER**; the written bytes become the result
+ *		of **read**\ (2) on the iterator file descriptor.
+ *	Return
+ *		0 on success, or **-EOVERFLOW** if the record did not fit in
+ *		the output buffer.  The object is revisited with a larger
+ *		buffer in that case and the partial output is discarded.
  */
 #define __BPF_FUNC_MAPPER(FN)		\
 	FN(unspec),			\
@@ -2862,7 +2901,8 @@ union bpf_attr {
 	FN(sk_storage_get),		\
 	FN(sk_storage_delete),		\
 	FN(send_signal),		\
-	FN(tcp_gen_syncookie),
+	FN(tcp_gen_syncookie),		\
+	FN(seq_write),
 
 /* integer value in 'imm' field of BPF_CALL instruction selects which helper
  * function eBPF program intends to call
@@ -3613,4 +3653,15 @@ struct bpf_sockopt {
 	__s32	retval;
 };
 
+/* Context passed to a BPF_PROG_TYPE_ITER program, once per object walked.
+ * The type behind @object depends on the iterator target: "task" passes a
+ * struct task_struct *, "tcp" and "udp" a struct sock * (which may be a
+ * timewait or request sock).  After the last object the program is run one
+ * final time with @object zero so it can flush aggregated results.
+ */
+struct bpf_iter_ctx {
+	__u64	seq_num;	/* objects visited before this one */
+	__u64	object;		/* kernel address of the object, or 0 */
+};
+
 #endif /* _UAPI__LINUX_BPF_H__ */
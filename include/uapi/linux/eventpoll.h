@@ -17,16 +17,34 @@
 
 /* For O_CLOEXEC */
 #include <linux/fcntl.h>
+#include <linux/ioctl.h>
 #include <linux/types.h>
 
 /* Flags for epoll_create1.  */
 #define EPOLL_CLOEXEC O_CLOEXEC
+#define EPOLL_RING 1
 
 /* Valid opcodes to issue to sys_epoll_ctl() */
 #define EPOLL_CTL_ADD 1
 #define EPOLL_CTL_DEL 2
 #define EPOLL_CTL_MOD 3
 
+/* Parameters for the EPIOC[GS]PARAMS ioctls, configuring busy polling
+ * per epoll instance.
+ */
+struct epoll_params {
+	__u32 busy_poll_usecs;
+	__u16 busy_poll_budget;
+	__u8 prefer_busy_poll;
+
+	/* pad the struct to a multiple of 64bits */
+	__u8 __pad;
+};
+
+#define EPOLL_IOC_TYPE 0x8A
+#define EPIOCSPARAMS _IOW(EPOLL_IOC_TYPE, 0x01, struct epoll_params)
+#define EPIOCGPARAMS _IOR(EPOLL_IOC_TYPE, 0x02, struct epoll_params)
+
 /* Epoll event masks */
 #define EPOLLIN		(__force __poll_t)0x00000001
 #define EPOLLPRI	(__force __poll_t)0x00000002
@@ -79,6 +97,21 @@ struct epoll_event {
 	__u64 data;
 } EPOLL_PACKED;
 
+/*
+ * Header at offset 0 of the mapping obtained by mmap()ing an epoll file
+ * descriptor created with EPOLL_RING. The kernel publishes ready events
+ * at 'tail' during epoll_wait(); userspace consumes from 'head' and
+ * stores the new value with a release barrier. Indices are free running
+ * and must be masked with 'mask' to address the events array.
+ */
+struct epoll_ring_header {
+	__u32 head;
+	__u32 tail;
+	__u32 mask;
+	__u32 resv;
+	struct epoll_event events[];
+};
+
 #ifdef CONFIG_PM_SLEEP
 static inline void ep_take_care_of_epollwakeup(struct epoll_event *epev)
 {
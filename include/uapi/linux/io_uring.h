@@ -29,10 +29,13 @@ struct io_uring_sqe {
 		__u32		sync_range_flags;
 		__u32		msg_flags;
 		__u32		timeout_flags;
+		__u32		accept_flags;
+		__u32		splice_flags;
 	};
 	__u64	user_data;	/* data to be passed back at completion time */
 	union {
 		__u16	buf_index;	/* index into fixed buffers, if used */
+		__s32	splice_fd_in;	/* input fd for IORING_OP_SPLICE */
 		__u64	__pad2[3];
 	};
 };
@@ -50,6 +53,7 @@ struct io_uring_sqe {
 #define IORING_SETUP_IOPOLL	(1U << 0)	/* io_context is polled */
 #define IORING_SETUP_SQPOLL	(1U << 1)	/* SQ poll thread */
 #define IORING_SETUP_SQ_AFF	(1U << 2)	/* sq_thread_cpu is valid */
+#define IORING_SETUP_ATTACH_WQ	(1U << 3)	/* attach to existing wq */
 
 #define IORING_OP_NOP		0
 #define IORING_OP_READV		1
@@ -63,6 +67,13 @@ struct io_uring_sqe {
 #define IORING_OP_SENDMSG	9
 #define IORING_OP_RECVMSG	10
 #define IORING_OP_TIMEOUT	11
+#define IORING_OP_ACCEPT	12
+#define IORING_OP_SPLICE	13
+
+/*
+ * IORING_OP_ACCEPT flags, stored in sqe->ioprio
+ */
+#define IORING_ACCEPT_MULTISHOT	(1U << 0)
 
 /*
  * sqe->fsync_flags
@@ -78,6 +89,13 @@ struct io_uring_cqe {
 	__u32	flags;
 };
 
+/*
+ * cqe->flags
+ *
+ * IORING_CQE_F_MORE	If set, the request will post more CQEs
+ */
+#define IORING_CQE_F_MORE	(1U << 0)
+
 /*
  * Magic offsets for the application to mmap the data it needs
  */
@@ -131,7 +149,8 @@ struct io_uring_params {
 	__u32 sq_thread_cpu;
 	__u32 sq_thread_idle;
 	__u32 features;
-	__u32 resv[4];
+	__u32 wq_fd;
+	__u32 resv[3];
 	struct io_sqring_offsets sq_off;
 	struct io_cqring_offsets cq_off;
 };
@@ -150,5 +169,25 @@ struct io_uring_params {
 #define IORING_UNREGISTER_FILES		3
 #define IORING_REGISTER_EVENTFD		4
 #define IORING_UNREGISTER_EVENTFD	5
+#define IORING_REGISTER_FILES_UPDATE	6
+#define IORING_REGISTER_CQ_EV_BATCH	7
+
+/*
+ * Batched CQ notification settings. Wakeups and eventfd signals are held
+ * back until 'batch' completions have accumulated, or 'timeout_us' has
+ * passed since the first unreported completion. batch <= 1 disables
+ * coalescing.
+ */
+struct io_uring_cq_ev_batch {
+	__u32 batch;
+	__u32 timeout_us;
+	__u64 resv;
+};
+
+struct io_uring_files_update {
+	__u32 offset;
+	__u32 resv;
+	__aligned_u64 /* __s32 * */ fds;
+};
 
 #endif
@@ -234,4 +234,15 @@ struct prctl_mm_map {
 #define PR_GET_TAGGED_ADDR_CTRL		56
 # define PR_TAGGED_ADDR_ENABLE		(1UL << 0)
 
+/* Manage SMT core scheduling cookies */
+#define PR_SCHED_CORE			57
+# define PR_SCHED_CORE_GET		0
+# define PR_SCHED_CORE_CREATE		1 /* create unique cookie */
+# define PR_SCHED_CORE_SHARE_TO		2 /* push current's cookie to pid */
+# define PR_SCHED_CORE_CLEAR		3 /* clear the cookie of pid */
+
+/* Per-process control of automatic NUMA balancing */
+#define PR_SET_NUMA_BALANCING		58
+#define PR_GET_NUMA_BALANCING		59
+
 #endif /* _LINUX_PRCTL_H */
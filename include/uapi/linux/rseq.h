@@ -142,6 +142,27 @@ struct rseq {
 	 *     this thread.
 	 */
 	__u32 flags;
+	/*
+	 * Restartable sequences node_id field. Updated by the kernel.
+	 * Read by user-space with single-copy atomicity semantics. This
+	 * field should only be read by the thread which registered this
+	 * data structure. Aligned on 32-bit. Contains the current NUMA
+	 * node ID.
+	 */
+	__u32 node_id;
+	/*
+	 * Restartable sequences mm_cid field. Updated by the kernel.
+	 * Read by user-space with single-copy atomicity semantics. This
+	 * field should only be read by the thread which registered this
+	 * data structure. Aligned on 32-bit. Contains the current
+	 * thread's concurrency ID (allocated uniquely among the threads
+	 * of the current thread group running concurrently on CPUs).
+	 * The ids are dense: they stay below the number of CPUs allowed
+	 * to run the process, rather than the number of CPUs in the
+	 * system, which makes them suitable for indexing compact
+	 * per-CPU data structures in user-space.
+	 */
+	__u32 mm_cid;
 } __attribute__((aligned(4 * sizeof(__u64))));
 
 #endif /* _UAPI_LINUX_RSEQ_H */
@@ -10,6 +10,7 @@ struct sched_param {
 
 #define SCHED_ATTR_SIZE_VER0	48	/* sizeof first published struct */
 #define SCHED_ATTR_SIZE_VER1	56	/* add: util_{min,max} */
+#define SCHED_ATTR_SIZE_VER2	60	/* add: latency_nice */
 
 /*
  * Extended scheduling parameters data structure.
@@ -96,6 +97,20 @@ struct sched_param {
  * on a CPU with a capacity big enough to fit the specified value.
  * A task with a max utilization value smaller than 1024 is more likely
  * scheduled on a CPU with no more capacity than the specified value.
+ *
+ * Latency tolerance attributes
+ * ============================
+ *
+ * A subset of sched_attr attributes allows to specify the relative latency
+ * requirements of a task with respect to the other tasks running/queued in
+ * the system.
+ *
+ *  @sched_latency_nice	task's latency_nice value
+ *
+ * The latency_nice of a task can have any value in the range of
+ * [MIN_LATENCY_NICE..MAX_LATENCY_NICE], following the same convention as the
+ * nice value: a higher value means the task tolerates more scheduling
+ * latency, a lower value means it wants to run as soon as possible.
  */
 struct sched_attr {
 	__u32 size;
@@ -118,6 +133,9 @@ struct sched_attr {
 	__u32 sched_util_min;
 	__u32 sched_util_max;
 
+	/* Latency requests */
+	__s32 sched_latency_nice;
+
 };
 
 #endif /* _UAPI_LINUX_SCHED_TYPES_H */
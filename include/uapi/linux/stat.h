@@ -170,5 +170,23 @@ struct statx {
 
 #define STATX_ATTR_AUTOMOUNT		0x00001000 /* Dir: Automount trigger */
 
+/*
+ * A directory entry as returned by getdents_statx(), combining the
+ * linux_dirent64 layout with the statx data for the entry.
+ *
+ * d_stx.stx_mask is zero when the attributes could not be fetched for
+ * this entry (for example because it was unlinked between the
+ * directory walk and the attribute read); the entry itself is still
+ * valid.
+ */
+struct statx_dirent {
+	__u64		d_ino;		/* 64-bit inode number */
+	__s64		d_off;		/* 64-bit offset to next structure */
+	__u16		d_reclen;	/* Size of this dirent */
+	__u8		d_type;		/* File type */
+	__u8		__spare[5];
+	struct statx	d_stx;		/* Attributes of this entry */
+	char		d_name[];	/* Filename (null-terminated) */
+};
 
 #endif /* _UAPI_LINUX_STAT_H */
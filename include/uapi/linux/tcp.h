@@ -276,6 +276,9 @@ struct tcp_info {
 	__u32	tcpi_snd_wnd;	     /* peer's advertised receive window after
 				      * scaling (bytes)
 				      */
+
+	__u64	tcpi_rcv_zc_bytes;   /* bytes mapped by zerocopy receive */
+	__u64	tcpi_rcv_zc_copied;  /* zerocopy receive fallback copies */
 };
 
 /* netlink attributes types for SCM_TIMESTAMPING_OPT_STATS */
@@ -335,5 +338,7 @@ struct tcp_zerocopy_receive {
 	__u64 address;		/* in: address of mapping */
 	__u32 length;		/* in/out: number of bytes to map/mapped */
 	__u32 recv_skip_hint;	/* out: amount of bytes to skip */
+	__u64 copybuf_address;	/* in: copybuf address (small reads) */
+	__s32 copybuf_len;	/* in/out: copybuf bytes avail/used or error */
 };
 #endif /* _UAPI_LINUX_TCP_H */
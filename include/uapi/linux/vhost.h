@@ -44,6 +44,18 @@
 /* Specify an eventfd file descriptor to signal on log write. */
 #define VHOST_SET_LOG_FD _IOW(VHOST_VIRTIO, 0x07, int)
 
+/* Worker threads. */
+/* By default all virtqueues of a device are serviced by the single worker
+ * thread created at VHOST_SET_OWNER time.  Additional workers can be created
+ * and bound to virtqueues with VHOST_ATTACH_VRING_WORKER, so that busy
+ * queues of the same device are processed on separate host CPUs.  New
+ * workers inherit the cgroups of the owner thread. */
+/* Create a new worker and return its id. */
+#define VHOST_NEW_WORKER _IOR(VHOST_VIRTIO, 0x08, struct vhost_worker_state)
+/* Free a worker created with VHOST_NEW_WORKER.  The worker must not have
+ * any virtqueues attached to it. */
+#define VHOST_FREE_WORKER _IOW(VHOST_VIRTIO, 0x09, struct vhost_worker_state)
+
 /* Ring setup. */
 /* Set number of descriptors in ring. This parameter can not
  * be modified while ring is running (bound to a device). */
@@ -68,6 +80,14 @@
 #define VHOST_VRING_BIG_ENDIAN 1
 #define VHOST_SET_VRING_ENDIAN _IOW(VHOST_VIRTIO, 0x13, struct vhost_vring_state)
 #define VHOST_GET_VRING_ENDIAN _IOW(VHOST_VIRTIO, 0x14, struct vhost_vring_state)
+/* Bind this vring to the worker with the given id.  The vring must not have
+ * a backend attached.  Pass worker id 0 to move it back to the default
+ * worker. */
+#define VHOST_ATTACH_VRING_WORKER _IOW(VHOST_VIRTIO, 0x15,	\
+				       struct vhost_vring_worker)
+/* Return the id of the worker currently servicing this vring. */
+#define VHOST_GET_VRING_WORKER _IOWR(VHOST_VIRTIO, 0x16,	\
+				     struct vhost_vring_worker)
 
 /* The following ioctls use eventfd file descriptors to signal and poll
  * for events. */
@@ -27,6 +27,20 @@ struct vhost_vring_file {
 
 };
 
+struct vhost_worker_state {
+	/* Set by the kernel to the id of a new worker on VHOST_NEW_WORKER,
+	 * set by userspace to select a worker on VHOST_FREE_WORKER.  The
+	 * worker created at VHOST_SET_OWNER time has id 0.
+	 */
+	unsigned int worker_id;
+};
+
+struct vhost_vring_worker {
+	unsigned int index;
+	/* The id of the worker servicing this virtqueue. */
+	unsigned int worker_id;
+};
+
 struct vhost_vring_addr {
 	unsigned int index;
 	/* Option flags. */
@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+#ifndef _UAPI_LINUX_WATCH_QUEUE_H
+#define _UAPI_LINUX_WATCH_QUEUE_H
+
+#include <linux/types.h>
+#include <linux/fcntl.h>
+#include <linux/ioctl.h>
+
+#define O_NOTIFICATION_PIPE	O_EXCL	/* Parameter to pipe2() selecting notification pipe */
+
+#define IOC_WATCH_QUEUE_SET_SIZE	_IO('W', 0x60)	/* Set the size in notes of a notification pipe */
+#define IOC_WATCH_QUEUE_SET_FILTER	_IO('W', 0x61)	/* Set the filter on a notification pipe */
+#define IOC_WATCH_MOUNTS		_IO('W', 0x62)	/* Watch the mount topology seen by a
+							 * /proc/.../mounts file; the argument is
+							 * the fd of a notification pipe */
+
+enum watch_notification_type {
+	WATCH_TYPE_META		= 0,	/* Special record */
+	WATCH_TYPE_MOUNT_NOTIFY	= 1,	/* Mount topology change event */
+	WATCH_TYPE_SB_NOTIFY	= 2,	/* Superblock event */
+	WATCH_TYPE__NR		= 3
+};
+
+enum watch_meta_notification_subtype {
+	WATCH_META_REMOVAL_NOTIFICATION	= 0,	/* Watched object was removed */
+	WATCH_META_LOSS_NOTIFICATION	= 1,	/* Data loss occurred */
+};
+
+/*
+ * Notification record header.  All notification messages begin with this,
+ * the length in the info field covering the entire record including any
+ * type-specific payload.
+ */
+struct watch_notification {
+	__u32			type:24;	/* enum watch_notification_type */
+	__u32			subtype:8;	/* Type-specific subtype */
+	__u32			info;
+#define WATCH_INFO_LENGTH	0x0000007f	/* Length of record in bytes */
+#define WATCH_INFO_LENGTH__SHIFT 0
+#define WATCH_INFO_ID		0x0000ff00	/* ID of watchpoint, if type-appropriate */
+#define WATCH_INFO_ID__SHIFT	8
+#define WATCH_INFO_TYPE_INFO	0xffff0000	/* Type-specific info */
+#define WATCH_INFO_TYPE_INFO__SHIFT 16
+#define WATCH_INFO_FLAG_0	0x00010000	/* Type-specific info, flag bit 0 */
+#define WATCH_INFO_FLAG_1	0x00020000	/* ... */
+#define WATCH_INFO_FLAG_2	0x00040000
+#define WATCH_INFO_FLAG_3	0x00080000
+#define WATCH_INFO_FLAG_4	0x00100000
+#define WATCH_INFO_FLAG_5	0x00200000
+#define WATCH_INFO_FLAG_6	0x00400000
+#define WATCH_INFO_FLAG_7	0x00800000
+};
+
+/*
+ * Notification filtering rules (IOC_WATCH_QUEUE_SET_FILTER).
+ */
+struct watch_notification_type_filter {
+	__u32	type;			/* Type to apply filter to */
+	__u32	info_filter;		/* Filter on watch_notification::info */
+	__u32	info_mask;		/* Mask of relevant bits of info */
+	__u32	subtype_filter[8];	/* Bitmask of subtypes to filter on */
+};
+
+struct watch_notification_filter {
+	__u32	nr_filters;		/* Number of filters */
+	__u32	__reserved;		/* Must be 0 */
+	struct watch_notification_type_filter filters[];
+};
+
+
+/*
+ * Extended watch removal notification.  This is used optionally if the
+ * type wants to indicate an identifier for the object being watched, if
+ * there is one.  The record is padded out to 64 bits.
+ */
+struct watch_notification_removal {
+	struct watch_notification watch;
+	__u64	id;		/* Type-dependent identifier */
+};
+
+/*
+ * Type of mount topology change notification (WATCH_TYPE_MOUNT_NOTIFY).
+ */
+enum mount_notification_subtype {
+	NOTIFY_MOUNT_NEW_MOUNT	= 0,	/* New mount added */
+	NOTIFY_MOUNT_UNMOUNT	= 1,	/* Mount removed */
+	NOTIFY_MOUNT_READONLY	= 2,	/* Mount R/O state changed */
+	NOTIFY_MOUNT_SETATTR	= 3,	/* Mount attributes changed */
+	NOTIFY_MOUNT_MOVE_FROM	= 4,	/* Mount moved away from here */
+	NOTIFY_MOUNT_MOVE_TO	= 5,	/* Mount moved to here */
+};
+
+struct mount_notification {
+	struct watch_notification watch; /* WATCH_TYPE_MOUNT_NOTIFY */
+	__u32	triggered_on;		/* The mount that got triggered (mnt_id) */
+	__u32	changed_mount;		/* The mount that got changed (mnt_id) */
+};
+
+#define watch_sizeof(STRUCT)	(sizeof(STRUCT) << WATCH_INFO_LENGTH__SHIFT)
+
+#endif /* _UAPI_LINUX_WATCH_QUEUE_H */
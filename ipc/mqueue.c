@@ -1036,6 +1036,18 @@ static int do_mq_timedsend(mqd_t mqdes, const char __user *u_msg_ptr,
 	msg_ptr->m_ts = msg_len;
 	msg_ptr->m_type = msg_prio;
 
+	/*
+	 * A racy full check is as good as one under the lock for a
+	 * nonblocking send: any concurrent receiver is a valid ordering
+	 * for us to have missed. Bail before touching the lock or the
+	 * node cache.
+	 */
+	if ((f.file->f_flags & O_NONBLOCK) &&
+	    READ_ONCE(info->attr.mq_curmsgs) == info->attr.mq_maxmsg) {
+		ret = -EAGAIN;
+		goto out_free;
+	}
+
 	/*
 	 * msg_insert really wants us to have a valid, spare node struct so
 	 * it doesn't have to kmalloc a GFP_ATOMIC allocation, but it will
@@ -1080,12 +1092,14 @@ static int do_mq_timedsend(mqd_t mqdes, const char __user *u_msg_ptr,
 				goto out_unlock;
 			__do_notify(info);
 		}
-		inode->i_atime = inode->i_mtime = inode->i_ctime =
-				current_time(inode);
 	}
 out_unlock:
 	spin_unlock(&info->lock);
 	wake_up_q(&wake_q);
+	/* a racy timestamp is fine, no need to pin it under the lock */
+	if (!ret)
+		inode->i_atime = inode->i_mtime = inode->i_ctime =
+				current_time(inode);
 out_free:
 	if (ret)
 		free_msg(msg_ptr);
@@ -1141,11 +1155,26 @@ static int do_mq_timedreceive(mqd_t mqdes, char __user *u_msg_ptr,
 	}
 
 	/*
-	 * msg_insert really wants us to have a valid, spare node struct so
-	 * it doesn't have to kmalloc a GFP_ATOMIC allocation, but it will
-	 * fall back to that if necessary.
+	 * A racy empty check is as good as one under the lock for a
+	 * nonblocking receive: any concurrent sender is a valid ordering
+	 * for us to have missed. Bail before touching the lock or the
+	 * node cache.
 	 */
-	if (!info->node_cache)
+	if ((f.file->f_flags & O_NONBLOCK) &&
+	    !READ_ONCE(info->attr.mq_curmsgs)) {
+		ret = -EAGAIN;
+		goto out_fput;
+	}
+
+	/*
+	 * The spare node is only consumed on the receive side by
+	 * pipelined_receive() to requeue a blocked sender's message,
+	 * which requires the queue to be full. Don't pay for the
+	 * allocation when it cannot be needed; msg_insert() falls back
+	 * to GFP_ATOMIC if we lose the race.
+	 */
+	if (!info->node_cache &&
+	    READ_ONCE(info->attr.mq_curmsgs) == info->attr.mq_maxmsg)
 		new_leaf = kmalloc(sizeof(*new_leaf), GFP_KERNEL);
 
 	spin_lock(&info->lock);
@@ -1173,13 +1202,14 @@ static int do_mq_timedreceive(mqd_t mqdes, char __user *u_msg_ptr,
 
 		msg_ptr = msg_get(info);
 
-		inode->i_atime = inode->i_mtime = inode->i_ctime =
-				current_time(inode);
-
 		/* There is now free space in queue. */
 		pipelined_receive(&wake_q, info);
 		spin_unlock(&info->lock);
 		wake_up_q(&wake_q);
+
+		/* a racy timestamp is fine, no need to pin it under the lock */
+		inode->i_atime = inode->i_mtime = inode->i_ctime =
+				current_time(inode);
 		ret = 0;
 	}
 	if (ret == 0) {
@@ -122,6 +122,13 @@ struct sem_array {
 	int			sem_nsems;	/* no. of semaphores in array */
 	int			complex_count;	/* pending complex operations */
 	unsigned int		use_global_lock;/* >0: global lock required */
+	seqcount_t		slow_seq;	/* odd while a dupsop operation
+						 * may have written semvals it
+						 * will roll back */
+	unsigned long		global_lock_ops;/* semops that took the global
+						 * lock, for /proc */
+	atomic_long_t		lockless_nowait;/* IPC_NOWAIT semops failed
+						 * without any lock */
 
 	struct sem		sems[];
 } __randomize_layout;
@@ -244,7 +251,7 @@ void __init sem_init(void)
 {
 	sem_init_ns(&init_ipc_ns);
 	ipc_init_proc_interface("sysvipc/sem",
-				"       key      semid perms      nsems   uid   gid  cuid  cgid      otime      ctime\n",
+				"       key      semid perms      nsems   uid   gid  cuid  cgid      otime      ctime  glocklops nowaitfast\n",
 				IPC_SEM_IDS, sysvipc_sem_proc_show);
 }
 
@@ -542,6 +549,9 @@ static int newary(struct ipc_namespace *ns, struct ipc_params *params)
 
 	sma->complex_count = 0;
 	sma->use_global_lock = USE_GLOBAL_LOCK_HYSTERESIS;
+	seqcount_init(&sma->slow_seq);
+	sma->global_lock_ops = 0;
+	atomic_long_set(&sma->lockless_nowait, 0);
 	INIT_LIST_HEAD(&sma->pending_alter);
 	INIT_LIST_HEAD(&sma->pending_const);
 	INIT_LIST_HEAD(&sma->list_id);
@@ -635,6 +645,15 @@ static int perform_atomic_semop_slow(struct sem_array *sma, struct sem_queue *q)
 	nsops = q->nsops;
 	un = q->undo;
 
+	/*
+	 * The scan below writes semvals it may have to roll back. Flag the
+	 * window so that the lockless IPC_NOWAIT check in do_semtimedop()
+	 * never bases a decision on such a transient value. We hold the
+	 * global lock (dupsop implies a complex operation), so writers to
+	 * the seqcount are serialized.
+	 */
+	write_seqcount_begin(&sma->slow_seq);
+
 	for (sop = sops; sop < sops + nsops; sop++) {
 		int idx = array_index_nospec(sop->sem_num, sma->sem_nsems);
 		curr = &sma->sems[idx];
@@ -661,6 +680,8 @@ static int perform_atomic_semop_slow(struct sem_array *sma, struct sem_queue *q)
 		curr->semval = result;
 	}
 
+	write_seqcount_end(&sma->slow_seq);
+
 	sop--;
 	pid = q->pid;
 	while (sop >= sops) {
@@ -691,6 +712,7 @@ undo:
 			un->semadj[sop->sem_num] += sem_op;
 		sop--;
 	}
+	write_seqcount_end(&sma->slow_seq);
 
 	return result;
 }
@@ -763,6 +785,50 @@ would_block:
 	return sop->sem_flg & IPC_NOWAIT ? -EAGAIN : 1;
 }
 
+/*
+ * lockless_nowait_would_block - check a complex operation without locks
+ * @sma: semaphore array
+ * @sops: operations to check
+ * @nsops: number of operations
+ *
+ * Speculative would-block check for complex operations in which every sop
+ * is a decrement or a wait-for-zero with IPC_NOWAIT set. For such
+ * operations a single semaphore observed in a blocking state is enough to
+ * fail the whole transaction with -EAGAIN: the operation would have
+ * blocked at or before that sop at the instant the value was read, and
+ * with sem_op <= 0 everywhere no earlier sop can fail differently
+ * (ERANGE needs an increment). Semaphore values are ints and thus read
+ * tearing-free; the only values that must not be trusted are the
+ * transients that perform_atomic_semop_slow() may roll back, which the
+ * slow_seq read side rejects.
+ *
+ * Returns true if returning -EAGAIN without taking any lock is a valid
+ * outcome, false if the caller must take the locked path.
+ */
+static bool lockless_nowait_would_block(struct sem_array *sma,
+					struct sembuf *sops, unsigned nsops)
+{
+	struct sembuf *sop;
+	bool blocked = false;
+	unsigned seq;
+
+	seq = read_seqcount_begin(&sma->slow_seq);
+	for (sop = sops; sop < sops + nsops; sop++) {
+		int idx = array_index_nospec(sop->sem_num, sma->sem_nsems);
+		int result = READ_ONCE(sma->sems[idx].semval);
+
+		if (sop->sem_op > 0 || !(sop->sem_flg & IPC_NOWAIT))
+			return false;
+		if ((!sop->sem_op && result) || result + sop->sem_op < 0) {
+			blocked = true;
+			break;
+		}
+	}
+	if (!blocked)
+		return false;
+	return !read_seqcount_retry(&sma->slow_seq, seq);
+}
+
 static inline void wake_up_sem_queue_prepare(struct sem_queue *q, int error,
 					     struct wake_q_head *wake_q)
 {
@@ -2063,8 +2129,24 @@ static long do_semtimedop(int semid, struct sembuf __user *tsops,
 		goto out_free;
 	}
 
+	/*
+	 * Complex nonblocking operations (the classic multi-semaphore
+	 * try-acquire) can collide with the single-sop per-semaphore
+	 * locking on every poll. Fail them from a lockless check when
+	 * possible instead of taking the array-wide lock.
+	 */
+	if (nsops > 1 && !dupsop && un == NULL &&
+	    lockless_nowait_would_block(sma, sops, nsops)) {
+		atomic_long_inc(&sma->lockless_nowait);
+		rcu_read_unlock();
+		error = -EAGAIN;
+		goto out_free;
+	}
+
 	error = -EIDRM;
 	locknum = sem_lock(sma, sops, nsops);
+	if (locknum == SEM_GLOBAL_LOCK)
+		sma->global_lock_ops++;
 	/*
 	 * We eventually might perform the following check in a lockless
 	 * fashion, considering ipc_valid_object() locking constraints.
@@ -2427,7 +2509,7 @@ static int sysvipc_sem_proc_show(struct seq_file *s, void *it)
 	sem_otime = get_semotime(sma);
 
 	seq_printf(s,
-		   "%10d %10d  %4o %10u %5u %5u %5u %5u %10llu %10llu\n",
+		   "%10d %10d  %4o %10u %5u %5u %5u %5u %10llu %10llu %10lu %10lu\n",
 		   sma->sem_perm.key,
 		   sma->sem_perm.id,
 		   sma->sem_perm.mode,
@@ -2437,7 +2519,9 @@ static int sysvipc_sem_proc_show(struct seq_file *s, void *it)
 		   from_kuid_munged(user_ns, sma->sem_perm.cuid),
 		   from_kgid_munged(user_ns, sma->sem_perm.cgid),
 		   sem_otime,
-		   sma->sem_ctime);
+		   sma->sem_ctime,
+		   sma->global_lock_ops,
+		   atomic_long_read(&sma->lockless_nowait));
 
 	complexmode_tryleave(sma);
 
@@ -35,6 +35,7 @@
 #include <linux/init.h>
 #include <linux/types.h>
 #include <linux/atomic.h>
+#include <linux/percpu.h>
 #include <linux/mm.h>
 #include <linux/export.h>
 #include <linux/slab.h>
@@ -142,6 +143,11 @@ static struct kmem_cache *audit_buffer_cache;
 
 /* queue msgs to send via kauditd_task */
 static struct sk_buff_head audit_queue;
+/* per-CPU producer queues, spliced into audit_queue by kauditd_task so
+ * that audit_log_end() never contends on a global queue lock */
+static DEFINE_PER_CPU(struct sk_buff_head, audit_percpu_queue);
+/* number of records sitting in the per-CPU queues */
+static atomic_t audit_percpu_backlog = ATOMIC_INIT(0);
 /* queue msgs due to temporary unicast send problems */
 static struct sk_buff_head audit_retry_queue;
 /* queue msgs waiting for new auditd connection */
@@ -689,6 +695,56 @@ err:
 	return rc;
 }
 
+/**
+ * audit_queue_backlog - number of records waiting to be sent to auditd
+ *
+ * Description:
+ * Counts both the main queue and the records still sitting in the per-CPU
+ * producer queues.  Reads are lockless and approximate, which is fine for
+ * backlog limit checks and status reporting.
+ */
+static int audit_queue_backlog(void)
+{
+	return skb_queue_len(&audit_queue) + atomic_read(&audit_percpu_backlog);
+}
+
+/**
+ * kauditd_collect_percpu - splice the per-CPU producer queues
+ *
+ * Description:
+ * Move all records from the per-CPU producer queues to the tail of the main
+ * queue.  Only kauditd_thread calls this, so the main queue tail is never
+ * touched from more than one context.  Records stay ordered per CPU; cross-CPU
+ * ordering is by record serial number, as it always has been for readers.
+ */
+static void kauditd_collect_percpu(void)
+{
+	struct sk_buff_head spliced;
+	struct sk_buff_head *queue;
+	unsigned long flags;
+	unsigned int len;
+	int cpu;
+
+	__skb_queue_head_init(&spliced);
+
+	for_each_possible_cpu(cpu) {
+		queue = &per_cpu(audit_percpu_queue, cpu);
+		if (skb_queue_empty(queue))
+			continue;
+		spin_lock_irqsave(&queue->lock, flags);
+		skb_queue_splice_tail_init(queue, &spliced);
+		spin_unlock_irqrestore(&queue->lock, flags);
+	}
+
+	len = skb_queue_len(&spliced);
+	if (len) {
+		spin_lock_irqsave(&audit_queue.lock, flags);
+		skb_queue_splice_tail(&spliced, &audit_queue);
+		spin_unlock_irqrestore(&audit_queue.lock, flags);
+		atomic_sub(len, &audit_percpu_backlog);
+	}
+}
+
 /**
  * kauditd_send_queue - Helper for kauditd_thread to flush skb queues
  * @sk: the sending sock
@@ -847,6 +903,9 @@ static int kauditd_thread(void *dummy)
 		}
 
 main_queue:
+		/* pull in everything the producers have queued so far */
+		kauditd_collect_percpu();
+
 		/* process the main queue - do the multicast send and attempt
 		 * unicast, dump failed record sends to the retry queue; if
 		 * sk == NULL due to previous failures we will just do the
@@ -873,7 +932,7 @@ main_queue:
 		 *       do the multicast send and rotate records from the
 		 *       main queue to the retry/hold queues */
 		wait_event_freezable(kauditd_wait,
-				     (skb_queue_len(&audit_queue) ? 1 : 0));
+				     (audit_queue_backlog() ? 1 : 0));
 	}
 
 	return 0;
@@ -1208,7 +1267,7 @@ static int audit_receive_msg(struct sk_buff *skb, struct nlmsghdr *nlh)
 		s.rate_limit		= audit_rate_limit;
 		s.backlog_limit		= audit_backlog_limit;
 		s.lost			= atomic_read(&audit_lost);
-		s.backlog		= skb_queue_len(&audit_queue);
+		s.backlog		= audit_queue_backlog();
 		s.feature_bitmap	= AUDIT_FEATURE_BITMAP_ALL;
 		s.backlog_wait_time	= audit_backlog_wait_time;
 		audit_send_reply(skb, seq, AUDIT_GET, 0, 0, &s, sizeof(s));
@@ -1597,6 +1656,8 @@ static int __init audit_init(void)
 	skb_queue_head_init(&audit_queue);
 	skb_queue_head_init(&audit_retry_queue);
 	skb_queue_head_init(&audit_hold_queue);
+	for_each_possible_cpu(i)
+		skb_queue_head_init(&per_cpu(audit_percpu_queue, i));
 
 	for (i = 0; i < AUDIT_INODE_BUCKETS; i++)
 		INIT_LIST_HEAD(&audit_inode_hash[i]);
@@ -1778,7 +1839,7 @@ struct audit_buffer *audit_log_start(struct audit_context *ctx, gfp_t gfp_mask,
 		long stime = audit_backlog_wait_time;
 
 		while (audit_backlog_limit &&
-		       (skb_queue_len(&audit_queue) > audit_backlog_limit)) {
+		       (audit_queue_backlog() > audit_backlog_limit)) {
 			/* wake kauditd to try and flush the queue */
 			wake_up_interruptible(&kauditd_wait);
 
@@ -1795,7 +1856,7 @@ struct audit_buffer *audit_log_start(struct audit_context *ctx, gfp_t gfp_mask,
 			} else {
 				if (audit_rate_check() && printk_ratelimit())
 					pr_warn("audit_backlog=%d > audit_backlog_limit=%d\n",
-						skb_queue_len(&audit_queue),
+						audit_queue_backlog(),
 						audit_backlog_limit);
 				audit_log_lost("backlog limit exceeded");
 				return NULL;
@@ -2311,6 +2372,7 @@ int audit_signal_info(int sig, struct task_struct *t)
  */
 void audit_log_end(struct audit_buffer *ab)
 {
+	struct sk_buff_head *queue;
 	struct sk_buff *skb;
 	struct nlmsghdr *nlh;
 
@@ -2327,7 +2389,10 @@ void audit_log_end(struct audit_buffer *ab)
 		nlh->nlmsg_len = skb->len - NLMSG_HDRLEN;
 
 		/* queue the netlink packet and poke the kauditd thread */
-		skb_queue_tail(&audit_queue, skb);
+		atomic_inc(&audit_percpu_backlog);
+		queue = get_cpu_ptr(&audit_percpu_queue);
+		skb_queue_tail(queue, skb);
+		put_cpu_ptr(&audit_percpu_queue);
 		wake_up_interruptible(&kauditd_wait);
 	} else
 		audit_log_lost("rate limit exceeded");
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/* BPF object iterators.
+ *
+ * A BPF_PROG_TYPE_ITER program is bound to a registered iterator target
+ * ("task", "tcp", ...) with the BPF_ITER_CREATE command, which returns an
+ * anonymous seq_file descriptor.  Each read() resumes the target's walk
+ * where it left off and runs the program once per object; whatever the
+ * program emits with bpf_seq_write() becomes the file's contents.  This
+ * lets telemetry produce exactly the records it needs in a single pass
+ * instead of parsing the fixed-format /proc dumps.
+ */
+#include <linux/anon_inodes.h>
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <linux/fs.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+
+struct bpf_iter_target_info {
+	struct list_head list;
+	const struct bpf_iter_reg *reg_info;
+};
+
+/* Common state in front of the target's seq_file private data */
+struct bpf_iter_priv_data {
+	struct bpf_iter_target_info *tinfo;
+	struct bpf_prog *prog;
+	u64 seq_num;
+	bool done_stop;
+	u8 target_private[] __aligned(8);
+};
+
+static LIST_HEAD(targets);
+static DEFINE_MUTEX(targets_mutex);
+
+/**
+ * bpf_iter_reg_target - register an iterator target
+ * @reg_info: the walker to make available to BPF_ITER_CREATE; must stay
+ *	valid forever (targets cannot be unregistered)
+ */
+int bpf_iter_reg_target(const struct bpf_iter_reg *reg_info)
+{
+	struct bpf_iter_target_info *tinfo;
+
+	tinfo = kmalloc(sizeof(*tinfo), GFP_KERNEL);
+	if (!tinfo)
+		return -ENOMEM;
+
+	tinfo->reg_info = reg_info;
+	INIT_LIST_HEAD(&tinfo->list);
+
+	mutex_lock(&targets_mutex);
+	list_add(&tinfo->list, &targets);
+	mutex_unlock(&targets_mutex);
+
+	return 0;
+}
+
+static struct bpf_iter_priv_data *seq_to_priv(struct seq_file *seq)
+{
+	return (struct bpf_iter_priv_data *)
+		((u8 *)seq->private -
+		 offsetof(struct bpf_iter_priv_data, target_private));
+}
+
+/**
+ * bpf_iter_run_prog - run the iterator program for one object
+ * @seq: the iterator seq_file
+ * @object: the object the walker is visiting, or NULL at the end of the
+ *	walk (@in_stop true), in which case the program runs one final
+ *	time with ctx->object zero
+ * @in_stop: true when called from the walker's ->stop() at end of walk
+ *
+ * Called by a target's ->show() for every object.  A non-zero program
+ * return value discards anything the program wrote for this object.
+ * Always returns 0 so that the walk continues.
+ */
+int bpf_iter_run_prog(struct seq_file *seq, void *object, bool in_stop)
+{
+	struct bpf_iter_priv_data *priv = seq_to_priv(seq);
+	struct bpf_iter_ctx_kern ctx;
+	size_t count = seq->count;
+	int ret;
+
+	if (in_stop) {
+		if (priv->done_stop)
+			return 0;
+		priv->done_stop = true;
+	}
+
+	ctx.seq_num = priv->seq_num;
+	ctx.object = (unsigned long)object;
+	ctx.seq = seq;
+
+	rcu_read_lock();
+	preempt_disable();
+	ret = BPF_PROG_RUN(priv->prog, &ctx);
+	preempt_enable();
+	rcu_read_unlock();
+
+	if (ret)
+		seq->count = count;
+
+	/* If the record overflowed the buffer, seq_read() discards the
+	 * partial output and revisits the object with a bigger buffer;
+	 * keep the numbering stable for the rerun.
+	 */
+	if (!in_stop && !seq_has_overflowed(seq))
+		priv->seq_num++;
+
+	return 0;
+}
+
+BPF_CALL_3(bpf_seq_write, struct bpf_iter_ctx_kern *, ctx, const void *, data,
+	   u32, len)
+{
+	return seq_write(ctx->seq, data, len) ? -EOVERFLOW : 0;
+}
+
+const struct bpf_func_proto bpf_seq_write_proto = {
+	.func		= bpf_seq_write,
+	.gpl_only	= true,
+	.ret_type	= RET_INTEGER,
+	.arg1_type	= ARG_PTR_TO_CTX,
+	.arg2_type	= ARG_PTR_TO_MEM,
+	.arg3_type	= ARG_CONST_SIZE_OR_ZERO,
+};
+
+static int bpf_iter_release(struct inode *inode, struct file *file)
+{
+	struct seq_file *seq = file->private_data;
+	struct bpf_iter_priv_data *priv;
+
+	if (!seq)
+		return 0;
+
+	priv = seq_to_priv(seq);
+	if (priv->tinfo->reg_info->fini_seq_private)
+		priv->tinfo->reg_info->fini_seq_private(seq->private);
+	bpf_prog_put(priv->prog);
+	seq_release(inode, file);
+	kfree(priv);
+	return 0;
+}
+
+static const struct file_operations bpf_iter_fops = {
+	.llseek		= no_llseek,
+	.read		= seq_read,
+	.release	= bpf_iter_release,
+};
+
+int bpf_iter_new_fd(const union bpf_attr *attr)
+{
+	struct bpf_iter_target_info *tinfo, *found = NULL;
+	const struct bpf_iter_reg *reg_info;
+	struct bpf_iter_priv_data *priv;
+	char target[BPF_ITER_NAME_LEN];
+	struct bpf_prog *prog;
+	struct seq_file *seq;
+	struct file *file;
+	int err, fd;
+
+	if (attr->iter_create.flags)
+		return -EINVAL;
+
+	if (strncpy_from_user(target,
+			      u64_to_user_ptr(attr->iter_create.target),
+			      sizeof(target) - 1) < 0)
+		return -EFAULT;
+	target[sizeof(target) - 1] = 0;
+
+	prog = bpf_prog_get_type(attr->iter_create.prog_fd,
+				 BPF_PROG_TYPE_ITER);
+	if (IS_ERR(prog))
+		return PTR_ERR(prog);
+
+	mutex_lock(&targets_mutex);
+	list_for_each_entry(tinfo, &targets, list) {
+		if (!strcmp(tinfo->reg_info->target, target)) {
+			found = tinfo;
+			break;
+		}
+	}
+	mutex_unlock(&targets_mutex);
+
+	err = -ENOENT;
+	if (!found)
+		goto err_prog;
+	reg_info = found->reg_info;
+
+	err = -ENOMEM;
+	priv = kzalloc(offsetof(struct bpf_iter_priv_data, target_private) +
+		       reg_info->seq_priv_size, GFP_USER | __GFP_NOWARN);
+	if (!priv)
+		goto err_prog;
+	priv->tinfo = found;
+	priv->prog = prog;
+
+	if (reg_info->init_seq_private) {
+		err = reg_info->init_seq_private(priv->target_private);
+		if (err)
+			goto err_priv;
+	}
+
+	fd = get_unused_fd_flags(O_CLOEXEC);
+	if (fd < 0) {
+		err = fd;
+		goto err_fini;
+	}
+
+	file = anon_inode_getfile("bpf_iter", &bpf_iter_fops, NULL,
+				  O_RDONLY | O_CLOEXEC);
+	if (IS_ERR(file)) {
+		err = PTR_ERR(file);
+		goto err_fd;
+	}
+
+	err = seq_open(file, reg_info->seq_ops);
+	if (err) {
+		/* ->release copes with a fileless seq_open() failure */
+		fput(file);
+		goto err_fd;
+	}
+	seq = file->private_data;
+	seq->private = priv->target_private;
+
+	fd_install(fd, file);
+	return fd;
+
+err_fd:
+	put_unused_fd(fd);
+err_fini:
+	if (reg_info->fini_seq_private)
+		reg_info->fini_seq_private(priv->target_private);
+err_priv:
+	kfree(priv);
+err_prog:
+	bpf_prog_put(prog);
+	return err;
+}
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/* BPF iterator over the tasks visible in the caller's pid namespace.
+ * The walk is keyed by tid so that it resumes correctly across read()
+ * calls even while tasks come and go.
+ */
+#include <linux/bpf.h>
+#include <linux/init.h>
+#include <linux/pid_namespace.h>
+#include <linux/sched/task.h>
+#include <linux/seq_file.h>
+
+struct bpf_iter_seq_task_info {
+	struct pid_namespace *ns;
+	u32 tid;
+};
+
+static struct task_struct *task_seq_get_next(struct pid_namespace *ns,
+					     u32 *tid)
+{
+	struct task_struct *task = NULL;
+	struct pid *pid;
+
+	rcu_read_lock();
+retry:
+	pid = find_ge_pid(*tid, ns);
+	if (pid) {
+		*tid = pid_nr_ns(pid, ns);
+		task = get_pid_task(pid, PIDTYPE_PID);
+		if (!task) {
+			++*tid;
+			goto retry;
+		}
+	}
+	rcu_read_unlock();
+
+	return task;
+}
+
+static void *task_seq_start(struct seq_file *seq, loff_t *pos)
+{
+	struct bpf_iter_seq_task_info *info = seq->private;
+	struct task_struct *task;
+
+	task = task_seq_get_next(info->ns, &info->tid);
+	if (!task)
+		return NULL;
+
+	++*pos;
+	return task;
+}
+
+static void *task_seq_next(struct seq_file *seq, void *v, loff_t *pos)
+{
+	struct bpf_iter_seq_task_info *info = seq->private;
+	struct task_struct *task;
+
+	++*pos;
+	++info->tid;
+	put_task_struct((struct task_struct *)v);
+	task = task_seq_get_next(info->ns, &info->tid);
+	if (!task)
+		return NULL;
+
+	return task;
+}
+
+static int task_seq_show(struct seq_file *seq, void *v)
+{
+	return bpf_iter_run_prog(seq, v, false);
+}
+
+static void task_seq_stop(struct seq_file *seq, void *v)
+{
+	if (!v)
+		bpf_iter_run_prog(seq, NULL, true);
+	else
+		put_task_struct((struct task_struct *)v);
+}
+
+static const struct seq_operations task_seq_ops = {
+	.start	= task_seq_start,
+	.next	= task_seq_next,
+	.stop	= task_seq_stop,
+	.show	= task_seq_show,
+};
+
+static int init_seq_task(void *priv_data)
+{
+	struct bpf_iter_seq_task_info *info = priv_data;
+
+	info->ns = get_pid_ns(task_active_pid_ns(current));
+	return 0;
+}
+
+static void fini_seq_task(void *priv_data)
+{
+	struct bpf_iter_seq_task_info *info = priv_data;
+
+	put_pid_ns(info->ns);
+}
+
+static const struct bpf_iter_reg task_reg_info = {
+	.target			= "task",
+	.seq_ops		= &task_seq_ops,
+	.init_seq_private	= init_seq_task,
+	.fini_seq_private	= fini_seq_task,
+	.seq_priv_size		= sizeof(struct bpf_iter_seq_task_info),
+};
+
+static int __init task_iter_init(void)
+{
+	return bpf_iter_reg_target(&task_reg_info);
+}
+late_initcall(task_iter_init);
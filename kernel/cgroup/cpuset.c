@@ -215,6 +215,7 @@ typedef enum {
 	CS_SCHED_LOAD_BALANCE,
 	CS_SPREAD_PAGE,
 	CS_SPREAD_SLAB,
+	CS_TIMER_HOUSEKEEP,
 } cpuset_flagbits_t;
 
 /* convenient tests for these bits */
@@ -258,6 +259,11 @@ static inline int is_spread_slab(const struct cpuset *cs)
 	return test_bit(CS_SPREAD_SLAB, &cs->flags);
 }
 
+static inline int is_timer_housekeep(const struct cpuset *cs)
+{
+	return test_bit(CS_TIMER_HOUSEKEEP, &cs->flags);
+}
+
 static inline int is_partition_root(const struct cpuset *cs)
 {
 	return cs->partition_root_state > 0;
@@ -431,6 +437,11 @@ static void cpuset_update_task_spread_flag(struct cpuset *cs,
 		task_set_spread_slab(tsk);
 	else
 		task_clear_spread_slab(tsk);
+
+	if (is_timer_housekeep(cs))
+		task_set_timer_housekeep(tsk);
+	else
+		task_clear_timer_housekeep(tsk);
 }
 
 /*
@@ -1894,7 +1905,8 @@ static int update_flag(cpuset_flagbits_t bit, struct cpuset *cs,
 				is_sched_load_balance(trialcs));
 
 	spread_flag_changed = ((is_spread_slab(cs) != is_spread_slab(trialcs))
-			|| (is_spread_page(cs) != is_spread_page(trialcs)));
+			|| (is_spread_page(cs) != is_spread_page(trialcs))
+			|| (is_timer_housekeep(cs) != is_timer_housekeep(trialcs)));
 
 	spin_lock_irq(&callback_lock);
 	cs->flags = trialcs->flags;
@@ -2248,6 +2260,7 @@ typedef enum {
 	FILE_MEMORY_PRESSURE,
 	FILE_SPREAD_PAGE,
 	FILE_SPREAD_SLAB,
+	FILE_TIMER_HOUSEKEEP,
 } cpuset_filetype_t;
 
 static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
@@ -2289,6 +2302,9 @@ static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
 	case FILE_SPREAD_SLAB:
 		retval = update_flag(CS_SPREAD_SLAB, cs, val);
 		break;
+	case FILE_TIMER_HOUSEKEEP:
+		retval = update_flag(CS_TIMER_HOUSEKEEP, cs, val);
+		break;
 	default:
 		retval = -EINVAL;
 		break;
@@ -2456,6 +2472,8 @@ static u64 cpuset_read_u64(struct cgroup_subsys_state *css, struct cftype *cft)
 		return is_spread_page(cs);
 	case FILE_SPREAD_SLAB:
 		return is_spread_slab(cs);
+	case FILE_TIMER_HOUSEKEEP:
+		return is_timer_housekeep(cs);
 	default:
 		BUG();
 	}
@@ -2625,6 +2643,13 @@ static struct cftype legacy_files[] = {
 		.private = FILE_SPREAD_SLAB,
 	},
 
+	{
+		.name = "timer_housekeeping",
+		.read_u64 = cpuset_read_u64,
+		.write_u64 = cpuset_write_u64,
+		.private = FILE_TIMER_HOUSEKEEP,
+	},
+
 	{
 		.name = "memory_pressure_enabled",
 		.flags = CFTYPE_ONLY_ON_ROOT,
@@ -2739,6 +2764,8 @@ static int cpuset_css_online(struct cgroup_subsys_state *css)
 		set_bit(CS_SPREAD_PAGE, &cs->flags);
 	if (is_spread_slab(parent))
 		set_bit(CS_SPREAD_SLAB, &cs->flags);
+	if (is_timer_housekeep(parent))
+		set_bit(CS_TIMER_HOUSEKEEP, &cs->flags);
 
 	cpuset_inc();
 
@@ -300,29 +300,45 @@ static void cgroup_base_stat_accumulate(struct cgroup_base_stat *dst_bstat,
 	dst_bstat->cputime.utime += src_bstat->cputime.utime;
 	dst_bstat->cputime.stime += src_bstat->cputime.stime;
 	dst_bstat->cputime.sum_exec_runtime += src_bstat->cputime.sum_exec_runtime;
+#ifdef CONFIG_TASK_DELAY_ACCT
+	{
+		int i;
+
+		for (i = 0; i < CGROUP_NR_DELAYS; i++)
+			dst_bstat->delay[i] += src_bstat->delay[i];
+	}
+#endif
 }
 
 static void cgroup_base_stat_flush(struct cgroup *cgrp, int cpu)
 {
 	struct cgroup *parent = cgroup_parent(cgrp);
 	struct cgroup_rstat_cpu *rstatc = cgroup_rstat_cpu(cgrp, cpu);
-	struct task_cputime *last_cputime = &rstatc->last_bstat.cputime;
-	struct task_cputime cputime;
+	struct cgroup_base_stat *last_bstat = &rstatc->last_bstat;
+	struct cgroup_base_stat bstat;
 	struct cgroup_base_stat delta;
 	unsigned seq;
 
 	/* fetch the current per-cpu values */
 	do {
 		seq = __u64_stats_fetch_begin(&rstatc->bsync);
-		cputime = rstatc->bstat.cputime;
+		bstat = rstatc->bstat;
 	} while (__u64_stats_fetch_retry(&rstatc->bsync, seq));
 
 	/* calculate the delta to propgate */
-	delta.cputime.utime = cputime.utime - last_cputime->utime;
-	delta.cputime.stime = cputime.stime - last_cputime->stime;
-	delta.cputime.sum_exec_runtime = cputime.sum_exec_runtime -
-					 last_cputime->sum_exec_runtime;
-	*last_cputime = cputime;
+	delta.cputime.utime = bstat.cputime.utime - last_bstat->cputime.utime;
+	delta.cputime.stime = bstat.cputime.stime - last_bstat->cputime.stime;
+	delta.cputime.sum_exec_runtime = bstat.cputime.sum_exec_runtime -
+					 last_bstat->cputime.sum_exec_runtime;
+#ifdef CONFIG_TASK_DELAY_ACCT
+	{
+		int i;
+
+		for (i = 0; i < CGROUP_NR_DELAYS; i++)
+			delta.delay[i] = bstat.delay[i] - last_bstat->delay[i];
+	}
+#endif
+	*last_bstat = bstat;
 
 	/* transfer the pending stat into delta */
 	cgroup_base_stat_accumulate(&delta, &cgrp->pending_bstat);
@@ -385,10 +401,35 @@ void __cgroup_account_cputime_field(struct cgroup *cgrp,
 	cgroup_base_stat_cputime_account_end(cgrp, rstatc);
 }
 
+#ifdef CONFIG_TASK_DELAY_ACCT
+void __cgroup_account_delay(struct cgroup *cgrp, enum cgroup_delay_type idx,
+			    u64 delta)
+{
+	struct cgroup_rstat_cpu *rstatc;
+	unsigned long flags;
+
+	/*
+	 * Unlike the cputime accounting above, delays may be charged from
+	 * any context (e.g. wakeups in irq context), so the irqsave
+	 * variants are needed here.
+	 */
+	rstatc = get_cpu_ptr(cgrp->rstat_cpu);
+	flags = u64_stats_update_begin_irqsave(&rstatc->bsync);
+	rstatc->bstat.delay[idx] += delta;
+	u64_stats_update_end_irqrestore(&rstatc->bsync, flags);
+	cgroup_rstat_updated(cgrp, smp_processor_id());
+	put_cpu_ptr(rstatc);
+}
+#endif
+
 void cgroup_base_stat_cputime_show(struct seq_file *seq)
 {
 	struct cgroup *cgrp = seq_css(seq)->cgroup;
 	u64 usage, utime, stime;
+#ifdef CONFIG_TASK_DELAY_ACCT
+	u64 delay[CGROUP_NR_DELAYS];
+	int i;
+#endif
 
 	if (!cgroup_parent(cgrp))
 		return;
@@ -396,6 +437,10 @@ void cgroup_base_stat_cputime_show(struct seq_file *seq)
 	cgroup_rstat_flush_hold(cgrp);
 	usage = cgrp->bstat.cputime.sum_exec_runtime;
 	cputime_adjust(&cgrp->bstat.cputime, &cgrp->prev_cputime, &utime, &stime);
+#ifdef CONFIG_TASK_DELAY_ACCT
+	for (i = 0; i < CGROUP_NR_DELAYS; i++)
+		delay[i] = cgrp->bstat.delay[i] / NSEC_PER_USEC;
+#endif
 	cgroup_rstat_flush_release();
 
 	do_div(usage, NSEC_PER_USEC);
@@ -406,4 +451,15 @@ void cgroup_base_stat_cputime_show(struct seq_file *seq)
 		   "user_usec %llu\n"
 		   "system_usec %llu\n",
 		   usage, utime, stime);
+
+#ifdef CONFIG_TASK_DELAY_ACCT
+	seq_printf(seq, "delay_blkio_usec %llu\n"
+		   "delay_swapin_usec %llu\n"
+		   "delay_freepages_usec %llu\n"
+		   "delay_thrashing_usec %llu\n",
+		   delay[CGROUP_DELAY_BLKIO],
+		   delay[CGROUP_DELAY_SWAPIN],
+		   delay[CGROUP_DELAY_FREEPAGES],
+		   delay[CGROUP_DELAY_THRASHING]);
+#endif
 }
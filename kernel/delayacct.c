@@ -12,6 +12,7 @@
 #include <linux/time.h>
 #include <linux/sysctl.h>
 #include <linux/delayacct.h>
+#include <linux/cgroup.h>
 #include <linux/module.h>
 
 int delayacct_on __read_mostly = 1;	/* Delay accounting turned on/off */
@@ -35,25 +36,29 @@ void __delayacct_tsk_init(struct task_struct *tsk)
 {
 	tsk->delays = kmem_cache_zalloc(delayacct_cache, GFP_KERNEL);
 	if (tsk->delays)
-		raw_spin_lock_init(&tsk->delays->lock);
+		u64_stats_init(&tsk->delays->sync);
 }
 
 /*
  * Finish delay accounting for a statistic using its timestamps (@start),
- * accumalator (@total) and @count
+ * accumalator (@total) and @count.  Returns the accounted delay so the
+ * caller can roll it up into the task's cgroup.
  */
-static void delayacct_end(raw_spinlock_t *lock, u64 *start, u64 *total,
-			  u32 *count)
+static s64 delayacct_end(struct u64_stats_sync *sync, u64 *start, u64 *total,
+			 u32 *count)
 {
 	s64 ns = ktime_get_ns() - *start;
 	unsigned long flags;
 
-	if (ns > 0) {
-		raw_spin_lock_irqsave(lock, flags);
-		*total += ns;
-		(*count)++;
-		raw_spin_unlock_irqrestore(lock, flags);
-	}
+	if (ns <= 0)
+		return 0;
+
+	flags = u64_stats_update_begin_irqsave(sync);
+	*total += ns;
+	(*count)++;
+	u64_stats_update_end_irqrestore(sync, flags);
+
+	return ns;
 }
 
 void __delayacct_blkio_start(void)
@@ -68,25 +73,34 @@ void __delayacct_blkio_start(void)
 void __delayacct_blkio_end(struct task_struct *p)
 {
 	struct task_delay_info *delays = p->delays;
+	enum cgroup_delay_type idx;
 	u64 *total;
 	u32 *count;
+	s64 ns;
 
 	if (p->delays->flags & DELAYACCT_PF_SWAPIN) {
 		total = &delays->swapin_delay;
 		count = &delays->swapin_count;
+		idx = CGROUP_DELAY_SWAPIN;
 	} else {
 		total = &delays->blkio_delay;
 		count = &delays->blkio_count;
+		idx = CGROUP_DELAY_BLKIO;
 	}
 
-	delayacct_end(&delays->lock, &delays->blkio_start, total, count);
+	ns = delayacct_end(&delays->sync, &delays->blkio_start, total, count);
+	if (ns)
+		cgroup_account_delay(p, idx, ns);
 }
 
 int __delayacct_add_tsk(struct taskstats *d, struct task_struct *tsk)
 {
 	u64 utime, stime, stimescaled, utimescaled;
+	u64 blkio_delay, swapin_delay, freepages_delay, thrashing_delay;
+	u32 blkio_count, swapin_count, freepages_count, thrashing_count;
 	unsigned long long t2, t3;
-	unsigned long flags, t1;
+	unsigned long t1;
+	unsigned int seq;
 	s64 tmp;
 
 	task_cputime(tsk, &utime, &stime);
@@ -119,33 +133,45 @@ int __delayacct_add_tsk(struct taskstats *d, struct task_struct *tsk)
 
 	/* zero XXX_total, non-zero XXX_count implies XXX stat overflowed */
 
-	raw_spin_lock_irqsave(&tsk->delays->lock, flags);
-	tmp = d->blkio_delay_total + tsk->delays->blkio_delay;
+	do {
+		seq = u64_stats_fetch_begin_irq(&tsk->delays->sync);
+		blkio_delay = tsk->delays->blkio_delay;
+		swapin_delay = tsk->delays->swapin_delay;
+		freepages_delay = tsk->delays->freepages_delay;
+		thrashing_delay = tsk->delays->thrashing_delay;
+		blkio_count = tsk->delays->blkio_count;
+		swapin_count = tsk->delays->swapin_count;
+		freepages_count = tsk->delays->freepages_count;
+		thrashing_count = tsk->delays->thrashing_count;
+	} while (u64_stats_fetch_retry_irq(&tsk->delays->sync, seq));
+
+	tmp = d->blkio_delay_total + blkio_delay;
 	d->blkio_delay_total = (tmp < d->blkio_delay_total) ? 0 : tmp;
-	tmp = d->swapin_delay_total + tsk->delays->swapin_delay;
+	tmp = d->swapin_delay_total + swapin_delay;
 	d->swapin_delay_total = (tmp < d->swapin_delay_total) ? 0 : tmp;
-	tmp = d->freepages_delay_total + tsk->delays->freepages_delay;
+	tmp = d->freepages_delay_total + freepages_delay;
 	d->freepages_delay_total = (tmp < d->freepages_delay_total) ? 0 : tmp;
-	tmp = d->thrashing_delay_total + tsk->delays->thrashing_delay;
+	tmp = d->thrashing_delay_total + thrashing_delay;
 	d->thrashing_delay_total = (tmp < d->thrashing_delay_total) ? 0 : tmp;
-	d->blkio_count += tsk->delays->blkio_count;
-	d->swapin_count += tsk->delays->swapin_count;
-	d->freepages_count += tsk->delays->freepages_count;
-	d->thrashing_count += tsk->delays->thrashing_count;
-	raw_spin_unlock_irqrestore(&tsk->delays->lock, flags);
+	d->blkio_count += blkio_count;
+	d->swapin_count += swapin_count;
+	d->freepages_count += freepages_count;
+	d->thrashing_count += thrashing_count;
 
 	return 0;
 }
 
 __u64 __delayacct_blkio_ticks(struct task_struct *tsk)
 {
+	unsigned int seq;
 	__u64 ret;
-	unsigned long flags;
 
-	raw_spin_lock_irqsave(&tsk->delays->lock, flags);
-	ret = nsec_to_clock_t(tsk->delays->blkio_delay +
-				tsk->delays->swapin_delay);
-	raw_spin_unlock_irqrestore(&tsk->delays->lock, flags);
+	do {
+		seq = u64_stats_fetch_begin_irq(&tsk->delays->sync);
+		ret = nsec_to_clock_t(tsk->delays->blkio_delay +
+					tsk->delays->swapin_delay);
+	} while (u64_stats_fetch_retry_irq(&tsk->delays->sync, seq));
+
 	return ret;
 }
 
@@ -156,11 +182,13 @@ void __delayacct_freepages_start(void)
 
 void __delayacct_freepages_end(void)
 {
-	delayacct_end(
-		&current->delays->lock,
-		&current->delays->freepages_start,
-		&current->delays->freepages_delay,
-		&current->delays->freepages_count);
+	s64 ns = delayacct_end(&current->delays->sync,
+			       &current->delays->freepages_start,
+			       &current->delays->freepages_delay,
+			       &current->delays->freepages_count);
+
+	if (ns)
+		cgroup_account_delay(current, CGROUP_DELAY_FREEPAGES, ns);
 }
 
 void __delayacct_thrashing_start(void)
@@ -170,8 +198,11 @@ void __delayacct_thrashing_start(void)
 
 void __delayacct_thrashing_end(void)
 {
-	delayacct_end(&current->delays->lock,
-		      &current->delays->thrashing_start,
-		      &current->delays->thrashing_delay,
-		      &current->delays->thrashing_count);
+	s64 ns = delayacct_end(&current->delays->sync,
+			       &current->delays->thrashing_start,
+			       &current->delays->thrashing_delay,
+			       &current->delays->thrashing_count);
+
+	if (ns)
+		cgroup_account_delay(current, CGROUP_DELAY_THRASHING, ns);
 }
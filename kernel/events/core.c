@@ -2105,6 +2105,15 @@ event_sched_out(struct perf_event *event,
 	}
 	perf_event_set_state(event, state);
 
+	/*
+	 * Publish the final count to the self-monitoring userpage, so
+	 * mmap'd readers that find index == 0 can use userpg->offset as
+	 * an up-to-date snapshot instead of falling back to a read()
+	 * syscall while the event is off the PMU.
+	 */
+	if (rcu_access_pointer(event->rb))
+		perf_event_update_userpage(event);
+
 	if (!is_software_event(event))
 		cpuctx->active_oncpu--;
 	if (!--ctx->nr_active)
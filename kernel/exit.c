@@ -475,6 +475,8 @@ static void exit_mm(void)
 	}
 	mmgrab(mm);
 	BUG_ON(mm != current->active_mm);
+	/* drop the concurrency id before letting go of the mm */
+	sched_mm_cid_exit(current);
 	/* more a memory barrier than a real lock */
 	task_lock(current);
 	current->mm = NULL;
@@ -87,6 +87,7 @@
 #include <linux/khugepaged.h>
 #include <linux/signalfd.h>
 #include <linux/uprobes.h>
+#include <linux/prefetch.h>
 #include <linux/aio.h>
 #include <linux/compiler.h>
 #include <linux/sysctl.h>
@@ -351,19 +352,33 @@ struct vm_area_struct *vm_area_alloc(struct mm_struct *mm)
 	return vma;
 }
 
+static void vm_area_init_dup(struct vm_area_struct *new,
+			     struct vm_area_struct *orig)
+{
+	*new = *orig;
+	INIT_LIST_HEAD(&new->anon_vma_chain);
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	seqcount_init(&new->vm_sequence);
+	atomic_set(&new->vm_ref_count, 1);
+#endif
+}
+
 struct vm_area_struct *vm_area_dup(struct vm_area_struct *orig)
 {
 	struct vm_area_struct *new = kmem_cache_alloc(vm_area_cachep, GFP_KERNEL);
 
-	if (new) {
-		*new = *orig;
-		INIT_LIST_HEAD(&new->anon_vma_chain);
-	}
+	if (new)
+		vm_area_init_dup(new, orig);
 	return new;
 }
 
 void vm_area_free(struct vm_area_struct *vma)
 {
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	/* Speculative page fault handlers may still hold a reference. */
+	if (!atomic_dec_and_test(&vma->vm_ref_count))
+		return;
+#endif
 	kmem_cache_free(vm_area_cachep, vma);
 }
 
@@ -475,6 +490,41 @@ void free_task(struct task_struct *tsk)
 EXPORT_SYMBOL(free_task);
 
 #ifdef CONFIG_MMU
+/*
+ * dup_mmap() allocates one vm_area_struct per parent vma back to back, so
+ * grab them from the slab in batches instead of one at a time.
+ */
+#define VMA_DUP_BATCH	16
+
+struct vma_dup_batch {
+	unsigned int nr;
+	void *vmas[VMA_DUP_BATCH];
+};
+
+static struct vm_area_struct *vm_area_dup_batched(struct vma_dup_batch *batch,
+						  struct vm_area_struct *orig)
+{
+	struct vm_area_struct *new;
+
+	if (!batch->nr)
+		batch->nr = kmem_cache_alloc_bulk(vm_area_cachep, GFP_KERNEL,
+						  VMA_DUP_BATCH, batch->vmas);
+	if (!batch->nr) {
+		/* Bulk allocation is all-or-nothing; retry a single vma. */
+		return vm_area_dup(orig);
+	}
+
+	new = batch->vmas[--batch->nr];
+	vm_area_init_dup(new, orig);
+	return new;
+}
+
+static void vma_dup_batch_release(struct vma_dup_batch *batch)
+{
+	if (batch->nr)
+		kmem_cache_free_bulk(vm_area_cachep, batch->nr, batch->vmas);
+}
+
 static __latent_entropy int dup_mmap(struct mm_struct *mm,
 					struct mm_struct *oldmm)
 {
@@ -482,6 +532,7 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 	struct rb_node **rb_link, *rb_parent;
 	int retval;
 	unsigned long charge;
+	struct vma_dup_batch batch = { };
 	LIST_HEAD(uf);
 
 	uprobe_start_dup_mmap();
@@ -518,6 +569,7 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 	for (mpnt = oldmm->mmap; mpnt; mpnt = mpnt->vm_next) {
 		struct file *file;
 
+		prefetch(mpnt->vm_next);
 		if (mpnt->vm_flags & VM_DONTCOPY) {
 			vm_stat_account(mm, mpnt->vm_flags, -vma_pages(mpnt));
 			continue;
@@ -538,7 +590,7 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 				goto fail_nomem;
 			charge = len;
 		}
-		tmp = vm_area_dup(mpnt);
+		tmp = vm_area_dup_batched(&batch, mpnt);
 		if (!tmp)
 			goto fail_nomem;
 		retval = vma_dup_policy(mpnt, tmp);
@@ -609,6 +661,7 @@ static __latent_entropy int dup_mmap(struct mm_struct *mm,
 	/* a new mm has just been created */
 	retval = arch_dup_mmap(oldmm, mm);
 out:
+	vma_dup_batch_release(&batch);
 	up_write(&mm->mmap_sem);
 	flush_tlb_mm(oldmm);
 	up_write(&oldmm->mmap_sem);
@@ -1005,6 +1058,9 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p,
 {
 	mm->mmap = NULL;
 	mm->mm_rb = RB_ROOT;
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	rwlock_init(&mm->mm_rb_lock);
+#endif
 	mm->vmacache_seqnum = 0;
 	atomic_set(&mm->mm_users, 1);
 	atomic_set(&mm->mm_count, 1);
@@ -1019,6 +1075,7 @@ static struct mm_struct *mm_init(struct mm_struct *mm, struct task_struct *p,
 	spin_lock_init(&mm->page_table_lock);
 	spin_lock_init(&mm->arg_lock);
 	mm_init_cpumask(mm);
+	mm_init_cid(mm);
 	mm_init_aio(mm);
 	mm_init_owner(mm, p);
 	RCU_INIT_POINTER(mm->exe_file, NULL);
@@ -2714,7 +2771,7 @@ void __init proc_caches_init(void)
 	 * dynamically sized based on the maximum CPU number this system
 	 * can have, taking hotplug into account (nr_cpu_ids).
 	 */
-	mm_size = sizeof(struct mm_struct) + cpumask_size();
+	mm_size = sizeof(struct mm_struct) + cpumask_size() + mm_cid_size();
 
 	mm_cachep = kmem_cache_create_usercopy("mm_struct",
 			mm_size, ARCH_MIN_MMSTRUCT_ALIGN,
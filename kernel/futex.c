@@ -183,6 +183,7 @@ static int  __read_mostly futex_cmpxchg_enabled;
 #endif
 #define FLAGS_CLOCKRT		0x02
 #define FLAGS_HAS_TIMEOUT	0x04
+#define FLAGS_NUMA		0x08
 
 /*
  * Priority Inheritance state:
@@ -268,6 +269,18 @@ static struct {
 #define futex_queues   (__futex_data.queues)
 #define futex_hashsize (__futex_data.hashsize)
 
+/*
+ * Per-node bucket tables used for FUTEX_NUMA_FLAG hashing. 'queues' is a
+ * dense array with one table per node that had memory at boot, each
+ * allocated on that node; NULL when the machine has a single node or the
+ * boot time allocation failed, in which case flagged futexes simply fall
+ * back to the global table.
+ */
+static struct {
+	struct futex_hash_bucket **queues;
+	unsigned int		 nodes;
+} __futex_numa __read_mostly;
+
 
 /*
  * Fault injections for futexes.
@@ -388,9 +401,30 @@ static struct futex_hash_bucket *hash_futex(union futex_key *key)
 	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
 			  key->both.offset);
 
+	if ((key->both.offset & FUT_OFF_NUMA) && __futex_numa.queues) {
+		struct futex_hash_bucket *table;
+
+		/*
+		 * The node is derived from the hash, so every task picks
+		 * the same table for a given futex. reciprocal_scale()
+		 * consumes the high bits while the bucket index uses the
+		 * low ones, keeping the two selections independent.
+		 */
+		table = __futex_numa.queues[reciprocal_scale(hash,
+							__futex_numa.nodes)];
+		return &table[hash & (futex_hashsize - 1)];
+	}
+
 	return &futex_queues[hash & (futex_hashsize - 1)];
 }
 
+/* Make the key hash into the per-node tables, see hash_futex() */
+static inline void futex_key_set_numa(union futex_key *key, unsigned int flags)
+{
+	if (flags & FLAGS_NUMA)
+		key->both.offset |= FUT_OFF_NUMA;
+}
+
 
 /**
  * match_futex - Check whether two futex keys are equal
@@ -1683,6 +1717,7 @@ futex_wake(u32 __user *uaddr, unsigned int flags, int nr_wake, u32 bitset)
 	ret = get_futex_key(uaddr, flags & FLAGS_SHARED, &key, FUTEX_READ);
 	if (unlikely(ret != 0))
 		goto out;
+	futex_key_set_numa(&key, flags);
 
 	hb = hash_futex(&key);
 
@@ -1785,6 +1820,8 @@ retry:
 	ret = get_futex_key(uaddr2, flags & FLAGS_SHARED, &key2, FUTEX_WRITE);
 	if (unlikely(ret != 0))
 		goto out_put_key1;
+	futex_key_set_numa(&key1, flags);
+	futex_key_set_numa(&key2, flags);
 
 	hb1 = hash_futex(&key1);
 	hb2 = hash_futex(&key2);
@@ -2071,6 +2108,8 @@ retry:
 			    requeue_pi ? FUTEX_WRITE : FUTEX_READ);
 	if (unlikely(ret != 0))
 		goto out_put_key1;
+	futex_key_set_numa(&key1, flags);
+	futex_key_set_numa(&key2, flags);
 
 	/*
 	 * The check above which compares uaddrs is not sufficient for
@@ -2768,6 +2807,7 @@ retry:
 	ret = get_futex_key(uaddr, flags & FLAGS_SHARED, &q->key, FUTEX_READ);
 	if (unlikely(ret != 0))
 		return ret;
+	futex_key_set_numa(&q->key, flags);
 
 retry_private:
 	*hb = queue_lock(q);
@@ -2880,6 +2920,321 @@ static long futex_wait_restart(struct restart_block *restart)
 				restart->futex.val, tp, restart->futex.bitset);
 }
 
+/**
+ * struct futex_vector - Auxiliary struct for futex_waitv()
+ * @w: Userspace provided data
+ * @q: Kernel side data
+ *
+ * Struct used to build an array with all data need for futex_waitv()
+ */
+struct futex_vector {
+	struct futex_waitv w;
+	struct futex_q q;
+};
+
+static int futex_parse_waitv(struct futex_vector *futexv,
+			     struct futex_waitv __user *uwaitv,
+			     unsigned int nr_futexes)
+{
+	struct futex_waitv aux;
+	unsigned int i;
+
+	for (i = 0; i < nr_futexes; i++) {
+		if (copy_from_user(&aux, &uwaitv[i], sizeof(aux)))
+			return -EFAULT;
+
+		if ((aux.flags & ~(FUTEX_32 | FUTEX_PRIVATE_FLAG |
+				   FUTEX_NUMA_FLAG)) || aux.__reserved)
+			return -EINVAL;
+
+		if (!(aux.flags & FUTEX_32))
+			return -EINVAL;
+
+		if ((aux.uaddr % sizeof(u32)) || aux.val > U32_MAX)
+			return -EINVAL;
+
+		futexv[i].w = aux;
+		futexv[i].q = futex_q_init;
+	}
+
+	return 0;
+}
+
+/**
+ * futex_unqueue_multiple - Remove various futexes from their hash bucket
+ * @v:	   The list of futexes to unqueue
+ * @count: Number of futexes in the list
+ *
+ * Helper to unqueue a list of futexes. This can't fail.
+ *
+ * Return:
+ *  - >=0 - Index of the last futex that was awoken;
+ *  - -1  - No futex was awoken
+ */
+static int futex_unqueue_multiple(struct futex_vector *v, unsigned int count)
+{
+	unsigned int i;
+	int ret = -1;
+
+	for (i = 0; i < count; i++) {
+		/* unqueue_me() drops q.key refs */
+		if (!unqueue_me(&v[i].q))
+			ret = i;
+	}
+
+	return ret;
+}
+
+/**
+ * futex_wait_multiple_setup - Prepare to wait and enqueue multiple futexes
+ * @vs:		The futex list to wait on
+ * @count:	The size of the list
+ * @woken:	Index of the last woken futex, if any. Used to notify the
+ *		caller that it can return this index, because it was the
+ *		last queued futex, so the wait condition still holds for
+ *		the others.
+ *
+ * Prepare multiple futexes in a single step and enqueue them. This may
+ * fail if the futex list is invalid or if any futex was already awoken.
+ * On success the task is ready to interruptible sleep.
+ *
+ * Return:
+ *  -  1 - One of the futexes was woken by another thread
+ *  -  0 - Success
+ *  - <0 - -EFAULT, -EWOULDBLOCK or -EINVAL
+ */
+static int futex_wait_multiple_setup(struct futex_vector *vs, int count,
+				     int *woken)
+{
+	struct futex_hash_bucket *hb;
+	bool retry = false;
+	int ret, i;
+	u32 uval;
+
+	/*
+	 * Enqueuing multiple futexes is tricky, because we need to enqueue
+	 * each futex on the list before dealing with the next one to avoid
+	 * deadlocking on the hash bucket. But, before enqueuing, we need to
+	 * make sure that current->state is TASK_INTERRUPTIBLE, so we don't
+	 * lose any wake events, which cannot be done before the get_futex_key
+	 * of the next key, because it calls get_user_pages, which can sleep.
+	 * Thus, we fetch the list of futexes keys in two steps, by first
+	 * pinning all the memory keys in the futex key, and only then we read
+	 * each key and queue the corresponding futex.
+	 *
+	 * Private futexes doesn't need to recalculate hash in retry, so skip
+	 * get_futex_key() when retrying.
+	 */
+retry:
+	for (i = 0; i < count; i++) {
+		if ((vs[i].w.flags & FUTEX_PRIVATE_FLAG) && retry)
+			continue;
+
+		ret = get_futex_key(u64_to_user_ptr(vs[i].w.uaddr),
+				    !(vs[i].w.flags & FUTEX_PRIVATE_FLAG),
+				    &vs[i].q.key, FUTEX_READ);
+
+		if (unlikely(ret))
+			goto put_and_return;
+
+		if (vs[i].w.flags & FUTEX_NUMA_FLAG)
+			vs[i].q.key.both.offset |= FUT_OFF_NUMA;
+	}
+
+	set_current_state(TASK_INTERRUPTIBLE);
+
+	for (i = 0; i < count; i++) {
+		u32 __user *uaddr = u64_to_user_ptr(vs[i].w.uaddr);
+		struct futex_q *q = &vs[i].q;
+		u32 val = (u32)vs[i].w.val;
+
+		hb = queue_lock(q);
+		ret = get_futex_value_locked(&uval, uaddr);
+
+		if (!ret && uval == val) {
+			/*
+			 * The bucket lock can't be held while dealing with
+			 * the next futex. Queue each futex at this moment
+			 * so hb can be unlocked.
+			 */
+			queue_me(q, hb);
+			continue;
+		}
+
+		queue_unlock(hb);
+		__set_current_state(TASK_RUNNING);
+
+		/*
+		 * Even if something went wrong, if we find out that a futex
+		 * was woken, we don't return error and return this index as
+		 * the awoken one.
+		 */
+		*woken = futex_unqueue_multiple(vs, i);
+		/* drop the refs of the futexes that were never queued */
+		while (++i < count)
+			put_futex_key(&vs[i].q.key);
+		put_futex_key(&q->key);
+		if (*woken >= 0)
+			return 1;
+
+		if (ret) {
+			/* -EFAULT: fault in the page and try again */
+			ret = get_user(uval, uaddr);
+			if (ret)
+				return ret;
+
+			retry = true;
+			goto retry;
+		}
+
+		return -EWOULDBLOCK;
+	}
+
+	return 0;
+
+put_and_return:
+	while (--i >= 0)
+		put_futex_key(&vs[i].q.key);
+	return ret;
+}
+
+/**
+ * futex_wait_multiple - Prepare to wait on and enqueue several futexes
+ * @vs:		The list of futexes to wait on
+ * @count:	The number of objects
+ * @to:		Timeout before giving up and returning to userspace
+ *
+ * Entry point for the FUTEX_WAIT_MULTIPLE futex operation, this function
+ * sleeps on a group of futexes and returns on the first futex that is
+ * wake, or after the timeout has elapsed.
+ *
+ * Return:
+ *  - >=0 - Hint to the futex that was awoken
+ *  - <0  - On error
+ */
+static int futex_wait_multiple(struct futex_vector *vs, unsigned int count,
+			       struct hrtimer_sleeper *to)
+{
+	int ret, hint = 0;
+	unsigned int i;
+
+	while (1) {
+		ret = futex_wait_multiple_setup(vs, count, &hint);
+		if (ret) {
+			if (ret > 0) {
+				/* A futex was woken during setup */
+				ret = hint;
+			}
+			return ret;
+		}
+
+		if (to)
+			hrtimer_sleeper_start_expires(to, HRTIMER_MODE_ABS);
+
+		/*
+		 * Avoid sleeping if another thread already tried to
+		 * wake us.
+		 */
+		for (i = 0; i < count; i++) {
+			if (plist_node_empty(&vs[i].q.list))
+				break;
+		}
+
+		if (i == count && (!to || to->task))
+			freezable_schedule();
+
+		__set_current_state(TASK_RUNNING);
+
+		ret = futex_unqueue_multiple(vs, count);
+		if (ret >= 0)
+			return ret;
+
+		if (to && !to->task)
+			return -ETIMEDOUT;
+		else if (signal_pending(current))
+			return -ERESTARTSYS;
+		/*
+		 * The final case is a spurious wakeup, for
+		 * which just retry.
+		 */
+	}
+}
+
+/**
+ * sys_futex_waitv - Wait on a list of futexes
+ * @waiters:    List of futexes to wait on
+ * @nr_futexes: Length of futexv
+ * @flags:      Flag for timeout (monotonic/realtime)
+ * @timeout:	Optional absolute timeout.
+ * @clockid:	Clock to be used for the timeout, realtime or monotonic.
+ *
+ * Given an array of `struct futex_waitv`, wait on each uaddr. The thread
+ * wakes on the first futex_wake() of any futex in the list, or when the
+ * timeout expires.
+ *
+ * Returns the array index of one of the woken futexes. No further
+ * information is provided: any number of other futexes in the list might
+ * have been woken by the same event, and if more than one futex with the
+ * same address was listed, the index of the first one is returned.
+ *
+ * Return:
+ *  - >=0 - Index of the woken futex
+ *  - <0  - On error
+ */
+SYSCALL_DEFINE5(futex_waitv, struct futex_waitv __user *, waiters,
+		unsigned int, nr_futexes, unsigned int, flags,
+		struct __kernel_timespec __user *, timeout, clockid_t, clockid)
+{
+	struct hrtimer_sleeper to, *tp = NULL;
+	struct futex_vector *futexv;
+	struct timespec64 ts;
+	ktime_t time;
+	int ret;
+
+	/* This syscall supports no flags for now */
+	if (flags)
+		return -EINVAL;
+
+	if (!nr_futexes || nr_futexes > FUTEX_WAITV_MAX || !waiters)
+		return -EINVAL;
+
+	if (timeout) {
+		int tflags = FLAGS_HAS_TIMEOUT;
+
+		if (clockid == CLOCK_REALTIME)
+			tflags |= FLAGS_CLOCKRT;
+		else if (clockid != CLOCK_MONOTONIC)
+			return -EINVAL;
+
+		if (get_timespec64(&ts, timeout))
+			return -EFAULT;
+		if (!timespec64_valid(&ts))
+			return -EINVAL;
+
+		time = timespec64_to_ktime(ts);
+		tp = futex_setup_timer(&time, &to, tflags, 0);
+	}
+
+	futexv = kcalloc(nr_futexes, sizeof(*futexv), GFP_KERNEL);
+	if (!futexv) {
+		ret = -ENOMEM;
+		goto destroy_timer;
+	}
+
+	ret = futex_parse_waitv(futexv, waiters, nr_futexes);
+	if (!ret)
+		ret = futex_wait_multiple(futexv, nr_futexes, tp);
+
+	kfree(futexv);
+
+destroy_timer:
+	if (tp) {
+		hrtimer_cancel(&tp->timer);
+		destroy_hrtimer_on_stack(&tp->timer);
+	}
+	return ret;
+}
+
 
 /*
  * Userspace tried a 0 -> TID atomic transition of the futex value
@@ -3880,6 +4235,23 @@ long do_futex(u32 __user *uaddr, int op, u32 val, ktime_t *timeout,
 			return -ENOSYS;
 	}
 
+	if (op & FUTEX_NUMA_FLAG) {
+		flags |= FLAGS_NUMA;
+		switch (cmd) {
+		case FUTEX_WAIT:
+		case FUTEX_WAIT_BITSET:
+		case FUTEX_WAKE:
+		case FUTEX_WAKE_BITSET:
+		case FUTEX_REQUEUE:
+		case FUTEX_CMP_REQUEUE:
+		case FUTEX_WAKE_OP:
+			break;
+		default:
+			/* NUMA hashing is not supported for PI futexes */
+			return -ENOSYS;
+		}
+	}
+
 	switch (cmd) {
 	case FUTEX_LOCK_PI:
 	case FUTEX_UNLOCK_PI:
@@ -4168,6 +4540,48 @@ static void __init futex_detect_cmpxchg(void)
 #endif
 }
 
+static void __init futex_init_numa(void)
+{
+	struct futex_hash_bucket **tables;
+	unsigned int nnodes = 0;
+	unsigned long i;
+	int node;
+
+	if (num_online_nodes() < 2)
+		return;
+
+	tables = kcalloc(num_online_nodes(), sizeof(*tables), GFP_KERNEL);
+	if (!tables)
+		return;
+
+	for_each_online_node(node) {
+		struct futex_hash_bucket *table;
+
+		table = kvzalloc_node(futex_hashsize * sizeof(*table),
+				      GFP_KERNEL, node);
+		if (!table)
+			goto fail;
+
+		for (i = 0; i < futex_hashsize; i++) {
+			atomic_set(&table[i].waiters, 0);
+			plist_head_init(&table[i].chain);
+			spin_lock_init(&table[i].lock);
+		}
+		tables[nnodes++] = table;
+	}
+
+	/* hash_futex() checks ->queues, so publish it last */
+	__futex_numa.nodes = nnodes;
+	smp_wmb();
+	__futex_numa.queues = tables;
+	return;
+
+fail:
+	while (nnodes)
+		kvfree(tables[--nnodes]);
+	kfree(tables);
+}
+
 static int __init futex_init(void)
 {
 	unsigned int futex_shift;
@@ -4194,6 +4608,8 @@ static int __init futex_init(void)
 		spin_lock_init(&futex_queues[i].lock);
 	}
 
+	futex_init_numa();
+
 	return 0;
 }
 core_initcall(futex_init);
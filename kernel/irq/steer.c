@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Feedback driven interrupt steering.
+ *
+ * Userspace balancers like irqbalance sample interrupt counts every few
+ * seconds, which is far too slow when a single CPU saturates in softirq
+ * context, e.g. in net_rx_action() behind one busy queue vector.  When
+ * enabled with the "irqsteer" command line option, a periodic worker
+ * samples the per-CPU softirq time accounted by IRQ_TIME_ACCOUNTING and,
+ * within tens of milliseconds, moves the busiest steerable interrupt
+ * away from a CPU which spent most of the last period in softirq
+ * context towards the least loaded one.
+ *
+ * Only interrupts which userspace could steer as well are touched:
+ * per-CPU, non-balancable and affinity-managed interrupts are left
+ * alone, and both the sampled and the target CPUs are restricted to the
+ * housekeeping mask, so isolated CPUs never receive steered interrupts.
+ */
+#include <linux/cpumask.h>
+#include <linux/delay.h>
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/irqnr.h>
+#include <linux/kernel_stat.h>
+#include <linux/math64.h>
+#include <linux/mm.h>
+#include <linux/sched/isolation.h>
+#include <linux/workqueue.h>
+
+#include "internals.h"
+
+/* Sampling period, and softirq load thresholds in percent of the period */
+static unsigned int irq_steer_period_ms __read_mostly = 20;
+static unsigned int irq_steer_high_pct __read_mostly = 75;
+static unsigned int irq_steer_low_pct __read_mostly = 40;
+
+static bool irq_steer_enabled __read_mostly;
+
+static DEFINE_PER_CPU(u64, irq_steer_softirq_time);
+static u32 *irq_steer_counts;
+static unsigned int irq_steer_nr;
+
+static int __init irq_steer_setup(char *str)
+{
+	irq_steer_enabled = true;
+	return 1;
+}
+__setup("irqsteer", irq_steer_setup);
+
+/*
+ * Percentage of the last period which @cpu spent in softirq context.
+ */
+static unsigned int irq_steer_softirq_load(int cpu)
+{
+	u64 *prev = per_cpu_ptr(&irq_steer_softirq_time, cpu);
+	u64 now = kcpustat_cpu(cpu).cpustat[CPUTIME_SOFTIRQ];
+	u64 delta = now - *prev;
+
+	*prev = now;
+
+	return div64_u64(100 * delta, (u64)irq_steer_period_ms * NSEC_PER_MSEC);
+}
+
+static bool irq_steer_candidate(unsigned int irq, int cpu)
+{
+	struct irq_desc *desc = irq_to_desc(irq);
+	struct irq_data *data;
+
+	if (!desc || !desc->action)
+		return false;
+
+	data = irq_desc_get_irq_data(desc);
+	if (irqd_affinity_is_managed(data) || !irq_can_set_affinity(irq))
+		return false;
+
+	return cpumask_test_cpu(cpu, irq_data_get_effective_affinity_mask(data));
+}
+
+/*
+ * Move the interrupt which fired most on @busiest during a short
+ * observation window over to @target.  One interrupt per period is
+ * enough; if the CPU is still overloaded afterwards, the next period
+ * will move the next one.
+ */
+static void irq_steer_one(int busiest, int target)
+{
+	unsigned int irq, best_irq = 0, best_delta = 0;
+
+	rcu_read_lock();
+	for_each_active_irq(irq) {
+		if (irq >= irq_steer_nr || !irq_steer_candidate(irq, busiest))
+			continue;
+		irq_steer_counts[irq] = kstat_irqs_cpu(irq, busiest);
+	}
+	rcu_read_unlock();
+
+	msleep(max(irq_steer_period_ms / 4, 1U));
+
+	rcu_read_lock();
+	for_each_active_irq(irq) {
+		unsigned int delta;
+
+		if (irq >= irq_steer_nr || !irq_steer_candidate(irq, busiest))
+			continue;
+
+		delta = kstat_irqs_cpu(irq, busiest) - irq_steer_counts[irq];
+		if (delta > best_delta) {
+			best_delta = delta;
+			best_irq = irq;
+		}
+	}
+	rcu_read_unlock();
+
+	if (!best_delta)
+		return;
+
+	if (!irq_set_affinity(best_irq, cpumask_of(target)))
+		pr_debug("irqsteer: moved IRQ%u from CPU%d to CPU%d\n",
+			 best_irq, busiest, target);
+}
+
+static void irq_steer_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(irq_steer_work, irq_steer_work_fn);
+
+static void irq_steer_work_fn(struct work_struct *work)
+{
+	const struct cpumask *hk = housekeeping_cpumask(HK_FLAG_DOMAIN);
+	unsigned int load, high = 0, low = 100;
+	int cpu, busiest = -1, target = -1;
+
+	for_each_cpu_and(cpu, cpu_online_mask, hk) {
+		load = irq_steer_softirq_load(cpu);
+
+		if (load >= irq_steer_high_pct && load > high) {
+			high = load;
+			busiest = cpu;
+		}
+		if (load <= irq_steer_low_pct && load < low) {
+			low = load;
+			target = cpu;
+		}
+	}
+
+	if (busiest >= 0 && target >= 0)
+		irq_steer_one(busiest, target);
+
+	queue_delayed_work(system_unbound_wq, &irq_steer_work,
+			   msecs_to_jiffies(irq_steer_period_ms));
+}
+
+static int __init irq_steer_init(void)
+{
+	int cpu;
+
+	if (!irq_steer_enabled)
+		return 0;
+
+	irq_steer_nr = nr_irqs;
+	irq_steer_counts = kvcalloc(irq_steer_nr, sizeof(*irq_steer_counts),
+				    GFP_KERNEL);
+	if (!irq_steer_counts)
+		return -ENOMEM;
+
+	/* Prime the softirq time baselines before the first period. */
+	for_each_online_cpu(cpu)
+		irq_steer_softirq_load(cpu);
+
+	queue_delayed_work(system_unbound_wq, &irq_steer_work,
+			   msecs_to_jiffies(irq_steer_period_ms));
+
+	return 0;
+}
+late_initcall(irq_steer_init);
@@ -285,6 +285,11 @@ void set_module_sig_enforced(void)
 	sig_enforce = true;
 }
 
+/* Force all modules to request asynchronous device probing. */
+static bool module_async_probe;
+module_param_named(async_probe, module_async_probe, bool, 0644);
+MODULE_PARM_DESC(async_probe, "Force modules to use async probing");
+
 /* Block module loading/unloading? */
 int modules_disabled = 0;
 core_param(nomodule, modules_disabled, bint, 0);
@@ -3514,6 +3519,36 @@ static bool finished_loading(const char *name)
 	return ret;
 }
 
+/*
+ * Fail if a module of the same name is live or in flight.  Must be called
+ * with module_mutex held; drops and re-takes it while waiting for an
+ * in-flight load of the same name to succeed or fail.
+ */
+static int module_patient_check_exists(const char *name)
+{
+	struct module *old;
+	int err;
+
+	old = find_module_all(name, strlen(name), true);
+	while (old != NULL) {
+		if (old->state == MODULE_STATE_LIVE)
+			return -EEXIST;
+
+		/* Wait in case it fails to load. */
+		mutex_unlock(&module_mutex);
+		err = wait_event_interruptible(module_wq,
+					       finished_loading(name));
+		mutex_lock(&module_mutex);
+		if (err)
+			return err;
+
+		/* The module might have gone in the meantime. */
+		old = find_module_all(name, strlen(name), true);
+	}
+
+	return 0;
+}
+
 /* Call module constructors. */
 static void do_mod_ctors(struct module *mod)
 {
@@ -3690,26 +3725,14 @@ static int may_init_module(void)
 static int add_unformed_module(struct module *mod)
 {
 	int err;
-	struct module *old;
 
 	mod->state = MODULE_STATE_UNFORMED;
 
-again:
 	mutex_lock(&module_mutex);
-	old = find_module_all(mod->name, strlen(mod->name), true);
-	if (old != NULL) {
-		if (old->state != MODULE_STATE_LIVE) {
-			/* Wait in case it fails to load. */
-			mutex_unlock(&module_mutex);
-			err = wait_event_interruptible(module_wq,
-					       finished_loading(mod->name));
-			if (err)
-				goto out_unlocked;
-			goto again;
-		}
-		err = -EEXIST;
+	err = module_patient_check_exists(mod->name);
+	if (err)
 		goto out;
-	}
+
 	mod_update_bounds(mod);
 	list_add_rcu(&mod->list, &modules);
 	mod_tree_insert(mod);
@@ -3717,7 +3740,6 @@ again:
 
 out:
 	mutex_unlock(&module_mutex);
-out_unlocked:
 	return err;
 }
 
@@ -3819,6 +3841,19 @@ static int load_module(struct load_info *info, const char __user *uargs,
 		goto free_copy;
 	}
 
+	/*
+	 * Concurrent requests to load the same module are common at boot
+	 * and the losers only find out in add_unformed_module(), after
+	 * paying for section layout and module_alloc().  Check for an
+	 * existing or in-flight module of this name before dedicating any
+	 * resources; add_unformed_module() still arbitrates the race.
+	 */
+	mutex_lock(&module_mutex);
+	err = module_patient_check_exists(info->name);
+	mutex_unlock(&module_mutex);
+	if (err)
+		goto free_copy;
+
 	/* Figure out module layout, and allocate all the memory. */
 	mod = layout_and_allocate(info, flags);
 	if (IS_ERR(mod)) {
@@ -3890,6 +3925,9 @@ static int load_module(struct load_info *info, const char __user *uargs,
 		goto free_arch_cleanup;
 	}
 
+	/* Parsing args may override this with a per-module "async_probe". */
+	mod->async_probe_requested = module_async_probe;
+
 	dynamic_debug_setup(mod, info->debug, info->num_debug);
 
 	/* Ftrace init must be called in the MODULE_STATE_UNFORMED state */
@@ -43,6 +43,7 @@
 #include <linux/rculist.h>
 #include <linux/poll.h>
 #include <linux/irq_work.h>
+#include <linux/kthread.h>
 #include <linux/ctype.h>
 #include <linux/uio.h>
 #include <linux/sched/clock.h>
@@ -1979,6 +1980,62 @@ int vprintk_store(int facility, int level,
 			  dict, dictlen, text, text_len);
 }
 
+/*
+ * Offloading console printing to a kthread keeps slow console drivers
+ * from stalling printk() callers.  Disabled by default; enable with
+ * printk.offload=1 when console latency matters more than having the
+ * caller push its own message out.  The kthread runs at normal priority
+ * so the admin can adjust it with chrt/renice like any other thread.
+ */
+static bool printk_offload;
+module_param_named(offload, printk_offload, bool, 0644);
+
+static struct task_struct *printk_kthread;
+static DECLARE_WAIT_QUEUE_HEAD(printk_offload_wait);
+static bool printk_offload_pending;
+
+static int printk_kthread_func(void *unused)
+{
+	for (;;) {
+		wait_event_interruptible(printk_offload_wait,
+					 READ_ONCE(printk_offload_pending));
+		WRITE_ONCE(printk_offload_pending, false);
+		console_lock();
+		console_unlock();
+	}
+	return 0;
+}
+
+static int __init printk_offload_init(void)
+{
+	struct task_struct *thread;
+
+	thread = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(thread)) {
+		pr_err("failed to start printk offload thread\n");
+		return PTR_ERR(thread);
+	}
+	printk_kthread = thread;
+	return 0;
+}
+late_initcall(printk_offload_init);
+
+/*
+ * Hand console printing over to the offload kthread, unless printing
+ * must stay synchronous because the system is booting or crashing.
+ */
+static bool printk_offload_printing(void)
+{
+	if (!READ_ONCE(printk_offload) || !printk_kthread)
+		return false;
+	if (system_state != SYSTEM_RUNNING || oops_in_progress)
+		return false;
+
+	WRITE_ONCE(printk_offload_pending, true);
+	wake_up_interruptible(&printk_offload_wait);
+	return true;
+}
+
 asmlinkage int vprintk_emit(int facility, int level,
 			    const char *dict, size_t dictlen,
 			    const char *fmt, va_list args)
@@ -2008,7 +2065,7 @@ asmlinkage int vprintk_emit(int facility, int level,
 	logbuf_unlock_irqrestore(flags);
 
 	/* If called from the scheduler, we can not call up(). */
-	if (!in_sched && pending_output) {
+	if (!in_sched && pending_output && !printk_offload_printing()) {
 		/*
 		 * Disable preemption to avoid being preempted while holding
 		 * console_sem which would prevent anyone from printing to
@@ -52,6 +52,8 @@
 #include <linux/sysrq.h>
 #include <linux/kprobes.h>
 #include <linux/gfp.h>
+#include <linux/shrinker.h>
+#include <linux/workqueue.h>
 #include <linux/oom.h>
 #include <linux/smpboot.h>
 #include <linux/jiffies.h>
@@ -2666,6 +2668,162 @@ void kfree_call_rcu(struct rcu_head *head, rcu_callback_t func)
 }
 EXPORT_SYMBOL_GPL(kfree_call_rcu);
 
+/*
+ * Lazy callback batching.  Callbacks queued through call_rcu_lazy() are
+ * parked on a per-CPU list and only handed to the RCU machinery once the
+ * list grows large or LAZY_FLUSH_JIFFIES elapse, so a flood of them is
+ * covered by a handful of grace periods instead of keeping rcu_do_batch()
+ * continuously busy.  A shrinker flushes the lists under memory pressure
+ * and rcu_barrier() flushes them before waiting, preserving its guarantee
+ * for lazily queued callbacks.
+ */
+#define LAZY_FLUSH_JIFFIES	(10 * HZ)
+#define LAZY_BATCH_LIMIT	4096
+
+struct rcu_lazy_pcp {
+	struct rcu_head *head;
+	struct rcu_head **tail;
+	unsigned long count;
+	raw_spinlock_t lock;
+	struct delayed_work work;
+};
+
+static DEFINE_PER_CPU(struct rcu_lazy_pcp, rcu_lazy_pcp);
+static bool rcu_lazy_initialized;
+
+/* Hand all parked callbacks on @rlp to the regular RCU machinery. */
+static void rcu_lazy_flush(struct rcu_lazy_pcp *rlp)
+{
+	struct rcu_head *head;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&rlp->lock, flags);
+	head = rlp->head;
+	rlp->head = NULL;
+	rlp->tail = &rlp->head;
+	rlp->count = 0;
+	raw_spin_unlock_irqrestore(&rlp->lock, flags);
+
+	while (head) {
+		struct rcu_head *next = head->next;
+
+		__call_rcu(head, head->func, 1);
+		head = next;
+	}
+}
+
+static void rcu_lazy_flush_work(struct work_struct *work)
+{
+	rcu_lazy_flush(container_of(to_delayed_work(work),
+				    struct rcu_lazy_pcp, work));
+}
+
+static void rcu_lazy_flush_all(void)
+{
+	int cpu;
+
+	if (!smp_load_acquire(&rcu_lazy_initialized))
+		return;
+
+	for_each_possible_cpu(cpu)
+		rcu_lazy_flush(per_cpu_ptr(&rcu_lazy_pcp, cpu));
+}
+
+/**
+ * call_rcu_lazy() - Queue a callback whose invocation may be deferred.
+ * @head: structure to be used for queueing the RCU updates.
+ * @func: actual callback function to be invoked after the grace period
+ *
+ * Same semantics as call_rcu(), but the callback is understood to only
+ * free memory, so its invocation may be deferred well beyond the end of
+ * the grace period in order to batch grace-period and callback-invocation
+ * work.  Intended for high-rate teardown paths whose callbacks have no
+ * ordering requirements beyond "after all current readers".
+ */
+void call_rcu_lazy(struct rcu_head *head, rcu_callback_t func)
+{
+	struct rcu_lazy_pcp *rlp;
+	unsigned long flags;
+	bool flush = false;
+
+	if (!smp_load_acquire(&rcu_lazy_initialized)) {
+		__call_rcu(head, func, 1);
+		return;
+	}
+
+	head->func = func;
+	head->next = NULL;
+
+	local_irq_save(flags);
+	rlp = this_cpu_ptr(&rcu_lazy_pcp);
+	raw_spin_lock(&rlp->lock);
+	*rlp->tail = head;
+	rlp->tail = &head->next;
+	if (++rlp->count >= LAZY_BATCH_LIMIT)
+		flush = true;
+	else if (rlp->count == 1)
+		schedule_delayed_work_on(smp_processor_id(), &rlp->work,
+					 LAZY_FLUSH_JIFFIES);
+	raw_spin_unlock(&rlp->lock);
+	local_irq_restore(flags);
+
+	if (flush)
+		rcu_lazy_flush(rlp);
+}
+EXPORT_SYMBOL_GPL(call_rcu_lazy);
+
+static unsigned long
+rcu_lazy_shrink_count(struct shrinker *shrink, struct shrink_control *sc)
+{
+	unsigned long count = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		count += READ_ONCE(per_cpu_ptr(&rcu_lazy_pcp, cpu)->count);
+
+	return count;
+}
+
+static unsigned long
+rcu_lazy_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
+{
+	unsigned long count = rcu_lazy_shrink_count(shrink, sc);
+
+	if (!count)
+		return SHRINK_STOP;
+
+	/*
+	 * Flushing doesn't free anything by itself, but it starts the
+	 * grace period that the parked callbacks were holding off.
+	 */
+	rcu_lazy_flush_all();
+	return count;
+}
+
+static struct shrinker rcu_lazy_shrinker = {
+	.count_objects	= rcu_lazy_shrink_count,
+	.scan_objects	= rcu_lazy_shrink_scan,
+	.seeks		= DEFAULT_SEEKS,
+};
+
+static int __init rcu_lazy_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct rcu_lazy_pcp *rlp = per_cpu_ptr(&rcu_lazy_pcp, cpu);
+
+		raw_spin_lock_init(&rlp->lock);
+		rlp->tail = &rlp->head;
+		INIT_DELAYED_WORK(&rlp->work, rcu_lazy_flush_work);
+	}
+	WARN_ON(register_shrinker(&rcu_lazy_shrinker));
+	smp_store_release(&rcu_lazy_initialized, true);
+
+	return 0;
+}
+core_initcall(rcu_lazy_init);
+
 /*
  * During early boot, any blocking grace-period wait automatically
  * implies a grace period.  Later on, this is never the case for PREEMPT.
@@ -2894,6 +3052,14 @@ void rcu_barrier(void)
 	/* Take mutex to serialize concurrent rcu_barrier() requests. */
 	mutex_lock(&rcu_state.barrier_mutex);
 
+	/*
+	 * Hand any parked lazy callbacks to the RCU machinery so that they
+	 * are covered by this barrier.  This must precede the early-exit
+	 * check - a barrier that completed before we got the mutex may have
+	 * flushed before our caller's callbacks were queued.
+	 */
+	rcu_lazy_flush_all();
+
 	/* Did someone else do our work for us? */
 	if (rcu_seq_done(&rcu_state.barrier_sequence, s)) {
 		rcu_barrier_trace(TPS("EarlyExit"), -1,
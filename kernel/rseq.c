@@ -9,6 +9,8 @@
  */
 
 #include <linux/sched.h>
+#include <linux/sched/mm.h>
+#include <linux/topology.h>
 #include <linux/uaccess.h>
 #include <linux/syscalls.h>
 #include <linux/rseq.h>
@@ -81,21 +83,28 @@
  *   F1. <failure>
  */
 
-static int rseq_update_cpu_id(struct task_struct *t)
+static int rseq_update_cpu_node_id(struct task_struct *t)
 {
 	u32 cpu_id = raw_smp_processor_id();
+	u32 node_id = cpu_to_node(cpu_id);
+	u32 mm_cid = t->mm_cid >= 0 ? t->mm_cid : 0;
 
 	if (put_user(cpu_id, &t->rseq->cpu_id_start))
 		return -EFAULT;
 	if (put_user(cpu_id, &t->rseq->cpu_id))
 		return -EFAULT;
+	if (put_user(node_id, &t->rseq->node_id))
+		return -EFAULT;
+	if (put_user(mm_cid, &t->rseq->mm_cid))
+		return -EFAULT;
 	trace_rseq_update(t);
 	return 0;
 }
 
-static int rseq_reset_rseq_cpu_id(struct task_struct *t)
+static int rseq_reset_rseq_cpu_node_id(struct task_struct *t)
 {
 	u32 cpu_id_start = 0, cpu_id = RSEQ_CPU_ID_UNINITIALIZED;
+	u32 node_id = 0, mm_cid = 0;
 
 	/*
 	 * Reset cpu_id_start to its initial state (0).
@@ -109,6 +118,13 @@ static int rseq_reset_rseq_cpu_id(struct task_struct *t)
 	 */
 	if (put_user(cpu_id, &t->rseq->cpu_id))
 		return -EFAULT;
+	/*
+	 * Reset node_id and mm_cid to their initial state (0).
+	 */
+	if (put_user(node_id, &t->rseq->node_id))
+		return -EFAULT;
+	if (put_user(mm_cid, &t->rseq->mm_cid))
+		return -EFAULT;
 	return 0;
 }
 
@@ -271,7 +287,7 @@ void __rseq_handle_notify_resume(struct ksignal *ksig, struct pt_regs *regs)
 	ret = rseq_ip_fixup(regs);
 	if (unlikely(ret < 0))
 		goto error;
-	if (unlikely(rseq_update_cpu_id(t)))
+	if (unlikely(rseq_update_cpu_node_id(t)))
 		goto error;
 	return;
 
@@ -317,9 +333,10 @@ SYSCALL_DEFINE4(rseq, struct rseq __user *, rseq, u32, rseq_len,
 			return -EINVAL;
 		if (current->rseq_sig != sig)
 			return -EPERM;
-		ret = rseq_reset_rseq_cpu_id(current);
+		ret = rseq_reset_rseq_cpu_node_id(current);
 		if (ret)
 			return ret;
+		sched_mm_cid_exit(current);
 		current->rseq = NULL;
 		current->rseq_sig = 0;
 		return 0;
@@ -353,10 +370,11 @@ SYSCALL_DEFINE4(rseq, struct rseq __user *, rseq, u32, rseq_len,
 		return -EFAULT;
 	current->rseq = rseq;
 	current->rseq_sig = sig;
+	sched_mm_cid_activate(current);
 	/*
 	 * If rseq was previously inactive, and has just been
-	 * registered, ensure the cpu_id_start and cpu_id fields
-	 * are updated before returning to user-space.
+	 * registered, ensure the cpu_id_start, cpu_id, node_id and
+	 * mm_cid fields are updated before returning to user-space.
 	 */
 	rseq_set_notify_resume(current);
 
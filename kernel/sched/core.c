@@ -11,6 +11,8 @@
 #include <linux/nospec.h>
 
 #include <linux/kcov.h>
+#include <linux/prctl.h>
+#include <linux/ptrace.h>
 
 #include <asm/switch_to.h>
 #include <asm/tlb.h>
@@ -552,9 +554,19 @@ void resched_cpu(int cpu)
 int get_nohz_timer_target(void)
 {
 	int i, cpu = smp_processor_id();
+	unsigned int hk_flags = HK_FLAG_TIMER;
 	struct sched_domain *sd;
 
-	if (!idle_cpu(cpu) && housekeeping_cpu(cpu, HK_FLAG_TIMER))
+	/*
+	 * Tasks in a timer-housekeeping cpuset keep their timer wheel
+	 * off domain-isolated CPUs too, so that "isolcpus=" alone (which
+	 * does not populate the nohz_full timer mask) is enough to shield
+	 * those CPUs from container timer expiry.
+	 */
+	if (task_timer_housekeep(current))
+		hk_flags |= HK_FLAG_DOMAIN;
+
+	if (!idle_cpu(cpu) && housekeeping_cpu(cpu, hk_flags))
 		return cpu;
 
 	rcu_read_lock();
@@ -563,15 +575,15 @@ int get_nohz_timer_target(void)
 			if (cpu == i)
 				continue;
 
-			if (!idle_cpu(i) && housekeeping_cpu(i, HK_FLAG_TIMER)) {
+			if (!idle_cpu(i) && housekeeping_cpu(i, hk_flags)) {
 				cpu = i;
 				goto unlock;
 			}
 		}
 	}
 
-	if (!housekeeping_cpu(cpu, HK_FLAG_TIMER))
-		cpu = housekeeping_any_cpu(HK_FLAG_TIMER);
+	if (!housekeeping_cpu(cpu, hk_flags))
+		cpu = housekeeping_any_cpu(hk_flags);
 unlock:
 	rcu_read_unlock();
 	return cpu;
@@ -1068,6 +1080,15 @@ uclamp_update_active(struct task_struct *p, enum uclamp_id clamp_id)
 	if (p->uclamp[clamp_id].active) {
 		uclamp_rq_dec_id(rq, p, clamp_id);
 		uclamp_rq_inc_id(rq, p, clamp_id);
+
+		/*
+		 * A changed clamp may raise (or lower) the frequency floor of
+		 * the CPU the task is queued on right away; poke schedutil
+		 * instead of waiting for the next scheduling event to make it
+		 * notice the new rq clamp.
+		 */
+		if (task_on_rq_queued(p))
+			cpufreq_update_util(rq, 0);
 	}
 
 	task_rq_unlock(rq, p, &rf);
@@ -2863,6 +2884,7 @@ int sched_fork(unsigned long clone_flags, struct task_struct *p)
 			p->static_prio = NICE_TO_PRIO(0);
 
 		p->prio = p->normal_prio = __normal_prio(p);
+		p->latency_nice = DEFAULT_LATENCY_NICE;
 		set_load_weight(p, false);
 
 		/*
@@ -3324,6 +3346,44 @@ asmlinkage __visible void schedule_tail(struct task_struct *prev)
 	calculate_sigpending();
 }
 
+#ifdef CONFIG_RSEQ
+/*
+ * Attach a concurrency id to @t when an rseq area is registered.  Runs
+ * on the task itself, which also holds an id across later context
+ * switches until it unregisters, execs or exits.
+ */
+void sched_mm_cid_activate(struct task_struct *t)
+{
+	struct mm_struct *mm = t->mm;
+
+	if (!mm || t->mm_cid_active)
+		return;
+	local_irq_disable();
+	t->mm_cid = mm_cid_get(mm);
+	t->mm_cid_active = 1;
+	local_irq_enable();
+}
+
+/*
+ * Drop @t's concurrency id on rseq unregistration, and on exec and exit
+ * before the task lets go of its mm.  Runs on the task itself.
+ */
+void sched_mm_cid_exit(struct task_struct *t)
+{
+	struct mm_struct *mm = t->mm;
+	unsigned long flags;
+
+	if (!t->mm_cid_active)
+		return;
+	local_irq_save(flags);
+	if (mm)
+		mm_cid_put(mm, t->mm_cid);
+	t->mm_cid = -1;
+	t->mm_cid_active = 0;
+	local_irq_restore(flags);
+}
+#endif
+
 /*
  * context_switch - switch to the new MM and the new thread's register state.
  */
@@ -3374,6 +3434,8 @@ context_switch(struct rq *rq, struct task_struct *prev,
 		}
 	}
 
+	switch_mm_cid(prev, next);
+
 	rq->clock_update_flags &= ~(RQCF_ACT_SKIP|RQCF_REQ_SKIP);
 
 	prepare_lock_switch(rq, next, rf);
@@ -4694,6 +4756,9 @@ static void __setscheduler_params(struct task_struct *p,
 	else if (fair_policy(policy))
 		p->static_prio = NICE_TO_PRIO(attr->sched_nice);
 
+	if (attr->sched_flags & SCHED_FLAG_LATENCY_NICE)
+		p->latency_nice = attr->sched_latency_nice;
+
 	/*
 	 * __sched_setscheduler() ensures attr->sched_priority == 0 when
 	 * !rt_policy. Always setting this ensures that things like
@@ -4834,6 +4899,14 @@ recheck:
 				return -EPERM;
 		}
 
+		/*
+		 * A lower latency_nice buys preemption favors, so treat a
+		 * decrease like a nice decrease: privileged only.
+		 */
+		if ((attr->sched_flags & SCHED_FLAG_LATENCY_NICE) &&
+		    attr->sched_latency_nice < p->latency_nice)
+			return -EPERM;
+
 		/* Can't change other user's priorities: */
 		if (!check_same_owner(p))
 			return -EPERM;
@@ -4893,6 +4966,9 @@ recheck:
 			goto change;
 		if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP)
 			goto change;
+		if ((attr->sched_flags & SCHED_FLAG_LATENCY_NICE) &&
+		    attr->sched_latency_nice != p->latency_nice)
+			goto change;
 
 		p->sched_reset_on_fork = reset_on_fork;
 		retval = 0;
@@ -5141,6 +5217,14 @@ static int sched_copy_attr(struct sched_attr __user *uattr, struct sched_attr *a
 	    size < SCHED_ATTR_SIZE_VER1)
 		return -EINVAL;
 
+	if (attr->sched_flags & SCHED_FLAG_LATENCY_NICE) {
+		if (size < SCHED_ATTR_SIZE_VER2)
+			return -EINVAL;
+		if (attr->sched_latency_nice > MAX_LATENCY_NICE ||
+		    attr->sched_latency_nice < MIN_LATENCY_NICE)
+			return -EINVAL;
+	}
+
 	/*
 	 * XXX: Do we want to be lenient like existing syscalls; or do we want
 	 * to be strict and return an error on out-of-bounds values?
@@ -5370,6 +5454,8 @@ SYSCALL_DEFINE4(sched_getattr, pid_t, pid, struct sched_attr __user *, uattr,
 	else
 		kattr.sched_nice = task_nice(p);
 
+	kattr.sched_latency_nice = p->latency_nice;
+
 #ifdef CONFIG_UCLAMP_TASK
 	kattr.sched_util_min = p->uclamp_req[UCLAMP_MIN].value;
 	kattr.sched_util_max = p->uclamp_req[UCLAMP_MAX].value;
@@ -6383,6 +6469,64 @@ static int cpuset_cpu_inactive(unsigned int cpu)
 	return 0;
 }
 
+#ifdef CONFIG_SCHED_SMT
+/*
+ * Core scheduling cookies: tasks carrying different cookies are kept off
+ * the same SMT core by the idle sibling selection in the wakeup path.
+ * sched_core_tagged keeps the sibling checks compiled out until the first
+ * cookie is created; it stays enabled afterwards since cookies may still
+ * be inherited across fork by running tasks.
+ */
+static atomic64_t sched_core_cookie_gen;
+
+int sched_core_prctl(int op, pid_t pid, unsigned long __user *uaddr)
+{
+	struct task_struct *p = current;
+	unsigned long cookie;
+	int ret = 0;
+
+	if (pid) {
+		rcu_read_lock();
+		p = find_task_by_vpid(pid);
+		if (p)
+			get_task_struct(p);
+		rcu_read_unlock();
+		if (!p)
+			return -ESRCH;
+		if (!ptrace_may_access(p, PTRACE_MODE_READ_REALCREDS)) {
+			put_task_struct(p);
+			return -EPERM;
+		}
+	}
+
+	switch (op) {
+	case PR_SCHED_CORE_GET:
+		cookie = READ_ONCE(p->core_cookie);
+		if (put_user(cookie, uaddr))
+			ret = -EFAULT;
+		break;
+	case PR_SCHED_CORE_CREATE:
+		cookie = atomic64_inc_return(&sched_core_cookie_gen);
+		WRITE_ONCE(p->core_cookie, cookie);
+		static_branch_enable(&sched_core_tagged);
+		break;
+	case PR_SCHED_CORE_SHARE_TO:
+		WRITE_ONCE(p->core_cookie, READ_ONCE(current->core_cookie));
+		break;
+	case PR_SCHED_CORE_CLEAR:
+		WRITE_ONCE(p->core_cookie, 0);
+		break;
+	default:
+		ret = -EINVAL;
+		break;
+	}
+
+	if (pid)
+		put_task_struct(p);
+	return ret;
+}
+#endif /* CONFIG_SCHED_SMT */
+
 int sched_cpu_activate(unsigned int cpu)
 {
 	struct rq *rq = cpu_rq(cpu);
@@ -6631,6 +6775,7 @@ void __init sched_init(void)
 		init_cfs_rq(&rq->cfs);
 		init_rt_rq(&rq->rt);
 		init_dl_rq(&rq->dl);
+		fair_server_init(rq);
 #ifdef CONFIG_FAIR_GROUP_SCHED
 		root_task_group.shares = ROOT_TASK_GROUP_LOAD;
 		INIT_LIST_HEAD(&rq->leaf_cfs_rq_list);
@@ -7372,6 +7517,23 @@ static u64 cpu_shares_read_u64(struct cgroup_subsys_state *css,
 	return (u64) scale_load_down(tg->shares);
 }
 
+static int cpu_wakeup_lat_target_write_u64(struct cgroup_subsys_state *css,
+					   struct cftype *cftype,
+					   u64 target_us)
+{
+	if (target_us > USEC_PER_SEC)
+		return -ERANGE;
+
+	WRITE_ONCE(css_tg(css)->wakeup_lat_ns, target_us * NSEC_PER_USEC);
+	return 0;
+}
+
+static u64 cpu_wakeup_lat_target_read_u64(struct cgroup_subsys_state *css,
+					  struct cftype *cft)
+{
+	return READ_ONCE(css_tg(css)->wakeup_lat_ns) / NSEC_PER_USEC;
+}
+
 #ifdef CONFIG_CFS_BANDWIDTH
 static DEFINE_MUTEX(cfs_constraints_mutex);
 
@@ -7679,6 +7841,11 @@ static struct cftype cpu_legacy_files[] = {
 		.read_u64 = cpu_shares_read_u64,
 		.write_u64 = cpu_shares_write_u64,
 	},
+	{
+		.name = "wakeup_lat_target_us",
+		.read_u64 = cpu_wakeup_lat_target_read_u64,
+		.write_u64 = cpu_wakeup_lat_target_write_u64,
+	},
 #endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
@@ -7880,6 +8047,12 @@ static struct cftype cpu_files[] = {
 		.read_s64 = cpu_weight_nice_read_s64,
 		.write_s64 = cpu_weight_nice_write_s64,
 	},
+	{
+		.name = "wakeup_lat_target_us",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpu_wakeup_lat_target_read_u64,
+		.write_u64 = cpu_wakeup_lat_target_write_u64,
+	},
 #endif
 #ifdef CONFIG_CFS_BANDWIDTH
 	{
@@ -340,11 +340,18 @@ static bool sugov_iowait_reset(struct sugov_cpu *sg_cpu, u64 time,
  *
  * To keep doubling, an IO boost has to be requested at least once per tick,
  * otherwise we restart from the utilization of the minimum OPP.
+ *
+ * SCHED_CPUFREQ_RAMP_BOOST requests, sent for tasks waking up from a long
+ * sleep whose utilization has decayed meanwhile, feed the same machinery:
+ * a one-off wakeup starts from the minimum boost and periodic activations
+ * keep it alive and double it, so they do not stay stuck at the frequency
+ * the idle time decayed us down to.
  */
 static void sugov_iowait_boost(struct sugov_cpu *sg_cpu, u64 time,
 			       unsigned int flags)
 {
-	bool set_iowait_boost = flags & SCHED_CPUFREQ_IOWAIT;
+	bool set_iowait_boost = flags & (SCHED_CPUFREQ_IOWAIT |
+					 SCHED_CPUFREQ_RAMP_BOOST);
 
 	/* Reset boost if the CPU appears to have been idle enough */
 	if (sg_cpu->iowait_boost &&
@@ -30,12 +30,19 @@ static inline struct rq *rq_of_dl_rq(struct dl_rq *dl_rq)
 	return container_of(dl_rq, struct rq, dl);
 }
 
-static inline struct dl_rq *dl_rq_of_se(struct sched_dl_entity *dl_se)
+static inline struct rq *rq_of_dl_se(struct sched_dl_entity *dl_se)
 {
-	struct task_struct *p = dl_task_of(dl_se);
-	struct rq *rq = task_rq(p);
+	struct rq *rq = dl_se->rq;
+
+	if (!dl_se->dl_server)
+		rq = task_rq(dl_task_of(dl_se));
+
+	return rq;
+}
 
-	return &rq->dl;
+static inline struct dl_rq *dl_rq_of_se(struct sched_dl_entity *dl_se)
+{
+	return &rq_of_dl_se(dl_se)->dl;
 }
 
 static inline int on_dl_rq(struct sched_dl_entity *dl_se)
@@ -917,11 +924,10 @@ static inline u64 dl_next_period(struct sched_dl_entity *dl_se)
  * actually started or not (i.e., the replenishment instant is in
  * the future or in the past).
  */
-static int start_dl_timer(struct task_struct *p)
+static int start_dl_timer(struct sched_dl_entity *dl_se)
 {
-	struct sched_dl_entity *dl_se = &p->dl;
 	struct hrtimer *timer = &dl_se->dl_timer;
-	struct rq *rq = task_rq(p);
+	struct rq *rq = rq_of_dl_se(dl_se);
 	ktime_t now, act;
 	s64 delta;
 
@@ -955,7 +961,8 @@ static int start_dl_timer(struct task_struct *p)
 	 * and observe our state.
 	 */
 	if (!hrtimer_is_queued(timer)) {
-		get_task_struct(p);
+		if (!dl_se->dl_server)
+			get_task_struct(dl_task_of(dl_se));
 		hrtimer_start(timer, act, HRTIMER_MODE_ABS_HARD);
 	}
 
@@ -980,10 +987,39 @@ static enum hrtimer_restart dl_task_timer(struct hrtimer *timer)
 	struct sched_dl_entity *dl_se = container_of(timer,
 						     struct sched_dl_entity,
 						     dl_timer);
-	struct task_struct *p = dl_task_of(dl_se);
+	struct task_struct *p;
 	struct rq_flags rf;
 	struct rq *rq;
 
+	if (dl_se->dl_server) {
+		rq = rq_of_dl_se(dl_se);
+
+		rq_lock(rq, &rf);
+		if (dl_se->dl_throttled) {
+			sched_clock_tick();
+			update_rq_clock(rq);
+
+			if (dl_se->dl_server_active) {
+				enqueue_dl_entity(dl_se, dl_se,
+						  ENQUEUE_REPLENISH);
+				if (!dl_task(rq->curr) ||
+				    dl_entity_preempt(dl_se, &rq->curr->dl))
+					resched_curr(rq);
+			} else {
+				/*
+				 * The server was stopped while throttled;
+				 * just replenish so that a restart finds it
+				 * ready to go.
+				 */
+				replenish_dl_entity(dl_se, dl_se);
+			}
+		}
+		rq_unlock(rq, &rf);
+
+		return HRTIMER_NORESTART;
+	}
+
+	p = dl_task_of(dl_se);
 	rq = task_rq_lock(p, &rf);
 
 	/*
@@ -1110,12 +1146,11 @@ void init_dl_task_timer(struct sched_dl_entity *dl_se)
  */
 static inline void dl_check_constrained_dl(struct sched_dl_entity *dl_se)
 {
-	struct task_struct *p = dl_task_of(dl_se);
 	struct rq *rq = rq_of_dl_rq(dl_rq_of_se(dl_se));
 
 	if (dl_time_before(dl_se->deadline, rq_clock(rq)) &&
 	    dl_time_before(rq_clock(rq), dl_next_period(dl_se))) {
-		if (unlikely(dl_se->dl_boosted || !start_dl_timer(p)))
+		if (unlikely(dl_se->dl_boosted || !start_dl_timer(dl_se)))
 			return;
 		dl_se->dl_throttled = 1;
 		if (dl_se->runtime > 0)
@@ -1172,46 +1207,18 @@ static u64 grub_reclaim(u64 delta, struct rq *rq, struct sched_dl_entity *dl_se)
 	return (delta * u_act) >> BW_SHIFT;
 }
 
-/*
- * Update the current task's runtime statistics (provided it is still
- * a -deadline task and has not been removed from the dl_rq).
- */
-static void update_curr_dl(struct rq *rq)
+static void update_curr_dl_se(struct rq *rq, struct sched_dl_entity *dl_se,
+			      s64 delta_exec)
 {
-	struct task_struct *curr = rq->curr;
-	struct sched_dl_entity *dl_se = &curr->dl;
-	u64 delta_exec, scaled_delta_exec;
+	u64 scaled_delta_exec;
 	int cpu = cpu_of(rq);
-	u64 now;
 
-	if (!dl_task(curr) || !on_dl_rq(dl_se))
-		return;
-
-	/*
-	 * Consumed budget is computed considering the time as
-	 * observed by schedulable tasks (excluding time spent
-	 * in hardirq context, etc.). Deadlines are instead
-	 * computed using hard walltime. This seems to be the more
-	 * natural solution, but the full ramifications of this
-	 * approach need further study.
-	 */
-	now = rq_clock_task(rq);
-	delta_exec = now - curr->se.exec_start;
-	if (unlikely((s64)delta_exec <= 0)) {
+	if (unlikely(delta_exec <= 0)) {
 		if (unlikely(dl_se->dl_yielded))
 			goto throttle;
 		return;
 	}
 
-	schedstat_set(curr->se.statistics.exec_max,
-		      max(curr->se.statistics.exec_max, delta_exec));
-
-	curr->se.sum_exec_runtime += delta_exec;
-	account_group_exec_runtime(curr, delta_exec);
-
-	curr->se.exec_start = now;
-	cgroup_account_cputime(curr, delta_exec);
-
 	if (dl_entity_is_special(dl_se))
 		return;
 
@@ -1223,9 +1230,7 @@ static void update_curr_dl(struct rq *rq)
 	 * according to current frequency and CPU maximum capacity.
 	 */
 	if (unlikely(dl_se->flags & SCHED_FLAG_RECLAIM)) {
-		scaled_delta_exec = grub_reclaim(delta_exec,
-						 rq,
-						 &curr->dl);
+		scaled_delta_exec = grub_reclaim(delta_exec, rq, dl_se);
 	} else {
 		unsigned long scale_freq = arch_scale_freq_capacity(cpu);
 		unsigned long scale_cpu = arch_scale_cpu_capacity(cpu);
@@ -1245,12 +1250,23 @@ throttle:
 		    (dl_se->flags & SCHED_FLAG_DL_OVERRUN))
 			dl_se->dl_overrun = 1;
 
-		__dequeue_task_dl(rq, curr, 0);
-		if (unlikely(dl_se->dl_boosted || !start_dl_timer(curr)))
-			enqueue_task_dl(rq, curr, ENQUEUE_REPLENISH);
-
-		if (!is_leftmost(curr, &rq->dl))
+		if (dl_se->dl_server) {
+			dequeue_dl_entity(dl_se);
+			if (!start_dl_timer(dl_se))
+				enqueue_dl_entity(dl_se, dl_se,
+						  ENQUEUE_REPLENISH);
 			resched_curr(rq);
+		} else {
+			struct task_struct *curr = dl_task_of(dl_se);
+
+			__dequeue_task_dl(rq, curr, 0);
+			if (unlikely(dl_se->dl_boosted ||
+				     !start_dl_timer(dl_se)))
+				enqueue_task_dl(rq, curr, ENQUEUE_REPLENISH);
+
+			if (!is_leftmost(curr, &rq->dl))
+				resched_curr(rq);
+		}
 	}
 
 	/*
@@ -1279,6 +1295,91 @@ throttle:
 	}
 }
 
+/*
+ * Update the current task's runtime statistics (provided it is still
+ * a -deadline task and has not been removed from the dl_rq).
+ */
+static void update_curr_dl(struct rq *rq)
+{
+	struct task_struct *curr = rq->curr;
+	struct sched_dl_entity *dl_se = &curr->dl;
+	s64 delta_exec;
+	u64 now;
+
+	if (!dl_task(curr) || !on_dl_rq(dl_se))
+		return;
+
+	/*
+	 * Consumed budget is computed considering the time as
+	 * observed by schedulable tasks (excluding time spent
+	 * in hardirq context, etc.). Deadlines are instead
+	 * computed using hard walltime. This seems to be the more
+	 * natural solution, but the full ramifications of this
+	 * approach need further study.
+	 */
+	now = rq_clock_task(rq);
+	delta_exec = now - curr->se.exec_start;
+
+	if (delta_exec > 0) {
+		schedstat_set(curr->se.statistics.exec_max,
+			      max(curr->se.statistics.exec_max,
+				  (u64)delta_exec));
+
+		curr->se.sum_exec_runtime += delta_exec;
+		account_group_exec_runtime(curr, delta_exec);
+
+		curr->se.exec_start = now;
+		cgroup_account_cputime(curr, delta_exec);
+	}
+
+	update_curr_dl_se(rq, dl_se, delta_exec);
+}
+
+/*
+ * A server entity is charged for whatever runs out of the class it
+ * serves; called from that class's update_curr() with the time its
+ * current task just consumed.
+ */
+void dl_server_update(struct sched_dl_entity *dl_se, s64 delta_exec)
+{
+	if (dl_se->dl_server_active && !dl_se->dl_throttled &&
+	    dl_se->dl_runtime)
+		update_curr_dl_se(dl_se->rq, dl_se, delta_exec);
+}
+
+void dl_server_start(struct sched_dl_entity *dl_se)
+{
+	struct rq *rq = dl_se->rq;
+
+	if (!dl_se->dl_runtime || dl_se->dl_server_active)
+		return;
+
+	dl_se->dl_server_active = 1;
+	enqueue_dl_entity(dl_se, dl_se, ENQUEUE_WAKEUP);
+	if (!dl_task(rq->curr) || dl_entity_preempt(dl_se, &rq->curr->dl))
+		resched_curr(rq);
+}
+
+void dl_server_stop(struct sched_dl_entity *dl_se)
+{
+	if (!dl_se->dl_server_active)
+		return;
+
+	if (on_dl_rq(dl_se))
+		dequeue_dl_entity(dl_se);
+	hrtimer_try_to_cancel(&dl_se->dl_timer);
+	dl_se->dl_throttled = 0;
+	dl_se->dl_server_active = 0;
+}
+
+void dl_server_init(struct sched_dl_entity *dl_se, struct rq *rq,
+		    struct task_struct *(*server_pick)(struct sched_dl_entity *))
+{
+	dl_se->rq = rq;
+	dl_se->server_pick = server_pick;
+	dl_se->dl_server = 1;
+}
+
 static enum hrtimer_restart inactive_task_timer(struct hrtimer *timer)
 {
 	struct sched_dl_entity *dl_se = container_of(timer,
@@ -1374,28 +1475,35 @@ static inline void dec_dl_deadline(struct dl_rq *dl_rq, u64 deadline) {}
 static inline
 void inc_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 {
-	int prio = dl_task_of(dl_se)->prio;
 	u64 deadline = dl_se->deadline;
 
-	WARN_ON(!dl_prio(prio));
 	dl_rq->dl_nr_running++;
-	add_nr_running(rq_of_dl_rq(dl_rq), 1);
-
 	inc_dl_deadline(dl_rq, deadline);
+
+	/*
+	 * The tasks a server runs on behalf of are already counted by
+	 * their own class, and servers never migrate.
+	 */
+	if (dl_se->dl_server)
+		return;
+
+	WARN_ON(!dl_prio(dl_task_of(dl_se)->prio));
+	add_nr_running(rq_of_dl_rq(dl_rq), 1);
 	inc_dl_migration(dl_se, dl_rq);
 }
 
 static inline
 void dec_dl_tasks(struct sched_dl_entity *dl_se, struct dl_rq *dl_rq)
 {
-	int prio = dl_task_of(dl_se)->prio;
-
-	WARN_ON(!dl_prio(prio));
 	WARN_ON(!dl_rq->dl_nr_running);
 	dl_rq->dl_nr_running--;
-	sub_nr_running(rq_of_dl_rq(dl_rq), 1);
-
 	dec_dl_deadline(dl_rq, dl_se->deadline);
+
+	if (dl_se->dl_server)
+		return;
+
+	WARN_ON(!dl_prio(dl_task_of(dl_se)->prio));
+	sub_nr_running(rq_of_dl_rq(dl_rq), 1);
 	dec_dl_migration(dl_se, dl_rq);
 }
 
@@ -1451,7 +1559,9 @@ enqueue_dl_entity(struct sched_dl_entity *dl_se,
 	 * we want a replenishment of its runtime.
 	 */
 	if (flags & ENQUEUE_WAKEUP) {
-		task_contending(dl_se, flags);
+		/* Servers are not subject to GRUB's active utilization. */
+		if (!dl_se->dl_server)
+			task_contending(dl_se, flags);
 		update_dl_entity(dl_se, pi_se);
 	} else if (flags & ENQUEUE_REPLENISH) {
 		replenish_dl_entity(dl_se, pi_se);
@@ -1787,6 +1897,22 @@ pick_next_task_dl(struct rq *rq, struct task_struct *prev, struct rq_flags *rf)
 
 	dl_se = pick_next_dl_entity(rq, dl_rq);
 	BUG_ON(!dl_se);
+
+	if (dl_se->dl_server) {
+		p = dl_se->server_pick(dl_se);
+		if (!p) {
+			/*
+			 * The server is active but the class it serves has
+			 * nothing runnable; shut it down and let the core
+			 * retry the pick.
+			 */
+			WARN_ON_ONCE(1);
+			dl_server_stop(dl_se);
+			return NULL;
+		}
+		return p;
+	}
+
 	p = dl_task_of(dl_se);
 	set_next_task_dl(rq, p, true);
 	return p;
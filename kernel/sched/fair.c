@@ -22,6 +22,8 @@
  */
 #include "sched.h"
 
+#include <linux/migrate.h>
+
 #include <trace/events/sched.h>
 
 /*
@@ -856,10 +858,15 @@ static void update_curr(struct cfs_rq *cfs_rq)
 
 	if (entity_is_task(curr)) {
 		struct task_struct *curtask = task_of(curr);
+		struct rq *rq = rq_of(cfs_rq);
 
 		trace_sched_stat_runtime(curtask, delta_exec, curr->vruntime);
 		cgroup_account_cputime(curtask, delta_exec);
 		account_group_exec_runtime(curtask, delta_exec);
+
+		/* Charge the fair server backing this runqueue. */
+		if (dl_server_active(&rq->fair_server))
+			dl_server_update(&rq->fair_server, delta_exec);
 	}
 
 	account_cfs_rq_runtime(cfs_rq, delta_exec);
@@ -1415,6 +1422,15 @@ bool should_numa_migrate_memory(struct task_struct *p, struct page * page,
 	this_cpupid = cpu_pid_to_cpupid(dst_cpu, current->pid);
 	last_cpupid = page_cpupid_xchg_last(page, this_cpupid);
 
+	/*
+	 * Pages on memory-only nodes (e.g. PMEM used as a slow tier) have
+	 * no task locality to preserve: a hint fault means the page is
+	 * hot, so promote it towards the faulting CPU without applying
+	 * the two-stage filter below.
+	 */
+	if (numa_demotion_enabled && !node_state(src_nid, N_CPU))
+		return true;
+
 	/*
 	 * Allow first faults or private faults to migrate immediately early in
 	 * the lifetime of a task. The magic number 4 is based on waiting for
@@ -2506,6 +2522,9 @@ static void task_numa_work(struct callback_head *work)
 	if (p->flags & PF_EXITING)
 		return;
 
+	if (test_bit(MMF_DISABLE_NUMA_BALANCING, &mm->flags))
+		return;
+
 	if (!mm->numa_next_scan) {
 		mm->numa_next_scan = now +
 			msecs_to_jiffies(sysctl_numa_balancing_scan_delay);
@@ -5226,9 +5245,23 @@ enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	 * If in_iowait is set, the code below may not trigger any cpufreq
 	 * utilization updates, so do it here explicitly with the IOWAIT flag
 	 * passed.
+	 *
+	 * Similarly, a task waking up from a sleep longer than a tick comes
+	 * back with a decayed utilization which can take many PELT windows to
+	 * ramp back up.  Ask schedutil for a ramp boost so that short periodic
+	 * activations do not keep running at the idle-time frequency.
 	 */
 	if (p->in_iowait)
 		cpufreq_update_util(rq, SCHED_CPUFREQ_IOWAIT);
+	else if (sched_feat(RAMP_BOOST) && (flags & ENQUEUE_WAKEUP) &&
+		 (s64)(rq_clock_task(rq) - p->se.exec_start) > (s64)TICK_NSEC)
+		cpufreq_update_util(rq, SCHED_CPUFREQ_RAMP_BOOST);
+
+	/*
+	 * Arm the fair server reservation: while fair tasks are runnable
+	 * they compete at deadline priority through it.
+	 */
+	dl_server_start(&rq->fair_server);
 
 	for_each_sched_entity(se) {
 		if (se->on_rq)
@@ -5368,6 +5401,10 @@ dequeue_throttle:
 	if (!se)
 		sub_nr_running(rq, 1);
 
+	/* No fair tasks left; the server has nothing to serve. */
+	if (!rq->cfs.h_nr_running)
+		dl_server_stop(&rq->fair_server);
+
 	util_est_dequeue(&rq->cfs, p, task_sleep);
 	hrtick_update(rq);
 }
@@ -5828,6 +5865,33 @@ static inline int find_idlest_cpu(struct sched_domain *sd, struct task_struct *p
 
 #ifdef CONFIG_SCHED_SMT
 DEFINE_STATIC_KEY_FALSE(sched_smt_present);
+DEFINE_STATIC_KEY_FALSE(sched_core_tagged);
+
+/*
+ * Can @p run on @cpu without sharing an SMT core with a task that carries
+ * a different core scheduling cookie? Idle siblings are always compatible.
+ */
+static inline bool sched_core_cookie_match(struct task_struct *p, int cpu)
+{
+	int sibling;
+
+	if (!static_branch_unlikely(&sched_core_tagged))
+		return true;
+
+	for_each_cpu(sibling, cpu_smt_mask(cpu)) {
+		struct rq *rq = cpu_rq(sibling);
+		struct task_struct *curr;
+
+		if (sibling == cpu)
+			continue;
+		curr = READ_ONCE(rq->curr);
+		if (curr != rq->idle &&
+		    READ_ONCE(curr->core_cookie) != p->core_cookie)
+			return false;
+	}
+
+	return true;
+}
 EXPORT_SYMBOL_GPL(sched_smt_present);
 
 static inline void set_idle_cores(int cpu, int val)
@@ -5931,6 +5995,8 @@ static int select_idle_smt(struct task_struct *p, int target)
 	for_each_cpu(cpu, cpu_smt_mask(target)) {
 		if (!cpumask_test_cpu(cpu, p->cpus_ptr))
 			continue;
+		if (!sched_core_cookie_match(p, cpu))
+			continue;
 		if (available_idle_cpu(cpu))
 			return cpu;
 		if (si_cpu == -1 && sched_idle_cpu(cpu))
@@ -5952,6 +6018,11 @@ static inline int select_idle_smt(struct task_struct *p, int target)
 	return -1;
 }
 
+static inline bool sched_core_cookie_match(struct task_struct *p, int cpu)
+{
+	return true;
+}
+
 #endif /* CONFIG_SCHED_SMT */
 
 /*
@@ -5959,9 +6030,22 @@ static inline int select_idle_smt(struct task_struct *p, int target)
  * comparing the average scan cost (tracked in sd->avg_scan_cost) against the
  * average idle time for this rq (as found in rq->avg_idle).
  */
+#ifdef CONFIG_FAIR_GROUP_SCHED
+static inline u64 task_wakeup_lat_target(struct task_struct *p)
+{
+	return READ_ONCE(task_group(p)->wakeup_lat_ns);
+}
+#else
+static inline u64 task_wakeup_lat_target(struct task_struct *p)
+{
+	return 0;
+}
+#endif
+
 static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, int target)
 {
 	struct cpumask *cpus = this_cpu_cpumask_var_ptr(select_idle_mask);
+	u64 lat_target = task_wakeup_lat_target(p);
 	struct sched_domain *this_sd;
 	u64 avg_cost, avg_idle;
 	u64 time, cost;
@@ -5980,10 +6064,27 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, int t
 	avg_idle = this_rq()->avg_idle / 512;
 	avg_cost = this_sd->avg_scan_cost + 1;
 
-	if (sched_feat(SIS_AVG_CPU) && avg_idle < avg_cost)
+	if (!lat_target && sched_feat(SIS_AVG_CPU) && avg_idle < avg_cost)
 		return -1;
 
-	if (sched_feat(SIS_PROP)) {
+	if (lat_target) {
+		/*
+		 * The group asked for a wakeup latency target, so size the
+		 * scan off that instead of rq->avg_idle. The tighter the
+		 * target, the more CPUs we are willing to examine to avoid
+		 * queueing the task behind running work: targets at or
+		 * below sysctl_sched_migration_cost buy the full LLC scan,
+		 * larger (more latency-tolerant) targets scale down
+		 * proportionally towards the cheap four-CPU glance.
+		 */
+		if (lat_target <= sysctl_sched_migration_cost)
+			nr = sd->span_weight;
+		else
+			nr = max_t(int, 4,
+				   div_u64(sd->span_weight *
+					   sysctl_sched_migration_cost,
+					   lat_target));
+	} else if (sched_feat(SIS_PROP)) {
 		u64 span_avg = sd->span_weight * avg_idle;
 		if (span_avg > 4*avg_cost)
 			nr = div_u64(span_avg, avg_cost);
@@ -5998,6 +6099,8 @@ static int select_idle_cpu(struct task_struct *p, struct sched_domain *sd, int t
 	for_each_cpu_wrap(cpu, cpus, target) {
 		if (!--nr)
 			return si_cpu;
+		if (!sched_core_cookie_match(p, cpu))
+			continue;
 		if (available_idle_cpu(cpu))
 			break;
 		if (si_cpu == -1 && sched_idle_cpu(cpu))
@@ -6020,14 +6123,16 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 	struct sched_domain *sd;
 	int i, recent_used_cpu;
 
-	if (available_idle_cpu(target) || sched_idle_cpu(target))
+	if ((available_idle_cpu(target) || sched_idle_cpu(target)) &&
+	    sched_core_cookie_match(p, target))
 		return target;
 
 	/*
 	 * If the previous CPU is cache affine and idle, don't be stupid:
 	 */
 	if (prev != target && cpus_share_cache(prev, target) &&
-	    (available_idle_cpu(prev) || sched_idle_cpu(prev)))
+	    (available_idle_cpu(prev) || sched_idle_cpu(prev)) &&
+	    sched_core_cookie_match(p, prev))
 		return prev;
 
 	/* Check a recently used CPU as a potential idle candidate: */
@@ -6036,7 +6141,8 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 	    recent_used_cpu != target &&
 	    cpus_share_cache(recent_used_cpu, target) &&
 	    (available_idle_cpu(recent_used_cpu) || sched_idle_cpu(recent_used_cpu)) &&
-	    cpumask_test_cpu(p->recent_used_cpu, p->cpus_ptr)) {
+	    cpumask_test_cpu(p->recent_used_cpu, p->cpus_ptr) &&
+	    sched_core_cookie_match(p, recent_used_cpu)) {
 		/*
 		 * Replace recent_used_cpu with prev as it is a potential
 		 * candidate for the next wake:
@@ -6053,6 +6159,14 @@ static int select_idle_sibling(struct task_struct *p, int prev, int target)
 	if ((unsigned)i < nr_cpumask_bits)
 		return i;
 
+	/*
+	 * Tasks that tolerate maximum latency don't get the expensive
+	 * LLC-wide scan; the cheap placement is good enough for them
+	 * and the scan cost is better spent on latency-sensitive tasks.
+	 */
+	if (p->latency_nice == MAX_LATENCY_NICE)
+		return target;
+
 	i = select_idle_cpu(p, sd, target);
 	if ((unsigned)i < nr_cpumask_bits)
 		return i;
@@ -6615,6 +6729,18 @@ static unsigned long wakeup_gran(struct sched_entity *se)
 {
 	unsigned long gran = sysctl_sched_wakeup_granularity;
 
+	/*
+	 * Scale the granularity by the waking task's latency_nice: a
+	 * latency-tolerant task (> 0) needs a bigger vruntime lead to
+	 * preempt the current task, up to ~2x gran at MAX_LATENCY_NICE,
+	 * while a latency-sensitive task (< 0) preempts with less, down
+	 * to none at MIN_LATENCY_NICE.  This only gates preemption at
+	 * wakeup; the task's share of CPU time is unaffected.
+	 */
+	if (entity_is_task(se))
+		gran += (long)gran * task_of(se)->latency_nice /
+			(LATENCY_NICE_WIDTH / 2);
+
 	/*
 	 * Since its curr running now, convert the gran from real-time
 	 * to virtual-time in his units.
@@ -6920,6 +7046,34 @@ idle:
 	return NULL;
 }
 
+static struct task_struct *fair_server_pick(struct sched_dl_entity *dl_se)
+{
+	return pick_next_task_fair(dl_se->rq, NULL, NULL);
+}
+
+/*
+ * The fair server backs the whole fair class with a deadline
+ * reservation: while fair tasks are runnable the server is enqueued on
+ * the dl runqueue and, when picked, runs whatever the fair class would
+ * run. 50ms every 1s is plenty for a control plane and small enough not
+ * to disturb actual deadline tasks.
+ */
+void fair_server_init(struct rq *rq)
+{
+	struct sched_dl_entity *dl_se = &rq->fair_server;
+
+	RB_CLEAR_NODE(&dl_se->rb_node);
+
+	dl_se->dl_runtime = 50 * NSEC_PER_MSEC;
+	dl_se->dl_deadline = 1000 * NSEC_PER_MSEC;
+	dl_se->dl_period = 1000 * NSEC_PER_MSEC;
+	dl_se->dl_bw = to_ratio(dl_se->dl_period, dl_se->dl_runtime);
+	dl_se->dl_density = to_ratio(dl_se->dl_deadline, dl_se->dl_runtime);
+
+	init_dl_task_timer(dl_se);
+	dl_server_init(dl_se, rq, fair_server_pick);
+}
+
 /*
  * Account for a descheduled task:
  */
@@ -89,3 +89,10 @@ SCHED_FEAT(WA_BIAS, true)
  * UtilEstimation. Use estimated CPU utilization.
  */
 SCHED_FEAT(UTIL_EST, true)
+
+/*
+ * Request a schedutil frequency boost when a task wakes up from a sleep
+ * longer than a tick, to compensate for the PELT utilization decayed
+ * while the CPU was idle.
+ */
+SCHED_FEAT(RAMP_BOOST, true)
@@ -164,9 +164,10 @@ __setup("psi=", setup_psi);
 #define EXP_300s	2034		/* 1/exp(2s/300s) */
 
 /* PSI trigger definitions */
-#define WINDOW_MIN_US 500000	/* Min window size is 500ms */
-#define WINDOW_MAX_US 10000000	/* Max window size is 10s */
-#define UPDATES_PER_WINDOW 10	/* 10 updates per window */
+#define WINDOW_MIN_US 10000		/* Min window size is 10ms */
+#define WINDOW_MAX_US 10000000		/* Max window size is 10s */
+#define UNPRIV_WINDOW_MIN_US 500000	/* Min window for unprivileged users */
+#define UPDATES_PER_WINDOW 10		/* 10 updates per window */
 
 /* Sampling frequency in nanoseconds */
 static u64 psi_period __read_mostly;
@@ -1029,6 +1030,14 @@ struct psi_trigger *psi_trigger_create(struct psi_group *group,
 		window_us > WINDOW_MAX_US)
 		return ERR_PTR(-EINVAL);
 
+	/*
+	 * Sub-500ms windows make the SCHED_FIFO poll worker sample every
+	 * window/10, so keep them for privileged users; triggers remain
+	 * rate-limited to one wakeup per window either way.
+	 */
+	if (window_us < UNPRIV_WINDOW_MIN_US && !capable(CAP_SYS_RESOURCE))
+		return ERR_PTR(-EPERM);
+
 	/* Check threshold */
 	if (threshold_us == 0 || threshold_us > window_us)
 		return ERR_PTR(-EINVAL);
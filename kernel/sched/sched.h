@@ -368,6 +368,15 @@ struct task_group {
 	struct cfs_rq		**cfs_rq;
 	unsigned long		shares;
 
+	/*
+	 * Wakeup latency target (ns) for tasks in this group, set through
+	 * the cpu.wakeup_lat_target_us cgroup attribute. It steers how many
+	 * CPUs select_idle_cpu() is willing to examine on wakeup: groups
+	 * with a tight target get a full LLC scan, latency-tolerant groups
+	 * take the cheap path. 0 selects the default avg_idle heuristics.
+	 */
+	u64			wakeup_lat_ns;
+
 #ifdef	CONFIG_SMP
 	/*
 	 * load_avg can be heavily contended at clock tick time, so put
@@ -888,6 +897,13 @@ struct rq {
 	struct rt_rq		rt;
 	struct dl_rq		dl;
 
+	/*
+	 * Deadline reservation backing the whole fair class on this
+	 * runqueue: while it has budget, runnable fair entities run with
+	 * deadline priority and cannot be starved by RT activity.
+	 */
+	struct sched_dl_entity	fair_server;
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	/* list of leaf cfs_rq on this CPU: */
 	struct list_head	leaf_cfs_rq_list;
@@ -1034,6 +1050,7 @@ static inline int cpu_of(struct rq *rq)
 
 
 #ifdef CONFIG_SCHED_SMT
+extern struct static_key_false sched_core_tagged;
 extern void __update_idle_core(struct rq *rq);
 
 static inline void update_idle_core(struct rq *rq)
@@ -1884,6 +1901,18 @@ extern struct dl_bandwidth def_dl_bandwidth;
 extern void init_dl_bandwidth(struct dl_bandwidth *dl_b, u64 period, u64 runtime);
 extern void init_dl_task_timer(struct sched_dl_entity *dl_se);
 extern void init_dl_inactive_task_timer(struct sched_dl_entity *dl_se);
+
+extern void dl_server_update(struct sched_dl_entity *dl_se, s64 delta_exec);
+extern void dl_server_start(struct sched_dl_entity *dl_se);
+extern void dl_server_stop(struct sched_dl_entity *dl_se);
+extern void dl_server_init(struct sched_dl_entity *dl_se, struct rq *rq,
+		    struct task_struct *(*server_pick)(struct sched_dl_entity *));
+extern void fair_server_init(struct rq *rq);
+
+static inline bool dl_server_active(struct sched_dl_entity *dl_se)
+{
+	return dl_se->dl_server_active;
+}
 extern void init_dl_rq_bw_ratio(struct dl_rq *dl_rq);
 
 #define BW_SHIFT		20
@@ -2504,3 +2533,64 @@ static inline void membarrier_switch_mm(struct rq *rq,
 {
 }
 #endif
+
+#ifdef CONFIG_RSEQ
+/*
+ * Concurrency ids are dense replacements for cpu numbers: a thread owns
+ * one while it runs on a CPU, so the ids handed out for an mm stay below
+ * the number of CPUs concurrently running that mm rather than the number
+ * of CPUs in the machine.  Interrupts must be disabled.
+ */
+static inline int mm_cid_get(struct mm_struct *mm)
+{
+	struct cpumask *cpumask = mm_cidmask(mm);
+	int cid;
+
+	lockdep_assert_irqs_disabled();
+	raw_spin_lock(&mm->cid_lock);
+	cid = cpumask_first_zero(cpumask);
+	if (cid >= nr_cpu_ids)
+		cid = -1;
+	else
+		__cpumask_set_cpu(cid, cpumask);
+	raw_spin_unlock(&mm->cid_lock);
+	return cid;
+}
+
+static inline void mm_cid_put(struct mm_struct *mm, int cid)
+{
+	lockdep_assert_irqs_disabled();
+	if (cid < 0)
+		return;
+	raw_spin_lock(&mm->cid_lock);
+	__cpumask_clear_cpu(cid, mm_cidmask(mm));
+	raw_spin_unlock(&mm->cid_lock);
+}
+
+static inline void switch_mm_cid(struct task_struct *prev,
+				 struct task_struct *next)
+{
+	if (prev->mm_cid_active) {
+		if (next->mm_cid_active && next->mm == prev->mm &&
+		    prev->mm_cid >= 0) {
+			/*
+			 * Context switch between threads of the same mm:
+			 * hand the id over, it stays dense and the bitmap
+			 * is left alone.
+			 */
+			next->mm_cid = prev->mm_cid;
+			prev->mm_cid = -1;
+			return;
+		}
+		mm_cid_put(prev->mm, prev->mm_cid);
+		prev->mm_cid = -1;
+	}
+	if (next->mm_cid_active)
+		next->mm_cid = mm_cid_get(next->mm);
+}
+#else
+static inline void switch_mm_cid(struct task_struct *prev,
+				 struct task_struct *next)
+{
+}
+#endif
@@ -1853,6 +1853,26 @@ int send_sigqueue(struct sigqueue *q, struct pid *pid, enum pid_type type)
 
 	BUG_ON(!(q->flags & SIGQUEUE_PREALLOC));
 
+	/*
+	 * A preallocated timer sigqueue is enqueued and dequeued only
+	 * under sighand->siglock, and expiries of one timer are
+	 * serialized by the timer's it_lock.  So if the previous
+	 * expiry's signal is still queued, the only work left is to
+	 * fold this expiry into si_overrun, which nothing but this
+	 * (serialized) expiry path writes while the entry is queued.
+	 * Do that without siglock: a high-rate per-thread timer whose
+	 * consumer lags behind would otherwise bounce the siglock
+	 * cacheline on every coalesced expiry.  Racing with a
+	 * concurrent dequeue yields the same outcomes as losing the
+	 * siglock race in the slow path below - the expiry is counted
+	 * against either this signal or the next one.
+	 */
+	if (unlikely(!list_empty(&q->list))) {
+		BUG_ON(q->info.si_code != SI_TIMER);
+		WRITE_ONCE(q->info.si_overrun, q->info.si_overrun + 1);
+		return 0;
+	}
+
 	ret = -1;
 	rcu_read_lock();
 	t = pid_task(pid, type);
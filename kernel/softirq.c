@@ -25,6 +25,8 @@
 #include <linux/smpboot.h>
 #include <linux/tick.h>
 #include <linux/irq.h>
+#include <linux/ctype.h>
+#include <linux/sched/clock.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/irq.h>
@@ -76,6 +78,29 @@ static void wakeup_softirqd(void)
 		wake_up_process(tsk);
 }
 
+/*
+ * Vectors forced into dedicated per-CPU threads with the softirq_threads=
+ * command line option.  Raising such a vector does not mark it pending for
+ * __do_softirq(); it is recorded in softirq_threaded_pending and served by
+ * the vector's thread, so the work competes for CPU time under the
+ * scheduler instead of stealing arbitrary task time.
+ */
+static unsigned long softirq_threaded_mask __read_mostly;
+static DEFINE_PER_CPU(unsigned long, softirq_threaded_pending);
+static DEFINE_PER_CPU(struct task_struct *, softirq_vec_thread[NR_SOFTIRQS]);
+
+/*
+ * Must run with irqs disabled.
+ */
+static void softirq_thread_raise(unsigned int nr)
+{
+	struct task_struct *tsk = __this_cpu_read(softirq_vec_thread[nr]);
+
+	__this_cpu_or(softirq_threaded_pending, 1UL << nr);
+	if (tsk && tsk->state != TASK_RUNNING)
+		wake_up_process(tsk);
+}
+
 /*
  * If ksoftirqd is scheduled, we do not want to process pending softirqs
  * right now. Let ksoftirqd handle this at its own rate, to get fairness,
@@ -449,6 +474,10 @@ void raise_softirq(unsigned int nr)
 void __raise_softirq_irqoff(unsigned int nr)
 {
 	trace_softirq_raise(nr);
+	if (unlikely(softirq_threaded_mask & (1UL << nr))) {
+		softirq_thread_raise(nr);
+		return;
+	}
 	or_softirq_pending(1UL << nr);
 }
 
@@ -608,6 +637,132 @@ static void run_ksoftirqd(unsigned int cpu)
 	local_irq_enable();
 }
 
+/* Maximum time a vector thread keeps serving re-raises before rescheduling */
+#define SOFTIRQ_THREAD_BUDGET_NS	(2 * NSEC_PER_MSEC)
+
+/*
+ * Vectors which may safely be deferred to a thread.  Timer, scheduler and
+ * RCU work stays in traditional softirq context.
+ */
+#define SOFTIRQ_THREADABLE_MASK						\
+	((1UL << NET_TX_SOFTIRQ) | (1UL << NET_RX_SOFTIRQ) |		\
+	 (1UL << BLOCK_SOFTIRQ) | (1UL << IRQ_POLL_SOFTIRQ) |		\
+	 (1UL << TASKLET_SOFTIRQ))
+
+static int __init softirq_threads_setup(char *str)
+{
+	unsigned int i;
+	char *tok;
+
+	while ((tok = strsep(&str, ","))) {
+		for (i = 0; i < NR_SOFTIRQS; i++) {
+			if (strcasecmp(tok, softirq_to_name[i]))
+				continue;
+			if (SOFTIRQ_THREADABLE_MASK & (1UL << i))
+				softirq_threaded_mask |= 1UL << i;
+			else
+				pr_warn("softirq_threads: %s cannot be threaded\n",
+					tok);
+			break;
+		}
+		if (i == NR_SOFTIRQS)
+			pr_warn("softirq_threads: unknown vector '%s'\n", tok);
+	}
+	return 1;
+}
+__setup("softirq_threads=", softirq_threads_setup);
+
+static unsigned int softirq_thread_vec(void)
+{
+	unsigned int nr;
+
+	for (nr = 0; nr < NR_SOFTIRQS; nr++) {
+		if (__this_cpu_read(softirq_vec_thread[nr]) == current)
+			break;
+	}
+
+	return nr;
+}
+
+static int softirq_thread_should_run(unsigned int cpu)
+{
+	return __this_cpu_read(softirq_threaded_pending) &
+	       (1UL << softirq_thread_vec());
+}
+
+static void run_softirq_thread(unsigned int cpu)
+{
+	unsigned int vec_nr = softirq_thread_vec();
+	struct softirq_action *h = softirq_vec + vec_nr;
+	u64 deadline = sched_clock() + SOFTIRQ_THREAD_BUDGET_NS;
+
+	if (WARN_ON_ONCE(vec_nr >= NR_SOFTIRQS))
+		return;
+
+	do {
+		local_irq_disable();
+		if (!(__this_cpu_read(softirq_threaded_pending) &
+		      (1UL << vec_nr))) {
+			local_irq_enable();
+			return;
+		}
+		__this_cpu_and(softirq_threaded_pending, ~(1UL << vec_nr));
+
+		/*
+		 * Serve the vector in proper softirq context, so that
+		 * in_serving_softirq() and lockdep see the usual picture,
+		 * but on the thread's own time slice.
+		 */
+		__local_bh_disable_ip(_RET_IP_, SOFTIRQ_OFFSET);
+		lockdep_softirq_enter();
+		local_irq_enable();
+
+		kstat_incr_softirqs_this_cpu(vec_nr);
+		trace_softirq_entry(vec_nr);
+		h->action(h);
+		trace_softirq_exit(vec_nr);
+
+		local_irq_disable();
+		lockdep_softirq_exit();
+		__local_bh_enable(SOFTIRQ_OFFSET);
+
+		/* The action may have raised non-threaded vectors */
+		if (local_softirq_pending())
+			wakeup_softirqd();
+		local_irq_enable();
+	} while (!need_resched() && sched_clock() < deadline);
+}
+
+static struct smp_hotplug_thread softirq_vec_threads[NR_SOFTIRQS];
+static char softirq_vec_comm[NR_SOFTIRQS][24];
+
+static __init int spawn_softirq_vec_threads(void)
+{
+	unsigned int nr;
+	char *p;
+
+	for (nr = 0; nr < NR_SOFTIRQS; nr++) {
+		struct smp_hotplug_thread *ht = &softirq_vec_threads[nr];
+
+		if (!(softirq_threaded_mask & (1UL << nr)))
+			continue;
+
+		snprintf(softirq_vec_comm[nr], sizeof(softirq_vec_comm[nr]),
+			 "sirq-%s/%%u", softirq_to_name[nr]);
+		for (p = softirq_vec_comm[nr]; *p; p++)
+			*p = tolower(*p);
+
+		ht->store = &softirq_vec_thread[nr];
+		ht->thread_should_run = softirq_thread_should_run;
+		ht->thread_fn = run_softirq_thread;
+		ht->thread_comm = softirq_vec_comm[nr];
+		BUG_ON(smpboot_register_percpu_thread(ht));
+	}
+
+	return 0;
+}
+early_initcall(spawn_softirq_vec_threads);
+
 #ifdef CONFIG_HOTPLUG_CPU
 /*
  * tasklet_kill_immediate is called to remove a tasklet which can already be
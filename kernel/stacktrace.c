@@ -376,3 +376,42 @@ unsigned int stack_trace_save_user(unsigned long *store, unsigned int size)
 #endif /* CONFIG_USER_STACKTRACE_SUPPORT */
 
 #endif /* !CONFIG_ARCH_STACKWALK */
+
+/**
+ * stack_trace_save_tsk_bulk - Save the stack traces of several tasks
+ * @tasks:	Array of tasks to examine
+ * @nr_tasks:	Number of tasks in @tasks
+ * @store:	Pointer to the storage array
+ * @size:	Size of the storage array
+ * @lens:	Array with at least @nr_tasks entries. Filled with the number
+ *		of trace entries stored for each task
+ * @skipnr:	Number of entries to skip at the start of each trace
+ *
+ * The traces are stored back to back in @store; the trace of tasks[i]
+ * starts at the sum of lens[0..i-1]. Unwinding a batch of tasks in one
+ * call keeps the unwinder's lookup caches hot across tasks, which is
+ * noticeably cheaper for sampling profilers than one call per task. If
+ * @store fills up, the remaining tasks get a trace length of zero.
+ *
+ * Return: Total number of trace entries stored
+ */
+unsigned int stack_trace_save_tsk_bulk(struct task_struct **tasks,
+				       unsigned int nr_tasks,
+				       unsigned long *store, unsigned int size,
+				       unsigned int *lens, unsigned int skipnr)
+{
+	unsigned int i, total = 0;
+
+	for (i = 0; i < nr_tasks; i++) {
+		lens[i] = stack_trace_save_tsk(tasks[i], store + total,
+					       size - total, skipnr);
+		total += lens[i];
+		if (total >= size) {
+			memset(lens + i + 1, 0,
+			       (nr_tasks - i - 1) * sizeof(*lens));
+			break;
+		}
+	}
+
+	return total;
+}
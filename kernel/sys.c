@@ -2486,6 +2486,27 @@ SYSCALL_DEFINE5(prctl, int, option, unsigned long, arg2, unsigned long, arg3,
 			return -EINVAL;
 		error = GET_TAGGED_ADDR_CTRL();
 		break;
+	case PR_SCHED_CORE:
+		if (arg5)
+			return -EINVAL;
+		error = sched_core_prctl((int) arg2, (pid_t) arg3,
+					 (unsigned long __user *) arg4);
+		break;
+#ifdef CONFIG_NUMA_BALANCING
+	case PR_GET_NUMA_BALANCING:
+		if (arg2 || arg3 || arg4 || arg5)
+			return -EINVAL;
+		error = !test_bit(MMF_DISABLE_NUMA_BALANCING, &me->mm->flags);
+		break;
+	case PR_SET_NUMA_BALANCING:
+		if (arg3 || arg4 || arg5)
+			return -EINVAL;
+		if (arg2)
+			clear_bit(MMF_DISABLE_NUMA_BALANCING, &me->mm->flags);
+		else
+			set_bit(MMF_DISABLE_NUMA_BALANCING, &me->mm->flags);
+		break;
+#endif
 	default:
 		error = -EINVAL;
 		break;
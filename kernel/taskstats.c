@@ -537,6 +537,67 @@ err:
 	return rc;
 }
 
+/*
+ * Dump per-task stats for every task visible in the requester's pid
+ * namespace.  One TASKSTATS_CMD_NEW message is emitted per task and
+ * cb->args[0] carries the next pid to visit between dump passes, so a
+ * monitoring agent gets all tasks in a handful of recvmsg() calls
+ * instead of one /proc/<pid>/stat read per task.
+ */
+static int taskstats_dump(struct sk_buff *skb, struct netlink_callback *cb)
+{
+	struct pid_namespace *ns = task_active_pid_ns(current);
+	struct user_namespace *user_ns = current_user_ns();
+	int pid = cb->args[0];
+	struct taskstats *stats;
+	struct task_struct *tsk;
+	struct pid *tpid;
+	void *reply;
+
+	for (;;) {
+		rcu_read_lock();
+		tpid = find_ge_pid(pid, ns);
+		if (!tpid) {
+			rcu_read_unlock();
+			break;
+		}
+		pid = pid_nr_ns(tpid, ns);
+		tsk = pid_task(tpid, PIDTYPE_PID);
+		if (tsk)
+			get_task_struct(tsk);
+		rcu_read_unlock();
+
+		if (!tsk) {
+			pid++;
+			continue;
+		}
+
+		reply = genlmsg_put(skb, NETLINK_CB(cb->skb).portid,
+				    cb->nlh->nlmsg_seq, &family, NLM_F_MULTI,
+				    TASKSTATS_CMD_NEW);
+		if (!reply) {
+			put_task_struct(tsk);
+			break;
+		}
+
+		stats = mk_reply(skb, TASKSTATS_TYPE_PID, pid);
+		if (!stats) {
+			genlmsg_cancel(skb, reply);
+			put_task_struct(tsk);
+			break;
+		}
+
+		fill_stats(user_ns, ns, tsk, stats);
+		put_task_struct(tsk);
+		genlmsg_end(skb, reply);
+		pid++;
+	}
+
+	/* Resume from here, or terminate the dump if nothing was added. */
+	cb->args[0] = pid;
+	return skb->len;
+}
+
 static int taskstats_user_cmd(struct sk_buff *skb, struct genl_info *info)
 {
 	if (info->attrs[TASKSTATS_CMD_ATTR_REGISTER_CPUMASK])
@@ -649,6 +710,7 @@ static const struct genl_ops taskstats_ops[] = {
 		.cmd		= TASKSTATS_CMD_GET,
 		.validate = GENL_DONT_VALIDATE_STRICT | GENL_DONT_VALIDATE_DUMP,
 		.doit		= taskstats_user_cmd,
+		.dumpit		= taskstats_dump,
 		/* policy enforced later */
 		.flags		= GENL_ADMIN_PERM | GENL_CMD_CAP_HASPOL,
 	},
@@ -1137,6 +1137,32 @@ void hrtimer_start_range_ns(struct hrtimer *timer, ktime_t tim,
 }
 EXPORT_SYMBOL_GPL(hrtimer_start_range_ns);
 
+/*
+ * Slack granted to each coalescing class.  The values are a compromise
+ * between coalescing nearby timers into one interrupt and not deferring
+ * expiry noticeably: NORMAL stays well below typical scheduling
+ * latencies, LOOSE is bounded by roughly a tick at HZ=1000, so even
+ * timing-sensitive users like pacing see a bounded error.
+ */
+static const u64 hrtimer_class_slack_ns[] = {
+	[HRTIMER_CLASS_TIGHT]	= 0,
+	[HRTIMER_CLASS_NORMAL]	= 100 * NSEC_PER_USEC,
+	[HRTIMER_CLASS_LOOSE]	= 1250 * NSEC_PER_USEC,
+};
+
+/**
+ * hrtimer_class_slack - expiry slack granted to a coalescing class
+ * @class:	coalescing class, see hrtimer_start_class()
+ */
+u64 hrtimer_class_slack(enum hrtimer_class class)
+{
+	if (WARN_ON_ONCE(class >= ARRAY_SIZE(hrtimer_class_slack_ns)))
+		return 0;
+
+	return hrtimer_class_slack_ns[class];
+}
+EXPORT_SYMBOL_GPL(hrtimer_class_slack);
+
 /**
  * hrtimer_try_to_cancel - try to deactivate a timer
  * @timer:	hrtimer to stop
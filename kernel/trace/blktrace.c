@@ -18,6 +18,7 @@
 #include <linux/time.h>
 #include <linux/uaccess.h>
 #include <linux/list.h>
+#include <linux/seq_file.h>
 #include <linux/blk-cgroup.h>
 
 #include "../../block/blk.h"
@@ -209,6 +210,71 @@ static const u32 ddir_act[2] = { BLK_TC_ACT(BLK_TC_READ),
 #define MASK_TC_BIT(rw, __name) ((rw & REQ_ ## __name) << \
 	  (ilog2(BLK_TC_ ## __name) + BLK_TC_SHIFT - __REQ_ ## __name))
 
+/*
+ * Per-cpu completion latency histograms, kept in addition to (or, with
+ * raw event sampling, mostly instead of) the relay stream.  Requests are
+ * bucketed by operation, log2 of the transfer size starting at one
+ * sector, and log2 of the completion latency in microseconds.
+ */
+enum {
+	BLK_AGG_READ,
+	BLK_AGG_WRITE,
+	BLK_AGG_DISCARD,
+	BLK_AGG_FLUSH,
+	BLK_AGG_NR_OPS,
+};
+
+#define BLK_AGG_SIZE_BUCKETS	13	/* 512B .. >= 2M */
+#define BLK_AGG_LAT_BUCKETS	26	/* < 1us .. >= 16s */
+
+struct blk_trace_agg {
+	unsigned long raw_seen;		/* raw events seen, for sampling */
+	u64 hist[BLK_AGG_NR_OPS][BLK_AGG_SIZE_BUCKETS][BLK_AGG_LAT_BUCKETS];
+};
+
+static void blk_trace_agg_complete(struct blk_trace *bt, struct request *rq,
+				   unsigned int nr_bytes)
+{
+	u64 now = ktime_get_ns(), start;
+	int op, sbkt, lbkt;
+
+	if (bt->trace_state != Blktrace_running)
+		return;
+
+	switch (req_op(rq)) {
+	case REQ_OP_READ:
+		op = BLK_AGG_READ;
+		break;
+	case REQ_OP_WRITE:
+	case REQ_OP_WRITE_SAME:
+	case REQ_OP_WRITE_ZEROES:
+		op = BLK_AGG_WRITE;
+		break;
+	case REQ_OP_DISCARD:
+	case REQ_OP_SECURE_ERASE:
+		op = BLK_AGG_DISCARD;
+		break;
+	case REQ_OP_FLUSH:
+		op = BLK_AGG_FLUSH;
+		break;
+	default:
+		return;
+	}
+
+	/*
+	 * Prefer device time (D2C) when the queue collects it, and fall
+	 * back to the time since request allocation (Q2C) otherwise.
+	 */
+	start = rq->io_start_time_ns ? : rq->start_time_ns;
+	if (!start || now < start)
+		return;
+
+	sbkt = min(ilog2((nr_bytes >> 9) | 1), BLK_AGG_SIZE_BUCKETS - 1);
+	lbkt = min(fls64((now - start) >> 10), BLK_AGG_LAT_BUCKETS - 1);
+
+	this_cpu_inc(bt->agg->hist[op][sbkt][lbkt]);
+}
+
 /*
  * The worker for the various blk_add_trace*() types. Fills out a
  * blk_io_trace structure and places it in a per-cpu subbuffer.
@@ -247,6 +313,17 @@ static void __blk_add_trace(struct blk_trace *bt, sector_t sector, int bytes,
 	pid = tsk->pid;
 	if (act_log_check(bt, what, sector, pid))
 		return;
+
+	/*
+	 * Optionally emit only one in every sample_rate raw events; the
+	 * latency histograms still account every completion.
+	 */
+	if (bt->agg) {
+		unsigned int rate = READ_ONCE(bt->sample_rate);
+
+		if (rate > 1 && (this_cpu_inc_return(bt->agg->raw_seen) % rate))
+			return;
+	}
 	cpu = raw_smp_processor_id();
 
 	if (blk_tracer) {
@@ -312,12 +389,15 @@ record_it:
 
 static void blk_trace_free(struct blk_trace *bt)
 {
+	debugfs_remove(bt->sample_file);
+	debugfs_remove(bt->hist_file);
 	debugfs_remove(bt->msg_file);
 	debugfs_remove(bt->dropped_file);
 	relay_close(bt->rchan);
 	debugfs_remove(bt->dir);
 	free_percpu(bt->sequence);
 	free_percpu(bt->msg_data);
+	free_percpu(bt->agg);
 	kfree(bt);
 }
 
@@ -415,6 +495,99 @@ static const struct file_operations blk_msg_fops = {
 	.llseek =	noop_llseek,
 };
 
+static int blk_latency_hist_show(struct seq_file *m, void *v)
+{
+	static const char op_names[BLK_AGG_NR_OPS] = { 'R', 'W', 'D', 'F' };
+	struct blk_trace *bt = m->private;
+	int cpu, op, sbkt, lbkt;
+	u64 count;
+
+	seq_puts(m, "# op size_bytes lat_us_hi count\n");
+	for (op = 0; op < BLK_AGG_NR_OPS; op++) {
+		for (sbkt = 0; sbkt < BLK_AGG_SIZE_BUCKETS; sbkt++) {
+			for (lbkt = 0; lbkt < BLK_AGG_LAT_BUCKETS; lbkt++) {
+				count = 0;
+				for_each_possible_cpu(cpu)
+					count += per_cpu_ptr(bt->agg,
+						cpu)->hist[op][sbkt][lbkt];
+				if (!count)
+					continue;
+				seq_printf(m, "%c %u %llu %llu\n",
+					   op_names[op], 512U << sbkt,
+					   1ULL << lbkt, count);
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int blk_latency_hist_open(struct inode *inode, struct file *filp)
+{
+	return single_open(filp, blk_latency_hist_show, inode->i_private);
+}
+
+static ssize_t blk_latency_hist_write(struct file *filp,
+				      const char __user *buffer,
+				      size_t count, loff_t *ppos)
+{
+	struct seq_file *m = filp->private_data;
+	struct blk_trace *bt = m->private;
+	int cpu;
+
+	/* any write resets the histograms */
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(bt->agg, cpu)->hist, 0,
+		       sizeof(per_cpu_ptr(bt->agg, cpu)->hist));
+
+	return count;
+}
+
+static const struct file_operations blk_latency_hist_fops = {
+	.owner =	THIS_MODULE,
+	.open =		blk_latency_hist_open,
+	.read =		seq_read,
+	.write =	blk_latency_hist_write,
+	.llseek =	seq_lseek,
+	.release =	single_release,
+};
+
+static ssize_t blk_sample_rate_read(struct file *filp, char __user *buffer,
+				    size_t count, loff_t *ppos)
+{
+	struct blk_trace *bt = filp->private_data;
+	char buf[16];
+
+	snprintf(buf, sizeof(buf), "%u\n", READ_ONCE(bt->sample_rate));
+
+	return simple_read_from_buffer(buffer, count, ppos, buf, strlen(buf));
+}
+
+static ssize_t blk_sample_rate_write(struct file *filp,
+				     const char __user *buffer,
+				     size_t count, loff_t *ppos)
+{
+	struct blk_trace *bt = filp->private_data;
+	unsigned int rate;
+	int ret;
+
+	ret = kstrtouint_from_user(buffer, count, 0, &rate);
+	if (ret)
+		return ret;
+
+	WRITE_ONCE(bt->sample_rate, rate);
+
+	return count;
+}
+
+static const struct file_operations blk_sample_rate_fops = {
+	.owner =	THIS_MODULE,
+	.open =		simple_open,
+	.read =		blk_sample_rate_read,
+	.write =	blk_sample_rate_write,
+	.llseek =	default_llseek,
+};
+
 /*
  * Keep track of how many times we encountered a full subbuffer, to aid
  * the user space app in telling how many lost events there were.
@@ -521,6 +694,11 @@ static int do_blk_trace_setup(struct request_queue *q, char *name, dev_t dev,
 	if (!bt->msg_data)
 		goto err;
 
+	bt->agg = alloc_percpu(struct blk_trace_agg);
+	if (!bt->agg)
+		goto err;
+	bt->sample_rate = 1;
+
 	ret = -ENOENT;
 
 	dir = debugfs_lookup(buts->name, blk_debugfs_root);
@@ -537,6 +715,12 @@ static int do_blk_trace_setup(struct request_queue *q, char *name, dev_t dev,
 
 	bt->msg_file = debugfs_create_file("msg", 0222, dir, bt, &blk_msg_fops);
 
+	bt->hist_file = debugfs_create_file("latency_hist", 0644, dir, bt,
+					    &blk_latency_hist_fops);
+
+	bt->sample_file = debugfs_create_file("sample_rate", 0644, dir, bt,
+					      &blk_sample_rate_fops);
+
 	bt->rchan = relay_open("trace", dir, buts->buf_size,
 				buts->buf_nr, &blk_relay_callbacks, bt);
 	if (!bt->rchan)
@@ -827,6 +1011,9 @@ static void blk_add_trace_rq(struct request *rq, int error,
 		return;
 	}
 
+	if (what == BLK_TA_COMPLETE && bt->agg)
+		blk_trace_agg_complete(bt, rq, nr_bytes);
+
 	if (blk_rq_is_passthrough(rq))
 		what |= BLK_TC_ACT(BLK_TC_PC);
 	else
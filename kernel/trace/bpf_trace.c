@@ -1104,6 +1104,39 @@ const struct bpf_verifier_ops raw_tracepoint_writable_verifier_ops = {
 const struct bpf_prog_ops raw_tracepoint_writable_prog_ops = {
 };
 
+static const struct bpf_func_proto *
+iter_prog_func_proto(enum bpf_func_id func_id, const struct bpf_prog *prog)
+{
+	switch (func_id) {
+	case BPF_FUNC_seq_write:
+		return &bpf_seq_write_proto;
+	default:
+		return tracing_func_proto(func_id, prog);
+	}
+}
+
+static bool iter_prog_is_valid_access(int off, int size,
+				      enum bpf_access_type type,
+				      const struct bpf_prog *prog,
+				      struct bpf_insn_access_aux *info)
+{
+	if (off < 0 || off >= sizeof(struct bpf_iter_ctx))
+		return false;
+	if (type != BPF_READ)
+		return false;
+	if (off % size != 0)
+		return false;
+	return size == sizeof(__u64);
+}
+
+const struct bpf_verifier_ops iter_verifier_ops = {
+	.get_func_proto  = iter_prog_func_proto,
+	.is_valid_access = iter_prog_is_valid_access,
+};
+
+const struct bpf_prog_ops iter_prog_ops = {
+};
+
 static bool pe_prog_is_valid_access(int off, int size, enum bpf_access_type type,
 				    const struct bpf_prog *prog,
 				    struct bpf_insn_access_aux *info)
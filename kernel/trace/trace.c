@@ -1319,6 +1319,7 @@ static int __init set_tracing_thresh(char *str)
 	if (ret < 0)
 		return 0;
 	tracing_thresh = threshold * 1000;
+	global_trace.tracing_thresh = tracing_thresh;
 	return 1;
 }
 __setup("tracing_thresh=", set_tracing_thresh);
@@ -5807,7 +5808,9 @@ static ssize_t
 tracing_thresh_read(struct file *filp, char __user *ubuf,
 		    size_t cnt, loff_t *ppos)
 {
-	return tracing_nsecs_read(&tracing_thresh, ubuf, cnt, ppos);
+	struct trace_array *tr = filp->private_data;
+
+	return tracing_nsecs_read(&tr->tracing_thresh, ubuf, cnt, ppos);
 }
 
 static ssize_t
@@ -5818,10 +5821,14 @@ tracing_thresh_write(struct file *filp, const char __user *ubuf,
 	int ret;
 
 	mutex_lock(&trace_types_lock);
-	ret = tracing_nsecs_write(&tracing_thresh, ubuf, cnt, ppos);
+	ret = tracing_nsecs_write(&tr->tracing_thresh, ubuf, cnt, ppos);
 	if (ret < 0)
 		goto out;
 
+	/* the function profiler's threshold follows the top level instance */
+	if (tr == &global_trace)
+		tracing_thresh = tr->tracing_thresh;
+
 	if (tr->current_trace->update_thresh) {
 		ret = tr->current_trace->update_thresh(tr);
 		if (ret < 0)
@@ -8582,6 +8589,9 @@ init_tracer_tracefs(struct trace_array *tr, struct dentry *d_tracer)
 	trace_create_file("buffer_total_size_kb", 0444, d_tracer,
 			  tr, &tracing_total_entries_fops);
 
+	trace_create_file("tracing_thresh", 0644, d_tracer,
+			  tr, &tracing_thresh_fops);
+
 	trace_create_file("free_buffer", 0200, d_tracer,
 			  tr, &tracing_free_buffer_fops);
 
@@ -8791,9 +8801,6 @@ static __init int tracer_init_tracefs(void)
 	init_tracer_tracefs(&global_trace, d_tracer);
 	ftrace_init_tracefs_toplevel(&global_trace, d_tracer);
 
-	trace_create_file("tracing_thresh", 0644, d_tracer,
-			&global_trace, &tracing_thresh_fops);
-
 	trace_create_file("README", 0444, d_tracer,
 			NULL, &tracing_readme_fops);
 
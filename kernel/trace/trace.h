@@ -265,6 +265,12 @@ struct trace_array {
 #if defined(CONFIG_TRACER_MAX_TRACE) || defined(CONFIG_HWLAT_TRACER)
 	unsigned long		max_latency;
 #endif
+	/*
+	 * Per-instance duration threshold for tracers that support it
+	 * (function_graph); mirrored into the global tracing_thresh for
+	 * the top level instance.
+	 */
+	unsigned long		tracing_thresh;
 	struct trace_pid_list	__rcu *filtered_pids;
 	/*
 	 * max_lock is used to protect the swapping of buffers
@@ -12,6 +12,7 @@
 #include <linux/slab.h>
 #include <linux/stacktrace.h>
 #include <linux/rculist.h>
+#include <linux/sort.h>
 #include <linux/tracefs.h>
 
 /* for gfp flag names */
@@ -5536,6 +5537,94 @@ static void hist_trigger_entry_print(struct seq_file *m,
 	seq_puts(m, "\n");
 }
 
+struct hist_percentile_bucket {
+	u64 log2_val;
+	u64 hitcount;
+};
+
+static int cmp_percentile_bucket(const void *a, const void *b)
+{
+	const struct hist_percentile_bucket *bucket_a = a;
+	const struct hist_percentile_bucket *bucket_b = b;
+
+	if (bucket_a->log2_val > bucket_b->log2_val)
+		return 1;
+	if (bucket_a->log2_val < bucket_b->log2_val)
+		return -1;
+	return 0;
+}
+
+/*
+ * Estimate the value below which @pct percent of the hits fall.  The key
+ * is a .log2 bucket holding values in (2^(b-1), 2^b], so interpolate
+ * linearly inside the bucket that crosses the threshold.  @buckets must
+ * be sorted by ascending bucket.
+ */
+static u64 hist_percentile(struct hist_percentile_bucket *buckets,
+			   unsigned int n_buckets, u64 total, unsigned int pct)
+{
+	u64 thresh = div_u64(total * pct + 99, 100);
+	u64 cum = 0, low, width, b;
+	unsigned int i;
+
+	for (i = 0; i < n_buckets; i++) {
+		if (cum + buckets[i].hitcount < thresh) {
+			cum += buckets[i].hitcount;
+			continue;
+		}
+		b = buckets[i].log2_val;
+		low = b ? 1ULL << (b - 1) : 0;
+		width = (1ULL << b) - low;
+		return low + div64_u64(width * (thresh - cum),
+				       buckets[i].hitcount);
+	}
+
+	return 0;
+}
+
+/*
+ * For a histogram with a single .log2 key, publish estimated p50/p95/p99
+ * of the keyed quantity.  Computed entirely at read time from the bucket
+ * hitcounts, so it adds nothing to the event fast path.
+ */
+static void hist_percentiles_print(struct seq_file *m,
+				   struct hist_trigger_data *hist_data,
+				   struct tracing_map_sort_entry **sort_entries,
+				   unsigned int n_entries)
+{
+	struct hist_field *key_field = hist_data->fields[hist_data->n_vals];
+	struct hist_percentile_bucket *buckets;
+	u64 total = 0;
+	unsigned int i;
+
+	if (hist_data->n_keys != 1 ||
+	    !(key_field->flags & HIST_FIELD_FL_LOG2) || !n_entries)
+		return;
+
+	buckets = kcalloc(n_entries, sizeof(*buckets), GFP_KERNEL);
+	if (!buckets)
+		return;
+
+	for (i = 0; i < n_entries; i++) {
+		buckets[i].log2_val = *(u64 *)(sort_entries[i]->key +
+					       key_field->offset);
+		buckets[i].hitcount = tracing_map_read_sum(sort_entries[i]->elt,
+							   HITCOUNT_IDX);
+		total += buckets[i].hitcount;
+	}
+
+	sort(buckets, n_entries, sizeof(*buckets), cmp_percentile_bucket, NULL);
+
+	if (total)
+		seq_printf(m, "\nPercentiles (%s):\n    p50: ~ %10llu    p95: ~ %10llu    p99: ~ %10llu\n",
+			   hist_field_name(key_field, 0),
+			   hist_percentile(buckets, n_entries, total, 50),
+			   hist_percentile(buckets, n_entries, total, 95),
+			   hist_percentile(buckets, n_entries, total, 99));
+
+	kfree(buckets);
+}
+
 static int print_entries(struct seq_file *m,
 			 struct hist_trigger_data *hist_data)
 {
@@ -5554,6 +5643,8 @@ static int print_entries(struct seq_file *m,
 					 sort_entries[i]->key,
 					 sort_entries[i]->elt);
 
+	hist_percentiles_print(m, hist_data, sort_entries, n_entries);
+
 	tracing_map_destroy_sort_entries(sort_entries, n_entries);
 
 	return n_entries;
@@ -163,10 +163,10 @@ int trace_graph_entry(struct ftrace_graph_ent *trace)
 		return 0;
 
 	/*
-	 * Stop here if tracing_threshold is set. We only write function return
-	 * events to the ring buffer.
+	 * Stop here if a duration threshold is set. We only write function
+	 * return events to the ring buffer.
 	 */
-	if (tracing_thresh)
+	if (tr->tracing_thresh)
 		return 1;
 
 	local_irq_save(flags);
@@ -273,6 +273,8 @@ void set_graph_array(struct trace_array *tr)
 
 static void trace_graph_thresh_return(struct ftrace_graph_ret *trace)
 {
+	struct trace_array *tr = graph_array;
+
 	ftrace_graph_addr_finish(trace);
 
 	if (trace_recursion_test(TRACE_GRAPH_NOTRACE_BIT)) {
@@ -280,8 +282,8 @@ static void trace_graph_thresh_return(struct ftrace_graph_ret *trace)
 		return;
 	}
 
-	if (tracing_thresh &&
-	    (trace->rettime - trace->calltime < tracing_thresh))
+	if (tr->tracing_thresh &&
+	    (trace->rettime - trace->calltime < tr->tracing_thresh))
 		return;
 	else
 		trace_graph_return(trace);
@@ -302,7 +304,7 @@ static int graph_trace_init(struct trace_array *tr)
 	int ret;
 
 	set_graph_array(tr);
-	if (tracing_thresh)
+	if (tr->tracing_thresh)
 		ret = register_ftrace_graph(&funcgraph_thresh_ops);
 	else
 		ret = register_ftrace_graph(&funcgraph_ops);
@@ -316,7 +318,7 @@ static int graph_trace_init(struct trace_array *tr)
 static void graph_trace_reset(struct trace_array *tr)
 {
 	tracing_stop_cmdline_record();
-	if (tracing_thresh)
+	if (tr->tracing_thresh)
 		unregister_ftrace_graph(&funcgraph_thresh_ops);
 	else
 		unregister_ftrace_graph(&funcgraph_ops);
@@ -1291,6 +1293,7 @@ static struct tracer graph_trace __tracer_data = {
 	.print_header	= print_graph_headers,
 	.flags		= &tracer_flags,
 	.set_flag	= func_graph_set_flag,
+	.allow_instances = true,
 #ifdef CONFIG_FTRACE_SELFTEST
 	.selftest	= trace_selftest_startup_function_graph,
 #endif
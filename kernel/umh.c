@@ -26,6 +26,7 @@
 #include <linux/ptrace.h>
 #include <linux/async.h>
 #include <linux/uaccess.h>
+#include <linux/initrd.h>
 #include <linux/shmem_fs.h>
 #include <linux/pipe_fs_i.h>
 
@@ -100,6 +101,8 @@ static int call_usermodehelper_exec_async(void *data)
 		}
 	}
 
+	wait_for_initramfs();
+
 	commit_creds(new);
 
 	sub_info->pid = task_pid_nr(current);
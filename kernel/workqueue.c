@@ -49,6 +49,7 @@
 #include <linux/moduleparam.h>
 #include <linux/uaccess.h>
 #include <linux/sched/isolation.h>
+#include <linux/topology.h>
 #include <linux/nmi.h>
 
 #include "workqueue_internal.h"
@@ -1392,6 +1393,65 @@ static int wq_select_unbound_cpu(int cpu)
 	return new_cpu;
 }
 
+/*
+ * Unlocked peek at whether queueing to @pwq's per-cpu pool would have to
+ * wait behind other work.  This is a placement heuristic, not a guarantee;
+ * a stale answer just costs one work item its locality.
+ */
+static bool wq_cpu_pwq_busy(struct pool_workqueue *pwq)
+{
+	return pwq->nr_active >= pwq->max_active ||
+	       !list_empty(&pwq->pool->worklist);
+}
+
+/*
+ * For unbound wqs with an affinity scope narrower than NUMA, try to place
+ * the work item on a per-cpu pool inside the queueing CPU's scope domain,
+ * preferring the queueing CPU itself.  Returns NULL if every CPU in the
+ * domain is busy (or excluded by wq_unbound_cpumask), in which case the
+ * caller falls back to the regular NUMA node pwq.
+ */
+static struct pool_workqueue *wq_select_local_pwq(struct workqueue_struct *wq,
+						  int cpu)
+{
+	int scope = READ_ONCE(wq->unbound_attrs->affn_scope);
+	const struct cpumask *scope_mask;
+	struct pool_workqueue *pwq;
+	int tcpu;
+
+	if (likely(scope == WQ_AFFN_NUMA) || !wq->cpu_pwqs)
+		return NULL;
+
+	switch (scope) {
+	case WQ_AFFN_CPU:
+		scope_mask = cpumask_of(cpu);
+		break;
+	case WQ_AFFN_SMT:
+		scope_mask = topology_sibling_cpumask(cpu);
+		break;
+	default:
+		/* closest thing to an LLC mask available in generic code */
+		scope_mask = topology_core_cpumask(cpu);
+		break;
+	}
+
+	if (cpumask_test_cpu(cpu, wq_unbound_cpumask)) {
+		pwq = per_cpu_ptr(wq->cpu_pwqs, cpu);
+		if (!wq_cpu_pwq_busy(pwq))
+			return pwq;
+	}
+
+	for_each_cpu_and(tcpu, scope_mask, wq_unbound_cpumask) {
+		if (tcpu == cpu || !cpu_online(tcpu))
+			continue;
+		pwq = per_cpu_ptr(wq->cpu_pwqs, tcpu);
+		if (!wq_cpu_pwq_busy(pwq))
+			return pwq;
+	}
+
+	return NULL;
+}
+
 static void __queue_work(int cpu, struct workqueue_struct *wq,
 			 struct work_struct *work)
 {
@@ -1421,7 +1481,9 @@ retry:
 	if (wq->flags & WQ_UNBOUND) {
 		if (req_cpu == WORK_CPU_UNBOUND)
 			cpu = wq_select_unbound_cpu(raw_smp_processor_id());
-		pwq = unbound_pwq_by_node(wq, cpu_to_node(cpu));
+		pwq = wq_select_local_pwq(wq, cpu);
+		if (!pwq)
+			pwq = unbound_pwq_by_node(wq, cpu_to_node(cpu));
 	} else {
 		if (req_cpu == WORK_CPU_UNBOUND)
 			cpu = raw_smp_processor_id();
@@ -3380,8 +3442,10 @@ static void copy_workqueue_attrs(struct workqueue_attrs *to,
 	 * Unlike hash and equality test, this function doesn't ignore
 	 * ->no_numa as it is used for both pool and wq attrs.  Instead,
 	 * get_unbound_pool() explicitly clears ->no_numa after copying.
+	 * The same applies to ->affn_scope.
 	 */
 	to->no_numa = from->no_numa;
+	to->affn_scope = from->affn_scope;
 }
 
 /* hash value of the content of @attr */
@@ -3490,9 +3554,8 @@ static void rcu_free_wq(struct rcu_head *rcu)
 
 	wq_free_lockdep(wq);
 
-	if (!(wq->flags & WQ_UNBOUND))
-		free_percpu(wq->cpu_pwqs);
-	else
+	free_percpu(wq->cpu_pwqs);
+	if (wq->flags & WQ_UNBOUND)
 		free_workqueue_attrs(wq->unbound_attrs);
 
 	kfree(wq->rescuer);
@@ -3622,10 +3685,11 @@ static struct worker_pool *get_unbound_pool(const struct workqueue_attrs *attrs)
 	pool->node = target_node;
 
 	/*
-	 * no_numa isn't a worker_pool attribute, always clear it.  See
-	 * 'struct workqueue_attrs' comments for detail.
+	 * no_numa and affn_scope aren't worker_pool attributes, always clear
+	 * them.  See 'struct workqueue_attrs' comments for detail.
 	 */
 	pool->attrs->no_numa = false;
+	pool->attrs->affn_scope = WQ_AFFN_NUMA;
 
 	if (worker_pool_assign_id(pool) < 0)
 		goto fail;
@@ -4175,6 +4239,30 @@ static int alloc_and_link_pwqs(struct workqueue_struct *wq)
 			      wq->pwqs.prev != &wq->dfl_pwq->pwqs_node),
 		     "ordering guarantee broken for workqueue %s\n", wq->name);
 	} else {
+		/*
+		 * Per-cpu pwqs back the sub-NUMA affinity scopes.  They sit
+		 * idle until ->affn_scope is narrowed, see
+		 * wq_select_local_pwq().
+		 */
+		wq->cpu_pwqs = alloc_percpu(struct pool_workqueue);
+		if (!wq->cpu_pwqs) {
+			put_online_cpus();
+			return -ENOMEM;
+		}
+
+		for_each_possible_cpu(cpu) {
+			struct pool_workqueue *pwq =
+				per_cpu_ptr(wq->cpu_pwqs, cpu);
+			struct worker_pool *cpu_pools =
+				per_cpu(cpu_worker_pools, cpu);
+
+			init_pwq(pwq, wq, &cpu_pools[highpri]);
+
+			mutex_lock(&wq->mutex);
+			link_pwq(pwq);
+			mutex_unlock(&wq->mutex);
+		}
+
 		ret = apply_workqueue_attrs(wq, unbound_std_wq_attrs[highpri]);
 	}
 	put_online_cpus();
@@ -4396,6 +4484,22 @@ void destroy_workqueue(struct workqueue_struct *wq)
 		 */
 		call_rcu(&wq->rcu, rcu_free_wq);
 	} else {
+		int cpu;
+
+		/*
+		 * Unlink the per-cpu pwqs backing the affinity scopes so
+		 * that the release of the last unbound pwq sees an empty
+		 * pwq list and frees @wq.  Their base refs are never
+		 * dropped; they go away together with @wq.
+		 */
+		if (wq->cpu_pwqs) {
+			mutex_lock(&wq->mutex);
+			for_each_possible_cpu(cpu)
+				list_del_rcu(&per_cpu_ptr(wq->cpu_pwqs,
+							  cpu)->pwqs_node);
+			mutex_unlock(&wq->mutex);
+		}
+
 		/*
 		 * We're the sole accessor of @wq at this point.  Directly
 		 * access numa_pwq_tbl[] and dfl_pwq to put the base refs.
@@ -5536,11 +5640,63 @@ out_unlock:
 	return ret ?: count;
 }
 
+static const char *wq_affn_names[WQ_AFFN_NR_TYPES] = {
+	[WQ_AFFN_NUMA]		= "numa",
+	[WQ_AFFN_CACHE]		= "cache",
+	[WQ_AFFN_SMT]		= "smt",
+	[WQ_AFFN_CPU]		= "cpu",
+};
+
+static ssize_t wq_affinity_scope_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	int written;
+
+	mutex_lock(&wq->mutex);
+	written = scnprintf(buf, PAGE_SIZE, "%s\n",
+			    wq_affn_names[wq->unbound_attrs->affn_scope]);
+	mutex_unlock(&wq->mutex);
+
+	return written;
+}
+
+static ssize_t wq_affinity_scope_store(struct device *dev,
+				       struct device_attribute *attr,
+				       const char *buf, size_t count)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	struct workqueue_attrs *attrs;
+	int affn, ret = -ENOMEM;
+
+	for (affn = 0; affn < WQ_AFFN_NR_TYPES; affn++)
+		if (sysfs_streq(buf, wq_affn_names[affn]))
+			break;
+	if (affn == WQ_AFFN_NR_TYPES)
+		return -EINVAL;
+
+	apply_wqattrs_lock();
+
+	attrs = wq_sysfs_prep_attrs(wq);
+	if (!attrs)
+		goto out_unlock;
+
+	attrs->affn_scope = affn;
+	ret = apply_workqueue_attrs_locked(wq, attrs);
+
+out_unlock:
+	apply_wqattrs_unlock();
+	free_workqueue_attrs(attrs);
+	return ret ?: count;
+}
+
 static struct device_attribute wq_sysfs_unbound_attrs[] = {
 	__ATTR(pool_ids, 0444, wq_pool_ids_show, NULL),
 	__ATTR(nice, 0644, wq_nice_show, wq_nice_store),
 	__ATTR(cpumask, 0644, wq_cpumask_show, wq_cpumask_store),
 	__ATTR(numa, 0644, wq_numa_show, wq_numa_store),
+	__ATTR(affinity_scope, 0644, wq_affinity_scope_show,
+	       wq_affinity_scope_store),
 	__ATTR_NULL,
 };
 
@@ -28,11 +28,21 @@
 /* Revised by Kenneth Albanowski for m68knommu. Basic problem: unaligned access
  kills, so most of the assembly has to go. */
 
+#include <linux/bitops.h>
 #include <linux/export.h>
 #include <net/checksum.h>
 
 #include <asm/byteorder.h>
 
+static inline u32 from64to32(u64 x)
+{
+	/* add up 32-bit and 32-bit for 32+c bit */
+	x = (x & 0xffffffff) + (x >> 32);
+	/* add up carry.. */
+	x = (x & 0xffffffff) + (x >> 32);
+	return (u32)x;
+}
+
 #ifndef do_csum
 static inline unsigned short from32to16(unsigned int x)
 {
@@ -66,6 +76,36 @@ static unsigned int do_csum(const unsigned char *buff, int len)
 			len -= 2;
 			buff += 2;
 		}
+#if BITS_PER_LONG == 64
+		if (len >= 4) {
+			u64 sum = result;
+
+			if (4 & (unsigned long) buff) {
+				sum += *(unsigned int *) buff;
+				len -= 4;
+				buff += 4;
+			}
+			if (len >= 8) {
+				const unsigned char *end = buff + ((unsigned)len & ~7);
+				u64 carry = 0;
+				do {
+					u64 w = *(u64 *) buff;
+					buff += 8;
+					sum += carry;
+					sum += w;
+					carry = (w > sum);
+				} while (buff < end);
+				sum += carry;
+				sum = (sum & 0xffffffff) + (sum >> 32);
+			}
+			if (len & 4) {
+				sum += *(unsigned int *) buff;
+				buff += 4;
+			}
+			result = from64to32(sum);
+			result = (result & 0xffff) + (result >> 16);
+		}
+#else
 		if (len >= 4) {
 			const unsigned char *end = buff + ((unsigned)len & ~3);
 			unsigned int carry = 0;
@@ -79,6 +119,7 @@ static unsigned int do_csum(const unsigned char *buff, int len)
 			result += carry;
 			result = (result & 0xffff) + (result >> 16);
 		}
+#endif
 		if (len & 2) {
 			result += *(unsigned short *) buff;
 			buff += 2;
@@ -177,15 +218,6 @@ csum_partial_copy(const void *src, void *dst, int len, __wsum sum)
 EXPORT_SYMBOL(csum_partial_copy);
 
 #ifndef csum_tcpudp_nofold
-static inline u32 from64to32(u64 x)
-{
-	/* add up 32-bit and 32-bit for 32+c bit */
-	x = (x & 0xffffffff) + (x >> 32);
-	/* add up carry.. */
-	x = (x & 0xffffffff) + (x >> 32);
-	return (u32)x;
-}
-
 __wsum csum_tcpudp_nofold(__be32 saddr, __be32 daddr,
 			  __u32 len, __u8 proto, __wsum sum)
 {
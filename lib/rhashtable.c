@@ -378,7 +378,7 @@ static int rhashtable_rehash_alloc(struct rhashtable *ht,
 static int rhashtable_shrink(struct rhashtable *ht)
 {
 	struct bucket_table *old_tbl = rht_dereference(ht->tbl, ht);
-	unsigned int nelems = atomic_read(&ht->nelems);
+	unsigned int nelems = percpu_counter_sum_positive(&ht->nelems);
 	unsigned int size = 0;
 
 	if (nelems)
@@ -570,7 +570,7 @@ static struct bucket_table *rhashtable_insert_one(struct rhashtable *ht,
 	 */
 	rht_assign_locked(bkt, obj);
 
-	atomic_inc(&ht->nelems);
+	percpu_counter_inc(&ht->nelems);
 	if (rht_grow_above_75(ht, tbl))
 		schedule_work(&ht->run_work);
 
@@ -1037,6 +1037,9 @@ int rhashtable_init(struct rhashtable *ht,
 	size = rounded_hashtable_size(&ht->p);
 
 	ht->key_len = ht->p.key_len;
+	if (percpu_counter_init(&ht->nelems, 0, GFP_KERNEL))
+		return -ENOMEM;
+
 	if (!params->hashfn) {
 		ht->p.hashfn = jhash;
 
@@ -1057,8 +1060,6 @@ int rhashtable_init(struct rhashtable *ht,
 		tbl = bucket_table_alloc(ht, size, GFP_KERNEL | __GFP_NOFAIL);
 	}
 
-	atomic_set(&ht->nelems, 0);
-
 	RCU_INIT_POINTER(ht->tbl, tbl);
 
 	INIT_WORK(&ht->run_work, rht_deferred_worker);
@@ -1155,6 +1156,7 @@ restart:
 		goto restart;
 	}
 	mutex_unlock(&ht->mutex);
+	percpu_counter_destroy(&ht->nelems);
 }
 EXPORT_SYMBOL_GPL(rhashtable_free_and_destroy);
 
@@ -522,11 +522,27 @@ EXPORT_SYMBOL(strim);
  */
 size_t strlen(const char *s)
 {
-	const char *sc;
+	const struct word_at_a_time constants = WORD_AT_A_TIME_CONSTANTS;
+	const char *sc = s;
+	unsigned long c, data;
 
-	for (sc = s; *sc != '\0'; ++sc)
-		/* nothing */;
-	return sc - s;
+	/*
+	 * Scan byte-wise up to the first word boundary; from there on,
+	 * aligned word reads cannot cross a page boundary, so whole
+	 * words can be examined at a time.
+	 */
+	for (; (unsigned long)sc & (sizeof(unsigned long) - 1); sc++)
+		if (!*sc)
+			return sc - s;
+
+	for (;;) {
+		c = read_word_at_a_time(sc);
+		if (has_zero(c, &data, &constants)) {
+			data = prep_zero_mask(c, data, &constants);
+			return sc - s + find_zero(create_zero_mask(data));
+		}
+		sc += sizeof(unsigned long);
+	}
 }
 EXPORT_SYMBOL(strlen);
 #endif
@@ -997,10 +1013,39 @@ EXPORT_SYMBOL(strnstr);
 void *memchr(const void *s, int c, size_t n)
 {
 	const unsigned char *p = s;
-	while (n-- != 0) {
-        	if ((unsigned char)c == *p++) {
-			return (void *)(p - 1);
-		}
+
+	/* Scan byte-wise until the pointer is word aligned. */
+	while (n && ((unsigned long)p & (sizeof(unsigned long) - 1))) {
+		if (*p == (unsigned char)c)
+			return (void *)p;
+		p++;
+		n--;
+	}
+
+	if (n >= sizeof(unsigned long)) {
+		const struct word_at_a_time constants = WORD_AT_A_TIME_CONSTANTS;
+		unsigned long mask = REPEAT_BYTE((unsigned char)c);
+		unsigned long v, data;
+
+		/*
+		 * XORing with the repeated byte turns matches into zero
+		 * bytes, which the word-at-a-time machinery can spot.
+		 */
+		do {
+			v = *(const unsigned long *)p ^ mask;
+			if (has_zero(v, &data, &constants)) {
+				data = prep_zero_mask(v, data, &constants);
+				return (void *)(p + find_zero(create_zero_mask(data)));
+			}
+			p += sizeof(unsigned long);
+			n -= sizeof(unsigned long);
+		} while (n >= sizeof(unsigned long));
+	}
+
+	while (n--) {
+		if (*p == (unsigned char)c)
+			return (void *)p;
+		p++;
 	}
 	return NULL;
 }
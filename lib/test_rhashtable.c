@@ -198,10 +198,10 @@ static void test_bucket_stats(struct rhashtable *ht, unsigned int entries)
 	rhashtable_walk_stop(&hti);
 	rhashtable_walk_exit(&hti);
 
-	pr_info("  Traversal complete: counted=%u, nelems=%u, entries=%d, table-jumps=%u\n",
-		total, atomic_read(&ht->nelems), entries, chain_len);
+	pr_info("  Traversal complete: counted=%u, nelems=%lld, entries=%d, table-jumps=%u\n",
+		total, percpu_counter_sum(&ht->nelems), entries, chain_len);
 
-	if (total != atomic_read(&ht->nelems) || total != entries)
+	if (total != percpu_counter_sum(&ht->nelems) || total != entries)
 		pr_warn("Test failed: Total count mismatch ^^^");
 }
 
@@ -179,6 +179,66 @@ static __init int strnchr_selftest(void)
 	return 0;
 }
 
+static __init int strlen_selftest(void)
+{
+	char *buf;
+	unsigned int i, j;
+
+	buf = kmalloc(64, GFP_KERNEL);
+	if (!buf)
+		return -1;
+
+	/* Exercise every start alignment and length around word edges. */
+	for (i = 0; i < sizeof(long); i++) {
+		for (j = 0; j < 48; j++) {
+			memset(buf, 'x', 64);
+			buf[i + j] = '\0';
+			if (strlen(buf + i) != j) {
+				kfree(buf);
+				return (i << 8) | j;
+			}
+		}
+	}
+
+	kfree(buf);
+	return 0;
+}
+
+static __init int memchr_selftest(void)
+{
+	char *buf;
+	char *result;
+	unsigned int i, j, k;
+
+	buf = kmalloc(64, GFP_KERNEL);
+	if (!buf)
+		return -1;
+
+	/* Every start alignment, area size and match position. */
+	for (i = 0; i < sizeof(long); i++) {
+		for (j = 0; j < 40; j++) {
+			memset(buf, 'x', 64);
+			result = memchr(buf + i, 'y', j);
+			if (result) {
+				kfree(buf);
+				return (i << 16) | (j << 8);
+			}
+			for (k = 0; k < j; k++) {
+				buf[i + k] = 'y';
+				result = memchr(buf + i, 'y', j);
+				if (result != buf + i + k) {
+					kfree(buf);
+					return (i << 16) | (j << 8) | k | 0x80;
+				}
+				buf[i + k] = 'x';
+			}
+		}
+	}
+
+	kfree(buf);
+	return 0;
+}
+
 static __init int string_selftest_init(void)
 {
 	int test, subtest;
@@ -208,6 +268,16 @@ static __init int string_selftest_init(void)
 	if (subtest)
 		goto fail;
 
+	test = 6;
+	subtest = strlen_selftest();
+	if (subtest)
+		goto fail;
+
+	test = 7;
+	subtest = memchr_selftest();
+	if (subtest)
+		goto fail;
+
 	pr_info("String selftests succeeded\n");
 	return 0;
 fail:
@@ -163,6 +163,25 @@ static DEVICE_ATTR_RW(name);
 
 BDI_SHOW(read_ahead_kb, K(bdi->ra_pages))
 
+static ssize_t max_read_ahead_kb_store(struct device *dev,
+				       struct device_attribute *attr,
+				       const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned long max_read_ahead_kb;
+	ssize_t ret;
+
+	ret = kstrtoul(buf, 10, &max_read_ahead_kb);
+	if (ret < 0)
+		return ret;
+
+	bdi->max_ra_pages = max_read_ahead_kb >> (PAGE_SHIFT - 10);
+
+	return count;
+}
+
+BDI_SHOW(max_read_ahead_kb, K(bdi->max_ra_pages))
+
 static ssize_t min_ratio_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t count)
 {
@@ -214,6 +233,7 @@ static DEVICE_ATTR_RO(stable_pages_required);
 
 static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
+	&dev_attr_max_read_ahead_kb.attr,
 	&dev_attr_min_ratio.attr,
 	&dev_attr_max_ratio.attr,
 	&dev_attr_stable_pages_required.attr,
@@ -1990,6 +1990,64 @@ static void shrink_readahead_size_eio(struct file *filp,
 	ra->ra_pages /= 4;
 }
 
+/*
+ * find_get_uptodate_pages_contig - gang lookup of ready-to-copy pages
+ * @mapping:	The address_space to search
+ * @index:	The starting page index
+ * @nr_pages:	The maximum number of pages
+ * @pages:	Where the resulting pages are placed
+ *
+ * Like find_get_pages_contig(), but stops at the first page that is not
+ * uptodate or carries the readahead marker, so that the caller's slow
+ * path can deal with IO, locking and readahead for that page.
+ */
+static unsigned int find_get_uptodate_pages_contig(struct address_space *mapping,
+		pgoff_t index, unsigned int nr_pages, struct page **pages)
+{
+	XA_STATE(xas, &mapping->i_pages, index);
+	struct page *page;
+	unsigned int ret = 0;
+
+	if (unlikely(!nr_pages))
+		return 0;
+
+	rcu_read_lock();
+	for (page = xas_load(&xas); page; page = xas_next(&xas)) {
+		if (xas_retry(&xas, page))
+			continue;
+		/*
+		 * If the entry has been swapped out, we can stop looking.
+		 * No current caller is looking for DAX entries.
+		 */
+		if (xa_is_value(page))
+			break;
+
+		if (!page_cache_get_speculative(page))
+			goto retry;
+
+		/* Has the page moved or been split? */
+		if (unlikely(page != xas_reload(&xas)))
+			goto put_page;
+
+		/* Leave pages that need IO or readahead to the caller. */
+		if (!PageUptodate(page) || PageReadahead(page)) {
+			put_page(page);
+			break;
+		}
+
+		pages[ret] = find_subpage(page, xas.xa_index);
+		if (++ret == nr_pages)
+			break;
+		continue;
+put_page:
+		put_page(page);
+retry:
+		xas_reset(&xas);
+	}
+	rcu_read_unlock();
+	return ret;
+}
+
 /**
  * generic_file_buffered_read - generic file read routine
  * @iocb:	the iocb to read
@@ -2044,6 +2102,88 @@ find_page:
 			goto out;
 		}
 
+		/*
+		 * Fast path: pull a run of contiguous uptodate pages in one
+		 * xarray walk and copy them out back to back, instead of
+		 * paying for a full lookup per page.  The first page that
+		 * needs IO, locking or readahead ends the run and is dealt
+		 * with by the single-page path below.
+		 */
+		while (last_index - index >= 2) {
+			struct page *pages[PAGEVEC_SIZE];
+			unsigned int want, nr_pages, i;
+			bool stop = false;
+
+			want = min_t(pgoff_t, last_index - index, PAGEVEC_SIZE);
+			nr_pages = find_get_uptodate_pages_contig(mapping, index,
+								  want, pages);
+			if (!nr_pages)
+				break;
+
+			for (i = 0; i < nr_pages; i++) {
+				page = pages[i];
+
+				isize = i_size_read(inode);
+				end_index = (isize - 1) >> PAGE_SHIFT;
+				if (unlikely(!isize || index > end_index)) {
+					put_page(page);
+					stop = true;
+					break;
+				}
+
+				nr = PAGE_SIZE;
+				if (index == end_index) {
+					nr = ((isize - 1) & ~PAGE_MASK) + 1;
+					if (nr <= offset) {
+						put_page(page);
+						stop = true;
+						break;
+					}
+				}
+				nr = nr - offset;
+
+				if (mapping_writably_mapped(mapping))
+					flush_dcache_page(page);
+
+				if (prev_index != index || offset != prev_offset)
+					mark_page_accessed(page);
+				prev_index = index;
+
+				ret = copy_page_to_iter(page, offset, nr, iter);
+				offset += ret;
+				index += offset >> PAGE_SHIFT;
+				offset &= ~PAGE_MASK;
+				prev_offset = offset;
+
+				put_page(page);
+				written += ret;
+				if (ret < nr) {
+					error = -EFAULT;
+					stop = true;
+					break;
+				}
+				if (!iov_iter_count(iter)) {
+					stop = true;
+					break;
+				}
+			}
+
+			/* Release what the copy loop did not consume. */
+			while (++i < nr_pages)
+				put_page(pages[i]);
+			if (stop)
+				goto out;
+			/* A short batch means the next page needs attention. */
+			if (nr_pages < want)
+				break;
+
+			if (fatal_signal_pending(current)) {
+				error = -EINTR;
+				goto out;
+			}
+			cond_resched();
+		}
+
 		page = find_get_page(mapping, index);
 		if (!page) {
 			if (iocb->ki_flags & IOCB_NOWAIT)
@@ -28,6 +28,7 @@
 #include <linux/jhash.h>
 #include <linux/numa.h>
 #include <linux/llist.h>
+#include <linux/workqueue.h>
 
 #include <asm/page.h>
 #include <asm/pgtable.h>
@@ -1550,6 +1551,82 @@ static int alloc_pool_huge_page(struct hstate *h, nodemask_t *nodes_allowed,
 	return 1;
 }
 
+/* minimum pool increment worth fanning out across per-node workers */
+#define HUGETLB_PARALLEL_ALLOC_MIN	1024
+
+struct hugetlb_grow_work {
+	struct work_struct work;
+	struct hstate *h;
+	nodemask_t *node_alloc_noretry;
+	int nid;
+	unsigned long nr_pages;
+};
+
+static void hugetlb_grow_workfn(struct work_struct *work)
+{
+	struct hugetlb_grow_work *gw = container_of(work,
+					struct hugetlb_grow_work, work);
+	struct hstate *h = gw->h;
+	gfp_t gfp_mask = htlb_alloc_mask(h) | __GFP_THISNODE;
+	unsigned long i;
+
+	for (i = 0; i < gw->nr_pages; i++) {
+		struct page *page;
+
+		page = alloc_fresh_huge_page(h, gfp_mask, gw->nid, NULL,
+					     gw->node_alloc_noretry);
+		if (!page)
+			break;
+		put_page(page); /* free it into the hugepage allocator */
+		cond_resched();
+	}
+}
+
+/*
+ * Grow the pool with one worker per allowed node, each allocating only on
+ * its own node.  This both parallelizes the zeroing/prep work and spreads
+ * the new pages evenly, like the interleaved serial loop would.  Called
+ * without hugetlb_lock; the workers take it per page via
+ * prep_new_huge_page() and free_huge_page().  The caller is expected to
+ * re-check persistent_huge_pages() afterwards and top up any shortfall
+ * with the serial loop; excess pages from concurrent frees are trimmed by
+ * the normal pool-shrink path.
+ */
+static void alloc_pool_huge_pages_parallel(struct hstate *h,
+					   unsigned long needed,
+					   nodemask_t *nodes_allowed,
+					   nodemask_t *node_alloc_noretry)
+{
+	struct hugetlb_grow_work *works;
+	unsigned long per_node, rem;
+	int nr_nodes, node, i;
+
+	nr_nodes = nodes_weight(*nodes_allowed);
+	works = kcalloc(nr_nodes, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return;
+
+	per_node = needed / nr_nodes;
+	rem = needed % nr_nodes;
+	i = 0;
+	for_each_node_mask(node, *nodes_allowed) {
+		struct hugetlb_grow_work *gw = &works[i++];
+
+		gw->h = h;
+		gw->nid = node;
+		gw->node_alloc_noretry = node_alloc_noretry;
+		gw->nr_pages = per_node + !!rem;
+		if (rem)
+			rem--;
+		INIT_WORK(&gw->work, hugetlb_grow_workfn);
+		queue_work(system_unbound_wq, &gw->work);
+	}
+
+	for (i = 0; i < nr_nodes; i++)
+		flush_work(&works[i].work);
+	kfree(works);
+}
+
 /*
  * Free huge page from pool from next node to free.
  * Attempt to keep persistent huge pages more or less
@@ -2491,6 +2568,22 @@ static int set_max_huge_pages(struct hstate *h, unsigned long count, int nid,
 			break;
 	}
 
+	/*
+	 * Large increments on a multi-node system are fanned out with one
+	 * worker per allowed node.  The serial loop below then only has to
+	 * top up whatever the workers could not allocate.
+	 */
+	if (!hstate_is_gigantic(h) && count > persistent_huge_pages(h) &&
+	    count - persistent_huge_pages(h) >= HUGETLB_PARALLEL_ALLOC_MIN &&
+	    nodes_weight(*nodes_allowed) > 1) {
+		unsigned long needed = count - persistent_huge_pages(h);
+
+		spin_unlock(&hugetlb_lock);
+		alloc_pool_huge_pages_parallel(h, needed, nodes_allowed,
+					       node_alloc_noretry);
+		spin_lock(&hugetlb_lock);
+	}
+
 	while (count > persistent_huge_pages(h)) {
 		/*
 		 * If this allocation races such that we no longer need the
@@ -4511,7 +4604,17 @@ long follow_hugetlb_page(struct mm_struct *mm, struct vm_area_struct *vma,
 same_page:
 		if (pages) {
 			pages[i] = mem_map_offset(page, pfn_offset);
-			get_page(pages[i]);
+			/*
+			 * try_grab_page() should always succeed here, because:
+			 * a) we hold the ptl lock, and b) we've just checked
+			 * that the huge page is present in the page tables.
+			 */
+			if (WARN_ON_ONCE(!try_grab_page(pages[i], flags))) {
+				spin_unlock(ptl);
+				remainder = 0;
+				err = -ENOMEM;
+				break;
+			}
 		}
 
 		if (vmas)
@@ -5085,8 +5188,15 @@ retry:
 	pte = huge_ptep_get((pte_t *)pmd);
 	if (pte_present(pte)) {
 		page = pmd_page(*pmd) + ((address & ~PMD_MASK) >> PAGE_SHIFT);
-		if (flags & FOLL_GET)
-			get_page(page);
+		/*
+		 * try_grab_page() should always succeed here, because: a) we
+		 * hold the pmd (ptl) lock, and b) we've just checked that the
+		 * huge pmd (head) page is present in the page tables.
+		 */
+		if (WARN_ON_ONCE(!try_grab_page(page, flags))) {
+			page = NULL;
+			goto out;
+		}
 	} else {
 		if (is_hugetlb_entry_migration(pte)) {
 			spin_unlock(ptl);
@@ -5107,7 +5217,7 @@ struct page * __weak
 follow_huge_pud(struct mm_struct *mm, unsigned long address,
 		pud_t *pud, int flags)
 {
-	if (flags & FOLL_GET)
+	if (flags & (FOLL_GET | FOLL_PIN))
 		return NULL;
 
 	return pte_page(*(pte_t *)pud) + ((address & ~PUD_MASK) >> PAGE_SHIFT);
@@ -5116,7 +5226,7 @@ follow_huge_pud(struct mm_struct *mm, unsigned long address,
 struct page * __weak
 follow_huge_pgd(struct mm_struct *mm, unsigned long address, pgd_t *pgd, int flags)
 {
-	if (flags & FOLL_GET)
+	if (flags & (FOLL_GET | FOLL_PIN))
 		return NULL;
 
 	return pte_page(*(pte_t *)pgd) + ((address & ~PGDIR_MASK) >> PAGE_SHIFT);
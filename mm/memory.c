@@ -2381,7 +2381,7 @@ static vm_fault_t wp_page_copy(struct vm_fault *vmf)
 		ptep_clear_flush_notify(vma, vmf->address, vmf->pte);
 		page_add_new_anon_rmap(new_page, vma, vmf->address, false);
 		mem_cgroup_commit_charge(new_page, memcg, false, false);
-		lru_cache_add_active_or_unevictable(new_page, vma);
+		lru_cache_add_inactive_or_unevictable(new_page, vma);
 		/*
 		 * We call the notify macro here because, when using secondary
 		 * mmu page tables (such as kvm shadow page tables), we want the
@@ -2565,6 +2565,11 @@ static vm_fault_t do_wp_page(struct vm_fault *vmf)
 {
 	struct vm_area_struct *vma = vmf->vma;
 
+	if (userfaultfd_pte_wp(vma, *vmf->pte)) {
+		pte_unmap_unlock(vmf->pte, vmf->ptl);
+		return handle_userfault(vmf, VM_UFFD_WP);
+	}
+
 	vmf->page = vm_normal_page(vma, vmf->address, vmf->orig_pte);
 	if (!vmf->page) {
 		/*
@@ -2898,6 +2903,10 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	flush_icache_page(vma, page);
 	if (pte_swp_soft_dirty(vmf->orig_pte))
 		pte = pte_mksoft_dirty(pte);
+	if (pte_swp_uffd_wp(vmf->orig_pte)) {
+		pte = pte_mkuffd_wp(pte);
+		pte = pte_wrprotect(pte);
+	}
 	set_pte_at(vma->vm_mm, vmf->address, vmf->pte, pte);
 	arch_do_swap_page(vma->vm_mm, vma, vmf->address, pte, vmf->orig_pte);
 	vmf->orig_pte = pte;
@@ -2906,11 +2915,10 @@ vm_fault_t do_swap_page(struct vm_fault *vmf)
 	if (unlikely(page != swapcache && swapcache)) {
 		page_add_new_anon_rmap(page, vma, vmf->address, false);
 		mem_cgroup_commit_charge(page, memcg, false, false);
-		lru_cache_add_active_or_unevictable(page, vma);
+		lru_cache_add_inactive_or_unevictable(page, vma);
 	} else {
 		do_page_add_anon_rmap(page, vma, vmf->address, exclusive);
 		mem_cgroup_commit_charge(page, memcg, true, false);
-		activate_page(page);
 	}
 
 	swap_free(entry);
@@ -3054,7 +3062,7 @@ static vm_fault_t do_anonymous_page(struct vm_fault *vmf)
 	inc_mm_counter_fast(vma->vm_mm, MM_ANONPAGES);
 	page_add_new_anon_rmap(page, vma, vmf->address, false);
 	mem_cgroup_commit_charge(page, memcg, false, false);
-	lru_cache_add_active_or_unevictable(page, vma);
+	lru_cache_add_inactive_or_unevictable(page, vma);
 setpte:
 	set_pte_at(vma->vm_mm, vmf->address, vmf->pte, entry);
 
@@ -3317,7 +3325,7 @@ vm_fault_t alloc_set_pte(struct vm_fault *vmf, struct mem_cgroup *memcg,
 		inc_mm_counter_fast(vma->vm_mm, MM_ANONPAGES);
 		page_add_new_anon_rmap(page, vma, vmf->address, false);
 		mem_cgroup_commit_charge(page, memcg, false, false);
-		lru_cache_add_active_or_unevictable(page, vma);
+		lru_cache_add_inactive_or_unevictable(page, vma);
 	} else {
 		inc_mm_counter_fast(vma->vm_mm, mm_counter_file(page));
 		page_add_file_rmap(page, false);
@@ -4041,6 +4049,182 @@ vm_fault_t handle_mm_fault(struct vm_area_struct *vma, unsigned long address,
 }
 EXPORT_SYMBOL_GPL(handle_mm_fault);
 
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+/*
+ * Handle the easiest and by far most common page fault - the first touch of
+ * an anonymous private page - without taking the mmap_sem at all.
+ *
+ * The vma is looked up under mm_rb_lock and pinned with a reference, and a
+ * snapshot of its sequence count is taken; any concurrent modification of
+ * the vma (or of the address space layout) changes the sequence count and
+ * makes us bail to the classic, mmap_sem protected, path. The final check
+ * is done with the page table lock held, which is also what any concurrent
+ * zap of the range must take, so once the pte is installed it is visible to
+ * munmap()/mprotect() the same way a pte installed under the mmap_sem is.
+ *
+ * The page table walk is done with interrupts disabled: x86 frees page
+ * tables only after the TLB shootdown IPI has been answered by all CPUs,
+ * so the tables cannot go away under us (see the Kconfig dependency).
+ *
+ * Returns VM_FAULT_RETRY whenever the fault must be retried on the classic
+ * path, for whatever reason.
+ */
+vm_fault_t __handle_speculative_fault(struct mm_struct *mm,
+				      unsigned long address, unsigned int flags)
+{
+	struct vm_area_struct *vma;
+	struct mem_cgroup *memcg;
+	struct page *page = NULL;
+	spinlock_t *ptl;
+	pgd_t *pgd;
+	p4d_t *p4d;
+	pud_t *pud;
+	pmd_t *pmd, pmdval;
+	pte_t *pte, entry;
+	unsigned long vm_flags;
+	unsigned int seq;
+	vm_fault_t ret = VM_FAULT_RETRY;
+
+	vma = get_vma(mm, address);
+	if (!vma)
+		return VM_FAULT_RETRY;
+
+	seq = raw_read_seqcount(&vma->vm_sequence);
+	if (seq & 1)
+		goto out_put;
+
+	/*
+	 * A speculative fault is only attempted on the straightforward
+	 * anonymous private vma; everything else - files, hugetlb, uffd,
+	 * driver mappings, mlock accounting, per-vma NUMA policies - is
+	 * left to the classic path.
+	 */
+	if (!vma_is_anonymous(vma))
+		goto out_put;
+
+	vm_flags = READ_ONCE(vma->vm_flags);
+	if (vm_flags & (VM_SHARED | VM_SPECIAL | VM_HUGETLB | VM_LOCKED |
+			VM_UFFD_MISSING))
+		goto out_put;
+#ifdef CONFIG_NUMA
+	if (READ_ONCE(vma->vm_policy))
+		goto out_put;
+#endif
+
+	if (address < READ_ONCE(vma->vm_start) ||
+	    READ_ONCE(vma->vm_end) <= address)
+		goto out_put;
+
+	/* Same checks as access_error()/protection fault handling */
+	if (flags & FAULT_FLAG_WRITE) {
+		if (!(vm_flags & VM_WRITE))
+			goto out_put;
+	} else if (flags & FAULT_FLAG_INSTRUCTION) {
+		if (!(vm_flags & VM_EXEC))
+			goto out_put;
+	} else if (!(vm_flags & (VM_READ | VM_EXEC | VM_WRITE)))
+		goto out_put;
+
+	if (flags & FAULT_FLAG_WRITE) {
+		/*
+		 * anon_vma_prepare() requires the mmap_sem; only handle the
+		 * fault if a previous (locked) fault already set it up.
+		 */
+		if (!READ_ONCE(vma->anon_vma))
+			goto out_put;
+
+		/*
+		 * Equivalent to alloc_zeroed_user_highpage_movable(), but
+		 * without looking at vma->vm_policy, which a concurrent
+		 * mbind() may be rewriting: vmas with a policy were
+		 * excluded above, so the task policy applies either way.
+		 */
+		page = alloc_page(GFP_HIGHUSER_MOVABLE | __GFP_ZERO);
+		if (!page)
+			goto out_put;
+		if (mem_cgroup_try_charge_delay(page, mm, GFP_KERNEL, &memcg,
+						false))
+			goto out_free;
+		__SetPageUptodate(page);
+
+		entry = mk_pte(page, vma->vm_page_prot);
+		entry = pte_mkwrite(pte_mkdirty(entry));
+	} else {
+		if (mm_forbids_zeropage(mm))
+			goto out_put;
+		entry = pte_mkspecial(pfn_pte(my_zero_pfn(address),
+					      vma->vm_page_prot));
+	}
+
+	local_irq_disable();
+	pgd = pgd_offset(mm, address);
+	if (pgd_none(*pgd) || unlikely(pgd_bad(*pgd)))
+		goto out_irq;
+	p4d = p4d_offset(pgd, address);
+	if (p4d_none(*p4d) || unlikely(p4d_bad(*p4d)))
+		goto out_irq;
+	pud = pud_offset(p4d, address);
+	if (pud_none(*pud) || unlikely(pud_bad(*pud)))
+		goto out_irq;
+	pmd = pmd_offset(pud, address);
+	pmdval = READ_ONCE(*pmd);
+	if (!pmd_present(pmdval) || pmd_trans_huge(pmdval) ||
+	    pmd_devmap(pmdval) || unlikely(pmd_bad(pmdval)))
+		goto out_irq;
+
+	pte = pte_offset_map_lock(mm, &pmdval, address, &ptl);
+
+	/*
+	 * Re-validate now that we hold the pte lock: any vma modification
+	 * (including its unmapping) either bumped vm_sequence before we got
+	 * here, or is serialized behind this pte lock and will operate on
+	 * whatever we install. A collapsing THP rewrites the pmd under the
+	 * same pte lock, hence the pmd_same() check.
+	 */
+	if (raw_read_seqcount(&vma->vm_sequence) != seq)
+		goto out_unlock;
+	if (unlikely(!pmd_same(pmdval, *pmd)))
+		goto out_unlock;
+	if (!pte_none(*pte))
+		goto out_unlock;
+
+	ret = check_stable_address_space(mm);
+	if (ret)
+		goto out_unlock;
+
+	if (page) {
+		inc_mm_counter_fast(mm, MM_ANONPAGES);
+		page_add_new_anon_rmap(page, vma, address, false);
+		mem_cgroup_commit_charge(page, memcg, false, false);
+		lru_cache_add_inactive_or_unevictable(page, vma);
+		page = NULL;
+	}
+	set_pte_at(mm, address, pte, entry);
+
+	/* No need to invalidate - it was non-present before */
+	update_mmu_cache(vma, address, pte);
+
+	pte_unmap_unlock(pte, ptl);
+	local_irq_enable();
+	count_vm_event(SPECULATIVE_PGFAULT);
+	put_vma(vma);
+	return 0;
+
+out_unlock:
+	pte_unmap_unlock(pte, ptl);
+out_irq:
+	local_irq_enable();
+	if (page)
+		mem_cgroup_cancel_charge(page, memcg, false);
+out_free:
+	if (page)
+		put_page(page);
+out_put:
+	put_vma(vma);
+	return ret;
+}
+#endif /* CONFIG_SPECULATIVE_PAGE_FAULT */
+
 #ifndef __PAGETABLE_P4D_FOLDED
 /*
  * Allocate p4d page table.
@@ -570,9 +570,11 @@ success:
 	 * set VM_LOCKED, populate_vma_page_range will bring it back.
 	 */
 
-	if (lock)
+	if (lock) {
+		vm_write_begin(vma);
 		vma->vm_flags = newflags;
-	else
+		vm_write_end(vma);
+	} else
 		munlock_vma_pages_range(vma, start, end);
 
 out:
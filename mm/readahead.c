@@ -144,6 +144,41 @@ out:
 	return ret;
 }
 
+/*
+ * Refill @batch with up to @nr pages.  Readahead windows run to hundreds
+ * of pages, so try to carve them out of one higher-order block instead of
+ * hitting the allocator once per 4K; the split pages are handed out in
+ * ascending physical order, so a contiguous stretch of the file ends up
+ * physically contiguous and the filesystem can build large, few-segment
+ * bios from it.  Readahead is speculative, so never apply direct reclaim
+ * pressure for the big block - fall back to a plain order-0 allocation
+ * instead.
+ */
+static unsigned int ra_alloc_batch(struct list_head *batch, unsigned int nr,
+				   gfp_t gfp_mask)
+{
+	unsigned int order, i;
+	struct page *page;
+
+	order = min_t(unsigned int, ilog2(nr), PAGE_ALLOC_COSTLY_ORDER);
+	for (; order; order--) {
+		page = alloc_pages((gfp_mask & ~__GFP_DIRECT_RECLAIM) |
+				   __GFP_NORETRY | __GFP_NOWARN, order);
+		if (page) {
+			split_page(page, order);
+			for (i = 0; i < (1U << order); i++)
+				list_add(&page[i].lru, batch);
+			return 1U << order;
+		}
+	}
+
+	page = __page_cache_alloc(gfp_mask);
+	if (!page)
+		return 0;
+	list_add(&page->lru, batch);
+	return 1;
+}
+
 /*
  * __do_page_cache_readahead() actually reads a chunk of disk.  It allocates
  * the pages first, then submits them for I/O. This avoids the very bad
@@ -160,6 +195,7 @@ unsigned int __do_page_cache_readahead(struct address_space *mapping,
 	struct page *page;
 	unsigned long end_index;	/* The last page we want to read */
 	LIST_HEAD(page_pool);
+	LIST_HEAD(batch);
 	int page_idx;
 	unsigned int nr_pages = 0;
 	loff_t isize = i_size_read(inode);
@@ -171,7 +207,10 @@ unsigned int __do_page_cache_readahead(struct address_space *mapping,
 	end_index = ((isize - 1) >> PAGE_SHIFT);
 
 	/*
-	 * Preallocate as many pages as we will need.
+	 * Preallocate as many pages as we will need.  Pages are drawn from
+	 * a batch that is refilled with one higher-order allocation at a
+	 * time; leftover batch pages simply carry over to the next hole in
+	 * the range.
 	 */
 	for (page_idx = 0; page_idx < nr_to_read; page_idx++) {
 		pgoff_t page_offset = offset + page_idx;
@@ -193,9 +232,11 @@ unsigned int __do_page_cache_readahead(struct address_space *mapping,
 			continue;
 		}
 
-		page = __page_cache_alloc(gfp_mask);
-		if (!page)
+		if (list_empty(&batch) &&
+		    !ra_alloc_batch(&batch, nr_to_read - page_idx, gfp_mask))
 			break;
+		page = lru_to_page(&batch);
+		list_del(&page->lru);
 		page->index = page_offset;
 		list_add(&page->lru, &page_pool);
 		if (page_idx == nr_to_read - lookahead_size)
@@ -211,6 +252,7 @@ unsigned int __do_page_cache_readahead(struct address_space *mapping,
 	if (nr_pages)
 		read_pages(mapping, filp, &page_pool, nr_pages, gfp_mask);
 	BUG_ON(!list_empty(&page_pool));
+	put_pages_list(&batch);
 out:
 	return nr_pages;
 }
@@ -408,6 +450,13 @@ ondemand_readahead(struct address_space *mapping,
 	 */
 	if ((offset == (ra->start + ra->size - ra->async_size) ||
 	     offset == (ra->start + ra->size))) {
+		/*
+		 * A stream that keeps hitting its own readahead marker has
+		 * proven itself sequential; let it ramp past the default
+		 * window up to the bdi's streaming cap, if one is set.
+		 */
+		if (bdi->max_ra_pages > max_pages)
+			max_pages = bdi->max_ra_pages;
 		ra->start += ra->size;
 		ra->size = get_next_ra_size(ra, max_pages);
 		ra->async_size = ra->size;
@@ -423,6 +472,9 @@ ondemand_readahead(struct address_space *mapping,
 	if (hit_readahead_marker) {
 		pgoff_t start;
 
+		if (bdi->max_ra_pages > max_pages)
+			max_pages = bdi->max_ra_pages;
+
 		rcu_read_lock();
 		start = page_cache_next_miss(mapping, offset + 1, max_pages);
 		rcu_read_unlock();
@@ -116,10 +116,12 @@ struct shmem_options {
 	kgid_t gid;
 	umode_t mode;
 	int huge;
+	bool huge_sync;
 	int seen;
 #define SHMEM_SEEN_BLOCKS 1
 #define SHMEM_SEEN_INODES 2
 #define SHMEM_SEEN_HUGE 4
+#define SHMEM_SEEN_HUGE_SYNC 8
 };
 
 #ifdef CONFIG_TMPFS
@@ -1468,6 +1470,7 @@ static struct page *shmem_alloc_hugepage(gfp_t gfp,
 {
 	struct vm_area_struct pvma;
 	struct address_space *mapping = info->vfs_inode.i_mapping;
+	struct shmem_sb_info *sbinfo = SHMEM_SB(info->vfs_inode.i_sb);
 	pgoff_t hindex;
 	struct page *page;
 
@@ -1479,9 +1482,17 @@ static struct page *shmem_alloc_hugepage(gfp_t gfp,
 								XA_PRESENT))
 		return NULL;
 
+	/*
+	 * A mount with huge_sync prefers waiting for compaction over
+	 * silently falling back to small pages under fragmentation.
+	 */
+	gfp |= __GFP_COMP | __GFP_NOWARN;
+	if (!sbinfo->huge_sync)
+		gfp |= __GFP_NORETRY;
+
 	shmem_pseudo_vma_init(&pvma, info, hindex);
-	page = alloc_pages_vma(gfp | __GFP_COMP | __GFP_NORETRY | __GFP_NOWARN,
-			HPAGE_PMD_ORDER, &pvma, 0, numa_node_id(), true);
+	page = alloc_pages_vma(gfp, HPAGE_PMD_ORDER, &pvma, 0,
+			       numa_node_id(), true);
 	shmem_pseudo_vma_destroy(&pvma);
 	if (page)
 		prep_transhuge_page(page);
@@ -1526,6 +1537,8 @@ static struct page *shmem_alloc_and_acct_page(gfp_t gfp,
 		__SetPageSwapBacked(page);
 		return page;
 	}
+	if (huge)
+		count_vm_event(THP_FILE_FALLBACK);
 
 	err = -ENOMEM;
 	shmem_inode_unacct_blocks(inode, nr);
@@ -2896,8 +2909,15 @@ shmem_mknod(struct inode *dir, struct dentry *dentry, umode_t mode, dev_t dev)
 			goto out_iput;
 
 		error = 0;
+		/*
+		 * The parent may only be locked shared (FS_ALLOW_PAR_DIROPS),
+		 * so the bogus directory size and times are updated under
+		 * i_lock to keep concurrent creates and unlinks consistent.
+		 */
+		spin_lock(&dir->i_lock);
 		dir->i_size += BOGO_DIRENT_SIZE;
 		dir->i_ctime = dir->i_mtime = current_time(dir);
+		spin_unlock(&dir->i_lock);
 		d_instantiate(dentry, inode);
 		dget(dentry); /* Extra count - pin the dentry in core */
 	}
@@ -2985,8 +3005,10 @@ static int shmem_unlink(struct inode *dir, struct dentry *dentry)
 	if (inode->i_nlink > 1 && !S_ISDIR(inode->i_mode))
 		shmem_free_inode(inode->i_sb);
 
+	spin_lock(&dir->i_lock);
 	dir->i_size -= BOGO_DIRENT_SIZE;
 	inode->i_ctime = dir->i_ctime = dir->i_mtime = current_time(inode);
+	spin_unlock(&dir->i_lock);
 	drop_nlink(inode);
 	dput(dentry);	/* Undo the count from "create" - this does all the work */
 	return 0;
@@ -3375,6 +3397,7 @@ static const struct export_operations shmem_export_ops = {
 enum shmem_param {
 	Opt_gid,
 	Opt_huge,
+	Opt_huge_sync,
 	Opt_mode,
 	Opt_mpol,
 	Opt_nr_blocks,
@@ -3386,6 +3409,7 @@ enum shmem_param {
 static const struct fs_parameter_spec shmem_param_specs[] = {
 	fsparam_u32   ("gid",		Opt_gid),
 	fsparam_enum  ("huge",		Opt_huge),
+	fsparam_flag_no("huge_sync",	Opt_huge_sync),
 	fsparam_u32oct("mode",		Opt_mode),
 	fsparam_string("mpol",		Opt_mpol),
 	fsparam_string("nr_blocks",	Opt_nr_blocks),
@@ -3468,6 +3492,13 @@ static int shmem_parse_one(struct fs_context *fc, struct fs_parameter *param)
 			goto unsupported_parameter;
 		ctx->seen |= SHMEM_SEEN_HUGE;
 		break;
+	case Opt_huge_sync:
+		if (!(IS_ENABLED(CONFIG_TRANSPARENT_HUGE_PAGECACHE) &&
+		      has_transparent_hugepage()))
+			goto unsupported_parameter;
+		ctx->huge_sync = result.boolean;
+		ctx->seen |= SHMEM_SEEN_HUGE_SYNC;
+		break;
 	case Opt_mpol:
 		if (IS_ENABLED(CONFIG_NUMA)) {
 			mpol_put(ctx->mpol);
@@ -3570,6 +3601,8 @@ static int shmem_reconfigure(struct fs_context *fc)
 
 	if (ctx->seen & SHMEM_SEEN_HUGE)
 		sbinfo->huge = ctx->huge;
+	if (ctx->seen & SHMEM_SEEN_HUGE_SYNC)
+		sbinfo->huge_sync = ctx->huge_sync;
 	if (ctx->seen & SHMEM_SEEN_BLOCKS)
 		sbinfo->max_blocks  = ctx->blocks;
 	if (ctx->seen & SHMEM_SEEN_INODES) {
@@ -3613,6 +3646,8 @@ static int shmem_show_options(struct seq_file *seq, struct dentry *root)
 	/* Rightly or wrongly, show huge mount option unmasked by shmem_huge */
 	if (sbinfo->huge)
 		seq_printf(seq, ",huge=%s", shmem_format_huge(sbinfo->huge));
+	if (sbinfo->huge_sync)
+		seq_puts(seq, ",huge_sync");
 #endif
 	shmem_show_mpol(seq, sbinfo->mpol);
 	return 0;
@@ -3670,6 +3705,7 @@ static int shmem_fill_super(struct super_block *sb, struct fs_context *fc)
 	sbinfo->gid = ctx->gid;
 	sbinfo->mode = ctx->mode;
 	sbinfo->huge = ctx->huge;
+	sbinfo->huge_sync = ctx->huge_sync;
 	sbinfo->mpol = ctx->mpol;
 	ctx->mpol = NULL;
 
@@ -3894,7 +3930,7 @@ static struct file_system_type shmem_fs_type = {
 	.parameters	= &shmem_fs_parameters,
 #endif
 	.kill_sb	= kill_litter_super,
-	.fs_flags	= FS_USERNS_MOUNT,
+	.fs_flags	= FS_USERNS_MOUNT | FS_ALLOW_PAR_DIROPS,
 };
 
 int __init shmem_init(void)
@@ -4039,7 +4075,7 @@ static struct file_system_type shmem_fs_type = {
 	.init_fs_context = ramfs_init_fs_context,
 	.parameters	= &ramfs_fs_parameters,
 	.kill_sb	= kill_litter_super,
-	.fs_flags	= FS_USERNS_MOUNT,
+	.fs_flags	= FS_USERNS_MOUNT | FS_ALLOW_PAR_DIROPS,
 };
 
 int __init shmem_init(void)
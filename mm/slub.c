@@ -2365,7 +2365,7 @@ static bool has_cpu_slab(int cpu, void *info)
 
 static void flush_all(struct kmem_cache *s)
 {
-	on_each_cpu_cond(has_cpu_slab, flush_cpu_slab, s, 1, GFP_ATOMIC);
+	on_each_cpu_cond(has_cpu_slab, flush_cpu_slab, s, 1);
 }
 
 /*
@@ -2706,6 +2706,43 @@ static __always_inline void maybe_wipe_obj_freeptr(struct kmem_cache *s,
  *
  * Otherwise we can simply pick the next object from the lockless free list.
  */
+/*
+ * Try to grab an object from this CPU's sheaf. Sheaves are filled by
+ * sheaf_free() absorbing frees and by kmem_cache_prefill_sheaf(), so a hit
+ * here avoids the cpu freelist and any slab locks entirely.
+ */
+static __always_inline void *sheaf_alloc(struct kmem_cache *s)
+{
+	struct kmem_cache_sheaf *sheaf;
+	unsigned long flags;
+	void *object = NULL;
+
+	local_irq_save(flags);
+	sheaf = this_cpu_ptr(s->cpu_sheaf);
+	if (likely(sheaf->count))
+		object = sheaf->objects[--sheaf->count];
+	local_irq_restore(flags);
+
+	return object;
+}
+
+static __always_inline bool sheaf_free(struct kmem_cache *s, void *object)
+{
+	struct kmem_cache_sheaf *sheaf;
+	unsigned long flags;
+	bool done = false;
+
+	local_irq_save(flags);
+	sheaf = this_cpu_ptr(s->cpu_sheaf);
+	if (likely(sheaf->count < s->sheaf_capacity)) {
+		sheaf->objects[sheaf->count++] = object;
+		done = true;
+	}
+	local_irq_restore(flags);
+
+	return done;
+}
+
 static __always_inline void *slab_alloc_node(struct kmem_cache *s,
 		gfp_t gfpflags, int node, unsigned long addr)
 {
@@ -2717,6 +2754,14 @@ static __always_inline void *slab_alloc_node(struct kmem_cache *s,
 	s = slab_pre_alloc_hook(s, gfpflags);
 	if (!s)
 		return NULL;
+
+	if (s->cpu_sheaf && node == NUMA_NO_NODE) {
+		object = sheaf_alloc(s);
+		if (object) {
+			stat(s, ALLOC_FASTPATH);
+			goto out;
+		}
+	}
 redo:
 	/*
 	 * Must read kmem_cache cpu data via this cpu ptr. Preemption is
@@ -2784,7 +2829,7 @@ redo:
 		prefetch_freepointer(s, next_object);
 		stat(s, ALLOC_FASTPATH);
 	}
-
+out:
 	maybe_wipe_obj_freeptr(s, object);
 
 	if (unlikely(slab_want_init_on_alloc(gfpflags, s)) && object)
@@ -3038,8 +3083,11 @@ static __always_inline void slab_free(struct kmem_cache *s, struct page *page,
 	 * With KASAN enabled slab_free_freelist_hook modifies the freelist
 	 * to remove objects, whose reuse must be delayed.
 	 */
-	if (slab_free_freelist_hook(s, &head, &tail))
+	if (slab_free_freelist_hook(s, &head, &tail)) {
+		if (s->cpu_sheaf && cnt == 1 && sheaf_free(s, head))
+			return;
 		do_slab_free(s, page, head, tail, cnt, addr);
+	}
 }
 
 #ifdef CONFIG_KASAN_GENERIC
@@ -3240,6 +3288,93 @@ error:
 }
 EXPORT_SYMBOL(kmem_cache_alloc_bulk);
 
+/* Return the sheaf objects of a dead or dying cache to the slabs */
+static void sheaf_drain_cpu(struct kmem_cache *s, int cpu)
+{
+	struct kmem_cache_sheaf *sheaf = per_cpu_ptr(s->cpu_sheaf, cpu);
+
+	while (sheaf->count) {
+		void *object = sheaf->objects[--sheaf->count];
+
+		do_slab_free(s, virt_to_head_page(object), object, NULL, 1,
+			     _RET_IP_);
+	}
+}
+
+/*
+ * Layer a percpu sheaf of @capacity objects above the cpu freelists of
+ * @s. Frees of single objects are absorbed into the local sheaf until it
+ * is full, and allocations are served from it until it is empty, without
+ * ever taking the list_lock. Must be called before the cache sees any
+ * concurrent use.
+ */
+int kmem_cache_setup_sheaves(struct kmem_cache *s, unsigned int capacity)
+{
+	if (!capacity || capacity > PAGE_SIZE / sizeof(void *))
+		return -EINVAL;
+	if (s->cpu_sheaf)
+		return -EBUSY;
+
+	s->cpu_sheaf = __alloc_percpu(sizeof(struct kmem_cache_sheaf) +
+				      capacity * sizeof(void *),
+				      __alignof__(struct kmem_cache_sheaf));
+	if (!s->cpu_sheaf)
+		return -ENOMEM;
+	s->sheaf_capacity = capacity;
+	return 0;
+}
+EXPORT_SYMBOL(kmem_cache_setup_sheaves);
+
+/*
+ * Fill the local sheaf up to @count objects, so that the caller's context
+ * (e.g. a driver rx path) is guaranteed that many lockless allocations.
+ * Interrupts must be enabled; the fill is re-checked around the bulk
+ * allocations since the caller may be migrated between CPUs.
+ */
+int kmem_cache_prefill_sheaf(struct kmem_cache *s, gfp_t gfp,
+			     unsigned int count)
+{
+	struct kmem_cache_sheaf *sheaf;
+	void *objects[16];
+	unsigned long flags;
+
+	if (!s->cpu_sheaf)
+		return -EINVAL;
+
+	count = min(count, s->sheaf_capacity);
+
+	for (;;) {
+		unsigned int batch, i, n;
+
+		local_irq_save(flags);
+		sheaf = this_cpu_ptr(s->cpu_sheaf);
+		batch = sheaf->count < count ? count - sheaf->count : 0;
+		local_irq_restore(flags);
+
+		if (!batch)
+			return 0;
+		batch = min_t(unsigned int, batch, ARRAY_SIZE(objects));
+
+		n = kmem_cache_alloc_bulk(s, gfp, batch, objects);
+		if (!n)
+			return -ENOMEM;
+
+		local_irq_save(flags);
+		sheaf = this_cpu_ptr(s->cpu_sheaf);
+		for (i = 0; i < n; i++) {
+			if (sheaf->count >= s->sheaf_capacity)
+				break;
+			sheaf->objects[sheaf->count++] = objects[i];
+		}
+		local_irq_restore(flags);
+
+		/* migration may have filled the sheaf behind our back */
+		if (i < n)
+			kmem_cache_free_bulk(s, n - i, &objects[i]);
+	}
+}
+EXPORT_SYMBOL(kmem_cache_prefill_sheaf);
+
 
 /*
  * Object placement in a slab is made very easy because we always start at
@@ -3460,6 +3595,7 @@ static void free_kmem_cache_nodes(struct kmem_cache *s)
 void __kmem_cache_release(struct kmem_cache *s)
 {
 	cache_random_seq_destroy(s);
+	free_percpu(s->cpu_sheaf);
 	free_percpu(s->cpu_slab);
 	free_kmem_cache_nodes(s);
 }
@@ -3786,6 +3922,12 @@ int __kmem_cache_shutdown(struct kmem_cache *s)
 	struct kmem_cache_node *n;
 
 	flush_all(s);
+	if (s->cpu_sheaf) {
+		int cpu;
+
+		for_each_possible_cpu(cpu)
+			sheaf_drain_cpu(s, cpu);
+	}
 	/* Attempt to free all objects */
 	for_each_kmem_cache_node(s, node, n) {
 		free_partial(s, n);
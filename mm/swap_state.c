@@ -788,6 +788,20 @@ struct page *swapin_readahead(swp_entry_t entry, gfp_t gfp_mask,
 			swap_cluster_readahead(entry, gfp_mask, vmf);
 }
 
+/*
+ * Report the current per-VMA readahead state for /proc/<pid>/smaps.  The
+ * window says how many pages the next swapin fault in @vma may read ahead,
+ * the hit count is the feedback that grows or shrinks it.
+ */
+void swap_vma_ra_info(struct vm_area_struct *vma, unsigned int *win,
+		      unsigned int *hits)
+{
+	unsigned long ra_val = GET_SWAP_RA_VAL(vma);
+
+	*win = SWAP_RA_WIN(ra_val);
+	*hits = SWAP_RA_HITS(ra_val);
+}
+
 #ifdef CONFIG_SYSFS
 static ssize_t vma_ra_enabled_show(struct kobject *kobj,
 				     struct kobj_attribute *attr, char *buf)
@@ -16,6 +16,7 @@
 #include <linux/hugetlb.h>
 #include <linux/shmem_fs.h>
 #include <asm/tlbflush.h>
+#include <asm/pgalloc.h>
 #include "internal.h"
 
 static int mcopy_atomic_pte(struct mm_struct *dst_mm,
@@ -90,7 +91,7 @@ static int mcopy_atomic_pte(struct mm_struct *dst_mm,
 	inc_mm_counter(dst_mm, MM_ANONPAGES);
 	page_add_new_anon_rmap(page, dst_vma, dst_addr, false);
 	mem_cgroup_commit_charge(page, memcg, false, false);
-	lru_cache_add_active_or_unevictable(page, dst_vma);
+	lru_cache_add_inactive_or_unevictable(page, dst_vma);
 
 	set_pte_at(dst_mm, dst_addr, dst_pte, _dst_pte);
 
@@ -144,6 +145,98 @@ out_unlock:
 	return ret;
 }
 
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+/*
+ * Install a whole transparent huge page with a single pmd update, modeled
+ * after __do_huge_pmd_anonymous_page() except that the contents come from
+ * userspace.  Called with mmap_sem held and the pmd known to have been
+ * none; any failure leaves the pmd untouched so the caller can fall back
+ * to PAGE_SIZE copies.
+ */
+static int mcopy_atomic_huge_pmd(struct mm_struct *dst_mm,
+				 pmd_t *dst_pmd,
+				 struct vm_area_struct *dst_vma,
+				 unsigned long dst_addr,
+				 unsigned long src_addr)
+{
+	struct mem_cgroup *memcg;
+	pgtable_t pgtable;
+	struct page *page;
+	spinlock_t *ptl;
+	pmd_t _dst_pmd;
+	int ret;
+
+	/*
+	 * No direct reclaim: if a huge page is not immediately available
+	 * the PAGE_SIZE fallback makes progress instead of stalling.
+	 */
+	page = alloc_pages_vma(GFP_TRANSHUGE_LIGHT, HPAGE_PMD_ORDER, dst_vma,
+			       dst_addr, numa_node_id(), true);
+	if (!page)
+		return -ENOMEM;
+	prep_transhuge_page(page);
+
+	/*
+	 * mmap_sem is held so pagefaults on the source are not allowed
+	 * here; if the source range is not fully resident the fallback
+	 * path retries the copy outside the lock.
+	 */
+	ret = copy_huge_page_from_user(page, (const void __user *)src_addr,
+				       HPAGE_PMD_NR, false);
+	if (unlikely(ret)) {
+		ret = -EFAULT;
+		goto out_release;
+	}
+
+	/*
+	 * The memory barrier inside __SetPageUptodate makes sure that
+	 * preceeding stores to the page contents become visible before
+	 * the set_pmd_at() write.
+	 */
+	__SetPageUptodate(page);
+
+	ret = -ENOMEM;
+	if (mem_cgroup_try_charge_delay(page, dst_mm, GFP_TRANSHUGE_LIGHT,
+					&memcg, true))
+		goto out_release;
+
+	pgtable = pte_alloc_one(dst_mm);
+	if (unlikely(!pgtable))
+		goto out_cancel;
+
+	_dst_pmd = pmd_mkhuge(mk_pmd(page, dst_vma->vm_page_prot));
+	if (dst_vma->vm_flags & VM_WRITE)
+		_dst_pmd = pmd_mkwrite(pmd_mkdirty(_dst_pmd));
+
+	ptl = pmd_lock(dst_mm, dst_pmd);
+	ret = -EEXIST;
+	if (unlikely(!pmd_none(*dst_pmd))) {
+		spin_unlock(ptl);
+		pte_free(dst_mm, pgtable);
+		goto out_cancel;
+	}
+
+	page_add_new_anon_rmap(page, dst_vma, dst_addr, true);
+	mem_cgroup_commit_charge(page, memcg, false, true);
+	lru_cache_add_inactive_or_unevictable(page, dst_vma);
+	pgtable_trans_huge_deposit(dst_mm, dst_pmd, pgtable);
+	set_pmd_at(dst_mm, dst_addr, dst_pmd, _dst_pmd);
+	add_mm_counter(dst_mm, MM_ANONPAGES, HPAGE_PMD_NR);
+	mm_inc_nr_ptes(dst_mm);
+	update_mmu_cache_pmd(dst_vma, dst_addr, dst_pmd);
+	spin_unlock(ptl);
+	count_vm_event(THP_FAULT_ALLOC);
+	count_memcg_events(memcg, THP_FAULT_ALLOC, 1);
+	return 0;
+
+out_cancel:
+	mem_cgroup_cancel_charge(page, memcg, true);
+out_release:
+	put_page(page);
+	return ret;
+}
+#endif /* CONFIG_TRANSPARENT_HUGEPAGE */
+
 static pmd_t *mm_alloc_pmd(struct mm_struct *mm, unsigned long address)
 {
 	pgd_t *pgd;
@@ -531,6 +624,38 @@ retry:
 		}
 
 		dst_pmdval = pmd_read_atomic(dst_pmd);
+
+#ifdef CONFIG_TRANSPARENT_HUGEPAGE
+		/*
+		 * Opportunistically fill a whole pmd in one go when source
+		 * and destination are huge page aligned, the destination
+		 * pmd is still empty and the vma allows THP.  Any failure
+		 * (no huge page available, source not resident, ...) simply
+		 * falls through to the PAGE_SIZE copies below.
+		 */
+		if (!zeropage && vma_is_anonymous(dst_vma) &&
+		    __transparent_hugepage_enabled(dst_vma) &&
+		    pmd_none(dst_pmdval) &&
+		    !(dst_addr & ~HPAGE_PMD_MASK) &&
+		    !(src_addr & ~HPAGE_PMD_MASK) &&
+		    src_start + len - src_addr >= HPAGE_PMD_SIZE) {
+			err = mcopy_atomic_huge_pmd(dst_mm, dst_pmd, dst_vma,
+						    dst_addr, src_addr);
+			if (!err) {
+				dst_addr += HPAGE_PMD_SIZE;
+				src_addr += HPAGE_PMD_SIZE;
+				copied += HPAGE_PMD_SIZE;
+
+				if (fatal_signal_pending(current)) {
+					err = -EINTR;
+					break;
+				}
+				cond_resched();
+				continue;
+			}
+		}
+#endif
+
 		/*
 		 * If the dst_pmd is mapped as THP don't
 		 * override it and just be strict.
@@ -612,3 +737,60 @@ ssize_t mfill_zeropage(struct mm_struct *dst_mm, unsigned long start,
 {
 	return __mcopy_atomic(dst_mm, start, 0, len, true, mmap_changing);
 }
+
+int mwriteprotect_range(struct mm_struct *dst_mm, unsigned long start,
+			unsigned long len, bool enable_wp, bool *mmap_changing)
+{
+	struct vm_area_struct *dst_vma;
+	pgprot_t newprot;
+	int err;
+
+	/*
+	 * Sanitize the command parameters:
+	 */
+	BUG_ON(start & ~PAGE_MASK);
+	BUG_ON(len & ~PAGE_MASK);
+
+	/* Does the address range wrap, or is the span zero-sized? */
+	BUG_ON(start + len <= start);
+
+	down_read(&dst_mm->mmap_sem);
+
+	/*
+	 * If memory mappings are changing because of non-cooperative
+	 * operation (e.g. mremap) running in parallel, bail out and
+	 * request the user to retry later
+	 */
+	err = -EAGAIN;
+	if (mmap_changing && READ_ONCE(*mmap_changing))
+		goto out_unlock;
+
+	err = -ENOENT;
+	dst_vma = find_vma(dst_mm, start);
+	/*
+	 * Make sure the vma is not shared, that the dst range is
+	 * both valid and fully within a single existing vma.
+	 */
+	if (!dst_vma || (dst_vma->vm_flags & VM_SHARED))
+		goto out_unlock;
+	if (!userfaultfd_wp(dst_vma))
+		goto out_unlock;
+	if (!vma_is_anonymous(dst_vma))
+		goto out_unlock;
+	if (start < dst_vma->vm_start ||
+	    start + len > dst_vma->vm_end)
+		goto out_unlock;
+
+	if (enable_wp)
+		newprot = vm_get_page_prot(dst_vma->vm_flags & ~(VM_WRITE));
+	else
+		newprot = vm_get_page_prot(dst_vma->vm_flags);
+
+	change_protection(dst_vma, start, start + len, newprot,
+			  enable_wp ? MM_CP_UFFD_WP : MM_CP_UFFD_WP_RESOLVE);
+
+	err = 0;
+out_unlock:
+	up_read(&dst_mm->mmap_sem);
+	return err;
+}
@@ -57,6 +57,7 @@
 
 #include <linux/swapops.h>
 #include <linux/balloon_compaction.h>
+#include <linux/migrate.h>
 
 #include "internal.h"
 
@@ -1113,6 +1114,76 @@ static void page_check_dirty_writeback(struct page *page,
 		mapping->a_ops->is_dirty_writeback(page, dirty, writeback);
 }
 
+static struct page *alloc_demote_page(struct page *page, unsigned long node)
+{
+	/*
+	 * Allocate from the target node only and fail fast.  Reclaim is
+	 * already under way and any heroic allocation effort on the
+	 * lower tier is unwanted: if it can not satisfy the request
+	 * immediately, the page is simply reclaimed as before.
+	 */
+	gfp_t mask = (GFP_HIGHUSER_MOVABLE & ~__GFP_RECLAIM) |
+		      __GFP_THISNODE | __GFP_NOWARN |
+		      __GFP_NOMEMALLOC | GFP_NOWAIT;
+	unsigned int order = 0;
+	struct page *new_page;
+
+	if (PageTransHuge(page)) {
+		mask |= __GFP_COMP;
+		order = HPAGE_PMD_ORDER;
+	}
+
+	new_page = __alloc_pages_node(node, mask, order);
+	if (new_page && PageTransHuge(new_page))
+		prep_transhuge_page(new_page);
+
+	return new_page;
+}
+
+/*
+ * Can this node demote to a lower memory tier instead of discarding
+ * at reclaim time?
+ */
+static bool can_demote(int nid)
+{
+	if (!numa_demotion_enabled)
+		return false;
+	if (next_demotion_node(nid) == NUMA_NO_NODE)
+		return false;
+
+	return true;
+}
+
+/*
+ * Take pages on @demote_list and attempt to demote them to
+ * another node.  Pages which are not demoted are left on
+ * @demote_pages.
+ */
+static unsigned int demote_page_list(struct list_head *demote_pages,
+				     struct pglist_data *pgdat)
+{
+	int target_nid = next_demotion_node(pgdat->node_id);
+	unsigned int nr_succeeded;
+
+	if (list_empty(demote_pages))
+		return 0;
+
+	if (target_nid == NUMA_NO_NODE)
+		return 0;
+
+	/* Demotion ignores all cpuset and mempolicy settings */
+	migrate_pages(demote_pages, alloc_demote_page, NULL,
+		      target_nid, MIGRATE_ASYNC, MR_DEMOTION,
+		      &nr_succeeded);
+
+	if (current_is_kswapd())
+		__count_vm_events(PGDEMOTE_KSWAPD, nr_succeeded);
+	else
+		__count_vm_events(PGDEMOTE_DIRECT, nr_succeeded);
+
+	return nr_succeeded;
+}
+
 /*
  * shrink_page_list() returns the number of reclaimed pages
  */
@@ -1125,12 +1196,16 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 {
 	LIST_HEAD(ret_pages);
 	LIST_HEAD(free_pages);
+	LIST_HEAD(demote_pages);
 	unsigned nr_reclaimed = 0;
 	unsigned pgactivate = 0;
+	bool do_demote_pass;
 
 	memset(stat, 0, sizeof(*stat));
 	cond_resched();
+	do_demote_pass = can_demote(pgdat->node_id);
 
+retry:
 	while (!list_empty(page_list)) {
 		struct address_space *mapping;
 		struct page *page;
@@ -1160,6 +1235,19 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 		if (!sc->may_unmap && page_mapped(page))
 			goto keep_locked;
 
+		/*
+		 * An anonymous page pinned for long-term DMA (e.g. an RDMA
+		 * buffer) cannot be freed while the pin is held: unmapping
+		 * and swapping it out would only generate IO and LRU churn
+		 * before the final free fails on the elevated refcount.
+		 * Activate it instead, so it stops cycling through the
+		 * inactive list.  page_maybe_dma_pinned() can report false
+		 * positives for heavily shared pages; rotating those to the
+		 * active list is harmless.
+		 */
+		if (PageAnon(page) && page_maybe_dma_pinned(page))
+			goto activate_locked;
+
 		may_enter_fs = (sc->gfp_mask & __GFP_FS) ||
 			(PageSwapCache(page) && (sc->gfp_mask & __GFP_IO));
 
@@ -1280,6 +1368,17 @@ static unsigned long shrink_page_list(struct list_head *page_list,
 			; /* try to reclaim the page below */
 		}
 
+		/*
+		 * Before reclaiming the page, try to relocate
+		 * its contents to another node.
+		 */
+		if (do_demote_pass &&
+		    (thp_migration_supported() || !PageTransHuge(page))) {
+			list_add(&page->lru, &demote_pages);
+			unlock_page(page);
+			continue;
+		}
+
 		/*
 		 * Anonymous process memory has backing store?
 		 * Try to allocate it some swap space here.
@@ -1520,6 +1619,17 @@ keep:
 		list_add(&page->lru, &ret_pages);
 		VM_BUG_ON_PAGE(PageLRU(page) || PageUnevictable(page), page);
 	}
+	/* 'page_list' is always empty here */
+
+	/* Migrate pages selected for demotion */
+	nr_reclaimed += demote_page_list(&demote_pages, pgdat);
+	/* Pages that could not be demoted are still in @demote_pages */
+	if (!list_empty(&demote_pages)) {
+		/* Pages which failed to migrate go back on @page_list */
+		list_splice_init(&demote_pages, page_list);
+		do_demote_pass = false;
+		goto retry;
+	}
 
 	pgactivate = stat->nr_activate[0] + stat->nr_activate[1];
 
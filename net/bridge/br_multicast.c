@@ -446,7 +446,7 @@ struct net_bridge_mdb_entry *br_multicast_new_group(struct net_bridge *br,
 	if (mp)
 		return mp;
 
-	if (atomic_read(&br->mdb_hash_tbl.nelems) >= br->hash_max) {
+	if (percpu_counter_sum_positive(&br->mdb_hash_tbl.nelems) >= br->hash_max) {
 		br_opt_toggle(br, BROPT_MULTICAST_ENABLED, false);
 		return ERR_PTR(-E2BIG);
 	}
@@ -206,6 +206,7 @@ struct sk_buff *__skb_try_recv_from_queue(struct sock *sk,
 	}
 	return NULL;
 }
+EXPORT_SYMBOL(__skb_try_recv_from_queue);
 
 /**
  *	__skb_try_recv_datagram - Receive a datagram skbuff
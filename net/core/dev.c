@@ -75,6 +75,7 @@
 #include <linux/types.h>
 #include <linux/kernel.h>
 #include <linux/hash.h>
+#include <linux/kthread.h>
 #include <linux/slab.h>
 #include <linux/sched.h>
 #include <linux/sched/mm.h>
@@ -3383,8 +3384,26 @@ static inline int __dev_xmit_skb(struct sk_buff *skb, struct Qdisc *q,
 	qdisc_calculate_pkt_len(skb, q);
 
 	if (q->flags & TCQ_F_NOLOCK) {
-		rc = q->enqueue(skb, q, &to_free) & NET_XMIT_MASK;
-		qdisc_run(q);
+		if ((q->flags & TCQ_F_CAN_BYPASS) && qdisc_is_empty(q) &&
+		    qdisc_run_begin(q)) {
+			if (unlikely(test_bit(__QDISC_STATE_DEACTIVATED,
+					      &q->state))) {
+				__qdisc_drop(skb, &to_free);
+				rc = NET_XMIT_DROP;
+				goto end_run;
+			}
+			qdisc_bstats_cpu_update(q, skb);
+
+			rc = NET_XMIT_SUCCESS;
+			if (sch_direct_xmit(skb, q, dev, txq, NULL, true))
+				__qdisc_run(q);
+
+end_run:
+			qdisc_run_end(q);
+		} else {
+			rc = q->enqueue(skb, q, &to_free) & NET_XMIT_MASK;
+			qdisc_run(q);
+		}
 
 		if (unlikely(to_free))
 			kfree_skb_list(to_free);
@@ -3875,6 +3894,22 @@ int gro_normal_batch __read_mostly = 8;
 static inline void ____napi_schedule(struct softnet_data *sd,
 				     struct napi_struct *napi)
 {
+	struct task_struct *thread;
+
+	if (test_bit(NAPI_STATE_THREADED, &napi->state)) {
+		/* Paired with smp_mb__before_atomic() in
+		 * napi_enable()/dev_set_threaded().
+		 * Use READ_ONCE() to guarantee a complete
+		 * read on napi->thread. Only call
+		 * wake_up_process() when it's not NULL.
+		 */
+		thread = READ_ONCE(napi->thread);
+		if (thread) {
+			wake_up_process(thread);
+			return;
+		}
+	}
+
 	list_add_tail(&napi->poll_list, &sd->poll_list);
 	__raise_softirq_irqoff(NET_RX_SOFTIRQ);
 }
@@ -3892,6 +3927,123 @@ EXPORT_SYMBOL(rps_needed);
 struct static_key_false rfs_needed __read_mostly;
 EXPORT_SYMBOL(rfs_needed);
 
+int rps_sock_flow_autosize __read_mostly;
+atomic_long_t rps_sock_flow_collisions;
+EXPORT_SYMBOL(rps_sock_flow_collisions);
+
+/* Collision count when the table was last (re)sized, used to throttle
+ * autosizing: we only grow again after seeing mask/4 fresh collisions.
+ */
+static long rps_sock_flow_resized_at;
+
+/* Autosizing stops doubling here; beyond this, collisions indicate hash
+ * quality problems rather than table pressure (1M entries is 4MB).
+ */
+#define RPS_SOCK_FLOW_AUTOSIZE_MAX	(1 << 20)
+
+static DEFINE_MUTEX(rps_sock_flow_mutex);
+
+/* Install a global sock flow table of @size entries (rounded up to a power
+ * of two), flushing all recorded flows.  @size of zero removes the table.
+ * Serializes the sysctl writer against the autosize worker.
+ */
+int rps_sock_flow_table_set(unsigned int size)
+{
+	struct rps_sock_flow_table *orig_sock_table, *sock_table;
+	unsigned int i;
+
+	if (size > 1 << 29)
+		/* Enforce limit to prevent overflow */
+		return -EINVAL;
+
+	mutex_lock(&rps_sock_flow_mutex);
+
+	orig_sock_table = rcu_dereference_protected(rps_sock_flow_table,
+					lockdep_is_held(&rps_sock_flow_mutex));
+
+	if (size) {
+		size = roundup_pow_of_two(size);
+		if (orig_sock_table && size == orig_sock_table->mask + 1) {
+			sock_table = orig_sock_table;
+		} else {
+			sock_table = vmalloc(RPS_SOCK_FLOW_TABLE_SIZE(size));
+			if (!sock_table) {
+				mutex_unlock(&rps_sock_flow_mutex);
+				return -ENOMEM;
+			}
+			rps_cpu_mask = roundup_pow_of_two(nr_cpu_ids) - 1;
+			sock_table->mask = size - 1;
+		}
+
+		for (i = 0; i < size; i++)
+			sock_table->ents[i] = RPS_NO_CPU;
+	} else {
+		sock_table = NULL;
+	}
+
+	if (sock_table != orig_sock_table) {
+		rcu_assign_pointer(rps_sock_flow_table, sock_table);
+		if (sock_table) {
+			static_branch_inc(&rps_needed);
+			static_branch_inc(&rfs_needed);
+		}
+		if (orig_sock_table) {
+			static_branch_dec(&rps_needed);
+			static_branch_dec(&rfs_needed);
+			synchronize_rcu();
+			vfree(orig_sock_table);
+		}
+	}
+
+	WRITE_ONCE(rps_sock_flow_resized_at,
+		   atomic_long_read(&rps_sock_flow_collisions));
+
+	mutex_unlock(&rps_sock_flow_mutex);
+
+	return 0;
+}
+
+static void rps_sock_flow_resize(struct work_struct *work)
+{
+	struct rps_sock_flow_table *sock_table;
+	unsigned int size = 0;
+
+	rcu_read_lock();
+	sock_table = rcu_dereference(rps_sock_flow_table);
+	if (sock_table)
+		size = (sock_table->mask + 1) << 1;
+	rcu_read_unlock();
+
+	/* Racing with a sysctl writer or autosize being switched off just
+	 * means we might size from a stale snapshot; rps_sock_flow_table_set
+	 * serializes the actual swap.
+	 */
+	if (size && size <= RPS_SOCK_FLOW_AUTOSIZE_MAX &&
+	    READ_ONCE(rps_sock_flow_autosize))
+		rps_sock_flow_table_set(size);
+}
+
+static DECLARE_WORK(rps_sock_flow_resize_work, rps_sock_flow_resize);
+
+/* Called from rps_record_sock_flow() when a live entry for a different flow
+ * hash is overwritten.  Collisions silently degrade accelerated RFS back to
+ * hashed RPS, so beyond counting them we optionally grow the table once a
+ * quarter of it has been clobbered since the last resize.
+ */
+void rps_sock_flow_collision(const struct rps_sock_flow_table *table)
+{
+	long collisions = atomic_long_inc_return(&rps_sock_flow_collisions);
+
+	if (!READ_ONCE(rps_sock_flow_autosize))
+		return;
+	if (table->mask + 1 >= RPS_SOCK_FLOW_AUTOSIZE_MAX)
+		return;
+	if (collisions - READ_ONCE(rps_sock_flow_resized_at) >
+	    (long)(table->mask >> 2))
+		schedule_work(&rps_sock_flow_resize_work);
+}
+EXPORT_SYMBOL(rps_sock_flow_collision);
+
 static struct rps_dev_flow *
 set_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 	    struct rps_dev_flow *rflow, u16 next_cpu)
@@ -3984,10 +4136,17 @@ static int get_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 		u32 next_cpu;
 		u32 ident;
 
-		/* First check into global flow table if there is a match */
+		/* First check into global flow table if there is a match.
+		 * A miss here means the flow was never recorded or its
+		 * entry was clobbered by a hash collision; either way we
+		 * fall back to hashed RPS, so count it per queue to make
+		 * an undersized table visible.
+		 */
 		ident = sock_flow_table->ents[hash & sock_flow_table->mask];
-		if ((ident ^ hash) & ~rps_cpu_mask)
+		if ((ident ^ hash) & ~rps_cpu_mask) {
+			atomic_long_inc(&rxqueue->rps_flow_misses);
 			goto try_rps;
+		}
 
 		next_cpu = ident & rps_cpu_mask;
 
@@ -4017,6 +4176,7 @@ static int get_rps_cpu(struct net_device *dev, struct sk_buff *skb,
 		}
 
 		if (tcpu < nr_cpu_ids && cpu_online(tcpu)) {
+			atomic_long_inc(&rxqueue->rps_flow_hits);
 			*rflowp = rflow;
 			cpu = tcpu;
 			goto done;
@@ -5958,9 +6118,42 @@ void __napi_schedule_irqoff(struct napi_struct *n)
 }
 EXPORT_SYMBOL(__napi_schedule_irqoff);
 
+/* Pick how long a completed NAPI instance may hold partially assembled
+ * GRO packets.  With adaptive flush enabled, hold only as long as a full
+ * GRO batch can plausibly be assembled within the configured timeout;
+ * holding longer than that adds latency without improving batching.  The
+ * per-packet cost estimate is an EWMA fed from the time between polls.
+ */
+static unsigned long napi_gro_hold_ns(struct napi_struct *n, int work_done)
+{
+	unsigned long timeout = READ_ONCE(n->dev->gro_flush_timeout);
+	u64 now, sample, est;
+
+	if (!timeout || !READ_ONCE(n->dev->gro_adaptive_flush))
+		return timeout;
+
+	now = ktime_get_ns();
+	if (n->gro_last_done) {
+		/* Bound the sample so one long idle gap does not dominate
+		 * the average.
+		 */
+		sample = min_t(u64, div_u64(now - n->gro_last_done, work_done),
+			       2 * (u64)timeout);
+		n->gro_ns_per_pkt += (sample >> 2) - (n->gro_ns_per_pkt >> 2);
+	}
+	n->gro_last_done = now;
+
+	est = n->gro_ns_per_pkt * (MAX_GRO_SKBS - 1);
+	if (est > timeout)
+		return 0;
+	return est;
+}
+
 bool napi_complete_done(struct napi_struct *n, int work_done)
 {
 	unsigned long flags, val, new;
+	unsigned long timeout = 0;
+	bool ret = true;
 
 	/*
 	 * 1) Don't let napi dequeue from the cpu poll list
@@ -5972,24 +6165,32 @@ bool napi_complete_done(struct napi_struct *n, int work_done)
 				 NAPIF_STATE_IN_BUSY_POLL)))
 		return false;
 
+	if (work_done) {
+		if (n->gro_bitmask)
+			timeout = napi_gro_hold_ns(n, work_done);
+		n->defer_hard_irqs_count =
+			READ_ONCE(n->dev->napi_defer_hard_irqs);
+	}
+	if (n->defer_hard_irqs_count > 0) {
+		n->defer_hard_irqs_count--;
+		timeout = READ_ONCE(n->dev->gro_flush_timeout);
+		if (timeout)
+			ret = false;
+	}
 	if (n->gro_bitmask) {
-		unsigned long timeout = 0;
-
-		if (work_done)
-			timeout = n->dev->gro_flush_timeout;
-
 		/* When the NAPI instance uses a timeout and keeps postponing
 		 * it, we need to bound somehow the time packets are kept in
 		 * the GRO layer
 		 */
 		napi_gro_flush(n, !!timeout);
-		if (timeout)
-			hrtimer_start(&n->timer, ns_to_ktime(timeout),
-				      HRTIMER_MODE_REL_PINNED);
 	}
 
 	gro_normal_list(n);
 
+	if (timeout)
+		hrtimer_start(&n->timer, ns_to_ktime(timeout),
+			      HRTIMER_MODE_REL_PINNED);
+
 	if (unlikely(!list_empty(&n->poll_list))) {
 		/* If n->poll_list is not empty, we need to mask irqs */
 		local_irq_save(flags);
@@ -6017,7 +6218,7 @@ bool napi_complete_done(struct napi_struct *n, int work_done)
 		return false;
 	}
 
-	return true;
+	return ret;
 }
 EXPORT_SYMBOL(napi_complete_done);
 
@@ -6036,9 +6237,8 @@ static struct napi_struct *napi_by_id(unsigned int napi_id)
 
 #if defined(CONFIG_NET_RX_BUSY_POLL)
 
-#define BUSY_POLL_BUDGET 8
-
-static void busy_poll_stop(struct napi_struct *napi, void *have_poll_lock)
+static void busy_poll_stop(struct napi_struct *napi, void *have_poll_lock,
+			   u16 budget)
 {
 	int rc;
 
@@ -6059,14 +6259,14 @@ static void busy_poll_stop(struct napi_struct *napi, void *have_poll_lock)
 	/* All we really want here is to re-enable device interrupts.
 	 * Ideally, a new ndo_busy_poll_stop() could avoid another round.
 	 */
-	rc = napi->poll(napi, BUSY_POLL_BUDGET);
+	rc = napi->poll(napi, budget);
 	/* We can't gro_normal_list() here, because napi->poll() might have
 	 * rearmed the napi (napi_complete_done()) in which case it could
 	 * already be running on another CPU.
 	 */
-	trace_napi_poll(napi, rc, BUSY_POLL_BUDGET);
+	trace_napi_poll(napi, rc, budget);
 	netpoll_poll_unlock(have_poll_lock);
-	if (rc == BUSY_POLL_BUDGET) {
+	if (rc == budget) {
 		/* As the whole budget was spent, we still own the napi so can
 		 * safely handle the rx_list.
 		 */
@@ -6078,7 +6278,7 @@ static void busy_poll_stop(struct napi_struct *napi, void *have_poll_lock)
 
 void napi_busy_loop(unsigned int napi_id,
 		    bool (*loop_end)(void *, unsigned long),
-		    void *loop_end_arg)
+		    void *loop_end_arg, u16 budget)
 {
 	unsigned long start_time = loop_end ? busy_loop_current_time() : 0;
 	int (*napi_poll)(struct napi_struct *napi, int budget);
@@ -6115,8 +6315,8 @@ restart:
 			have_poll_lock = netpoll_poll_lock(napi);
 			napi_poll = napi->poll;
 		}
-		work = napi_poll(napi, BUSY_POLL_BUDGET);
-		trace_napi_poll(napi, work, BUSY_POLL_BUDGET);
+		work = napi_poll(napi, budget);
+		trace_napi_poll(napi, work, budget);
 		gro_normal_list(napi);
 count:
 		if (work > 0)
@@ -6129,7 +6329,7 @@ count:
 
 		if (unlikely(need_resched())) {
 			if (napi_poll)
-				busy_poll_stop(napi, have_poll_lock);
+				busy_poll_stop(napi, have_poll_lock, budget);
 			preempt_enable();
 			rcu_read_unlock();
 			cond_resched();
@@ -6140,7 +6340,7 @@ count:
 		cpu_relax();
 	}
 	if (napi_poll)
-		busy_poll_stop(napi, have_poll_lock);
+		busy_poll_stop(napi, have_poll_lock, budget);
 	preempt_enable();
 out:
 	rcu_read_unlock();
@@ -6196,8 +6396,10 @@ static enum hrtimer_restart napi_watchdog(struct hrtimer *timer)
 
 	/* Note : we use a relaxed variant of napi_schedule_prep() not setting
 	 * NAPI_STATE_MISSED, since we do not react to a device IRQ.
+	 * The NAPI instance must be rescheduled even with an empty GRO list,
+	 * otherwise a deferred hard irq would never be re-enabled.
 	 */
-	if (napi->gro_bitmask && !napi_disable_pending(napi) &&
+	if (!napi_disable_pending(napi) &&
 	    !test_and_set_bit(NAPI_STATE_SCHED, &napi->state))
 		__napi_schedule_irqoff(napi);
 
@@ -6215,6 +6417,71 @@ static void init_gro_hash(struct napi_struct *napi)
 	napi->gro_bitmask = 0;
 }
 
+static int napi_threaded_poll(void *data);
+
+static int napi_kthread_create(struct napi_struct *n)
+{
+	int err = 0;
+
+	/* Create and wake up the kthread once to put it in
+	 * TASK_INTERRUPTIBLE mode to avoid the blocked task
+	 * warning and work with loadavg.
+	 */
+	n->thread = kthread_run(napi_threaded_poll, n, "napi/%s-%d",
+				n->dev->name, n->napi_id);
+	if (IS_ERR(n->thread)) {
+		err = PTR_ERR(n->thread);
+		pr_err("kthread_run failed with err %d\n", err);
+		n->thread = NULL;
+	}
+
+	return err;
+}
+
+int dev_set_threaded(struct net_device *dev, bool threaded)
+{
+	struct napi_struct *napi;
+	int err = 0;
+
+	ASSERT_RTNL();
+
+	if (dev->threaded == threaded)
+		return 0;
+
+	if (threaded) {
+		list_for_each_entry(napi, &dev->napi_list, dev_list) {
+			if (!napi->thread) {
+				err = napi_kthread_create(napi);
+				if (err) {
+					threaded = false;
+					break;
+				}
+			}
+		}
+	}
+
+	dev->threaded = threaded;
+
+	/* Make sure kthread is created before THREADED bit is set. */
+	smp_mb__before_atomic();
+
+	/* Setting/unsetting threaded mode on a napi might not immediately
+	 * take effect, if the current napi instance is actively being
+	 * polled. In this case, the switch between threaded mode and
+	 * softirq mode will happen in the next round of napi_schedule().
+	 * This should not cause hiccups/stalls to the live traffic.
+	 */
+	list_for_each_entry(napi, &dev->napi_list, dev_list) {
+		if (threaded)
+			set_bit(NAPI_STATE_THREADED, &napi->state);
+		else
+			clear_bit(NAPI_STATE_THREADED, &napi->state);
+	}
+
+	return err;
+}
+EXPORT_SYMBOL(dev_set_threaded);
+
 void netif_napi_add(struct net_device *dev, struct napi_struct *napi,
 		    int (*poll)(struct napi_struct *, int), int weight)
 {
@@ -6225,6 +6492,9 @@ void netif_napi_add(struct net_device *dev, struct napi_struct *napi,
 	napi->skb = NULL;
 	INIT_LIST_HEAD(&napi->rx_list);
 	napi->rx_count = 0;
+	napi->defer_hard_irqs_count = 0;
+	napi->gro_ns_per_pkt = 0;
+	napi->gro_last_done = 0;
 	napi->poll = poll;
 	if (weight > NAPI_POLL_WEIGHT)
 		netdev_err_once(dev, "%s() called with weight %d\n", __func__,
@@ -6237,6 +6507,13 @@ void netif_napi_add(struct net_device *dev, struct napi_struct *napi,
 #endif
 	set_bit(NAPI_STATE_SCHED, &napi->state);
 	napi_hash_add(napi);
+	napi->thread = NULL;
+	/* Create kthread for this napi if dev->threaded is set.
+	 * Clear dev->threaded if kthread creation failed so that
+	 * threaded mode will not be enabled in napi_enable().
+	 */
+	if (dev->threaded && napi_kthread_create(napi))
+		dev->threaded = 0;
 }
 EXPORT_SYMBOL(netif_napi_add);
 
@@ -6280,18 +6557,18 @@ void netif_napi_del(struct napi_struct *napi)
 
 	flush_gro_hash(napi);
 	napi->gro_bitmask = 0;
+
+	if (napi->thread) {
+		kthread_stop(napi->thread);
+		napi->thread = NULL;
+	}
 }
 EXPORT_SYMBOL(netif_napi_del);
 
-static int napi_poll(struct napi_struct *n, struct list_head *repoll)
+static int __napi_poll(struct napi_struct *n, bool *repoll)
 {
-	void *have;
 	int work, weight;
 
-	list_del_init(&n->poll_list);
-
-	have = netpoll_poll_lock(n);
-
 	weight = n->weight;
 
 	/* This NAPI_STATE_SCHED test is for avoiding a race
@@ -6309,7 +6586,7 @@ static int napi_poll(struct napi_struct *n, struct list_head *repoll)
 	WARN_ON_ONCE(work > weight);
 
 	if (likely(work < weight))
-		goto out_unlock;
+		return work;
 
 	/* Drivers must not modify the NAPI state if they
 	 * consume the entire weight.  In such cases this code
@@ -6318,7 +6595,7 @@ static int napi_poll(struct napi_struct *n, struct list_head *repoll)
 	 */
 	if (unlikely(napi_disable_pending(n))) {
 		napi_complete(n);
-		goto out_unlock;
+		return work;
 	}
 
 	if (n->gro_bitmask) {
@@ -6336,17 +6613,78 @@ static int napi_poll(struct napi_struct *n, struct list_head *repoll)
 	if (unlikely(!list_empty(&n->poll_list))) {
 		pr_warn_once("%s: Budget exhausted after napi rescheduled\n",
 			     n->dev ? n->dev->name : "backlog");
-		goto out_unlock;
+		return work;
 	}
 
-	list_add_tail(&n->poll_list, repoll);
+	*repoll = true;
+
+	return work;
+}
+
+static int napi_poll(struct napi_struct *n, struct list_head *repoll)
+{
+	bool do_repoll = false;
+	void *have;
+	int work;
+
+	list_del_init(&n->poll_list);
+
+	have = netpoll_poll_lock(n);
+
+	work = __napi_poll(n, &do_repoll);
+
+	if (do_repoll)
+		list_add_tail(&n->poll_list, repoll);
 
-out_unlock:
 	netpoll_poll_unlock(have);
 
 	return work;
 }
 
+static int napi_thread_wait(struct napi_struct *napi)
+{
+	set_current_state(TASK_INTERRUPTIBLE);
+
+	while (!kthread_should_stop() && !napi_disable_pending(napi)) {
+		if (test_bit(NAPI_STATE_SCHED, &napi->state)) {
+			__set_current_state(TASK_RUNNING);
+			return 0;
+		}
+
+		schedule();
+		set_current_state(TASK_INTERRUPTIBLE);
+	}
+	__set_current_state(TASK_RUNNING);
+
+	return -1;
+}
+
+static int napi_threaded_poll(void *data)
+{
+	struct napi_struct *napi = data;
+	void *have;
+
+	while (!napi_thread_wait(napi)) {
+		for (;;) {
+			bool repoll = false;
+
+			local_bh_disable();
+
+			have = netpoll_poll_lock(napi);
+			__napi_poll(napi, &repoll);
+			netpoll_poll_unlock(have);
+
+			local_bh_enable();
+
+			if (!repoll)
+				break;
+
+			cond_resched();
+		}
+	}
+	return 0;
+}
+
 static __latent_entropy void net_rx_action(struct softirq_action *h)
 {
 	struct softnet_data *sd = this_cpu_ptr(&softnet_data);
@@ -51,6 +51,13 @@ do {						\
 
 #define PNEIGH_HASHMASK		0xF
 
+/* Upper bound on the time the periodic gc may hold off writers on
+ * tbl->lock in one go.  Once exceeded, the walk records its position
+ * and reschedules itself, so that arp/ndisc updates and the slow
+ * output path never wait for a full hash table scan.
+ */
+#define NEIGH_GC_SCAN_BUDGET	msecs_to_jiffies(10)
+
 static void neigh_timer_handler(struct timer_list *t);
 static void __neigh_notify(struct neighbour *n, int type, int flags,
 			   u32 pid);
@@ -887,11 +894,14 @@ static void neigh_periodic_work(struct work_struct *work)
 	struct neigh_table *tbl = container_of(work, struct neigh_table, gc_work.work);
 	struct neighbour *n;
 	struct neighbour __rcu **np;
+	unsigned long end_time;
 	unsigned int i;
 	struct neigh_hash_table *nht;
 
 	NEIGH_CACHE_STAT_INC(tbl, periodic_gc_runs);
 
+	end_time = jiffies + NEIGH_GC_SCAN_BUDGET;
+
 	write_lock_bh(&tbl->lock);
 	nht = rcu_dereference_protected(tbl->nht,
 					lockdep_is_held(&tbl->lock));
@@ -911,7 +921,7 @@ static void neigh_periodic_work(struct work_struct *work)
 	if (atomic_read(&tbl->entries) < tbl->gc_thresh1)
 		goto out;
 
-	for (i = 0 ; i < (1 << nht->hash_shift); i++) {
+	for (i = tbl->gc_bucket; i < (1 << nht->hash_shift); i++) {
 		np = &nht->hash_buckets[i];
 
 		while ((n = rcu_dereference_protected(*np,
@@ -944,6 +954,18 @@ static void neigh_periodic_work(struct work_struct *work)
 next_elt:
 			np = &n->next;
 		}
+		/* Scan budget exhausted: remember where we stopped and
+		 * resume from there in a fresh work slice, so that the
+		 * lock is never monopolized for a whole table walk.
+		 */
+		if (time_after_eq(jiffies, end_time) &&
+		    i + 1 < (1 << nht->hash_shift)) {
+			tbl->gc_bucket = i + 1;
+			write_unlock_bh(&tbl->lock);
+			queue_delayed_work(system_power_efficient_wq,
+					   &tbl->gc_work, 0);
+			return;
+		}
 		/*
 		 * It's fine to release lock here, even if hash table
 		 * grows while we are preempted.
@@ -955,6 +977,7 @@ next_elt:
 						lockdep_is_held(&tbl->lock));
 	}
 out:
+	tbl->gc_bucket = 0;
 	/* Cycle through all hash buckets every BASE_REACHABLE_TIME/2 ticks.
 	 * ARP entry timeouts range from 1/2 BASE_REACHABLE_TIME to 3/2
 	 * BASE_REACHABLE_TIME.
@@ -353,6 +353,25 @@ static ssize_t tx_queue_len_store(struct device *dev,
 }
 NETDEVICE_SHOW_RW(tx_queue_len, fmt_dec);
 
+static int change_napi_threaded(struct net_device *dev, unsigned long val)
+{
+	if (val != 0 && val != 1)
+		return -EINVAL;
+
+	return dev_set_threaded(dev, !!val);
+}
+
+static ssize_t threaded_store(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t len)
+{
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	return netdev_store(dev, attr, buf, len, change_napi_threaded);
+}
+NETDEVICE_SHOW_RW(threaded, fmt_dec);
+
 static int change_gro_flush_timeout(struct net_device *dev, unsigned long val)
 {
 	dev->gro_flush_timeout = val;
@@ -370,6 +389,45 @@ static ssize_t gro_flush_timeout_store(struct device *dev,
 }
 NETDEVICE_SHOW_RW(gro_flush_timeout, fmt_ulong);
 
+static int change_napi_defer_hard_irqs(struct net_device *dev,
+				       unsigned long val)
+{
+	if (val > S32_MAX)
+		return -ERANGE;
+
+	dev->napi_defer_hard_irqs = val;
+	return 0;
+}
+
+static ssize_t napi_defer_hard_irqs_store(struct device *dev,
+					  struct device_attribute *attr,
+					  const char *buf, size_t len)
+{
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	return netdev_store(dev, attr, buf, len, change_napi_defer_hard_irqs);
+}
+NETDEVICE_SHOW_RW(napi_defer_hard_irqs, fmt_dec);
+
+static int change_gro_adaptive_flush(struct net_device *dev,
+				     unsigned long val)
+{
+	dev->gro_adaptive_flush = !!val;
+	return 0;
+}
+
+static ssize_t gro_adaptive_flush_store(struct device *dev,
+					struct device_attribute *attr,
+					const char *buf, size_t len)
+{
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	return netdev_store(dev, attr, buf, len, change_gro_adaptive_flush);
+}
+NETDEVICE_SHOW_RW(gro_adaptive_flush, fmt_dec);
+
 static ssize_t ifalias_store(struct device *dev, struct device_attribute *attr,
 			     const char *buf, size_t len)
 {
@@ -532,6 +590,9 @@ static struct attribute *net_class_attrs[] __ro_after_init = {
 	&dev_attr_flags.attr,
 	&dev_attr_tx_queue_len.attr,
 	&dev_attr_gro_flush_timeout.attr,
+	&dev_attr_napi_defer_hard_irqs.attr,
+	&dev_attr_gro_adaptive_flush.attr,
+	&dev_attr_threaded.attr,
 	&dev_attr_phys_port_id.attr,
 	&dev_attr_phys_port_name.attr,
 	&dev_attr_phys_switch_id.attr,
@@ -844,19 +905,102 @@ static ssize_t store_rps_dev_flow_table_cnt(struct netdev_rx_queue *queue,
 	return len;
 }
 
+static ssize_t show_rps_flow_hits(struct netdev_rx_queue *queue, char *buf)
+{
+	return sprintf(buf, "%lu\n",
+		       (unsigned long)atomic_long_read(&queue->rps_flow_hits));
+}
+
+static ssize_t show_rps_flow_misses(struct netdev_rx_queue *queue, char *buf)
+{
+	return sprintf(buf, "%lu\n",
+		       (unsigned long)atomic_long_read(&queue->rps_flow_misses));
+}
+
 static struct rx_queue_attribute rps_cpus_attribute __ro_after_init
 	= __ATTR(rps_cpus, 0644, show_rps_map, store_rps_map);
 
 static struct rx_queue_attribute rps_dev_flow_table_cnt_attribute __ro_after_init
 	= __ATTR(rps_flow_cnt, 0644,
 		 show_rps_dev_flow_table_cnt, store_rps_dev_flow_table_cnt);
+
+static struct rx_queue_attribute rps_flow_hits_attribute __ro_after_init
+	= __ATTR(rps_flow_hits, 0444, show_rps_flow_hits, NULL);
+
+static struct rx_queue_attribute rps_flow_misses_attribute __ro_after_init
+	= __ATTR(rps_flow_misses, 0444, show_rps_flow_misses, NULL);
 #endif /* CONFIG_RPS */
 
+static ssize_t show_payload_pool_order(struct netdev_rx_queue *queue,
+				       char *buf)
+{
+	return sprintf(buf, "%u\n", queue->payload_pool_order);
+}
+
+static ssize_t store_payload_pool_order(struct netdev_rx_queue *queue,
+					const char *buf, size_t len)
+{
+	unsigned int order;
+	int rc;
+
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	rc = kstrtouint(buf, 0, &order);
+	if (rc < 0)
+		return rc;
+
+	if (order >= MAX_ORDER)
+		return -EINVAL;
+
+	/* A hint only: the driver picks it up the next time it rebuilds
+	 * this queue's buffer pool (typically on the next ifup or ring
+	 * reconfiguration).
+	 */
+	queue->payload_pool_order = order;
+
+	return len;
+}
+
+static ssize_t show_header_split(struct netdev_rx_queue *queue, char *buf)
+{
+	return sprintf(buf, "%u\n", queue->header_split);
+}
+
+static ssize_t store_header_split(struct netdev_rx_queue *queue,
+				  const char *buf, size_t len)
+{
+	bool split;
+	int rc;
+
+	if (!capable(CAP_NET_ADMIN))
+		return -EPERM;
+
+	rc = kstrtobool(buf, &split);
+	if (rc < 0)
+		return rc;
+
+	queue->header_split = split;
+
+	return len;
+}
+
+static struct rx_queue_attribute payload_pool_order_attribute __ro_after_init
+	= __ATTR(payload_pool_order, 0644,
+		 show_payload_pool_order, store_payload_pool_order);
+
+static struct rx_queue_attribute header_split_attribute __ro_after_init
+	= __ATTR(header_split, 0644, show_header_split, store_header_split);
+
 static struct attribute *rx_queue_default_attrs[] __ro_after_init = {
 #ifdef CONFIG_RPS
 	&rps_cpus_attribute.attr,
 	&rps_dev_flow_table_cnt_attribute.attr,
+	&rps_flow_hits_attribute.attr,
+	&rps_flow_misses_attribute.attr,
 #endif
+	&payload_pool_order_attribute.attr,
+	&header_split_attribute.attr,
 	NULL
 };
 ATTRIBUTE_GROUPS(rx_queue_default);
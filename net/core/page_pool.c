@@ -117,33 +117,12 @@ static struct page *__page_pool_get_cached(struct page_pool *pool)
 
 /* slow path */
 noinline
-static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
-						 gfp_t _gfp)
+static bool page_pool_dma_map(struct page_pool *pool, struct page *page)
 {
-	struct page *page;
-	gfp_t gfp = _gfp;
 	dma_addr_t dma;
 
-	/* We could always set __GFP_COMP, and avoid this branch, as
-	 * prep_new_page() can handle order-0 with __GFP_COMP.
-	 */
-	if (pool->p.order)
-		gfp |= __GFP_COMP;
-
-	/* FUTURE development:
-	 *
-	 * Current slow-path essentially falls back to single page
-	 * allocations, which doesn't improve performance.  This code
-	 * need bulk allocation support from the page allocator code.
-	 */
-
-	/* Cache was empty, do real allocation */
-	page = alloc_pages_node(pool->p.nid, gfp, pool->p.order);
-	if (!page)
-		return NULL;
-
 	if (!(pool->p.flags & PP_FLAG_DMA_MAP))
-		goto skip_dma_map;
+		return true;
 
 	/* Setup DMA mapping: use 'struct page' area for storing DMA-addr
 	 * since dma_addr_t can be either 32 or 64 bits and does not always fit
@@ -153,17 +132,75 @@ static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
 	dma = dma_map_page_attrs(pool->p.dev, page, 0,
 				 (PAGE_SIZE << pool->p.order),
 				 pool->p.dma_dir, DMA_ATTR_SKIP_CPU_SYNC);
-	if (dma_mapping_error(pool->p.dev, dma)) {
+	if (dma_mapping_error(pool->p.dev, dma))
+		return false;
+
+	page->dma_addr = dma;
+	return true;
+}
+
+static struct page *__page_pool_alloc_page_order(struct page_pool *pool,
+						 gfp_t gfp)
+{
+	struct page *page;
+
+	gfp |= __GFP_COMP;
+	page = alloc_pages_node(pool->p.nid, gfp, pool->p.order);
+	if (unlikely(!page))
+		return NULL;
+
+	if (!page_pool_dma_map(pool, page)) {
 		put_page(page);
 		return NULL;
 	}
-	page->dma_addr = dma;
 
-skip_dma_map:
 	/* Track how many pages are held 'in-flight' */
 	pool->pages_state_hold_cnt++;
-
 	trace_page_pool_state_hold(pool, page, pool->pages_state_hold_cnt);
+	return page;
+}
+
+static struct page *__page_pool_alloc_pages_slow(struct page_pool *pool,
+						 gfp_t gfp)
+{
+	const int bulk = PP_ALLOC_CACHE_REFILL;
+	struct page *page, *next;
+	LIST_HEAD(page_list);
+	int nid = pool->p.nid;
+
+	if (pool->p.order)
+		return __page_pool_alloc_page_order(pool, gfp);
+
+	if (nid == NUMA_NO_NODE)
+		nid = numa_mem_id();
+
+	/* Refill the alloc cache with one trip into the page allocator
+	 * instead of falling back to single page allocations. The slow
+	 * path only runs from the pool owner's (NAPI) context, so the
+	 * alloc cache can be filled without further protection.
+	 */
+	if (unlikely(!__alloc_pages_bulk(gfp, nid, NULL, bulk, &page_list)))
+		return NULL;
+
+	list_for_each_entry_safe(page, next, &page_list, lru) {
+		list_del(&page->lru);
+		if (!page_pool_dma_map(pool, page)) {
+			put_page(page);
+			continue;
+		}
+
+		/* Track how many pages are held 'in-flight' */
+		pool->pages_state_hold_cnt++;
+		trace_page_pool_state_hold(pool, page,
+					   pool->pages_state_hold_cnt);
+		pool->alloc.cache[pool->alloc.count++] = page;
+	}
+
+	/* Return the first page, leave the rest for the fast path */
+	if (likely(pool->alloc.count))
+		page = pool->alloc.cache[--pool->alloc.count];
+	else
+		page = NULL;
 
 	/* When page just alloc'ed is should/must have refcnt 1. */
 	return page;
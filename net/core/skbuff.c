@@ -58,6 +58,7 @@
 #include <linux/scatterlist.h>
 #include <linux/errqueue.h>
 #include <linux/prefetch.h>
+#include <linux/kasan.h>
 #include <linux/if_vlan.h>
 #include <linux/mpls.h>
 
@@ -358,6 +359,8 @@ struct sk_buff *build_skb_around(struct sk_buff *skb,
 EXPORT_SYMBOL(build_skb_around);
 
 #define NAPI_SKB_CACHE_SIZE	64
+#define NAPI_SKB_CACHE_BULK	16
+#define NAPI_SKB_CACHE_HALF	(NAPI_SKB_CACHE_SIZE / 2)
 
 struct napi_alloc_cache {
 	struct page_frag_cache page;
@@ -480,6 +483,30 @@ skb_fail:
 }
 EXPORT_SYMBOL(__netdev_alloc_skb);
 
+/* Pull an sk_buff head from the softirq-local cache, refilling it with a
+ * slab bulk allocation when empty.  Heads recycled by napi_consume_skb()
+ * on the tx side are thereby reused for rx on the same CPU without a
+ * slab round-trip.
+ */
+static struct sk_buff *napi_skb_cache_get(void)
+{
+	struct napi_alloc_cache *nc = this_cpu_ptr(&napi_alloc_cache);
+	struct sk_buff *skb;
+
+	if (unlikely(!nc->skb_count))
+		nc->skb_count = kmem_cache_alloc_bulk(skbuff_head_cache,
+						      GFP_ATOMIC,
+						      NAPI_SKB_CACHE_BULK,
+						      nc->skb_cache);
+	if (unlikely(!nc->skb_count))
+		return NULL;
+
+	skb = nc->skb_cache[--nc->skb_count];
+	kasan_unpoison_object_data(skbuff_head_cache, skb);
+
+	return skb;
+}
+
 /**
  *	__napi_alloc_skb - allocate skbuff for rx in a specific NAPI instance
  *	@napi: napi instance this buffer was allocated for
@@ -520,12 +547,15 @@ struct sk_buff *__napi_alloc_skb(struct napi_struct *napi, unsigned int len,
 	if (unlikely(!data))
 		return NULL;
 
-	skb = __build_skb(data, len);
+	skb = napi_skb_cache_get();
 	if (unlikely(!skb)) {
 		skb_free_frag(data);
 		return NULL;
 	}
 
+	memset(skb, 0, offsetof(struct sk_buff, tail));
+	__build_skb_around(skb, data, len);
+
 	/* use OR instead of assignment to avoid clearing of bits in mask */
 	if (nc->page.pfmemalloc)
 		skb->pfmemalloc = 1;
@@ -540,6 +570,51 @@ skb_fail:
 }
 EXPORT_SYMBOL(__napi_alloc_skb);
 
+/**
+ *	napi_skb_header_split - build an skb with headers split off a page
+ *	@napi: napi instance the packet was received on
+ *	@page: page holding the received packet
+ *	@offset: offset of the packet data within @page
+ *	@len: length of the packet data
+ *	@hlen: number of header bytes to copy into the linear area
+ *	@truesize: true size accounting for the page when attached as a frag
+ *
+ *	Allocate a small header skb from the NAPI caches, copy up to @hlen
+ *	bytes of headers into its linear area and attach the remaining
+ *	payload as a page fragment.  This lets drivers keep packet headers
+ *	in slab while steering payload to a separate page provider (e.g. a
+ *	huge-page backed page_pool) for zerocopy receive.
+ *
+ *	If the whole packet fits in @hlen it is copied in full and @page is
+ *	NOT consumed: the caller may recycle it into its pool.  Otherwise a
+ *	reference to @page is taken over by the skb.  The caller can tell
+ *	the two cases apart from skb_shinfo(skb)->nr_frags.
+ *
+ *	%NULL is returned if there is no free memory; @page is not consumed.
+ */
+struct sk_buff *napi_skb_header_split(struct napi_struct *napi,
+				      struct page *page, unsigned int offset,
+				      unsigned int len, unsigned int hlen,
+				      unsigned int truesize)
+{
+	struct sk_buff *skb;
+
+	if (hlen > len)
+		hlen = len;
+
+	skb = napi_alloc_skb(napi, hlen);
+	if (unlikely(!skb))
+		return NULL;
+
+	skb_put_data(skb, page_address(page) + offset, hlen);
+	if (len > hlen)
+		skb_add_rx_frag(skb, 0, page, offset + hlen, len - hlen,
+				truesize);
+
+	return skb;
+}
+EXPORT_SYMBOL(napi_skb_header_split);
+
 void skb_add_rx_frag(struct sk_buff *skb, int i, struct page *page, int off,
 		     int size, unsigned int truesize)
 {
@@ -859,6 +934,12 @@ void __kfree_skb_flush(void)
 
 	/* flush skb_cache if containing objects */
 	if (nc->skb_count) {
+		unsigned int i;
+
+		for (i = 0; i < nc->skb_count; i++)
+			kasan_unpoison_object_data(skbuff_head_cache,
+						   nc->skb_cache[i]);
+
 		kmem_cache_free_bulk(skbuff_head_cache, nc->skb_count,
 				     nc->skb_cache);
 		nc->skb_count = 0;
@@ -873,18 +954,22 @@ static inline void _kfree_skb_defer(struct sk_buff *skb)
 	skb_release_all(skb);
 
 	/* record skb to CPU local list */
+	kasan_poison_object_data(skbuff_head_cache, skb);
 	nc->skb_cache[nc->skb_count++] = skb;
 
-#ifdef CONFIG_SLUB
-	/* SLUB writes into objects when freeing */
-	prefetchw(skb);
-#endif
-
-	/* flush skb_cache if it is filled */
+	/* Return half of the cache to the slab when it overflows, keeping
+	 * the rest around for napi_skb_cache_get() to hand back out.
+	 */
 	if (unlikely(nc->skb_count == NAPI_SKB_CACHE_SIZE)) {
-		kmem_cache_free_bulk(skbuff_head_cache, NAPI_SKB_CACHE_SIZE,
-				     nc->skb_cache);
-		nc->skb_count = 0;
+		unsigned int i;
+
+		for (i = NAPI_SKB_CACHE_HALF; i < NAPI_SKB_CACHE_SIZE; i++)
+			kasan_unpoison_object_data(skbuff_head_cache,
+						   nc->skb_cache[i]);
+
+		kmem_cache_free_bulk(skbuff_head_cache, NAPI_SKB_CACHE_HALF,
+				     nc->skb_cache + NAPI_SKB_CACHE_HALF);
+		nc->skb_count = NAPI_SKB_CACHE_HALF;
 	}
 }
 void __kfree_skb_defer(struct sk_buff *skb)
@@ -1173,7 +1258,8 @@ new_alloc:
 }
 EXPORT_SYMBOL_GPL(sock_zerocopy_realloc);
 
-static bool skb_zerocopy_notify_extend(struct sk_buff *skb, u32 lo, u16 len)
+static bool skb_zerocopy_notify_extend(struct sk_buff *skb, u32 lo, u16 len,
+				       __u8 code)
 {
 	struct sock_exterr_skb *serr = SKB_EXT_ERR(skb);
 	u32 old_lo, old_hi;
@@ -1189,6 +1275,12 @@ static bool skb_zerocopy_notify_extend(struct sk_buff *skb, u32 lo, u16 len)
 	if (lo != old_hi + 1)
 		return false;
 
+	/* Only merge ranges with the same copied status, else the
+	 * combined notification would misreport one of them.
+	 */
+	if (serr->ee.ee_code != code)
+		return false;
+
 	serr->ee.ee_data += len;
 	return true;
 }
@@ -1228,13 +1320,18 @@ void sock_zerocopy_callback(struct ubuf_info *uarg, bool success)
 	spin_lock_irqsave(&q->lock, flags);
 	tail = skb_peek_tail(q);
 	if (!tail || SKB_EXT_ERR(tail)->ee.ee_origin != SO_EE_ORIGIN_ZEROCOPY ||
-	    !skb_zerocopy_notify_extend(tail, lo, len)) {
+	    !skb_zerocopy_notify_extend(tail, lo, len, serr->ee.ee_code)) {
 		__skb_queue_tail(q, skb);
 		skb = NULL;
 	}
 	spin_unlock_irqrestore(&q->lock, flags);
 
-	sk->sk_error_report(sk);
+	/* If the range was merged into a queued notification the reader
+	 * has already been signalled for that skb and will observe the
+	 * extended range when it dequeues it; skip the extra wakeup.
+	 */
+	if (!skb)
+		sk->sk_error_report(sk);
 
 release:
 	consume_skb(skb);
@@ -9,6 +9,12 @@
 #include <net/tcp.h>
 #include <net/tls.h>
 
+/* How many bytes and for how long a flow may reuse its last skb verdict
+ * before the verdict program is consulted again; 0 disables the cache.
+ */
+int sysctl_sockmap_verdict_cache_bytes __read_mostly;
+int sysctl_sockmap_verdict_cache_ms __read_mostly;
+
 static bool sk_msg_try_coalesce_ok(struct sk_msg *msg, int elem_first_coalesce)
 {
 	if (msg->sg.end > msg->sg.start &&
@@ -580,6 +586,8 @@ static void sk_psock_destroy_deferred(struct work_struct *gc)
 
 	if (psock->sk_redir)
 		sock_put(psock->sk_redir);
+	if (psock->verdict_cache.sk_redir)
+		sock_put(psock->verdict_cache.sk_redir);
 	sock_put(psock->sk);
 	kfree(psock);
 }
@@ -783,6 +791,64 @@ out_free:
 	}
 }
 
+static bool sk_psock_verdict_cache_active(struct sk_psock_verdict_cache *cache)
+{
+	return cache->bytes_left && time_before(jiffies, cache->expires);
+}
+
+static void sk_psock_verdict_cache_update(struct sk_psock *psock,
+					  struct sk_buff *skb, int verdict)
+{
+	struct sk_psock_verdict_cache *cache = &psock->verdict_cache;
+	int bytes = READ_ONCE(sysctl_sockmap_verdict_cache_bytes);
+	int ms = READ_ONCE(sysctl_sockmap_verdict_cache_ms);
+	struct tcp_skb_cb *tcp = TCP_SKB_CB(skb);
+
+	cache->bytes_left = 0;
+	if (cache->sk_redir) {
+		sock_put(cache->sk_redir);
+		cache->sk_redir = NULL;
+	}
+
+	if (bytes <= 0 || ms <= 0)
+		return;
+	if (verdict != __SK_PASS && verdict != __SK_REDIRECT)
+		return;
+	if (verdict == __SK_REDIRECT) {
+		if (!tcp->bpf.sk_redir)
+			return;
+		cache->sk_redir = tcp->bpf.sk_redir;
+		sock_hold(cache->sk_redir);
+		cache->flags = tcp->bpf.flags;
+	}
+	cache->verdict = verdict;
+	cache->bytes_left = bytes;
+	cache->expires = jiffies + msecs_to_jiffies(ms);
+}
+
+static bool sk_psock_verdict_cache_get(struct sk_psock *psock,
+				       struct sk_buff *skb, int *verdict)
+{
+	struct sk_psock_verdict_cache *cache = &psock->verdict_cache;
+
+	if (!sk_psock_verdict_cache_active(cache))
+		return false;
+	if (skb->len > cache->bytes_left) {
+		/* Out of budget; the next message gets a fresh verdict. */
+		cache->bytes_left = 0;
+		return false;
+	}
+	cache->bytes_left -= skb->len;
+	if (cache->verdict == __SK_REDIRECT) {
+		struct tcp_skb_cb *tcp = TCP_SKB_CB(skb);
+
+		tcp->bpf.sk_redir = cache->sk_redir;
+		tcp->bpf.flags = cache->flags;
+	}
+	*verdict = cache->verdict;
+	return true;
+}
+
 static void sk_psock_strp_read(struct strparser *strp, struct sk_buff *skb)
 {
 	struct sk_psock *psock;
@@ -801,8 +867,12 @@ static void sk_psock_strp_read(struct strparser *strp, struct sk_buff *skb)
 	if (likely(prog)) {
 		skb_orphan(skb);
 		tcp_skb_bpf_redirect_clear(skb);
-		ret = sk_psock_bpf_run(psock, prog, skb);
-		ret = sk_psock_map_verd(ret, tcp_skb_bpf_redirect_fetch(skb));
+		if (!sk_psock_verdict_cache_get(psock, skb, &ret)) {
+			ret = sk_psock_bpf_run(psock, prog, skb);
+			ret = sk_psock_map_verd(ret,
+					tcp_skb_bpf_redirect_fetch(skb));
+			sk_psock_verdict_cache_update(psock, skb, ret);
+		}
 	}
 	sk_psock_verdict_apply(psock, skb, ret);
 out:
@@ -820,6 +890,13 @@ static int sk_psock_strp_parse(struct strparser *strp, struct sk_buff *skb)
 	struct bpf_prog *prog;
 	int ret = skb->len;
 
+	/* While a cached verdict is in effect the flow needs no message
+	 * framing: pass whole skbs through, which skips one BPF run per
+	 * message and lets the read loop splice skb-at-a-time.
+	 */
+	if (sk_psock_verdict_cache_active(&psock->verdict_cache))
+		return ret;
+
 	rcu_read_lock();
 	prog = READ_ONCE(psock->progs.skb_parser);
 	if (likely(prog))
@@ -47,68 +47,46 @@ EXPORT_SYMBOL(sysctl_devconf_inherit_init_net);
 static int rps_sock_flow_sysctl(struct ctl_table *table, int write,
 				void __user *buffer, size_t *lenp, loff_t *ppos)
 {
-	unsigned int orig_size, size;
-	int ret, i;
+	unsigned int size;
+	int ret;
 	struct ctl_table tmp = {
 		.data = &size,
 		.maxlen = sizeof(size),
 		.mode = table->mode
 	};
-	struct rps_sock_flow_table *orig_sock_table, *sock_table;
-	static DEFINE_MUTEX(sock_flow_mutex);
-
-	mutex_lock(&sock_flow_mutex);
+	struct rps_sock_flow_table *sock_table;
 
-	orig_sock_table = rcu_dereference_protected(rps_sock_flow_table,
-					lockdep_is_held(&sock_flow_mutex));
-	size = orig_size = orig_sock_table ? orig_sock_table->mask + 1 : 0;
+	rcu_read_lock();
+	sock_table = rcu_dereference(rps_sock_flow_table);
+	size = sock_table ? sock_table->mask + 1 : 0;
+	rcu_read_unlock();
 
 	ret = proc_dointvec(&tmp, write, buffer, lenp, ppos);
+	if (ret)
+		return ret;
 
-	if (write) {
-		if (size) {
-			if (size > 1<<29) {
-				/* Enforce limit to prevent overflow */
-				mutex_unlock(&sock_flow_mutex);
-				return -EINVAL;
-			}
-			size = roundup_pow_of_two(size);
-			if (size != orig_size) {
-				sock_table =
-				    vmalloc(RPS_SOCK_FLOW_TABLE_SIZE(size));
-				if (!sock_table) {
-					mutex_unlock(&sock_flow_mutex);
-					return -ENOMEM;
-				}
-				rps_cpu_mask = roundup_pow_of_two(nr_cpu_ids) - 1;
-				sock_table->mask = size - 1;
-			} else
-				sock_table = orig_sock_table;
-
-			for (i = 0; i < size; i++)
-				sock_table->ents[i] = RPS_NO_CPU;
-		} else
-			sock_table = NULL;
-
-		if (sock_table != orig_sock_table) {
-			rcu_assign_pointer(rps_sock_flow_table, sock_table);
-			if (sock_table) {
-				static_branch_inc(&rps_needed);
-				static_branch_inc(&rfs_needed);
-			}
-			if (orig_sock_table) {
-				static_branch_dec(&rps_needed);
-				static_branch_dec(&rfs_needed);
-				synchronize_rcu();
-				vfree(orig_sock_table);
-			}
-		}
-	}
-
-	mutex_unlock(&sock_flow_mutex);
+	if (write)
+		ret = rps_sock_flow_table_set(size);
 
 	return ret;
 }
+
+static int rps_sock_flow_collisions_sysctl(struct ctl_table *table, int write,
+					   void __user *buffer, size_t *lenp,
+					   loff_t *ppos)
+{
+	unsigned long val = atomic_long_read(&rps_sock_flow_collisions);
+	struct ctl_table tmp = {
+		.data = &val,
+		.maxlen = sizeof(val),
+		.mode = table->mode
+	};
+
+	if (write)
+		return -EPERM;
+
+	return proc_doulongvec_minmax(&tmp, write, buffer, lenp, ppos);
+}
 #endif /* CONFIG_RPS */
 
 #ifdef CONFIG_NET_FLOW_LIMIT
@@ -382,6 +360,24 @@ static struct ctl_table net_core_table[] = {
 		.mode		= 0444,
 		.proc_handler	= proc_do_rss_key,
 	},
+#ifdef CONFIG_NET_SOCK_MSG
+	{
+		.procname	= "sockmap_verdict_cache_bytes",
+		.data		= &sysctl_sockmap_verdict_cache_bytes,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+	},
+	{
+		.procname	= "sockmap_verdict_cache_ms",
+		.data		= &sysctl_sockmap_verdict_cache_ms,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+	},
+#endif
 #ifdef CONFIG_BPF_JIT
 	{
 		.procname	= "bpf_jit_enable",
@@ -471,6 +467,21 @@ static struct ctl_table net_core_table[] = {
 		.mode		= 0644,
 		.proc_handler	= rps_sock_flow_sysctl
 	},
+	{
+		.procname	= "rps_sock_flow_autosize",
+		.data		= &rps_sock_flow_autosize,
+		.maxlen		= sizeof(int),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_ONE
+	},
+	{
+		.procname	= "rps_sock_flow_collisions",
+		.maxlen		= sizeof(unsigned long),
+		.mode		= 0444,
+		.proc_handler	= rps_sock_flow_collisions_sysctl
+	},
 #endif
 #ifdef CONFIG_NET_FLOW_LIMIT
 	{
@@ -582,7 +582,24 @@ static void ip_rt_build_flow_key(struct flowi4 *fl4, const struct sock *sk,
 		build_sk_flow_key(fl4, sk);
 }
 
-static DEFINE_SPINLOCK(fnhe_lock);
+/* The exception chains hang off each nexthop, but updates used to serialize
+ * on one global lock, which PMTU-churning tunnel workloads turn into a
+ * hotspot.  Shard the lock by bucket index instead: all operations on a
+ * given destination hash to the same bucket and therefore the same lock,
+ * which is what fnhe_oldest() and the chain updates rely on.
+ */
+#define FNHE_LOCK_BITS	8
+#define FNHE_LOCK_SIZE	(1 << FNHE_LOCK_BITS)
+#define FNHE_LOCK_MASK	(FNHE_LOCK_SIZE - 1)
+
+static struct fnhe_aligned_lock {
+	spinlock_t	l;
+} fnhe_locks[FNHE_LOCK_SIZE] __cacheline_aligned;
+
+static inline spinlock_t *fnhe_lock_ptr(u32 hval)
+{
+	return &fnhe_locks[hval & FNHE_LOCK_MASK].l;
+}
 
 static void fnhe_flush_routes(struct fib_nh_exception *fnhe)
 {
@@ -640,21 +657,57 @@ static void fill_route_from_fnhe(struct rtable *rt, struct fib_nh_exception *fnh
 	}
 }
 
+/* Batched removal of exceptions whose expiry passed more than the per-netns
+ * stale timeout ago.  Called with the bucket's shard lock held, typically
+ * while the chain is being updated anyway, so churny workloads pay for
+ * cleanup where they created the garbage.
+ */
+static void fnhe_prune_stale(struct net *net, struct fnhe_hash_bucket *bucket,
+			     spinlock_t *lock)
+{
+	int timeout = READ_ONCE(net->ipv4.sysctl_fnhe_stale_timeout);
+	struct fib_nh_exception *fnhe, __rcu **fnhe_p;
+
+	if (!timeout)
+		return;
+
+	fnhe_p = &bucket->chain;
+	fnhe = rcu_dereference_protected(*fnhe_p, lockdep_is_held(lock));
+	while (fnhe) {
+		if (fnhe->fnhe_expires &&
+		    time_after(jiffies, fnhe->fnhe_expires + timeout * HZ)) {
+			rcu_assign_pointer(*fnhe_p, rcu_dereference_protected(
+				fnhe->fnhe_next, lockdep_is_held(lock)));
+			/* see ip_del_fnhe() */
+			fnhe->fnhe_daddr = 0;
+			fnhe_flush_routes(fnhe);
+			kfree_rcu(fnhe, rcu);
+		} else {
+			fnhe_p = &fnhe->fnhe_next;
+		}
+		fnhe = rcu_dereference_protected(*fnhe_p,
+						 lockdep_is_held(lock));
+	}
+}
+
 static void update_or_create_fnhe(struct fib_nh_common *nhc, __be32 daddr,
 				  __be32 gw, u32 pmtu, bool lock,
 				  unsigned long expires)
 {
+	struct net *net = dev_net(nhc->nhc_dev);
 	struct fnhe_hash_bucket *hash;
 	struct fib_nh_exception *fnhe;
+	spinlock_t *fnhe_lock;
 	struct rtable *rt;
 	u32 genid, hval;
 	unsigned int i;
 	int depth;
 
-	genid = fnhe_genid(dev_net(nhc->nhc_dev));
+	genid = fnhe_genid(net);
 	hval = fnhe_hashfun(daddr);
+	fnhe_lock = fnhe_lock_ptr(hval);
 
-	spin_lock_bh(&fnhe_lock);
+	spin_lock_bh(fnhe_lock);
 
 	hash = rcu_dereference(nhc->nhc_exceptions);
 	if (!hash) {
@@ -666,6 +719,8 @@ static void update_or_create_fnhe(struct fib_nh_common *nhc, __be32 daddr,
 
 	hash += hval;
 
+	fnhe_prune_stale(net, hash, fnhe_lock);
+
 	depth = 0;
 	for (fnhe = rcu_dereference(hash->chain); fnhe;
 	     fnhe = rcu_dereference(fnhe->fnhe_next)) {
@@ -692,7 +747,7 @@ static void update_or_create_fnhe(struct fib_nh_common *nhc, __be32 daddr,
 		if (rt)
 			fill_route_from_fnhe(rt, fnhe);
 	} else {
-		if (depth > FNHE_RECLAIM_DEPTH)
+		if (depth > READ_ONCE(net->ipv4.sysctl_fnhe_reclaim_depth))
 			fnhe = fnhe_oldest(hash);
 		else {
 			fnhe = kzalloc(sizeof(*fnhe), GFP_ATOMIC);
@@ -729,7 +784,7 @@ static void update_or_create_fnhe(struct fib_nh_common *nhc, __be32 daddr,
 	fnhe->fnhe_stamp = jiffies;
 
 out_unlock:
-	spin_unlock_bh(&fnhe_lock);
+	spin_unlock_bh(fnhe_lock);
 }
 
 static void __ip_do_redirect(struct rtable *rt, struct sk_buff *skb, struct flowi4 *fl4,
@@ -1327,19 +1382,20 @@ static void ip_del_fnhe(struct fib_nh_common *nhc, __be32 daddr)
 	struct fnhe_hash_bucket *hash;
 	struct fib_nh_exception *fnhe, __rcu **fnhe_p;
 	u32 hval = fnhe_hashfun(daddr);
+	spinlock_t *fnhe_lock = fnhe_lock_ptr(hval);
 
-	spin_lock_bh(&fnhe_lock);
+	spin_lock_bh(fnhe_lock);
 
 	hash = rcu_dereference_protected(nhc->nhc_exceptions,
-					 lockdep_is_held(&fnhe_lock));
+					 lockdep_is_held(fnhe_lock));
 	hash += hval;
 
 	fnhe_p = &hash->chain;
-	fnhe = rcu_dereference_protected(*fnhe_p, lockdep_is_held(&fnhe_lock));
+	fnhe = rcu_dereference_protected(*fnhe_p, lockdep_is_held(fnhe_lock));
 	while (fnhe) {
 		if (fnhe->fnhe_daddr == daddr) {
 			rcu_assign_pointer(*fnhe_p, rcu_dereference_protected(
-				fnhe->fnhe_next, lockdep_is_held(&fnhe_lock)));
+				fnhe->fnhe_next, lockdep_is_held(fnhe_lock)));
 			/* set fnhe_daddr to 0 to ensure it won't bind with
 			 * new dsts in rt_bind_exception().
 			 */
@@ -1350,10 +1406,10 @@ static void ip_del_fnhe(struct fib_nh_common *nhc, __be32 daddr)
 		}
 		fnhe_p = &fnhe->fnhe_next;
 		fnhe = rcu_dereference_protected(fnhe->fnhe_next,
-						 lockdep_is_held(&fnhe_lock));
+						 lockdep_is_held(fnhe_lock));
 	}
 
-	spin_unlock_bh(&fnhe_lock);
+	spin_unlock_bh(fnhe_lock);
 }
 
 static struct fib_nh_exception *find_exception(struct fib_nh_common *nhc,
@@ -1416,9 +1472,10 @@ u32 ip_mtu_from_fib_result(struct fib_result *res, __be32 daddr)
 static bool rt_bind_exception(struct rtable *rt, struct fib_nh_exception *fnhe,
 			      __be32 daddr, const bool do_cache)
 {
+	spinlock_t *fnhe_lock = fnhe_lock_ptr(fnhe_hashfun(daddr));
 	bool ret = false;
 
-	spin_lock_bh(&fnhe_lock);
+	spin_lock_bh(fnhe_lock);
 
 	if (daddr == fnhe->fnhe_daddr) {
 		struct rtable __rcu **porig;
@@ -1458,7 +1515,7 @@ static bool rt_bind_exception(struct rtable *rt, struct fib_nh_exception *fnhe,
 
 		fnhe->fnhe_stamp = jiffies;
 	}
-	spin_unlock_bh(&fnhe_lock);
+	spin_unlock_bh(fnhe_lock);
 
 	return ret;
 }
@@ -3413,6 +3470,8 @@ static __net_init int rt_genid_init(struct net *net)
 	atomic_set(&net->ipv4.rt_genid, 0);
 	atomic_set(&net->fnhe_genid, 0);
 	atomic_set(&net->ipv4.dev_addr_genid, get_random_int());
+	net->ipv4.sysctl_fnhe_reclaim_depth = FNHE_RECLAIM_DEPTH;
+	net->ipv4.sysctl_fnhe_stale_timeout = 5 * 60;
 	return 0;
 }
 
@@ -3451,7 +3510,7 @@ struct ip_rt_acct __percpu *ip_rt_acct __read_mostly;
 
 int __init ip_rt_init(void)
 {
-	int cpu;
+	int cpu, i;
 
 	ip_idents = kmalloc_array(IP_IDENTS_SZ, sizeof(*ip_idents),
 				  GFP_KERNEL);
@@ -3470,6 +3529,9 @@ int __init ip_rt_init(void)
 		INIT_LIST_HEAD(&ul->head);
 		spin_lock_init(&ul->lock);
 	}
+
+	for (i = 0; i < FNHE_LOCK_SIZE; i++)
+		spin_lock_init(&fnhe_locks[i].l);
 #ifdef CONFIG_IP_ROUTE_CLASSID
 	ip_rt_acct = __alloc_percpu(256 * sizeof(struct ip_rt_acct), __alignof__(struct ip_rt_acct));
 	if (!ip_rt_acct)
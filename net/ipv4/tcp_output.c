@@ -2243,9 +2243,10 @@ static bool tcp_pacing_check(struct sock *sk)
 		return false;
 
 	if (!hrtimer_is_queued(&tp->pacing_timer)) {
-		hrtimer_start(&tp->pacing_timer,
-			      ns_to_ktime(tp->tcp_wstamp_ns),
-			      HRTIMER_MODE_ABS_PINNED_SOFT);
+		hrtimer_start_class(&tp->pacing_timer,
+				    ns_to_ktime(tp->tcp_wstamp_ns),
+				    HRTIMER_CLASS_NORMAL,
+				    HRTIMER_MODE_ABS_PINNED_SOFT);
 		sock_hold(sk);
 	}
 	return true;
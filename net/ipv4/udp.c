@@ -112,6 +112,8 @@
 #include <net/sock_reuseport.h>
 #include <net/addrconf.h>
 #include <net/udp_tunnel.h>
+#include <linux/bpf.h>
+#include <linux/nsproxy.h>
 
 struct udp_table udp_table __read_mostly;
 EXPORT_SYMBOL(udp_table);
@@ -965,6 +967,78 @@ int udp_cmsg_send(struct sock *sk, struct msghdr *msg, u16 *gso_size)
 }
 EXPORT_SYMBOL_GPL(udp_cmsg_send);
 
+/* Lockless lookup of the route cached from the previous send of an
+ * unconnected socket.  The seqlock retry pairs the dst with the flow key
+ * it was stored under, rcu protects the dst itself until the reference
+ * is taken, and dst->ops->check() rejects entries made stale by a fib
+ * change or genid bump, so a hit is as valid as a fresh fib lookup.
+ */
+static struct rtable *udp_rtcache_get(struct udp_sock *up, struct flowi4 *fl4)
+{
+	struct dst_entry *dst;
+	__be32 prefsrc;
+	unsigned int seq;
+
+	rcu_read_lock();
+	do {
+		seq = read_seqbegin(&up->rtcache_lock);
+		dst = up->rtcache_dst;
+		prefsrc = up->rtcache_prefsrc;
+		if (!dst ||
+		    up->rtcache_daddr != fl4->daddr ||
+		    up->rtcache_saddr != fl4->saddr ||
+		    up->rtcache_dport != fl4->fl4_dport ||
+		    up->rtcache_oif != fl4->flowi4_oif ||
+		    up->rtcache_mark != fl4->flowi4_mark ||
+		    up->rtcache_tos != fl4->flowi4_tos ||
+		    up->rtcache_flow_flags != fl4->flowi4_flags) {
+			dst = NULL;
+			break;
+		}
+	} while (read_seqretry(&up->rtcache_lock, seq));
+
+	if (dst && ((dst->obsolete && !dst->ops->check(dst, 0)) ||
+		    !dst_hold_safe(dst)))
+		dst = NULL;
+	rcu_read_unlock();
+
+	if (!dst)
+		return NULL;
+
+	fl4->saddr = prefsrc;
+	return (struct rtable *)dst;
+}
+
+/* @fl4 must hold the flow as it was before ip_route_output_flow(), which
+ * rewrites saddr and tos; @prefsrc is the source address the lookup chose.
+ */
+static void udp_rtcache_set(struct udp_sock *up, const struct flowi4 *fl4,
+			    __be32 prefsrc, struct rtable *rt)
+{
+	struct dst_entry *old;
+
+	/* Broadcast sends must recheck SOCK_BROADCAST every time. */
+	if (rt->rt_flags & (RTCF_BROADCAST | RTCF_MULTICAST))
+		return;
+
+	dst_hold(&rt->dst);
+
+	write_seqlock(&up->rtcache_lock);
+	old = up->rtcache_dst;
+	up->rtcache_dst = &rt->dst;
+	up->rtcache_daddr = fl4->daddr;
+	up->rtcache_saddr = fl4->saddr;
+	up->rtcache_prefsrc = prefsrc;
+	up->rtcache_dport = fl4->fl4_dport;
+	up->rtcache_oif = fl4->flowi4_oif;
+	up->rtcache_mark = fl4->flowi4_mark;
+	up->rtcache_tos = fl4->flowi4_tos;
+	up->rtcache_flow_flags = fl4->flowi4_flags;
+	write_sequnlock(&up->rtcache_lock);
+
+	dst_release(old);
+}
+
 int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 {
 	struct inet_sock *inet = inet_sk(sk);
@@ -1134,6 +1208,8 @@ int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 	if (!rt) {
 		struct net *net = sock_net(sk);
 		__u8 flow_flags = inet_sk_flowi_flags(sk);
+		struct flowi4 fl4_key;
+		bool use_cache = false;
 
 		fl4 = &fl4_stack;
 
@@ -1144,21 +1220,35 @@ int udp_sendmsg(struct sock *sk, struct msghdr *msg, size_t len)
 				   sk->sk_uid);
 
 		security_sk_classify_flow(sk, flowi4_to_flowi(fl4));
-		rt = ip_route_output_flow(net, fl4, sk);
-		if (IS_ERR(rt)) {
-			err = PTR_ERR(rt);
-			rt = NULL;
-			if (err == -ENETUNREACH)
-				IP_INC_STATS(net, IPSTATS_MIB_OUTNOROUTES);
-			goto out;
+
+		if (!connected && !ipv4_is_multicast(daddr) &&
+		    !ipv4_is_lbcast(daddr)) {
+			rt = udp_rtcache_get(up, fl4);
+			if (!rt) {
+				fl4_key = *fl4;
+				use_cache = true;
+			}
 		}
+		if (!rt) {
+			rt = ip_route_output_flow(net, fl4, sk);
+			if (IS_ERR(rt)) {
+				err = PTR_ERR(rt);
+				rt = NULL;
+				if (err == -ENETUNREACH)
+					IP_INC_STATS(net,
+						     IPSTATS_MIB_OUTNOROUTES);
+				goto out;
+			}
 
-		err = -EACCES;
-		if ((rt->rt_flags & RTCF_BROADCAST) &&
-		    !sock_flag(sk, SOCK_BROADCAST))
-			goto out;
-		if (connected)
-			sk_dst_set(sk, dst_clone(&rt->dst));
+			err = -EACCES;
+			if ((rt->rt_flags & RTCF_BROADCAST) &&
+			    !sock_flag(sk, SOCK_BROADCAST))
+				goto out;
+			if (connected)
+				sk_dst_set(sk, dst_clone(&rt->dst));
+			else if (use_cache)
+				udp_rtcache_set(up, &fl4_key, fl4->saddr, rt);
+		}
 	}
 
 	if (msg->msg_flags&MSG_CONFIRM)
@@ -1535,6 +1625,8 @@ void udp_destruct_sock(struct sock *sk)
 	}
 	udp_rmem_release(sk, total, 0, true);
 
+	dst_release(up->rtcache_dst);
+
 	inet_sock_destruct(sk);
 }
 EXPORT_SYMBOL_GPL(udp_destruct_sock);
@@ -1542,6 +1634,7 @@ EXPORT_SYMBOL_GPL(udp_destruct_sock);
 int udp_init_sock(struct sock *sk)
 {
 	skb_queue_head_init(&udp_sk(sk)->reader_queue);
+	seqlock_init(&udp_sk(sk)->rtcache_lock);
 	sk->sk_destruct = udp_destruct_sock;
 	return 0;
 }
@@ -2691,6 +2784,10 @@ int udp_lib_getsockopt(struct sock *sk, int level, int optname,
 		val = up->gso_size;
 		break;
 
+	case UDP_GRO:
+		val = up->gro_enabled;
+		break;
+
 	/* The following two cannot be changed on UDP sockets, the return is
 	 * always 0 (which corresponds to the full checksum coverage of UDP). */
 	case UDPLITE_SEND_CSCOV:
@@ -2812,10 +2909,20 @@ EXPORT_SYMBOL(udp_prot);
 /* ------------------------------------------------------------------------ */
 #ifdef CONFIG_PROC_FS
 
+static struct udp_seq_afinfo *udp_seq_afinfo_of(struct seq_file *seq)
+{
+	struct udp_iter_state *state = seq->private;
+
+	/* BPF iterators have no proc entry to hang the afinfo off */
+	if (state->bpf_seq_afinfo)
+		return state->bpf_seq_afinfo;
+	return PDE_DATA(file_inode(seq->file));
+}
+
 static struct sock *udp_get_first(struct seq_file *seq, int start)
 {
 	struct sock *sk;
-	struct udp_seq_afinfo *afinfo = PDE_DATA(file_inode(seq->file));
+	struct udp_seq_afinfo *afinfo = udp_seq_afinfo_of(seq);
 	struct udp_iter_state *state = seq->private;
 	struct net *net = seq_file_net(seq);
 
@@ -2830,7 +2937,8 @@ static struct sock *udp_get_first(struct seq_file *seq, int start)
 		sk_for_each(sk, &hslot->head) {
 			if (!net_eq(sock_net(sk), net))
 				continue;
-			if (sk->sk_family == afinfo->family)
+			if (afinfo->family == AF_UNSPEC ||
+			    sk->sk_family == afinfo->family)
 				goto found;
 		}
 		spin_unlock_bh(&hslot->lock);
@@ -2842,13 +2950,15 @@ found:
 
 static struct sock *udp_get_next(struct seq_file *seq, struct sock *sk)
 {
-	struct udp_seq_afinfo *afinfo = PDE_DATA(file_inode(seq->file));
+	struct udp_seq_afinfo *afinfo = udp_seq_afinfo_of(seq);
 	struct udp_iter_state *state = seq->private;
 	struct net *net = seq_file_net(seq);
 
 	do {
 		sk = sk_next(sk);
-	} while (sk && (!net_eq(sock_net(sk), net) || sk->sk_family != afinfo->family));
+	} while (sk && (!net_eq(sock_net(sk), net) ||
+			(afinfo->family != AF_UNSPEC &&
+			 sk->sk_family != afinfo->family)));
 
 	if (!sk) {
 		if (state->bucket <= afinfo->udp_table->mask)
@@ -2893,7 +3003,7 @@ EXPORT_SYMBOL(udp_seq_next);
 
 void udp_seq_stop(struct seq_file *seq, void *v)
 {
-	struct udp_seq_afinfo *afinfo = PDE_DATA(file_inode(seq->file));
+	struct udp_seq_afinfo *afinfo = udp_seq_afinfo_of(seq);
 	struct udp_iter_state *state = seq->private;
 
 	if (state->bucket <= afinfo->udp_table->mask)
@@ -2979,6 +3089,68 @@ void udp4_proc_exit(void)
 {
 	unregister_pernet_subsys(&udp4_net_ops);
 }
+
+#ifdef CONFIG_BPF_SYSCALL
+static int bpf_iter_udp_seq_show(struct seq_file *seq, void *v)
+{
+	if (v == SEQ_START_TOKEN)
+		return 0;
+	return bpf_iter_run_prog(seq, v, false);
+}
+
+static void bpf_iter_udp_seq_stop(struct seq_file *seq, void *v)
+{
+	if (!v)
+		bpf_iter_run_prog(seq, NULL, true);
+	udp_seq_stop(seq, v);
+}
+
+static const struct seq_operations bpf_iter_udp_seq_ops = {
+	.start		= udp_seq_start,
+	.next		= udp_seq_next,
+	.stop		= bpf_iter_udp_seq_stop,
+	.show		= bpf_iter_udp_seq_show,
+};
+
+static int bpf_iter_udp_init_seq(void *priv_data)
+{
+	struct udp_iter_state *st = priv_data;
+	struct udp_seq_afinfo *afinfo;
+
+	afinfo = kmalloc(sizeof(*afinfo), GFP_USER | __GFP_NOWARN);
+	if (!afinfo)
+		return -ENOMEM;
+
+	/* Walk both IPv4 and IPv6 sockets of the caller's netns */
+	afinfo->family = AF_UNSPEC;
+	afinfo->udp_table = &udp_table;
+	st->bpf_seq_afinfo = afinfo;
+	st->p.net = get_net(current->nsproxy->net_ns);
+	return 0;
+}
+
+static void bpf_iter_udp_fini_seq(void *priv_data)
+{
+	struct udp_iter_state *st = priv_data;
+
+	put_net(st->p.net);
+	kfree(st->bpf_seq_afinfo);
+}
+
+static const struct bpf_iter_reg udp_reg_info = {
+	.target			= "udp",
+	.seq_ops		= &bpf_iter_udp_seq_ops,
+	.init_seq_private	= bpf_iter_udp_init_seq,
+	.fini_seq_private	= bpf_iter_udp_fini_seq,
+	.seq_priv_size		= sizeof(struct udp_iter_state),
+};
+
+static void __init bpf_iter_register(void)
+{
+	if (bpf_iter_reg_target(&udp_reg_info))
+		pr_warn("Failed to register bpf iterator for udp\n");
+}
+#endif /* CONFIG_BPF_SYSCALL */
 #endif /* CONFIG_PROC_FS */
 
 static __initdata unsigned long uhash_entries;
@@ -3081,4 +3253,8 @@ void __init udp_init(void)
 
 	if (register_pernet_subsys(&udp_sysctl_ops))
 		panic("UDP: failed to init sysctl parameters.\n");
+
+#if defined(CONFIG_PROC_FS) && defined(CONFIG_BPF_SYSCALL)
+	bpf_iter_register();
+#endif
 }
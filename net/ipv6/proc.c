@@ -44,7 +44,7 @@ static int sockstat6_seq_show(struct seq_file *seq, void *v)
 	seq_printf(seq, "RAW6: inuse %d\n",
 		       sock_prot_inuse_get(net, &rawv6_prot));
 	seq_printf(seq, "FRAG6: inuse %u memory %lu\n",
-		   atomic_read(&net->ipv6.fqdir->rhashtable.nelems),
+		   (unsigned int)percpu_counter_sum_positive(&net->ipv6.fqdir->rhashtable.nelems),
 		   frag_mem_limit(net->ipv6.fqdir));
 	return 0;
 }
@@ -5625,6 +5625,7 @@ static const struct nla_policy nft_flowtable_policy[NFTA_FLOWTABLE_MAX + 1] = {
 					    .len = NFT_NAME_MAXLEN - 1 },
 	[NFTA_FLOWTABLE_HOOK]		= { .type = NLA_NESTED },
 	[NFTA_FLOWTABLE_HANDLE]		= { .type = NLA_U64 },
+	[NFTA_FLOWTABLE_FLAGS]		= { .type = NLA_U32 },
 };
 
 struct nft_flowtable *nft_flowtable_lookup(const struct nft_table *table,
@@ -5751,6 +5752,7 @@ static int nf_tables_flowtable_parse_hook(const struct nft_ctx *ctx,
 
 	flowtable->hooknum	= hooknum;
 	flowtable->priority	= priority;
+	flowtable->data.priority = priority;
 	flowtable->ops		= ops;
 	flowtable->ops_len	= n;
 
@@ -5796,6 +5798,16 @@ nft_flowtable_type_get(struct net *net, u8 family)
 	return ERR_PTR(-ENOENT);
 }
 
+static int nft_flowtable_hook_setup(struct nft_flowtable *flowtable,
+				    struct net_device *dev,
+				    enum flow_block_command cmd)
+{
+	if (!flowtable->data.type->setup)
+		return 0;
+
+	return flowtable->data.type->setup(&flowtable->data, dev, cmd);
+}
+
 static void nft_unregister_flowtable_net_hooks(struct net *net,
 					       struct nft_flowtable *flowtable)
 {
@@ -5806,6 +5818,8 @@ static void nft_unregister_flowtable_net_hooks(struct net *net,
 			continue;
 
 		nf_unregister_net_hook(net, &flowtable->ops[i]);
+		nft_flowtable_hook_setup(flowtable, flowtable->ops[i].dev,
+					 FLOW_BLOCK_UNBIND);
 	}
 }
 
@@ -5874,6 +5888,18 @@ static int nf_tables_newflowtable(struct net *net, struct sock *nlsk,
 		goto err2;
 	}
 
+	if (nla[NFTA_FLOWTABLE_FLAGS]) {
+		flowtable->data.flags =
+			ntohl(nla_get_be32(nla[NFTA_FLOWTABLE_FLAGS]));
+		if (flowtable->data.flags & ~NFT_FLOWTABLE_MASK ||
+		    ((flowtable->data.flags & NF_FLOWTABLE_HW_OFFLOAD) &&
+		     !type->setup)) {
+			err = -EOPNOTSUPP;
+			goto err3;
+		}
+	}
+
+	write_pnet(&flowtable->data.net, net);
 	flowtable->data.type = type;
 	err = type->init(&flowtable->data);
 	if (err < 0)
@@ -5901,9 +5927,19 @@ static int nf_tables_newflowtable(struct net *net, struct sock *nlsk,
 			}
 		}
 
-		err = nf_register_net_hook(net, &flowtable->ops[i]);
+		err = nft_flowtable_hook_setup(flowtable,
+					       flowtable->ops[i].dev,
+					       FLOW_BLOCK_BIND);
 		if (err < 0)
 			goto err5;
+
+		err = nf_register_net_hook(net, &flowtable->ops[i]);
+		if (err < 0) {
+			nft_flowtable_hook_setup(flowtable,
+						 flowtable->ops[i].dev,
+						 FLOW_BLOCK_UNBIND);
+			goto err5;
+		}
 	}
 
 	err = nft_trans_flowtable_add(&ctx, NFT_MSG_NEWFLOWTABLE, flowtable);
@@ -5917,8 +5953,11 @@ static int nf_tables_newflowtable(struct net *net, struct sock *nlsk,
 err6:
 	i = flowtable->ops_len;
 err5:
-	for (k = i - 1; k >= 0; k--)
+	for (k = i - 1; k >= 0; k--) {
 		nf_unregister_net_hook(net, &flowtable->ops[k]);
+		nft_flowtable_hook_setup(flowtable, flowtable->ops[k].dev,
+					 FLOW_BLOCK_UNBIND);
+	}
 
 	kfree(flowtable->ops);
 err4:
@@ -6004,7 +6043,8 @@ static int nf_tables_fill_flowtable_info(struct sk_buff *skb, struct net *net,
 	    nla_put_string(skb, NFTA_FLOWTABLE_NAME, flowtable->name) ||
 	    nla_put_be32(skb, NFTA_FLOWTABLE_USE, htonl(flowtable->use)) ||
 	    nla_put_be64(skb, NFTA_FLOWTABLE_HANDLE, cpu_to_be64(flowtable->handle),
-			 NFTA_FLOWTABLE_PAD))
+			 NFTA_FLOWTABLE_PAD) ||
+	    nla_put_be32(skb, NFTA_FLOWTABLE_FLAGS, htonl(flowtable->data.flags)))
 		goto nla_put_failure;
 
 	nest = nla_nest_start_noflag(skb, NFTA_FLOWTABLE_HOOK);
@@ -6260,6 +6300,7 @@ static void nft_flowtable_event(unsigned long event, struct net_device *dev,
 			continue;
 
 		nf_unregister_net_hook(dev_net(dev), &flowtable->ops[i]);
+		nft_flowtable_hook_setup(flowtable, dev, FLOW_BLOCK_UNBIND);
 		flowtable->ops[i].dev = NULL;
 		break;
 	}
@@ -1404,13 +1404,25 @@ static int decrypt_internal(struct sock *sk, struct sk_buff *skb,
 	struct scatterlist *sgout = NULL;
 	const int data_len = rxm->full_len - prot->overhead_size +
 			     prot->tail_size;
-	int iv_offset = 0;
+	int iv_offset = 0, tail_size = 0;
 
 	if (*zc && (out_iov || out_sg)) {
-		if (out_iov)
-			n_sgout = iov_iter_npages(out_iov, INT_MAX) + 1;
-		else
+		if (out_iov) {
+			/* TLS 1.3 hides the real content type (and any
+			 * zero padding) at the tail of the plaintext, so
+			 * the last byte must stay readable by the kernel.
+			 * Split it out into a side buffer and gamble on
+			 * the common case of an unpadded data record; the
+			 * decryption is redone into the skb if the gamble
+			 * turns out to be lost.
+			 */
+			if (prot->version == TLS_1_3_VERSION)
+				tail_size = 1;
+			n_sgout = iov_iter_npages(out_iov, INT_MAX) + 1 +
+				  tail_size;
+		} else {
 			n_sgout = sg_nents(out_sg);
+		}
 		n_sgin = skb_nsg(skb, rxm->offset + prot->prepend_size,
 				 rxm->full_len - prot->prepend_size);
 	} else {
@@ -1492,11 +1504,19 @@ static int decrypt_internal(struct sock *sk, struct sk_buff *skb,
 			sg_set_buf(&sgout[0], aad, prot->aad_size);
 
 			*chunk = 0;
-			err = tls_setup_from_iter(sk, out_iov, data_len,
+			err = tls_setup_from_iter(sk, out_iov,
+						  data_len - tail_size,
 						  &pages, chunk, &sgout[1],
-						  (n_sgout - 1));
+						  (n_sgout - 1) - tail_size);
 			if (err < 0)
 				goto fallback_to_reg_recv;
+
+			if (tail_size) {
+				sg_unmark_end(&sgout[pages]);
+				sg_set_buf(&sgout[pages + 1], &ctx->rx_tail,
+					   tail_size);
+				sg_mark_end(&sgout[pages + 1]);
+			}
 		} else if (out_sg) {
 			memcpy(sgout, out_sg, n_sgout * sizeof(*sgout));
 		} else {
@@ -1516,6 +1536,22 @@ fallback_to_reg_recv:
 	if (err == -EINPROGRESS)
 		return err;
 
+	if (!err && *zc && tail_size &&
+	    ctx->rx_tail != TLS_RECORD_TYPE_DATA) {
+		/* Lost the gamble: the record carries padding or a
+		 * non-data content type, neither of which may end up in
+		 * the user's buffer.  Hand the pages back, rewind the
+		 * iterator and decrypt again into the skb.
+		 */
+		for (; pages > 0; pages--)
+			put_page(sg_page(&sgout[pages]));
+		kfree(mem);
+		iov_iter_revert(out_iov, *chunk);
+		*zc = false;
+		return decrypt_internal(sk, skb, NULL, NULL, chunk, zc,
+					false);
+	}
+
 	/* Release the pages in case iov was mapped to pages */
 	for (; pages > 0; pages--)
 		put_page(sg_page(&sgout[pages]));
@@ -1556,9 +1592,18 @@ static int decrypt_skb_update(struct sock *sk, struct sk_buff *skb,
 			*zc = false;
 		}
 
-		pad = padding_length(ctx, prot, skb);
-		if (pad < 0)
-			return pad;
+		if (*zc && prot->version == TLS_1_3_VERSION) {
+			/* decrypt_internal() split the content type byte
+			 * out of the user's buffer and already ruled out
+			 * padding.
+			 */
+			ctx->control = ctx->rx_tail;
+			pad = 0;
+		} else {
+			pad = padding_length(ctx, prot, skb);
+			if (pad < 0)
+				return pad;
+		}
 
 		rxm->full_len -= pad;
 		rxm->offset += prot->prepend_size;
@@ -1802,7 +1847,6 @@ int tls_sw_recvmsg(struct sock *sk,
 
 		if (to_decrypt <= len && !is_kvec && !is_peek &&
 		    ctx->control == TLS_RECORD_TYPE_DATA &&
-		    prot->version != TLS_1_3_VERSION &&
 		    !bpf_strp_enabled)
 			zc = true;
 
@@ -470,9 +470,13 @@ static void unix_write_space(struct sock *sk)
  * may receive messages only from that peer. */
 static void unix_dgram_disconnected(struct sock *sk, struct sock *other)
 {
-	if (!skb_queue_empty(&sk->sk_receive_queue)) {
+	struct unix_sock *u = unix_sk(sk);
+
+	if (!skb_queue_empty(&sk->sk_receive_queue) ||
+	    !skb_queue_empty(&u->reader_queue)) {
 		skb_queue_purge(&sk->sk_receive_queue);
-		wake_up_interruptible_all(&unix_sk(sk)->peer_wait);
+		skb_queue_purge(&u->reader_queue);
+		wake_up_interruptible_all(&u->peer_wait);
 
 		/* If one link of bidirectional dgram pipe is disconnected,
 		 * we signal error. Messages are lost. Do not make this,
@@ -490,6 +494,7 @@ static void unix_sock_destructor(struct sock *sk)
 	struct unix_sock *u = unix_sk(sk);
 
 	skb_queue_purge(&sk->sk_receive_queue);
+	skb_queue_purge(&u->reader_queue);
 
 	WARN_ON(refcount_read(&sk->sk_wmem_alloc));
 	WARN_ON(!sk_unhashed(sk));
@@ -564,6 +569,14 @@ static void unix_release_sock(struct sock *sk, int embrion)
 		kfree_skb(skb);
 	}
 
+	/* Datagram readers may have spliced buffers into their private
+	 * queue; embryos never end up there, so a plain flush suffices.
+	 */
+	while ((skb = skb_dequeue(&u->reader_queue)) != NULL) {
+		UNIXCB(skb).consumed = skb->len;
+		kfree_skb(skb);
+	}
+
 	if (path.dentry)
 		path_put(&path);
 
@@ -788,6 +801,7 @@ static struct sock *unix_create1(struct net *net, struct socket *sock, int kern)
 	INIT_LIST_HEAD(&u->link);
 	mutex_init(&u->iolock); /* single task reading lock */
 	mutex_init(&u->bindlock); /* single task binding lock */
+	skb_queue_head_init(&u->reader_queue);
 	init_waitqueue_head(&u->peer_wait);
 	init_waitqueue_func_entry(&u->peer_wake, unix_dgram_peer_wake_relay);
 	unix_insert_socket(unix_sockets_unbound(sk), sk);
@@ -2039,6 +2053,50 @@ static void unix_copy_addr(struct msghdr *msg, struct sock *sk)
 	}
 }
 
+/* Dequeue a datagram, refilling the reader-private queue from
+ * sk_receive_queue in one batch when it runs dry. Senders only ever
+ * take the receive queue lock, so a reader draining a backlog does not
+ * serialize with them on every message. Called with iolock held, which
+ * makes the reader queue single consumer.
+ */
+static struct sk_buff *unix_dgram_recv_skb(struct sock *sk, unsigned int flags,
+					   int *off, int *err,
+					   struct sk_buff **last)
+{
+	struct sk_buff_head *sk_queue = &sk->sk_receive_queue;
+	struct sk_buff_head *queue = &unix_sk(sk)->reader_queue;
+	struct sk_buff *skb;
+	int error;
+
+	error = sock_error(sk);
+	if (error)
+		goto no_packet;
+
+	error = 0;
+	spin_lock(&queue->lock);
+	skb = __skb_try_recv_from_queue(sk, queue, flags, NULL, off, &error,
+					last);
+	if (!skb && !error && !skb_queue_empty_lockless(sk_queue)) {
+		spin_lock(&sk_queue->lock);
+		skb_queue_splice_tail_init(sk_queue, queue);
+		spin_unlock(&sk_queue->lock);
+
+		skb = __skb_try_recv_from_queue(sk, queue, flags, NULL, off,
+						&error, last);
+	}
+	spin_unlock(&queue->lock);
+
+	if (error)
+		goto no_packet;
+	if (skb)
+		return skb;
+
+	error = -EAGAIN;
+no_packet:
+	*err = error;
+	return NULL;
+}
+
 static int unix_dgram_recvmsg(struct socket *sock, struct msghdr *msg,
 			      size_t size, int flags)
 {
@@ -2060,8 +2118,7 @@ static int unix_dgram_recvmsg(struct socket *sock, struct msghdr *msg,
 		mutex_lock(&u->iolock);
 
 		skip = sk_peek_offset(sk, flags);
-		skb = __skb_try_recv_datagram(sk, flags, NULL, &skip, &err,
-					      &last);
+		skb = unix_dgram_recv_skb(sk, flags, &skip, &err, &last);
 		if (skb)
 			break;
 
@@ -2070,7 +2127,8 @@ static int unix_dgram_recvmsg(struct socket *sock, struct msghdr *msg,
 		if (err != -EAGAIN)
 			break;
 	} while (timeo &&
-		 !__skb_wait_for_more_packets(sk, &err, &timeo, last));
+		 !__skb_wait_for_more_packets(sk, &err, &timeo,
+				(struct sk_buff *)&sk->sk_receive_queue));
 
 	if (!skb) { /* implies iolock unlocked */
 		unix_state_lock(sk);
@@ -2508,17 +2566,23 @@ long unix_inq_len(struct sock *sk)
 	if (sk->sk_state == TCP_LISTEN)
 		return -EINVAL;
 
+	spin_lock(&unix_sk(sk)->reader_queue.lock);
 	spin_lock(&sk->sk_receive_queue.lock);
 	if (sk->sk_type == SOCK_STREAM ||
 	    sk->sk_type == SOCK_SEQPACKET) {
+		skb_queue_walk(&unix_sk(sk)->reader_queue, skb)
+			amount += unix_skb_len(skb);
 		skb_queue_walk(&sk->sk_receive_queue, skb)
 			amount += unix_skb_len(skb);
 	} else {
-		skb = skb_peek(&sk->sk_receive_queue);
+		skb = skb_peek(&unix_sk(sk)->reader_queue);
+		if (!skb)
+			skb = skb_peek(&sk->sk_receive_queue);
 		if (skb)
 			amount = skb->len;
 	}
 	spin_unlock(&sk->sk_receive_queue.lock);
+	spin_unlock(&unix_sk(sk)->reader_queue.lock);
 
 	return amount;
 }
@@ -2657,7 +2721,8 @@ static __poll_t unix_dgram_poll(struct file *file, struct socket *sock,
 		mask |= EPOLLHUP;
 
 	/* readable? */
-	if (!skb_queue_empty_lockless(&sk->sk_receive_queue))
+	if (!skb_queue_empty_lockless(&sk->sk_receive_queue) ||
+	    !skb_queue_empty_lockless(&unix_sk(sk)->reader_queue))
 		mask |= EPOLLIN | EPOLLRDNORM;
 
 	/* Connection-based need to check for termination and startup */
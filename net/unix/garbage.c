@@ -88,14 +88,15 @@
 static LIST_HEAD(gc_candidates);
 static DECLARE_WAIT_QUEUE_HEAD(unix_gc_wait);
 
-static void scan_inflight(struct sock *x, void (*func)(struct unix_sock *),
-			  struct sk_buff_head *hitlist)
+static void scan_queue(struct sock *x, struct sk_buff_head *queue,
+		       void (*func)(struct unix_sock *),
+		       struct sk_buff_head *hitlist)
 {
 	struct sk_buff *skb;
 	struct sk_buff *next;
 
-	spin_lock(&x->sk_receive_queue.lock);
-	skb_queue_walk_safe(&x->sk_receive_queue, skb, next) {
+	spin_lock(&queue->lock);
+	skb_queue_walk_safe(queue, skb, next) {
 		/* Do we have file descriptors ? */
 		if (UNIXCB(skb).fp) {
 			bool hit = false;
@@ -122,12 +123,22 @@ static void scan_inflight(struct sock *x, void (*func)(struct unix_sock *),
 				}
 			}
 			if (hit && hitlist != NULL) {
-				__skb_unlink(skb, &x->sk_receive_queue);
+				__skb_unlink(skb, queue);
 				__skb_queue_tail(hitlist, skb);
 			}
 		}
 	}
-	spin_unlock(&x->sk_receive_queue.lock);
+	spin_unlock(&queue->lock);
+}
+
+static void scan_inflight(struct sock *x, void (*func)(struct unix_sock *),
+			  struct sk_buff_head *hitlist)
+{
+	scan_queue(x, &x->sk_receive_queue, func, hitlist);
+	/* Datagram readers stash received buffers in a private queue,
+	 * which may hold in-flight descriptors as well.
+	 */
+	scan_queue(x, &unix_sk(x)->reader_queue, func, hitlist);
 }
 
 static void scan_children(struct sock *x, void (*func)(struct unix_sock *),
@@ -10,7 +10,6 @@
 #include <linux/if_xdp.h>
 #include <net/xdp_sock.h>
 
-#define RX_BATCH_SIZE 16
 #define LAZY_UPDATE_THRESHOLD 128
 
 struct xdp_ring {
@@ -204,7 +203,7 @@ static inline u64 *xskq_peek_addr(struct xsk_queue *q, u64 *addr,
 	if (q->cons_tail == q->cons_head) {
 		smp_mb(); /* D, matches A */
 		WRITE_ONCE(q->ring->consumer, q->cons_tail);
-		q->cons_head = q->cons_tail + xskq_nb_avail(q, RX_BATCH_SIZE);
+		q->cons_head = q->cons_tail + xskq_nb_avail(q, q->nentries);
 
 		/* Order consumer and data */
 		smp_rmb();
@@ -215,7 +214,8 @@ static inline u64 *xskq_peek_addr(struct xsk_queue *q, u64 *addr,
 
 static inline void xskq_discard_addr(struct xsk_queue *q)
 {
-	q->cons_tail++;
+	/* Order the descriptor read before the consumer update */
+	smp_store_release(&q->ring->consumer, ++q->cons_tail);
 }
 
 static inline int xskq_produce_addr(struct xsk_queue *q, u64 addr)
@@ -321,7 +321,7 @@ static inline struct xdp_desc *xskq_peek_desc(struct xsk_queue *q,
 	if (q->cons_tail == q->cons_head) {
 		smp_mb(); /* D, matches A */
 		WRITE_ONCE(q->ring->consumer, q->cons_tail);
-		q->cons_head = q->cons_tail + xskq_nb_avail(q, RX_BATCH_SIZE);
+		q->cons_head = q->cons_tail + xskq_nb_avail(q, q->nentries);
 
 		/* Order consumer and data */
 		smp_rmb(); /* C, matches B */
@@ -332,7 +332,8 @@ static inline struct xdp_desc *xskq_peek_desc(struct xsk_queue *q,
 
 static inline void xskq_discard_desc(struct xsk_queue *q)
 {
-	q->cons_tail++;
+	/* Order the descriptor read before the consumer update */
+	smp_store_release(&q->ring->consumer, ++q->cons_tail);
 }
 
 static inline int xskq_produce_batch_desc(struct xsk_queue *q,
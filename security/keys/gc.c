@@ -139,10 +139,8 @@ static noinline void key_gc_unused_keys(struct list_head *keys)
 
 		/* deal with the user's key tracking and quota */
 		if (test_bit(KEY_FLAG_IN_QUOTA, &key->flags)) {
-			spin_lock(&key->user->lock);
-			key->user->qnkeys--;
-			key->user->qnbytes -= key->quotalen;
-			spin_unlock(&key->user->lock);
+			percpu_counter_dec(&key->user->qnkeys);
+			percpu_counter_sub(&key->user->qnbytes, key->quotalen);
 		}
 
 		atomic_dec(&key->user->nkeys);
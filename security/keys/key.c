@@ -80,6 +80,12 @@ try_again:
 		candidate = kmalloc(sizeof(struct key_user), GFP_KERNEL);
 		if (unlikely(!candidate))
 			goto out;
+		if (percpu_counter_init(&candidate->qnkeys, 0, GFP_KERNEL))
+			goto free_candidate;
+		if (percpu_counter_init(&candidate->qnbytes, 0, GFP_KERNEL)) {
+			percpu_counter_destroy(&candidate->qnkeys);
+			goto free_candidate;
+		}
 
 		/* the allocation may have scheduled, so we need to repeat the
 		 * search lest someone else added the record whilst we were
@@ -93,9 +99,6 @@ try_again:
 	atomic_set(&candidate->nkeys, 0);
 	atomic_set(&candidate->nikeys, 0);
 	candidate->uid = uid;
-	candidate->qnkeys = 0;
-	candidate->qnbytes = 0;
-	spin_lock_init(&candidate->lock);
 	mutex_init(&candidate->cons_lock);
 
 	rb_link_node(&candidate->node, parent, p);
@@ -108,9 +111,17 @@ try_again:
 found:
 	refcount_inc(&user->usage);
 	spin_unlock(&key_user_lock);
-	kfree(candidate);
+	if (candidate) {
+		percpu_counter_destroy(&candidate->qnkeys);
+		percpu_counter_destroy(&candidate->qnbytes);
+		kfree(candidate);
+	}
 out:
 	return user;
+
+free_candidate:
+	kfree(candidate);
+	return NULL;
 }
 
 /*
@@ -122,6 +133,8 @@ void key_user_put(struct key_user *user)
 		rb_erase(&user->node, &key_user_tree);
 		spin_unlock(&key_user_lock);
 
+		percpu_counter_destroy(&user->qnkeys);
+		percpu_counter_destroy(&user->qnbytes);
 		kfree(user);
 	}
 }
@@ -259,17 +272,16 @@ struct key *key_alloc(struct key_type *type, const char *desc,
 		unsigned maxbytes = uid_eq(uid, GLOBAL_ROOT_UID) ?
 			key_quota_root_maxbytes : key_quota_maxbytes;
 
-		spin_lock(&user->lock);
 		if (!(flags & KEY_ALLOC_QUOTA_OVERRUN)) {
-			if (user->qnkeys + 1 > maxkeys ||
-			    user->qnbytes + quotalen > maxbytes ||
-			    user->qnbytes + quotalen < user->qnbytes)
+			if (percpu_counter_compare(&user->qnkeys,
+						   maxkeys) >= 0 ||
+			    percpu_counter_compare(&user->qnbytes,
+						   (s64)maxbytes - quotalen) > 0)
 				goto no_quota;
 		}
 
-		user->qnkeys++;
-		user->qnbytes += quotalen;
-		spin_unlock(&user->lock);
+		percpu_counter_inc(&user->qnkeys);
+		percpu_counter_add(&user->qnbytes, quotalen);
 	}
 
 	/* allocate and initialise the key and its description */
@@ -324,10 +336,8 @@ security_error:
 	kfree(key->description);
 	kmem_cache_free(key_jar, key);
 	if (!(flags & KEY_ALLOC_NOT_IN_QUOTA)) {
-		spin_lock(&user->lock);
-		user->qnkeys--;
-		user->qnbytes -= quotalen;
-		spin_unlock(&user->lock);
+		percpu_counter_dec(&user->qnkeys);
+		percpu_counter_sub(&user->qnbytes, quotalen);
 	}
 	key_user_put(user);
 	key = ERR_PTR(ret);
@@ -337,10 +347,8 @@ no_memory_3:
 	kmem_cache_free(key_jar, key);
 no_memory_2:
 	if (!(flags & KEY_ALLOC_NOT_IN_QUOTA)) {
-		spin_lock(&user->lock);
-		user->qnkeys--;
-		user->qnbytes -= quotalen;
-		spin_unlock(&user->lock);
+		percpu_counter_dec(&user->qnkeys);
+		percpu_counter_sub(&user->qnbytes, quotalen);
 	}
 	key_user_put(user);
 no_memory_1:
@@ -348,7 +356,6 @@ no_memory_1:
 	goto error;
 
 no_quota:
-	spin_unlock(&user->lock);
 	key_user_put(user);
 	key = ERR_PTR(-EDQUOT);
 	goto error;
@@ -378,18 +385,15 @@ int key_payload_reserve(struct key *key, size_t datalen)
 		unsigned maxbytes = uid_eq(key->user->uid, GLOBAL_ROOT_UID) ?
 			key_quota_root_maxbytes : key_quota_maxbytes;
 
-		spin_lock(&key->user->lock);
-
 		if (delta > 0 &&
-		    (key->user->qnbytes + delta > maxbytes ||
-		     key->user->qnbytes + delta < key->user->qnbytes)) {
+		    percpu_counter_compare(&key->user->qnbytes,
+					   (s64)maxbytes - delta) > 0) {
 			ret = -EDQUOT;
 		}
 		else {
-			key->user->qnbytes += delta;
+			percpu_counter_add(&key->user->qnbytes, delta);
 			key->quotalen += delta;
 		}
-		spin_unlock(&key->user->lock);
 	}
 
 	/* change the recorded data length if that didn't generate an error */
@@ -1187,6 +1191,10 @@ void __init key_init(void)
 	list_add_tail(&key_type_logon.link, &key_types_list);
 
 	/* record the root user tracking */
+	if (percpu_counter_init(&root_key_user.qnkeys, 0, GFP_KERNEL) ||
+	    percpu_counter_init(&root_key_user.qnbytes, 0, GFP_KERNEL))
+		panic("Cannot allocate root key quota counters");
+
 	rb_link_node(&root_key_user.node,
 		     NULL,
 		     &key_user_tree.rb_node);
@@ -1002,21 +1002,18 @@ long keyctl_chown_key(key_serial_t id, uid_t user, gid_t group)
 			unsigned maxbytes = uid_eq(uid, GLOBAL_ROOT_UID) ?
 				key_quota_root_maxbytes : key_quota_maxbytes;
 
-			spin_lock(&newowner->lock);
-			if (newowner->qnkeys + 1 > maxkeys ||
-			    newowner->qnbytes + key->quotalen > maxbytes ||
-			    newowner->qnbytes + key->quotalen <
-			    newowner->qnbytes)
+			if (percpu_counter_compare(&newowner->qnkeys,
+						   maxkeys) >= 0 ||
+			    percpu_counter_compare(&newowner->qnbytes,
+						   (s64)maxbytes -
+						   key->quotalen) > 0)
 				goto quota_overrun;
 
-			newowner->qnkeys++;
-			newowner->qnbytes += key->quotalen;
-			spin_unlock(&newowner->lock);
+			percpu_counter_inc(&newowner->qnkeys);
+			percpu_counter_add(&newowner->qnbytes, key->quotalen);
 
-			spin_lock(&key->user->lock);
-			key->user->qnkeys--;
-			key->user->qnbytes -= key->quotalen;
-			spin_unlock(&key->user->lock);
+			percpu_counter_dec(&key->user->qnkeys);
+			percpu_counter_sub(&key->user->qnbytes, key->quotalen);
 		}
 
 		atomic_dec(&key->user->nkeys);
@@ -1047,7 +1044,6 @@ error:
 	return ret;
 
 quota_overrun:
-	spin_unlock(&newowner->lock);
 	zapowner = newowner;
 	ret = -EDQUOT;
 	goto error_put;
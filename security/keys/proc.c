@@ -309,14 +309,14 @@ static int proc_key_users_show(struct seq_file *m, void *v)
 	unsigned maxbytes = uid_eq(user->uid, GLOBAL_ROOT_UID) ?
 		key_quota_root_maxbytes : key_quota_maxbytes;
 
-	seq_printf(m, "%5u: %5d %d/%d %d/%d %d/%d\n",
+	seq_printf(m, "%5u: %5d %d/%d %lld/%d %lld/%d\n",
 		   from_kuid_munged(seq_user_ns(m), user->uid),
 		   refcount_read(&user->usage),
 		   atomic_read(&user->nkeys),
 		   atomic_read(&user->nikeys),
-		   user->qnkeys,
+		   percpu_counter_sum(&user->qnkeys),
 		   maxkeys,
-		   user->qnbytes,
+		   percpu_counter_sum(&user->qnbytes),
 		   maxbytes);
 
 	return 0;